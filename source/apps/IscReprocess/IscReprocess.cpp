@@ -0,0 +1,347 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Reprocess a RAW data file without the camera
+// The file is split into ranges and each range is processed by a worker process,
+// because the data processing modules share their state in the process.
+// The results of the ranges are merged in order.
+
+#include <Windows.h>
+#include <shlwapi.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_dpl.h"
+
+#pragma comment (lib, "shlwapi")
+#pragma comment (lib, "IscDpl")
+
+struct ReprocessOption {
+	wchar_t configuration_file_path[_MAX_PATH];
+	wchar_t log_file_path[_MAX_PATH];
+	wchar_t play_file_name[_MAX_PATH];
+	wchar_t result_file_name[_MAX_PATH];
+
+	int camera_model;			// 0:VM 1:XC 2:4K 3:4KA 4:4KJ
+	int worker_count;
+	int process_mode;			// 0:stereo matching 1:frame decoder
+	bool enabled_disparity_filter;
+	bool write_depth;
+
+	// worker
+	bool is_worker;
+	__int64 start_frame_number;
+	__int64 end_frame_number;
+	wchar_t range_file_name[_MAX_PATH];
+};
+
+void PrintUsage(void)
+{
+	printf("REPROCESS A RAW DATA FILE WITHOUT THE CAMERA\n");
+	printf("\n");
+	printf("Usage : IscReprocess.exe -m camera_model -i raw_data_file -o result_file [options]\n");
+	printf("         -m camera_model : 0:VM 1:XC 2:4K 3:4KA 4:4KJ\n");
+	printf("         -i raw_data_file : file to reprocess\n");
+	printf("         -o result_file : merged result file\n");
+	printf("         -w worker_count : number of worker processes, default is the number of processors\n");
+	printf("         -p process_mode : 0:stereo matching 1:frame decoder, default 0\n");
+	printf("         -nf : without the disparity filter\n");
+	printf("         -nd : write the block disparity only\n");
+	printf("         -c path : configuration path, default is the path of this program\n");
+	printf("         -l path : log path, default c:\\temp\n");
+	printf("\n");
+
+	return;
+}
+
+bool ParseOption(int argc, wchar_t* argv[], ReprocessOption* option)
+{
+	for (int i = 1; i < argc; i++) {
+		const wchar_t* arg = argv[i];
+		const bool has_value = (i + 1) < argc;
+
+		if (wcscmp(arg, L"-m") == 0 && has_value) {
+			option->camera_model = _wtoi(argv[++i]);
+		}
+		else if (wcscmp(arg, L"-i") == 0 && has_value) {
+			swprintf_s(option->play_file_name, L"%s", argv[++i]);
+		}
+		else if (wcscmp(arg, L"-o") == 0 && has_value) {
+			swprintf_s(option->result_file_name, L"%s", argv[++i]);
+		}
+		else if (wcscmp(arg, L"-w") == 0 && has_value) {
+			option->worker_count = _wtoi(argv[++i]);
+		}
+		else if (wcscmp(arg, L"-p") == 0 && has_value) {
+			option->process_mode = _wtoi(argv[++i]);
+		}
+		else if (wcscmp(arg, L"-nf") == 0) {
+			option->enabled_disparity_filter = false;
+		}
+		else if (wcscmp(arg, L"-nd") == 0) {
+			option->write_depth = false;
+		}
+		else if (wcscmp(arg, L"-c") == 0 && has_value) {
+			swprintf_s(option->configuration_file_path, L"%s", argv[++i]);
+		}
+		else if (wcscmp(arg, L"-l") == 0 && has_value) {
+			swprintf_s(option->log_file_path, L"%s", argv[++i]);
+		}
+		else if (wcscmp(arg, L"-r") == 0 && (i + 3) < argc) {
+			// internal, range of the worker
+			option->is_worker = true;
+			option->start_frame_number = _wtoi64(argv[++i]);
+			option->end_frame_number = _wtoi64(argv[++i]);
+			swprintf_s(option->range_file_name, L"%s", argv[++i]);
+		}
+		else {
+			return false;
+		}
+	}
+
+	if (option->camera_model < 0 || option->camera_model > 4) {
+		return false;
+	}
+
+	if (option->play_file_name[0] == L'\0') {
+		return false;
+	}
+
+	if (!option->is_worker && option->result_file_name[0] == L'\0') {
+		return false;
+	}
+
+	return true;
+}
+
+ns_isc_dpl::IscDpl* OpenLibrary(const ReprocessOption* option)
+{
+	IscDplConfiguration isc_dpl_configuration = {};
+	swprintf_s(isc_dpl_configuration.configuration_file_path, L"%s", option->configuration_file_path);
+	swprintf_s(isc_dpl_configuration.log_file_path, L"%s", option->log_file_path);
+	isc_dpl_configuration.log_level = 0;
+
+	// the recording only
+	isc_dpl_configuration.enabled_camera = false;
+
+	IscCameraModel isc_camera_model = IscCameraModel::kUnknown;
+	switch (option->camera_model) {
+	case 0:isc_camera_model = IscCameraModel::kVM; break;
+	case 1:isc_camera_model = IscCameraModel::kXC; break;
+	case 2:isc_camera_model = IscCameraModel::k4K; break;
+	case 3:isc_camera_model = IscCameraModel::k4KA; break;
+	case 4:isc_camera_model = IscCameraModel::k4KJ; break;
+	}
+	isc_dpl_configuration.isc_camera_model = isc_camera_model;
+
+	swprintf_s(isc_dpl_configuration.save_image_path, L"%s", option->log_file_path);
+	swprintf_s(isc_dpl_configuration.load_image_path, L"%s", option->log_file_path);
+
+	isc_dpl_configuration.enabled_data_proc_module = true;
+
+	ns_isc_dpl::IscDpl* isc_dpl = new ns_isc_dpl::IscDpl;
+	DPL_RESULT dpl_result = isc_dpl->Initialize(&isc_dpl_configuration);
+	if (dpl_result != DPC_E_OK) {
+		printf("[ERROR]Failed to open library(0x%08X)\n", dpl_result);
+
+		isc_dpl->Terminate();
+		delete isc_dpl;
+		return nullptr;
+	}
+
+	return isc_dpl;
+}
+
+void CloseLibrary(ns_isc_dpl::IscDpl* isc_dpl)
+{
+	if (isc_dpl != nullptr) {
+		isc_dpl->Terminate();
+		delete isc_dpl;
+	}
+
+	return;
+}
+
+int RunWorker(const ReprocessOption* option)
+{
+	ns_isc_dpl::IscDpl* isc_dpl = OpenLibrary(option);
+	if (isc_dpl == nullptr) {
+		return 1;
+	}
+
+	IscReprocessParameter isc_reprocess_parameter = {};
+	swprintf_s(isc_reprocess_parameter.play_file_name, L"%s", option->play_file_name);
+	swprintf_s(isc_reprocess_parameter.result_file_name, L"%s", option->range_file_name);
+	isc_reprocess_parameter.start_frame_number = option->start_frame_number;
+	isc_reprocess_parameter.end_frame_number = option->end_frame_number;
+	isc_reprocess_parameter.isc_dataproc_start_mode.enabled_stereo_matching = (option->process_mode == 0);
+	isc_reprocess_parameter.isc_dataproc_start_mode.enabled_frame_decoder = (option->process_mode == 1);
+	isc_reprocess_parameter.isc_dataproc_start_mode.enabled_disparity_filter = option->enabled_disparity_filter;
+	isc_reprocess_parameter.write_block_disparity = true;
+	isc_reprocess_parameter.write_depth = option->write_depth;
+
+	IscReprocessStatus isc_reprocess_status = {};
+	DPL_RESULT dpl_result = isc_dpl->ReprocessRange(&isc_reprocess_parameter, &isc_reprocess_status);
+
+	printf("[INFO]Range %I64d-%I64d frames=%I64d failed=%I64d time=%.1f(sec) fps=%.2f result=0x%08X\n",
+		isc_reprocess_status.start_frame_number, isc_reprocess_status.end_frame_number,
+		isc_reprocess_status.processed_frame_count, isc_reprocess_status.failed_frame_count,
+		isc_reprocess_status.elapsed_time_msec / 1000.0, isc_reprocess_status.frames_per_second, dpl_result);
+
+	CloseLibrary(isc_dpl);
+
+	return (dpl_result == DPC_E_OK) ? 0 : 1;
+}
+
+int RunMaster(const ReprocessOption* option)
+{
+	ns_isc_dpl::IscDpl* isc_dpl = OpenLibrary(option);
+	if (isc_dpl == nullptr) {
+		return 1;
+	}
+
+	// split
+	IscReprocessRangeList* isc_reprocess_range_list = new IscReprocessRangeList;
+	DPL_RESULT dpl_result = isc_dpl->MakeReprocessRanges(option->play_file_name, option->worker_count, isc_reprocess_range_list);
+	if (dpl_result != DPC_E_OK || isc_reprocess_range_list->range_count == 0) {
+		printf("[ERROR]Failed to read the file(0x%08X)\n", dpl_result);
+
+		delete isc_reprocess_range_list;
+		CloseLibrary(isc_dpl);
+		return 1;
+	}
+
+	const int range_count = isc_reprocess_range_list->range_count;
+	printf("[INFO]Frames=%I64d Workers=%d\n", isc_reprocess_range_list->total_frame_count, range_count);
+
+	wchar_t module_file_name[_MAX_PATH] = {};
+	GetModuleFileName(NULL, module_file_name, _MAX_PATH);
+
+	IscReprocessMergeParameter* isc_reprocess_merge_parameter = new IscReprocessMergeParameter;
+	memset(isc_reprocess_merge_parameter, 0, sizeof(IscReprocessMergeParameter));
+	isc_reprocess_merge_parameter->range_file_count = range_count;
+	swprintf_s(isc_reprocess_merge_parameter->result_file_name, L"%s", option->result_file_name);
+	isc_reprocess_merge_parameter->delete_range_files = true;
+
+	ULONGLONG start_time = GetTickCount64();
+
+	// start workers
+	HANDLE process_handle[kISC_REPROCESS_MAX_RANGE_COUNT] = {};
+	int started_count = 0;
+	bool is_failed = false;
+
+	wchar_t* command_line = new wchar_t[8192];
+	for (int i = 0; i < range_count; i++) {
+		const IscReprocessRangeList::Range* range = &isc_reprocess_range_list->range[i];
+		swprintf_s(isc_reprocess_merge_parameter->range_file_name[i], L"%s.part%02d", option->result_file_name, i);
+
+		// the log of each worker is separated
+		swprintf_s(command_line, 8192, L"\"%s\" -m %d -i \"%s\" -p %d %s%s-c \"%s\" -l \"%s\\Reprocess%02d\" -r %I64d %I64d \"%s\"",
+			module_file_name, option->camera_model, option->play_file_name, option->process_mode,
+			option->enabled_disparity_filter ? L"" : L"-nf ", option->write_depth ? L"" : L"-nd ",
+			option->configuration_file_path, option->log_file_path, i,
+			range->start_frame_number, range->end_frame_number, isc_reprocess_merge_parameter->range_file_name[i]);
+
+		STARTUPINFO startup_info = {};
+		startup_info.cb = sizeof(startup_info);
+		PROCESS_INFORMATION process_information = {};
+		if (!CreateProcess(NULL, command_line, NULL, NULL, FALSE, 0, NULL, NULL, &startup_info, &process_information)) {
+			printf("[ERROR]Failed to start the worker(%d)\n", GetLastError());
+			is_failed = true;
+			break;
+		}
+		CloseHandle(process_information.hThread);
+		process_handle[started_count] = process_information.hProcess;
+		started_count++;
+	}
+	delete[] command_line;
+
+	// wait for all workers
+	if (started_count > 0) {
+		WaitForMultipleObjects(started_count, process_handle, TRUE, INFINITE);
+	}
+	for (int i = 0; i < started_count; i++) {
+		DWORD exit_code = 0;
+		if (!GetExitCodeProcess(process_handle[i], &exit_code) || exit_code != 0) {
+			printf("[ERROR]Worker %d failed\n", i);
+			is_failed = true;
+		}
+		CloseHandle(process_handle[i]);
+	}
+
+	if (!is_failed) {
+		dpl_result = isc_dpl->MergeReprocessResults(isc_reprocess_merge_parameter);
+		if (dpl_result != DPC_E_OK) {
+			printf("[ERROR]Failed to merge the results(0x%08X)\n", dpl_result);
+			is_failed = true;
+		}
+	}
+
+	if (is_failed) {
+		for (int i = 0; i < range_count; i++) {
+			DeleteFile(isc_reprocess_merge_parameter->range_file_name[i]);
+		}
+	}
+	else {
+		const double elapsed_time = (double)(GetTickCount64() - start_time) / 1000.0;
+		printf("[INFO]Completed time=%.1f(sec) fps=%.2f\n", elapsed_time,
+			(elapsed_time > 0) ? (double)isc_reprocess_range_list->total_frame_count / elapsed_time : 0.0);
+	}
+
+	delete isc_reprocess_merge_parameter;
+	delete isc_reprocess_range_list;
+	CloseLibrary(isc_dpl);
+
+	return is_failed ? 1 : 0;
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+	ReprocessOption* option = new ReprocessOption;
+	memset(option, 0, sizeof(ReprocessOption));
+
+	GetModuleFileName(NULL, option->configuration_file_path, _MAX_PATH);
+	PathRemoveFileSpec(option->configuration_file_path);
+	swprintf_s(option->log_file_path, L"c:\\temp");
+
+	SYSTEM_INFO system_info = {};
+	GetSystemInfo(&system_info);
+	option->camera_model = -1;
+	option->worker_count = (int)system_info.dwNumberOfProcessors;
+	option->process_mode = 0;
+	option->enabled_disparity_filter = true;
+	option->write_depth = true;
+
+	if (!ParseOption(argc, argv, option)) {
+		PrintUsage();
+
+		delete option;
+		return 1;
+	}
+
+	if (option->worker_count < 1) {
+		option->worker_count = 1;
+	}
+	else if (option->worker_count > kISC_REPROCESS_MAX_RANGE_COUNT) {
+		option->worker_count = kISC_REPROCESS_MAX_RANGE_COUNT;
+	}
+
+	int ret = option->is_worker ? RunWorker(option) : RunMaster(option);
+
+	delete option;
+
+	return ret;
+}
@@ -71,6 +71,15 @@ class IscPlayMode(IntEnum) :
     kPlayOff = 0        #/**< mode off */
     kPlayOn = 1         #/**< mode on */
 
+# /** @enum  IscPlayPacingMode
+#  *  @brief This is the pacing of the play
+#  */
+class IscPlayPacingMode(IntEnum) :
+    kInterval = 0       #/**< wait interval (msec) after each frame */
+    kRealTime = 1       #/**< follow the frame_time of the recording */
+    kFixedRate = 2      #/**< play at fixed_rate frames per second */
+    kMaximumSpeed = 3   #/**< as fast as the data processing accepts the frames, no frame is skipped */
+
 # /** @enum  IscCameraInfo
 #  *  @brief This is a camera dependent parameter 
 #  */
@@ -249,7 +258,8 @@ class IscRawFileHeader (Structure):
                 ("grab_mode", c_int),       #/**< Grab mode */
                 ("shutter_mode", c_int),    #/**< Shutter control mode */
                 ("color_mode", c_int) ,     #/**< color mode on/off 0:off 1:on*/
-                ("reserve", c_int * 12)     #/**< Reserve */
+                ("compression", c_int) ,    #/**< data compression 0:off 1:on */
+                ("reserve", c_int * 11)     #/**< Reserve */
     ]
 
 # /** @struct  IscPlayFileInformation
@@ -278,7 +288,10 @@ class IscGetMode (Structure):
 class IscPalyModeParameter (Structure):         
     _fields_ = [
                 ("interval", c_int),                # int interval;                       /**< intervaltime for read one frame data */
-                ("play_file_name", c_wchar * 260)   # wchar_t play_file_name[_MAX_PATH];  /**< file name for play iamge */
+                ("play_file_name", c_wchar * 260),  # wchar_t play_file_name[_MAX_PATH];  /**< file name for play iamge */
+                ("pacing_mode", c_int),             # IscPlayPacingMode pacing_mode;      /**< pacing of the play */
+                ("fixed_rate", c_double),           # double fixed_rate;                  /**< frames per second for kFixedRate */
+                ("follow_growing_file", c_bool)     # bool follow_growing_file;           /**< wait for the data appended to the file being recorded, instead of ending */
     ]
 
 # /** @struct  IscGrabStartMode
@@ -305,7 +318,8 @@ class IscDataProcStartMode (Structure):
     _fields_ = [
                 ("enabled_stereo_matching", c_bool),    # bool enabled_block_matching;                  /**< whether to use a soft stereo matching */
                 ("enabled_frame_decoder", c_bool) ,     # bool enabled_frame_decoder;                   /**< whether to use a frame decoder */
-                ("enabled_disparity_filter", c_bool)    # bool enabled_disparity_filter;                /**< whether to use a disparity filter */
+                ("enabled_disparity_filter", c_bool),   # bool enabled_disparity_filter;                /**< whether to use a disparity filter */
+                ("enabled_valid_block_list", c_bool)    # bool enabled_valid_block_list;                /**< whether to make the list of the valid blocks */
     ]
 
 # /** @struct  IscStartMode
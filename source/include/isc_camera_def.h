@@ -32,6 +32,73 @@ enum class IscCameraModel {
     kUnknown            /**< error type */
 };
 
+/** @enum  IscThreadRole
+ *  @brief This is the role of the threads created by the library
+ */
+enum class IscThreadRole {
+    kCameraReceive = 0,         /**< camera receive */
+    kDataProc,                  /**< data processing control */
+    kStereoMatchingBand,        /**< stereo matching band */
+    kDisparityFilterBand,       /**< disparity filter band */
+    kSelfCalibration,           /**< self calibration */
+    kFileWriter,                /**< file writer */
+    kLog,                       /**< log */
+    kCallbackDelivery,          /**< callback delivery */
+    kBandWorker,                /**< band workers of the point cloud, occupancy grid, u/v disparity and draw */
+    kFilePlayer,                /**< play prefetch and decompression */
+};
+constexpr int kISC_THREAD_ROLE_COUNT = 10;      /**< number of IscThreadRole */
+
+/** @enum  IscThreadPriority
+ *  @brief This is the priority of the thread
+ */
+enum class IscThreadPriority {
+    kIdle = 0,                  /**< idle */
+    kLowest,                    /**< lowest */
+    kBelowNormal,               /**< below normal */
+    kNormal,                    /**< normal */
+    kAboveNormal,               /**< above normal */
+    kHighest,                   /**< highest */
+    kTimeCritical,              /**< time critical */
+};
+
+/** @struct  IscThreadParameter
+ *  @brief This is the placement of the threads of one role
+ */
+struct IscThreadParameter {
+    bool enabled;                       /**< false:the library default is used */
+    unsigned __int64 cpu_mask;          /**< cpu set, bit n is logical processor n  0:all processors */
+    bool distribute;                    /**< true:each thread of the role is bound to one cpu of the set in turn */
+    IscThreadPriority priority;         /**< priority */
+    bool disable_priority_boost;        /**< true:the dynamic priority boost of the scheduler is disabled */
+};
+
+/** @struct  IscThreadConfiguration
+ *  @brief This is the placement of the threads for each role
+ */
+struct IscThreadConfiguration {
+    IscThreadParameter thread_parameter[kISC_THREAD_ROLE_COUNT];    /**< indexed by IscThreadRole */
+};
+
+/** @struct  IscThreadPlacementStatus
+ *  @brief This is the placement applied to the threads
+ */
+constexpr int kISC_THREAD_PLACEMENT_MAX_COUNT = 64;
+struct IscThreadPlacementStatus {
+    struct Placement {
+        IscThreadRole role;                 /**< role */
+        int thread_index;                   /**< index in the role */
+        unsigned int thread_id;             /**< thread id */
+        unsigned __int64 cpu_mask;          /**< cpu set applied */
+        int priority;                       /**< priority of the thread(THREAD_PRIORITY_*) */
+        bool priority_boost_disabled;       /**< true:the dynamic priority boost is disabled */
+        int error_code;                     /**< 0:applied other:system error code */
+    };
+
+    int placement_count;                                        /**< valid count of placement */
+    Placement placement[kISC_THREAD_PLACEMENT_MAX_COUNT];       /**< placement */
+};
+
 /** @struct  IsCameraControlConfiguration
  *  @brief This is the configuration information
  */
@@ -43,9 +110,11 @@ struct IscCameraControlConfiguration {
 
     bool enabled_camera;                        /**< decide whether to use a physical camera */
     IscCameraModel isc_camera_model;            /**< physical camera model */
-    wchar_t save_image_path[_MAX_PATH];         /**< the path to save the image */
+    wchar_t save_image_path[_MAX_PATH];         /**< the path to save the image. separate with ';' to stripe the recording across several folders */
     wchar_t load_image_path[_MAX_PATH];         /**< image loading path */
     int minimum_write_interval_time;            /**< minimum free time to write (msec) */
+
+    IscThreadConfiguration isc_thread_configuration;    /**< placement of the threads */
 };
 
 /** @struct  IscSaveDataConfiguration
@@ -66,6 +135,72 @@ struct IscSaveDataConfiguration {
     int minimum_write_interval_time;        /**< 書き込みの最小空き時間 (msec) */
 };
 
+/** @struct  IscRecordCompressionParameter
+ *  @brief This is the parameter of the lossless compression of the raw data when saving
+ */
+constexpr int kISC_RECORD_COMPRESSION_MAX_THREAD_COUNT = 16;
+struct IscRecordCompressionParameter {
+    bool enabled;                           /**< true:the raw data is compressed, the setting is applied at the start of saving */
+    int thread_count;                       /**< number of compression threads 1 - kISC_RECORD_COMPRESSION_MAX_THREAD_COUNT */
+};
+
+/** @struct  IscRecordCompressionStatistics
+ *  @brief This is the result of the compression since the start of saving
+ */
+struct IscRecordCompressionStatistics {
+    __int64 data_count;                     /**< number of data written */
+    __int64 uncompressed_count;             /**< number of data written without compression (not smaller) */
+    __int64 raw_bytes;                      /**< total size before compression */
+    __int64 written_bytes;                  /**< total size written */
+    double compression_ratio;               /**< raw_bytes / written_bytes */
+    double average_time_msec;               /**< average compression time for one data */
+    double throughput_mb_per_sec;           /**< raw_bytes processed per second of compression time */
+};
+
+/** @enum  IscRecordStripingMode
+ *  @brief This is how the raw data is distributed over the save folders
+ */
+enum class IscRecordStripingMode {
+    kStripingOff,                           /**< the folders are used one at a time, the next one when the free space runs low */
+    kRoundRobin,                            /**< the write requests are distributed round-robin over all folders */
+    kFreeSpace                              /**< the write requests are distributed by the free space of each folder */
+};
+
+/** @struct  IscRecordWriteParameter
+ *  @brief This is the parameter of the writing of the raw data file
+ */
+constexpr int kISC_RECORD_WRITE_MAX_REQUEST_COUNT = 16;
+struct IscRecordWriteParameter {
+    int batch_size;                         /**< size of one write request (KB) 64 - 65536, rounded up to a multiple of 64KB */
+    int request_count;                      /**< number of write requests in flight 1 - kISC_RECORD_WRITE_MAX_REQUEST_COUNT */
+    bool direct_io;                         /**< true:the file is written without the system file cache */
+    IscRecordStripingMode striping_mode;    /**< distribution over the save folders, a write request is the unit of striping */
+};
+
+/** @struct  IscRecordWriteStatistics
+ *  @brief This is the result of the writing since the start of saving
+ */
+struct IscRecordWriteStatistics {
+    __int64 frame_count;                    /**< number of data written */
+    __int64 dropped_frame_count;            /**< number of data dropped because the queue was full */
+    int queue_depth;                        /**< number of data waiting to be written */
+    int max_queue_depth;                    /**< maximum of queue_depth */
+
+    __int64 request_count;                  /**< number of write requests issued */
+    __int64 written_bytes;                  /**< total size written */
+    __int64 stall_count;                    /**< number of times the writer waited for a free request */
+    int requests_in_flight;                 /**< number of write requests in progress */
+    int max_requests_in_flight;             /**< maximum of requests_in_flight */
+    double latency_p50_msec;                /**< write request latency, 50th percentile */
+    double latency_p90_msec;                /**< write request latency, 90th percentile */
+    double latency_p99_msec;                /**< write request latency, 99th percentile */
+    double latency_max_msec;                /**< write request latency, maximum */
+
+    int stripe_count;                       /**< number of files written at the same time (1:no striping) */
+    __int64 stripe_written_bytes[kISC_SAVE_MAX_SAVE_FOLDER_COUNT];         /**< size written to each folder */
+    double stripe_throughput_mb_per_sec[kISC_SAVE_MAX_SAVE_FOLDER_COUNT];  /**< write speed of each folder since the start of saving */
+};
+
 
 /** @enum  IscCameraInfo
  *  @brief This is a camera dependent parameter 
@@ -198,12 +333,25 @@ enum class IscPlayMode {
     kPlayOn              /**< mode on */
 };
 
+/** @enum  IscPlayPacingMode
+ *  @brief This is the pacing of the play from file
+ */
+enum class IscPlayPacingMode {
+    kInterval = 0,      /**< wait interval (msec) after each frame */
+    kRealTime,          /**< follow the frame_time of the recording */
+    kFixedRate,         /**< play at fixed_rate frames per second */
+    kMaximumSpeed       /**< as fast as the data processing accepts the frames, no frame is skipped */
+};
+
 /** @struct  IscPalyModeParameter
  *  @brief This is the parameter for play image
  */
 struct IscPalyModeParameter {           
     int interval;                       /**< intervaltime for read one frame data */
     wchar_t play_file_name[_MAX_PATH];  /**< file name for play iamge */
+    IscPlayPacingMode pacing_mode;      /**< pacing of the play */
+    double fixed_rate;                  /**< frames per second for kFixedRate */
+    bool follow_growing_file;           /**< wait for the data appended to the file being recorded, instead of ending */
 };
 
 /** @struct  IscGrabStartMode
@@ -320,7 +468,8 @@ struct IscImageInfo {
                                             0x01 Single
                                             0x02 Double
     12  INT     4           COLOR MODE      Color有効 0:off 1:on
-    13	INT		4*12		RESERVE(0)
+    13  INT     4           COMPRESSION     データの圧縮 0:off 1:on
+    14	INT		4*11		RESERVE(0)
 
                 128
 */
@@ -344,7 +493,8 @@ struct IscRawFileHeader {
     int		grab_mode;      /**< Grab mode */
     int		shutter_mode;   /**< Shutter control mode */
     int     color_mode;     /**< color mode on/off 0:off 1:on*/
-    int		reserve[12];    /**< Reserve */
+    int     compression;    /**< data compression 0:off 1:on, the data of each frame may still be stored as is */
+    int		reserve[11];    /**< Reserve */
 };
 
 // DATA HEADER
@@ -393,6 +543,62 @@ struct IscRawDataHeader {
     int		reserve[4];         /**< Reserve */
 };
 
+// INDEX FILE (.idx, same name as the RAW data file)
+//
+// |-----------------------------------|
+// |    INDEX HEADER(64byte)           |
+// |-----------------------------------|
+// |    INDEX ENTRY(32byte)            |  one entry for each DATA HEADER + DATA
+// |-----------------------------------|
+// |    INDEX ENTRY(32byte)            |
+// |-----------------------------------|
+//
+// the number of entries is (file size - INDEX HEADER) / INDEX ENTRY
+
+constexpr int ISC_RAW_INDEX_HEADER_VERSION = 100;   /**< Index Header Version 1.0.0 */
+
+/** @struct  IscRawFileIndexHeader
+ *  @brief This is the header of the index file
+ */
+struct IscRawFileIndexHeader {
+    char    mark[32];           /**< MARK "ISC RAW INDEX" */
+    int     version;            /**< Header version */
+    int     header_size;        /**< Header size */
+    int     entry_size;         /**< Entry size */
+    int     reserve[5];         /**< Reserve */
+};
+
+/** @struct  IscRawFileIndexEntry
+ *  @brief This is the position of one data in the RAW data file
+ */
+struct IscRawFileIndexEntry {
+    __int64 offset;             /**< offset of DATA HEADER from the beginning of the file */
+    __int64 frame_time;         /**< frame time (UTC msec) */
+    int     frame_index;        /**< Frame index */
+    int     data_size;          /**< Data size */
+    int     type;               /**< Type 1:mono 2:color */
+    int     reserve;            /**< Reserve */
+};
+
+constexpr int ISC_RAW_STRIPE_MANIFEST_VERSION = 100;    /**< Stripe Manifest Version 1.0.0 */
+
+/** @struct  IscRawStripeManifestHeader
+ *  @brief This is the header of the manifest of a striped RAW data file
+ *  the header is followed by the stripe file names (wchar_t[_MAX_PATH] x stripe_count)
+ *  and the stripe number of each chunk (unsigned char x chunk_count)
+ */
+struct IscRawStripeManifestHeader {
+    char    mark[32];           /**< MARK "ISC RAW STRIPE" */
+    int     version;            /**< Header version */
+    int     header_size;        /**< Header size */
+    int     stripe_count;       /**< Number of stripe files */
+    int     reserve0;           /**< Reserve */
+    __int64 chunk_size;         /**< Size of one chunk */
+    __int64 chunk_count;        /**< Number of chunks */
+    __int64 total_size;         /**< Size of the reassembled RAW data file */
+    int     reserve[4];         /**< Reserve */
+};
+
 /** @struct  IscPlayFileInformation
  *  @brief This is the structure of play file
  */
@@ -404,6 +610,47 @@ struct IscPlayFileInformation {
     __int64 end_time;           /**< End time */
 };
 
+/** @struct  IscPlayStatistics
+ *  @brief This is the result of the play since the start
+ */
+struct IscPlayStatistics {
+    IscPlayPacingMode pacing_mode;          /**< pacing of the play */
+    __int64 frame_count;                    /**< number of frames read */
+    double elapsed_time_msec;               /**< time from the first frame to the latest frame */
+    double achieved_fps;                    /**< frames per second actually read */
+    double target_fps;                      /**< frames per second requested (0:no target) */
+    __int64 late_frame_count;               /**< number of frames read after the scheduled time */
+    double read_time_average_msec;          /**< average time to read and decode one frame */
+
+    __int64 processed_frame_count;          /**< number of frames processed by the data processing */
+    double processing_time_average_msec;    /**< average time from passing the frame to the data processing until its result */
+    double processing_time_max_msec;        /**< maximum of the above */
+    double processing_time_last_msec;       /**< the above of the latest frame */
+    double backpressure_wait_msec;          /**< total time waiting for the data processing (kMaximumSpeed) */
+};
+
+/** @struct  IscPlayCacheParameter
+ *  @brief This is the parameter of the cache of decoded frames for the play
+ */
+struct IscPlayCacheParameter {
+    bool enabled;                           /**< keep the decoded frames */
+    int memory_budget_mb;                   /**< maximum memory used by the cache (MB) */
+    int prefetch_ahead_count;               /**< number of frames decoded in the background after the current frame */
+    int prefetch_behind_count;              /**< number of frames decoded in the background before the current frame */
+};
+
+/** @struct  IscPlayCacheStatus
+ *  @brief This is the state of the cache of decoded frames for the play
+ */
+struct IscPlayCacheStatus {
+    int frame_count;                        /**< number of frames in the cache */
+    __int64 used_size;                      /**< memory used by the cache (byte) */
+    __int64 memory_budget;                  /**< maximum memory used by the cache (byte) */
+    __int64 hit_count;                      /**< number of frames taken from the cache */
+    __int64 miss_count;                     /**< number of frames read and decoded from the file */
+    __int64 prefetched_count;               /**< number of frames decoded in the background */
+};
+
 /** @enum  IscFileReadStatus
  *  @brief This is the status of file read
  */
@@ -36,6 +36,8 @@ struct IscDataProcModuleConfiguration {
     bool enabled_data_proc_module;              /**< whether to use a data processing library */
 
     int max_buffer_count;                       /**< number of internal buffers */
+
+    IscThreadConfiguration isc_thread_configuration;    /**< placement of the threads */
 };
 
 /** @struct  IscDataProcStartMode
@@ -45,6 +47,7 @@ struct IscDataProcStartMode {
     bool enabled_stereo_matching;               /**< whether to use a soft stereo matching */
     bool enabled_frame_decoder;                 /**< whether to use a frame decoder */
     bool enabled_disparity_filter;              /**< whether to use a disparity filter */
+    bool enabled_valid_block_list;              /**< whether to make the list of the valid blocks (IscBlockDisparityData::pvalidblk) */
 };
 
 /** @struct  IscDataProcModuleParameter
@@ -103,6 +106,150 @@ struct IscDataProcResultData {
     IscImageInfo isc_image_info;                /**< result processed by the module */
 };
 
+constexpr unsigned int kISC_DATAPROC_FIELD_P1 = 0x0001;           /**< base image */
+constexpr unsigned int kISC_DATAPROC_FIELD_P2 = 0x0002;           /**< compare image */
+constexpr unsigned int kISC_DATAPROC_FIELD_COLOR = 0x0004;        /**< color image */
+constexpr unsigned int kISC_DATAPROC_FIELD_DEPTH = 0x0008;        /**< disparity */
+constexpr unsigned int kISC_DATAPROC_FIELD_RAW = 0x0010;          /**< camera raw */
+constexpr unsigned int kISC_DATAPROC_FIELD_RAW_COLOR = 0x0020;    /**< camera raw color */
+constexpr unsigned int kISC_DATAPROC_FIELD_ALL = 0x003F;          /**< all planes */
+
+/** @struct  IscDataProcOutputPlane
+ *  @brief This is the caller-owned buffer for one plane of the result
+ */
+struct IscDataProcOutputPlane {
+    void* buffer;           /**< [in] caller-owned buffer, nullptr to skip */
+    int pitch;              /**< [in] bytes per row of buffer, 0:width x bytes per pixel */
+    size_t buffer_size;     /**< [in] size of buffer in bytes */
+
+    int width;              /**< [out] valid width, 0 if not available */
+    int height;             /**< [out] valid height */
+    int channel_count;      /**< [out] number of channels */
+};
+
+/** @struct  IscDataProcPartialResultData
+ *  @brief This is the request and result for partial retrieval of the data processing result
+ */
+struct IscDataProcPartialResultData {
+    unsigned int field_mask;                    /**< [in] kISC_DATAPROC_FIELD_* */
+    int frame_data_index;                       /**< [in] kISCIMAGEINFO_FRAMEDATA_LATEST ~ kISCIMAGEINFO_FRAMEDATA_MERGED */
+
+    int number_of_modules_processed;            /**< [out] Number of modules processed */
+    IscDataProcStatus status;                   /**< [out] status of data proccesing */
+    IscDataProcModuleStatus module_status[4];   /**< [out] IscDataProcModuleStatus */
+
+    IscGrabMode grab;                           /**< [out] grab mode */
+    IscGrabColorMode color_grab_mode;           /**< [out] color mode */
+    IscShutterMode shutter_mode;                /**< [out] shutter mode */
+    IscCameraSpecificParameter camera_specific_parameter;   /**< [out] camera specific parameter */
+
+    IscCameraStatus camera_status;              /**< [out] camera status */
+    __int64 frame_time;                         /**< [out] UNIX UTC Time (msec) */
+    __int64 data_index;                         /**< [out] data index */
+    int frameNo;                                /**< [out] frame number */
+    int gain;                                   /**< [out] gain */
+    int exposure;                               /**< [out] exposure */
+
+    IscDataProcOutputPlane p1;                  /**< base image (1byte/pixel) */
+    IscDataProcOutputPlane p2;                  /**< compare image (1byte/pixel) */
+    IscDataProcOutputPlane color;               /**< color image (3byte/pixel) */
+    IscDataProcOutputPlane depth;               /**< disparity (float) */
+    IscDataProcOutputPlane raw;                 /**< camera raw (1byte/pixel x channel) */
+    IscDataProcOutputPlane raw_color;           /**< camera raw color (1byte/pixel x channel) */
+};
+
+/** @enum  IscDataProcAdmissionPolicy
+ *  @brief This is the action for a frame that does not fit in the latency budget
+ */
+enum class IscDataProcAdmissionPolicy {
+    kAdmit = 0,                 /**< process normally */
+    kDrop,                      /**< drop the frame */
+    kSkipDisparityFilter,       /**< process without the disparity filter */
+    kReducedDepth,              /**< process with reduced matching depth */
+    kEveryNthFrame,             /**< process only every Nth frame, drop the others */
+};
+
+/** @struct  IscDataProcAdmissionParameter
+ *  @brief This is the parameter for admission control of the asynchronous processing
+ */
+struct IscDataProcAdmissionParameter {
+    bool enabled;                                   /**< whether to use admission control */
+    int latency_budget;                             /**< allowed latency from input to result (msec) */
+    IscDataProcAdmissionPolicy over_budget_policy;  /**< action when the budget is exceeded */
+    int reduced_depth;                              /**< matching depth for kReducedDepth */
+    int every_nth_frame;                            /**< N for kEveryNthFrame */
+};
+
+/** @struct  IscDataProcAdmissionDecision
+ *  @brief This is the decision for one frame
+ */
+struct IscDataProcAdmissionDecision {
+    __int64 decision_number;                /**< serial number of the decision */
+    __int64 data_index;                     /**< data index of the frame */
+    int frameNo;                            /**< frame number */
+    IscDataProcAdmissionPolicy policy;      /**< applied policy */
+    bool processed;                         /**< true:processed false:dropped */
+    int queue_age;                          /**< time since the frame was passed to data processing (msec) */
+    int predicted_latency;                  /**< predicted time from passing the frame to the end of its processing (msec) */
+};
+
+constexpr int kISC_DATAPROC_ADMISSION_HISTORY_COUNT = 64;    /**< number of decisions kept */
+
+/** @struct  IscDataProcAdmissionStatus
+ *  @brief This is the status of admission control
+ */
+struct IscDataProcAdmissionStatus {
+    __int64 total_decision_count;           /**< number of decisions */
+    __int64 admitted_count;                 /**< processed normally */
+    __int64 downgraded_count;               /**< processed with a downgrade */
+    __int64 dropped_count;                  /**< dropped by the policy */
+    __int64 superseded_count;               /**< overwritten in the queue by a newer frame */
+    int average_proc_time;                  /**< average processing time (msec) */
+
+    int decision_count;                                                     /**< valid count of decision */
+    IscDataProcAdmissionDecision decision[kISC_DATAPROC_ADMISSION_HISTORY_COUNT];  /**< latest decisions, oldest first */
+};
+
+/** @struct  IscDataProcPreviewParameter
+ *  @brief This is the parameter for the reduced-resolution preview of the result
+ */
+struct IscDataProcPreviewParameter {
+    bool enabled;               /**< whether to make the preview */
+    int decimation;             /**< kISC_DATAPROC_PREVIEW_MIN_DECIMATION ~ kISC_DATAPROC_PREVIEW_MAX_DECIMATION, 4:1/4 width and height */
+    int min_interval;           /**< minimum interval between previews (msec), 0:every result */
+};
+
+constexpr int kISC_DATAPROC_PREVIEW_MIN_DECIMATION = 2;     /**< minimum decimation */
+constexpr int kISC_DATAPROC_PREVIEW_MAX_DECIMATION = 16;    /**< maximum decimation */
+
+/** @struct  IscDataProcPreviewData
+ *  @brief This is the latest reduced-resolution preview of the result
+ */
+struct IscDataProcPreviewData {
+    __int64 preview_number;     /**< [out] serial number of the preview, 0:no preview yet */
+    __int64 frame_time;         /**< [out] UNIX UTC Time (msec) */
+    __int64 data_index;         /**< [out] data index */
+    int frameNo;                /**< [out] frame number */
+    int decimation;             /**< [out] decimation applied */
+    bool is_block_disparity;    /**< [out] true:depth is made from the block disparity false:from the disparity image */
+
+    IscDataProcOutputPlane image;   /**< base image (1byte/pixel) */
+    IscDataProcOutputPlane depth;   /**< disparity (float) */
+};
+
+constexpr int kISC_DISPARITY_FIXED_POINT_SCALE = 16;   /**< fixed-point disparity = disparity(pixel) x 16 in uint16, the resolution of the FPGA (4bit fraction) */
+
+/** @struct  IscValidBlock
+ *  @brief This is a block which has the disparity
+ */
+struct IscValidBlock {
+    unsigned short block_x;     /**< position of the block (horizontal) */
+    unsigned short block_y;     /**< position of the block (vertical) */
+    unsigned short disparity;   /**< disparity x kISC_DISPARITY_FIXED_POINT_SCALE */
+    unsigned short reserved;    /**< reserved */
+    int contrast;               /**< contrast of the block */
+};
+
 /** @struct  IscBlockDisparityData
  *  @brief This is the result of BlockMatching
  */
@@ -121,6 +268,9 @@ struct IscBlockDisparityData {
     int shdwdt;             /**< 画像遮蔽幅 */
     int* pblkval;           /**< 視差ブロック視差値(1000倍サブピクセル精度の整数) */
     int* pblkcrst;          /**< ブロックコントラスト */
+    unsigned short* pblkfix;    /**< 視差ブロック視差値(kISC_DISPARITY_FIXED_POINT_SCALE倍の固定小数点 0:視差なし) pblkvalから整数演算で作成 */
+    IscValidBlock* pvalidblk;   /**< 視差のあるブロックのリスト(ブロック行順) */
+    int validblkcnt;            /**< 視差のあるブロックの数 -1:リストを作成していない */
     unsigned char* pdspimg; /**< 視差画像 右下原点 */
     float* ppxldsp;         /**< 視差データ 右下原点 */
     float* pblkdsp;         /**< ブロック視差データ 右下原点 */
@@ -35,7 +35,7 @@ struct IscDplConfiguration {
 
     bool enabled_camera;                        /**< whether to use a physical camera */
     IscCameraModel isc_camera_model;            /**< physical camera model */
-    wchar_t save_image_path[_MAX_PATH];         /**< the path to save the image */
+    wchar_t save_image_path[_MAX_PATH];         /**< the path to save the image. separate with ';' to stripe the recording across several folders */
     wchar_t load_image_path[_MAX_PATH];         /**< image loading path */
     int minimum_write_interval_time;            /**< minimum free time to write (msec) */
 
@@ -82,4 +82,556 @@ struct IscAreaDataStatistics {
     Roi3D roi_3d;                       /**< distance of 3D */
 };
 
+/** @enum  IscPointCloudLayout
+ *  @brief This is the memory layout of the point cloud
+ */
+enum class IscPointCloudLayout {
+    kArrayOfStructures,                 /**< points[i] = {x, y, z, rgb} */
+    kStructureOfArrays                  /**< x[i], y[i], z[i], rgb[i] */
+};
+
+/** @enum  IscPointCloudFileFormat
+ *  @brief This is the file format of the point cloud
+ */
+enum class IscPointCloudFileFormat {
+    kPcdBinary,                         /**< PCD v0.7, DATA binary */
+    kPlyBinary                          /**< PLY, binary_little_endian (the invalid points are not written) */
+};
+
+/** @struct  IscPointCloudParameter
+ *  @brief This is the parameter to make the point cloud
+ */
+struct IscPointCloudParameter {
+    int roi_x;                          /**< top left of region */
+    int roi_y;                          /**< top left of region */
+    int roi_width;                      /**< width of region, 0: to the right end */
+    int roi_height;                     /**< height of region, 0: to the bottom end */
+    int decimation;                     /**< use every n-th pixel in x and y, 1: all pixels */
+
+    float min_distance;                 /**< minimum distance(m) */
+    float max_distance;                 /**< maximum distance(m) */
+
+    bool with_color;                    /**< add the color of the base image */
+    bool is_organized;                  /**< keep the invalid pixels as NaN, the points are the sampled grid */
+    bool is_ros_axis;                   /**< x:forward y:left z:up, otherwise x:right y:up z:forward */
+    IscPointCloudLayout layout;         /**< memory layout of IscPointCloudData */
+};
+
+/** @struct  IscPointXYZRGB
+ *  @brief This is a point of the point cloud
+ */
+struct IscPointXYZRGB {
+    float x;                            /**< position(m) */
+    float y;                            /**< position(m) */
+    float z;                            /**< position(m) */
+    unsigned int rgb;                   /**< color 0x00RRGGBB */
+};
+
+/** @struct  IscPointCloudData
+ *  @brief This is the point cloud, the buffers are allocated by the caller
+ */
+struct IscPointCloudData {
+    int max_point_count;                /**< number of points the buffers can hold */
+
+    IscPointXYZRGB* points;             /**< kArrayOfStructures */
+
+    float* x;                           /**< kStructureOfArrays */
+    float* y;                           /**< kStructureOfArrays */
+    float* z;                           /**< kStructureOfArrays */
+    unsigned int* rgb;                  /**< kStructureOfArrays, nullptr if the color is not required */
+
+    int point_count;                    /**< number of points */
+    int width;                          /**< organized: width of the sampled grid, otherwise point_count */
+    int height;                         /**< organized: height of the sampled grid, otherwise 1 */
+};
+
+constexpr int kISC_POSITION_MAX_WINDOW_SIZE = 15;       /**< maximum window size of IscPositionBatch */
+
+/** @struct  IscPositionBatch
+ *  @brief This is the batch of the positions, the buffers are allocated by the caller
+ */
+struct IscPositionBatch {
+    int window_size;                    /**< 0: first valid disparity of the 4x4 block (same as GetPosition3D), odd 1 ~ 15: median of the valid disparities in the window */
+
+    int max_point_count;                /**< number of points the buffers can hold */
+    int point_count;                    /**< number of points in x, y (in), or number of points found in the mask (out) */
+    int* x;                             /**< coordinates of the image, written when mask is used */
+    int* y;                             /**< coordinates of the image, written when mask is used */
+    const unsigned char* mask;          /**< nullptr: use x, y, otherwise the pixels of non zero are the points (same size as the disparity) */
+
+    float* disparity;                   /**< disparity, nullptr if not required */
+    float* depth;                       /**< distance(m), nullptr if not required */
+    float* x_d;                         /**< distance from the center(m), nullptr if not required */
+    float* y_d;                         /**< distance from the center(m), nullptr if not required */
+    float* z_d;                         /**< distance(m), nullptr if not required */
+    unsigned char* is_valid;            /**< 1: valid, 0: out of image or no disparity, nullptr if not required */
+};
+
+/** @struct  IscOccupancyGridParameter
+ *  @brief This is the parameter to build the occupancy grid and the voxel map from the block disparity
+ *  @note The ground frame is x:right, z:forward along the ground, height:up from the ground
+ */
+struct IscOccupancyGridParameter {
+    bool enabled;                       /**< build the grid each time the block disparity is ready */
+
+    float camera_height;                /**< height of the camera above the ground(m) */
+    float camera_pitch;                 /**< downward tilt of the camera(deg) */
+
+    float cell_size;                    /**< size of a grid cell(m) */
+    float min_x;                        /**< left end of the grid(m) */
+    float max_x;                        /**< right end of the grid(m) */
+    float min_z;                        /**< near end of the grid(m) */
+    float max_z;                        /**< far end of the grid(m) */
+
+    float min_height;                   /**< the points from min_height to max_height are obstacles, the points below min_height are ground */
+    float max_height;                   /**< the points above max_height are ignored */
+
+    float decay;                        /**< weight of the previous frames 0.0 ~ 1.0, 0.0: current frame only */
+
+    bool build_voxel;                   /**< build the sparse voxel map too */
+    float voxel_size;                   /**< size of a voxel(m) */
+};
+
+/** @struct  IscOccupancyGridData
+ *  @brief This is the occupancy grid, the buffers are allocated by the caller
+ */
+struct IscOccupancyGridData {
+    int max_cell_count;                 /**< number of cells the buffers can hold */
+    float* occupied;                    /**< evidence of obstacles, [z][x], nullptr if not required */
+    float* ground;                      /**< evidence of the ground, [z][x], nullptr if not required */
+
+    int cell_count_x;                   /**< number of cells horizontally */
+    int cell_count_z;                   /**< number of cells forward */
+    __int64 frame_time;                 /**< time of the last frame (UNIX UTC msec) */
+    int frame_index;                    /**< number of the last frame */
+};
+
+/** @struct  IscVoxel
+ *  @brief This is a voxel of the voxel map
+ */
+struct IscVoxel {
+    int x;                              /**< index, x * voxel_size(m) from the camera to the right */
+    int y;                              /**< index, y * voxel_size(m) from the ground to the up */
+    int z;                              /**< index, z * voxel_size(m) from the camera to the forward */
+    float value;                        /**< evidence */
+};
+
+/** @struct  IscVoxelMapData
+ *  @brief This is the voxel map, the buffer is allocated by the caller
+ */
+struct IscVoxelMapData {
+    int max_voxel_count;                /**< number of voxels the buffer can hold */
+    IscVoxel* voxels;                   /**< voxels */
+
+    int voxel_count;                    /**< number of voxels */
+    float voxel_size;                   /**< size of a voxel(m) */
+    __int64 frame_time;                 /**< time of the last frame (UNIX UTC msec) */
+    int frame_index;                    /**< number of the last frame */
+};
+
+/** @struct  IscUvDisparityParameter
+ *  @brief This is the parameter to build the u-disparity and v-disparity from the block disparity
+ */
+struct IscUvDisparityParameter {
+    bool enabled;                       /**< build the histograms each time the block disparity is ready */
+
+    int disparity_resolution;           /**< bins per pixel of disparity 1 ~ 16 */
+    int max_disparity;                  /**< disparity(pixel) covered by the histograms, number of bins = max_disparity x disparity_resolution */
+
+    bool fit_ground_line;               /**< fit the ground line to the v-disparity by RANSAC */
+    int ground_min_count;               /**< minimum count of a v-disparity cell used for the fit */
+    float ground_tolerance;             /**< distance of disparity(pixel) from the line counted as inlier */
+    int ground_iteration_count;         /**< number of iterations of RANSAC */
+};
+
+/** @struct  IscUvDisparityData
+ *  @brief This is the u-disparity and v-disparity, the buffers are allocated by the caller
+ */
+struct IscUvDisparityData {
+    int max_u_count;                    /**< number of elements the u_disparity buffer can hold */
+    int* u_disparity;                   /**< [bin][block x], nullptr if not required */
+    int max_v_count;                    /**< number of elements the v_disparity buffer can hold */
+    int* v_disparity;                   /**< [block y][bin], nullptr if not required */
+
+    int block_width;                    /**< width of the disparity block */
+    int block_height;                   /**< height of the disparity block */
+    int block_count_x;                  /**< number of blocks horizontally */
+    int block_count_y;                  /**< number of blocks vertically */
+    int bin_count;                      /**< number of bins of disparity */
+    int disparity_resolution;           /**< bins per pixel of disparity */
+
+    bool has_ground_line;               /**< the ground line is found */
+    float ground_slope;                 /**< disparity(pixel) = ground_slope x y(pixel) + ground_intercept */
+    float ground_intercept;
+    int ground_inlier_count;            /**< number of blocks on the ground line */
+
+    __int64 frame_time;                 /**< time of the frame (UNIX UTC msec) */
+    int frame_index;                    /**< number of the frame */
+};
+
+/** @struct  IscBlockDisparityFixedData
+ *  @brief This is the fixed-point block disparity of the latest frame, the buffer is allocated by the caller
+ */
+struct IscBlockDisparityFixedData {
+    int max_block_count;                /**< number of elements the block_value buffer can hold */
+    unsigned short* block_value;        /**< [block y][block x] disparity x fixed_point_scale, 0:invalid, nullptr if not required */
+
+    int image_width;                    /**< width of the image */
+    int image_height;                   /**< height of the image */
+    int block_width;                    /**< width of the disparity block */
+    int block_height;                   /**< height of the disparity block */
+    int block_count_x;                  /**< number of blocks horizontally */
+    int block_count_y;                  /**< number of blocks vertically */
+    int fixed_point_scale;              /**< kISC_DISPARITY_FIXED_POINT_SCALE */
+
+    float d_inf;                        /**< d_inf of the camera */
+    float bf;                           /**< bf of the camera */
+
+    __int64 frame_time;                 /**< time of the frame (UNIX UTC msec) */
+    int frame_index;                    /**< number of the frame */
+};
+
+/** @struct  IscValidBlockListData
+ *  @brief This is the list of the blocks which have the disparity in the latest frame, the buffer is allocated by the caller
+ */
+struct IscValidBlockListData {
+    int max_valid_block_count;          /**< number of elements the valid_block buffer can hold */
+    IscValidBlock* valid_block;         /**< blocks which have the disparity in block row order, nullptr if not required */
+    int valid_block_count;              /**< number of the blocks which have the disparity */
+
+    int image_width;                    /**< width of the image */
+    int image_height;                   /**< height of the image */
+    int block_width;                    /**< width of the disparity block */
+    int block_height;                   /**< height of the disparity block */
+    int block_count_x;                  /**< number of blocks horizontally */
+    int block_count_y;                  /**< number of blocks vertically */
+    int fixed_point_scale;              /**< kISC_DISPARITY_FIXED_POINT_SCALE */
+
+    float d_inf;                        /**< d_inf of the camera */
+    float bf;                           /**< bf of the camera */
+
+    __int64 frame_time;                 /**< time of the frame (UNIX UTC msec) */
+    int frame_index;                    /**< number of the frame */
+};
+
+constexpr int kISC_RANGE_INDEX_MAX_ZONE_COUNT = 32;     /**< maximum number of the zones evaluated every frame */
+
+/** @struct  IscRangeZone
+ *  @brief This is a zone of the range query, the blocks which overlap the region are used
+ */
+struct IscRangeZone {
+    int x;                              /**< top left of region */
+    int y;                              /**< top left of region */
+    int width;                          /**< width of region */
+    int height;                         /**< height of region */
+
+    float min_distance;                 /**< minimum distance(m) counted as in range */
+    float max_distance;                 /**< maximum distance(m) counted as in range */
+};
+
+/** @struct  IscRangeZoneResult
+ *  @brief This is the result of the range query
+ */
+struct IscRangeZoneResult {
+    int valid_count;                    /**< number of the valid blocks */
+    int in_range_count;                 /**< number of the valid blocks in the range of the zone */
+    float min_distance;                 /**< distance of the nearest block(m), 0 if there is no valid block */
+    float max_distance;                 /**< distance of the farthest block(m), 0 if there is no valid block */
+};
+
+/** @struct  IscRangeIndexParameter
+ *  @brief This is the parameter of the range index built from the block disparity
+ */
+struct IscRangeIndexParameter {
+    bool enabled;                       /**< build the index each time the block disparity is ready */
+
+    int zone_count;                     /**< number of the zones evaluated every frame */
+    IscRangeZone zones[kISC_RANGE_INDEX_MAX_ZONE_COUNT];
+};
+
+/** @struct  IscRangeZoneData
+ *  @brief This is the results of the zones of the latest frame
+ */
+struct IscRangeZoneData {
+    int zone_count;                     /**< number of the zones */
+    IscRangeZoneResult results[kISC_RANGE_INDEX_MAX_ZONE_COUNT];
+
+    __int64 frame_time;                 /**< time of the frame (UNIX UTC msec) */
+    int frame_index;                    /**< number of the frame */
+};
+
+constexpr int kISC_DATA_CALLBACK_MAX_QUEUE_COUNT = 8;   /**< maximum number of queued data for callback */
+constexpr int kISC_DATA_CALLBACK_RELEASE = 0;           /**< callback return value, the data is released when the callback returns */
+constexpr int kISC_DATA_CALLBACK_HOLD = 1;              /**< callback return value, the data is held until ReleaseCallbackData() is called */
+
+/** @enum  IscDataCallbackDropPolicy
+ *  @brief This is the policy applied when the callback queue is full
+ */
+enum class IscDataCallbackDropPolicy {
+    kDropOldest = 0,    /**< discard the oldest undelivered data and queue the new one */
+    kDropNewest         /**< discard the newly published data */
+};
+
+/** @struct  IscDataCallbackParameter
+ *  @brief This is the parameter for callback registration
+ */
+struct IscDataCallbackParameter {
+    int max_queue_count;                    /**< number of data that can be queued or held 1~kISC_DATA_CALLBACK_MAX_QUEUE_COUNT */
+    IscDataCallbackDropPolicy drop_policy;  /**< policy when the queue is full */
+};
+
+/** @struct  IscDataCallbackStatus
+ *  @brief This is the delivery status of callback
+ */
+struct IscDataCallbackStatus {
+    bool registered;                /**< true, if a callback is registered */
+    __int64 published_count;        /**< number of data published to the queue */
+    __int64 delivered_count;        /**< number of data passed to the callback */
+    __int64 dropped_count;          /**< number of data discarded by the drop policy */
+    int queued_count;               /**< number of data waiting for delivery */
+    int held_count;                 /**< number of data held by the client */
+};
+
+/** @brief callback for camera data. isc_image_info is read-only and valid until it is released.
+    @return kISC_DATA_CALLBACK_RELEASE or kISC_DATA_CALLBACK_HOLD.
+*/
+typedef int (*IscCameraDataCallback)(const IscImageInfo* isc_image_info, const int release_token, void* user_context);
+
+/** @brief callback for data processing result. isc_data_proc_result_data is read-only and valid until it is released.
+    @return kISC_DATA_CALLBACK_RELEASE or kISC_DATA_CALLBACK_HOLD.
+*/
+typedef int (*IscDataProcResultCallback)(const IscDataProcResultData* isc_data_proc_result_data, const int release_token, void* user_context);
+
+constexpr int kISC_REPROCESS_MAX_RANGE_COUNT = 64;      /**< maximum number of ranges of a reprocessing */
+constexpr int kISC_REPROCESS_RANGE_ALIGNMENT = 4;       /**< range boundary in records, it keeps mono/color and double shutter sets together */
+
+/** @struct  IscReprocessParameter
+ *  @brief This is the parameter to reprocess a range of the RAW data file
+ */
+struct IscReprocessParameter {
+    wchar_t play_file_name[_MAX_PATH];              /**< RAW data file to reprocess */
+    wchar_t result_file_name[_MAX_PATH];            /**< result file of the range */
+    __int64 start_frame_number;                     /**< first record of the range */
+    __int64 end_frame_number;                       /**< record after the range, -1:to the end of the file */
+    IscDataProcStartMode isc_dataproc_start_mode;   /**< modules to run */
+    bool write_block_disparity;                     /**< write the block disparity */
+    bool write_depth;                               /**< write the disparity of each pixel */
+};
+
+/** @struct  IscReprocessStatus
+ *  @brief This is the result of the reprocessing of a range
+ */
+struct IscReprocessStatus {
+    __int64 start_frame_number;     /**< first record processed */
+    __int64 end_frame_number;       /**< record after the last record processed */
+    __int64 processed_frame_count;  /**< number of frames written to the result file */
+    __int64 failed_frame_count;     /**< number of frames the modules failed to process */
+    double elapsed_time_msec;       /**< time to process the range */
+    double frames_per_second;       /**< frames processed per second */
+};
+
+/** @struct  IscReprocessRangeList
+ *  @brief This is the split of the RAW data file for the reprocessing
+ */
+struct IscReprocessRangeList {
+    struct Range {
+        __int64 start_frame_number; /**< first record of the range */
+        __int64 end_frame_number;   /**< record after the range */
+    };
+
+    __int64 total_frame_count;      /**< number of records of the file */
+    int range_count;                /**< number of ranges */
+    Range range[kISC_REPROCESS_MAX_RANGE_COUNT];    /**< ranges in order of the file */
+};
+
+/** @struct  IscReprocessMergeParameter
+ *  @brief This is the parameter to merge the result files of the ranges
+ */
+struct IscReprocessMergeParameter {
+    int range_file_count;                                               /**< number of result files of the ranges */
+    wchar_t range_file_name[kISC_REPROCESS_MAX_RANGE_COUNT][_MAX_PATH]; /**< result files of the ranges in order */
+    wchar_t result_file_name[_MAX_PATH];                                /**< merged result file */
+    bool delete_range_files;                                            /**< delete the result files of the ranges after merging */
+};
+
+// REPROCESS RESULT file format
+//
+// |-----------------------------------|
+// |    RESULT FILE HEADER             |
+// |-----------------------------------|
+// |    RESULT FRAME HEADER            |
+// |-----------------------------------|
+// |    BLOCK DISPARITY (float)        |  block_count_x x block_count_y, if written
+// |-----------------------------------|
+// |    DEPTH (float)                  |  depth_width x depth_height, if written
+// |-----------------------------------|
+// |    RESULT FRAME HEADER            |
+// |-----------------------------------|
+//
+
+constexpr int ISC_REPROCESS_RESULT_HEADER_VERSION = 100;    /**< Result Header Version 1.0.0 */
+
+/** @struct  IscReprocessResultFileHeader
+ *  @brief This is the header of the reprocess result file
+ */
+struct IscReprocessResultFileHeader {
+    char    mark[32];                   /**< MARK "ISC REPROCESS RESULT" */
+    int     version;                    /**< Header version */
+    int     header_size;                /**< Header size */
+    int     frame_header_size;          /**< Frame header size */
+    int     reserve0;                   /**< Reserve */
+    __int64 start_frame_number;         /**< first record of the RAW data file */
+    __int64 end_frame_number;           /**< record after the last record */
+    __int64 frame_count;                /**< number of frames */
+    IscRawFileHeader raw_file_header;   /**< header of the RAW data file */
+    int     reserve[8];                 /**< Reserve */
+};
+
+/** @struct  IscReprocessResultFrameHeader
+ *  @brief This is the header of one frame of the reprocess result file
+ */
+struct IscReprocessResultFrameHeader {
+    __int64 frame_number;       /**< record of the RAW data file */
+    __int64 frame_time;         /**< frame time (UTC msec) */
+    int     frame_index;        /**< frame index of the camera */
+    int     result_code;        /**< result of the modules 0:success */
+    int     block_width;        /**< width of the disparity block */
+    int     block_height;       /**< height of the disparity block */
+    int     block_count_x;      /**< number of blocks written horizontally, 0:not written */
+    int     block_count_y;      /**< number of blocks written vertically */
+    int     depth_width;        /**< width of the disparity written, 0:not written */
+    int     depth_height;       /**< height of the disparity written */
+};
+
+constexpr int kISC_RESULT_RECORD_SUBPIXEL_TIMES = 250;          /**< disparity x 250 in uint16, 1/4 of MATCHING_SUBPIXEL_TIMES(1000) so that 255 pixels fit */
+constexpr int kISC_RESULT_RECORD_DEFAULT_KEY_FRAME_INTERVAL = 30;   /**< default number of frames from a key frame to the next */
+
+/** @struct  IscResultRecordParameter
+ *  @brief This is the parameter to record the block disparity of the data processing result
+ */
+struct IscResultRecordParameter {
+    wchar_t file_name[_MAX_PATH];   /**< result record file */
+    int key_frame_interval;         /**< frames from a key frame to the next 1:all key frames, 0:default */
+    bool use_fixed_point;           /**< record the fixed-point block disparity (kISC_DISPARITY_FIXED_POINT_SCALE, after the disparity filter) as is */
+};
+
+/** @struct  IscResultRecordStatus
+ *  @brief This is the status of the result recording
+ */
+struct IscResultRecordStatus {
+    bool recording;                 /**< true, if recording */
+    __int64 frame_count;            /**< number of frames written */
+    __int64 key_frame_count;        /**< number of key frames written */
+    __int64 failed_count;           /**< number of frames failed to write */
+    __int64 block_data_size;        /**< size of the block disparity written as float */
+    __int64 file_size;              /**< size of the file */
+    double compression_ratio;       /**< block_data_size / file_size */
+};
+
+/** @struct  IscResultRecordInformation
+ *  @brief This is the information of the result record file
+ */
+struct IscResultRecordInformation {
+    __int64 frame_count;            /**< number of frames */
+    __int64 start_time;             /**< frame time of the first frame (UTC msec) */
+    __int64 end_time;               /**< frame time of the last frame (UTC msec) */
+    int image_width;                /**< width of the image of the first frame */
+    int image_height;               /**< height of the image of the first frame */
+    int block_width;                /**< width of the disparity block */
+    int block_height;               /**< height of the disparity block */
+    int block_count_x;              /**< number of blocks horizontally */
+    int block_count_y;              /**< number of blocks vertically */
+    int subpixel_times;             /**< scale of the fixed-point disparity */
+    int key_frame_interval;         /**< frames from a key frame to the next */
+    bool has_index;                 /**< false, if the index was rebuilt by scanning the file */
+};
+
+/** @struct  IscResultRecordFrame
+ *  @brief This is one frame read from the result record file
+ */
+struct IscResultRecordFrame {
+    float* block_disparity;         /**< [in] caller-owned buffer of disparity, nullptr to skip */
+    unsigned short* block_value;    /**< [in] caller-owned buffer of fixed-point disparity, nullptr to skip */
+    int buffer_count;               /**< [in] number of elements of the buffers */
+
+    __int64 frame_time;             /**< [out] frame time (UTC msec) */
+    int frame_index;                /**< [out] frame index of the camera */
+    int image_width;                /**< [out] width of the image */
+    int image_height;               /**< [out] height of the image */
+    int block_width;                /**< [out] width of the disparity block */
+    int block_height;               /**< [out] height of the disparity block */
+    int block_count_x;              /**< [out] number of blocks horizontally */
+    int block_count_y;              /**< [out] number of blocks vertically */
+};
+
+// RESULT RECORD file format
+//
+// |-----------------------------------|
+// |    RESULT RECORD HEADER           |
+// |-----------------------------------|
+// |    RESULT RECORD FRAME HEADER     |
+// |-----------------------------------|
+// |    LOW BYTE PLANE                 |  rANS coded or as is
+// |-----------------------------------|
+// |    HIGH BYTE PLANE                |  rANS coded or as is
+// |-----------------------------------|
+// |    RESULT RECORD FRAME HEADER     |
+// |-----------------------------------|
+// |    ...                            |
+// |-----------------------------------|
+// |    RESULT RECORD INDEX            |  frame_count entries, written when the recording stops
+// |-----------------------------------|
+//
+// The disparity of a block is stored as uint16 in kISC_RESULT_RECORD_SUBPIXEL_TIMES.
+// A key frame is predicted from the left block, the other frames from the same block of the previous frame.
+// The prediction residual is zigzag coded and split into the low and the high byte planes.
+//
+
+constexpr int ISC_RESULT_RECORD_HEADER_VERSION = 100;           /**< Result Record Header Version 1.0.0 */
+constexpr int kISC_RESULT_RECORD_FRAME_KEY = 0x0001;            /**< frame flag, key frame */
+constexpr int kISC_RESULT_RECORD_PLANE_STORED = 0x0001;         /**< plane flag, the plane is not coded */
+
+/** @struct  IscResultRecordFileHeader
+ *  @brief This is the header of the result record file
+ */
+struct IscResultRecordFileHeader {
+    char    mark[32];               /**< MARK "ISC RESULT RECORD" */
+    int     version;                /**< Header version */
+    int     header_size;            /**< Header size */
+    int     frame_header_size;      /**< Frame header size */
+    int     subpixel_times;         /**< scale of the fixed-point disparity */
+    int     key_frame_interval;     /**< frames from a key frame to the next */
+    int     reserve0;               /**< Reserve */
+    __int64 frame_count;            /**< number of frames, 0 if the recording did not stop */
+    __int64 index_offset;           /**< offset of the index, 0 if the recording did not stop */
+    int     reserve[8];             /**< Reserve */
+};
+
+/** @struct  IscResultRecordFrameHeader
+ *  @brief This is the header of one frame of the result record file
+ */
+struct IscResultRecordFrameHeader {
+    __int64 frame_time;             /**< frame time (UTC msec) */
+    int     frame_index;            /**< frame index of the camera */
+    int     flags;                  /**< kISC_RESULT_RECORD_FRAME_KEY */
+    int     image_width;            /**< width of the image */
+    int     image_height;           /**< height of the image */
+    int     block_width;            /**< width of the disparity block */
+    int     block_height;           /**< height of the disparity block */
+    int     block_count_x;          /**< number of blocks horizontally */
+    int     block_count_y;          /**< number of blocks vertically */
+    int     plane_flags[2];         /**< kISC_RESULT_RECORD_PLANE_STORED of the low and the high plane */
+    int     plane_size[2];          /**< size of the low and the high plane */
+};
+
+/** @struct  IscResultRecordIndexEntry
+ *  @brief This is one entry of the index of the result record file
+ */
+struct IscResultRecordIndexEntry {
+    __int64 offset;                 /**< offset of the frame header */
+    __int64 frame_time;             /**< frame time (UTC msec) */
+    int     flags;                  /**< flags of the frame */
+    int     reserve;                /**< Reserve */
+};
+
 #endif /* ISC_DPL_DEF_H */
@@ -74,6 +74,8 @@
 #define CAMCONTROL_E_READ_FILE_FAILED_RETRY     ((DPL_RESULT) 0xC2000032)  /**< can't read from file and request retry. */
 #define CAMCONTROL_E_READ_CAMERA_MODEL          ((DPL_RESULT) 0xC2000033)  /**< camera model not match. */
 #define CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE      ((DPL_RESULT) 0xC2000034)  /**< Not enough free space. */
+#define CAMCONTROL_E_NO_FILE_INDEX              ((DPL_RESULT) 0xC2000035)  /**< There is no index for the file. */
+#define CAMCONTROL_E_INVALID_COMPRESSED_DATA    ((DPL_RESULT) 0xC2000036)  /**< The compressed data is invalid. */
 
 #define DPCCONTROL_E_FAIL                       ((DPL_RESULT) 0xB2000001)  /**< Unspecified error occurred. */
 #define DPCCONTROL_E_OPVERLAPED_OPERATION       ((DPL_RESULT) 0xB2000002)  /**< The processing overlaps. */
@@ -0,0 +1,143 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_async_file_writer.h
+ * @brief asynchronous writer of raw data file
+ */
+
+#pragma once
+
+/**
+ * @class   IscAsyncFileWriter
+ * @brief   file writer class
+ * this class gathers the data into large aligned batches and writes them with several overlapped requests in flight
+ */
+class IscAsyncFileWriter
+{
+public:
+	IscAsyncFileWriter();
+	~IscAsyncFileWriter();
+
+	/** @brief allocate the batch buffers. batch_size must be a multiple of the sector size.
+		@return 0, if successful.
+	*/
+	int Initialize(const int batch_size, const int request_count, const bool direct_io);
+
+	/** @brief close the file and release the buffers.
+		@return 0, if successful.
+	*/
+	int Terminate();
+
+	/** @brief create the file and reserve the disk space for it.
+		@return 0, if successful.
+	*/
+	int Open(const wchar_t* file_name, const __int64 preallocate_size);
+
+	/** @brief create one file in each folder and the manifest. the write requests are distributed over the files by weight.
+		@return 0, if successful.
+	*/
+	int OpenStriped(const wchar_t* manifest_file_name, const int stripe_count, const wchar_t stripe_folder[][_MAX_PATH], const __int64 preallocate_size);
+
+	/** @brief set the weight of the distribution. 0 stops writing to the file.
+		@return none.
+	*/
+	void SetStripeWeight(const int stripe_index, const __int64 weight);
+
+	/** @brief append the data to the file.
+		@return 0, if successful.
+	*/
+	int Write(const void* data, const __int64 size);
+
+	/** @brief write the remaining data, wait for all requests and close the file.
+		@return 0, if successful.
+	*/
+	int Close();
+
+	/** @brief clear the statistics.
+		@return none.
+	*/
+	void ResetStatistics();
+
+	/** @brief get the statistics of the write requests. the fields of the frame are not changed.
+		@return none.
+	*/
+	void GetStatistics(IscRecordWriteStatistics* isc_record_write_statistics);
+
+private:
+
+	static constexpr int kSectorSize = 4096;
+	static constexpr int kLatencySampleCount = 1024;
+
+	struct WriteRequest {
+		unsigned char* buffer;
+		int size;						/**< size of the data in the buffer */
+		int submit_size;				/**< size of the request (padded for direct I/O) */
+		int stripe_index;				/**< file of the request */
+		bool pending;
+		OVERLAPPED overlapped;
+		LARGE_INTEGER submit_time;
+	};
+
+	int batch_size_;
+	int request_count_;
+	bool direct_io_;
+
+	WriteRequest write_request_[kISC_RECORD_WRITE_MAX_REQUEST_COUNT];
+	int current_request_;
+
+	struct Stripe {
+		HANDLE handle_file;
+		wchar_t file_name[_MAX_PATH];
+		__int64 file_offset;			/**< offset of the next request */
+		__int64 logical_size;			/**< size of the data written (without padding) */
+		__int64 weight;
+		__int64 current_weight;
+	};
+	Stripe stripe_[kISC_SAVE_MAX_SAVE_FOLDER_COUNT];
+	int stripe_count_;
+	bool is_striped_;
+
+	wchar_t manifest_file_name_[_MAX_PATH];
+	unsigned char* chunk_stripe_;		/**< file of each request, for the manifest */
+	__int64 chunk_count_;
+	__int64 chunk_capacity_;
+
+	__int64 logical_size_;				/**< size of the data written */
+
+	LARGE_INTEGER frequency_;
+
+	CRITICAL_SECTION statistics_critical_;
+	struct Statistics {
+		__int64 request_count;
+		__int64 written_bytes;
+		__int64 stall_count;
+		int requests_in_flight;
+		int max_requests_in_flight;
+		double latency_max_msec;
+		ULONGLONG start_time;
+		__int64 stripe_written_bytes[kISC_SAVE_MAX_SAVE_FOLDER_COUNT];
+		double latency_sample[kLatencySampleCount];
+		int latency_sample_count;
+		int latency_sample_index;
+	};
+	Statistics statistics_;
+
+	int CreateStripeFile(Stripe* stripe, const __int64 preallocate_size);
+	int SelectStripe();
+	int SubmitRequest(WriteRequest* write_request);
+	int WaitRequest(WriteRequest* write_request);
+	int NextRequest();
+
+};
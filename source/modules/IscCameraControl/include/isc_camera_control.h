@@ -331,11 +331,84 @@ public:
 	*/
 	int SetReadFrameNumber(const __int64 frame_number);
 
+	/** @brief Set the read Frame to the first frame at or after the specified time. The index file is required.
+		@return 0, if successful.
+	*/
+	int SetReadFrameTime(const __int64 frame_time);
+
+	/** @brief make the index file of the raw data file. it is for files recorded without the index.
+		@return 0, if successful.
+	*/
+	int RebuildFileIndex(const wchar_t* play_file_name, __int64* entry_count);
+
 	/** @brief Get the status.
 		@return 0, if successful.
 	*/
 	int GetFileReadStatus(__int64* frame_number, IscFileReadStatus* file_read_status);
 
+	// thread placement
+
+	/** @brief append the placement applied to the threads of camera control.
+		@return 0, if successful.
+	*/
+	int GetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status);
+
+	// record compression
+
+	/** @brief set the compression of the raw data recording. it is applied at the next start of recording.
+		@return 0, if successful.
+	*/
+	int SetRecordCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter);
+
+	/** @brief get the compression of the raw data recording.
+		@return 0, if successful.
+	*/
+	int GetRecordCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter);
+
+	/** @brief get the result of the compression of the current recording.
+		@return 0, if successful.
+	*/
+	int GetRecordCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics);
+
+	// record writer
+
+	/** @brief set the writing of the raw data recording. it is applied at the next start of recording.
+		@return 0, if successful.
+	*/
+	int SetRecordWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter);
+
+	/** @brief get the writing of the raw data recording.
+		@return 0, if successful.
+	*/
+	int GetRecordWriteParameter(IscRecordWriteParameter* isc_record_write_parameter);
+
+	/** @brief get the queue depth, dropped frames and write latency of the current recording.
+		@return 0, if successful.
+	*/
+	int GetRecordWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics);
+
+	// play
+
+	/** @brief get the pacing and the achieved rate of the current playback.
+		@return 0, if successful.
+	*/
+	int GetPlayStatistics(IscPlayStatistics* isc_play_statistics);
+
+	/** @brief set how the decoded frames are kept during the playback.
+		@return 0, if successful.
+	*/
+	int SetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter);
+
+	/** @brief get how the decoded frames are kept during the playback.
+		@return 0, if successful.
+	*/
+	int GetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter);
+
+	/** @brief get the usage of the decoded frame cache.
+		@return 0, if successful.
+	*/
+	int GetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status);
+
 
 private:
 	IscLog* isc_log_;
@@ -377,6 +450,8 @@ private:
 	HANDLE thread_handle_;
 	CRITICAL_SECTION	threads_critical_;
 
+	IscThreadPlacement* isc_thread_placement_;
+
 	static unsigned __stdcall ControlThread(void* context);
 	int RecieveDataProc();
 
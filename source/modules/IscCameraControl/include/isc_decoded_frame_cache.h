@@ -0,0 +1,123 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_decoded_frame_cache.h
+ * @brief cache of decoded frames for the play
+ */
+
+#pragma once
+
+/**
+ * @class   IscDecodedFrameCache
+ * @brief   cache class
+ * this class keeps the decoded frames of the file being played within the memory budget, and discards the least recently used frames
+ */
+class IscDecodedFrameCache
+{
+public:
+	IscDecodedFrameCache();
+	~IscDecodedFrameCache();
+
+	/** @brief allocate the table of the frames.
+		@return 0, if successful.
+	*/
+	int Initialize();
+
+	/** @brief release all the frames.
+		@return 0, if successful.
+	*/
+	int Terminate();
+
+	/** @brief set the memory budget. the frames over the budget are discarded.
+		@return none.
+	*/
+	void SetMemoryBudget(const __int64 memory_budget);
+
+	/** @brief set the file and the decode mode. the frames are discarded if they are changed.
+		@return none.
+	*/
+	void SetSource(const wchar_t* file_name, const IscGetModeColor isc_get_color_mode);
+
+	/** @brief discard all the frames.
+		@return none.
+	*/
+	void Clear();
+
+	/** @brief whether the frame is in the cache.
+		@return true, if found.
+	*/
+	bool Contains(const __int64 frame_number, __int64* next_frame_number);
+
+	/** @brief copy the frame to the buffers of isc_image_info.
+		@return true, if found.
+	*/
+	bool Get(const __int64 frame_number, IscImageInfo* isc_image_info, __int64* next_frame_number, unsigned __int64* next_read_offset);
+
+	/** @brief add a copy of the frame.
+		@return 0, if successful.
+	*/
+	int Put(const __int64 frame_number, const IscImageInfo* isc_image_info, const __int64 next_frame_number, const unsigned __int64 next_read_offset, const bool is_prefetched);
+
+	/** @brief get the status of the cache.
+		@return none.
+	*/
+	void GetStatus(IscPlayCacheStatus* isc_play_cache_status);
+
+	/** @brief allocate the buffers of isc_image_info for the specified size.
+		@return 0, if successful.
+	*/
+	static int AllocateImageInfo(const int width, const int height, IscImageInfo* isc_image_info);
+
+	/** @brief release the buffers allocated by AllocateImageInfo().
+		@return none.
+	*/
+	static void ReleaseImageInfo(IscImageInfo* isc_image_info);
+
+private:
+
+	struct CacheEntry {
+		bool is_used;
+		__int64 frame_number;			/**< 読み込みを開始したデータの番号 */
+		__int64 next_frame_number;		/**< 読み込み後のデータの番号 */
+		unsigned __int64 next_read_offset;	/**< 読み込み後のファイルの位置 */
+		unsigned __int64 last_access;	/**< 最後に使用した順番 (LRU) */
+		size_t size;
+		unsigned char* buffer;
+		IscImageInfo isc_image_info;	/**< 画像はbufferを指します */
+	};
+	CacheEntry* entry_;
+	int entry_count_;
+
+	CRITICAL_SECTION cache_critical_;
+
+	wchar_t file_name_[_MAX_PATH];
+	IscGetModeColor isc_get_color_mode_;
+
+	__int64 memory_budget_;
+	__int64 used_size_;
+	unsigned __int64 access_count_;
+
+	__int64 hit_count_;
+	__int64 miss_count_;
+	__int64 prefetched_count_;
+
+	int FindEntry(const __int64 frame_number) const;
+	void ReleaseEntry(CacheEntry* entry);
+	bool EvictLeastRecentlyUsed();
+
+	static size_t GetImageInfoSize(const IscImageInfo* isc_image_info);
+	static void CopyImageInfo(const IscImageInfo* src, IscImageInfo* dst);
+
+};
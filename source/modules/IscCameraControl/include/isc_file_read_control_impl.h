@@ -74,11 +74,41 @@ public:
 	*/
 	int SetReadFrameNumber(const __int64 frame_number);
 
+	/** @brief Set the read Frame to the first frame at or after the specified time. The index file is required.
+		@return 0, if successful.
+	*/
+	int SetReadFrameTime(const __int64 frame_time);
+
 	/** @brief Get the status.
 		@return 0, if successful.
 	*/
 	int GetFileReadStatus(__int64* frame_number, IscFileReadStatus* file_read_status);
 
+	/** @brief get the pacing and the reading speed of the play.
+		@return 0, if successful.
+	*/
+	int GetPlayStatistics(IscPlayStatistics* isc_play_statistics);
+
+	/** @brief set the cache of decoded frames. it is applied from the next start of the play.
+		@return 0, if successful.
+	*/
+	int SetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter);
+
+	/** @brief get the cache of decoded frames.
+		@return 0, if successful.
+	*/
+	int GetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter);
+
+	/** @brief get the hits and the memory of the cache of decoded frames.
+		@return 0, if successful.
+	*/
+	int GetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status);
+
+	/** @brief set the placement applied to the prefetch and the decompression threads.
+		@return none.
+	*/
+	void SetThreadPlacement(IscThreadPlacement* isc_thread_placement);
+
 
 private:
 
@@ -88,14 +118,27 @@ private:
 	struct FileRaedInformation {
 		IscFileReadStatus file_read_status;
 		wchar_t read_file_name[_MAX_PATH];
-		unsigned __int64 file_size;
+		unsigned __int64 file_size;				/**< 最後の正しいデータの終わりまでのサイズ */
+		unsigned __int64 raw_file_size;			/**< ファイルの実際のサイズ (事前確保や書き込み途中の領域を含む) */
 
 		HANDLE handle_file;
 		bool is_file_ready;
+		bool is_striped;						/**< 保存先に分散されたファイル (handle_fileはマニフェスト) */
+
+		HANDLE handle_file_mapping;
+		const unsigned char* mapped_view;		/**< ファイル全体のView (nullptr:ReadFileで読み込む) */
+		unsigned __int64 mapped_size;
+		unsigned __int64 prefetch_start;
+		unsigned __int64 prefetch_end;
+		unsigned __int64 prefetch_size;
 
 		IscRawFileHeader raw_file_header;
+		IscRawDataHeader first_data_header;		/**< 先頭のデータのヘッダー (データの確認の基準) */
 		unsigned __int64 total_read_size;
 
+		bool follow_growing_file;				/**< 記録中のファイルの追記を待って読み込む */
+		ULONGLONG follow_check_time;			/**< 最後に追記を確認した時刻 (msec) */
+
 		__int64 current_frame_number;
 
 		bool request_fo_designated_number;
@@ -109,12 +152,83 @@ private:
 		IscRawDataHeader isc_raw_data_header;
 		int width, height;
 		unsigned char* buffer;
+		unsigned char* compressed_buffer;	/**< 圧縮データの読み込み用 (ReadFileの場合) */
+		const unsigned char* data;		/**< 読み込んだデータ bufferまたはViewを指します */
+		int decoded_size;				/**< dataのサイズ(展開後) isc_raw_data_header.data_sizeはファイル上のサイズのままです */
 	};
 	RawReadData raw_read_data_;
 
 	RawDataDecoder* raw_data_decoder_;
 
+	IscRawFileIndex* raw_file_index_;
+
+	IscRawDataCodec* raw_data_codec_;
+
+	IscRawFileStripe* raw_file_stripe_;
+
+	// pacing of the play
+	struct PlayPacing {
+		LARGE_INTEGER frequency;
+
+		bool is_started;
+		LARGE_INTEGER start_counter;			/**< 基準の時刻 */
+		__int64 start_frame_time;				/**< 基準のフレームの時刻 (kRealTime) */
+		__int64 scheduled_count;				/**< 基準からのフレーム数 (kFixedRate) */
+		__int64 previous_frame_time;
+
+		LARGE_INTEGER first_counter;
+		LARGE_INTEGER last_counter;
+		__int64 frame_count;
+		__int64 late_frame_count;
+		double read_time_total_msec;
+
+		__int64 recorded_interval_count;		/**< 記録時のフレーム間隔 (kRealTimeの目標) */
+		double recorded_interval_total_msec;
+	};
+	PlayPacing play_pacing_;
+	CRITICAL_SECTION play_pacing_critical_;
+
+	// cache of decoded frames
+	IscPlayCacheParameter play_cache_parameter_;
+	IscDecodedFrameCache* decoded_frame_cache_;
+	bool is_cache_enabled_;
+
+	// prefetch of the play
+	struct PlayPrefetch {
+		IscFileReadControlImpl* reader;			/**< 先読み用の読み込み (同じファイルを別に開きます) */
+		IscImageInfo isc_image_info;			/**< 先読みの展開先 */
+
+		HANDLE thread_handle;
+		HANDLE handle_event;
+		int terminate_request;
+		int terminate_done;
+
+		__int64 request_frame_number;			/**< 先読みの基準 (次に読み込むデータの番号) */
+		__int64 stride;							/**< 1回の読み込みで進むデータの数 */
+	};
+	PlayPrefetch play_prefetch_;
+	CRITICAL_SECTION play_prefetch_critical_;
+
+	IscThreadPlacement* isc_thread_placement_;
+
 	bool GetDatFileSize(TCHAR* file_name, unsigned __int64* file_size);
+	BOOL ReadFromFile(LPVOID buffer, DWORD number_of_bytes_to_read, LPDWORD number_of_bytes_read);
+	BOOL SeekReadFile(LARGE_INTEGER distance_to_move, PLARGE_INTEGER new_file_pointer, DWORD move_method);
+
+	bool MapReadFile();
+	void UnmapReadFile();
+	void PrefetchReadFile();
+	int ReadRawRecord();
+	int DecompressRawRecord(const unsigned char* src);
+
+	bool ReadRawDataHeaderAt(HANDLE handle_file, const unsigned __int64 offset, IscRawDataHeader* isc_raw_data_header);
+	bool IsValidRawDataHeader(const IscRawDataHeader* isc_raw_data_header, const IscRawDataHeader* first_data_header, const int max_data_size) const;
+	__int64 FindValidRecordCount(HANDLE handle_file, const IscRawFileHeader* raw_file_header, const IscRawDataHeader* first_data_header, const int max_data_size, const unsigned __int64 file_size,
+									const __int64 start_count, const unsigned __int64 start_offset, unsigned __int64* valid_size);
+	__int64 FindValidIndexCount(HANDLE handle_file, const IscRawFileIndex* raw_file_index, const IscRawDataHeader* first_data_header, const int max_data_size, const __int64 start_count);
+	__int64 RecoverReadFile();
+	bool RefreshGrowingFile();
+	int ReachEndOfFile();
 
 	int ReadOneRawData(IscImageInfo* isc_image_info);
 	int ReadColorRawData(IscImageInfo* isc_image_info);
@@ -122,6 +236,19 @@ private:
 	int ReadDoubleShutterColorRawData(IscImageInfo* isc_image_info);
 
 	int MoveToSpecifyFrameNumber(const __int64 specify_frame_number);
+	void ResetPlayPacing();
+	void WaitPlayPacing(const IscImageInfo* isc_image_info, const LARGE_INTEGER* read_start_counter);
+	__int64 GetRequiredRecordCount(const IscGrabColorMode isc_grab_color_mode) const;
+	int StartPlayPrefetch();
+	void StopPlayPrefetch();
+	void RequestPlayPrefetch(const __int64 frame_number);
+	bool IsPlayPrefetchMoved(const __int64 frame_number);
+	int PrefetchOneFrame(const __int64 frame_number, __int64* next_frame_number);
+	int PlayPrefetchProc();
+	static unsigned __stdcall PlayPrefetchThread(void* context);
+
+	int GetFileInformationFromIndex(const wchar_t* play_file_name, const IscRawFileHeader* raw_file_header, const unsigned __int64 file_size, HANDLE handle_file,
+									IscPlayFileInformation* play_file_information);
 
 
 };
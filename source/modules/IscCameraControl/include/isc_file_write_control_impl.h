@@ -62,6 +62,41 @@ public:
 	*/
 	int QueryThreadStatus(bool* is_running);
 
+	/** @brief set the placement applied to the write thread.
+		@return none.
+	*/
+	void SetThreadPlacement(IscThreadPlacement* isc_thread_placement);
+
+	/** @brief set the parameter of the compression. it is applied at the start of writing.
+		@return 0, if successful.
+	*/
+	int SetCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter);
+
+	/** @brief get the parameter of the compression.
+		@return 0, if successful.
+	*/
+	int GetCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter);
+
+	/** @brief get the result of the compression since the start of writing.
+		@return 0, if successful.
+	*/
+	int GetCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics);
+
+	/** @brief set the parameter of the writing. it is applied at the start of writing.
+		@return 0, if successful.
+	*/
+	int SetWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter);
+
+	/** @brief get the parameter of the writing.
+		@return 0, if successful.
+	*/
+	int GetWriteParameter(IscRecordWriteParameter* isc_record_write_parameter);
+
+	/** @brief get the result of the writing since the start of writing.
+		@return 0, if successful.
+	*/
+	int GetWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics);
+
 private:
 
 	IscCameraControlConfiguration isc_camera_control_config_;
@@ -75,6 +110,35 @@ private:
 
 	UtilityMeasureTime* utility_measure_time_;
 
+	IscRawFileIndex* raw_file_index_;
+
+	// compression
+	IscRecordCompressionParameter record_compression_parameter_;
+	IscRawDataCodec* raw_data_codec_;
+	unsigned char* compressed_buffer_;
+	int compressed_buffer_size_;
+
+	struct CompressionStatistics {
+		__int64 data_count;
+		__int64 uncompressed_count;
+		__int64 raw_bytes;
+		__int64 written_bytes;
+		double total_time_msec;
+	};
+	CompressionStatistics compression_statistics_;
+
+	// writer
+	IscRecordWriteParameter record_write_parameter_;
+	IscAsyncFileWriter* async_file_writer_;
+
+	struct WriteStatistics {
+		__int64 frame_count;
+		__int64 dropped_frame_count;
+		int queue_depth;
+		int max_queue_depth;
+	};
+	WriteStatistics write_statistics_;
+
 	struct FileWriteSpeedInformation {
 		ULONGLONG start_time;
 
@@ -131,34 +195,40 @@ private:
 
 		__int64 minimum_capacity_required;				/**< 最小ディスク空き容量 */
 
+		IscRecordStripingMode striping_mode;			/**< 保存先への分散方法 */
+		bool is_striped;								/**< 現在のファイルを分散しているか */
+
 		__int64 start_time_of_current_file_msec;		/**< 現在のファイルの保存開始時間 msec(=GetTickCount) */
 		int save_time_for_one_file_sec;					/**< 保存ファイルの1個あたりの時間 (秒) */ 
 
 		__int64 previous_time_free_space_monitoring;	/**< 空き容量の監視　前回の時間 msec(=GetTickCount) */
 		int free_space_monitoring_cycle_sec;			/**< 空き容量の監視周期 (秒) */
 
-		HANDLE handle_file;
 		bool is_file_ready;
 
 		unsigned int frame_index;
 		IscRawFileHeader raw_file_hedaer;
 
+		__int64 write_offset;							/**< 現在のファイルの書き込み位置 (インデックス用) */
+
 		int minimum_write_interval_time;				/**< 書き込みの最小空き時間 (msec) */
 		__int64 previous_write_interval_time_tick;		/**< 書き込みの最小空き時間の監視　前回の時間 msec(=GetTickCount) */
 
 	};
 	FileWriteInformation file_write_information_;
 
-	HRESULT EnablePrivilege(const wchar_t* privilege_name, const BOOL enabled);
 	int PrepareFileforWriting(FileWriteInformation* file_write_information);
+	void OpenFileIndex(FileWriteInformation* file_write_information);
+	void AddFileIndexEntry(FileWriteInformation* file_write_information, const IscRawDataHeader* isc_raw_data_header);
+	void CompressRawData(const unsigned char* image, const int width, const int height, const unsigned char** write_data, int* write_size, int* compressed);
 	int CreateWriteFile(FileWriteInformation* file_write_information);
 
 	int PrepareNewFileforWriting(FileWriteInformation* file_write_information);
 	int CreateNewWriteFile(FileWriteInformation* file_write_information);
 
-	int WriteDataToFile(HANDLE handle_file, LPCVOID buffer, __int64 number_of_write_to_file, __int64* number_of_byteswritten, LPOVERLAPPED overlapped);
-
 	int CheckFreeSpace(FileWriteInformation* file_write_information);
+	int OpenWriteFile(FileWriteInformation* file_write_information);
+	int UpdateStripeWeight(FileWriteInformation* file_write_information);
 		
 	// Thread Control
 	struct ThreadControl {
@@ -173,6 +243,8 @@ private:
 	HANDLE thread_handle_;
 	CRITICAL_SECTION	threads_critical_;
 
+	IscThreadPlacement* isc_thread_placement_;
+
 	static unsigned __stdcall ControlThread(void* context);
 	int WriteDataProc(IscFileWriteControlImpl* isc_file_write_Control);
 
@@ -0,0 +1,103 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_raw_data_codec.h
+ * @brief lossless compression of raw data
+ */
+
+#pragma once
+
+class IscBandWorker;
+
+/**
+ * @class   IscRawDataCodec
+ * @brief   codec class
+ * this class compresses and decompresses the raw data without loss
+ */
+class IscRawDataCodec
+{
+public:
+	IscRawDataCodec();
+	~IscRawDataCodec();
+
+	/** @brief initialize the codec. the data is divided into stripes of rows, and each stripe is processed by one thread.
+		@return 0, if successful.
+	*/
+	int Initialize(const int thread_count, const int max_width, const int max_height);
+
+	/** @brief shut down the codec.
+		@return 0, if successful.
+	*/
+	int Terminate();
+
+	/** @brief get the threads for placement.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
+	/** @brief get the maximum size of the compressed data.
+		@return size in bytes.
+	*/
+	static int GetMaxCompressedSize(const int width, const int height);
+
+	/** @brief compress the data. compressed_size is 0 if the compressed data is not smaller than the source.
+		@return 0, if successful.
+	*/
+	int Compress(const unsigned char* src, const int width, const int height, unsigned char* dst, const int dst_capacity, int* compressed_size);
+
+	/** @brief decompress the data.
+		@return 0, if successful.
+	*/
+	int Decompress(const unsigned char* src, const int src_size, unsigned char* dst, const int dst_capacity, int* decompressed_size);
+
+private:
+
+	static constexpr int kMaxStripeCount = kISC_RECORD_COMPRESSION_MAX_THREAD_COUNT;
+
+	struct CompressedDataHeader {
+		int method;								/**< 1:MED prediction + rANS */
+		int width;								/**< width (bytes) */
+		int height;								/**< height */
+		int stripe_count;						/**< number of stripes */
+		int rows_per_stripe;					/**< number of rows in a stripe */
+		int stripe_size[kMaxStripeCount];		/**< compressed size of each stripe */
+	};
+
+	struct StripeJob {
+		bool is_compress;
+		const unsigned char* src;
+		unsigned char* dst;
+		int width;
+		int row_start, row_end;
+		int src_size;
+		int result_size;
+		int result;
+
+		unsigned char* residual;				/**< work area */
+		unsigned char* encoded;					/**< work area, the encoded data is written backward */
+		int encoded_capacity;
+	};
+
+	IscBandWorker* band_worker_;				/**< one stripe is one band */
+	int max_width_, max_height_;
+
+	StripeJob stripe_job_[kMaxStripeCount];
+
+	static void RunStripe(void* context, const int band_index);
+
+	static void CompressStripe(StripeJob* job);
+	static void DecompressStripe(StripeJob* job);
+
+};
@@ -0,0 +1,112 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_raw_file_index.h
+ * @brief index of raw data file
+ */
+
+#pragma once
+
+/**
+ * @class   IscRawFileIndex
+ * @brief   index class
+ * this class reads and writes the index of raw data file
+ */
+class IscRawFileIndex
+{
+public:
+	IscRawFileIndex();
+	~IscRawFileIndex();
+
+	// read
+
+	/** @brief load the index of the raw data file. entries beyond the raw data file are ignored.
+		@return 0, if successful.
+	*/
+	int Load(const wchar_t* raw_file_name, const unsigned __int64 raw_file_size);
+
+	/** @brief read the entries added to the index after Load(). for the raw data file being written.
+		@return 0, if successful.
+	*/
+	int Extend(const wchar_t* raw_file_name, const unsigned __int64 raw_file_size, __int64* added_count);
+
+	/** @brief drop the entries at and after the specified number.
+		@return none.
+	*/
+	void Truncate(const __int64 entry_count);
+
+	/** @brief release the loaded index.
+		@return none.
+	*/
+	void Clear();
+
+	/** @brief whether the index is loaded.
+		@return true, if loaded.
+	*/
+	bool IsValid() const;
+
+	/** @brief get the number of entries.
+		@return number of entries.
+	*/
+	__int64 GetEntryCount() const;
+
+	/** @brief get the specified entry.
+		@return 0, if successful.
+	*/
+	int GetEntry(const __int64 entry_number, IscRawFileIndexEntry* entry) const;
+
+	/** @brief find the first entry at or after the specified time.
+		@return entry number, -1 if not found.
+	*/
+	__int64 FindEntryByTime(const __int64 frame_time) const;
+
+	// write
+
+	/** @brief create the index for the raw data file being written.
+		@return 0, if successful.
+	*/
+	int Open(const wchar_t* raw_file_name);
+
+	/** @brief add an entry to the index.
+		@return 0, if successful.
+	*/
+	int Add(const IscRawFileIndexEntry* entry);
+
+	/** @brief close the index being written.
+		@return 0, if successful.
+	*/
+	int Close();
+
+	/** @brief make the name of the index file from the raw data file name.
+		@return 0, if successful.
+	*/
+	static int MakeIndexFileName(const wchar_t* raw_file_name, wchar_t* index_file_name, const int max_length);
+
+	/** @brief make the index by scanning the raw data file.
+		@return 0, if successful.
+	*/
+	static int Rebuild(const wchar_t* raw_file_name, __int64* entry_count);
+
+private:
+
+	IscRawFileIndexEntry* entry_;
+	__int64 entry_count_;
+	__int64 entry_capacity_;
+
+	HANDLE handle_index_file_;
+
+	int OpenIndexFile(const wchar_t* index_file_name);
+
+};
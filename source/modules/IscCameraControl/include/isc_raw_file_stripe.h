@@ -0,0 +1,100 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_raw_file_stripe.h
+ * @brief striped raw data file
+ */
+
+#pragma once
+
+/**
+ * @class   IscRawFileStripe
+ * @brief   stripe class
+ * this class writes the manifest of a raw data file striped over several folders, and reads it back as one file
+ */
+class IscRawFileStripe
+{
+public:
+	IscRawFileStripe();
+	~IscRawFileStripe();
+
+	// read
+
+	/** @brief open the manifest and the stripe files.
+		@return 0, if successful.
+	*/
+	int Open(const wchar_t* manifest_file_name);
+
+	/** @brief close the stripe files.
+		@return none.
+	*/
+	void Close();
+
+	/** @brief whether the stripe files are open.
+		@return true, if open.
+	*/
+	bool IsOpen() const;
+
+	/** @brief get the size of the reassembled file.
+		@return size in bytes.
+	*/
+	unsigned __int64 GetSize() const;
+
+	/** @brief move the read position. the same as SetFilePointerEx.
+		@return 0, if successful.
+	*/
+	int Seek(const __int64 distance_to_move, const DWORD move_method, __int64* new_position);
+
+	/** @brief read from the current position. the same as ReadFile.
+		@return 0, if successful.
+	*/
+	int Read(void* buffer, const DWORD number_of_bytes_to_read, DWORD* number_of_bytes_read);
+
+	// write
+
+	/** @brief write the manifest.
+		@return 0, if successful.
+	*/
+	static int WriteManifest(const wchar_t* manifest_file_name, const int stripe_count, const wchar_t stripe_file_name[][_MAX_PATH],
+								const __int64 chunk_size, const unsigned char* chunk_stripe, const __int64 chunk_count, const __int64 total_size);
+
+	/** @brief make the name of a stripe file from the manifest file name.
+		@return 0, if successful.
+	*/
+	static int MakeStripeFileName(const wchar_t* manifest_file_name, const wchar_t* stripe_folder, const int stripe_index, wchar_t* stripe_file_name, const int max_length);
+
+	/** @brief whether the file is a manifest.
+		@return true, if the file is a manifest.
+	*/
+	static bool IsManifest(const wchar_t* file_name);
+
+private:
+
+	struct ChunkLocation {
+		int stripe_index;
+		__int64 offset;				/**< offset in the stripe file */
+	};
+
+	int stripe_count_;
+	HANDLE handle_stripe_file_[kISC_SAVE_MAX_SAVE_FOLDER_COUNT];
+
+	__int64 chunk_size_;
+	__int64 chunk_count_;
+	__int64 total_size_;
+	ChunkLocation* chunk_location_;
+
+	__int64 position_;
+
+};
@@ -0,0 +1,642 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_async_file_writer.cpp
+ * @brief asynchronous writer of raw data file
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class writes the raw data file with large aligned batches and overlapped I/O.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <malloc.h>
+#include <algorithm>
+
+#include "isc_dpl_error_def.h"
+#include "isc_camera_def.h"
+
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
+
+/**
+ * constructor
+ *
+ */
+IscAsyncFileWriter::IscAsyncFileWriter():
+	batch_size_(0), request_count_(0), direct_io_(false), write_request_(), current_request_(0),
+	stripe_(), stripe_count_(0), is_striped_(false), manifest_file_name_(), chunk_stripe_(nullptr), chunk_count_(0), chunk_capacity_(0),
+	logical_size_(0), frequency_(), statistics_critical_(), statistics_()
+{
+	InitializeCriticalSection(&statistics_critical_);
+	QueryPerformanceFrequency(&frequency_);
+}
+
+/**
+ * destructor
+ *
+ */
+IscAsyncFileWriter::~IscAsyncFileWriter()
+{
+	Terminate();
+	DeleteCriticalSection(&statistics_critical_);
+}
+
+/**
+ * 書き込み用のバッファーを確保します
+ *
+ * @param[in] batch_size 1回の書き込みサイズ(byte) セクターサイズの倍数
+ * @param[in] request_count 同時に発行する書き込みの数
+ * @param[in] direct_io true:システムのキャッシュを使用しない
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscAsyncFileWriter::Initialize(const int batch_size, const int request_count, const bool direct_io)
+{
+	Terminate();
+
+	if ((batch_size <= 0) || ((batch_size % kSectorSize) != 0) ||
+		(request_count < 1) || (request_count > kISC_RECORD_WRITE_MAX_REQUEST_COUNT)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	batch_size_ = batch_size;
+	request_count_ = request_count;
+	direct_io_ = direct_io;
+
+	for (int i = 0; i < request_count_; i++) {
+		WriteRequest* write_request = &write_request_[i];
+
+		// direct I/Oのため、セクター境界に合わせる
+		write_request->buffer = (unsigned char*)_aligned_malloc(batch_size_, kSectorSize);
+		write_request->overlapped.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+		if ((write_request->buffer == nullptr) || (write_request->overlapped.hEvent == NULL)) {
+			Terminate();
+			return CAMCONTROL_E_INVALID_DEVICEHANDLE;
+		}
+		write_request->size = 0;
+		write_request->submit_size = 0;
+		write_request->stripe_index = 0;
+		write_request->pending = false;
+	}
+	current_request_ = 0;
+
+	ResetStatistics();
+
+	return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscAsyncFileWriter::Terminate()
+{
+	Close();
+
+	for (int i = 0; i < kISC_RECORD_WRITE_MAX_REQUEST_COUNT; i++) {
+		WriteRequest* write_request = &write_request_[i];
+
+		if (write_request->buffer != nullptr) {
+			_aligned_free(write_request->buffer);
+			write_request->buffer = nullptr;
+		}
+		if (write_request->overlapped.hEvent != NULL) {
+			CloseHandle(write_request->overlapped.hEvent);
+			write_request->overlapped.hEvent = NULL;
+		}
+		write_request->size = 0;
+		write_request->submit_size = 0;
+		write_request->pending = false;
+	}
+
+	delete[] chunk_stripe_;
+	chunk_stripe_ = nullptr;
+	chunk_capacity_ = 0;
+
+	batch_size_ = 0;
+	request_count_ = 0;
+	current_request_ = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * ファイルを作成し、ディスク領域を予約します
+ *
+ * @param[in] file_name ファイル名
+ * @param[in] preallocate_size 予約するサイズ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscAsyncFileWriter::Open(const wchar_t* file_name, const __int64 preallocate_size)
+{
+	if ((file_name == nullptr) || (request_count_ == 0)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	Close();
+
+	swprintf_s(stripe_[0].file_name, L"%s", file_name);
+	int ret = CreateStripeFile(&stripe_[0], preallocate_size);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	stripe_count_ = 1;
+	is_striped_ = false;
+	logical_size_ = 0;
+	current_request_ = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 保存先ごとにファイルを作成し、マニフェストを作成します
+ *
+ * @param[in] manifest_file_name マニフェストのファイル名
+ * @param[in] stripe_count 保存先の数
+ * @param[in] stripe_folder 保存先
+ * @param[in] preallocate_size 予約するサイズ(合計)
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 書き込み中のマニフェストはチャンクを含みません Close()で完成します
+ */
+int IscAsyncFileWriter::OpenStriped(const wchar_t* manifest_file_name, const int stripe_count, const wchar_t stripe_folder[][_MAX_PATH], const __int64 preallocate_size)
+{
+	if ((manifest_file_name == nullptr) || (stripe_folder == nullptr) || (request_count_ == 0) ||
+		(stripe_count < 1) || (stripe_count > kISC_SAVE_MAX_SAVE_FOLDER_COUNT)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	Close();
+
+	wchar_t stripe_file_name[kISC_SAVE_MAX_SAVE_FOLDER_COUNT][_MAX_PATH] = {};
+	for (int i = 0; i < stripe_count; i++) {
+		int ret = IscRawFileStripe::MakeStripeFileName(manifest_file_name, stripe_folder[i], i, stripe_file_name[i], _MAX_PATH);
+		if (ret != DPC_E_OK) {
+			return ret;
+		}
+	}
+
+	int ret = IscRawFileStripe::WriteManifest(manifest_file_name, stripe_count, stripe_file_name, batch_size_, nullptr, 0, 0);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	for (int i = 0; i < stripe_count; i++) {
+		swprintf_s(stripe_[i].file_name, L"%s", stripe_file_name[i]);
+		ret = CreateStripeFile(&stripe_[i], preallocate_size / stripe_count);
+		if (ret != DPC_E_OK) {
+			stripe_count_ = i;
+			Close();
+			return ret;
+		}
+		stripe_count_ = i + 1;
+	}
+
+	swprintf_s(manifest_file_name_, L"%s", manifest_file_name);
+	is_striped_ = true;
+	chunk_count_ = 0;
+	logical_size_ = 0;
+	current_request_ = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 分散の重みを設定します
+ *
+ * @param[in] stripe_index ファイルの番号
+ * @param[in] weight 重み 0:書き込まない
+ * @return none
+ */
+void IscAsyncFileWriter::SetStripeWeight(const int stripe_index, const __int64 weight)
+{
+	if ((stripe_index < 0) || (stripe_index >= stripe_count_)) {
+		return;
+	}
+
+	stripe_[stripe_index].weight = (weight > 0) ? weight : 0;
+
+	return;
+}
+
+/**
+ * データをファイルに追加します
+ *
+ * @param[in] data データ
+ * @param[in] size サイズ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note バッファーが一杯になったら書き込みを発行します 完了は待ちません
+ */
+int IscAsyncFileWriter::Write(const void* data, const __int64 size)
+{
+	if (stripe_count_ == 0) {
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	if ((data == nullptr) || (size < 0)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	const unsigned char* src = (const unsigned char*)data;
+	__int64 remaining_size = size;
+
+	while (remaining_size > 0) {
+		WriteRequest* write_request = &write_request_[current_request_];
+
+		const int free_size = batch_size_ - write_request->size;
+		const int copy_size = (remaining_size < free_size) ? (int)remaining_size : free_size;
+
+		memcpy(write_request->buffer + write_request->size, src, copy_size);
+		write_request->size += copy_size;
+		src += copy_size;
+		remaining_size -= copy_size;
+		logical_size_ += copy_size;
+
+		if (write_request->size == batch_size_) {
+			int ret = SubmitRequest(write_request);
+			if (ret != DPC_E_OK) {
+				return ret;
+			}
+
+			ret = NextRequest();
+			if (ret != DPC_E_OK) {
+				return ret;
+			}
+		}
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * 残りのデータを書き込み、ファイルを閉じます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 予約した領域はファイルの終端を設定して解放します
+ */
+int IscAsyncFileWriter::Close()
+{
+	if (stripe_count_ == 0) {
+		return DPC_E_OK;
+	}
+
+	int result = DPC_E_OK;
+
+	// 残り
+	WriteRequest* write_request = &write_request_[current_request_];
+	if (write_request->size > 0) {
+		int ret = SubmitRequest(write_request);
+		if (ret != DPC_E_OK) {
+			result = ret;
+		}
+	}
+
+	for (int i = 0; i < request_count_; i++) {
+		if (write_request_[i].pending) {
+			int ret = WaitRequest(&write_request_[i]);
+			if (ret != DPC_E_OK) {
+				result = ret;
+			}
+		}
+		write_request_[i].size = 0;
+	}
+
+	// truncate pre-allocated and padding
+	wchar_t stripe_file_name[kISC_SAVE_MAX_SAVE_FOLDER_COUNT][_MAX_PATH] = {};
+	for (int i = 0; i < stripe_count_; i++) {
+		Stripe* stripe = &stripe_[i];
+
+		FILE_END_OF_FILE_INFO file_end_of_file_info = {};
+		file_end_of_file_info.EndOfFile.QuadPart = stripe->logical_size;
+		SetFileInformationByHandle(stripe->handle_file, FileEndOfFileInfo, &file_end_of_file_info, sizeof(file_end_of_file_info));
+
+		CloseHandle(stripe->handle_file);
+		stripe->handle_file = NULL;
+
+		swprintf_s(stripe_file_name[i], L"%s", stripe->file_name);
+	}
+
+	if (is_striped_) {
+		int ret = IscRawFileStripe::WriteManifest(manifest_file_name_, stripe_count_, stripe_file_name, batch_size_, chunk_stripe_, chunk_count_, logical_size_);
+		if (ret != DPC_E_OK) {
+			result = ret;
+		}
+	}
+
+	stripe_count_ = 0;
+	is_striped_ = false;
+	chunk_count_ = 0;
+	logical_size_ = 0;
+	current_request_ = 0;
+
+	return result;
+}
+
+/**
+ * 統計をクリアします
+ *
+ * @return none
+ */
+void IscAsyncFileWriter::ResetStatistics()
+{
+	EnterCriticalSection(&statistics_critical_);
+	const int requests_in_flight = statistics_.requests_in_flight;
+	memset(&statistics_, 0, sizeof(statistics_));
+	statistics_.requests_in_flight = requests_in_flight;
+	statistics_.start_time = GetTickCount64();
+	LeaveCriticalSection(&statistics_critical_);
+
+	return;
+}
+
+/**
+ * 書き込みの統計を取得します
+ *
+ * @param[out] isc_record_write_statistics 統計
+ * @return none
+ * @note 遅延は直近kLatencySampleCount回の書き込みから求めます
+ */
+void IscAsyncFileWriter::GetStatistics(IscRecordWriteStatistics* isc_record_write_statistics)
+{
+	if (isc_record_write_statistics == nullptr) {
+		return;
+	}
+
+	double latency_sample[kLatencySampleCount] = {};
+
+	EnterCriticalSection(&statistics_critical_);
+	isc_record_write_statistics->request_count = statistics_.request_count;
+	isc_record_write_statistics->written_bytes = statistics_.written_bytes;
+	isc_record_write_statistics->stall_count = statistics_.stall_count;
+	isc_record_write_statistics->requests_in_flight = statistics_.requests_in_flight;
+	isc_record_write_statistics->max_requests_in_flight = statistics_.max_requests_in_flight;
+	isc_record_write_statistics->latency_max_msec = statistics_.latency_max_msec;
+
+	const double elapsed_time_sec = (double)(GetTickCount64() - statistics_.start_time) / 1000.0;
+	isc_record_write_statistics->stripe_count = (stripe_count_ > 0) ? stripe_count_ : 1;
+	for (int i = 0; i < kISC_SAVE_MAX_SAVE_FOLDER_COUNT; i++) {
+		isc_record_write_statistics->stripe_written_bytes[i] = statistics_.stripe_written_bytes[i];
+		isc_record_write_statistics->stripe_throughput_mb_per_sec[i] = (elapsed_time_sec > 0.0) ? ((double)statistics_.stripe_written_bytes[i] / (1024.0 * 1024.0)) / elapsed_time_sec : 0.0;
+	}
+
+	const int sample_count = statistics_.latency_sample_count;
+	memcpy(latency_sample, statistics_.latency_sample, sizeof(double) * sample_count);
+	LeaveCriticalSection(&statistics_critical_);
+
+	isc_record_write_statistics->latency_p50_msec = 0;
+	isc_record_write_statistics->latency_p90_msec = 0;
+	isc_record_write_statistics->latency_p99_msec = 0;
+
+	if (sample_count > 0) {
+		std::sort(latency_sample, latency_sample + sample_count);
+
+		isc_record_write_statistics->latency_p50_msec = latency_sample[((sample_count - 1) * 50) / 100];
+		isc_record_write_statistics->latency_p90_msec = latency_sample[((sample_count - 1) * 90) / 100];
+		isc_record_write_statistics->latency_p99_msec = latency_sample[((sample_count - 1) * 99) / 100];
+	}
+
+	return;
+}
+
+/**
+ * ファイルを作成し、ディスク領域を予約します
+ *
+ * @param[in] stripe 作成するファイル
+ * @param[in] preallocate_size 予約するサイズ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 予約はファイルの終端を変更しないため、最初の書き込みで0埋めは発生しません
+ */
+int IscAsyncFileWriter::CreateStripeFile(Stripe* stripe, const __int64 preallocate_size)
+{
+	DWORD flags_and_attributes = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED;
+	if (direct_io_) {
+		flags_and_attributes |= FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH;
+	}
+	else {
+		flags_and_attributes |= FILE_FLAG_SEQUENTIAL_SCAN;
+	}
+
+	stripe->handle_file = CreateFile(stripe->file_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, flags_and_attributes, NULL);
+	if (stripe->handle_file == INVALID_HANDLE_VALUE) {
+		stripe->handle_file = NULL;
+		return CAMCONTROL_E_CREATE_SAVE_FILE;
+	}
+
+	// pre allocate (特権は不要です 失敗しても書き込みは可能です)
+	if (preallocate_size > 0) {
+		FILE_ALLOCATION_INFO file_allocation_info = {};
+		file_allocation_info.AllocationSize.QuadPart = preallocate_size;
+		SetFileInformationByHandle(stripe->handle_file, FileAllocationInfo, &file_allocation_info, sizeof(file_allocation_info));
+	}
+
+	stripe->file_offset = 0;
+	stripe->logical_size = 0;
+	stripe->weight = 1;
+	stripe->current_weight = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 次の書き込み先を選択します
+ *
+ * @retval >=0 ファイルの番号
+ * @retval -1 書き込めるファイルが無い
+ * @note 重み付きラウンドロビン 重みが等しい場合は順番になります
+ */
+int IscAsyncFileWriter::SelectStripe()
+{
+	if (!is_striped_) {
+		return (stripe_count_ > 0) ? 0 : -1;
+	}
+
+	__int64 total_weight = 0;
+	int selected_index = -1;
+	for (int i = 0; i < stripe_count_; i++) {
+		Stripe* stripe = &stripe_[i];
+		if (stripe->weight == 0) {
+			continue;
+		}
+
+		stripe->current_weight += stripe->weight;
+		total_weight += stripe->weight;
+
+		if ((selected_index < 0) || (stripe->current_weight > stripe_[selected_index].current_weight)) {
+			selected_index = i;
+		}
+	}
+
+	if (selected_index >= 0) {
+		stripe_[selected_index].current_weight -= total_weight;
+	}
+
+	return selected_index;
+}
+
+/**
+ * バッファーの書き込みを発行します
+ *
+ * @param[in] write_request 書き込み要求
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note direct I/Oの場合、サイズをセクター境界まで0で埋めます 余分な部分はClose()で切り詰めます
+ */
+int IscAsyncFileWriter::SubmitRequest(WriteRequest* write_request)
+{
+	int submit_size = write_request->size;
+	if (direct_io_ && ((submit_size % kSectorSize) != 0)) {
+		const int padded_size = ((submit_size + kSectorSize - 1) / kSectorSize) * kSectorSize;
+		memset(write_request->buffer + submit_size, 0, padded_size - submit_size);
+		submit_size = padded_size;
+	}
+
+	const int stripe_index = SelectStripe();
+	if (stripe_index < 0) {
+		return CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE;
+	}
+	Stripe* stripe = &stripe_[stripe_index];
+
+	if (is_striped_) {
+		if (chunk_count_ >= chunk_capacity_) {
+			// 1チャンク1byteのため、小さい
+			const __int64 new_capacity = (chunk_capacity_ > 0) ? chunk_capacity_ * 2 : 4096;
+			unsigned char* new_chunk_stripe = new unsigned char[(size_t)new_capacity];
+			if (chunk_count_ > 0) {
+				memcpy(new_chunk_stripe, chunk_stripe_, (size_t)chunk_count_);
+			}
+			delete[] chunk_stripe_;
+			chunk_stripe_ = new_chunk_stripe;
+			chunk_capacity_ = new_capacity;
+		}
+	}
+
+	HANDLE handle_event = write_request->overlapped.hEvent;
+	memset(&write_request->overlapped, 0, sizeof(OVERLAPPED));
+	write_request->overlapped.hEvent = handle_event;
+	ResetEvent(handle_event);
+
+	ULARGE_INTEGER ul_int = {};
+	ul_int.QuadPart = (ULONGLONG)stripe->file_offset;
+	write_request->overlapped.Offset = ul_int.LowPart;
+	write_request->overlapped.OffsetHigh = ul_int.HighPart;
+
+	QueryPerformanceCounter(&write_request->submit_time);
+
+	BOOL ret = WriteFile(stripe->handle_file, write_request->buffer, (DWORD)submit_size, NULL, &write_request->overlapped);
+	if (!ret && (GetLastError() != ERROR_IO_PENDING)) {
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	write_request->submit_size = submit_size;
+	write_request->stripe_index = stripe_index;
+	write_request->pending = true;
+	stripe->file_offset += submit_size;
+	stripe->logical_size += write_request->size;
+
+	if (is_striped_) {
+		chunk_stripe_[chunk_count_] = (unsigned char)stripe_index;
+		chunk_count_++;
+	}
+
+	EnterCriticalSection(&statistics_critical_);
+	statistics_.request_count++;
+	statistics_.requests_in_flight++;
+	if (statistics_.requests_in_flight > statistics_.max_requests_in_flight) {
+		statistics_.max_requests_in_flight = statistics_.requests_in_flight;
+	}
+	LeaveCriticalSection(&statistics_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 書き込みの完了を待ちます
+ *
+ * @param[in] write_request 書き込み要求
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscAsyncFileWriter::WaitRequest(WriteRequest* write_request)
+{
+	DWORD number_of_written = 0;
+	BOOL ret = GetOverlappedResult(stripe_[write_request->stripe_index].handle_file, &write_request->overlapped, &number_of_written, TRUE);
+
+	LARGE_INTEGER end_time = {};
+	QueryPerformanceCounter(&end_time);
+	const double latency_msec = (double)(end_time.QuadPart - write_request->submit_time.QuadPart) * 1000.0 / (double)frequency_.QuadPart;
+
+	write_request->pending = false;
+	write_request->size = 0;
+
+	EnterCriticalSection(&statistics_critical_);
+	statistics_.requests_in_flight--;
+	if (ret && (number_of_written == (DWORD)write_request->submit_size)) {
+		statistics_.written_bytes += number_of_written;
+		statistics_.stripe_written_bytes[write_request->stripe_index] += number_of_written;
+	}
+	if (latency_msec > statistics_.latency_max_msec) {
+		statistics_.latency_max_msec = latency_msec;
+	}
+	statistics_.latency_sample[statistics_.latency_sample_index] = latency_msec;
+	statistics_.latency_sample_index = (statistics_.latency_sample_index + 1) % kLatencySampleCount;
+	if (statistics_.latency_sample_count < kLatencySampleCount) {
+		statistics_.latency_sample_count++;
+	}
+	LeaveCriticalSection(&statistics_critical_);
+
+	if (!ret || (number_of_written != (DWORD)write_request->submit_size)) {
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * 次のバッファーに切り替えます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次のバッファーが書き込み中の場合は、完了を待ちます
+ */
+int IscAsyncFileWriter::NextRequest()
+{
+	current_request_ = (current_request_ + 1) % request_count_;
+
+	WriteRequest* write_request = &write_request_[current_request_];
+	if (write_request->pending) {
+		EnterCriticalSection(&statistics_critical_);
+		statistics_.stall_count++;
+		LeaveCriticalSection(&statistics_critical_);
+
+		int ret = WaitRequest(write_request);
+		if (ret != DPC_E_OK) {
+			return ret;
+		}
+	}
+
+	return DPC_E_OK;
+}
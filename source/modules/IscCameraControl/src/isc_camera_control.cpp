@@ -28,6 +28,7 @@
 #include <time.h>
 #include <stdint.h>
 #include <process.h>
+#include <Shlwapi.h>
 #include <mutex>
 #include <functional>
 
@@ -35,14 +36,20 @@
 #include "isc_camera_def.h"
 #include "isc_log.h"
 #include "utility.h"
+#include "isc_thread_placement.h"
 
 #include "vm_sdk_wrapper.h"
 #include "xc_sdk_wrapper.h"
 #include "k4a_sdk_wrapper.h"
 #include "isc_sdk_control.h"
 #include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
 #include "isc_file_write_control_impl.h"
 #include "isc_raw_data_decoder.h"
+#include "isc_decoded_frame_cache.h"
 #include "isc_file_read_control_impl.h"
 #include "isc_selftcalibration_interface.h"
 
@@ -137,7 +144,8 @@ IscCameraControl::IscCameraControl() :
 	thread_control_(), 
 	handle_semaphore_(NULL), 
 	thread_handle_(NULL), 
-	threads_critical_()
+	threads_critical_(),
+	isc_thread_placement_(nullptr)
 {
 
 	measure_tackt_time_ = new UtilityMeasureTime;
@@ -187,11 +195,17 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 
 	isc_camera_control_config_.minimum_write_interval_time = isc_camera_control_configuration->minimum_write_interval_time;
 
+	isc_camera_control_config_.isc_thread_configuration = isc_camera_control_configuration->isc_thread_configuration;
+
 	measure_tackt_time_->Init();
 
 	// log
 	isc_log_ = isc_log;
 
+	// thread placement
+	isc_thread_placement_ = new IscThreadPlacement;
+	isc_thread_placement_->Initialize(&isc_camera_control_config_.isc_thread_configuration);
+
 	if (isc_camera_control_config_.enabled_camera) {
 		// it use camera 
 		isc_sdk_control_ = new IscSdkControl;
@@ -243,10 +257,28 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 			return ret;
 		}
 
+		// 保存先は';'で区切って複数指定できます (複数の場合は分散して書き込みます)
 		IscSaveDataConfiguration save_data_configration = {};
-		save_data_configration.max_save_folder_count = 1;
-		save_data_configration.save_folder_count = 1;
-		swprintf_s(save_data_configration.save_folders[0], L"%s", isc_camera_control_configuration->save_image_path);
+		save_data_configration.max_save_folder_count = kISC_SAVE_MAX_SAVE_FOLDER_COUNT;
+		save_data_configration.save_folder_count = 0;
+
+		wchar_t save_image_path[_MAX_PATH] = {};
+		swprintf_s(save_image_path, L"%s", isc_camera_control_configuration->save_image_path);
+
+		wchar_t* next_token = nullptr;
+		wchar_t* token = wcstok_s(save_image_path, L";", &next_token);
+		while ((token != nullptr) && (save_data_configration.save_folder_count < kISC_SAVE_MAX_SAVE_FOLDER_COUNT)) {
+			PathRemoveBlanks(token);
+			if (token[0] != L'\0') {
+				swprintf_s(save_data_configration.save_folders[save_data_configration.save_folder_count], L"%s", token);
+				save_data_configration.save_folder_count++;
+			}
+			token = wcstok_s(nullptr, L";", &next_token);
+		}
+		if (save_data_configration.save_folder_count == 0) {
+			save_data_configration.save_folder_count = 1;
+			swprintf_s(save_data_configration.save_folders[0], L"%s", isc_camera_control_configuration->save_image_path);
+		}
 		save_data_configration.minimum_capacity_required = 20;	// 20GB
 		save_data_configration.save_time_for_one_file = 60;		// 60分
 		save_data_configration.max_buffer_count = max_buffer_count;
@@ -257,10 +289,12 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 		if (ret != DPC_E_OK) {
 			return ret;
 		}
+		isc_file_write_control_impl_->SetThreadPlacement(isc_thread_placement_);
 
 		// reader
 		isc_file_read_control_impl_ = new IscFileReadControlImpl;
 		isc_file_read_control_impl_->Initialize(isc_camera_control_configuration);
+		isc_file_read_control_impl_->SetThreadPlacement(isc_thread_placement_);
 
 		// selft calibration
 		callback_iscsdkcontrol_control_.SetSdkControl(isc_sdk_control_);
@@ -269,6 +303,13 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 		isc_selfcalibration_interface_->Initialize(isc_camera_control_configuration, width, height);
 		isc_selfcalibration_interface_->SetCallbackFunc(CallbackGetCameraRegData, CallbackSetCameraRegData);
 
+		HANDLE selfcalibration_thread_handle[kISC_THREAD_PLACEMENT_MAX_COUNT] = {};
+		int selfcalibration_thread_count = 0;
+		isc_selfcalibration_interface_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT, selfcalibration_thread_handle, &selfcalibration_thread_count);
+		for (int i = 0; i < selfcalibration_thread_count; i++) {
+			isc_thread_placement_->Apply(IscThreadRole::kSelfCalibration, i, selfcalibration_thread_handle[i]);
+		}
+
 		// Get Buffer
 		isc_image_info_ring_buffer_ = new IscImageInfoRingBuffer;
 		isc_image_info_ring_buffer_->Initialize(true, true, max_buffer_count, width, height);
@@ -280,9 +321,7 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 		thread_control_.end_code = 0;
 		thread_control_.stop_request = false;
 
-		char semaphoreName[64] = {};
-		sprintf_s(semaphoreName, "THREAD_SEMAPHORENAME_ISCCAMERACONT_%d", 0);
-		handle_semaphore_ = CreateSemaphoreA(NULL, 0, 1, semaphoreName);
+		handle_semaphore_ = CreateSemaphoreA(NULL, 0, 1, NULL);
 		if (handle_semaphore_ == NULL) {
 			// Fail
 			return CAMCONTROL_E_INVALID_DEVICEHANDLE;
@@ -301,6 +340,7 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 		// THREAD_PRIORITY_BELOW_NORMAL -1
 		SetThreadPriority(thread_handle_, THREAD_PRIORITY_NORMAL);
 
+		isc_thread_placement_->Apply(IscThreadRole::kCameraReceive, 0, thread_handle_);
 	}
 	else {
 		// Operation from file is possible
@@ -315,6 +355,7 @@ int IscCameraControl::Initialize(const IscCameraControlConfiguration* isc_camera
 		// reader
 		isc_file_read_control_impl_ = new IscFileReadControlImpl;
 		isc_file_read_control_impl_->Initialize(isc_camera_control_configuration);
+		isc_file_read_control_impl_->SetThreadPlacement(isc_thread_placement_);
 
 		// Specify the maximum size that corresponds
 		int width = 3840;
@@ -423,6 +464,12 @@ int IscCameraControl::Terminate()
 		}
 	}
 
+	if (isc_thread_placement_ != nullptr) {
+		isc_thread_placement_->Terminate();
+		delete isc_thread_placement_;
+		isc_thread_placement_ = nullptr;
+	}
+
 	isc_log_ = nullptr;
 
 	return DPC_E_OK;
@@ -1833,6 +1880,9 @@ int IscCameraControl::Start(const IscGrabStartMode* isc_grab_start_mode)
 		isc_run_status_.isc_grab_start_mode.isc_record_mode = isc_grab_start_mode->isc_record_mode;
 		isc_run_status_.isc_grab_start_mode.isc_play_mode = isc_grab_start_mode->isc_play_mode;
 		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.interval = isc_grab_start_mode->isc_play_mode_parameter.interval;
+		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.pacing_mode = isc_grab_start_mode->isc_play_mode_parameter.pacing_mode;
+		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.fixed_rate = isc_grab_start_mode->isc_play_mode_parameter.fixed_rate;
+		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.follow_growing_file = isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file;
 		swprintf_s(isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.play_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
 
 		ret = isc_file_read_control_impl_->Start(&isc_run_status_.isc_grab_start_mode);
@@ -1858,6 +1908,9 @@ int IscCameraControl::Start(const IscGrabStartMode* isc_grab_start_mode)
 		isc_run_status_.isc_grab_start_mode.isc_record_mode = isc_grab_start_mode->isc_record_mode;
 		isc_run_status_.isc_grab_start_mode.isc_play_mode = isc_grab_start_mode->isc_play_mode;
 		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.interval = isc_grab_start_mode->isc_play_mode_parameter.interval;
+		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.pacing_mode = isc_grab_start_mode->isc_play_mode_parameter.pacing_mode;
+		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.fixed_rate = isc_grab_start_mode->isc_play_mode_parameter.fixed_rate;
+		isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.follow_growing_file = isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file;
 		swprintf_s(isc_run_status_.isc_grab_start_mode.isc_play_mode_parameter.play_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
 
 		if (isc_run_status_.isc_grab_start_mode.isc_record_mode == IscRecordMode::kRecordOn) {
@@ -2066,6 +2119,50 @@ int IscCameraControl::SetReadFrameNumber(const __int64 frame_number)
 	return ret;
 }
 
+/**
+ * 読み込みFrameを指定時刻以降の最初のFrameとします
+ *
+ * @param[in] frame_time 指定時刻 (UTC msec)
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::SetReadFrameTime(const __int64 frame_time)
+{
+	int ret = DPC_E_OK;
+
+	ret = isc_file_read_control_impl_->SetReadFrameTime(frame_time);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * RAWデータファイルのインデックスを作成します
+ *
+ * @param[in] play_file_name RAWデータファイル名
+ * @param[out] entry_count 作成したEntryの数
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note インデックス無しで保存されたファイル用です 分散されたファイルは対象外です
+ */
+int IscCameraControl::RebuildFileIndex(const wchar_t* play_file_name, __int64* entry_count)
+{
+	if (IscRawFileStripe::IsManifest(play_file_name)) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = IscRawFileIndex::Rebuild(play_file_name, entry_count);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
 /**
  * File読み込みの状態を取得します
  *
@@ -2087,6 +2184,290 @@ int IscCameraControl::GetFileReadStatus(__int64* frame_number, IscFileReadStatus
 	return ret;
 }
 
+/**
+ * Threadに適用した配置を取得します
+ *
+ * @param[in,out] isc_thread_placement_status 配置の一覧　placement_countの後に追加します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status)
+{
+	if (isc_thread_placement_status == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_thread_placement_ == nullptr) {
+		return DPC_E_OK;
+	}
+
+	isc_thread_placement_->GetPlacement(isc_thread_placement_status);
+
+	return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮を設定します
+ *
+ * @param[in] isc_record_compression_parameter パラメータ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の保存開始時に適用します
+ */
+int IscCameraControl::SetRecordCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+	if (isc_record_compression_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_write_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_write_control_impl_->SetCompressionParameter(isc_record_compression_parameter);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * RAWデータ保存の圧縮の設定を取得します
+ *
+ * @param[out] isc_record_compression_parameter パラメータ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetRecordCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+	if (isc_record_compression_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_write_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_write_control_impl_->GetCompressionParameter(isc_record_compression_parameter);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * RAWデータ保存の圧縮の結果を取得します
+ *
+ * @param[out] isc_record_compression_statistics 圧縮の結果
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetRecordCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics)
+{
+	if (isc_record_compression_statistics == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_write_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_write_control_impl_->GetCompressionStatistics(isc_record_compression_statistics);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * RAWデータ保存の書き込みを設定します
+ *
+ * @param[in] isc_record_write_parameter パラメータ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の保存開始時に適用します
+ */
+int IscCameraControl::SetRecordWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter)
+{
+	if (isc_record_write_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_write_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_write_control_impl_->SetWriteParameter(isc_record_write_parameter);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * RAWデータ保存の書き込みの設定を取得します
+ *
+ * @param[out] isc_record_write_parameter パラメータ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetRecordWriteParameter(IscRecordWriteParameter* isc_record_write_parameter)
+{
+	if (isc_record_write_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_write_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_write_control_impl_->GetWriteParameter(isc_record_write_parameter);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * RAWデータ保存の書き込みの結果を取得します
+ *
+ * @param[out] isc_record_write_statistics 書き込みの結果
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetRecordWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics)
+{
+	if (isc_record_write_statistics == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_write_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_write_control_impl_->GetWriteStatistics(isc_record_write_statistics);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * 再生の速度制御の結果を取得します
+ *
+ * @param[out] isc_play_statistics 再生の結果
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetPlayStatistics(IscPlayStatistics* isc_play_statistics)
+{
+	if (isc_play_statistics == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_read_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_read_control_impl_->GetPlayStatistics(isc_play_statistics);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * 展開済みFrameの保持の方法を設定します
+ *
+ * @param[in] isc_play_cache_parameter 設定
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::SetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter)
+{
+	if (isc_play_cache_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_read_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_read_control_impl_->SetPlayCacheParameter(isc_play_cache_parameter);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * 展開済みFrameの保持の方法を取得します
+ *
+ * @param[out] isc_play_cache_parameter 設定
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter)
+{
+	if (isc_play_cache_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_read_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_read_control_impl_->GetPlayCacheParameter(isc_play_cache_parameter);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
+/**
+ * 展開済みFrameの保持の状態を取得します
+ *
+ * @param[out] isc_play_cache_status 状態
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscCameraControl::GetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status)
+{
+	if (isc_play_cache_status == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (isc_file_read_control_impl_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	int ret = isc_file_read_control_impl_->GetPlayCacheStatus(isc_play_cache_status);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return ret;
+}
+
 /**
  * カメラよりデータを取得します
  *
@@ -0,0 +1,569 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_decoded_frame_cache.cpp
+ * @brief cache of decoded frames for the play
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class keeps the decoded frames of the file being played, for going back and forth in the play.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "isc_dpl_error_def.h"
+#include "isc_camera_def.h"
+
+#include "isc_decoded_frame_cache.h"
+
+constexpr int kISC_DECODED_FRAME_CACHE_MAX_ENTRY_COUNT = 4096;	/**< 保持するFrameの最大数 */
+constexpr size_t kISC_DECODED_FRAME_CACHE_ALIGNMENT = 16;		/**< 各画像の先頭の境界 */
+
+/**
+ * constructor
+ *
+ */
+IscDecodedFrameCache::IscDecodedFrameCache():
+	entry_(nullptr), entry_count_(0), cache_critical_(), file_name_(), isc_get_color_mode_(IscGetModeColor::kBGR),
+	memory_budget_(0), used_size_(0), access_count_(0), hit_count_(0), miss_count_(0), prefetched_count_(0)
+{
+	InitializeCriticalSection(&cache_critical_);
+}
+
+/**
+ * destructor
+ *
+ */
+IscDecodedFrameCache::~IscDecodedFrameCache()
+{
+	Terminate();
+	DeleteCriticalSection(&cache_critical_);
+}
+
+/**
+ * Frameの管理表を確保します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDecodedFrameCache::Initialize()
+{
+	Terminate();
+
+	entry_count_ = kISC_DECODED_FRAME_CACHE_MAX_ENTRY_COUNT;
+	entry_ = new CacheEntry[entry_count_];
+	memset(entry_, 0, sizeof(CacheEntry) * entry_count_);
+
+	file_name_[0] = 0;
+	used_size_ = 0;
+	access_count_ = 0;
+
+	hit_count_ = 0;
+	miss_count_ = 0;
+	prefetched_count_ = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 全てのFrameを解放します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDecodedFrameCache::Terminate()
+{
+	Clear();
+
+	EnterCriticalSection(&cache_critical_);
+	delete[] entry_;
+	entry_ = nullptr;
+	entry_count_ = 0;
+	LeaveCriticalSection(&cache_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 使用するメモリの上限を設定します
+ *
+ * @param[in] memory_budget 上限(byte) 0:保持しない
+ * @return none
+ * @note 上限を越えるFrameは、最後に使用した時期が古いものから破棄します
+ */
+void IscDecodedFrameCache::SetMemoryBudget(const __int64 memory_budget)
+{
+	EnterCriticalSection(&cache_critical_);
+
+	memory_budget_ = (memory_budget > 0) ? memory_budget : 0;
+	while (used_size_ > memory_budget_) {
+		if (!EvictLeastRecentlyUsed()) {
+			break;
+		}
+	}
+
+	LeaveCriticalSection(&cache_critical_);
+
+	return;
+}
+
+/**
+ * 再生するファイルと展開の方法を設定します
+ *
+ * @param[in] file_name ファイル名
+ * @param[in] isc_get_color_mode Color画像の展開の方法
+ * @return none
+ * @note 前回と異なる場合は、保持しているFrameを破棄します
+ */
+void IscDecodedFrameCache::SetSource(const wchar_t* file_name, const IscGetModeColor isc_get_color_mode)
+{
+	EnterCriticalSection(&cache_critical_);
+	const bool is_changed = (wcscmp(file_name_, file_name) != 0) || (isc_get_color_mode_ != isc_get_color_mode);
+	LeaveCriticalSection(&cache_critical_);
+
+	if (is_changed) {
+		Clear();
+
+		EnterCriticalSection(&cache_critical_);
+		swprintf_s(file_name_, L"%s", file_name);
+		isc_get_color_mode_ = isc_get_color_mode;
+		LeaveCriticalSection(&cache_critical_);
+	}
+
+	return;
+}
+
+/**
+ * 全てのFrameを破棄します
+ *
+ * @return none
+ */
+void IscDecodedFrameCache::Clear()
+{
+	EnterCriticalSection(&cache_critical_);
+
+	for (int i = 0; i < entry_count_; i++) {
+		ReleaseEntry(&entry_[i]);
+	}
+	used_size_ = 0;
+	access_count_ = 0;
+
+	hit_count_ = 0;
+	miss_count_ = 0;
+	prefetched_count_ = 0;
+
+	LeaveCriticalSection(&cache_critical_);
+
+	return;
+}
+
+/**
+ * 指定のFrameを保持しているか確認します
+ *
+ * @param[in] frame_number 読み込みを開始するデータの番号
+ * @param[out] next_frame_number 読み込み後のデータの番号
+ * @retval true 保持している
+ * @retval false 無し
+ * @note 先読みの判定用です。使用した順番は更新しません
+ */
+bool IscDecodedFrameCache::Contains(const __int64 frame_number, __int64* next_frame_number)
+{
+	EnterCriticalSection(&cache_critical_);
+
+	const int index = FindEntry(frame_number);
+	if (index >= 0) {
+		*next_frame_number = entry_[index].next_frame_number;
+	}
+
+	LeaveCriticalSection(&cache_critical_);
+
+	return index >= 0;
+}
+
+/**
+ * 指定のFrameを取得します
+ *
+ * @param[in] frame_number 読み込みを開始するデータの番号
+ * @param[out] isc_image_info 取得先 (画像はisc_image_infoのバッファーへコピーします)
+ * @param[out] next_frame_number 読み込み後のデータの番号
+ * @param[out] next_read_offset 読み込み後のファイルの位置
+ * @retval true 成功
+ * @retval false 無し
+ */
+bool IscDecodedFrameCache::Get(const __int64 frame_number, IscImageInfo* isc_image_info, __int64* next_frame_number, unsigned __int64* next_read_offset)
+{
+	EnterCriticalSection(&cache_critical_);
+
+	const int index = FindEntry(frame_number);
+	if (index < 0) {
+		miss_count_++;
+		LeaveCriticalSection(&cache_critical_);
+
+		return false;
+	}
+
+	CacheEntry* entry = &entry_[index];
+	CopyImageInfo(&entry->isc_image_info, isc_image_info);
+	*next_frame_number = entry->next_frame_number;
+	*next_read_offset = entry->next_read_offset;
+
+	entry->last_access = ++access_count_;
+	hit_count_++;
+
+	LeaveCriticalSection(&cache_critical_);
+
+	return true;
+}
+
+/**
+ * Frameの複製を追加します
+ *
+ * @param[in] frame_number 読み込みを開始したデータの番号
+ * @param[in] isc_image_info 展開したFrame
+ * @param[in] next_frame_number 読み込み後のデータの番号
+ * @param[in] next_read_offset 読み込み後のファイルの位置
+ * @param[in] is_prefetched true:先読みしたFrame
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 上限を越える場合は、最後に使用した時期が古いものから破棄します
+ */
+int IscDecodedFrameCache::Put(const __int64 frame_number, const IscImageInfo* isc_image_info, const __int64 next_frame_number, const unsigned __int64 next_read_offset, const bool is_prefetched)
+{
+	const size_t size = GetImageInfoSize(isc_image_info);
+
+	EnterCriticalSection(&cache_critical_);
+
+	if ((entry_ == nullptr) || ((__int64)size > memory_budget_)) {
+		LeaveCriticalSection(&cache_critical_);
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	// already added (by the prefetch or the play)
+	if (FindEntry(frame_number) >= 0) {
+		LeaveCriticalSection(&cache_critical_);
+		return DPC_E_OK;
+	}
+
+	while (used_size_ + (__int64)size > memory_budget_) {
+		if (!EvictLeastRecentlyUsed()) {
+			break;
+		}
+	}
+
+	int index = -1;
+	for (int i = 0; i < entry_count_; i++) {
+		if (!entry_[i].is_used) {
+			index = i;
+			break;
+		}
+	}
+	if (index < 0) {
+		EvictLeastRecentlyUsed();
+		for (int i = 0; i < entry_count_; i++) {
+			if (!entry_[i].is_used) {
+				index = i;
+				break;
+			}
+		}
+	}
+	if (index < 0) {
+		LeaveCriticalSection(&cache_critical_);
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	// the images are placed in one buffer
+	CacheEntry* entry = &entry_[index];
+	entry->buffer = new unsigned char[size];
+	entry->size = size;
+
+	size_t offset = 0;
+	auto place = [&](const int width, const int height, const size_t unit_size) -> unsigned char* {
+		if ((width <= 0) || (height <= 0)) {
+			return nullptr;
+		}
+		unsigned char* image = entry->buffer + offset;
+		offset += (((size_t)width * height * unit_size) + kISC_DECODED_FRAME_CACHE_ALIGNMENT - 1) & ~(kISC_DECODED_FRAME_CACHE_ALIGNMENT - 1);
+		return image;
+	};
+
+	for (int i = 0; i < kISCIMAGEINFO_FRAMEDATA_MAX_COUNT; i++) {
+		const IscImageInfo::FrameData* src = &isc_image_info->frame_data[i];
+		IscImageInfo::FrameData* dst = &entry->isc_image_info.frame_data[i];
+
+		dst->p1.image = place(src->p1.width, src->p1.height, (src->p1.channel_count > 0) ? src->p1.channel_count : 1);
+		dst->p2.image = place(src->p2.width, src->p2.height, (src->p2.channel_count > 0) ? src->p2.channel_count : 1);
+		dst->color.image = place(src->color.width, src->color.height, (src->color.channel_count > 0) ? src->color.channel_count : 1);
+		dst->depth.image = (float*)place(src->depth.width, src->depth.height, sizeof(float));
+		dst->raw.image = place(src->raw.width, src->raw.height, (src->raw.channel_count > 0) ? src->raw.channel_count : 1);
+		dst->raw_color.image = place(src->raw_color.width, src->raw_color.height, (src->raw_color.channel_count > 0) ? src->raw_color.channel_count : 1);
+	}
+
+	CopyImageInfo(isc_image_info, &entry->isc_image_info);
+
+	entry->is_used = true;
+	entry->frame_number = frame_number;
+	entry->next_frame_number = next_frame_number;
+	entry->next_read_offset = next_read_offset;
+	entry->last_access = ++access_count_;
+
+	used_size_ += (__int64)size;
+	if (is_prefetched) {
+		prefetched_count_++;
+	}
+
+	LeaveCriticalSection(&cache_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 状態を取得します
+ *
+ * @param[out] isc_play_cache_status 状態
+ * @return none
+ */
+void IscDecodedFrameCache::GetStatus(IscPlayCacheStatus* isc_play_cache_status)
+{
+	EnterCriticalSection(&cache_critical_);
+
+	int frame_count = 0;
+	for (int i = 0; i < entry_count_; i++) {
+		if (entry_[i].is_used) {
+			frame_count++;
+		}
+	}
+
+	isc_play_cache_status->frame_count = frame_count;
+	isc_play_cache_status->used_size = used_size_;
+	isc_play_cache_status->memory_budget = memory_budget_;
+	isc_play_cache_status->hit_count = hit_count_;
+	isc_play_cache_status->miss_count = miss_count_;
+	isc_play_cache_status->prefetched_count = prefetched_count_;
+
+	LeaveCriticalSection(&cache_critical_);
+
+	return;
+}
+
+/**
+ * 指定の大きさの画像のバッファーを確保します
+ *
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[out] isc_image_info 確保先
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 各画像の大きさは、IscImageInfoRingBufferと同じです
+ */
+int IscDecodedFrameCache::AllocateImageInfo(const int width, const int height, IscImageInfo* isc_image_info)
+{
+	if ((width <= 0) || (height <= 0) || (isc_image_info == nullptr)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	memset(isc_image_info, 0, sizeof(IscImageInfo));
+
+	const size_t one_frame_size = (size_t)width * height;
+
+	for (int i = 0; i < kISCIMAGEINFO_FRAMEDATA_MAX_COUNT; i++) {
+		IscImageInfo::FrameData* frame_data = &isc_image_info->frame_data[i];
+
+		frame_data->p1.image = new unsigned char[one_frame_size];
+		frame_data->p2.image = new unsigned char[one_frame_size];
+		frame_data->color.image = new unsigned char[one_frame_size * 3];
+		frame_data->depth.image = new float[one_frame_size];
+		frame_data->raw.image = new unsigned char[one_frame_size * 2];
+		frame_data->raw_color.image = new unsigned char[one_frame_size * 2];
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * AllocateImageInfo()で確保したバッファーを解放します
+ *
+ * @param[in] isc_image_info 解放するもの
+ * @return none
+ */
+void IscDecodedFrameCache::ReleaseImageInfo(IscImageInfo* isc_image_info)
+{
+	if (isc_image_info == nullptr) {
+		return;
+	}
+
+	for (int i = 0; i < kISCIMAGEINFO_FRAMEDATA_MAX_COUNT; i++) {
+		IscImageInfo::FrameData* frame_data = &isc_image_info->frame_data[i];
+
+		delete[] frame_data->p1.image;
+		frame_data->p1.image = nullptr;
+		delete[] frame_data->p2.image;
+		frame_data->p2.image = nullptr;
+		delete[] frame_data->color.image;
+		frame_data->color.image = nullptr;
+		delete[] frame_data->depth.image;
+		frame_data->depth.image = nullptr;
+		delete[] frame_data->raw.image;
+		frame_data->raw.image = nullptr;
+		delete[] frame_data->raw_color.image;
+		frame_data->raw_color.image = nullptr;
+	}
+
+	return;
+}
+
+/**
+ * 指定のFrameの位置を探します
+ *
+ * @param[in] frame_number 読み込みを開始するデータの番号
+ * @return 位置 -1:無し
+ */
+int IscDecodedFrameCache::FindEntry(const __int64 frame_number) const
+{
+	for (int i = 0; i < entry_count_; i++) {
+		if (entry_[i].is_used && (entry_[i].frame_number == frame_number)) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Frameを解放します
+ *
+ * @param[in] entry 解放するFrame
+ * @return none
+ */
+void IscDecodedFrameCache::ReleaseEntry(CacheEntry* entry)
+{
+	if (entry->is_used) {
+		used_size_ -= (__int64)entry->size;
+	}
+
+	delete[] entry->buffer;
+	memset(entry, 0, sizeof(CacheEntry));
+
+	return;
+}
+
+/**
+ * 最後に使用した時期が最も古いFrameを破棄します
+ *
+ * @retval true 成功
+ * @retval false 破棄するものが無い
+ */
+bool IscDecodedFrameCache::EvictLeastRecentlyUsed()
+{
+	int index = -1;
+	for (int i = 0; i < entry_count_; i++) {
+		if (entry_[i].is_used && ((index < 0) || (entry_[i].last_access < entry_[index].last_access))) {
+			index = i;
+		}
+	}
+
+	if (index < 0) {
+		return false;
+	}
+
+	ReleaseEntry(&entry_[index]);
+
+	return true;
+}
+
+/**
+ * Frameの複製に必要なサイズを取得します
+ *
+ * @param[in] isc_image_info Frame
+ * @return サイズ(byte)
+ */
+size_t IscDecodedFrameCache::GetImageInfoSize(const IscImageInfo* isc_image_info)
+{
+	auto image_size = [](const int width, const int height, const size_t unit_size) -> size_t {
+		if ((width <= 0) || (height <= 0)) {
+			return 0;
+		}
+		return (((size_t)width * height * unit_size) + kISC_DECODED_FRAME_CACHE_ALIGNMENT - 1) & ~(kISC_DECODED_FRAME_CACHE_ALIGNMENT - 1);
+	};
+
+	size_t size = 0;
+	for (int i = 0; i < kISCIMAGEINFO_FRAMEDATA_MAX_COUNT; i++) {
+		const IscImageInfo::FrameData* frame_data = &isc_image_info->frame_data[i];
+
+		size += image_size(frame_data->p1.width, frame_data->p1.height, (frame_data->p1.channel_count > 0) ? frame_data->p1.channel_count : 1);
+		size += image_size(frame_data->p2.width, frame_data->p2.height, (frame_data->p2.channel_count > 0) ? frame_data->p2.channel_count : 1);
+		size += image_size(frame_data->color.width, frame_data->color.height, (frame_data->color.channel_count > 0) ? frame_data->color.channel_count : 1);
+		size += image_size(frame_data->depth.width, frame_data->depth.height, sizeof(float));
+		size += image_size(frame_data->raw.width, frame_data->raw.height, (frame_data->raw.channel_count > 0) ? frame_data->raw.channel_count : 1);
+		size += image_size(frame_data->raw_color.width, frame_data->raw_color.height, (frame_data->raw_color.channel_count > 0) ? frame_data->raw_color.channel_count : 1);
+	}
+
+	return size;
+}
+
+/**
+ * Frameを複製します
+ *
+ * @param[in] src 複製元
+ * @param[out] dst 複製先 (画像はdstのバッファーへコピーします)
+ * @return none
+ */
+void IscDecodedFrameCache::CopyImageInfo(const IscImageInfo* src, IscImageInfo* dst)
+{
+	dst->camera_specific_parameter = src->camera_specific_parameter;
+	dst->grab = src->grab;
+	dst->color_grab_mode = src->color_grab_mode;
+	dst->shutter_mode = src->shutter_mode;
+
+	auto copy_image = [](const IscImageInfo::ImageType* src_image, IscImageInfo::ImageType* dst_image) {
+		dst_image->width = src_image->width;
+		dst_image->height = src_image->height;
+		dst_image->channel_count = src_image->channel_count;
+
+		if ((src_image->width > 0) && (src_image->height > 0) && (src_image->image != nullptr) && (dst_image->image != nullptr)) {
+			const size_t channel_count = (src_image->channel_count > 0) ? src_image->channel_count : 1;
+			memcpy(dst_image->image, src_image->image, (size_t)src_image->width * src_image->height * channel_count);
+		}
+	};
+
+	for (int i = 0; i < kISCIMAGEINFO_FRAMEDATA_MAX_COUNT; i++) {
+		const IscImageInfo::FrameData* src_frame_data = &src->frame_data[i];
+		IscImageInfo::FrameData* dst_frame_data = &dst->frame_data[i];
+
+		dst_frame_data->camera_status = src_frame_data->camera_status;
+		dst_frame_data->frame_time = src_frame_data->frame_time;
+		dst_frame_data->data_index = src_frame_data->data_index;
+		dst_frame_data->frameNo = src_frame_data->frameNo;
+		dst_frame_data->gain = src_frame_data->gain;
+		dst_frame_data->exposure = src_frame_data->exposure;
+
+		copy_image(&src_frame_data->p1, &dst_frame_data->p1);
+		copy_image(&src_frame_data->p2, &dst_frame_data->p2);
+		copy_image(&src_frame_data->color, &dst_frame_data->color);
+		copy_image(&src_frame_data->raw, &dst_frame_data->raw);
+		copy_image(&src_frame_data->raw_color, &dst_frame_data->raw_color);
+
+		dst_frame_data->depth.width = src_frame_data->depth.width;
+		dst_frame_data->depth.height = src_frame_data->depth.height;
+		if ((src_frame_data->depth.width > 0) && (src_frame_data->depth.height > 0) && (src_frame_data->depth.image != nullptr) && (dst_frame_data->depth.image != nullptr)) {
+			memcpy(dst_frame_data->depth.image, src_frame_data->depth.image, (size_t)src_frame_data->depth.width * src_frame_data->depth.height * sizeof(float));
+		}
+	}
+
+	return;
+}
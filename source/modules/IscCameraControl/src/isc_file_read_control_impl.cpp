@@ -34,23 +34,43 @@
 
 #include "isc_dpl_error_def.h"
 #include "isc_camera_def.h"
+#include "isc_thread_placement.h"
 #include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
 #include "vm_sdk_wrapper.h"
 #include "xc_sdk_wrapper.h"
 #include "k4a_sdk_wrapper.h"
 #include "isc_raw_data_decoder.h"
+#include "isc_decoded_frame_cache.h"
 
 #include "isc_file_read_control_impl.h"
 
+constexpr int kISC_PLAY_PREFETCH_FRAME_COUNT = 8;		/**< 先読みするデータの数 */
+constexpr int kISC_PLAY_DECOMPRESSION_THREAD_COUNT = 4;	/**< 圧縮データの展開に使用するthread数 */
+constexpr ULONGLONG kISC_PLAY_FOLLOW_CHECK_INTERVAL_MSEC = 100;	/**< 記録中のファイルの追記を確認する間隔 */
+constexpr int kISC_PLAY_CACHE_DEFAULT_MEMORY_BUDGET_MB = 1024;	/**< 展開済みFrameの保持に使用するメモリ (MB) */
+constexpr int kISC_PLAY_CACHE_DEFAULT_PREFETCH_COUNT = 30;		/**< 前後に先読みするFrameの数 */
 
 /**
  * constructor
  *
  */
 IscFileReadControlImpl::IscFileReadControlImpl():
-	isc_camera_control_config_(), isc_grab_start_mode_(), file_read_information_(), raw_read_data_(), raw_data_decoder_(nullptr)
+	isc_camera_control_config_(), isc_grab_start_mode_(), file_read_information_(), raw_read_data_(), raw_data_decoder_(nullptr), raw_file_index_(nullptr), raw_data_codec_(nullptr), raw_file_stripe_(nullptr),
+	play_pacing_(), play_pacing_critical_(), play_cache_parameter_(), decoded_frame_cache_(nullptr), is_cache_enabled_(false),
+	play_prefetch_(), play_prefetch_critical_(), isc_thread_placement_(nullptr)
 {
-
+	InitializeCriticalSection(&play_pacing_critical_);
+	InitializeCriticalSection(&play_prefetch_critical_);
+	QueryPerformanceFrequency(&play_pacing_.frequency);
+
+	play_cache_parameter_.enabled = false;
+	play_cache_parameter_.memory_budget_mb = kISC_PLAY_CACHE_DEFAULT_MEMORY_BUDGET_MB;
+	play_cache_parameter_.prefetch_ahead_count = kISC_PLAY_CACHE_DEFAULT_PREFETCH_COUNT;
+	play_cache_parameter_.prefetch_behind_count = kISC_PLAY_CACHE_DEFAULT_PREFETCH_COUNT;
 }
 
 /**
@@ -59,7 +79,8 @@ IscFileReadControlImpl::IscFileReadControlImpl():
  */
 IscFileReadControlImpl::~IscFileReadControlImpl()
 {
-
+	DeleteCriticalSection(&play_prefetch_critical_);
+	DeleteCriticalSection(&play_pacing_critical_);
 }
 
 /**
@@ -87,6 +108,17 @@ int IscFileReadControlImpl::Initialize(const IscCameraControlConfiguration* isc_
 	raw_data_decoder_ = new RawDataDecoder;
 	raw_data_decoder_->Initialize();
 
+	raw_file_index_ = new IscRawFileIndex;
+
+	raw_data_codec_ = new IscRawDataCodec;
+	raw_data_codec_->Initialize(kISC_PLAY_DECOMPRESSION_THREAD_COUNT, 0, 0);
+
+	raw_file_stripe_ = new IscRawFileStripe;
+
+	decoded_frame_cache_ = new IscDecodedFrameCache;
+	decoded_frame_cache_->Initialize();
+	is_cache_enabled_ = false;
+
 	file_read_information_.file_read_status = IscFileReadStatus::kNotReady;
 
 	return DPC_E_OK;
@@ -103,12 +135,39 @@ int IscFileReadControlImpl::Terminate()
 
 	file_read_information_.file_read_status = IscFileReadStatus::kNotReady;
 
+	StopPlayPrefetch();
+
+	if (decoded_frame_cache_ != nullptr) {
+		decoded_frame_cache_->Terminate();
+		delete decoded_frame_cache_;
+		decoded_frame_cache_ = nullptr;
+	}
+	is_cache_enabled_ = false;
+
 	if (raw_data_decoder_ != nullptr) {
 		raw_data_decoder_->Terminate();
 		delete raw_data_decoder_;
 		raw_data_decoder_ = nullptr;
 	}
 
+	if (raw_file_index_ != nullptr) {
+		raw_file_index_->Clear();
+		delete raw_file_index_;
+		raw_file_index_ = nullptr;
+	}
+
+	if (raw_data_codec_ != nullptr) {
+		raw_data_codec_->Terminate();
+		delete raw_data_codec_;
+		raw_data_codec_ = nullptr;
+	}
+
+	if (raw_file_stripe_ != nullptr) {
+		raw_file_stripe_->Close();
+		delete raw_file_stripe_;
+		raw_file_stripe_ = nullptr;
+	}
+
 	return DPC_E_OK;
 }
 
@@ -126,7 +185,7 @@ bool IscFileReadControlImpl::GetDatFileSize(TCHAR* file_name, unsigned __int64*
 
 	if ((handle_file = CreateFile(	file_name,
 									GENERIC_READ,
-									FILE_SHARE_READ,
+									FILE_SHARE_READ | FILE_SHARE_WRITE,
 									NULL,
 									OPEN_EXISTING,
 									FILE_ATTRIBUTE_NORMAL,
@@ -162,915 +221,2196 @@ bool IscFileReadControlImpl::GetDatFileSize(TCHAR* file_name, unsigned __int64*
 }
 
 /**
- * ファイルからの読み込みを開始します
+ * 読み込みファイルの現在の位置から読み込みます
  *
- * @param[in] isc_grab_start_mode 読み込みのモードを指定する
- * 
- * @retval 0 成功
- * @retval other 失敗
+ * @param[out] buffer 読み込み先
+ * @param[in] number_of_bytes_to_read 読み込むサイズ
+ * @param[out] number_of_bytes_read 読み込んだサイズ
+ * @retval TRUE 成功
+ * @retval FALSE 失敗
+ * @note 分散されたファイルの場合は、各保存先のファイルから読み込みます
  */
-int IscFileReadControlImpl::Start(const IscGrabStartMode* isc_grab_start_mode)
+BOOL IscFileReadControlImpl::ReadFromFile(LPVOID buffer, DWORD number_of_bytes_to_read, LPDWORD number_of_bytes_read)
 {
-
-	file_read_information_.is_file_ready = false;
-
-	if (isc_grab_start_mode->isc_play_mode == IscPlayMode::kPlayOff) {
-		// error
-		return CAMCONTROL_E_INVALID_REQUEST;
+	if (file_read_information_.is_striped) {
+		return (raw_file_stripe_->Read(buffer, number_of_bytes_to_read, number_of_bytes_read) == DPC_E_OK) ? TRUE : FALSE;
 	}
 
-	if (isc_grab_start_mode->isc_play_mode_parameter.play_file_name[0] == 0) {
-		// error
-		return CAMCONTROL_E_INVALID_PARAMETER;
-	}
+	return ReadFile(file_read_information_.handle_file, buffer, number_of_bytes_to_read, number_of_bytes_read, NULL);
+}
 
-	if (::PathFileExists(isc_grab_start_mode->isc_play_mode_parameter.play_file_name) &&
-		!::PathIsDirectory(isc_grab_start_mode->isc_play_mode_parameter.play_file_name)) {
-		// 指定されたパスにファイルが存在、かつディレクトリでない -> OK
-	}
-	else {
-		// NG
-		return CAMCONTROL_E_INVALID_PARAMETER;
+/**
+ * 読み込みファイルの位置を移動します
+ *
+ * @param[in] distance_to_move 移動量
+ * @param[out] new_file_pointer 移動後の位置 (nullptr:取得しない)
+ * @param[in] move_method FILE_BEGIN/FILE_CURRENT/FILE_END
+ * @retval TRUE 成功
+ * @retval FALSE 失敗
+ */
+BOOL IscFileReadControlImpl::SeekReadFile(LARGE_INTEGER distance_to_move, PLARGE_INTEGER new_file_pointer, DWORD move_method)
+{
+	if (file_read_information_.is_striped) {
+		__int64 new_position = 0;
+		if (raw_file_stripe_->Seek(distance_to_move.QuadPart, move_method, &new_position) != DPC_E_OK) {
+			return FALSE;
+		}
+		if (new_file_pointer != nullptr) {
+			new_file_pointer->QuadPart = new_position;
+		}
+		return TRUE;
 	}
 
-	isc_grab_start_mode_.isc_grab_mode = isc_grab_start_mode->isc_grab_mode;
-	isc_grab_start_mode_.isc_grab_color_mode = isc_grab_start_mode->isc_grab_color_mode;
+	return SetFilePointerEx(file_read_information_.handle_file, distance_to_move, new_file_pointer, move_method);
+}
 
-	isc_grab_start_mode_.isc_get_mode.wait_time = isc_grab_start_mode->isc_get_mode.wait_time;
-	isc_grab_start_mode_.isc_get_raw_mode = isc_grab_start_mode->isc_get_raw_mode;
-	isc_grab_start_mode_.isc_get_color_mode = isc_grab_start_mode->isc_get_color_mode;
+/**
+ * 読み込みファイル全体をメモリにマップします
+ *
+ * @retval true 成功
+ * @retval false 失敗 ReadFileで読み込みます
+ * @note 32bit環境などでViewを確保できない場合は、従来の読み込みとなります
+ */
+bool IscFileReadControlImpl::MapReadFile()
+{
+	file_read_information_.handle_file_mapping = NULL;
+	file_read_information_.mapped_view = nullptr;
+	file_read_information_.mapped_size = 0;
+	file_read_information_.prefetch_start = 0;
+	file_read_information_.prefetch_end = 0;
 
-	isc_grab_start_mode_.isc_record_mode = isc_grab_start_mode->isc_record_mode;
-	isc_grab_start_mode_.isc_play_mode = isc_grab_start_mode->isc_play_mode;
-	isc_grab_start_mode_.isc_play_mode_parameter.interval = isc_grab_start_mode->isc_play_mode_parameter.interval;
-	swprintf_s(isc_grab_start_mode_.isc_play_mode_parameter.play_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
+	if (file_read_information_.raw_file_size == 0 || file_read_information_.raw_file_size > (unsigned __int64)SIZE_MAX) {
+		return false;
+	}
 
-	swprintf_s(file_read_information_.read_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
+	file_read_information_.handle_file_mapping = CreateFileMapping(file_read_information_.handle_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (file_read_information_.handle_file_mapping == NULL) {
+		return false;
+	}
 
-	// open file
-	file_read_information_.request_fo_designated_number = false;
-	file_read_information_.designated_number = 0;
+	file_read_information_.mapped_view = (const unsigned char*)MapViewOfFile(file_read_information_.handle_file_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (file_read_information_.mapped_view == nullptr) {
+		CloseHandle(file_read_information_.handle_file_mapping);
+		file_read_information_.handle_file_mapping = NULL;
+		return false;
+	}
+	file_read_information_.mapped_size = file_read_information_.raw_file_size;
 
-	file_read_information_.total_read_size = 0;
-	file_read_information_.current_frame_number = 0;
+	return true;
+}
 
-	if (!GetDatFileSize(file_read_information_.read_file_name, &file_read_information_.file_size)) {
-		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+/**
+ * メモリへのマップを解除します
+ *
+ * @return none
+ */
+void IscFileReadControlImpl::UnmapReadFile()
+{
+	if (file_read_information_.mapped_view != nullptr) {
+		UnmapViewOfFile(file_read_information_.mapped_view);
+		file_read_information_.mapped_view = nullptr;
 	}
 
-	if ((file_read_information_.handle_file = CreateFile(	file_read_information_.read_file_name,
-															GENERIC_READ,
-															FILE_SHARE_READ,
-															NULL,
-															OPEN_EXISTING,
-															FILE_ATTRIBUTE_NORMAL,
-															NULL)) == INVALID_HANDLE_VALUE) {
-
+	if (file_read_information_.handle_file_mapping != NULL) {
+		CloseHandle(file_read_information_.handle_file_mapping);
+		file_read_information_.handle_file_mapping = NULL;
+	}
 
-		DWORD gs_error = GetLastError();
-		wchar_t msg[1024] = {};
-		swprintf_s(msg, L"[ERROR]Failed to open read file(%d) %s", gs_error, file_read_information_.read_file_name);
-		MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
+	file_read_information_.mapped_size = 0;
+	file_read_information_.prefetch_start = 0;
+	file_read_information_.prefetch_end = 0;
 
-		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
-	}
+	return;
+}
 
+/**
+ * 現在の読み込み位置から先のデータを先読みします
+ *
+ * @return none
+ * @note 先読み範囲の半分を読み進めたとき、または範囲外へ移動したときに、次の範囲を要求します
+ */
+void IscFileReadControlImpl::PrefetchReadFile()
+{
+	const unsigned __int64 position = file_read_information_.total_read_size;
+	const unsigned __int64 prefetch_size = file_read_information_.prefetch_size;
 
-	// read header
-	DWORD bytes_to_read = sizeof(file_read_information_.raw_file_header);
-	DWORD readed_size = 0;
-	
-	if (FALSE == ReadFile(file_read_information_.handle_file, &file_read_information_.raw_file_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	if ((position >= file_read_information_.prefetch_start) &&
+		(position + (prefetch_size / 2) < file_read_information_.prefetch_end)) {
+		return;
+	}
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	unsigned __int64 end = position + prefetch_size;
+	if (end > file_read_information_.file_size) {
+		end = file_read_information_.file_size;
+	}
+	if (end <= position) {
+		return;
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	raw_read_data_.width = file_read_information_.raw_file_header.max_width;
-	raw_read_data_.height = file_read_information_.raw_file_header.max_height;
+	WIN32_MEMORY_RANGE_ENTRY memory_range = {};
+	memory_range.VirtualAddress = (PVOID)(file_read_information_.mapped_view + position);
+	memory_range.NumberOfBytes = (SIZE_T)(end - position);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &memory_range, 0);
 
-	size_t buff_size = raw_read_data_.width * raw_read_data_.height * 2;
-	raw_read_data_.buffer = new unsigned char[buff_size];
-	memset(raw_read_data_.buffer, 0, buff_size);
+	file_read_information_.prefetch_start = position;
+	file_read_information_.prefetch_end = end;
 
-	file_read_information_.is_file_ready = true;
+	return;
+}
 
-	// it check camera model
-	IscCameraModel camera_model_in_file = IscCameraModel::kVM;
+/**
+ * 現在の位置からヘッダーとデータを1組読み込みます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note
+ *  - 結果は、raw_read_data_.isc_raw_data_headerとraw_read_data_.dataに設定します  
+ *  - マップ時は、dataはViewを直接指します(コピーしません)
+ */
+int IscFileReadControlImpl::ReadRawRecord()
+{
+	if (file_read_information_.mapped_view != nullptr) {
+		const unsigned __int64 position = file_read_information_.total_read_size;
+		const unsigned __int64 header_size = sizeof(raw_read_data_.isc_raw_data_header);
 
-	// model  0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	switch (file_read_information_.raw_file_header.camera_model) {
-	case 0:camera_model_in_file = IscCameraModel::kVM;
-		break;
-	case 1:camera_model_in_file = IscCameraModel::kXC;
-		break;
-	case 2:camera_model_in_file = IscCameraModel::k4K;
-		break;
-	case 3:camera_model_in_file = IscCameraModel::k4KA;
-		break;
-	case 4:camera_model_in_file = IscCameraModel::k4KJ;
-		break;
-	case 99:camera_model_in_file = IscCameraModel::kUnknown;
-		break;
-	default:camera_model_in_file = IscCameraModel::kUnknown;
-		break;
-	}
+		if (position + header_size > file_read_information_.file_size) {
+			file_read_information_.is_file_ready = false;
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+		memcpy(&raw_read_data_.isc_raw_data_header, file_read_information_.mapped_view + position, header_size);
 
-	if (isc_camera_control_config_.isc_camera_model != camera_model_in_file) {
-		if (file_read_information_.handle_file != NULL) {
-			CloseHandle(file_read_information_.handle_file);
-			file_read_information_.handle_file = NULL;
+		const __int64 data_size = raw_read_data_.isc_raw_data_header.data_size;
+		if ((data_size <= 0) || (data_size > (__int64)(raw_read_data_.width * raw_read_data_.height * 2)) ||
+			(position + header_size + data_size > file_read_information_.file_size)) {
+			file_read_information_.is_file_ready = false;
+			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
+		raw_read_data_.data = file_read_information_.mapped_view + position + header_size;
+		raw_read_data_.decoded_size = (int)data_size;
 
-		delete[] raw_read_data_.buffer;
-		raw_read_data_.buffer = nullptr;
-		raw_read_data_.width = 0;
-		raw_read_data_.height = 0;
+		file_read_information_.total_read_size += header_size + data_size;
 
-		file_read_information_.is_file_ready = false;
+		PrefetchReadFile();
 
-		return CAMCONTROL_E_READ_CAMERA_MODEL;
+		if (raw_read_data_.isc_raw_data_header.compressed == 1) {
+			return DecompressRawRecord(file_read_information_.mapped_view + position + header_size);
+		}
+
+		return DPC_E_OK;
 	}
 
-	{
-		// deug informatin
-		char msg[256] = {};
+	DWORD bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
+	DWORD readed_size = 0;
 
-		OutputDebugStringA("[INFO]IscFileReadControlImpl::Start() \n");
-		
-		OutputDebugStringA("    ");
-		OutputDebugStringW(file_read_information_.read_file_name);
-		OutputDebugStringA("\n");
+	// haeder
+	if (FALSE == ReadFromFile(&raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size)) {
+		CloseHandle(file_read_information_.handle_file);
+		file_read_information_.handle_file = NULL;
+		file_read_information_.is_file_ready = false;
 
-		__int64 one_fr_size = sizeof(raw_read_data_.isc_raw_data_header) + buff_size;
-		__int64 total_frame_count = (file_read_information_.file_size - sizeof(file_read_information_.raw_file_header)) / one_fr_size;
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	file_read_information_.total_read_size += readed_size;
 
-		sprintf_s(msg, "    Total Frame Count=%lld\n", total_frame_count);
-		OutputDebugStringA(msg);
+	// data
+	unsigned char* read_buffer = (raw_read_data_.isc_raw_data_header.compressed == 1) ? raw_read_data_.compressed_buffer : raw_read_data_.buffer;
+	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
+	readed_size = 0;
+	if ((raw_read_data_.isc_raw_data_header.data_size <= 0) || (raw_read_data_.isc_raw_data_header.data_size > (raw_read_data_.width * raw_read_data_.height * 2))) {
+		file_read_information_.is_file_ready = false;
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	if (FALSE == ReadFromFile(read_buffer, bytes_to_read, &readed_size)) {
+		CloseHandle(file_read_information_.handle_file);
+		file_read_information_.handle_file = NULL;
+		file_read_information_.is_file_ready = false;
 
-		OutputDebugStringA("[INFO]IscFileReadControlImpl::Start() end of message -- \n");
+		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
+	file_read_information_.total_read_size += readed_size;
 
-	file_read_information_.file_read_status = IscFileReadStatus::kReading;
+	raw_read_data_.data = raw_read_data_.buffer;
+	raw_read_data_.decoded_size = raw_read_data_.isc_raw_data_header.data_size;
 
+	if (raw_read_data_.isc_raw_data_header.compressed == 1) {
+		return DecompressRawRecord(raw_read_data_.compressed_buffer);
+	}
 
 	return DPC_E_OK;
 }
 
 /**
- * ファイルからの読み込みを終了します
- *
+ * 圧縮されたデータを展開します
  *
+ * @param[in] src 圧縮データ(サイズはheaderのdata_size)
  * @retval 0 成功
  * @retval other 失敗
+ * @note 展開したデータはbufferに格納し、dataはbufferを指します
+ * @note headerのdata_sizeはファイル上のサイズのままとし、展開後のサイズはdecoded_sizeに設定します
  */
-int IscFileReadControlImpl::Stop()
+int IscFileReadControlImpl::DecompressRawRecord(const unsigned char* src)
 {
+	const int buffer_size = raw_read_data_.width * raw_read_data_.height * 2;
+	int decompressed_size = 0;
 
-	if (file_read_information_.handle_file != NULL) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
+	int ret = raw_data_codec_->Decompress(src, raw_read_data_.isc_raw_data_header.data_size, raw_read_data_.buffer, buffer_size, &decompressed_size);
+	if (ret != DPC_E_OK) {
+		return ret;
 	}
 
-	delete[] raw_read_data_.buffer;
-	raw_read_data_.buffer = nullptr;
-	raw_read_data_.width = 0;
-	raw_read_data_.height = 0;
+	raw_read_data_.decoded_size = decompressed_size;
+	raw_read_data_.data = raw_read_data_.buffer;
 
-	file_read_information_.is_file_ready = false;
+	return DPC_E_OK;
+}
 
-	file_read_information_.file_read_status = IscFileReadStatus::kNotReady;
+/**
+ * 指定位置のデータのヘッダーを読み込みます
+ *
+ * @param[in] handle_file 読み込みファイル
+ * @param[in] offset ヘッダーの位置
+ * @param[out] isc_raw_data_header ヘッダー
+ * @retval true 成功
+ * @retval false 失敗
+ * @note ファイルの位置は移動したままとなります
+ */
+bool IscFileReadControlImpl::ReadRawDataHeaderAt(HANDLE handle_file, const unsigned __int64 offset, IscRawDataHeader* isc_raw_data_header)
+{
+	LARGE_INTEGER distance_to_move = {};
+	distance_to_move.QuadPart = (LONGLONG)offset;
+	if (!SetFilePointerEx(handle_file, distance_to_move, NULL, FILE_BEGIN)) {
+		return false;
+	}
 
-	OutputDebugStringA("[INFO]IscFileReadControlImpl::Stop() \n");
+	DWORD readed_size = 0;
+	if (FALSE == ReadFile(handle_file, isc_raw_data_header, sizeof(IscRawDataHeader), &readed_size, NULL) || readed_size != sizeof(IscRawDataHeader)) {
+		return false;
+	}
 
-	return DPC_E_OK;
+	return true;
 }
 
 /**
- * 現在の動作モードを取得します
- *
- * @param[out] isc_grab_start_mode　動作モード
+ * データのヘッダーが正しいか確認します
  *
- * @retval 0 成功
- * @retval other 失敗
+ * @param[in] isc_raw_data_header 確認するヘッダー
+ * @param[in] first_data_header 先頭のデータのヘッダー
+ * @param[in] max_data_size データの最大サイズ
+ * @retval true 正しい
+ * @retval false 不正 (事前確保の領域、または書き込み途中)
+ * @note ヘッダーにはマークが無いため、先頭のデータとversionが一致し、各項目が範囲内であることを確認します
  */
-int IscFileReadControlImpl::GetGrabMode(IscGrabStartMode* isc_grab_start_mode)
+bool IscFileReadControlImpl::IsValidRawDataHeader(const IscRawDataHeader* isc_raw_data_header, const IscRawDataHeader* first_data_header, const int max_data_size) const
 {
-	isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
-	switch (file_read_information_.raw_file_header.grab_mode) {
-	case 0:
-		// ?
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
-		break;
+	if ((isc_raw_data_header->version != first_data_header->version) ||
+		(isc_raw_data_header->header_size != sizeof(IscRawDataHeader))) {
+		return false;
+	}
 
-	case 1:
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
-		break;
+	if ((isc_raw_data_header->data_size <= 0) || (isc_raw_data_header->data_size > max_data_size)) {
+		return false;
+	}
 
-	case 2:
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kCorrect;
-		break;
+	if ((isc_raw_data_header->compressed != 0) && (isc_raw_data_header->compressed != 1)) {
+		return false;
+	}
 
-	case 3:
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kBeforeCorrect;
-		break;
+	if (isc_raw_data_header->version >= 300) {
+		if ((isc_raw_data_header->type != 1) && (isc_raw_data_header->type != 2)) {
+			return false;
+		}
 
-	case 4:
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kBayerS0;
-		break;
+		// 先頭のデータより前の時刻にはならない
+		ULARGE_INTEGER frame_time = {};
+		frame_time.LowPart = isc_raw_data_header->frame_time_low;
+		frame_time.HighPart = isc_raw_data_header->frame_time_high;
 
-	case 5:
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kBayerS1;
-		break;
+		ULARGE_INTEGER first_frame_time = {};
+		first_frame_time.LowPart = first_data_header->frame_time_low;
+		first_frame_time.HighPart = first_data_header->frame_time_high;
 
-	default:
-		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
-		break;
+		if (frame_time.QuadPart < first_frame_time.QuadPart) {
+			return false;
+		}
 	}
 
-	isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorOFF;
-	switch (file_read_information_.raw_file_header.color_mode) {
-	case 0:
-		isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorOFF;
-		break;
-	case 1:
-		isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorON;
-		break;
-	default:
-		isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorOFF;
-		break;
-	}
-
-	isc_grab_start_mode->isc_get_mode.wait_time = isc_grab_start_mode_.isc_get_mode.wait_time;
-	isc_grab_start_mode->isc_get_raw_mode = isc_grab_start_mode_.isc_get_raw_mode;
-	isc_grab_start_mode->isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;
-
-	isc_grab_start_mode->isc_record_mode = IscRecordMode::kRecordOff;
-	isc_grab_start_mode->isc_play_mode = IscPlayMode::kPlayOff;
-	isc_grab_start_mode->isc_play_mode_parameter.interval = 0;
-	swprintf_s(isc_grab_start_mode->isc_play_mode_parameter.play_file_name, L"%s", file_read_information_.read_file_name);
-
-	return DPC_E_OK;
+	return true;
 }
 
 /**
- * 読み込みデータを取得します
- *
- * @param[out] isc_image_info　データ
+ * 最後の正しいデータを探します
  *
- * @retval 0 成功
- * @retval other 失敗
+ * @param[in] handle_file 読み込みファイル
+ * @param[in] raw_file_header ファイルのヘッダー
+ * @param[in] first_data_header 先頭のデータのヘッダー
+ * @param[in] max_data_size データの最大サイズ
+ * @param[in] file_size ファイルのサイズ
+ * @param[in] start_count 確認済みのデータの数
+ * @param[in] start_offset 確認済みのデータの終わりの位置
+ * @param[out] valid_size 最後の正しいデータの終わりの位置
+ * @return 正しいデータの数
+ * @note
+ *  - ファイルのヘッダーが非圧縮の場合、データは固定長のため、データの位置を二分探索します  
+ *  - 圧縮のファイルは、縮まないデータをそのまま格納するため可変長です。ヘッダーを順にたどります  
+ *  - 書き込みは先頭から順に行われるため、正しいデータは先頭から連続しているものとします
  */
-int IscFileReadControlImpl::GetData(IscImageInfo* isc_image_info)
+__int64 IscFileReadControlImpl::FindValidRecordCount(HANDLE handle_file, const IscRawFileHeader* raw_file_header, const IscRawDataHeader* first_data_header, const int max_data_size, const unsigned __int64 file_size,
+														const __int64 start_count, const unsigned __int64 start_offset, unsigned __int64* valid_size)
 {
+	const unsigned __int64 data_header_size = sizeof(IscRawDataHeader);
+	IscRawDataHeader isc_raw_data_header = {};
 
-	if (!file_read_information_.is_file_ready) {
-		return CAMCONTROL_E_NO_IMAGE;
-	}
+	if ((raw_file_header->compression == 0) && (first_data_header->compressed == 0)) {
+		const unsigned __int64 record_size = data_header_size + max_data_size;
 
-	if (file_read_information_.handle_file == NULL) {
-		return CAMCONTROL_E_NO_IMAGE;
-	}
+		// low個目までは正しく、high個目より後は不正
+		__int64 low = 0;
+		__int64 high = (file_size > start_offset) ? (__int64)((file_size - start_offset) / record_size) : 0;
 
-	// Colorモードを確認する
-	// Color ModeがOnの場合は、mono/colorをペアで読み込み
+		while (low < high) {
+			const __int64 middle = low + (high - low + 1) / 2;
+			const unsigned __int64 offset = start_offset + record_size * (middle - 1);
 
-	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+			if (ReadRawDataHeaderAt(handle_file, offset, &isc_raw_data_header) &&
+				IsValidRawDataHeader(&isc_raw_data_header, first_data_header, max_data_size) &&
+				(isc_raw_data_header.compressed == 0) && (isc_raw_data_header.data_size == max_data_size)) {
+				low = middle;
+			}
+			else {
+				high = middle - 1;
+			}
+		}
 
-		IscShutterMode isc_shutter_mode = IscShutterMode::kManualShutter;
-		switch (file_read_information_.raw_file_header.shutter_mode) {
-		case 0:
-			isc_shutter_mode = IscShutterMode::kManualShutter;
-			break;
-		case 1:
-			isc_shutter_mode = IscShutterMode::kSingleShutter;
-			break;
-		case 2:
-			isc_shutter_mode = IscShutterMode::kDoubleShutter;
+		*valid_size = start_offset + record_size * low;
+
+		return start_count + low;
+	}
+
+	__int64 count = start_count;
+	unsigned __int64 offset = start_offset;
+
+	while (offset + data_header_size <= file_size) {
+		if (!ReadRawDataHeaderAt(handle_file, offset, &isc_raw_data_header) ||
+			!IsValidRawDataHeader(&isc_raw_data_header, first_data_header, max_data_size)) {
 			break;
-		case 3:
-			isc_shutter_mode = IscShutterMode::kDoubleShutter2;
+		}
+
+		const unsigned __int64 end_of_data = offset + data_header_size + isc_raw_data_header.data_size;
+		if (end_of_data > file_size) {
 			break;
 		}
 
-		if (isc_shutter_mode == IscShutterMode::kDoubleShutter) {
-			// Double Shutterの場合は、2Frame必要
-			int width = file_read_information_.raw_file_header.max_width;
-			int height = file_read_information_.raw_file_header.max_height;
+		count++;
+		offset = end_of_data;
+	}
 
-			size_t frame_size = width * height * 2;
-			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+	*valid_size = offset;
 
-			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size;
-			if (next_to_read >= file_read_information_.file_size) {
-				file_read_information_.file_read_status = IscFileReadStatus::kEnded;
-				return CAMCONTROL_E_NO_IMAGE;
-			}
-		}
-		else {
-			int width = file_read_information_.raw_file_header.max_width;
-			int height = file_read_information_.raw_file_header.max_height;
+	return count;
+}
 
-			size_t frame_size = width * height * 2;
-			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+/**
+ * データが書き込まれている最後のEntryを探します
+ *
+ * @param[in] handle_file 読み込みファイル
+ * @param[in] raw_file_index インデックス
+ * @param[in] first_data_header 先頭のデータのヘッダー
+ * @param[in] max_data_size データの最大サイズ
+ * @param[in] start_count 確認済みのEntryの数
+ * @return 正しいEntryの数
+ * @note Entryの位置のヘッダーが正しく、frame_indexとdata_sizeがEntryと一致するものを二分探索します
+ */
+__int64 IscFileReadControlImpl::FindValidIndexCount(HANDLE handle_file, const IscRawFileIndex* raw_file_index, const IscRawDataHeader* first_data_header, const int max_data_size, const __int64 start_count)
+{
+	IscRawFileIndexEntry entry = {};
+	IscRawDataHeader isc_raw_data_header = {};
 
-			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size;
-			if (next_to_read > file_read_information_.file_size) {
-				file_read_information_.file_read_status = IscFileReadStatus::kEnded;
-				return CAMCONTROL_E_NO_IMAGE;
-			}
+	// low個目までは正しく、high個目より後は不正
+	__int64 low = start_count;
+	__int64 high = raw_file_index->GetEntryCount();
+
+	while (low < high) {
+		const __int64 middle = low + (high - low + 1) / 2;
+
+		if ((raw_file_index->GetEntry(middle - 1, &entry) == DPC_E_OK) &&
+			ReadRawDataHeaderAt(handle_file, (unsigned __int64)entry.offset, &isc_raw_data_header) &&
+			IsValidRawDataHeader(&isc_raw_data_header, first_data_header, max_data_size) &&
+			(isc_raw_data_header.frame_index == entry.frame_index) && (isc_raw_data_header.data_size == entry.data_size)) {
+			low = middle;
 		}
-	}
-	else if (isc_grab_color_mode == IscGrabColorMode::kColorON) {
-		IscShutterMode isc_shutter_mode = IscShutterMode::kManualShutter;
-		switch (file_read_information_.raw_file_header.shutter_mode) {
-		case 0:
-			isc_shutter_mode = IscShutterMode::kManualShutter;
-			break;
-		case 1:
-			isc_shutter_mode = IscShutterMode::kSingleShutter;
-			break;
-		case 2:
-			isc_shutter_mode = IscShutterMode::kDoubleShutter;
-			break;
-		case 3:
-			isc_shutter_mode = IscShutterMode::kDoubleShutter2;
-			break;
+		else {
+			high = middle - 1;
 		}
+	}
 
-		if (isc_shutter_mode == IscShutterMode::kDoubleShutter) {
-			// Double Shutte & Colorrの場合は、4Frame必要
-			int width = file_read_information_.raw_file_header.max_width;
-			int height = file_read_information_.raw_file_header.max_height;
+	return low;
+}
 
-			size_t frame_size = width * height * 2;
-			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+/**
+ * 最後の正しいデータまでを読み込みの範囲とします
+ *
+ * @return 正しいデータの数
+ * @note
+ *  - 正常に閉じられていないファイル(事前確保の領域や書き込み途中のデータが残る)や、記録中のファイル用です  
+ *  - 結果は、file_read_information_.file_sizeとインデックスに反映します  
+ *  - 分散されたファイルは対象外です
+ */
+__int64 IscFileReadControlImpl::RecoverReadFile()
+{
+	const unsigned __int64 data_offset = sizeof(IscRawFileHeader);
+	const int max_data_size = raw_read_data_.width * raw_read_data_.height * 2;
+	IscRawDataHeader* first_data_header = &file_read_information_.first_data_header;
 
-			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size * 4;
-			if (next_to_read > file_read_information_.file_size) {
-				file_read_information_.file_read_status = IscFileReadStatus::kEnded;
-				return CAMCONTROL_E_NO_IMAGE;
-			}
-		}
-		else {
-			// Colorrの場合は、2Frame必要
-			int width = file_read_information_.raw_file_header.max_width;
-			int height = file_read_information_.raw_file_header.max_height;
+	__int64 record_count = 0;
+	file_read_information_.file_size = data_offset;
 
-			size_t frame_size = width * height * 2;
-			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+	// 先頭のデータを基準とする
+	if (!ReadRawDataHeaderAt(file_read_information_.handle_file, data_offset, first_data_header) ||
+		!IsValidRawDataHeader(first_data_header, first_data_header, max_data_size)) {
+		// データ無し
+		memset(first_data_header, 0, sizeof(IscRawDataHeader));
+		raw_file_index_->Clear();
+	}
+	else if (raw_file_index_->IsValid()) {
+		record_count = FindValidIndexCount(file_read_information_.handle_file, raw_file_index_, first_data_header, max_data_size, 0);
+		raw_file_index_->Truncate(record_count);
 
-			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size * 2;
-			if (next_to_read > file_read_information_.file_size) {
-				file_read_information_.file_read_status = IscFileReadStatus::kEnded;
-				return CAMCONTROL_E_NO_IMAGE;
-			}
+		IscRawFileIndexEntry entry = {};
+		if (raw_file_index_->GetEntry(record_count - 1, &entry) == DPC_E_OK) {
+			file_read_information_.file_size = (unsigned __int64)entry.offset + sizeof(IscRawDataHeader) + entry.data_size;
 		}
 	}
 	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		record_count = FindValidRecordCount(file_read_information_.handle_file, &file_read_information_.raw_file_header, first_data_header, max_data_size, file_read_information_.raw_file_size,
+											0, data_offset, &file_read_information_.file_size);
 	}
 
-	// setup
-	IscGrabMode isc_grab_mode = IscGrabMode::kParallax;
-	switch (file_read_information_.raw_file_header.grab_mode) {
-	case 1:
-		isc_grab_mode = IscGrabMode::kParallax;
-		break;
-
-	case 2:
-		isc_grab_mode = IscGrabMode::kCorrect;
-		break;
+	// 読み込み位置を戻す
+	LARGE_INTEGER distance_to_move = {};
+	distance_to_move.QuadPart = (LONGLONG)file_read_information_.total_read_size;
+	SeekReadFile(distance_to_move, NULL, FILE_BEGIN);
 
-	case 3:
-		isc_grab_mode = IscGrabMode::kBeforeCorrect;
-		break;
+	return record_count;
+}
 
-	case 4:
-		isc_grab_mode = IscGrabMode::kBayerS0;
-		break;
+/**
+ * 記録中のファイルに追記されたデータを読み込みの範囲に加えます
+ *
+ * @retval true 追記あり
+ * @retval false 追記無し
+ * @note
+ *  - 確認は、kISC_PLAY_FOLLOW_CHECK_INTERVAL_MSEC毎とします  
+ *  - 事前確保されたファイルはサイズが変わらないため、ヘッダーを確認します  
+ *  - Viewの範囲を越えた場合は、マップし直します
+ */
+bool IscFileReadControlImpl::RefreshGrowingFile()
+{
+	if (file_read_information_.is_striped || (file_read_information_.handle_file == NULL)) {
+		return false;
 	}
-	isc_image_info->grab = isc_grab_mode;
-	isc_image_info->color_grab_mode = isc_grab_color_mode;
 
-	IscShutterMode isc_shutter_mode = IscShutterMode::kManualShutter;
-	switch (file_read_information_.raw_file_header.shutter_mode) {
-	case 0:
-		isc_shutter_mode = IscShutterMode::kManualShutter;
-		break;
-	case 1:
-		isc_shutter_mode = IscShutterMode::kSingleShutter;
-		break;
-	case 2:
-		isc_shutter_mode = IscShutterMode::kDoubleShutter;
-		break;
-	case 3:
-		isc_shutter_mode = IscShutterMode::kDoubleShutter2;
-		break;
+	const ULONGLONG now_time = GetTickCount64();
+	if ((now_time - file_read_information_.follow_check_time) < kISC_PLAY_FOLLOW_CHECK_INTERVAL_MSEC) {
+		return false;
 	}
-	isc_image_info->shutter_mode = isc_shutter_mode;
-	isc_image_info->camera_specific_parameter.d_inf = file_read_information_.raw_file_header.d_inf;
-	isc_image_info->camera_specific_parameter.bf = file_read_information_.raw_file_header.bf;
-	isc_image_info->camera_specific_parameter.base_length = file_read_information_.raw_file_header.base_length;
-	isc_image_info->camera_specific_parameter.dz = file_read_information_.raw_file_header.dz;
+	file_read_information_.follow_check_time = now_time;
 
-	// 指定Frameへの移動要求の確認
-	if (file_read_information_.request_fo_designated_number) {
-		file_read_information_.request_fo_designated_number = false;
+	LARGE_INTEGER raw_file_size = {};
+	if (!GetFileSizeEx(file_read_information_.handle_file, &raw_file_size)) {
+		return false;
+	}
+	file_read_information_.raw_file_size = (unsigned __int64)raw_file_size.QuadPart;
 
-		__int64 request_frame = file_read_information_.designated_number;
+	const int max_data_size = raw_read_data_.width * raw_read_data_.height * 2;
+	const unsigned __int64 previous_file_size = file_read_information_.file_size;
+	__int64 total_frame_count = file_read_information_.play_file_information.total_frame_count;
 
-		if ((request_frame >= 0) && (request_frame < file_read_information_.play_file_information.total_frame_count)) {
-			// 移動
-			int move_ret = MoveToSpecifyFrameNumber(request_frame);
+	if (file_read_information_.first_data_header.header_size == 0) {
+		// 開始時にデータが無かった
+		raw_file_index_->Load(file_read_information_.read_file_name, file_read_information_.raw_file_size);
+		total_frame_count = RecoverReadFile();
+	}
+	else if (raw_file_index_->IsValid()) {
+		__int64 added_count = 0;
+		if (raw_file_index_->Extend(file_read_information_.read_file_name, file_read_information_.raw_file_size, &added_count) == DPC_E_OK && added_count > 0) {
+			total_frame_count = FindValidIndexCount(file_read_information_.handle_file, raw_file_index_, &file_read_information_.first_data_header, max_data_size, total_frame_count);
+			raw_file_index_->Truncate(total_frame_count);
 
-			if (move_ret != DPC_E_OK) {
-				return CAMCONTROL_E_READ_FILE_FAILED;
+			IscRawFileIndexEntry entry = {};
+			if (raw_file_index_->GetEntry(total_frame_count - 1, &entry) == DPC_E_OK) {
+				file_read_information_.file_size = (unsigned __int64)entry.offset + sizeof(IscRawDataHeader) + entry.data_size;
 			}
 		}
 	}
+	else {
+		total_frame_count = FindValidRecordCount(file_read_information_.handle_file, &file_read_information_.raw_file_header, &file_read_information_.first_data_header, max_data_size, file_read_information_.raw_file_size,
+													total_frame_count, file_read_information_.file_size, &file_read_information_.file_size);
+	}
 
-	if ((isc_shutter_mode == IscShutterMode::kManualShutter) ||
-		(isc_shutter_mode == IscShutterMode::kSingleShutter) ||
-		(isc_shutter_mode == IscShutterMode::kDoubleShutter2)) {
+	if (file_read_information_.file_size <= previous_file_size) {
+		file_read_information_.file_size = previous_file_size;
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
-			int ret = ReadOneRawData(isc_image_info);
-			if (ret != DPC_E_OK) {
-				return ret;
-			}
-		}
-		else if (isc_grab_color_mode == IscGrabColorMode::kColorON) {
-			int ret = ReadColorRawData(isc_image_info);
-			if (ret != DPC_E_OK) {
-				return ret;
-			}
-		}
-		else {
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
+		LARGE_INTEGER distance_to_move = {};
+		distance_to_move.QuadPart = (LONGLONG)file_read_information_.total_read_size;
+		SeekReadFile(distance_to_move, NULL, FILE_BEGIN);
+
+		return false;
 	}
-	else if (isc_shutter_mode == IscShutterMode::kDoubleShutter) {
-		// isc_shutter_mode = IscShutterMode::kDoubleShutter
-		// 合成を行います
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+	file_read_information_.play_file_information.total_frame_count = total_frame_count;
 
-			// Frame番号が連続していないデータは、不採用とします
+	// the view covers the file size at the time of mapping
+	if ((file_read_information_.mapped_view != nullptr) && (file_read_information_.file_size > file_read_information_.mapped_size)) {
+		UnmapReadFile();
+		MapReadFile();
+	}
 
-			DPL_RESULT read_ret = DPC_E_OK;
-			while(true) {
-				read_ret = ReadDoubleShutterRawData(isc_image_info);
-				
-				if (read_ret == DPC_E_OK) {
-					break;
-				}
-				else if (read_ret == CAMCONTROL_E_READ_FILE_FAILED_RETRY) {
-					// continue
-					int width = file_read_information_.raw_file_header.max_width;
-					int height = file_read_information_.raw_file_header.max_height;
+	LARGE_INTEGER distance_to_move = {};
+	distance_to_move.QuadPart = (LONGLONG)file_read_information_.total_read_size;
+	SeekReadFile(distance_to_move, NULL, FILE_BEGIN);
 
-					size_t frame_size = width * height * 2;
-					__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+	return true;
+}
 
-					unsigned __int64 next_to_read = file_read_information_.total_read_size + (one_data_size * 2);
-					// Double Shutterの場合は、2Frame必要
-					if (next_to_read >= file_read_information_.file_size) {
-						return CAMCONTROL_E_NO_IMAGE;
-					}
-				}
-				else {
-					break;
-				}
-			}
-		}
-		else {
-			// Double shutterにおけるColor画像の取得は、以下のFPGAとSDKよりサポートされました
-			// VM	X
-			// XC	FPGA 0x28 SDK 2.8.0
-			// 4K	X
+/**
+ * ファイルの終わりに達したときの処理を行います
+ *
+ * @retval CAMCONTROL_E_NO_IMAGE 読み込むデータ無し
+ * @note 記録中のファイルを追う場合は、終了とせずに追記を待ちます。追記されたデータは次の呼び出しで読み込みます
+ */
+int IscFileReadControlImpl::ReachEndOfFile()
+{
+	if (file_read_information_.follow_growing_file) {
+		RefreshGrowingFile();
 
-			// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-			if (file_read_information_.raw_file_header.camera_model == 0) {
-				// VM
-				return CAMCONTROL_E_READ_FILE_FAILED;
-			}
-			else if (file_read_information_.raw_file_header.camera_model == 1) {
-				// XC
-				// Frame番号が連続していないデータは、不採用とします
-
-				DPL_RESULT read_ret = DPC_E_OK;
-				while (true) {
-					read_ret = ReadDoubleShutterColorRawData(isc_image_info);
-
-					if (read_ret == DPC_E_OK) {
-						break;
-					}
-					else if (read_ret == CAMCONTROL_E_READ_FILE_FAILED_RETRY) {
-						// continue
-						int width = file_read_information_.raw_file_header.max_width;
-						int height = file_read_information_.raw_file_header.max_height;
-
-						size_t frame_size = width * height * 2;
-						__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
-
-						unsigned __int64 next_to_read = file_read_information_.total_read_size + (one_data_size * 4);
-						// Double Shutter;Colorの場合は、4Frame必要
-						if (next_to_read >= file_read_information_.file_size) {
-							return CAMCONTROL_E_NO_IMAGE;
-						}
-					}
-					else {
-						break;
-					}
-				}
-			}
-			else if (file_read_information_.raw_file_header.camera_model == 2) {
-				// 4K
-				return CAMCONTROL_E_READ_FILE_FAILED;
-			}
-			else if (file_read_information_.raw_file_header.camera_model == 3) {
-				return CAMCONTROL_E_READ_FILE_FAILED;
-			}
-			else if (file_read_information_.raw_file_header.camera_model == 4) {
-				return CAMCONTROL_E_READ_FILE_FAILED;
-			}
-			else {
-				return CAMCONTROL_E_READ_FILE_FAILED;
-			}
-		}
-	}
-	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		return CAMCONTROL_E_NO_IMAGE;
 	}
 
-	// adjust the time
-	Sleep(isc_grab_start_mode_.isc_play_mode_parameter.interval);
+	file_read_information_.file_read_status = IscFileReadStatus::kEnded;
 
-	return DPC_E_OK;
+	return CAMCONTROL_E_NO_IMAGE;
 }
 
 /**
- * RAW Dataを1個読み込みます
- *
- * @param[out] isc_image_info　データ
+ * ファイルからの読み込みを開始します
  *
+ * @param[in] isc_grab_start_mode 読み込みのモードを指定する
+ * 
  * @retval 0 成功
  * @retval other 失敗
  */
-int IscFileReadControlImpl::ReadOneRawData(IscImageInfo* isc_image_info)
+int IscFileReadControlImpl::Start(const IscGrabStartMode* isc_grab_start_mode)
 {
-	// read from file
-	DWORD bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	DWORD readed_size = 0;
 
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	file_read_information_.is_file_ready = false;
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	if (isc_grab_start_mode->isc_play_mode == IscPlayMode::kPlayOff) {
+		// error
+		return CAMCONTROL_E_INVALID_REQUEST;
 	}
-	file_read_information_.total_read_size += readed_size;
-
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
 
-		DWORD last_err = GetLastError();
+	if (isc_grab_start_mode->isc_play_mode_parameter.play_file_name[0] == 0) {
+		// error
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
 
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	if (::PathFileExists(isc_grab_start_mode->isc_play_mode_parameter.play_file_name) &&
+		!::PathIsDirectory(isc_grab_start_mode->isc_play_mode_parameter.play_file_name)) {
+		// 指定されたパスにファイルが存在、かつディレクトリでない -> OK
+	}
+	else {
+		// NG
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	if ((isc_grab_start_mode->isc_play_mode_parameter.pacing_mode == IscPlayPacingMode::kFixedRate) &&
+		(isc_grab_start_mode->isc_play_mode_parameter.fixed_rate <= 0)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	const int frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+	isc_grab_start_mode_.isc_grab_mode = isc_grab_start_mode->isc_grab_mode;
+	isc_grab_start_mode_.isc_grab_color_mode = isc_grab_start_mode->isc_grab_color_mode;
 
-	// 初期化
-	{
-		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
-		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+	isc_grab_start_mode_.isc_get_mode.wait_time = isc_grab_start_mode->isc_get_mode.wait_time;
+	isc_grab_start_mode_.isc_get_raw_mode = isc_grab_start_mode->isc_get_raw_mode;
+	isc_grab_start_mode_.isc_get_color_mode = isc_grab_start_mode->isc_get_color_mode;
 
-		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+	isc_grab_start_mode_.isc_record_mode = isc_grab_start_mode->isc_record_mode;
+	isc_grab_start_mode_.isc_play_mode = isc_grab_start_mode->isc_play_mode;
+	isc_grab_start_mode_.isc_play_mode_parameter.interval = isc_grab_start_mode->isc_play_mode_parameter.interval;
+	isc_grab_start_mode_.isc_play_mode_parameter.pacing_mode = isc_grab_start_mode->isc_play_mode_parameter.pacing_mode;
+	isc_grab_start_mode_.isc_play_mode_parameter.fixed_rate = isc_grab_start_mode->isc_play_mode_parameter.fixed_rate;
+	isc_grab_start_mode_.isc_play_mode_parameter.follow_growing_file = isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file;
+	swprintf_s(isc_grab_start_mode_.isc_play_mode_parameter.play_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
 
-			ULARGE_INTEGER ul_int = {};
-			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
-			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+	swprintf_s(file_read_information_.read_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
 
-			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+	// open file
+	file_read_information_.request_fo_designated_number = false;
+	file_read_information_.designated_number = 0;
 
-			// debug
-			if (0) {
-				struct timespec tm = {};
-				tm.tv_sec = ul_int.QuadPart / 1000LL;
-				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+	file_read_information_.total_read_size = 0;
+	file_read_information_.current_frame_number = 0;
 
-				struct tm ltm;
-				localtime_s(&ltm, &tm.tv_sec);
-				long millisecond = tm.tv_nsec / 1000000LL;
+	file_read_information_.follow_growing_file = isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file;
+	file_read_information_.follow_check_time = 0;
 
-				char time_str[256] = {};
-				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	ResetPlayPacing();
 
-				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
-					raw_read_data_.isc_raw_data_header.frame_index,
-					ltm.tm_year + 1900,
-					ltm.tm_mon + 1,
-					ltm.tm_mday,
-					dayofweek[ltm.tm_wday],
-					ltm.tm_hour,
-					ltm.tm_min,
-					ltm.tm_sec,
-					millisecond);
+	if (!GetDatFileSize(file_read_information_.read_file_name, &file_read_information_.file_size)) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
+	file_read_information_.raw_file_size = file_read_information_.file_size;
 
-				OutputDebugStringA(time_str);
-			}
-		}
-		else {
-			isc_image_info->frame_data[frame_data_index].frame_time = 0;
-		}
+	// the file may be being written
+	if ((file_read_information_.handle_file = CreateFile(	file_read_information_.read_file_name,
+															GENERIC_READ,
+															FILE_SHARE_READ | FILE_SHARE_WRITE,
+															NULL,
+															OPEN_EXISTING,
+															FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+															NULL)) == INVALID_HANDLE_VALUE) {
 
-		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
-		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
 
-		isc_image_info->frame_data[frame_data_index].p1.width = 0;
-		isc_image_info->frame_data[frame_data_index].p1.height = 0;
-		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+		DWORD gs_error = GetLastError();
+		wchar_t msg[1024] = {};
+		swprintf_s(msg, L"[ERROR]Failed to open read file(%d) %s", gs_error, file_read_information_.read_file_name);
+		MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
 
-		isc_image_info->frame_data[frame_data_index].p2.width = 0;
-		isc_image_info->frame_data[frame_data_index].p2.height = 0;
-		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
 
-		isc_image_info->frame_data[frame_data_index].color.width = 0;
-		isc_image_info->frame_data[frame_data_index].color.height = 0;
-		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+	// striped file (the manifest stays open, the data is read from the files in each folder)
+	file_read_information_.is_striped = false;
+	if (IscRawFileStripe::IsManifest(file_read_information_.read_file_name)) {
+		int ret = raw_file_stripe_->Open(file_read_information_.read_file_name);
+		if (ret != DPC_E_OK) {
+			CloseHandle(file_read_information_.handle_file);
+			file_read_information_.handle_file = NULL;
 
-		isc_image_info->frame_data[frame_data_index].depth.width = 0;
-		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+			return ret;
+		}
+		file_read_information_.is_striped = true;
+		file_read_information_.file_size = raw_file_stripe_->GetSize();
+		file_read_information_.raw_file_size = file_read_information_.file_size;
+	}
 
-		isc_image_info->frame_data[frame_data_index].raw.width = 0;
-		isc_image_info->frame_data[frame_data_index].raw.height = 0;
-		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+	// read header
+	DWORD bytes_to_read = sizeof(file_read_information_.raw_file_header);
+	DWORD readed_size = 0;
+	
+	if (FALSE == ReadFromFile(&file_read_information_.raw_file_header, bytes_to_read, &readed_size)) {
+		raw_file_stripe_->Close();
+		file_read_information_.is_striped = false;
+		CloseHandle(file_read_information_.handle_file);
+		file_read_information_.handle_file = NULL;
+		file_read_information_.is_file_ready = false;
+
+		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
+	file_read_information_.total_read_size += readed_size;
 
-	// decode
-	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
+	raw_read_data_.width = file_read_information_.raw_file_header.max_width;
+	raw_read_data_.height = file_read_information_.raw_file_header.max_height;
 
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		IscCameraModel isc_camera_model = IscCameraModel::kVM;
-		IscGetModeColor isc_get_color_mode = IscGetModeColor::kAwb;
+	size_t buff_size = raw_read_data_.width * raw_read_data_.height * 2;
+	raw_read_data_.buffer = new unsigned char[buff_size];
+	memset(raw_read_data_.buffer, 0, buff_size);
+	raw_read_data_.data = raw_read_data_.buffer;
+	raw_read_data_.decoded_size = 0;
+	raw_read_data_.compressed_buffer = new unsigned char[buff_size];
 
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
+	// map the whole file (if not, use ReadFile)
+	file_read_information_.prefetch_size = (unsigned __int64)(sizeof(raw_read_data_.isc_raw_data_header) + buff_size) * kISC_PLAY_PREFETCH_FRAME_COUNT;
+	if (!file_read_information_.is_striped) {
+		MapReadFile();
+	}
 
-		isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-		isc_image_info->frame_data[frame_data_index].raw.height = height;
-		isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-		size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-		memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+	file_read_information_.is_file_ready = true;
 
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+	// it check camera model
+	IscCameraModel camera_model_in_file = IscCameraModel::kVM;
 
-		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
-		obtained_color_mode = IscGrabColorMode::kColorOFF;
+	// model  0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	switch (file_read_information_.raw_file_header.camera_model) {
+	case 0:camera_model_in_file = IscCameraModel::kVM;
+		break;
+	case 1:camera_model_in_file = IscCameraModel::kXC;
+		break;
+	case 2:camera_model_in_file = IscCameraModel::k4K;
+		break;
+	case 3:camera_model_in_file = IscCameraModel::k4KA;
+		break;
+	case 4:camera_model_in_file = IscCameraModel::k4KJ;
+		break;
+	case 99:camera_model_in_file = IscCameraModel::kUnknown;
+		break;
+	default:camera_model_in_file = IscCameraModel::kUnknown;
+		break;
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		IscCameraModel isc_camera_model = IscCameraModel::kXC;
-		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
-
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
 
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+	if (isc_camera_control_config_.isc_camera_model != camera_model_in_file) {
+		UnmapReadFile();
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+		raw_file_stripe_->Close();
+		file_read_information_.is_striped = false;
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		if (file_read_information_.handle_file != NULL) {
+			CloseHandle(file_read_information_.handle_file);
+			file_read_information_.handle_file = NULL;
 		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
-		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
-			// color
-			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
-			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+		delete[] raw_read_data_.buffer;
+		raw_read_data_.buffer = nullptr;
+		delete[] raw_read_data_.compressed_buffer;
+		raw_read_data_.compressed_buffer = nullptr;
+		raw_read_data_.data = nullptr;
+		raw_read_data_.width = 0;
+		raw_read_data_.height = 0;
 
-			// this raw data is color;
-			raw_color_mode = IscGrabColorMode::kColorON;
-			obtained_color_mode = IscGrabColorMode::kColorON;
-		}
-		else {
-			// error
-			return CAMCONTROL_E_READ_FILE_FAILED;
+		file_read_information_.is_file_ready = false;
+
+		return CAMCONTROL_E_READ_CAMERA_MODEL;
+	}
+
+	// index (if not, use the fixed data size)
+	if (raw_file_index_->Load(file_read_information_.read_file_name, file_read_information_.raw_file_size) == DPC_E_OK) {
+		file_read_information_.play_file_information.total_frame_count = raw_file_index_->GetEntryCount();
+	}
+
+	// the file may not be closed normally or may be being written, read up to the last valid data
+	if (!file_read_information_.is_striped) {
+		file_read_information_.play_file_information.total_frame_count = RecoverReadFile();
+	}
+
+	{
+		// deug informatin
+		char msg[256] = {};
+
+		OutputDebugStringA("[INFO]IscFileReadControlImpl::Start() \n");
+		
+		OutputDebugStringA("    ");
+		OutputDebugStringW(file_read_information_.read_file_name);
+		OutputDebugStringA("\n");
+
+		__int64 one_fr_size = sizeof(raw_read_data_.isc_raw_data_header) + buff_size;
+		__int64 total_frame_count = (file_read_information_.file_size - sizeof(file_read_information_.raw_file_header)) / one_fr_size;
+		if (raw_file_index_->IsValid()) {
+			total_frame_count = raw_file_index_->GetEntryCount();
 		}
 
-		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
+		sprintf_s(msg, "    Total Frame Count=%lld\n", total_frame_count);
+		OutputDebugStringA(msg);
+
+		if (file_read_information_.file_size < file_read_information_.raw_file_size) {
+			sprintf_s(msg, "    Valid Size=%llu / File Size=%llu\n", file_read_information_.file_size, file_read_information_.raw_file_size);
+			OutputDebugStringA(msg);
 		}
+
+		OutputDebugStringA("[INFO]IscFileReadControlImpl::Start() end of message -- \n");
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 2) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 3) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+
+	// decompression threads, the index 0 is the prefetch thread
+	if (isc_thread_placement_ != nullptr) {
+		HANDLE codec_thread_handle[kISC_PLAY_DECOMPRESSION_THREAD_COUNT] = {};
+		int codec_thread_count = 0;
+		raw_data_codec_->GetThreadHandle(kISC_PLAY_DECOMPRESSION_THREAD_COUNT, codec_thread_handle, &codec_thread_count);
+		for (int i = 0; i < codec_thread_count; i++) {
+			isc_thread_placement_->Apply(IscThreadRole::kFilePlayer, i + 1, codec_thread_handle[i]);
+		}
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+
+	// decoded frame cache (kept while the same file is played)
+	// the read offset of the stripe files is not the position in one file
+	is_cache_enabled_ = play_cache_parameter_.enabled && (play_cache_parameter_.memory_budget_mb > 0) && !file_read_information_.is_striped;
+	if (is_cache_enabled_) {
+		decoded_frame_cache_->SetMemoryBudget((__int64)play_cache_parameter_.memory_budget_mb * 1024 * 1024);
+		decoded_frame_cache_->SetSource(file_read_information_.read_file_name, isc_grab_start_mode_.isc_get_color_mode);
+
+		if (StartPlayPrefetch() != DPC_E_OK) {
+			OutputDebugStringA("[WARN]IscFileReadControlImpl::Start() failed to start the prefetch\n");
+		}
 	}
 	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		decoded_frame_cache_->Clear();
 	}
 
-	file_read_information_.current_frame_number++;
+	file_read_information_.file_read_status = IscFileReadStatus::kReading;
+
 
 	return DPC_E_OK;
 }
 
 /**
- * Color を含んだRAW Dataを2個読み込みます
+ * ファイルからの読み込みを終了します
  *
- * @param[out] isc_image_info　データ
  *
  * @retval 0 成功
  * @retval other 失敗
  */
-int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
+int IscFileReadControlImpl::Stop()
 {
-	// read from file
-	DWORD bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	DWORD readed_size = 0;
 
-	// (1) first data
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	StopPlayPrefetch();
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	if (isc_thread_placement_ != nullptr) {
+		isc_thread_placement_->Remove(IscThreadRole::kFilePlayer);
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
+	UnmapReadFile();
 
-		DWORD last_err = GetLastError();
+	raw_file_stripe_->Close();
+	file_read_information_.is_striped = false;
 
+	if (file_read_information_.handle_file != NULL) {
 		CloseHandle(file_read_information_.handle_file);
 		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
-
-		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	const int frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
-
-	// 初期化
-	{
-		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
-		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+	delete[] raw_read_data_.buffer;
+	raw_read_data_.buffer = nullptr;
+	delete[] raw_read_data_.compressed_buffer;
+	raw_read_data_.compressed_buffer = nullptr;
+	raw_read_data_.data = nullptr;
+	raw_read_data_.width = 0;
+	raw_read_data_.height = 0;
 
-		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+	raw_file_index_->Clear();
 
-			ULARGE_INTEGER ul_int = {};
-			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
-			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+	memset(&file_read_information_.first_data_header, 0, sizeof(file_read_information_.first_data_header));
+	file_read_information_.follow_growing_file = false;
 
-			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+	file_read_information_.is_file_ready = false;
 
-			// debug
-			if (0) {
-				struct timespec tm = {};
-				tm.tv_sec = ul_int.QuadPart / 1000LL;
-				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+	file_read_information_.file_read_status = IscFileReadStatus::kNotReady;
 
-				struct tm ltm;
-				localtime_s(&ltm, &tm.tv_sec);
-				long millisecond = tm.tv_nsec / 1000000LL;
+	OutputDebugStringA("[INFO]IscFileReadControlImpl::Stop() \n");
 
-				char time_str[256] = {};
-				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	return DPC_E_OK;
+}
 
-				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
-					raw_read_data_.isc_raw_data_header.frame_index,
-					ltm.tm_year + 1900,
-					ltm.tm_mon + 1,
-					ltm.tm_mday,
-					dayofweek[ltm.tm_wday],
-					ltm.tm_hour,
-					ltm.tm_min,
-					ltm.tm_sec,
-					millisecond);
+/**
+ * 現在の動作モードを取得します
+ *
+ * @param[out] isc_grab_start_mode　動作モード
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::GetGrabMode(IscGrabStartMode* isc_grab_start_mode)
+{
+	isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
+	switch (file_read_information_.raw_file_header.grab_mode) {
+	case 0:
+		// ?
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
+		break;
 
-				OutputDebugStringA(time_str);
-			}
-		}
-		else {
-			isc_image_info->frame_data[frame_data_index].frame_time = 0;
-		}
+	case 1:
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
+		break;
 
-		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
-		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+	case 2:
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kCorrect;
+		break;
 
-		isc_image_info->frame_data[frame_data_index].p1.width = 0;
-		isc_image_info->frame_data[frame_data_index].p1.height = 0;
-		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+	case 3:
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kBeforeCorrect;
+		break;
 
-		isc_image_info->frame_data[frame_data_index].p2.width = 0;
-		isc_image_info->frame_data[frame_data_index].p2.height = 0;
-		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+	case 4:
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kBayerS0;
+		break;
 
-		isc_image_info->frame_data[frame_data_index].color.width = 0;
-		isc_image_info->frame_data[frame_data_index].color.height = 0;
-		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+	case 5:
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kBayerS1;
+		break;
 
-		isc_image_info->frame_data[frame_data_index].depth.width = 0;
-		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+	default:
+		isc_grab_start_mode->isc_grab_mode = IscGrabMode::kParallax;
+		break;
+	}
 
-		isc_image_info->frame_data[frame_data_index].raw.width = 0;
-		isc_image_info->frame_data[frame_data_index].raw.height = 0;
-		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+	isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorOFF;
+	switch (file_read_information_.raw_file_header.color_mode) {
+	case 0:
+		isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorOFF;
+		break;
+	case 1:
+		isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorON;
+		break;
+	default:
+		isc_grab_start_mode->isc_grab_color_mode = IscGrabColorMode::kColorOFF;
+		break;
 	}
 
-	// decode
-	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
+	isc_grab_start_mode->isc_get_mode.wait_time = isc_grab_start_mode_.isc_get_mode.wait_time;
+	isc_grab_start_mode->isc_get_raw_mode = isc_grab_start_mode_.isc_get_raw_mode;
+	isc_grab_start_mode->isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;
 
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// Colorはサポートされていない
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	isc_grab_start_mode->isc_record_mode = IscRecordMode::kRecordOff;
+	isc_grab_start_mode->isc_play_mode = IscPlayMode::kPlayOff;
+	isc_grab_start_mode->isc_play_mode_parameter.interval = 0;
+	isc_grab_start_mode->isc_play_mode_parameter.pacing_mode = isc_grab_start_mode_.isc_play_mode_parameter.pacing_mode;
+	isc_grab_start_mode->isc_play_mode_parameter.fixed_rate = isc_grab_start_mode_.isc_play_mode_parameter.fixed_rate;
+	isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file = isc_grab_start_mode_.isc_play_mode_parameter.follow_growing_file;
+	swprintf_s(isc_grab_start_mode->isc_play_mode_parameter.play_file_name, L"%s", file_read_information_.read_file_name);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 読み込みデータを取得します
+ *
+ * @param[out] isc_image_info　データ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::GetData(IscImageInfo* isc_image_info)
+{
+
+	if (!file_read_information_.is_file_ready) {
+		return CAMCONTROL_E_NO_IMAGE;
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		IscCameraModel isc_camera_model = IscCameraModel::kXC;
-		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
 
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
+	if (file_read_information_.handle_file == NULL) {
+		return CAMCONTROL_E_NO_IMAGE;
+	}
 
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+	LARGE_INTEGER read_start_counter = {};
+	QueryPerformanceCounter(&read_start_counter);
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
-			// mono
-			// Color要求に対してColorのデータではない
+	// Colorモードを確認する
+	// Color ModeがOnの場合は、mono/colorをペアで読み込み
 
-			// error
-			return CAMCONTROL_E_READ_FILE_FAILED;
+	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	if (raw_file_index_->IsValid()) {
+		// インデックスがある場合は、Entry数で終端を確認する
+		__int64 required_count = GetRequiredRecordCount(isc_grab_color_mode);
+		if ((file_read_information_.current_frame_number + required_count) > raw_file_index_->GetEntryCount()) {
+			return ReachEndOfFile();
 		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+	}
+	else if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
-		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
+		IscShutterMode isc_shutter_mode = IscShutterMode::kManualShutter;
+		switch (file_read_information_.raw_file_header.shutter_mode) {
+		case 0:
+			isc_shutter_mode = IscShutterMode::kManualShutter;
+			break;
+		case 1:
+			isc_shutter_mode = IscShutterMode::kSingleShutter;
+			break;
+		case 2:
+			isc_shutter_mode = IscShutterMode::kDoubleShutter;
+			break;
+		case 3:
+			isc_shutter_mode = IscShutterMode::kDoubleShutter2;
+			break;
+		}
+
+		if (isc_shutter_mode == IscShutterMode::kDoubleShutter) {
+			// Double Shutterの場合は、2Frame必要
+			int width = file_read_information_.raw_file_header.max_width;
+			int height = file_read_information_.raw_file_header.max_height;
+
+			size_t frame_size = width * height * 2;
+			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+
+			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size;
+			if (next_to_read >= file_read_information_.file_size) {
+				return ReachEndOfFile();
+			}
+		}
+		else {
+			int width = file_read_information_.raw_file_header.max_width;
+			int height = file_read_information_.raw_file_header.max_height;
+
+			size_t frame_size = width * height * 2;
+			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+
+			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size;
+			if (next_to_read > file_read_information_.file_size) {
+				return ReachEndOfFile();
+			}
+		}
+	}
+	else if (isc_grab_color_mode == IscGrabColorMode::kColorON) {
+		IscShutterMode isc_shutter_mode = IscShutterMode::kManualShutter;
+		switch (file_read_information_.raw_file_header.shutter_mode) {
+		case 0:
+			isc_shutter_mode = IscShutterMode::kManualShutter;
+			break;
+		case 1:
+			isc_shutter_mode = IscShutterMode::kSingleShutter;
+			break;
+		case 2:
+			isc_shutter_mode = IscShutterMode::kDoubleShutter;
+			break;
+		case 3:
+			isc_shutter_mode = IscShutterMode::kDoubleShutter2;
+			break;
+		}
+
+		if (isc_shutter_mode == IscShutterMode::kDoubleShutter) {
+			// Double Shutte & Colorrの場合は、4Frame必要
+			int width = file_read_information_.raw_file_header.max_width;
+			int height = file_read_information_.raw_file_header.max_height;
+
+			size_t frame_size = width * height * 2;
+			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+
+			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size * 4;
+			if (next_to_read > file_read_information_.file_size) {
+				return ReachEndOfFile();
+			}
+		}
+		else {
+			// Colorrの場合は、2Frame必要
+			int width = file_read_information_.raw_file_header.max_width;
+			int height = file_read_information_.raw_file_header.max_height;
+
+			size_t frame_size = width * height * 2;
+			__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+
+			unsigned __int64 next_to_read = file_read_information_.total_read_size + one_data_size * 2;
+			if (next_to_read > file_read_information_.file_size) {
+				return ReachEndOfFile();
+			}
+		}
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// setup
+	IscGrabMode isc_grab_mode = IscGrabMode::kParallax;
+	switch (file_read_information_.raw_file_header.grab_mode) {
+	case 1:
+		isc_grab_mode = IscGrabMode::kParallax;
+		break;
+
+	case 2:
+		isc_grab_mode = IscGrabMode::kCorrect;
+		break;
+
+	case 3:
+		isc_grab_mode = IscGrabMode::kBeforeCorrect;
+		break;
+
+	case 4:
+		isc_grab_mode = IscGrabMode::kBayerS0;
+		break;
+	}
+	isc_image_info->grab = isc_grab_mode;
+	isc_image_info->color_grab_mode = isc_grab_color_mode;
+
+	IscShutterMode isc_shutter_mode = IscShutterMode::kManualShutter;
+	switch (file_read_information_.raw_file_header.shutter_mode) {
+	case 0:
+		isc_shutter_mode = IscShutterMode::kManualShutter;
+		break;
+	case 1:
+		isc_shutter_mode = IscShutterMode::kSingleShutter;
+		break;
+	case 2:
+		isc_shutter_mode = IscShutterMode::kDoubleShutter;
+		break;
+	case 3:
+		isc_shutter_mode = IscShutterMode::kDoubleShutter2;
+		break;
+	}
+	isc_image_info->shutter_mode = isc_shutter_mode;
+	isc_image_info->camera_specific_parameter.d_inf = file_read_information_.raw_file_header.d_inf;
+	isc_image_info->camera_specific_parameter.bf = file_read_information_.raw_file_header.bf;
+	isc_image_info->camera_specific_parameter.base_length = file_read_information_.raw_file_header.base_length;
+	isc_image_info->camera_specific_parameter.dz = file_read_information_.raw_file_header.dz;
+
+	// 指定Frameへの移動要求の確認
+	if (file_read_information_.request_fo_designated_number) {
+		file_read_information_.request_fo_designated_number = false;
+
+		__int64 request_frame = file_read_information_.designated_number;
+
+		if ((request_frame >= 0) && (request_frame < file_read_information_.play_file_information.total_frame_count)) {
+			// 移動
+			int move_ret = MoveToSpecifyFrameNumber(request_frame);
+
+			if (move_ret != DPC_E_OK) {
+				return CAMCONTROL_E_READ_FILE_FAILED;
+			}
+
+			// 移動先から時刻を合わせ直す
+			EnterCriticalSection(&play_pacing_critical_);
+			play_pacing_.is_started = false;
+			LeaveCriticalSection(&play_pacing_critical_);
+		}
+	}
+
+	// 展開済みのFrameがあれば、読み込みと展開を行わない
+	const __int64 read_frame_number = file_read_information_.current_frame_number;
+	if (is_cache_enabled_) {
+		__int64 next_frame_number = 0;
+		unsigned __int64 next_read_offset = 0;
+
+		if (decoded_frame_cache_->Get(read_frame_number, isc_image_info, &next_frame_number, &next_read_offset)) {
+			file_read_information_.current_frame_number = next_frame_number;
+			file_read_information_.total_read_size = next_read_offset;
+			if (file_read_information_.mapped_view == nullptr) {
+				LARGE_INTEGER distance_to_move = {};
+				distance_to_move.QuadPart = (LONGLONG)next_read_offset;
+				SeekReadFile(distance_to_move, NULL, FILE_BEGIN);
+			}
+
+			RequestPlayPrefetch(next_frame_number);
+
+			// adjust the time
+			WaitPlayPacing(isc_image_info, &read_start_counter);
+
+			return DPC_E_OK;
+		}
+	}
+
+	if ((isc_shutter_mode == IscShutterMode::kManualShutter) ||
+		(isc_shutter_mode == IscShutterMode::kSingleShutter) ||
+		(isc_shutter_mode == IscShutterMode::kDoubleShutter2)) {
+
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+			int ret = ReadOneRawData(isc_image_info);
+			if (ret != DPC_E_OK) {
+				return ret;
+			}
+		}
+		else if (isc_grab_color_mode == IscGrabColorMode::kColorON) {
+			int ret = ReadColorRawData(isc_image_info);
+			if (ret != DPC_E_OK) {
+				return ret;
+			}
+		}
+		else {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if (isc_shutter_mode == IscShutterMode::kDoubleShutter) {
+		// isc_shutter_mode = IscShutterMode::kDoubleShutter
+		// 合成を行います
+
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+
+			// Frame番号が連続していないデータは、不採用とします
+
+			DPL_RESULT read_ret = DPC_E_OK;
+			while(true) {
+				read_ret = ReadDoubleShutterRawData(isc_image_info);
+				
+				if (read_ret == DPC_E_OK) {
+					break;
+				}
+				else if (read_ret == CAMCONTROL_E_READ_FILE_FAILED_RETRY) {
+					// continue
+					int width = file_read_information_.raw_file_header.max_width;
+					int height = file_read_information_.raw_file_header.max_height;
+
+					size_t frame_size = width * height * 2;
+					__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+
+					unsigned __int64 next_to_read = file_read_information_.total_read_size + (one_data_size * 2);
+					// Double Shutterの場合は、2Frame必要
+					if (next_to_read >= file_read_information_.file_size) {
+						return CAMCONTROL_E_NO_IMAGE;
+					}
+				}
+				else {
+					break;
+				}
+			}
+		}
+		else {
+			// Double shutterにおけるColor画像の取得は、以下のFPGAとSDKよりサポートされました
+			// VM	X
+			// XC	FPGA 0x28 SDK 2.8.0
+			// 4K	X
+
+			// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+			if (file_read_information_.raw_file_header.camera_model == 0) {
+				// VM
+				return CAMCONTROL_E_READ_FILE_FAILED;
+			}
+			else if (file_read_information_.raw_file_header.camera_model == 1) {
+				// XC
+				// Frame番号が連続していないデータは、不採用とします
+
+				DPL_RESULT read_ret = DPC_E_OK;
+				while (true) {
+					read_ret = ReadDoubleShutterColorRawData(isc_image_info);
+
+					if (read_ret == DPC_E_OK) {
+						break;
+					}
+					else if (read_ret == CAMCONTROL_E_READ_FILE_FAILED_RETRY) {
+						// continue
+						int width = file_read_information_.raw_file_header.max_width;
+						int height = file_read_information_.raw_file_header.max_height;
+
+						size_t frame_size = width * height * 2;
+						__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+
+						unsigned __int64 next_to_read = file_read_information_.total_read_size + (one_data_size * 4);
+						// Double Shutter;Colorの場合は、4Frame必要
+						if (next_to_read >= file_read_information_.file_size) {
+							return CAMCONTROL_E_NO_IMAGE;
+						}
+					}
+					else {
+						break;
+					}
+				}
+			}
+			else if (file_read_information_.raw_file_header.camera_model == 2) {
+				// 4K
+				return CAMCONTROL_E_READ_FILE_FAILED;
+			}
+			else if (file_read_information_.raw_file_header.camera_model == 3) {
+				return CAMCONTROL_E_READ_FILE_FAILED;
+			}
+			else if (file_read_information_.raw_file_header.camera_model == 4) {
+				return CAMCONTROL_E_READ_FILE_FAILED;
+			}
+			else {
+				return CAMCONTROL_E_READ_FILE_FAILED;
+			}
+		}
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	if (is_cache_enabled_) {
+		decoded_frame_cache_->Put(read_frame_number, isc_image_info, file_read_information_.current_frame_number, file_read_information_.total_read_size, false);
+		RequestPlayPrefetch(file_read_information_.current_frame_number);
+	}
+
+	// adjust the time
+	WaitPlayPacing(isc_image_info, &read_start_counter);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 再生の時刻合わせを初期化します
+ *
+ * @return none
+ */
+void IscFileReadControlImpl::ResetPlayPacing()
+{
+	EnterCriticalSection(&play_pacing_critical_);
+
+	play_pacing_.is_started = false;
+	play_pacing_.start_counter.QuadPart = 0;
+	play_pacing_.start_frame_time = 0;
+	play_pacing_.scheduled_count = 0;
+	play_pacing_.previous_frame_time = 0;
+
+	play_pacing_.first_counter.QuadPart = 0;
+	play_pacing_.last_counter.QuadPart = 0;
+	play_pacing_.frame_count = 0;
+	play_pacing_.late_frame_count = 0;
+	play_pacing_.read_time_total_msec = 0;
+
+	play_pacing_.recorded_interval_count = 0;
+	play_pacing_.recorded_interval_total_msec = 0;
+
+	LeaveCriticalSection(&play_pacing_critical_);
+
+	return;
+}
+
+/**
+ * 再生の方法に従って、フレームを渡す時刻まで待ちます
+ *
+ * @param[in] isc_image_info 読み込んだデータ
+ * @param[in] read_start_counter 読み込みを開始した時刻
+ * @return none
+ * @note
+ *  - kInterval:従来通り、intervalだけ待ちます
+ *  - kRealTime:記録時のframe_timeの間隔で渡します
+ *  - kFixedRate:fixed_rateの間隔で渡します
+ *  - kMaximumSpeed:待ちません 受け取り側(データ処理)が次のデータを読み込む時期を決めます
+ *  - 予定より遅れた場合は、遅れを取り戻すために連続で渡すことはせず、そのフレームを基準にします
+ */
+void IscFileReadControlImpl::WaitPlayPacing(const IscImageInfo* isc_image_info, const LARGE_INTEGER* read_start_counter)
+{
+	const IscPalyModeParameter* play_mode_parameter = &isc_grab_start_mode_.isc_play_mode_parameter;
+	const __int64 frame_time = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frame_time;
+	const double frequency = (double)play_pacing_.frequency.QuadPart;
+
+	LARGE_INTEGER now_counter = {};
+	QueryPerformanceCounter(&now_counter);
+	const double read_time_msec = (double)(now_counter.QuadPart - read_start_counter->QuadPart) * 1000.0 / frequency;
+
+	EnterCriticalSection(&play_pacing_critical_);
+
+	double wait_msec = 0;
+	bool is_late = false;
+
+	switch (play_mode_parameter->pacing_mode) {
+	case IscPlayPacingMode::kInterval:
+		wait_msec = play_mode_parameter->interval;
+		break;
+
+	case IscPlayPacingMode::kRealTime:
+		if (play_pacing_.is_started && (frame_time > 0) && (frame_time >= play_pacing_.start_frame_time)) {
+			const double scheduled_msec = (double)(frame_time - play_pacing_.start_frame_time);
+			const double elapsed_msec = (double)(now_counter.QuadPart - play_pacing_.start_counter.QuadPart) * 1000.0 / frequency;
+			wait_msec = scheduled_msec - elapsed_msec;
+
+			if (frame_time > play_pacing_.previous_frame_time) {
+				play_pacing_.recorded_interval_count++;
+				play_pacing_.recorded_interval_total_msec += (double)(frame_time - play_pacing_.previous_frame_time);
+			}
+
+			if (wait_msec < -1.0) {
+				is_late = true;
+				wait_msec = 0;
+				play_pacing_.start_counter = now_counter;
+				play_pacing_.start_frame_time = frame_time;
+			}
+		}
+		else {
+			play_pacing_.is_started = true;
+			play_pacing_.start_counter = now_counter;
+			play_pacing_.start_frame_time = frame_time;
+		}
+		play_pacing_.previous_frame_time = frame_time;
+		break;
+
+	case IscPlayPacingMode::kFixedRate:
+		if (play_pacing_.is_started) {
+			play_pacing_.scheduled_count++;
+			const double scheduled_msec = (double)play_pacing_.scheduled_count * 1000.0 / play_mode_parameter->fixed_rate;
+			const double elapsed_msec = (double)(now_counter.QuadPart - play_pacing_.start_counter.QuadPart) * 1000.0 / frequency;
+			wait_msec = scheduled_msec - elapsed_msec;
+
+			if (wait_msec < -1.0) {
+				is_late = true;
+				wait_msec = 0;
+				play_pacing_.start_counter = now_counter;
+				play_pacing_.scheduled_count = 0;
+			}
+		}
+		else {
+			play_pacing_.is_started = true;
+			play_pacing_.start_counter = now_counter;
+			play_pacing_.scheduled_count = 0;
+		}
+		break;
+
+	case IscPlayPacingMode::kMaximumSpeed:
+		break;
+
+	default:
+		break;
+	}
+
+	LeaveCriticalSection(&play_pacing_critical_);
+
+	if ((wait_msec >= 1.0) || (play_mode_parameter->pacing_mode == IscPlayPacingMode::kInterval)) {
+		Sleep((DWORD)wait_msec);
+		QueryPerformanceCounter(&now_counter);
+	}
+
+	EnterCriticalSection(&play_pacing_critical_);
+	if (play_pacing_.frame_count == 0) {
+		play_pacing_.first_counter = now_counter;
+	}
+	play_pacing_.last_counter = now_counter;
+	play_pacing_.frame_count++;
+	if (is_late) {
+		play_pacing_.late_frame_count++;
+	}
+	play_pacing_.read_time_total_msec += read_time_msec;
+	LeaveCriticalSection(&play_pacing_critical_);
+
+	return;
+}
+
+/**
+ * RAW Dataを1個読み込みます
+ *
+ * @param[out] isc_image_info　データ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::ReadOneRawData(IscImageInfo* isc_image_info)
+{
+	// read from file
+	// haeder & data
+	int read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
+
+	const int frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+
+	// 初期化
+	{
+		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
+		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+
+		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+
+			ULARGE_INTEGER ul_int = {};
+			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
+			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+
+			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+
+			// debug
+			if (0) {
+				struct timespec tm = {};
+				tm.tv_sec = ul_int.QuadPart / 1000LL;
+				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+
+				struct tm ltm;
+				localtime_s(&ltm, &tm.tv_sec);
+				long millisecond = tm.tv_nsec / 1000000LL;
+
+				char time_str[256] = {};
+				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
+					raw_read_data_.isc_raw_data_header.frame_index,
+					ltm.tm_year + 1900,
+					ltm.tm_mon + 1,
+					ltm.tm_mday,
+					dayofweek[ltm.tm_wday],
+					ltm.tm_hour,
+					ltm.tm_min,
+					ltm.tm_sec,
+					millisecond);
+
+				OutputDebugStringA(time_str);
+			}
+		}
+		else {
+			isc_image_info->frame_data[frame_data_index].frame_time = 0;
+		}
+
+		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
+		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+
+		isc_image_info->frame_data[frame_data_index].p1.width = 0;
+		isc_image_info->frame_data[frame_data_index].p1.height = 0;
+		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].p2.width = 0;
+		isc_image_info->frame_data[frame_data_index].p2.height = 0;
+		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].color.width = 0;
+		isc_image_info->frame_data[frame_data_index].color.height = 0;
+		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].depth.width = 0;
+		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+
+		isc_image_info->frame_data[frame_data_index].raw.width = 0;
+		isc_image_info->frame_data[frame_data_index].raw.height = 0;
+		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+	}
+
+	// decode
+	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
+
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		IscCameraModel isc_camera_model = IscCameraModel::kVM;
+		IscGetModeColor isc_get_color_mode = IscGetModeColor::kAwb;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+		isc_image_info->frame_data[frame_data_index].raw.height = height;
+		isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+		size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+		memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+
+		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+		obtained_color_mode = IscGrabColorMode::kColorOFF;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
+			// color
+			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
+			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
+
+			// this raw data is color;
+			raw_color_mode = IscGrabColorMode::kColorON;
+			obtained_color_mode = IscGrabColorMode::kColorON;
+		}
+		else {
+			// error
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 2) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 3) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	file_read_information_.current_frame_number++;
+
+	return DPC_E_OK;
+}
+
+/**
+ * Color を含んだRAW Dataを2個読み込みます
+ *
+ * @param[out] isc_image_info　データ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
+{
+	// read from file
+
+	// (1) first data
+	// haeder & data
+	int read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
+
+	const int frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+
+	// 初期化
+	{
+		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
+		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+
+		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+
+			ULARGE_INTEGER ul_int = {};
+			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
+			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+
+			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+
+			// debug
+			if (0) {
+				struct timespec tm = {};
+				tm.tv_sec = ul_int.QuadPart / 1000LL;
+				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+
+				struct tm ltm;
+				localtime_s(&ltm, &tm.tv_sec);
+				long millisecond = tm.tv_nsec / 1000000LL;
+
+				char time_str[256] = {};
+				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
+					raw_read_data_.isc_raw_data_header.frame_index,
+					ltm.tm_year + 1900,
+					ltm.tm_mon + 1,
+					ltm.tm_mday,
+					dayofweek[ltm.tm_wday],
+					ltm.tm_hour,
+					ltm.tm_min,
+					ltm.tm_sec,
+					millisecond);
+
+				OutputDebugStringA(time_str);
+			}
+		}
+		else {
+			isc_image_info->frame_data[frame_data_index].frame_time = 0;
+		}
+
+		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
+		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+
+		isc_image_info->frame_data[frame_data_index].p1.width = 0;
+		isc_image_info->frame_data[frame_data_index].p1.height = 0;
+		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].p2.width = 0;
+		isc_image_info->frame_data[frame_data_index].p2.height = 0;
+		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].color.width = 0;
+		isc_image_info->frame_data[frame_data_index].color.height = 0;
+		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].depth.width = 0;
+		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+
+		isc_image_info->frame_data[frame_data_index].raw.width = 0;
+		isc_image_info->frame_data[frame_data_index].raw.height = 0;
+		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+	}
+
+	// decode
+	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
+
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		// Colorはサポートされていない
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+			// mono
+			// Color要求に対してColorのデータではない
+
+			// error
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
+			// color
+			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
+			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
+
+			// this raw data is color;
+			raw_color_mode = IscGrabColorMode::kColorON;
+			obtained_color_mode = IscGrabColorMode::kColorON;
+		}
+		else {
+			// error
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 2) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 3) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	file_read_information_.current_frame_number++;
+
+	// (2) second data
+	IscGrabColorMode requested_color_mode = IscGrabColorMode::kColorOFF;
+
+	if (obtained_color_mode == IscGrabColorMode::kColorOFF) {
+		// 最初のデータがmonochroなら次はColorが必要
+		requested_color_mode = IscGrabColorMode::kColorON;
+	}
+	else {
+		// 最初のデータがColorなら次はmonochroが必要
+		requested_color_mode = IscGrabColorMode::kColorOFF;
+	}
+
+	// haeder & data
+	read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
+
+	// check mode
+	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+
+	if ((isc_grab_color_mode == IscGrabColorMode::kColorOFF) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+		// color off
+		// NG
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+		// mono
+		if (requested_color_mode == IscGrabColorMode::kColorOFF) {
+			// OK
+		}
+		else {
+			// NG
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
+		// color
+		if (requested_color_mode == IscGrabColorMode::kColorON) {
+			// OK
+		}
+		else {
+			// NG
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else {
+		// NG
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		// Colorはサポートされていない
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+
+		if ((isc_grab_color_mode == IscGrabColorMode::kColorOFF) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
+			// color
+			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
+			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
+
+			// this raw data is color;
+			raw_color_mode = IscGrabColorMode::kColorON;
+			obtained_color_mode = IscGrabColorMode::kColorON;
+		}
+		else {
+			// error
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 2) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 3) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	file_read_information_.current_frame_number++;
+
+	return DPC_E_OK;
+}
+
+/**
+ * Double Shutter を含んだRAW Dataを2個読み込みます
+ *
+ * @param[out] isc_image_info　データ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_info)
+{
+	// read from file
+
+	// (1) first data
+	// haeder & data
+	int read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
+
+	int frame_data_index = kISCIMAGEINFO_FRAMEDATA_PREVIOUS;
+
+	// 初期化
+	{
+		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
+		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+
+		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+
+			ULARGE_INTEGER ul_int = {};
+			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
+			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+
+			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+
+			// debug
+			if (0) {
+				struct timespec tm = {};
+				tm.tv_sec = ul_int.QuadPart / 1000LL;
+				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+
+				struct tm ltm;
+				localtime_s(&ltm, &tm.tv_sec);
+				long millisecond = tm.tv_nsec / 1000000LL;
+
+				char time_str[256] = {};
+				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
+					raw_read_data_.isc_raw_data_header.frame_index,
+					ltm.tm_year + 1900,
+					ltm.tm_mon + 1,
+					ltm.tm_mday,
+					dayofweek[ltm.tm_wday],
+					ltm.tm_hour,
+					ltm.tm_min,
+					ltm.tm_sec,
+					millisecond);
+
+				OutputDebugStringA(time_str);
+			}
+		}
+		else {
+			isc_image_info->frame_data[frame_data_index].frame_time = 0;
+		}
+
+		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
+		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+
+		isc_image_info->frame_data[frame_data_index].p1.width = 0;
+		isc_image_info->frame_data[frame_data_index].p1.height = 0;
+		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].p2.width = 0;
+		isc_image_info->frame_data[frame_data_index].p2.height = 0;
+		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].color.width = 0;
+		isc_image_info->frame_data[frame_data_index].color.height = 0;
+		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].depth.width = 0;
+		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+
+		isc_image_info->frame_data[frame_data_index].raw.width = 0;
+		isc_image_info->frame_data[frame_data_index].raw.height = 0;
+		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+	}
+
+	// decode
+	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
+
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		// サポートされていない
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
+			// color
+			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
+			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
+
+			// this raw data is color;
+			raw_color_mode = IscGrabColorMode::kColorON;
+			obtained_color_mode = IscGrabColorMode::kColorON;
+		}
+		else {
+			// error
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 2) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 3) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// (2) second data
+	// haeder & data
+	const unsigned __int64 second_record_position = file_read_information_.total_read_size;
+	read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
+
+	frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+
+	// 次の読み込みのために1データ分　戻す
+	LARGE_INTEGER new_pointer = {};
+
+	LARGE_INTEGER  distance_to_move = {};
+	// 圧縮時はデータ毎にサイズが異なるため、読み込み前の位置に戻します
+	distance_to_move.QuadPart = (LONGLONG)second_record_position - (LONGLONG)file_read_information_.total_read_size;
+	DWORD move_method = FILE_CURRENT;
+
+	if (!SeekReadFile(distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
+		DWORD gs_error = GetLastError();
+		char msg[64] = {};
+		sprintf_s(msg, "[ERROR]ReadDoubleShutterRawData() SetFilePointerEx error(%d)\n", gs_error);
+		OutputDebugStringA(msg);
+
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	file_read_information_.total_read_size += distance_to_move.QuadPart;
+
+	// 初期化
+	{
+		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
+		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+
+		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+
+			ULARGE_INTEGER ul_int = {};
+			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
+			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+
+			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+
+			// debug
+			if (0) {
+				struct timespec tm = {};
+				tm.tv_sec = ul_int.QuadPart / 1000LL;
+				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+
+				struct tm ltm;
+				localtime_s(&ltm, &tm.tv_sec);
+				long millisecond = tm.tv_nsec / 1000000LL;
+
+				char time_str[256] = {};
+				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
+					raw_read_data_.isc_raw_data_header.frame_index,
+					ltm.tm_year + 1900,
+					ltm.tm_mon + 1,
+					ltm.tm_mday,
+					dayofweek[ltm.tm_wday],
+					ltm.tm_hour,
+					ltm.tm_min,
+					ltm.tm_sec,
+					millisecond);
+
+				OutputDebugStringA(time_str);
+			}
+		}
+		else {
+			isc_image_info->frame_data[frame_data_index].frame_time = 0;
+		}
+
+		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
+		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+
+		isc_image_info->frame_data[frame_data_index].p1.width = 0;
+		isc_image_info->frame_data[frame_data_index].p1.height = 0;
+		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].p2.width = 0;
+		isc_image_info->frame_data[frame_data_index].p2.height = 0;
+		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].color.width = 0;
+		isc_image_info->frame_data[frame_data_index].color.height = 0;
+		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].depth.width = 0;
+		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+
+		isc_image_info->frame_data[frame_data_index].raw.width = 0;
+		isc_image_info->frame_data[frame_data_index].raw.height = 0;
+		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+	}
+
+	// decode
+	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	obtained_color_mode = isc_grab_color_mode;
+
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		// サポートされていない
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+			// mono
+			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
+			isc_image_info->frame_data[frame_data_index].raw.height = height;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
+			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
+
+			obtained_color_mode = IscGrabColorMode::kColorOFF;
+		}
+		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
 			// color
 			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
 			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
 			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
 
 			// this raw data is color;
 			raw_color_mode = IscGrabColorMode::kColorON;
@@ -1081,101 +2421,261 @@ int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
 			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
 
-		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 2) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 3) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// 合成
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		// サポートされていない
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+
+		int width = file_read_information_.raw_file_header.max_width;
+		int height = file_read_information_.raw_file_header.max_height;
+
+		// check frame number
+		int latest_frame_no = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frameNo;
+		int previous_frame_no = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_PREVIOUS].frameNo;
+
+		bool is_frame_ok = true;
+		if (latest_frame_no == 255) {
+			int diff = abs(latest_frame_no - previous_frame_no);
+			if (diff != 1) {
+				is_frame_ok = false;
+			}
+		}
+		else if (previous_frame_no == 255) {
+			int diff = abs((latest_frame_no + 256) - previous_frame_no);
+			if (diff != 1) {
+				is_frame_ok = false;
+			}
+		}
+		else {
+			int diff = abs(latest_frame_no - previous_frame_no);
+			if (diff != 1) {
+				is_frame_ok = false;
+			}
+		}
+
+		if (!is_frame_ok) {
+			// Frameが連続していない
+			//char msg[256] = {};
+			//sprintf_s(msg, "[ERROR]ReadDoubleShutterRawData() Frame numbers are not consecutive.(%d,%d)\n", latest_frame_no, previous_frame_no);
+			//OutputDebugStringA(msg);
+
+			file_read_information_.current_frame_number++;
+			return CAMCONTROL_E_READ_FILE_FAILED_RETRY;
+		}
+
+		// 初期化
+		{
+			frame_data_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+
+			isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
+			isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+
+			if (raw_read_data_.isc_raw_data_header.version >= 300) {
+
+				ULARGE_INTEGER ul_int = {};
+				ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
+				ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+
+				isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+
+				// debug
+				if (0) {
+					struct timespec tm = {};
+					tm.tv_sec = ul_int.QuadPart / 1000LL;
+					tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+
+					struct tm ltm;
+					localtime_s(&ltm, &tm.tv_sec);
+					long millisecond = tm.tv_nsec / 1000000LL;
+
+					char time_str[256] = {};
+					char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+					sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
+						raw_read_data_.isc_raw_data_header.frame_index,
+						ltm.tm_year + 1900,
+						ltm.tm_mon + 1,
+						ltm.tm_mday,
+						dayofweek[ltm.tm_wday],
+						ltm.tm_hour,
+						ltm.tm_min,
+						ltm.tm_sec,
+						millisecond);
+
+					OutputDebugStringA(time_str);
+				}
+			}
+			else {
+				isc_image_info->frame_data[frame_data_index].frame_time = 0;
+			}
+
+			isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
+			isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+			isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+			isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+
+			isc_image_info->frame_data[frame_data_index].p1.width = 0;
+			isc_image_info->frame_data[frame_data_index].p1.height = 0;
+			isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+
+			isc_image_info->frame_data[frame_data_index].p2.width = 0;
+			isc_image_info->frame_data[frame_data_index].p2.height = 0;
+			isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+
+			isc_image_info->frame_data[frame_data_index].color.width = 0;
+			isc_image_info->frame_data[frame_data_index].color.height = 0;
+			isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+
+			isc_image_info->frame_data[frame_data_index].depth.width = 0;
+			isc_image_info->frame_data[frame_data_index].depth.height = 0;
+
+			isc_image_info->frame_data[frame_data_index].raw.width = 0;
+			isc_image_info->frame_data[frame_data_index].raw.height = 0;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+		}
+
+		int ret = raw_data_decoder_->CombineImagesForDoubleShutter(isc_camera_model, width, height, isc_image_info);
 		if (ret != DPC_E_OK) {
 			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 2) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 3) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
 
 	file_read_information_.current_frame_number++;
 
-	// (2) second data
-	IscGrabColorMode requested_color_mode = IscGrabColorMode::kColorOFF;
+	return DPC_E_OK;
+}
 
-	if (obtained_color_mode == IscGrabColorMode::kColorOFF) {
-		// 最初のデータがmonochroなら次はColorが必要
-		requested_color_mode = IscGrabColorMode::kColorON;
-	}
-	else {
-		// 最初のデータがColorなら次はmonochroが必要
-		requested_color_mode = IscGrabColorMode::kColorOFF;
+/**
+ * Double Shutter とColor画像を含んだRAW Dataを2個読み込みます
+ *
+ * @param[out] isc_image_info　データ
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::ReadDoubleShutterColorRawData(IscImageInfo* isc_image_info)
+{
+	/*
+		保存データ順序
+		(Mono+視差:明)-(Color)-(Mono+視差:暗)-(Color)-(Mono+視差:明)-(Color)-
+	
+		処理順序
+		①(Mono+視差:明)を読み込んで処理
+		②(Color)を読み込んで、このデータはSkip
+		③(Mono+視差:暗)を読み込んで処理
+		④(Color)を読み込んで処理
+		⑤2個戻す
+	*/
+	
+	// read from file
+
+	// (1) first data
+	// haeder & data
+	int read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
 	}
 
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	int frame_data_index = kISCIMAGEINFO_FRAMEDATA_PREVIOUS;
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	file_read_information_.total_read_size += readed_size;
+	// 初期化
+	{
+		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
+		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
 
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
+		if (raw_read_data_.isc_raw_data_header.version >= 300) {
 
-		DWORD last_err = GetLastError();
+			ULARGE_INTEGER ul_int = {};
+			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
+			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
 
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	file_read_information_.total_read_size += readed_size;
+			// debug
+			if (0) {
+				struct timespec tm = {};
+				tm.tv_sec = ul_int.QuadPart / 1000LL;
+				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
 
-	// check mode
-	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+				struct tm ltm;
+				localtime_s(&ltm, &tm.tv_sec);
+				long millisecond = tm.tv_nsec / 1000000LL;
 
-	if ((isc_grab_color_mode == IscGrabColorMode::kColorOFF) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-		// color off
-		// NG
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-		// mono
-		if (requested_color_mode == IscGrabColorMode::kColorOFF) {
-			// OK
-		}
-		else {
-			// NG
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
-	}
-	else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
-		// color
-		if (requested_color_mode == IscGrabColorMode::kColorON) {
-			// OK
+				char time_str[256] = {};
+				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
+					raw_read_data_.isc_raw_data_header.frame_index,
+					ltm.tm_year + 1900,
+					ltm.tm_mon + 1,
+					ltm.tm_mday,
+					dayofweek[ltm.tm_wday],
+					ltm.tm_hour,
+					ltm.tm_min,
+					ltm.tm_sec,
+					millisecond);
+
+				OutputDebugStringA(time_str);
+			}
 		}
 		else {
-			// NG
-			return CAMCONTROL_E_READ_FILE_FAILED;
+			isc_image_info->frame_data[frame_data_index].frame_time = 0;
 		}
+
+		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
+		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+
+		isc_image_info->frame_data[frame_data_index].p1.width = 0;
+		isc_image_info->frame_data[frame_data_index].p1.height = 0;
+		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].p2.width = 0;
+		isc_image_info->frame_data[frame_data_index].p2.height = 0;
+		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].color.width = 0;
+		isc_image_info->frame_data[frame_data_index].color.height = 0;
+		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+
+		isc_image_info->frame_data[frame_data_index].depth.width = 0;
+		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+
+		isc_image_info->frame_data[frame_data_index].raw.width = 0;
+		isc_image_info->frame_data[frame_data_index].raw.height = 0;
+		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
 	}
-	else {
-		// NG
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
+
+	// decode
+	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
 
 	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
 	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// Colorはサポートされていない
+		// サポートされていない
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
 	else if (file_read_information_.raw_file_header.camera_model == 1) {
@@ -1187,13 +2687,13 @@ int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
 
 		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
 
-		if ((isc_grab_color_mode == IscGrabColorMode::kColorOFF) && (raw_read_data_.isc_raw_data_header.type == 1)) {
+		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
 			// mono
 			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
 			isc_image_info->frame_data[frame_data_index].raw.height = height;
 			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
 
 			obtained_color_mode = IscGrabColorMode::kColorOFF;
 		}
@@ -1203,7 +2703,7 @@ int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
 			isc_image_info->frame_data[frame_data_index].raw.height = height;
 			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
 
 			obtained_color_mode = IscGrabColorMode::kColorOFF;
 		}
@@ -1213,7 +2713,7 @@ int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
 			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
 			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
 
 			// this raw data is color;
 			raw_color_mode = IscGrabColorMode::kColorON;
@@ -1242,52 +2742,47 @@ int IscFileReadControlImpl::ReadColorRawData(IscImageInfo* isc_image_info)
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
 
-	file_read_information_.current_frame_number++;
-
-	return DPC_E_OK;
-}
+	// (2) second data (color)
+	// haeder & data
+	read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
 
-/**
- * Double Shutter を含んだRAW Dataを2個読み込みます
- *
- * @param[out] isc_image_info　データ
- *
- * @retval 0 成功
- * @retval other 失敗
- */
-int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_info)
-{
-	// read from file
-	DWORD bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	DWORD readed_size = 0;
+	frame_data_index = kISCIMAGEINFO_FRAMEDATA_PREVIOUS;
 
-	// (1) first data
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	// decode
 
+	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
+	if (file_read_information_.raw_file_header.camera_model == 0) {
+		// サポートされていない
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
-
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
-
-		DWORD last_err = GetLastError();
-
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
-
+	else if (file_read_information_.raw_file_header.camera_model == 1) {
+		// このデータは使用しません
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 2) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 3) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	else {
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	int frame_data_index = kISCIMAGEINFO_FRAMEDATA_PREVIOUS;
+	// (3) 3rd data
+	// haeder & data
+	const unsigned __int64 third_record_position = file_read_information_.total_read_size;
+	read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
+
+	frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
 
 	// 初期化
 	{
@@ -1333,7 +2828,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].frame_time = 0;
 		}
 
-		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
+		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
 		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
 		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
 		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
@@ -1359,8 +2854,8 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 	}
 
 	// decode
-	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
+	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	obtained_color_mode = isc_grab_color_mode;
 
 	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
 	if (file_read_information_.raw_file_header.camera_model == 0) {
@@ -1382,7 +2877,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].raw.height = height;
 			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
 
 			obtained_color_mode = IscGrabColorMode::kColorOFF;
 		}
@@ -1392,7 +2887,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].raw.height = height;
 			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
 
 			obtained_color_mode = IscGrabColorMode::kColorOFF;
 		}
@@ -1402,7 +2897,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
 			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
 
 			// this raw data is color;
 			raw_color_mode = IscGrabColorMode::kColorON;
@@ -1423,52 +2918,32 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 	}
 	else if (file_read_information_.raw_file_header.camera_model == 3) {
 		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-
-	// (2) second data
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
-
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	file_read_information_.total_read_size += readed_size;
-
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
-
-		DWORD last_err = GetLastError();
-
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
-
+	}
+	else if (file_read_information_.raw_file_header.camera_model == 4) {
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
+	else {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// (4) 4th data
+	// haeder & data
+	read_ret = ReadRawRecord();
+	if (read_ret != DPC_E_OK) {
+		return read_ret;
+	}
 
 	frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
 
-	// 次の読み込みのために1データ分　戻す
+	// 次の読み込みのために2データ分　戻す
 	LARGE_INTEGER new_pointer = {};
 
 	LARGE_INTEGER  distance_to_move = {};
-	distance_to_move.QuadPart = (LONGLONG)(sizeof(raw_read_data_.isc_raw_data_header) + raw_read_data_.isc_raw_data_header.data_size) * -1;
+	// 圧縮時はデータ毎にサイズが異なるため、3番目のデータの読み込み前の位置に戻します
+	distance_to_move.QuadPart = (LONGLONG)third_record_position - (LONGLONG)file_read_information_.total_read_size;
 	DWORD move_method = FILE_CURRENT;
 
-	if (!SetFilePointerEx(file_read_information_.handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
+	if (!SeekReadFile(distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
 		DWORD gs_error = GetLastError();
 		char msg[64] = {};
 		sprintf_s(msg, "[ERROR]ReadDoubleShutterRawData() SetFilePointerEx error(%d)\n", gs_error);
@@ -1479,75 +2954,6 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 
 	file_read_information_.total_read_size += distance_to_move.QuadPart;
 
-	// 初期化
-	{
-		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
-		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
-
-		if (raw_read_data_.isc_raw_data_header.version >= 300) {
-
-			ULARGE_INTEGER ul_int = {};
-			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
-			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
-
-			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
-
-			// debug
-			if (0) {
-				struct timespec tm = {};
-				tm.tv_sec = ul_int.QuadPart / 1000LL;
-				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
-
-				struct tm ltm;
-				localtime_s(&ltm, &tm.tv_sec);
-				long millisecond = tm.tv_nsec / 1000000LL;
-
-				char time_str[256] = {};
-				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
-
-				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
-					raw_read_data_.isc_raw_data_header.frame_index,
-					ltm.tm_year + 1900,
-					ltm.tm_mon + 1,
-					ltm.tm_mday,
-					dayofweek[ltm.tm_wday],
-					ltm.tm_hour,
-					ltm.tm_min,
-					ltm.tm_sec,
-					millisecond);
-
-				OutputDebugStringA(time_str);
-			}
-		}
-		else {
-			isc_image_info->frame_data[frame_data_index].frame_time = 0;
-		}
-
-		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
-		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
-
-		isc_image_info->frame_data[frame_data_index].p1.width = 0;
-		isc_image_info->frame_data[frame_data_index].p1.height = 0;
-		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
-
-		isc_image_info->frame_data[frame_data_index].p2.width = 0;
-		isc_image_info->frame_data[frame_data_index].p2.height = 0;
-		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
-
-		isc_image_info->frame_data[frame_data_index].color.width = 0;
-		isc_image_info->frame_data[frame_data_index].color.height = 0;
-		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
-
-		isc_image_info->frame_data[frame_data_index].depth.width = 0;
-		isc_image_info->frame_data[frame_data_index].depth.height = 0;
-
-		isc_image_info->frame_data[frame_data_index].raw.width = 0;
-		isc_image_info->frame_data[frame_data_index].raw.height = 0;
-		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
-	}
-
 	// decode
 	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
 	obtained_color_mode = isc_grab_color_mode;
@@ -1572,7 +2978,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].raw.height = height;
 			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
 
 			obtained_color_mode = IscGrabColorMode::kColorOFF;
 		}
@@ -1582,7 +2988,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].raw.height = height;
 			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.data, cp_size);
 
 			obtained_color_mode = IscGrabColorMode::kColorOFF;
 		}
@@ -1592,7 +2998,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
 			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
 			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.data, cp_size);
 
 			// this raw data is color;
 			raw_color_mode = IscGrabColorMode::kColorON;
@@ -1640,19 +3046,19 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 		bool is_frame_ok = true;
 		if (latest_frame_no == 255) {
 			int diff = abs(latest_frame_no - previous_frame_no);
-			if (diff != 1) {
+			if (diff != 2) {
 				is_frame_ok = false;
 			}
 		}
 		else if (previous_frame_no == 255) {
 			int diff = abs((latest_frame_no + 256) - previous_frame_no);
-			if (diff != 1) {
+			if (diff != 2) {
 				is_frame_ok = false;
 			}
 		}
 		else {
 			int diff = abs(latest_frame_no - previous_frame_no);
-			if (diff != 1) {
+			if (diff != 2) {
 				is_frame_ok = false;
 			}
 		}
@@ -1663,7 +3069,7 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 			//sprintf_s(msg, "[ERROR]ReadDoubleShutterRawData() Frame numbers are not consecutive.(%d,%d)\n", latest_frame_no, previous_frame_no);
 			//OutputDebugStringA(msg);
 
-			file_read_information_.current_frame_number++;
+			file_read_information_.current_frame_number += 2;	// ColorのFrame分も含めて進める
 			return CAMCONTROL_E_READ_FILE_FAILED_RETRY;
 		}
 
@@ -1713,1030 +3119,929 @@ int IscFileReadControlImpl::ReadDoubleShutterRawData(IscImageInfo* isc_image_inf
 				isc_image_info->frame_data[frame_data_index].frame_time = 0;
 			}
 
-			isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
-			isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-			isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-			isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
-
-			isc_image_info->frame_data[frame_data_index].p1.width = 0;
-			isc_image_info->frame_data[frame_data_index].p1.height = 0;
-			isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
-
-			isc_image_info->frame_data[frame_data_index].p2.width = 0;
-			isc_image_info->frame_data[frame_data_index].p2.height = 0;
-			isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
-
-			isc_image_info->frame_data[frame_data_index].color.width = 0;
-			isc_image_info->frame_data[frame_data_index].color.height = 0;
-			isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
-
-			isc_image_info->frame_data[frame_data_index].depth.width = 0;
-			isc_image_info->frame_data[frame_data_index].depth.height = 0;
-
-			isc_image_info->frame_data[frame_data_index].raw.width = 0;
-			isc_image_info->frame_data[frame_data_index].raw.height = 0;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
-		}
-
-		int ret = raw_data_decoder_->CombineImagesForDoubleShutter(isc_camera_model, width, height, isc_image_info);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
-	}
-
-	file_read_information_.current_frame_number++;
-
-	return DPC_E_OK;
-}
-
-/**
- * Double Shutter とColor画像を含んだRAW Dataを2個読み込みます
- *
- * @param[out] isc_image_info　データ
- *
- * @retval 0 成功
- * @retval other 失敗
- */
-int IscFileReadControlImpl::ReadDoubleShutterColorRawData(IscImageInfo* isc_image_info)
-{
-	/*
-		保存データ順序
-		(Mono+視差:明)-(Color)-(Mono+視差:暗)-(Color)-(Mono+視差:明)-(Color)-
-	
-		処理順序
-		①(Mono+視差:明)を読み込んで処理
-		②(Color)を読み込んで、このデータはSkip
-		③(Mono+視差:暗)を読み込んで処理
-		④(Color)を読み込んで処理
-		⑤2個戻す
-	*/
-	
-	// read from file
-	DWORD bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	DWORD readed_size = 0;
-
-	// (1) first data
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
-
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	file_read_information_.total_read_size += readed_size;
-
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
-
-		DWORD last_err = GetLastError();
-
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
-
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	file_read_information_.total_read_size += readed_size;
-
-	int frame_data_index = kISCIMAGEINFO_FRAMEDATA_PREVIOUS;
-
-	// 初期化
-	{
-		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
-		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
-
-		if (raw_read_data_.isc_raw_data_header.version >= 300) {
-
-			ULARGE_INTEGER ul_int = {};
-			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
-			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
-
-			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
-
-			// debug
-			if (0) {
-				struct timespec tm = {};
-				tm.tv_sec = ul_int.QuadPart / 1000LL;
-				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
-
-				struct tm ltm;
-				localtime_s(&ltm, &tm.tv_sec);
-				long millisecond = tm.tv_nsec / 1000000LL;
-
-				char time_str[256] = {};
-				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
-
-				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
-					raw_read_data_.isc_raw_data_header.frame_index,
-					ltm.tm_year + 1900,
-					ltm.tm_mon + 1,
-					ltm.tm_mday,
-					dayofweek[ltm.tm_wday],
-					ltm.tm_hour,
-					ltm.tm_min,
-					ltm.tm_sec,
-					millisecond);
-
-				OutputDebugStringA(time_str);
-			}
-		}
-		else {
-			isc_image_info->frame_data[frame_data_index].frame_time = 0;
-		}
-
-		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number;
-		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
-
-		isc_image_info->frame_data[frame_data_index].p1.width = 0;
-		isc_image_info->frame_data[frame_data_index].p1.height = 0;
-		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
-
-		isc_image_info->frame_data[frame_data_index].p2.width = 0;
-		isc_image_info->frame_data[frame_data_index].p2.height = 0;
-		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
-
-		isc_image_info->frame_data[frame_data_index].color.width = 0;
-		isc_image_info->frame_data[frame_data_index].color.height = 0;
-		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
-
-		isc_image_info->frame_data[frame_data_index].depth.width = 0;
-		isc_image_info->frame_data[frame_data_index].depth.height = 0;
-
-		isc_image_info->frame_data[frame_data_index].raw.width = 0;
-		isc_image_info->frame_data[frame_data_index].raw.height = 0;
-		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
-	}
-
-	// decode
-	IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	IscGrabColorMode obtained_color_mode = isc_grab_color_mode;
-
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// サポートされていない
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		IscCameraModel isc_camera_model = IscCameraModel::kXC;
-		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+			isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
+			isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
+			isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
+			isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
 
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
+			isc_image_info->frame_data[frame_data_index].p1.width = 0;
+			isc_image_info->frame_data[frame_data_index].p1.height = 0;
+			isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
 
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+			isc_image_info->frame_data[frame_data_index].p2.width = 0;
+			isc_image_info->frame_data[frame_data_index].p2.height = 0;
+			isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			isc_image_info->frame_data[frame_data_index].color.width = 0;
+			isc_image_info->frame_data[frame_data_index].color.height = 0;
+			isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
-		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			isc_image_info->frame_data[frame_data_index].depth.width = 0;
+			isc_image_info->frame_data[frame_data_index].depth.height = 0;
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
+			isc_image_info->frame_data[frame_data_index].raw.width = 0;
+			isc_image_info->frame_data[frame_data_index].raw.height = 0;
+			isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
 		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
-			// color
-			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
-			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
 
-			// this raw data is color;
-			raw_color_mode = IscGrabColorMode::kColorON;
-			obtained_color_mode = IscGrabColorMode::kColorON;
-		}
-		else {
-			// error
+		int ret = raw_data_decoder_->CombineImagesForDoubleShutter(isc_camera_model, width, height, isc_image_info);
+		if (ret != DPC_E_OK) {
 			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
 
-		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
+		// color
+		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorON;
+		frame_data_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+
+		isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
+		isc_image_info->frame_data[frame_data_index].raw_color.height = height;
+		isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
+		size_t cp_size = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].raw_color.width * isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].raw_color.height;
+		memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].raw_color.image, cp_size);
+
+		ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
 		if (ret != DPC_E_OK) {
 			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 2) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 3) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
 
-	// (2) second data (color)
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	file_read_information_.current_frame_number += 2;	// ColorのFrame分も含めて進める
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	return DPC_E_OK;
+}
+
+/**
+ * 読み込みファイルのヘッダー部を取得します
+ *
+ * @param[in] play_file_name ファイル名
+ * @param[out] raw_file_header　ヘッダーデータ
+ * @param[out] play_file_information 再生ファイル情報
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::GetFileInformation(wchar_t* play_file_name, IscRawFileHeader* raw_file_header, IscPlayFileInformation* play_file_information)
+{
+	if (::PathFileExists(play_file_name) && !::PathIsDirectory(play_file_name)) {
+		// 指定されたパスにファイルが存在、かつディレクトリでない -> OK
+	}
+	else {
+		// NG
+		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
+	// open file
 
-		DWORD last_err = GetLastError();
+	if (IscRawFileStripe::IsManifest(play_file_name)) {
+		// 分散されたファイルは、インデックスから取得します
+		IscRawFileStripe raw_file_stripe;
+		int ret = raw_file_stripe.Open(play_file_name);
+		if (ret != DPC_E_OK) {
+			return ret;
+		}
 
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+		DWORD readed_size = 0;
+		ret = raw_file_stripe.Read(raw_file_header, sizeof(IscRawFileHeader), &readed_size);
+		const unsigned __int64 striped_file_size = raw_file_stripe.GetSize();
+		raw_file_stripe.Close();
+		if ((ret != DPC_E_OK) || (readed_size != sizeof(IscRawFileHeader))) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		return GetFileInformationFromIndex(play_file_name, raw_file_header, striped_file_size, NULL, play_file_information);
 	}
-	file_read_information_.total_read_size += readed_size;
-
-	frame_data_index = kISCIMAGEINFO_FRAMEDATA_PREVIOUS;
-
-	// decode
 
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// サポートされていない
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		// このデータは使用しません
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 2) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 3) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	unsigned __int64 file_size = 0;
+	if (!GetDatFileSize(play_file_name, &file_size)) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
 	}
 
-	// (3) 3rd data
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	// the file may be being written
+	HANDLE handle_file;
+	if ((handle_file = CreateFile(	play_file_name,
+									GENERIC_READ,
+									FILE_SHARE_READ | FILE_SHARE_WRITE,
+									NULL,
+									OPEN_EXISTING,
+									FILE_ATTRIBUTE_NORMAL,
+									NULL)) == INVALID_HANDLE_VALUE) {
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	file_read_information_.total_read_size += readed_size;
+		DWORD gs_error = GetLastError();
+		wchar_t msg[1024] = {};
+		swprintf_s(msg, L"[ERROR]Failed to open read file(%d) %s", gs_error, play_file_name);
+		MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
 
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
-	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
 
-		DWORD last_err = GetLastError();
+	// read header
+	DWORD bytes_to_read = sizeof(IscRawFileHeader);
+	DWORD readed_size = 0;
 
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	if (FALSE == ReadFile(handle_file, raw_file_header, bytes_to_read, &readed_size, NULL)) {
+		CloseHandle(handle_file);
+		handle_file = NULL;
 
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
-
-	frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
-
-	// 初期化
-	{
-		isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
-		isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
 
-		if (raw_read_data_.isc_raw_data_header.version >= 300) {
+	// index (if not, use the fixed data size)
+	if (GetFileInformationFromIndex(play_file_name, raw_file_header, file_size, handle_file, play_file_information) == DPC_E_OK) {
+		CloseHandle(handle_file);
+		handle_file = NULL;
 
-			ULARGE_INTEGER ul_int = {};
-			ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
-			ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+		return DPC_E_OK;
+	}
 
-			isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+	int width = raw_file_header->max_width;
+	int height = raw_file_header->max_height;
 
-			// debug
-			if (0) {
-				struct timespec tm = {};
-				tm.tv_sec = ul_int.QuadPart / 1000LL;
-				tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+	size_t buff_size = width * height * 2;
+	__int64 one_fr_size = sizeof(raw_read_data_.isc_raw_data_header) + buff_size;
 
-				struct tm ltm;
-				localtime_s(&ltm, &tm.tv_sec);
-				long millisecond = tm.tv_nsec / 1000000LL;
+	// read first data
 
-				char time_str[256] = {};
-				char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	// haeder
+	IscRawDataHeader isc_raw_data_header_first = {};
 
-				sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
-					raw_read_data_.isc_raw_data_header.frame_index,
-					ltm.tm_year + 1900,
-					ltm.tm_mon + 1,
-					ltm.tm_mday,
-					dayofweek[ltm.tm_wday],
-					ltm.tm_hour,
-					ltm.tm_min,
-					ltm.tm_sec,
-					millisecond);
+	if (!ReadRawDataHeaderAt(handle_file, sizeof(IscRawFileHeader), &isc_raw_data_header_first) ||
+		!IsValidRawDataHeader(&isc_raw_data_header_first, &isc_raw_data_header_first, (int)buff_size)) {
+		// データ無し (記録の開始直後など)
+		CloseHandle(handle_file);
 
-				OutputDebugStringA(time_str);
-			}
-		}
-		else {
-			isc_image_info->frame_data[frame_data_index].frame_time = 0;
-		}
+		memset(&file_read_information_.play_file_information, 0, sizeof(file_read_information_.play_file_information));
+		memset(play_file_information, 0, sizeof(IscPlayFileInformation));
 
-		isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
-		isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-		isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-		isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+		return DPC_E_OK;
+	}
 
-		isc_image_info->frame_data[frame_data_index].p1.width = 0;
-		isc_image_info->frame_data[frame_data_index].p1.height = 0;
-		isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+	// the file may not be closed normally, find the last valid data instead of the file size
+	unsigned __int64 valid_size = 0;
+	__int64 total_frame_count = FindValidRecordCount(handle_file, raw_file_header, &isc_raw_data_header_first, (int)buff_size, file_size, 0, sizeof(IscRawFileHeader), &valid_size);
 
-		isc_image_info->frame_data[frame_data_index].p2.width = 0;
-		isc_image_info->frame_data[frame_data_index].p2.height = 0;
-		isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+	ULARGE_INTEGER ul_int_first = {};
+	ul_int_first.LowPart = isc_raw_data_header_first.frame_time_low;
+	ul_int_first.HighPart = isc_raw_data_header_first.frame_time_high;
 
-		isc_image_info->frame_data[frame_data_index].color.width = 0;
-		isc_image_info->frame_data[frame_data_index].color.height = 0;
-		isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+	/*
+	struct timespec tm_start = {};
+	tm_start.tv_sec = ul_int_first.QuadPart / 1000LL;
+	tm_start.tv_nsec = static_cast<long>((ul_int_first.QuadPart - (tm_start.tv_sec * 1000LL)) * 1000000);
+	*/
 
-		isc_image_info->frame_data[frame_data_index].depth.width = 0;
-		isc_image_info->frame_data[frame_data_index].depth.height = 0;
+	// 保存間隔を確認するために、100Frame先のフレームの時間を見る
+	__int64 test_read_frame_count = 100;
 
-		isc_image_info->frame_data[frame_data_index].raw.width = 0;
-		isc_image_info->frame_data[frame_data_index].raw.height = 0;
-		isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
-	}
+	__int64 frame_interval = 16;
 
-	// decode
-	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	obtained_color_mode = isc_grab_color_mode;
+	if (total_frame_count > test_read_frame_count) {
 
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// サポートされていない
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		IscCameraModel isc_camera_model = IscCameraModel::kXC;
-		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
+		LARGE_INTEGER new_pointer = {};
 
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
+		LARGE_INTEGER  distance_to_move = {};
+		distance_to_move.QuadPart = (LONGLONG)(sizeof(IscRawFileHeader) + one_fr_size * (test_read_frame_count - 1));
+		DWORD move_method = FILE_BEGIN;
 
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+		if (!SetFilePointerEx(handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
+			DWORD gs_error = GetLastError();
+			char msg[64] = {};
+			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
+			OutputDebugStringA(msg);
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+			CloseHandle(handle_file);
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
+			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
-		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
-			// color
-			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
-			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+		bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
+		readed_size = 0;
+		IscRawDataHeader isc_raw_data_header_test = {};
+
+		if (FALSE == ReadFile(handle_file, &isc_raw_data_header_test, bytes_to_read, &readed_size, NULL)) {
+			CloseHandle(handle_file);
 
-			// this raw data is color;
-			raw_color_mode = IscGrabColorMode::kColorON;
-			obtained_color_mode = IscGrabColorMode::kColorON;
-		}
-		else {
-			// error
 			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
 
-		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
+		ULARGE_INTEGER ul_int_test = {};
+		ul_int_test.LowPart = isc_raw_data_header_test.frame_time_low;
+		ul_int_test.HighPart = isc_raw_data_header_test.frame_time_high;
+
+		__int64 elapsed_time_msec = ul_int_test.QuadPart - ul_int_first.QuadPart;
+		frame_interval = elapsed_time_msec / test_read_frame_count;
+
+		// 現在のISCシリーズは、最大60FPSなので、小さすぎる値は補正する
+		if (frame_interval < 15) {
+			frame_interval = 16;
 		}
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 2) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 3) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
 	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		frame_interval = 16;
 	}
 
-	// (4) 4th data
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	// haeder
-	if (FALSE == ReadFile(file_read_information_.handle_file, &raw_read_data_.isc_raw_data_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	// 最後のデータまでファイルポインタを進める
+	LARGE_INTEGER new_pointer = {};
+	LARGE_INTEGER  distance_to_move = {};
+	memset(&new_pointer, 0, sizeof(LARGE_INTEGER));
+	memset(&distance_to_move, 0, sizeof(LARGE_INTEGER));
+
+	distance_to_move.QuadPart = (LONGLONG)(sizeof(IscRawFileHeader) + one_fr_size * (total_frame_count - 1));
+	DWORD move_method = FILE_BEGIN;
+
+	if (!SetFilePointerEx(handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
+		DWORD gs_error = GetLastError();
+		char msg[64] = {};
+		sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
+		OutputDebugStringA(msg);
+
+		CloseHandle(handle_file);
 
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
 
-	// data
-	bytes_to_read = raw_read_data_.isc_raw_data_header.data_size;
+	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
 	readed_size = 0;
-	if (FALSE == ReadFile(file_read_information_.handle_file, raw_read_data_.buffer, bytes_to_read, &readed_size, NULL)) {
-
-		DWORD last_err = GetLastError();
+	IscRawDataHeader isc_raw_data_header_last = {};
 
-		CloseHandle(file_read_information_.handle_file);
-		file_read_information_.handle_file = NULL;
-		file_read_information_.is_file_ready = false;
+	if (FALSE == ReadFile(handle_file, &isc_raw_data_header_last, bytes_to_read, &readed_size, NULL)) {
+		CloseHandle(handle_file);
 
 		return CAMCONTROL_E_READ_FILE_FAILED;
 	}
-	file_read_information_.total_read_size += readed_size;
-
-	frame_data_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
 
-	// 次の読み込みのために2データ分　戻す
-	LARGE_INTEGER new_pointer = {};
+	ULARGE_INTEGER ul_int_last = {};
+	ul_int_last.LowPart = isc_raw_data_header_last.frame_time_low;
+	ul_int_last.HighPart = isc_raw_data_header_last.frame_time_high;
 
-	LARGE_INTEGER  distance_to_move = {};
-	distance_to_move.QuadPart = (LONGLONG)(sizeof(raw_read_data_.isc_raw_data_header) + raw_read_data_.isc_raw_data_header.data_size) * -2;
-	DWORD move_method = FILE_CURRENT;
+	__int64 total_elapsed_time_msec = ul_int_last.QuadPart - ul_int_first.QuadPart;
 
-	if (!SetFilePointerEx(file_read_information_.handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-		DWORD gs_error = GetLastError();
-		char msg[64] = {};
-		sprintf_s(msg, "[ERROR]ReadDoubleShutterRawData() SetFilePointerEx error(%d)\n", gs_error);
-		OutputDebugStringA(msg);
+	// file information
+	file_read_information_.play_file_information.total_frame_count = total_frame_count;
+	file_read_information_.play_file_information.total_time_sec = (__int64)(total_elapsed_time_msec / (long long)1000);
+	file_read_information_.play_file_information.frame_interval = (int)frame_interval;
+	file_read_information_.play_file_information.start_time = (__int64)ul_int_first.QuadPart;
+	file_read_information_.play_file_information.end_time = (__int64)ul_int_last.QuadPart;
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
+	// ended
+	CloseHandle(handle_file);
+	handle_file = NULL;
 
-	file_read_information_.total_read_size += distance_to_move.QuadPart;
+	// copy data
+	play_file_information->total_frame_count	= file_read_information_.play_file_information.total_frame_count;
+	play_file_information->total_time_sec		= file_read_information_.play_file_information.total_time_sec;
+	play_file_information->frame_interval		= file_read_information_.play_file_information.frame_interval;
+	play_file_information->start_time			= file_read_information_.play_file_information.start_time;
+	play_file_information->end_time				= file_read_information_.play_file_information.end_time;
 
-	// decode
-	isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
-	obtained_color_mode = isc_grab_color_mode;
+	return DPC_E_OK;
+}
 
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// サポートされていない
-		return CAMCONTROL_E_READ_FILE_FAILED;
+/**
+ * 読み込みFrameを指定番号とします
+ *
+ * @param[in] frame_number 指定番号
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::SetReadFrameNumber(const __int64 frame_number)
+{
+	if (!file_read_information_.request_fo_designated_number) {
+		file_read_information_.request_fo_designated_number = true;
+		file_read_information_.designated_number = frame_number;
 	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		IscCameraModel isc_camera_model = IscCameraModel::kXC;
-		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
 
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
+	return DPC_E_OK;
+}
 
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorOFF;
+/**
+ * 読み込みFrameを指定時刻以降の最初のFrameとします
+ *
+ * @param[in] frame_time 指定時刻 (UTC msec)
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note インデックスファイルが必要です。Colorの場合はmono/colorの組の先頭に合わせます
+ */
+int IscFileReadControlImpl::SetReadFrameTime(const __int64 frame_time)
+{
+	if (!raw_file_index_->IsValid()) {
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
 
-		if (isc_grab_color_mode == IscGrabColorMode::kColorOFF) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+	__int64 entry_number = raw_file_index_->FindEntryByTime(frame_time);
+	if (entry_number < 0) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
+	// mono/colorの組の先頭はmono(type=1)
+	IscRawFileIndexEntry entry = {};
+	while (entry_number > 0) {
+		if (raw_file_index_->GetEntry(entry_number, &entry) != DPC_E_OK || entry.type == 1) {
+			break;
 		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 1)) {
-			// mono
-			isc_image_info->frame_data[frame_data_index].raw.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw.height = height;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw.width * isc_image_info->frame_data[frame_data_index].raw.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw.image, raw_read_data_.buffer, cp_size);
+		entry_number--;
+	}
 
-			obtained_color_mode = IscGrabColorMode::kColorOFF;
-		}
-		else if ((isc_grab_color_mode == IscGrabColorMode::kColorON) && (raw_read_data_.isc_raw_data_header.type == 2)) {
-			// color
-			isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
-			isc_image_info->frame_data[frame_data_index].raw_color.height = height;
-			isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
-			size_t cp_size = isc_image_info->frame_data[frame_data_index].raw_color.width * isc_image_info->frame_data[frame_data_index].raw_color.height;
-			memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, raw_read_data_.buffer, cp_size);
+	return SetReadFrameNumber(entry_number);
+}
 
-			// this raw data is color;
-			raw_color_mode = IscGrabColorMode::kColorON;
-			obtained_color_mode = IscGrabColorMode::kColorON;
-		}
-		else {
-			// error
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
+/**
+ * 指定Frameまで移動します
+ *
+ * @param[in] specify_frame_number　指定フレーム
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::MoveToSpecifyFrameNumber(const __int64 specify_frame_number)
+{
 
-		int ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 2) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 3) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 4) {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	if (file_read_information_.handle_file == NULL) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
-	else {
-		return CAMCONTROL_E_READ_FILE_FAILED;
+
+	if ((specify_frame_number < 0) || (specify_frame_number >= file_read_information_.play_file_information.total_frame_count)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
 
-	// 合成
-	// camera modesl 0:VM 1:XC 2:4K 3:4KA 4:4KJ 99:unknown
-	if (file_read_information_.raw_file_header.camera_model == 0) {
-		// サポートされていない
-		return CAMCONTROL_E_READ_FILE_FAILED;
-	}
-	else if (file_read_information_.raw_file_header.camera_model == 1) {
-		IscCameraModel isc_camera_model = IscCameraModel::kXC;
+	if (raw_file_index_->IsValid()) {
+		// インデックスの位置へ移動する
+		IscRawFileIndexEntry entry = {};
+		int ret = raw_file_index_->GetEntry(specify_frame_number, &entry);
+		if (ret != DPC_E_OK) {
+			return CAMCONTROL_E_INVALID_PARAMETER;
+		}
 
-		int width = file_read_information_.raw_file_header.max_width;
-		int height = file_read_information_.raw_file_header.max_height;
+		LARGE_INTEGER  distance_to_move = {};
+		distance_to_move.QuadPart = (LONGLONG)entry.offset;
 
-		// check frame number
-		int latest_frame_no = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frameNo;
-		int previous_frame_no = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_PREVIOUS].frameNo;
+		if (!SeekReadFile(distance_to_move, NULL, FILE_BEGIN)) {
+			DWORD gs_error = GetLastError();
+			char msg[64] = {};
+			sprintf_s(msg, "[ERROR]MoveToSpecifyFrameNumber() SetFilePointerEx error(%d)\n", gs_error);
+			OutputDebugStringA(msg);
 
-		bool is_frame_ok = true;
-		if (latest_frame_no == 255) {
-			int diff = abs(latest_frame_no - previous_frame_no);
-			if (diff != 2) {
-				is_frame_ok = false;
-			}
-		}
-		else if (previous_frame_no == 255) {
-			int diff = abs((latest_frame_no + 256) - previous_frame_no);
-			if (diff != 2) {
-				is_frame_ok = false;
-			}
-		}
-		else {
-			int diff = abs(latest_frame_no - previous_frame_no);
-			if (diff != 2) {
-				is_frame_ok = false;
-			}
+			return CAMCONTROL_E_READ_FILE_FAILED;
 		}
 
-		if (!is_frame_ok) {
-			// Frameが連続していない
-			//char msg[256] = {};
-			//sprintf_s(msg, "[ERROR]ReadDoubleShutterRawData() Frame numbers are not consecutive.(%d,%d)\n", latest_frame_no, previous_frame_no);
-			//OutputDebugStringA(msg);
+		file_read_information_.total_read_size = distance_to_move.QuadPart;
+		file_read_information_.current_frame_number = specify_frame_number;
 
-			file_read_information_.current_frame_number += 2;	// ColorのFrame分も含めて進める
-			return CAMCONTROL_E_READ_FILE_FAILED_RETRY;
-		}
+		return DPC_E_OK;
+	}
 
-		// 初期化
-		{
-			frame_data_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+	// Header
+	__int64 headr_size = sizeof(IscRawFileHeader);
 
-			isc_image_info->frame_data[frame_data_index].camera_status.error_code = raw_read_data_.isc_raw_data_header.error_code;
-			isc_image_info->frame_data[frame_data_index].camera_status.data_receive_tact_time = 0;
+	int width = file_read_information_.raw_file_header.max_width;
+	int height = file_read_information_.raw_file_header.max_height;
 
-			if (raw_read_data_.isc_raw_data_header.version >= 300) {
+	size_t frame_size = width * height * 2;
+	__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
 
-				ULARGE_INTEGER ul_int = {};
-				ul_int.LowPart = raw_read_data_.isc_raw_data_header.frame_time_low;
-				ul_int.HighPart = raw_read_data_.isc_raw_data_header.frame_time_high;
+	// move
+	LARGE_INTEGER new_pointer = {};
 
-				isc_image_info->frame_data[frame_data_index].frame_time = ul_int.QuadPart;
+	LARGE_INTEGER  distance_to_move = {};
+	distance_to_move.QuadPart = (LONGLONG)(headr_size + (one_data_size * specify_frame_number));
+	DWORD move_method = FILE_BEGIN;
 
-				// debug
-				if (0) {
-					struct timespec tm = {};
-					tm.tv_sec = ul_int.QuadPart / 1000LL;
-					tm.tv_nsec = static_cast<long>((ul_int.QuadPart - (tm.tv_sec * 1000LL)) * 1000000);
+	if (!SeekReadFile(distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
+		DWORD gs_error = GetLastError();
+		char msg[64] = {};
+		sprintf_s(msg, "[ERROR]MoveToSpecifyFrameNumber() SetFilePointerEx error(%d)\n", gs_error);
+		OutputDebugStringA(msg);
 
-					struct tm ltm;
-					localtime_s(&ltm, &tm.tv_sec);
-					long millisecond = tm.tv_nsec / 1000000LL;
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
 
-					char time_str[256] = {};
-					char dayofweek[7][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	file_read_information_.total_read_size = distance_to_move.QuadPart;
+	file_read_information_.current_frame_number = specify_frame_number;
 
-					sprintf_s(time_str, "%d: %d/%d/%d %s %02d:%02d:%02d.%03d\n",
-						raw_read_data_.isc_raw_data_header.frame_index,
-						ltm.tm_year + 1900,
-						ltm.tm_mon + 1,
-						ltm.tm_mday,
-						dayofweek[ltm.tm_wday],
-						ltm.tm_hour,
-						ltm.tm_min,
-						ltm.tm_sec,
-						millisecond);
+	return DPC_E_OK;
+}
 
-					OutputDebugStringA(time_str);
-				}
-			}
-			else {
-				isc_image_info->frame_data[frame_data_index].frame_time = 0;
-			}
 
-			isc_image_info->frame_data[frame_data_index].data_index = file_read_information_.current_frame_number + 1;
-			isc_image_info->frame_data[frame_data_index].frameNo = raw_read_data_.isc_raw_data_header.frame_index;
-			isc_image_info->frame_data[frame_data_index].gain = raw_read_data_.isc_raw_data_header.gain;
-			isc_image_info->frame_data[frame_data_index].exposure = raw_read_data_.isc_raw_data_header.exposure;
+/**
+ * 1回の読み込みに必要なデータの数を取得します
+ *
+ * @param[in] isc_grab_color_mode Colorモード
+ *
+ * @return データの数
+ */
+__int64 IscFileReadControlImpl::GetRequiredRecordCount(const IscGrabColorMode isc_grab_color_mode) const
+{
+	// Double Shutterは2Frame、Colorはmono/colorの2Frame
+	const bool is_double_shutter = (file_read_information_.raw_file_header.shutter_mode == 2);
+	__int64 required_count = is_double_shutter ? 2 : 1;
 
-			isc_image_info->frame_data[frame_data_index].p1.width = 0;
-			isc_image_info->frame_data[frame_data_index].p1.height = 0;
-			isc_image_info->frame_data[frame_data_index].p1.channel_count = 0;
+	if (isc_grab_color_mode == IscGrabColorMode::kColorON) {
+		required_count *= 2;
+	}
 
-			isc_image_info->frame_data[frame_data_index].p2.width = 0;
-			isc_image_info->frame_data[frame_data_index].p2.height = 0;
-			isc_image_info->frame_data[frame_data_index].p2.channel_count = 0;
+	return required_count;
+}
 
-			isc_image_info->frame_data[frame_data_index].color.width = 0;
-			isc_image_info->frame_data[frame_data_index].color.height = 0;
-			isc_image_info->frame_data[frame_data_index].color.channel_count = 0;
+/**
+ * インデックスファイルからファイルの情報を取得します
+ *
+ * @param[in] play_file_name ファイル名
+ * @param[in] raw_file_header ファイルのヘッダー
+ * @param[in] file_size ファイルのサイズ
+ * @param[in] handle_file 読み込みファイル (NULL:データを確認しない)
+ * @param[out] play_file_information ファイルの情報
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データを読まずに、Frame数と時間を取得します。handle_fileを指定した場合は、データが書き込まれている最後のEntryまでとします
+ */
+int IscFileReadControlImpl::GetFileInformationFromIndex(const wchar_t* play_file_name, const IscRawFileHeader* raw_file_header, const unsigned __int64 file_size, HANDLE handle_file,
+														IscPlayFileInformation* play_file_information)
+{
+	IscRawFileIndex raw_file_index;
+	int ret = raw_file_index.Load(play_file_name, file_size);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
 
-			isc_image_info->frame_data[frame_data_index].depth.width = 0;
-			isc_image_info->frame_data[frame_data_index].depth.height = 0;
+	if (handle_file != NULL) {
+		const int max_data_size = raw_file_header->max_width * raw_file_header->max_height * 2;
 
-			isc_image_info->frame_data[frame_data_index].raw.width = 0;
-			isc_image_info->frame_data[frame_data_index].raw.height = 0;
-			isc_image_info->frame_data[frame_data_index].raw.channel_count = 0;
+		IscRawDataHeader first_data_header = {};
+		if (!ReadRawDataHeaderAt(handle_file, sizeof(IscRawFileHeader), &first_data_header) ||
+			!IsValidRawDataHeader(&first_data_header, &first_data_header, max_data_size)) {
+			return CAMCONTROL_E_NO_FILE_INDEX;
 		}
 
-		int ret = raw_data_decoder_->CombineImagesForDoubleShutter(isc_camera_model, width, height, isc_image_info);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
+		raw_file_index.Truncate(FindValidIndexCount(handle_file, &raw_file_index, &first_data_header, max_data_size, 0));
+		if (!raw_file_index.IsValid()) {
+			return CAMCONTROL_E_NO_FILE_INDEX;
 		}
+	}
 
-		// color
-		IscGetModeColor isc_get_color_mode = isc_grab_start_mode_.isc_get_color_mode;// IscGetModeColor::kAwbNoCorrect;
-		IscGrabColorMode raw_color_mode = IscGrabColorMode::kColorON;
-		frame_data_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+	const __int64 total_frame_count = raw_file_index.GetEntryCount();
 
-		isc_image_info->frame_data[frame_data_index].raw_color.width = width * 2;
-		isc_image_info->frame_data[frame_data_index].raw_color.height = height;
-		isc_image_info->frame_data[frame_data_index].raw_color.channel_count = 1;
-		size_t cp_size = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].raw_color.width * isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].raw_color.height;
-		memcpy(isc_image_info->frame_data[frame_data_index].raw_color.image, isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].raw_color.image, cp_size);
+	IscRawFileIndexEntry entry_first = {};
+	IscRawFileIndexEntry entry_last = {};
+	raw_file_index.GetEntry(0, &entry_first);
+	raw_file_index.GetEntry(total_frame_count - 1, &entry_last);
 
-		ret = raw_data_decoder_->Decode(isc_camera_model, isc_image_info->grab, raw_color_mode, isc_get_color_mode, width, height, isc_image_info, frame_data_index);
-		if (ret != DPC_E_OK) {
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
+	__int64 total_elapsed_time_msec = entry_last.frame_time - entry_first.frame_time;
+
+	// 現在のISCシリーズは、最大60FPSなので、小さすぎる値は補正する
+	__int64 frame_interval = 16;
+	if (total_frame_count > 1) {
+		frame_interval = total_elapsed_time_msec / (total_frame_count - 1);
+	}
+	if (frame_interval < 15) {
+		frame_interval = 16;
 	}
 
-	file_read_information_.current_frame_number += 2;	// ColorのFrame分も含めて進める
+	// file information
+	file_read_information_.play_file_information.total_frame_count = total_frame_count;
+	file_read_information_.play_file_information.total_time_sec = (__int64)(total_elapsed_time_msec / (long long)1000);
+	file_read_information_.play_file_information.frame_interval = (int)frame_interval;
+	file_read_information_.play_file_information.start_time = entry_first.frame_time;
+	file_read_information_.play_file_information.end_time = entry_last.frame_time;
+
+	// copy data
+	play_file_information->total_frame_count	= file_read_information_.play_file_information.total_frame_count;
+	play_file_information->total_time_sec		= file_read_information_.play_file_information.total_time_sec;
+	play_file_information->frame_interval		= file_read_information_.play_file_information.frame_interval;
+	play_file_information->start_time			= file_read_information_.play_file_information.start_time;
+	play_file_information->end_time				= file_read_information_.play_file_information.end_time;
 
 	return DPC_E_OK;
 }
 
 /**
- * 読み込みファイルのヘッダー部を取得します
+ * File読み込みの状態を取得します
  *
- * @param[in] play_file_name ファイル名
- * @param[out] raw_file_header　ヘッダーデータ
- * @param[out] play_file_information 再生ファイル情報
+ * @param[out] frame_number 最後に読み込んだframe_number番号
+ * @param[out] file_read_status 読み込み状態
  *
  * @retval 0 成功
  * @retval other 失敗
  */
-int IscFileReadControlImpl::GetFileInformation(wchar_t* play_file_name, IscRawFileHeader* raw_file_header, IscPlayFileInformation* play_file_information)
+int IscFileReadControlImpl::GetFileReadStatus(__int64* frame_number, IscFileReadStatus* file_read_status)
 {
-	if (::PathFileExists(play_file_name) && !::PathIsDirectory(play_file_name)) {
-		// 指定されたパスにファイルが存在、かつディレクトリでない -> OK
+	*frame_number = -1;
+
+	// status
+	switch (file_read_information_.file_read_status) {
+	case IscFileReadStatus::kNotReady:
+		*file_read_status = IscFileReadStatus::kNotReady;
+		break;
+	case IscFileReadStatus::kReady:
+		*file_read_status = IscFileReadStatus::kReady;
+		break;
+	case IscFileReadStatus::kReading:
+		// 現在のフレーム番号を取得
+		*frame_number = file_read_information_.current_frame_number;
+		*file_read_status = IscFileReadStatus::kReading;
+		break;
+	case IscFileReadStatus::kStoped:
+		// 現在のフレーム番号を取得
+		*frame_number = file_read_information_.current_frame_number;
+		*file_read_status = IscFileReadStatus::kStoped;
+		break;
+	case IscFileReadStatus::kEnded:
+		// 現在のフレーム番号を取得
+		*frame_number = file_read_information_.current_frame_number;
+		*file_read_status = IscFileReadStatus::kEnded;
+		break;
+	default:
+		return CAMCONTROL_E_READ_FILE_FAILED;
+		break;
 	}
-	else {
-		// NG
+
+	return DPC_E_OK;
+}
+
+/**
+ * 再生開始からの再生の速度を取得します
+ *
+ * @param[out] isc_play_statistics 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理の項目は設定しません
+ */
+int IscFileReadControlImpl::GetPlayStatistics(IscPlayStatistics* isc_play_statistics)
+{
+	if (isc_play_statistics == nullptr) {
 		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
 
-	// open file
+	const IscPalyModeParameter* play_mode_parameter = &isc_grab_start_mode_.isc_play_mode_parameter;
+	const double frequency = (double)play_pacing_.frequency.QuadPart;
 
-	unsigned __int64 file_size = 0;
-	if (!GetDatFileSize(play_file_name, &file_size)) {
-		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	EnterCriticalSection(&play_pacing_critical_);
+
+	isc_play_statistics->pacing_mode = play_mode_parameter->pacing_mode;
+	isc_play_statistics->frame_count = play_pacing_.frame_count;
+	isc_play_statistics->late_frame_count = play_pacing_.late_frame_count;
+
+	isc_play_statistics->elapsed_time_msec = 0;
+	isc_play_statistics->achieved_fps = 0;
+	if (play_pacing_.frame_count > 1) {
+		isc_play_statistics->elapsed_time_msec = (double)(play_pacing_.last_counter.QuadPart - play_pacing_.first_counter.QuadPart) * 1000.0 / frequency;
+		if (isc_play_statistics->elapsed_time_msec > 0) {
+			isc_play_statistics->achieved_fps = (double)(play_pacing_.frame_count - 1) * 1000.0 / isc_play_statistics->elapsed_time_msec;
+		}
 	}
 
-	HANDLE handle_file;
-	if ((handle_file = CreateFile(	play_file_name,
-									GENERIC_READ,
-									FILE_SHARE_READ,
-									NULL,
-									OPEN_EXISTING,
-									FILE_ATTRIBUTE_NORMAL,
-									NULL)) == INVALID_HANDLE_VALUE) {
+	isc_play_statistics->read_time_average_msec = (play_pacing_.frame_count > 0) ? play_pacing_.read_time_total_msec / (double)play_pacing_.frame_count : 0;
 
-		DWORD gs_error = GetLastError();
-		wchar_t msg[1024] = {};
-		swprintf_s(msg, L"[ERROR]Failed to open read file(%d) %s", gs_error, play_file_name);
-		MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
+	isc_play_statistics->target_fps = 0;
+	switch (play_mode_parameter->pacing_mode) {
+	case IscPlayPacingMode::kInterval:
+		if (play_mode_parameter->interval > 0) {
+			isc_play_statistics->target_fps = 1000.0 / (double)play_mode_parameter->interval;
+		}
+		break;
+	case IscPlayPacingMode::kRealTime:
+		if (play_pacing_.recorded_interval_total_msec > 0) {
+			isc_play_statistics->target_fps = (double)play_pacing_.recorded_interval_count * 1000.0 / play_pacing_.recorded_interval_total_msec;
+		}
+		break;
+	case IscPlayPacingMode::kFixedRate:
+		isc_play_statistics->target_fps = play_mode_parameter->fixed_rate;
+		break;
+	default:
+		break;
+	}
+
+	LeaveCriticalSection(&play_pacing_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 展開済みFrameの保持の方法を設定します
+ *
+ * @param[in] isc_play_cache_parameter 設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の再生の開始から適用します
+ */
+int IscFileReadControlImpl::SetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter)
+{
+	if (isc_play_cache_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
 
-		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	if ((isc_play_cache_parameter->memory_budget_mb < 0) ||
+		(isc_play_cache_parameter->prefetch_ahead_count < 0) || (isc_play_cache_parameter->prefetch_behind_count < 0)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
 
-	// read header
-	DWORD bytes_to_read = sizeof(IscRawFileHeader);
-	DWORD readed_size = 0;
+	play_cache_parameter_ = *isc_play_cache_parameter;
 
-	if (FALSE == ReadFile(handle_file, raw_file_header, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(handle_file);
-		handle_file = NULL;
+	return DPC_E_OK;
+}
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+/**
+ * 展開済みFrameの保持の方法を取得します
+ *
+ * @param[out] isc_play_cache_parameter 設定
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::GetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter)
+{
+	if (isc_play_cache_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
 	}
 
-	int width = raw_file_header->max_width;
-	int height = raw_file_header->max_height;
-
-	size_t buff_size = width * height * 2;
-	__int64 one_fr_size = sizeof(raw_read_data_.isc_raw_data_header) + buff_size;
-	__int64 total_frame_count = (file_size - sizeof(file_read_information_.raw_file_header)) / one_fr_size;
+	*isc_play_cache_parameter = play_cache_parameter_;
 
-	// read first data
+	return DPC_E_OK;
+}
 
-	// haeder
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	IscRawDataHeader isc_raw_data_header_first = {};
+/**
+ * 展開済みFrameの保持の状態を取得します
+ *
+ * @param[out] isc_play_cache_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileReadControlImpl::GetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status)
+{
+	if (isc_play_cache_status == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
 
-	if (FALSE == ReadFile(handle_file, &isc_raw_data_header_first, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(handle_file);
+	memset(isc_play_cache_status, 0, sizeof(IscPlayCacheStatus));
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+	if (decoded_frame_cache_ == nullptr) {
+		return CAMCONTROL_E_INVALID_REQUEST;
 	}
 
-	ULARGE_INTEGER ul_int_first = {};
-	ul_int_first.LowPart = isc_raw_data_header_first.frame_time_low;
-	ul_int_first.HighPart = isc_raw_data_header_first.frame_time_high;
+	decoded_frame_cache_->GetStatus(isc_play_cache_status);
 
-	/*
-	struct timespec tm_start = {};
-	tm_start.tv_sec = ul_int_first.QuadPart / 1000LL;
-	tm_start.tv_nsec = static_cast<long>((ul_int_first.QuadPart - (tm_start.tv_sec * 1000LL)) * 1000000);
-	*/
+	return DPC_E_OK;
+}
 
-	// 保存間隔を確認するために、100Frame先のフレームの時間を見る
-	__int64 test_read_frame_count = 100;
+/**
+ * 先読みと展開のThreadに適用する配置を設定します
+ *
+ * @param[in] isc_thread_placement 配置
+ * @return none.
+ * @note 再生開始時に適用します
+ */
+void IscFileReadControlImpl::SetThreadPlacement(IscThreadPlacement* isc_thread_placement)
+{
+	isc_thread_placement_ = isc_thread_placement;
 
-	__int64 frame_interval = 16;
+	return;
+}
 
-	if (total_frame_count > test_read_frame_count) {
+/**
+ * 先読みを開始します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 同じファイルを別に開き、再生の位置の前後のFrameを展開して保持します
+ */
+int IscFileReadControlImpl::StartPlayPrefetch()
+{
+	StopPlayPrefetch();
 
-		LARGE_INTEGER new_pointer = {};
+	if ((play_cache_parameter_.prefetch_ahead_count <= 0) && (play_cache_parameter_.prefetch_behind_count <= 0)) {
+		return DPC_E_OK;
+	}
 
-		LARGE_INTEGER  distance_to_move = {};
-		distance_to_move.QuadPart = (LONGLONG)(sizeof(IscRawFileHeader) + one_fr_size * (test_read_frame_count - 1));
-		DWORD move_method = FILE_BEGIN;
+	// the reader for the prefetch does not wait and does not follow the file
+	IscGrabStartMode isc_grab_start_mode = isc_grab_start_mode_;
+	isc_grab_start_mode.isc_play_mode_parameter.pacing_mode = IscPlayPacingMode::kMaximumSpeed;
+	isc_grab_start_mode.isc_play_mode_parameter.follow_growing_file = false;
 
-		if (!SetFilePointerEx(handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
+	play_prefetch_.reader = new IscFileReadControlImpl;
+	play_prefetch_.reader->Initialize(&isc_camera_control_config_);
 
-			CloseHandle(handle_file);
+	int ret = play_prefetch_.reader->Start(&isc_grab_start_mode);
+	if (ret != DPC_E_OK) {
+		play_prefetch_.reader->Terminate();
+		delete play_prefetch_.reader;
+		play_prefetch_.reader = nullptr;
 
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
+		return ret;
+	}
 
-		bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-		readed_size = 0;
-		IscRawDataHeader isc_raw_data_header_test = {};
+	IscDecodedFrameCache::AllocateImageInfo(file_read_information_.raw_file_header.max_width, file_read_information_.raw_file_header.max_height, &play_prefetch_.isc_image_info);
 
-		if (FALSE == ReadFile(handle_file, &isc_raw_data_header_test, bytes_to_read, &readed_size, NULL)) {
-			CloseHandle(handle_file);
+	const IscGrabColorMode isc_grab_color_mode = (file_read_information_.raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+	play_prefetch_.stride = GetRequiredRecordCount(isc_grab_color_mode);
+	play_prefetch_.request_frame_number = file_read_information_.current_frame_number;
+	play_prefetch_.terminate_request = 0;
+	play_prefetch_.terminate_done = 0;
 
-			return CAMCONTROL_E_READ_FILE_FAILED;
-		}
+	play_prefetch_.handle_event = CreateEvent(NULL, FALSE, FALSE, NULL);
 
-		ULARGE_INTEGER ul_int_test = {};
-		ul_int_test.LowPart = isc_raw_data_header_test.frame_time_low;
-		ul_int_test.HighPart = isc_raw_data_header_test.frame_time_high;
+	if ((play_prefetch_.thread_handle = (HANDLE)_beginthreadex(0, 0, PlayPrefetchThread, (void*)this, 0, 0)) == 0) {
+		StopPlayPrefetch();
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
 
-		__int64 elapsed_time_msec = ul_int_test.QuadPart - ul_int_first.QuadPart;
-		frame_interval = elapsed_time_msec / test_read_frame_count;
+	// the decode in the background must not delay the play
+	SetThreadPriority(play_prefetch_.thread_handle, THREAD_PRIORITY_BELOW_NORMAL);
 
-		// 現在のISCシリーズは、最大60FPSなので、小さすぎる値は補正する
-		if (frame_interval < 15) {
-			frame_interval = 16;
+	if (isc_thread_placement_ != nullptr) {
+		isc_thread_placement_->Apply(IscThreadRole::kFilePlayer, 0, play_prefetch_.thread_handle);
+
+		// the decompression threads of the prefetch follow those of the play
+		HANDLE codec_thread_handle[kISC_PLAY_DECOMPRESSION_THREAD_COUNT] = {};
+		int codec_thread_count = 0;
+		play_prefetch_.reader->raw_data_codec_->GetThreadHandle(kISC_PLAY_DECOMPRESSION_THREAD_COUNT, codec_thread_handle, &codec_thread_count);
+		for (int i = 0; i < codec_thread_count; i++) {
+			isc_thread_placement_->Apply(IscThreadRole::kFilePlayer, kISC_PLAY_DECOMPRESSION_THREAD_COUNT + 1 + i, codec_thread_handle[i]);
 		}
 	}
-	else {
-		frame_interval = 16;
-	}
-
-	// 最後のデータまでファイルポインタを進める
-	LARGE_INTEGER new_pointer = {};
-	LARGE_INTEGER  distance_to_move = {};
-	memset(&new_pointer, 0, sizeof(LARGE_INTEGER));
-	memset(&distance_to_move, 0, sizeof(LARGE_INTEGER));
 
-	distance_to_move.QuadPart = (LONGLONG)(sizeof(IscRawFileHeader) + one_fr_size * (total_frame_count - 1));
-	DWORD move_method = FILE_BEGIN;
+	SetEvent(play_prefetch_.handle_event);
 
-	if (!SetFilePointerEx(handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-		DWORD gs_error = GetLastError();
-		char msg[64] = {};
-		sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-		OutputDebugStringA(msg);
+	return DPC_E_OK;
+}
 
-		CloseHandle(handle_file);
+/**
+ * 先読みを終了します
+ *
+ * @return none
+ */
+void IscFileReadControlImpl::StopPlayPrefetch()
+{
+	if (play_prefetch_.thread_handle != NULL) {
+		play_prefetch_.terminate_request = 1;
+		SetEvent(play_prefetch_.handle_event);
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		WaitForSingleObject(play_prefetch_.thread_handle, INFINITE);
+		CloseHandle(play_prefetch_.thread_handle);
+		play_prefetch_.thread_handle = NULL;
 	}
 
-	bytes_to_read = sizeof(raw_read_data_.isc_raw_data_header);
-	readed_size = 0;
-	IscRawDataHeader isc_raw_data_header_last = {};
+	if (play_prefetch_.handle_event != NULL) {
+		CloseHandle(play_prefetch_.handle_event);
+		play_prefetch_.handle_event = NULL;
+	}
 
-	if (FALSE == ReadFile(handle_file, &isc_raw_data_header_last, bytes_to_read, &readed_size, NULL)) {
-		CloseHandle(handle_file);
+	if (play_prefetch_.reader != nullptr) {
+		play_prefetch_.reader->Stop();
+		play_prefetch_.reader->Terminate();
+		delete play_prefetch_.reader;
+		play_prefetch_.reader = nullptr;
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+		IscDecodedFrameCache::ReleaseImageInfo(&play_prefetch_.isc_image_info);
 	}
 
-	ULARGE_INTEGER ul_int_last = {};
-	ul_int_last.LowPart = isc_raw_data_header_last.frame_time_low;
-	ul_int_last.HighPart = isc_raw_data_header_last.frame_time_high;
-
-	__int64 total_elapsed_time_msec = ul_int_last.QuadPart - ul_int_first.QuadPart;
+	return;
+}
 
-	// file information
-	file_read_information_.play_file_information.total_frame_count = total_frame_count;
-	file_read_information_.play_file_information.total_time_sec = (__int64)(total_elapsed_time_msec / (long long)1000);
-	file_read_information_.play_file_information.frame_interval = (int)frame_interval;
-	file_read_information_.play_file_information.start_time = (__int64)ul_int_first.QuadPart;
-	file_read_information_.play_file_information.end_time = (__int64)ul_int_last.QuadPart;
+/**
+ * 先読みの基準を移動します
+ *
+ * @param[in] frame_number 次に読み込むデータの番号
+ * @return none
+ */
+void IscFileReadControlImpl::RequestPlayPrefetch(const __int64 frame_number)
+{
+	if (play_prefetch_.thread_handle == NULL) {
+		return;
+	}
 
-	// ended
-	CloseHandle(handle_file);
-	handle_file = NULL;
+	EnterCriticalSection(&play_prefetch_critical_);
+	play_prefetch_.request_frame_number = frame_number;
+	LeaveCriticalSection(&play_prefetch_critical_);
 
-	// copy data
-	play_file_information->total_frame_count	= file_read_information_.play_file_information.total_frame_count;
-	play_file_information->total_time_sec		= file_read_information_.play_file_information.total_time_sec;
-	play_file_information->frame_interval		= file_read_information_.play_file_information.frame_interval;
-	play_file_information->start_time			= file_read_information_.play_file_information.start_time;
-	play_file_information->end_time				= file_read_information_.play_file_information.end_time;
+	SetEvent(play_prefetch_.handle_event);
 
-	return DPC_E_OK;
+	return;
 }
 
 /**
- * 読み込みFrameを指定番号とします
- *
- * @param[in] frame_number 指定番号
+ * 先読みの基準が移動したか確認します
  *
- * @retval 0 成功
- * @retval other 失敗
+ * @param[in] frame_number 先読み中の基準
+ * @retval true 移動した
+ * @retval false 移動していない
  */
-int IscFileReadControlImpl::SetReadFrameNumber(const __int64 frame_number)
+bool IscFileReadControlImpl::IsPlayPrefetchMoved(const __int64 frame_number)
 {
-	if (!file_read_information_.request_fo_designated_number) {
-		file_read_information_.request_fo_designated_number = true;
-		file_read_information_.designated_number = frame_number;
-	}
+	EnterCriticalSection(&play_prefetch_critical_);
+	const bool is_moved = (play_prefetch_.request_frame_number != frame_number);
+	LeaveCriticalSection(&play_prefetch_critical_);
 
-	return DPC_E_OK;
+	return is_moved;
 }
 
 /**
- * 指定Frameまで移動します
- *
- * @param[in] specify_frame_number　指定フレーム
+ * 指定のFrameを先読みします
  *
+ * @param[in] frame_number 読み込みを開始するデータの番号
+ * @param[out] next_frame_number 読み込み後のデータの番号
  * @retval 0 成功
  * @retval other 失敗
  */
-int IscFileReadControlImpl::MoveToSpecifyFrameNumber(const __int64 specify_frame_number)
+int IscFileReadControlImpl::PrefetchOneFrame(const __int64 frame_number, __int64* next_frame_number)
 {
+	IscFileReadControlImpl* reader = play_prefetch_.reader;
 
-	if (file_read_information_.handle_file == NULL) {
-		return CAMCONTROL_E_INVALID_PARAMETER;
+	// move directly, GetData() checks the end of the file before the requested frame
+	int ret = reader->MoveToSpecifyFrameNumber(frame_number);
+	if (ret != DPC_E_OK) {
+		return ret;
 	}
 
-	if ((specify_frame_number < 0) && (specify_frame_number >= file_read_information_.play_file_information.total_frame_count)) {
-		return CAMCONTROL_E_INVALID_PARAMETER;
+	ret = reader->GetData(&play_prefetch_.isc_image_info);
+	if (ret != DPC_E_OK) {
+		return ret;
 	}
 
-	// Header
-	__int64 headr_size = sizeof(IscRawFileHeader);
+	*next_frame_number = reader->file_read_information_.current_frame_number;
 
-	int width = file_read_information_.raw_file_header.max_width;
-	int height = file_read_information_.raw_file_header.max_height;
+	return decoded_frame_cache_->Put(frame_number, &play_prefetch_.isc_image_info, *next_frame_number, reader->file_read_information_.total_read_size, true);
+}
 
-	size_t frame_size = width * height * 2;
-	__int64 one_data_size = sizeof(raw_read_data_.isc_raw_data_header) + frame_size;
+/**
+ * 先読み 処理本体
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 再生の順に先のFrameを、続いて前のFrameを展開します。基準が移動した場合は、新しい基準からやり直します
+ */
+int IscFileReadControlImpl::PlayPrefetchProc()
+{
+	while (play_prefetch_.terminate_request == 0) {
+		WaitForSingleObject(play_prefetch_.handle_event, INFINITE);
+		if (play_prefetch_.terminate_request != 0) {
+			break;
+		}
 
-	// move
-	LARGE_INTEGER new_pointer = {};
+		EnterCriticalSection(&play_prefetch_critical_);
+		const __int64 base_frame_number = play_prefetch_.request_frame_number;
+		LeaveCriticalSection(&play_prefetch_critical_);
 
-	LARGE_INTEGER  distance_to_move = {};
-	distance_to_move.QuadPart = (LONGLONG)(headr_size + (one_data_size * specify_frame_number));
-	DWORD move_method = FILE_BEGIN;
+		const __int64 stride = play_prefetch_.stride;
+		const __int64 total_frame_count = play_prefetch_.reader->file_read_information_.play_file_information.total_frame_count;
 
-	if (!SetFilePointerEx(file_read_information_.handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-		DWORD gs_error = GetLastError();
-		char msg[64] = {};
-		sprintf_s(msg, "[ERROR]MoveToSpecifyFrameNumber() SetFilePointerEx error(%d)\n", gs_error);
-		OutputDebugStringA(msg);
+		// ahead
+		__int64 frame_number = base_frame_number;
+		for (int i = 0; i < play_cache_parameter_.prefetch_ahead_count; i++) {
+			if ((play_prefetch_.terminate_request != 0) || IsPlayPrefetchMoved(base_frame_number) || (frame_number >= total_frame_count)) {
+				break;
+			}
 
-		return CAMCONTROL_E_READ_FILE_FAILED;
+			__int64 next_frame_number = 0;
+			if (!decoded_frame_cache_->Contains(frame_number, &next_frame_number)) {
+				if (PrefetchOneFrame(frame_number, &next_frame_number) != DPC_E_OK) {
+					break;
+				}
+			}
+
+			if (next_frame_number <= frame_number) {
+				break;
+			}
+			frame_number = next_frame_number;
+		}
+
+		// behind (base_frame_number - stride is the current frame)
+		for (int i = 1; i <= play_cache_parameter_.prefetch_behind_count; i++) {
+			frame_number = base_frame_number - stride * (i + 1);
+			if ((play_prefetch_.terminate_request != 0) || IsPlayPrefetchMoved(base_frame_number) || (frame_number < 0)) {
+				break;
+			}
+
+			__int64 next_frame_number = 0;
+			if (!decoded_frame_cache_->Contains(frame_number, &next_frame_number)) {
+				if (PrefetchOneFrame(frame_number, &next_frame_number) != DPC_E_OK) {
+					break;
+				}
+			}
+		}
 	}
 
-	file_read_information_.total_read_size = distance_to_move.QuadPart;
-	file_read_information_.current_frame_number = specify_frame_number;
+	play_prefetch_.terminate_done = 1;
 
 	return DPC_E_OK;
 }
 
-
 /**
- * File読み込みの状態を取得します
- *
- * @param[out] frame_number 最後に読み込んだframe_number番号
- * @param[out] file_read_status 読み込み状態
+ * 先読みThread
  *
+ * @param[in] context Threadパラメータ
  * @retval 0 成功
  * @retval other 失敗
  */
-int IscFileReadControlImpl::GetFileReadStatus(__int64* frame_number, IscFileReadStatus* file_read_status)
+unsigned __stdcall IscFileReadControlImpl::PlayPrefetchThread(void* context)
 {
-	*frame_number = -1;
+	IscFileReadControlImpl* isc_file_read_control = (IscFileReadControlImpl*)context;
 
-	// status
-	switch (file_read_information_.file_read_status) {
-	case IscFileReadStatus::kNotReady:
-		*file_read_status = IscFileReadStatus::kNotReady;
-		break;
-	case IscFileReadStatus::kReady:
-		*file_read_status = IscFileReadStatus::kReady;
-		break;
-	case IscFileReadStatus::kReading:
-		// 現在のフレーム番号を取得
-		*frame_number = file_read_information_.current_frame_number;
-		*file_read_status = IscFileReadStatus::kReading;
-		break;
-	case IscFileReadStatus::kStoped:
-		// 現在のフレーム番号を取得
-		*frame_number = file_read_information_.current_frame_number;
-		*file_read_status = IscFileReadStatus::kStoped;
-		break;
-	case IscFileReadStatus::kEnded:
-		// 現在のフレーム番号を取得
-		*frame_number = file_read_information_.current_frame_number;
-		*file_read_status = IscFileReadStatus::kEnded;
-		break;
-	default:
-		return CAMCONTROL_E_READ_FILE_FAILED;
-		break;
+	if (isc_file_read_control == nullptr) {
+		return -1;
 	}
 
-	return DPC_E_OK;
-}
+	int ret = isc_file_read_control->PlayPrefetchProc();
 
+	return ret;
+}
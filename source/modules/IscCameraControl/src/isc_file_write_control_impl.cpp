@@ -37,8 +37,13 @@
 #include "isc_camera_def.h"
 #include "isc_log.h"
 #include "utility.h"
+#include "isc_thread_placement.h"
 
 #include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
 
 #include "isc_file_write_control_impl.h"
 
@@ -48,8 +53,11 @@
  *
  */
 IscFileWriteControlImpl::IscFileWriteControlImpl():
-	isc_camera_control_config_(), isc_save_data_configuration_(), camera_width_(0), camera_height_(0), isc_image_info_ring_buffer_(nullptr), isc_log_(nullptr), utility_measure_time_(nullptr),
-	file_write_speed_info_(), file_write_information_(), thread_control_(), handle_semaphore_(NULL), thread_handle_(NULL), threads_critical_()
+	isc_camera_control_config_(), isc_save_data_configuration_(), camera_width_(0), camera_height_(0), isc_image_info_ring_buffer_(nullptr), isc_log_(nullptr), utility_measure_time_(nullptr), raw_file_index_(nullptr),
+	record_compression_parameter_(), raw_data_codec_(nullptr), compressed_buffer_(nullptr), compressed_buffer_size_(0), compression_statistics_(),
+	record_write_parameter_(), async_file_writer_(nullptr), write_statistics_(),
+	file_write_speed_info_(), file_write_information_(), thread_control_(), handle_semaphore_(NULL), thread_handle_(NULL), threads_critical_(),
+	isc_thread_placement_(nullptr)
 {
 
 }
@@ -206,15 +214,31 @@ int IscFileWriteControlImpl::Initialize(const IscCameraControlConfiguration* isc
 	*/
 	file_write_information_.initial_size = 2i64 * 1024i64 * 1024i64 * 1024i64;	
 
-	file_write_information_.handle_file = NULL;
 	file_write_information_.is_file_ready = false;
 	file_write_information_.frame_index = 0;
 	memset(&file_write_information_.raw_file_hedaer, 0, sizeof(file_write_information_.raw_file_hedaer));
+	file_write_information_.write_offset = 0;
 
-	// get buffer
+	// index
+	raw_file_index_ = new IscRawFileIndex;
+
+	// compression (off)
+	record_compression_parameter_.enabled = false;
+	record_compression_parameter_.thread_count = 2;
+	memset(&compression_statistics_, 0, sizeof(compression_statistics_));
+
+	// writer
+	async_file_writer_ = new IscAsyncFileWriter;
+	record_write_parameter_.batch_size = 4 * 1024;		// 4MB
+	record_write_parameter_.request_count = 4;
+	record_write_parameter_.direct_io = false;
+	record_write_parameter_.striping_mode = IscRecordStripingMode::kStripingOff;
+	memset(&write_statistics_, 0, sizeof(write_statistics_));
+
+	// get buffer (FIFO, all data is written in order and the queue absorbs the delay of the disk)
 	isc_image_info_ring_buffer_ = new IscImageInfoRingBuffer;
 	const int max_buffer_count = isc_save_data_configuration_.max_buffer_count;	// 16;
-	isc_image_info_ring_buffer_->Initialize(true, true, max_buffer_count, camera_width_, camera_height_);
+	isc_image_info_ring_buffer_->Initialize(false, false, max_buffer_count, camera_width_, camera_height_);
 	isc_image_info_ring_buffer_->Clear();
 
 	// for check speed
@@ -231,9 +255,7 @@ int IscFileWriteControlImpl::Initialize(const IscCameraControlConfiguration* isc
 	thread_control_.stop_request = false;
 
 	// initalize semaphore
-	char semaphoreName[64] = {};
-	sprintf_s(semaphoreName, "THREAD_SEMAPHORENAME_ISCCAMERAERITW%d", 0);
-	handle_semaphore_ = CreateSemaphoreA(NULL, 0, 8, semaphoreName);
+	handle_semaphore_ = CreateSemaphoreA(NULL, 0, max_buffer_count, NULL);
 	if (handle_semaphore_ == NULL) {
 		// Fail
 		swprintf_s(logMag, L"failed to create semaphore\n");
@@ -271,6 +293,18 @@ int IscFileWriteControlImpl::Terminate()
 	delete utility_measure_time_;
 	utility_measure_time_ = nullptr;
 
+	if (raw_file_index_ != nullptr) {
+		raw_file_index_->Close();
+		delete raw_file_index_;
+		raw_file_index_ = nullptr;
+	}
+
+	if (async_file_writer_ != nullptr) {
+		async_file_writer_->Terminate();
+		delete async_file_writer_;
+		async_file_writer_ = nullptr;
+	}
+
 	isc_log_ = nullptr;
 
 	return DPC_E_OK;
@@ -411,6 +445,53 @@ int IscFileWriteControlImpl::Start(const IscCameraSpecificParameter* camera_spec
 	// write speed check
 	file_write_speed_info_.Start();
 
+	// compression
+	EnterCriticalSection(&threads_critical_);
+	memset(&compression_statistics_, 0, sizeof(compression_statistics_));
+	IscRecordCompressionParameter record_compression_parameter = record_compression_parameter_;
+	LeaveCriticalSection(&threads_critical_);
+
+	file_write_information_.raw_file_hedaer.compression = record_compression_parameter.enabled ? 1 : 0;
+
+	if (record_compression_parameter.enabled) {
+		const int max_width = camera_width_ * 2;
+		raw_data_codec_ = new IscRawDataCodec;
+		int ret = raw_data_codec_->Initialize(record_compression_parameter.thread_count, max_width, camera_height_);
+		if (ret != DPC_E_OK) {
+			delete raw_data_codec_;
+			raw_data_codec_ = nullptr;
+			return ret;
+		}
+
+		compressed_buffer_size_ = IscRawDataCodec::GetMaxCompressedSize(max_width, camera_height_);
+		compressed_buffer_ = new unsigned char[compressed_buffer_size_];
+
+		if (isc_thread_placement_ != nullptr) {
+			HANDLE codec_thread_handle[kISC_RECORD_COMPRESSION_MAX_THREAD_COUNT] = {};
+			int codec_thread_count = 0;
+			raw_data_codec_->GetThreadHandle(kISC_RECORD_COMPRESSION_MAX_THREAD_COUNT, codec_thread_handle, &codec_thread_count);
+			for (int i = 0; i < codec_thread_count; i++) {
+				isc_thread_placement_->Apply(IscThreadRole::kFileWriter, i + 1, codec_thread_handle[i]);
+			}
+		}
+	}
+
+	// writer
+	EnterCriticalSection(&threads_critical_);
+	memset(&write_statistics_, 0, sizeof(write_statistics_));
+	IscRecordWriteParameter record_write_parameter = record_write_parameter_;
+	LeaveCriticalSection(&threads_critical_);
+
+	int batch_size = ((record_write_parameter.batch_size + 63) / 64) * 64 * 1024;
+	int ret_writer = async_file_writer_->Initialize(batch_size, record_write_parameter.request_count, record_write_parameter.direct_io);
+	if (ret_writer != DPC_E_OK) {
+		return ret_writer;
+	}
+	isc_image_info_ring_buffer_->Clear();
+
+	file_write_information_.striping_mode = record_write_parameter.striping_mode;
+	file_write_information_.is_striped = false;
+
 	// clear thread control
 	thread_control_.terminate_request = 0;
 	thread_control_.terminate_done = 0;
@@ -430,6 +511,10 @@ int IscFileWriteControlImpl::Start(const IscCameraSpecificParameter* camera_spec
 	// THREAD_PRIORITY_BELOW_NORMAL -1
 	SetThreadPriority(thread_handle_, THREAD_PRIORITY_BELOW_NORMAL);
 
+	if (isc_thread_placement_ != nullptr) {
+		isc_thread_placement_->Apply(IscThreadRole::kFileWriter, 0, thread_handle_);
+	}
+
 	return DPC_E_OK;
 }
 
@@ -515,8 +600,25 @@ int IscFileWriteControlImpl::Add(IscImageInfo* isc_image_info)
 		}
 
 		image_status = 1;
+	}
+
+	isc_image_info_ring_buffer_->DonePutBuffer(put_index, image_status);
+
+	EnterCriticalSection(&threads_critical_);
+	if (image_status == 1) {
+		write_statistics_.queue_depth++;
+		if (write_statistics_.queue_depth > write_statistics_.max_queue_depth) {
+			write_statistics_.max_queue_depth = write_statistics_.queue_depth;
+		}
+	}
+	else {
+		// queue is full
+		write_statistics_.dropped_frame_count++;
+	}
+	LeaveCriticalSection(&threads_critical_);
 
-		// start processing thread
+	if (image_status == 1) {
+		// start processing thread (after the data is ready)
 		BOOL result_release = ReleaseSemaphore(handle_semaphore_, 1, NULL);
 		if (!result_release) {
 			// over flow 
@@ -528,8 +630,6 @@ int IscFileWriteControlImpl::Add(IscImageInfo* isc_image_info)
 		}
 	}
 
-	isc_image_info_ring_buffer_->DonePutBuffer(put_index, image_status);
-
 	return DPC_E_OK;
 }
 
@@ -539,6 +639,7 @@ int IscFileWriteControlImpl::Add(IscImageInfo* isc_image_info)
  *
  * @retval 0 成功
  * @retval other 失敗
+ * @note 書き込みThreadは終了前に発行済みの書き込みを全て完了させるため、Threadの終了を待ってから解放します
  */
 int IscFileWriteControlImpl::Stop()
 {
@@ -555,24 +656,252 @@ int IscFileWriteControlImpl::Stop()
 		// release any resources
 		ReleaseSemaphore(handle_semaphore_, 1, NULL);
 
-		int count = 0;
-		while (thread_control_.terminate_done == 0) {
-			if (count > 100) {
-				break;
-			}
-			count++;
-			Sleep(10L);
-		}
+		// the thread drains all in-flight writes before it ends, it can take long on a slow disk
+		WaitForSingleObject(thread_handle_, INFINITE);
 
 		if (thread_handle_ != NULL) {
 			CloseHandle(thread_handle_);
 			thread_handle_ = NULL;
 		}
+
+		if (isc_thread_placement_ != nullptr) {
+			isc_thread_placement_->Remove(IscThreadRole::kFileWriter);
+		}
+	}
+
+	if (raw_data_codec_ != nullptr) {
+		raw_data_codec_->Terminate();
+		delete raw_data_codec_;
+		raw_data_codec_ = nullptr;
 	}
+	delete[] compressed_buffer_;
+	compressed_buffer_ = nullptr;
+	compressed_buffer_size_ = 0;
+
+	async_file_writer_->Terminate();
 
 	return DPC_E_OK;
 }
 
+/**
+ * 書き込みThreadに適用する配置を設定します
+ *
+ * @param[in] isc_thread_placement 配置
+ * @return none.
+ * @note 書き込み開始時に適用します
+ */
+void IscFileWriteControlImpl::SetThreadPlacement(IscThreadPlacement* isc_thread_placement)
+{
+	isc_thread_placement_ = isc_thread_placement;
+
+	return;
+}
+
+/**
+ * 圧縮のパラメータを設定します
+ *
+ * @param[in] isc_record_compression_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 書き込み開始時に適用します
+ */
+int IscFileWriteControlImpl::SetCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+	if (isc_record_compression_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if ((isc_record_compression_parameter->thread_count < 1) || (isc_record_compression_parameter->thread_count > kISC_RECORD_COMPRESSION_MAX_THREAD_COUNT)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	EnterCriticalSection(&threads_critical_);
+	record_compression_parameter_ = *isc_record_compression_parameter;
+	LeaveCriticalSection(&threads_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 圧縮のパラメータを取得します
+ *
+ * @param[out] isc_record_compression_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileWriteControlImpl::GetCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+	if (isc_record_compression_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	EnterCriticalSection(&threads_critical_);
+	*isc_record_compression_parameter = record_compression_parameter_;
+	LeaveCriticalSection(&threads_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 書き込み開始からの圧縮の結果を取得します
+ *
+ * @param[out] isc_record_compression_statistics 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileWriteControlImpl::GetCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics)
+{
+	if (isc_record_compression_statistics == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	EnterCriticalSection(&threads_critical_);
+	CompressionStatistics compression_statistics = compression_statistics_;
+	LeaveCriticalSection(&threads_critical_);
+
+	memset(isc_record_compression_statistics, 0, sizeof(IscRecordCompressionStatistics));
+	isc_record_compression_statistics->data_count = compression_statistics.data_count;
+	isc_record_compression_statistics->uncompressed_count = compression_statistics.uncompressed_count;
+	isc_record_compression_statistics->raw_bytes = compression_statistics.raw_bytes;
+	isc_record_compression_statistics->written_bytes = compression_statistics.written_bytes;
+
+	if (compression_statistics.written_bytes > 0) {
+		isc_record_compression_statistics->compression_ratio = (double)compression_statistics.raw_bytes / (double)compression_statistics.written_bytes;
+	}
+	if (compression_statistics.data_count > 0) {
+		isc_record_compression_statistics->average_time_msec = compression_statistics.total_time_msec / (double)compression_statistics.data_count;
+	}
+	if (compression_statistics.total_time_msec > 0.0) {
+		isc_record_compression_statistics->throughput_mb_per_sec = ((double)compression_statistics.raw_bytes / (1024.0 * 1024.0)) / (compression_statistics.total_time_msec / 1000.0);
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * 書き込みのパラメータを設定します
+ *
+ * @param[in] isc_record_write_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 書き込み開始時に適用します
+ */
+int IscFileWriteControlImpl::SetWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter)
+{
+	if (isc_record_write_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if ((isc_record_write_parameter->batch_size < 64) || (isc_record_write_parameter->batch_size > 65536) ||
+		(isc_record_write_parameter->request_count < 1) || (isc_record_write_parameter->request_count > kISC_RECORD_WRITE_MAX_REQUEST_COUNT)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	EnterCriticalSection(&threads_critical_);
+	record_write_parameter_ = *isc_record_write_parameter;
+	LeaveCriticalSection(&threads_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 書き込みのパラメータを取得します
+ *
+ * @param[out] isc_record_write_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileWriteControlImpl::GetWriteParameter(IscRecordWriteParameter* isc_record_write_parameter)
+{
+	if (isc_record_write_parameter == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	EnterCriticalSection(&threads_critical_);
+	*isc_record_write_parameter = record_write_parameter_;
+	LeaveCriticalSection(&threads_critical_);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 書き込み開始からの書き込みの結果を取得します
+ *
+ * @param[out] isc_record_write_statistics 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscFileWriteControlImpl::GetWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics)
+{
+	if (isc_record_write_statistics == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	memset(isc_record_write_statistics, 0, sizeof(IscRecordWriteStatistics));
+
+	EnterCriticalSection(&threads_critical_);
+	isc_record_write_statistics->frame_count = write_statistics_.frame_count;
+	isc_record_write_statistics->dropped_frame_count = write_statistics_.dropped_frame_count;
+	isc_record_write_statistics->queue_depth = write_statistics_.queue_depth;
+	isc_record_write_statistics->max_queue_depth = write_statistics_.max_queue_depth;
+	LeaveCriticalSection(&threads_critical_);
+
+	async_file_writer_->GetStatistics(isc_record_write_statistics);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 圧縮が有効な場合は、データを圧縮します
+ *
+ * @param[in] image データ
+ * @param[in] width 幅(byte)
+ * @param[in] height 高さ
+ * @param[out] write_data 書き込むデータ
+ * @param[out] write_size 書き込むサイズ
+ * @param[out] compressed 0:圧縮なし 1:圧縮
+ * @return none
+ * @note 圧縮できない、または小さくならない場合は、元のデータをそのまま書き込みます
+ */
+void IscFileWriteControlImpl::CompressRawData(const unsigned char* image, const int width, const int height, const unsigned char** write_data, int* write_size, int* compressed)
+{
+	*write_data = image;
+	*write_size = width * height;
+	*compressed = 0;
+
+	if (raw_data_codec_ == nullptr) {
+		return;
+	}
+
+	LARGE_INTEGER frequency = {}, start = {}, end = {};
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&start);
+
+	int compressed_size = 0;
+	int ret = raw_data_codec_->Compress(image, width, height, compressed_buffer_, compressed_buffer_size_, &compressed_size);
+
+	QueryPerformanceCounter(&end);
+	const double elapsed_time_msec = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)frequency.QuadPart;
+
+	if ((ret == DPC_E_OK) && (compressed_size > 0)) {
+		*write_data = compressed_buffer_;
+		*write_size = compressed_size;
+		*compressed = 1;
+	}
+
+	EnterCriticalSection(&threads_critical_);
+	compression_statistics_.data_count++;
+	if (*compressed == 0) {
+		compression_statistics_.uncompressed_count++;
+	}
+	compression_statistics_.raw_bytes += (__int64)width * height;
+	compression_statistics_.written_bytes += *write_size;
+	compression_statistics_.total_time_msec += elapsed_time_msec;
+	LeaveCriticalSection(&threads_critical_);
+
+	return;
+}
+
 /**
  * threadの動作状態を取得します
  *
@@ -612,16 +941,16 @@ int IscFileWriteControlImpl::PrepareFileforWriting(FileWriteInformation* file_wr
 		return ret;
 	}
 
-	__int64 number_of_write_to_file = sizeof(IscRawFileHeader);
-	__int64 number_of_byteswritten = 0i64;
-	ret = WriteDataToFile(file_write_information->handle_file, (LPCVOID)&file_write_information->raw_file_hedaer, number_of_write_to_file, &number_of_byteswritten, NULL);
+	ret = async_file_writer_->Write(&file_write_information->raw_file_hedaer, sizeof(IscRawFileHeader));
 	if (ret != DPC_E_OK) {
-		swprintf_s(logMag, L"WriteDataToFile() error(%d)\n", ret);
+		swprintf_s(logMag, L"Write() error(%d)\n", ret);
 		isc_log_->LogError(L"IscFileWriteControlImpl::PrepareFileforWriting", logMag);
 
 		return ret;
 	}
 
+	OpenFileIndex(file_write_information);
+
 	file_write_information->frame_index = 0;
 	file_write_information->is_file_ready = true;
 
@@ -629,81 +958,52 @@ int IscFileWriteControlImpl::PrepareFileforWriting(FileWriteInformation* file_wr
 }
 
 /**
- * ファイルの特権昇格処理を行います
+ * 書き込みファイルのインデックスを作成します
  *
- * @param[in] privilege_name 特権名を取得するシステムの名前
- * @param[in] enabled LUID の属性を指定します true:SE_PRIVILEGE_ENABLED(特権が有効)
- * @retval 0 成功
- * @retval other 失敗
+ * @param[in] file_write_information 書き込みファイルの情報です
+ * @return none
+ * @note インデックスが作成できなくても、データの保存は継続します
  */
-HRESULT IscFileWriteControlImpl::EnablePrivilege(const wchar_t* privilege_name, const BOOL enabled)
+void IscFileWriteControlImpl::OpenFileIndex(FileWriteInformation* file_write_information)
 {
-	BOOL ret = FALSE;
+	wchar_t logMag[128] = {};
 
-	HANDLE handle_token;
+	file_write_information->write_offset = sizeof(IscRawFileHeader);
 
-	/*
-		open the access token associated with the process
-	*/
-	ret = ::OpenProcessToken(
-								GetCurrentProcess()
-								, 0
-								//          | TOKEN_ASSIGN_PRIMARY
-								//          | TOKEN_DUPLICATE
-								//          | TOKEN_IMPERSONATE
-								| TOKEN_QUERY
-								//          | TOKEN_QUERY_SOURCE
-								| TOKEN_ADJUST_PRIVILEGES
-								//          | TOKEN_ADJUST_GROUPS
-								//          | TOKEN_ADJUST_DEFAULT
-								//          | TOKEN_ADJUST_SESSIONID
-								, &handle_token);
-
-	if (0 == ret) {
-		// error
-		return(::HRESULT_FROM_WIN32(::GetLastError()));
+	int ret = raw_file_index_->Open(file_write_information->write_file_name);
+	if (ret != DPC_E_OK) {
+		swprintf_s(logMag, L"failed to create file index(0X%08X)\n", ret);
+		isc_log_->LogError(L"IscFileWriteControlImpl::OpenFileIndex", logMag);
 	}
 
-	LUID tLuid;
+	return;
+}
 
-	/*
-		Get the Locally Unique Identifier (LUID) used by the specified system
-	*/
-	ret = LookupPrivilegeValue(NULL, privilege_name, &tLuid);
-	if (0 == ret) {
-		// error
-		DWORD last_error = ::GetLastError();
-		::CloseHandle(handle_token);
-		return(::HRESULT_FROM_WIN32(last_error));
-	}
+/**
+ * 書き込んだデータをインデックスに追加します
+ *
+ * @param[in] file_write_information 書き込みファイルの情報です
+ * @param[in] isc_raw_data_header 書き込んだデータのヘッダー
+ * @return none
+ */
+void IscFileWriteControlImpl::AddFileIndexEntry(FileWriteInformation* file_write_information, const IscRawDataHeader* isc_raw_data_header)
+{
+	ULARGE_INTEGER ul_int = {};
+	ul_int.LowPart = isc_raw_data_header->frame_time_low;
+	ul_int.HighPart = isc_raw_data_header->frame_time_high;
 
-	TOKEN_PRIVILEGES token_privileges;
-	token_privileges.PrivilegeCount = 1;
-	token_privileges.Privileges[0].Luid = tLuid;
-	token_privileges.Privileges[0].Attributes = (FALSE != enabled) ? SE_PRIVILEGE_ENABLED : 0;
+	IscRawFileIndexEntry entry = {};
+	entry.offset = file_write_information->write_offset;
+	entry.frame_time = (__int64)ul_int.QuadPart;
+	entry.frame_index = isc_raw_data_header->frame_index;
+	entry.data_size = isc_raw_data_header->data_size;
+	entry.type = isc_raw_data_header->type;
 
-	/*
-		Set privileges within the specified access token
-	*/
-	ret = ::AdjustTokenPrivileges(
-									handle_token
-									, FALSE
-									, &token_privileges
-									, sizeof(token_privileges)
-									, NULL
-									, NULL
-	);
-	if (0 == ret) {
-		// error
-		DWORD last_error = ::GetLastError();
-		::CloseHandle(handle_token);
-		return(::HRESULT_FROM_WIN32(last_error));
-	}
+	raw_file_index_->Add(&entry);
 
-	// close the token handle
-	::CloseHandle(handle_token);
+	file_write_information->write_offset += isc_raw_data_header->header_size + isc_raw_data_header->data_size;
 
-	return(S_OK);
+	return;
 }
 
 /**
@@ -717,132 +1017,15 @@ int IscFileWriteControlImpl::CreateWriteFile(FileWriteInformation* file_write_in
 {
 	wchar_t logMag[128] = {};
 
-	// create file
-	if ((file_write_information->handle_file = CreateFile(	file_write_information->write_file_name,
-															GENERIC_WRITE,
-															FILE_SHARE_READ,
-															NULL,
-															CREATE_ALWAYS,
-															FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
-															NULL)) == INVALID_HANDLE_VALUE) {
+	// create file (the disk space is reserved without extending the end of file)
+	int ret = OpenWriteFile(file_write_information);
+	if (ret != DPC_E_OK) {
 		DWORD gs_error = GetLastError();
-		//wchar_t msg[64] = {};
-		//swprintf_s(msg, L"[ERROR]CreateWriteFile() error(%d) %s", gs_error, file_write_information->write_file_name);
-		//MessageBox(NULL, msg, L"IscFileWriteControlImpl::CreateWriteFile()", MB_ICONERROR);
 
 		swprintf_s(logMag, L"CreateWriteFile() error(%d) %s\n", gs_error, file_write_information->write_file_name);
 		isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
 
-		return CAMCONTROL_E_CREATE_SAVE_FILE;
-	}
-
-
-	// pre allocate file
-	if (file_write_information->initial_size > 0) {
-		LARGE_INTEGER new_pointer = {};
-
-		LARGE_INTEGER  distance_to_move = {};
-		distance_to_move.QuadPart = (LONGLONG)file_write_information->initial_size;
-		DWORD move_method = FILE_BEGIN;
-
-		// 先までファイルポインタを進める
-		if (!SetFilePointerEx(file_write_information->handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-		
-		// EOFを設定
-		if (!SetEndOfFile(file_write_information->handle_file)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetEndOfFile error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetEndOfFile error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE; 
-		}
-
-		// Enable privilege ( SE_MANAGE_VOLUME_NAME )
-		DWORD hr_result = EnablePrivilege(SE_MANAGE_VOLUME_NAME, TRUE);
-		if (hr_result != S_OK) {
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() EnablePrivilege error(%d)\n", hr_result);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() EnablePrivilege error(%d)\n", hr_result);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-
-		// 先頭までファイルポインタを移動
-		distance_to_move.QuadPart = (LONGLONG)0;
-		if (!SetFilePointerEx(file_write_information->handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-
-		// EOFの位置までを有効なデータとする
-		/*
-			私は、SetFileValidDataで発生するエラー（1314)を解決できません。
-			そのため、初めの書き込みでパフォーマンスが低下します。
-			将来において、これを解決する予定です。
-			I can't resolve the error (1314) I get with SetFileValidData.
-			So the first write will have poor performance.
-			We plan to resolve this in the future.
-		*/
-		/*
-		if (!SetFileValidData(file_write_information->handle_file, (LONGLONG)file_write_information->initial_size)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-		*/
-
-		// 先頭までファイルポインタを移動
-		distance_to_move.QuadPart = (LONGLONG)0;
-		if (!SetFilePointerEx(file_write_information->handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
+		return ret;
 	}
 
 	return DPC_E_OK;
@@ -867,16 +1050,16 @@ int IscFileWriteControlImpl::PrepareNewFileforWriting(FileWriteInformation* file
 		return ret;
 	}
 
-	__int64 number_of_write_to_file = sizeof(IscRawFileHeader);
-	__int64 number_of_byteswritten = 0i64;
-	ret = WriteDataToFile(file_write_information->handle_file, (LPCVOID)&file_write_information->raw_file_hedaer, number_of_write_to_file, &number_of_byteswritten, NULL);
+	ret = async_file_writer_->Write(&file_write_information->raw_file_hedaer, sizeof(IscRawFileHeader));
 	if (ret != DPC_E_OK) {
-		swprintf_s(logMag, L"WriteDataToFile() error(%d)\n", ret);
+		swprintf_s(logMag, L"Write() error(%d)\n", ret);
 		isc_log_->LogError(L"IscFileWriteControlImpl::PrepareNewFileforWriting", logMag);
 
 		return ret;
 	}
 
+	OpenFileIndex(file_write_information);
+
 	file_write_information->frame_index = 0;
 	//file_write_information->is_file_ready = true;
 
@@ -895,20 +1078,14 @@ int IscFileWriteControlImpl::CreateNewWriteFile(FileWriteInformation* file_write
 	// 現在のファイルを閉じて新しいファイルにする
 	wchar_t logMag[128] = {};
 
-	// close file to write
-	if (file_write_information->handle_file != NULL) {
-		// truncate Pre-Allocated disk space
-		SetEndOfFile(file_write_information->handle_file);
-
-		CloseHandle(file_write_information->handle_file);
-		file_write_information->handle_file = NULL;
-	}
+	// close file to write (truncate Pre-Allocated disk space)
+	async_file_writer_->Close();
 
 	// new file
 
-	// 空き容量の確認
+	// 空き容量の確認 (分散する場合はOpenWriteFile()で確認します)
 	int index = file_write_information->current_folder_index;
-	bool is_ok = CheckDiskFreeSpace(file_write_information->write_folder[index], file_write_information->minimum_capacity_required);
+	bool is_ok = file_write_information->is_striped ? true : CheckDiskFreeSpace(file_write_information->write_folder[index], file_write_information->minimum_capacity_required);
 
 	if (!is_ok) {
 		swprintf_s(logMag, L"Your current disk is out of free space. %s\n", file_write_information->write_folder[index]);
@@ -952,131 +1129,53 @@ int IscFileWriteControlImpl::CreateNewWriteFile(FileWriteInformation* file_write
 	index = file_write_information->current_folder_index;
 	swprintf_s(file_write_information->write_file_name, L"%s\\%s.dat", file_write_information->write_folder[index], date_time_name);
 
-	// create file
-	if ((file_write_information->handle_file = CreateFile(	file_write_information->write_file_name,
-															GENERIC_WRITE,
-															FILE_SHARE_READ,
-															NULL,
-															CREATE_ALWAYS,
-															FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
-															NULL)) == INVALID_HANDLE_VALUE) {
+	// create file (the disk space is reserved without extending the end of file)
+	int ret = OpenWriteFile(file_write_information);
+	if (ret != DPC_E_OK) {
 		DWORD gs_error = GetLastError();
-		//wchar_t msg[64] = {};
-		//swprintf_s(msg, L"[ERROR]CreateWriteFile() error(%d) %s", gs_error, file_write_information->write_file_name);
-		//MessageBox(NULL, msg, L"IscFileWriteControlImpl::CreateNewWriteFile()", MB_ICONERROR);
 
 		swprintf_s(logMag, L"CreateWriteFile() error(%d) %s\n", gs_error, file_write_information->write_file_name);
 		isc_log_->LogError(L"IscFileWriteControlImpl::CreateNewWriteFile", logMag);
 
-		return CAMCONTROL_E_CREATE_SAVE_FILE;
+		return ret;
 	}
 
+	return DPC_E_OK;
+}
 
-	// pre allocate file
-	if (file_write_information->initial_size > 0) {
-		LARGE_INTEGER new_pointer = {};
-
-		LARGE_INTEGER  distance_to_move = {};
-		distance_to_move.QuadPart = (LONGLONG)file_write_information->initial_size;
-		DWORD move_method = FILE_BEGIN;
-
-		// 先までファイルポインタを進める
-		if (!SetFilePointerEx(file_write_information->handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-
-		// EOFを設定
-		if (!SetEndOfFile(file_write_information->handle_file)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetEndOfFile error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetEndOfFile error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-
-		// Enable privilege ( SE_MANAGE_VOLUME_NAME )
-		DWORD hr_result = EnablePrivilege(SE_MANAGE_VOLUME_NAME, TRUE);
-		if (hr_result != S_OK) {
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() EnablePrivilege error(%d)\n", hr_result);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() EnablePrivilege error(%d)\n", hr_result);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
-
-		// 先頭までファイルポインタを移動
-		distance_to_move.QuadPart = (LONGLONG)0;
-		if (!SetFilePointerEx(file_write_information->handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
+/**
+ * ディスクの空き容量を確認します
+ *
+ * @param[in] file_write_information 確認用のパラメータ
+ * @retval 0 成功
+ * @retval other 失敗/保存できない
+ */
+int IscFileWriteControlImpl::CheckFreeSpace(FileWriteInformation* file_write_information)
+{
+	if (file_write_information->is_striped) {
+		// 空き容量に応じて分散先を更新します
+		return UpdateStripeWeight(file_write_information);
+	}
 
-			swprintf_s(logMag, L"CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
+	// 空き容量の確認
+	int index = file_write_information->current_folder_index;
+	bool is_ok = CheckDiskFreeSpace(file_write_information->write_folder[index], file_write_information->minimum_capacity_required);
 
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
-		}
+	if (!is_ok) {
+		// 次のフォルダ
+		if (file_write_information->current_folder_index < (file_write_information->target_folder_count - 1)) {
+			file_write_information->current_folder_index++;
 
-		// EOFの位置までを有効なデータとする
-		/*
-			私は、SetFileValidDataで発生するエラー（1314)を解決できません。
-			そのため、初めの書き込みでパフォーマンスが低下します。
-			将来において、これを解決する予定です。
-			I can't resolve the error (1314) I get with SetFileValidData.
-			So the first write will have poor performance.
-			We plan to resolve this in the future.
-		*/
-		/*
-		if (!SetFileValidData(file_write_information->handle_file, (LONGLONG)file_write_information->initial_size)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
+			index = file_write_information->current_folder_index;
+			bool is_ok2 = CheckDiskFreeSpace(file_write_information->write_folder[index], file_write_information->minimum_capacity_required);
+			if (!is_ok) {
+				// 保存できない
+				return CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE;
+			}
 		}
-		*/
-
-		// 先頭までファイルポインタを移動
-		distance_to_move.QuadPart = (LONGLONG)0;
-		if (!SetFilePointerEx(file_write_information->handle_file, distance_to_move, (PLARGE_INTEGER)&new_pointer, move_method)) {
-			DWORD gs_error = GetLastError();
-			char msg[64] = {};
-			sprintf_s(msg, "[ERROR]CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			OutputDebugStringA(msg);
-
-			swprintf_s(logMag, L"CreateWriteFile() SetFilePointerEx error(%d)\n", gs_error);
-			isc_log_->LogError(L"IscFileWriteControlImpl::CreateWriteFile", logMag);
-
-			CloseHandle(file_write_information->handle_file);
-			file_write_information->handle_file = NULL;
-			return CAMCONTROL_E_CREATE_SAVE_FILE;
+		else {
+			// 保存できない
+			return CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE;
 		}
 	}
 
@@ -1084,69 +1183,82 @@ int IscFileWriteControlImpl::CreateNewWriteFile(FileWriteInformation* file_write
 }
 
 /**
- * ファイル書き込みを行います
+ * 書き込みファイルを開きます
  *
- * @param[in] handle_file 書き込みファイルハンドル
- * @param[in] buffer 書き込みデータバッファー
- * @param[in] number_of_write_to_file 書き込みバイト数
- * @param[out] number_of_byteswritten 実際に書き込んだバイト数
- * @param[in] overlapped Overlap構造体(=NULLで呼び出すこと)
+ * @param[in] file_write_information 書き込みファイルの情報です
  * @retval 0 成功
  * @retval other 失敗
+ * @note 分散が有効で保存先が複数ある場合は、保存先ごとにファイルを作成し、write_file_nameにはマニフェストを作成します
  */
-int IscFileWriteControlImpl::WriteDataToFile(HANDLE handle_file, LPCVOID buffer, __int64 number_of_write_to_file, __int64* number_of_byteswritten, LPOVERLAPPED overlapped)
+int IscFileWriteControlImpl::OpenWriteFile(FileWriteInformation* file_write_information)
 {
-	if (handle_file == NULL) {
-		return CAMCONTROL_E_WRITE_FAILED;
-	}
-	
-	DWORD number_of_write = (DWORD)number_of_write_to_file;
-	DWORD number_of_written = 0;
+	file_write_information->is_striped = false;
 
-	BOOL ret = WriteFile(handle_file, buffer, number_of_write, &number_of_written, overlapped);
-	if (!ret) {
-		return CAMCONTROL_E_WRITE_FAILED;
+	if ((file_write_information->striping_mode == IscRecordStripingMode::kStripingOff) || (file_write_information->target_folder_count < 2)) {
+		return async_file_writer_->Open(file_write_information->write_file_name, file_write_information->initial_size);
 	}
-	
-	if (number_of_written != 0) {
-		*number_of_byteswritten = (__int64)number_of_written;
+
+	int ret = async_file_writer_->OpenStriped(file_write_information->write_file_name, file_write_information->target_folder_count, file_write_information->write_folder, file_write_information->initial_size);
+	if (ret != DPC_E_OK) {
+		return ret;
 	}
-	else {
-		return CAMCONTROL_E_WRITE_FAILED;
+	file_write_information->is_striped = true;
+
+	ret = UpdateStripeWeight(file_write_information);
+	if (ret != DPC_E_OK) {
+		async_file_writer_->Close();
+		file_write_information->is_striped = false;
+		return ret;
 	}
 
 	return DPC_E_OK;
 }
 
 /**
- * ディスクの空き容量を確認します
+ * 空き容量から分散の重みを更新します
  *
- * @param[in] file_write_information 確認用のパラメータ
+ * @param[in] file_write_information 書き込みファイルの情報です
  * @retval 0 成功
  * @retval other 失敗/保存できない
+ * @note kRoundRobin:最低空き容量以上の保存先に均等に分散 kFreeSpace:最低空き容量を超える容量(MB)に比例して分散
  */
-int IscFileWriteControlImpl::CheckFreeSpace(FileWriteInformation* file_write_information)
+int IscFileWriteControlImpl::UpdateStripeWeight(FileWriteInformation* file_write_information)
 {
-	// 空き容量の確認
-	int index = file_write_information->current_folder_index;
-	bool is_ok = CheckDiskFreeSpace(file_write_information->write_folder[index], file_write_information->minimum_capacity_required);
+	wchar_t logMag[128] = {};
+	int available_count = 0;
 
-	if (!is_ok) {
-		// 次のフォルダ
-		if (file_write_information->current_folder_index < (file_write_information->target_folder_count - 1)) {
-			file_write_information->current_folder_index++;
+	for (int i = 0; i < file_write_information->target_folder_count; i++) {
+		__int64 weight = 0;
 
-			index = file_write_information->current_folder_index;
-			bool is_ok2 = CheckDiskFreeSpace(file_write_information->write_folder[index], file_write_information->minimum_capacity_required);
-			if (!is_ok) {
-				// 保存できない
-				return CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE;
+		unsigned __int64 free_disk_space = 0;
+		if (GetFreeDiskSpace(file_write_information->write_folder[i], &free_disk_space)) {
+			const __int64 free_space_mb = (__int64)(free_disk_space / (unsigned __int64)1024 / (unsigned __int64)1024);
+			const __int64 minimum_mb = file_write_information->minimum_capacity_required * 1024;
+
+			if (free_space_mb > minimum_mb) {
+				if (file_write_information->striping_mode == IscRecordStripingMode::kFreeSpace) {
+					weight = free_space_mb - minimum_mb;
+				}
+				else {
+					weight = 1;
+				}
 			}
 		}
+
+		if (weight == 0) {
+			swprintf_s(logMag, L"Insufficient free space. %s\n", file_write_information->write_folder[i]);
+			isc_log_->LogError(L"IscFileWriteControlImpl::UpdateStripeWeight", logMag);
+		}
 		else {
-			// 保存できない
-			return CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE;
+			available_count++;
 		}
+
+		async_file_writer_->SetStripeWeight(i, weight);
+	}
+
+	if (available_count == 0) {
+		// 保存できない
+		return CAMCONTROL_E_NOT_ENOUGH_FREE_SPACE;
 	}
 
 	return DPC_E_OK;
@@ -1205,9 +1317,6 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 	isc_raw_data_header.version = ISC_ROW_DATA_HEADER_VERSION;
 	isc_raw_data_header.header_size = sizeof(IscRawDataHeader);
 
-	__int64 number_of_write_to_file = 0;
-	__int64 number_of_byteswritten = 0;
-
 	while (isc_file_write_Control->thread_control_.terminate_request < 1) {
 
 		// Wait for start
@@ -1316,8 +1425,16 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 								image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.height * 
 								image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.channel_count;
 				if (data_size > 0) {
-					isc_raw_data_header.data_size = data_size;
-					isc_raw_data_header.compressed = 0;
+					const unsigned char* write_data = nullptr;
+					int write_size = 0;
+					int compressed = 0;
+					isc_file_write_Control->CompressRawData(image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.image,
+															image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.width * image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.channel_count,
+															image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.height,
+															&write_data, &write_size, &compressed);
+
+					isc_raw_data_header.data_size = write_size;
+					isc_raw_data_header.compressed = compressed;
 					isc_raw_data_header.frame_index = (image_info_buffer_data->isc_image_info.frame_data[frame_data_index].frameNo == -1) ? isc_file_write_Control->file_write_information_.frame_index :
 																																			image_info_buffer_data->isc_image_info.frame_data[frame_data_index].frameNo;
 					isc_raw_data_header.type = 1;	// mono
@@ -1331,15 +1448,8 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 					isc_raw_data_header.frame_time_low = ul_int.u.LowPart;
 					isc_raw_data_header.frame_time_high = ul_int.u.HighPart;
 
-					number_of_write_to_file = isc_raw_data_header.header_size;
-					number_of_byteswritten = 0;
-
-					int write_ret = WriteDataToFile(isc_file_write_Control->file_write_information_.handle_file,
-													(LPCVOID*)&isc_raw_data_header,
-													number_of_write_to_file,
-													&number_of_byteswritten,
-													NULL);
-					if ((write_ret != DPC_E_OK) || (number_of_byteswritten == 0)) {
+					int write_ret = isc_file_write_Control->async_file_writer_->Write(&isc_raw_data_header, isc_raw_data_header.header_size);
+					if (write_ret != DPC_E_OK) {
 						//wchar_t msg[1024] = {};
 						//swprintf_s(msg, L"[ERROR]Failed to write file code=0X%08X %s", write_ret, isc_file_write_Control->file_write_information_.write_file_name);
 						//MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
@@ -1351,15 +1461,8 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 						break;
 					}
 
-					number_of_write_to_file = data_size;
-					number_of_byteswritten = 0;
-
-					write_ret = WriteDataToFile(isc_file_write_Control->file_write_information_.handle_file,
-												(LPCVOID*)image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw.image,
-												number_of_write_to_file,
-												&number_of_byteswritten,
-												NULL);
-					if ((write_ret != DPC_E_OK) || (number_of_byteswritten == 0)) {
+					write_ret = isc_file_write_Control->async_file_writer_->Write(write_data, write_size);
+					if (write_ret != DPC_E_OK) {
 						//wchar_t msg[1024] = {};
 						//swprintf_s(msg, L"[ERROR]Failed to write file code=0X%08X %s", write_ret, isc_file_write_Control->file_write_information_.write_file_name);
 						//MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
@@ -1370,7 +1473,13 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 						isc_file_write_Control->thread_control_.end_code = CAMCONTROL_E_WRITE_FAILED;
 						break;
 					}
+					isc_file_write_Control->AddFileIndexEntry(&isc_file_write_Control->file_write_information_, &isc_raw_data_header);
+
 					isc_file_write_Control->file_write_information_.frame_index++;
+
+					EnterCriticalSection(&isc_file_write_Control->threads_critical_);
+					isc_file_write_Control->write_statistics_.frame_count++;
+					LeaveCriticalSection(&isc_file_write_Control->threads_critical_);
 				}
 
 				// color
@@ -1378,8 +1487,16 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 							image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.height *
 							image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.channel_count;
 				if (data_size > 0) {
-					isc_raw_data_header.data_size = data_size;
-					isc_raw_data_header.compressed = 0;
+					const unsigned char* write_data = nullptr;
+					int write_size = 0;
+					int compressed = 0;
+					isc_file_write_Control->CompressRawData(image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.image,
+															image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.width * image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.channel_count,
+															image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.height,
+															&write_data, &write_size, &compressed);
+
+					isc_raw_data_header.data_size = write_size;
+					isc_raw_data_header.compressed = compressed;
 					isc_raw_data_header.frame_index = (image_info_buffer_data->isc_image_info.frame_data[frame_data_index].frameNo == -1) ? isc_file_write_Control->file_write_information_.frame_index :
 																																			image_info_buffer_data->isc_image_info.frame_data[frame_data_index].frameNo;
 					isc_raw_data_header.type = 2;	// color
@@ -1393,15 +1510,8 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 					isc_raw_data_header.frame_time_low = ul_int.u.LowPart;
 					isc_raw_data_header.frame_time_high = ul_int.u.HighPart;
 
-					number_of_write_to_file = isc_raw_data_header.header_size;
-					number_of_byteswritten = 0;
-
-					int write_ret = WriteDataToFile(isc_file_write_Control->file_write_information_.handle_file,
-													(LPCVOID*)&isc_raw_data_header,
-													number_of_write_to_file,
-													&number_of_byteswritten,
-													NULL);
-					if ((write_ret != DPC_E_OK) || (number_of_byteswritten == 0)) {
+					int write_ret = isc_file_write_Control->async_file_writer_->Write(&isc_raw_data_header, isc_raw_data_header.header_size);
+					if (write_ret != DPC_E_OK) {
 						//wchar_t msg[1024] = {};
 						//swprintf_s(msg, L"[ERROR]Failed to write file code=0X%08X %s", write_ret, isc_file_write_Control->file_write_information_.write_file_name);
 						//MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
@@ -1413,15 +1523,8 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 						break;
 					}
 
-					number_of_write_to_file = data_size;
-					number_of_byteswritten = 0;
-
-					write_ret = WriteDataToFile(isc_file_write_Control->file_write_information_.handle_file,
-												(LPCVOID*)image_info_buffer_data->isc_image_info.frame_data[frame_data_index].raw_color.image,
-												number_of_write_to_file,
-												&number_of_byteswritten,
-												NULL);
-					if ((write_ret != DPC_E_OK) || (number_of_byteswritten == 0)) {
+					write_ret = isc_file_write_Control->async_file_writer_->Write(write_data, write_size);
+					if (write_ret != DPC_E_OK) {
 						//wchar_t msg[1024] = {};
 						//swprintf_s(msg, L"[ERROR]Failed to write file code=0X%08X %s", write_ret, isc_file_write_Control->file_write_information_.write_file_name);
 						//MessageBox(NULL, msg, L"IscFileWriteControlImpl::WriteDataProc()", MB_ICONERROR);
@@ -1432,8 +1535,13 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 						isc_file_write_Control->thread_control_.end_code = CAMCONTROL_E_WRITE_FAILED;
 						break;
 					}
+					isc_file_write_Control->AddFileIndexEntry(&isc_file_write_Control->file_write_information_, &isc_raw_data_header);
 
 					isc_file_write_Control->file_write_information_.frame_index++;
+
+					EnterCriticalSection(&isc_file_write_Control->threads_critical_);
+					isc_file_write_Control->write_statistics_.frame_count++;
+					LeaveCriticalSection(&isc_file_write_Control->threads_critical_);
 				}
 
 				// debug
@@ -1449,6 +1557,12 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 			// ended
 			isc_file_write_Control->isc_image_info_ring_buffer_->DoneGetBuffer(get_index);
 
+			if (get_index >= 0) {
+				EnterCriticalSection(&isc_file_write_Control->threads_critical_);
+				isc_file_write_Control->write_statistics_.queue_depth--;
+				LeaveCriticalSection(&isc_file_write_Control->threads_critical_);
+			}
+
 			// debug
 			//double elapsed_time = isc_file_write_Control->utility_measure_time_->Stop();
 			//if (elapsed_time > 100.0) {
@@ -1470,14 +1584,9 @@ int IscFileWriteControlImpl::WriteDataProc(IscFileWriteControlImpl* isc_file_wri
 	}
 
 
-	// close file to write
-	if (file_write_information_.handle_file != NULL) {
-		// truncate Pre-Allocated disk space
-		SetEndOfFile(file_write_information_.handle_file);
-
-		CloseHandle(file_write_information_.handle_file);
-		file_write_information_.handle_file = NULL;
-	}
+	// close file to write (truncate Pre-Allocated disk space)
+	async_file_writer_->Close();
+	raw_file_index_->Close();
 
 	isc_file_write_Control->thread_control_.terminate_done = 1;
 
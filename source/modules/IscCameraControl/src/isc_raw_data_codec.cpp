@@ -0,0 +1,569 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_raw_data_codec.cpp
+ * @brief lossless compression of raw data
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class provides lossless compression and decompression of the raw data.
+ * Each row is predicted from its neighbors (MED predictor of LOCO-I) and the residual is coded with
+ * a static order-0 rANS coder. The rows are divided into stripes which are processed in parallel.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "isc_dpl_error_def.h"
+#include "isc_camera_def.h"
+#include "isc_band_worker.h"
+
+#include "isc_raw_data_codec.h"
+
+constexpr int kRansScaleBits = 12;
+constexpr uint32_t kRansScale = 1u << kRansScaleBits;
+constexpr uint32_t kRansByteL = 1u << 23;
+constexpr int kFrequencyTableSize = 256 * sizeof(uint16_t);
+
+/**
+ * 周辺画素から予測値を計算します
+ *
+ * @param[in] row 現在の行
+ * @param[in] prev_row 前の行 (stripeの先頭行はnullptr)
+ * @param[in] i 位置
+ * @return 予測値
+ * @note 1画素2byteのため、2byte前を左隣とします
+ */
+static inline int PredictMed(const unsigned char* row, const unsigned char* prev_row, const int i)
+{
+	const int a = (i >= 2) ? row[i - 2] : ((prev_row != nullptr) ? prev_row[i] : 0);
+	const int b = (prev_row != nullptr) ? prev_row[i] : a;
+	const int c = ((prev_row != nullptr) && (i >= 2)) ? prev_row[i - 2] : b;
+
+	const int max_ab = (a > b) ? a : b;
+	const int min_ab = (a > b) ? b : a;
+
+	if (c >= max_ab) {
+		return min_ab;
+	}
+	else if (c <= min_ab) {
+		return max_ab;
+	}
+
+	return a + b - c;
+}
+
+/**
+ * 出現回数を合計kRansScaleの頻度に正規化します
+ *
+ * @param[in] count 出現回数
+ * @param[in] total 合計
+ * @param[out] freq 頻度
+ * @retval true 成功
+ * @retval false 失敗
+ * @note 出現した値の頻度は1以上とします
+ */
+static bool NormalizeFrequency(const uint32_t* count, const uint32_t total, uint16_t* freq)
+{
+	uint32_t sum = 0;
+	for (int s = 0; s < 256; s++) {
+		if (count[s] == 0) {
+			freq[s] = 0;
+			continue;
+		}
+		uint32_t f = (uint32_t)(((uint64_t)count[s] * kRansScale) / total);
+		if (f == 0) {
+			f = 1;
+		}
+		freq[s] = (uint16_t)f;
+		sum += f;
+	}
+
+	while (sum != kRansScale) {
+		int max_symbol = 0;
+		for (int s = 1; s < 256; s++) {
+			if (freq[s] > freq[max_symbol]) {
+				max_symbol = s;
+			}
+		}
+
+		if (sum < kRansScale) {
+			freq[max_symbol] = (uint16_t)(freq[max_symbol] + (kRansScale - sum));
+			sum = kRansScale;
+		}
+		else {
+			if (freq[max_symbol] <= 1) {
+				return false;
+			}
+			freq[max_symbol]--;
+			sum--;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * constructor
+ *
+ */
+IscRawDataCodec::IscRawDataCodec():
+	band_worker_(nullptr), max_width_(0), max_height_(0), stripe_job_()
+{
+	band_worker_ = new IscBandWorker;
+}
+
+/**
+ * destructor
+ *
+ */
+IscRawDataCodec::~IscRawDataCodec()
+{
+	Terminate();
+
+	delete band_worker_;
+	band_worker_ = nullptr;
+}
+
+/**
+ * 初期化します
+ *
+ * @param[in] thread_count スレッドの数 0:呼び出し側のスレッドで処理します
+ * @param[in] max_width 最大幅(byte) 0:圧縮は行いません
+ * @param[in] max_height 最大高さ 0:圧縮は行いません
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawDataCodec::Initialize(const int thread_count, const int max_width, const int max_height)
+{
+	Terminate();
+
+	if ((thread_count < 0) || (thread_count > kMaxStripeCount) || (max_width < 0) || (max_height < 0)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	max_width_ = max_width;
+	max_height_ = max_height;
+
+	// work area for compression
+	const int stripe_count = (thread_count > 0) ? thread_count : 1;
+	const int max_rows = (max_height_ + stripe_count - 1) / stripe_count;
+	const int max_stripe_size = max_width_ * max_rows;
+
+	for (int i = 0; i < stripe_count; i++) {
+		if (max_stripe_size > 0) {
+			stripe_job_[i].residual = new unsigned char[max_stripe_size];
+			stripe_job_[i].encoded_capacity = (max_stripe_size * 2) + kFrequencyTableSize + 16;
+			stripe_job_[i].encoded = new unsigned char[stripe_job_[i].encoded_capacity];
+		}
+	}
+
+	// workers
+	if (band_worker_->Initialize(thread_count, RunStripe, this) != 0) {
+		Terminate();
+		return CAMCONTROL_E_INVALID_DEVICEHANDLE;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawDataCodec::Terminate()
+{
+	band_worker_->Terminate();
+
+	for (int i = 0; i < kMaxStripeCount; i++) {
+		delete[] stripe_job_[i].residual;
+		stripe_job_[i].residual = nullptr;
+		delete[] stripe_job_[i].encoded;
+		stripe_job_[i].encoded = nullptr;
+		stripe_job_[i].encoded_capacity = 0;
+	}
+
+	max_width_ = 0;
+	max_height_ = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 配置のためにスレッドのハンドルを取得します
+ *
+ * @param[in] max_count thread_handleの数
+ * @param[out] thread_handle ハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawDataCodec::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+	if ((thread_handle == nullptr) || (thread_count == nullptr)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	band_worker_->GetThreadHandle(max_count, thread_handle, thread_count);
+
+	return DPC_E_OK;
+}
+
+/**
+ * 圧縮後の最大サイズを取得します
+ *
+ * @param[in] width 幅(byte)
+ * @param[in] height 高さ
+ * @return 最大サイズ(byte)
+ * @note 圧縮後が元より大きい場合は圧縮しないため、元のサイズとなります
+ */
+int IscRawDataCodec::GetMaxCompressedSize(const int width, const int height)
+{
+	return width * height;
+}
+
+/**
+ * 圧縮します
+ *
+ * @param[in] src 元データ
+ * @param[in] width 幅(byte)
+ * @param[in] height 高さ
+ * @param[out] dst 圧縮データ
+ * @param[in] dst_capacity dstのサイズ
+ * @param[out] compressed_size 圧縮後のサイズ 0:元より小さくならない
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawDataCodec::Compress(const unsigned char* src, const int width, const int height, unsigned char* dst, const int dst_capacity, int* compressed_size)
+{
+	if ((src == nullptr) || (dst == nullptr) || (compressed_size == nullptr)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+	*compressed_size = 0;
+
+	if ((width <= 0) || (height <= 0) || (width > max_width_) || (height > max_height_)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	int row_start[kMaxStripeCount] = {};
+	int row_end[kMaxStripeCount] = {};
+	const int valid_stripe_count = band_worker_->SplitRows(height, row_start, row_end);
+	const int rows_per_stripe = row_end[0] - row_start[0];
+
+	for (int i = 0; i < valid_stripe_count; i++) {
+		StripeJob* job = &stripe_job_[i];
+
+		job->is_compress = true;
+		job->src = src;
+		job->dst = nullptr;
+		job->width = width;
+		job->row_start = row_start[i];
+		job->row_end = row_end[i];
+		job->src_size = 0;
+		job->result_size = 0;
+		job->result = DPC_E_OK;
+	}
+
+	if (band_worker_->Run(valid_stripe_count) != 0) {
+		return CAMCONTROL_E_FAIL;
+	}
+
+	// combine
+	CompressedDataHeader compressed_data_header = {};
+	compressed_data_header.method = 1;
+	compressed_data_header.width = width;
+	compressed_data_header.height = height;
+	compressed_data_header.stripe_count = valid_stripe_count;
+	compressed_data_header.rows_per_stripe = rows_per_stripe;
+
+	__int64 total_size = sizeof(CompressedDataHeader);
+	for (int i = 0; i < valid_stripe_count; i++) {
+		if (stripe_job_[i].result != DPC_E_OK) {
+			return stripe_job_[i].result;
+		}
+		compressed_data_header.stripe_size[i] = stripe_job_[i].result_size;
+		total_size += stripe_job_[i].result_size;
+	}
+
+	if ((total_size >= (__int64)width * height) || (total_size > dst_capacity)) {
+		// 小さくならない
+		return DPC_E_OK;
+	}
+
+	unsigned char* dst_ptr = dst;
+	memcpy(dst_ptr, &compressed_data_header, sizeof(CompressedDataHeader));
+	dst_ptr += sizeof(CompressedDataHeader);
+
+	for (int i = 0; i < valid_stripe_count; i++) {
+		memcpy(dst_ptr, stripe_job_[i].dst, stripe_job_[i].result_size);
+		dst_ptr += stripe_job_[i].result_size;
+	}
+
+	*compressed_size = (int)total_size;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 展開します
+ *
+ * @param[in] src 圧縮データ
+ * @param[in] src_size 圧縮データのサイズ
+ * @param[out] dst 展開先
+ * @param[in] dst_capacity dstのサイズ
+ * @param[out] decompressed_size 展開後のサイズ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawDataCodec::Decompress(const unsigned char* src, const int src_size, unsigned char* dst, const int dst_capacity, int* decompressed_size)
+{
+	if ((src == nullptr) || (dst == nullptr) || (decompressed_size == nullptr)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+	*decompressed_size = 0;
+
+	if (src_size < (int)sizeof(CompressedDataHeader)) {
+		return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+	}
+
+	CompressedDataHeader compressed_data_header = {};
+	memcpy(&compressed_data_header, src, sizeof(CompressedDataHeader));
+
+	const int width = compressed_data_header.width;
+	const int height = compressed_data_header.height;
+	const int stripe_count = compressed_data_header.stripe_count;
+
+	if ((compressed_data_header.method != 1) || (width <= 0) || (height <= 0) ||
+		((__int64)width * height > dst_capacity) ||
+		(stripe_count <= 0) || (stripe_count > kMaxStripeCount) || (stripe_count > height)) {
+		return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+	}
+
+	// 圧縮時と同じ分割
+	const int rows_per_stripe = compressed_data_header.rows_per_stripe;
+	if ((rows_per_stripe <= 0) || ((__int64)rows_per_stripe * stripe_count < height)) {
+		return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+	}
+
+	const unsigned char* src_ptr = src + sizeof(CompressedDataHeader);
+	const unsigned char* src_end = src + src_size;
+
+	for (int i = 0; i < stripe_count; i++) {
+		StripeJob* job = &stripe_job_[i];
+
+		if ((compressed_data_header.stripe_size[i] <= 0) || (compressed_data_header.stripe_size[i] > (src_end - src_ptr))) {
+			return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+		}
+
+		job->is_compress = false;
+		job->src = src_ptr;
+		job->dst = dst;
+		job->width = width;
+		job->row_start = i * rows_per_stripe;
+		job->row_end = (job->row_start + rows_per_stripe < height) ? job->row_start + rows_per_stripe : height;
+		job->src_size = compressed_data_header.stripe_size[i];
+		job->result_size = 0;
+		job->result = DPC_E_OK;
+
+		if (job->row_start >= job->row_end) {
+			return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+		}
+
+		src_ptr += compressed_data_header.stripe_size[i];
+	}
+
+	if (band_worker_->Run(stripe_count) != 0) {
+		return CAMCONTROL_E_FAIL;
+	}
+
+	for (int i = 0; i < stripe_count; i++) {
+		if (stripe_job_[i].result != DPC_E_OK) {
+			return stripe_job_[i].result;
+		}
+	}
+
+	*decompressed_size = width * height;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 1 stripeを圧縮/展開します
+ *
+ * @param[in] context IscRawDataCodec
+ * @param[in] band_index stripe
+ * @return none
+ * @note IscBandWorkerのスレッドから呼び出されます。stripeがスレッドより多い場合は、スレッドの数ずつ処理されます
+ */
+void IscRawDataCodec::RunStripe(void* context, const int band_index)
+{
+	IscRawDataCodec* owner = (IscRawDataCodec*)context;
+
+	StripeJob* job = &owner->stripe_job_[band_index];
+	if (job->is_compress) {
+		CompressStripe(job);
+	}
+	else {
+		DecompressStripe(job);
+	}
+
+	return;
+}
+
+/**
+ * 1 stripeを圧縮します
+ *
+ * @param[in,out] job 処理内容
+ * @return none
+ * @note 出力は、頻度表(256 x 2byte)とrANSのデータです。job->dstはencodedの中を指します
+ */
+void IscRawDataCodec::CompressStripe(StripeJob* job)
+{
+	const int width = job->width;
+	const int rows = job->row_end - job->row_start;
+	const uint32_t data_count = (uint32_t)width * rows;
+	const unsigned char* src_rows = job->src + (size_t)job->row_start * width;
+
+	// prediction
+	uint32_t count[256] = {};
+	for (int r = 0; r < rows; r++) {
+		const unsigned char* row = src_rows + (size_t)r * width;
+		const unsigned char* prev_row = (r > 0) ? (row - width) : nullptr;
+		unsigned char* residual = job->residual + (size_t)r * width;
+
+		for (int i = 0; i < width; i++) {
+			residual[i] = (unsigned char)(row[i] - PredictMed(row, prev_row, i));
+			count[residual[i]]++;
+		}
+	}
+
+	// frequency
+	uint16_t freq[256] = {};
+	if (!NormalizeFrequency(count, data_count, freq)) {
+		job->result = CAMCONTROL_E_FAIL;
+		return;
+	}
+
+	uint32_t cum[256] = {};
+	uint32_t cum_value = 0;
+	for (int s = 0; s < 256; s++) {
+		cum[s] = cum_value;
+		cum_value += freq[s];
+	}
+
+	// encode backward
+	unsigned char* end = job->encoded + job->encoded_capacity;
+	unsigned char* ptr = end;
+	uint32_t x = kRansByteL;
+
+	for (int64_t k = (int64_t)data_count - 1; k >= 0; k--) {
+		const unsigned char s = job->residual[k];
+		const uint32_t x_max = ((kRansByteL >> kRansScaleBits) << 8) * freq[s];
+		while (x >= x_max) {
+			*--ptr = (unsigned char)(x & 0xff);
+			x >>= 8;
+		}
+		x = ((x / freq[s]) << kRansScaleBits) + (x % freq[s]) + cum[s];
+	}
+
+	ptr -= 4;
+	ptr[0] = (unsigned char)(x >> 0);
+	ptr[1] = (unsigned char)(x >> 8);
+	ptr[2] = (unsigned char)(x >> 16);
+	ptr[3] = (unsigned char)(x >> 24);
+
+	ptr -= kFrequencyTableSize;
+	memcpy(ptr, freq, kFrequencyTableSize);
+
+	job->dst = ptr;
+	job->result_size = (int)(end - ptr);
+	job->result = DPC_E_OK;
+
+	return;
+}
+
+/**
+ * 1 stripeを展開します
+ *
+ * @param[in,out] job 処理内容
+ * @return none
+ */
+void IscRawDataCodec::DecompressStripe(StripeJob* job)
+{
+	if (job->src_size < kFrequencyTableSize + 4) {
+		job->result = CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+		return;
+	}
+
+	// frequency
+	uint16_t freq[256] = {};
+	memcpy(freq, job->src, kFrequencyTableSize);
+
+	uint32_t cum[256] = {};
+	uint32_t cum_value = 0;
+	for (int s = 0; s < 256; s++) {
+		cum[s] = cum_value;
+		cum_value += freq[s];
+	}
+	if (cum_value != kRansScale) {
+		job->result = CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+		return;
+	}
+
+	unsigned char slot_to_symbol[kRansScale];
+	for (int s = 0; s < 256; s++) {
+		memset(&slot_to_symbol[cum[s]], s, freq[s]);
+	}
+
+	// decode
+	const unsigned char* ptr = job->src + kFrequencyTableSize;
+	const unsigned char* end = job->src + job->src_size;
+
+	uint32_t x = (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+	ptr += 4;
+
+	const int width = job->width;
+	const int rows = job->row_end - job->row_start;
+	unsigned char* dst_rows = job->dst + (size_t)job->row_start * width;
+
+	for (int r = 0; r < rows; r++) {
+		unsigned char* row = dst_rows + (size_t)r * width;
+		const unsigned char* prev_row = (r > 0) ? (row - width) : nullptr;
+
+		for (int i = 0; i < width; i++) {
+			const unsigned char s = slot_to_symbol[x & (kRansScale - 1)];
+			x = freq[s] * (x >> kRansScaleBits) + (x & (kRansScale - 1)) - cum[s];
+			while (x < kRansByteL) {
+				if (ptr >= end) {
+					job->result = CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+					return;
+				}
+				x = (x << 8) | *ptr++;
+			}
+
+			row[i] = (unsigned char)(s + PredictMed(row, prev_row, i));
+		}
+	}
+
+	job->result_size = width * rows;
+	job->result = DPC_E_OK;
+
+	return;
+}
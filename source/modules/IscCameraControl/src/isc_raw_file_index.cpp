@@ -0,0 +1,598 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_raw_file_index.cpp
+ * @brief index of raw data file
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class provides reading and writing of the index of raw data file.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <Shlwapi.h>
+
+#include "isc_dpl_error_def.h"
+#include "isc_camera_def.h"
+
+#include "isc_raw_file_index.h"
+
+#pragma comment (lib, "shlwapi")
+
+constexpr char kISC_RAW_INDEX_MARK[] = "ISC RAW INDEX";
+
+/**
+ * constructor
+ *
+ */
+IscRawFileIndex::IscRawFileIndex():
+	entry_(nullptr), entry_count_(0), entry_capacity_(0), handle_index_file_(NULL)
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscRawFileIndex::~IscRawFileIndex()
+{
+	Close();
+	Clear();
+}
+
+/**
+ * インデックスファイルを読み込みます
+ *
+ * @param[in] raw_file_name RAWデータファイル名
+ * @param[in] raw_file_size RAWデータファイルのサイズ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note RAWデータファイルに収まらないEntryは、書き込み途中として除外します
+ */
+int IscRawFileIndex::Load(const wchar_t* raw_file_name, const unsigned __int64 raw_file_size)
+{
+	Clear();
+
+	wchar_t index_file_name[_MAX_PATH] = {};
+	int ret = MakeIndexFileName(raw_file_name, index_file_name, _MAX_PATH);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	if (!::PathFileExists(index_file_name)) {
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
+
+	HANDLE handle_file = CreateFile(index_file_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle_file == INVALID_HANDLE_VALUE) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
+
+	LARGE_INTEGER index_file_size = {};
+	if (!GetFileSizeEx(handle_file, &index_file_size)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// header
+	IscRawFileIndexHeader index_header = {};
+	DWORD readed_size = 0;
+	if (FALSE == ReadFile(handle_file, &index_header, sizeof(index_header), &readed_size, NULL) || readed_size != sizeof(index_header)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
+
+	if (strncmp(index_header.mark, kISC_RAW_INDEX_MARK, sizeof(kISC_RAW_INDEX_MARK)) != 0 ||
+		index_header.header_size != sizeof(IscRawFileIndexHeader) ||
+		index_header.entry_size != sizeof(IscRawFileIndexEntry)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
+
+	// entries
+	const __int64 entry_count = (index_file_size.QuadPart - sizeof(IscRawFileIndexHeader)) / sizeof(IscRawFileIndexEntry);
+	if (entry_count <= 0) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
+
+	entry_ = new IscRawFileIndexEntry[entry_count];
+	entry_capacity_ = entry_count;
+
+	constexpr __int64 read_unit_count = 32768;
+	__int64 read_count = 0;
+	while (read_count < entry_count) {
+		const __int64 count = (entry_count - read_count) < read_unit_count ? (entry_count - read_count) : read_unit_count;
+		const DWORD bytes_to_read = (DWORD)(count * sizeof(IscRawFileIndexEntry));
+
+		readed_size = 0;
+		if (FALSE == ReadFile(handle_file, &entry_[read_count], bytes_to_read, &readed_size, NULL) || readed_size != bytes_to_read) {
+			break;
+		}
+		read_count += count;
+	}
+
+	CloseHandle(handle_file);
+
+	// the raw data file may be shorter than the index
+	__int64 valid_count = 0;
+	for (__int64 i = 0; i < read_count; i++) {
+		const unsigned __int64 end_of_data = (unsigned __int64)entry_[i].offset + sizeof(IscRawDataHeader) + (unsigned __int64)entry_[i].data_size;
+		if (entry_[i].offset < (__int64)sizeof(IscRawFileHeader) || entry_[i].data_size <= 0 || end_of_data > raw_file_size) {
+			break;
+		}
+		valid_count++;
+	}
+
+	if (valid_count == 0) {
+		Clear();
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
+
+	entry_count_ = valid_count;
+
+	return DPC_E_OK;
+}
+
+/**
+ * Load()以降にインデックスファイルへ追加されたEntryを読み込みます
+ *
+ * @param[in] raw_file_name RAWデータファイル名
+ * @param[in] raw_file_size RAWデータファイルのサイズ
+ * @param[out] added_count 追加したEntryの数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note
+ *  - 記録中のファイルの再生用です。読み込み済みのEntryは読み直しません  
+ *  - RAWデータファイルを越えるEntryは、次の呼び出しで対象とします
+ */
+int IscRawFileIndex::Extend(const wchar_t* raw_file_name, const unsigned __int64 raw_file_size, __int64* added_count)
+{
+	if (added_count == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+	*added_count = 0;
+
+	if (!IsValid()) {
+		int ret = Load(raw_file_name, raw_file_size);
+		if (ret != DPC_E_OK) {
+			return ret;
+		}
+		*added_count = entry_count_;
+
+		return DPC_E_OK;
+	}
+
+	wchar_t index_file_name[_MAX_PATH] = {};
+	int ret = MakeIndexFileName(raw_file_name, index_file_name, _MAX_PATH);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	HANDLE handle_file = CreateFile(index_file_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle_file == INVALID_HANDLE_VALUE) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
+
+	LARGE_INTEGER index_file_size = {};
+	if (!GetFileSizeEx(handle_file, &index_file_size)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	const __int64 entry_count = (index_file_size.QuadPart - sizeof(IscRawFileIndexHeader)) / sizeof(IscRawFileIndexEntry);
+	if (entry_count <= entry_count_) {
+		CloseHandle(handle_file);
+		return DPC_E_OK;
+	}
+
+	// grow the buffer to twice the size, so as not to copy on every call
+	if (entry_count > entry_capacity_) {
+		__int64 capacity = entry_capacity_ * 2;
+		if (capacity < entry_count) {
+			capacity = entry_count;
+		}
+
+		IscRawFileIndexEntry* entry = new IscRawFileIndexEntry[capacity];
+		memcpy(entry, entry_, sizeof(IscRawFileIndexEntry) * entry_count_);
+		delete[] entry_;
+		entry_ = entry;
+		entry_capacity_ = capacity;
+	}
+
+	LARGE_INTEGER distance_to_move = {};
+	distance_to_move.QuadPart = sizeof(IscRawFileIndexHeader) + sizeof(IscRawFileIndexEntry) * entry_count_;
+	if (!SetFilePointerEx(handle_file, distance_to_move, NULL, FILE_BEGIN)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	const DWORD bytes_to_read = (DWORD)((entry_count - entry_count_) * sizeof(IscRawFileIndexEntry));
+	DWORD readed_size = 0;
+	BOOL result = ReadFile(handle_file, &entry_[entry_count_], bytes_to_read, &readed_size, NULL);
+	CloseHandle(handle_file);
+	if (FALSE == result) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// the raw data file may be shorter than the index
+	const __int64 read_count = entry_count_ + readed_size / sizeof(IscRawFileIndexEntry);
+	__int64 valid_count = entry_count_;
+	for (__int64 i = entry_count_; i < read_count; i++) {
+		const unsigned __int64 end_of_data = (unsigned __int64)entry_[i].offset + sizeof(IscRawDataHeader) + (unsigned __int64)entry_[i].data_size;
+		if (entry_[i].offset <= entry_[i - 1].offset || entry_[i].data_size <= 0 || end_of_data > raw_file_size) {
+			break;
+		}
+		valid_count++;
+	}
+
+	*added_count = valid_count - entry_count_;
+	entry_count_ = valid_count;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 指定番号以降のEntryを対象外とします
+ *
+ * @param[in] entry_count 残すEntryの数
+ * @return none
+ * @note データが書き込まれていないEntryを除くために使用します
+ */
+void IscRawFileIndex::Truncate(const __int64 entry_count)
+{
+	if (entry_count <= 0) {
+		Clear();
+		return;
+	}
+
+	if (entry_count < entry_count_) {
+		entry_count_ = entry_count;
+	}
+
+	return;
+}
+
+/**
+ * 読み込んだインデックスを解放します
+ *
+ * @return none
+ */
+void IscRawFileIndex::Clear()
+{
+	delete[] entry_;
+	entry_ = nullptr;
+	entry_count_ = 0;
+	entry_capacity_ = 0;
+
+	return;
+}
+
+/**
+ * インデックスが読み込まれているか
+ *
+ * @retval true 読み込み済み
+ * @retval false 無し
+ */
+bool IscRawFileIndex::IsValid() const
+{
+	return entry_ != nullptr && entry_count_ > 0;
+}
+
+/**
+ * Entryの数を取得します
+ *
+ * @return Entryの数
+ */
+__int64 IscRawFileIndex::GetEntryCount() const
+{
+	return entry_count_;
+}
+
+/**
+ * 指定番号のEntryを取得します
+ *
+ * @param[in] entry_number 番号
+ * @param[out] entry Entry
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileIndex::GetEntry(const __int64 entry_number, IscRawFileIndexEntry* entry) const
+{
+	if (!IsValid()) {
+		return CAMCONTROL_E_NO_FILE_INDEX;
+	}
+
+	if (entry_number < 0 || entry_number >= entry_count_ || entry == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	*entry = entry_[entry_number];
+
+	return DPC_E_OK;
+}
+
+/**
+ * 指定時刻以降の最初のEntryを探します
+ *
+ * @param[in] frame_time 時刻 (UTC msec)
+ * @return Entry番号 -1:無し
+ * @note Entryは時刻順に並んでいるものとして二分探索します。最後のEntryより後の時刻は最後のEntryとします
+ */
+__int64 IscRawFileIndex::FindEntryByTime(const __int64 frame_time) const
+{
+	if (!IsValid()) {
+		return -1;
+	}
+
+	__int64 low = 0;
+	__int64 high = entry_count_;
+	while (low < high) {
+		const __int64 middle = low + (high - low) / 2;
+		if (entry_[middle].frame_time < frame_time) {
+			low = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+
+	if (low >= entry_count_) {
+		low = entry_count_ - 1;
+	}
+
+	return low;
+}
+
+/**
+ * 書き込み中のRAWデータファイルのインデックスを作成します
+ *
+ * @param[in] raw_file_name RAWデータファイル名
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileIndex::Open(const wchar_t* raw_file_name)
+{
+	wchar_t index_file_name[_MAX_PATH] = {};
+	int ret = MakeIndexFileName(raw_file_name, index_file_name, _MAX_PATH);
+	if (ret != DPC_E_OK) {
+		return ret;
+	}
+
+	return OpenIndexFile(index_file_name);
+}
+
+/**
+ * インデックスファイルを作成し、ヘッダーを書き込みます
+ *
+ * @param[in] index_file_name インデックスファイル名
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileIndex::OpenIndexFile(const wchar_t* index_file_name)
+{
+	Close();
+
+	if ((handle_index_file_ = CreateFile(index_file_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE) {
+		handle_index_file_ = NULL;
+		return CAMCONTROL_E_CREATE_SAVE_FILE;
+	}
+
+	IscRawFileIndexHeader index_header = {};
+	sprintf_s(index_header.mark, "%s", kISC_RAW_INDEX_MARK);
+	index_header.version = ISC_RAW_INDEX_HEADER_VERSION;
+	index_header.header_size = sizeof(IscRawFileIndexHeader);
+	index_header.entry_size = sizeof(IscRawFileIndexEntry);
+
+	DWORD written_size = 0;
+	if (FALSE == WriteFile(handle_index_file_, &index_header, sizeof(index_header), &written_size, NULL) || written_size != sizeof(index_header)) {
+		Close();
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * Entryを追加します
+ *
+ * @param[in] entry Entry
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileIndex::Add(const IscRawFileIndexEntry* entry)
+{
+	if (handle_index_file_ == NULL) {
+		return CAMCONTROL_E_INVALID_REQUEST;
+	}
+
+	DWORD written_size = 0;
+	if (FALSE == WriteFile(handle_index_file_, entry, sizeof(IscRawFileIndexEntry), &written_size, NULL) || written_size != sizeof(IscRawFileIndexEntry)) {
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * 書き込み中のインデックスを閉じます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileIndex::Close()
+{
+	if (handle_index_file_ != NULL) {
+		CloseHandle(handle_index_file_);
+		handle_index_file_ = NULL;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイル名からインデックスファイル名を作成します
+ *
+ * @param[in] raw_file_name RAWデータファイル名
+ * @param[out] index_file_name インデックスファイル名
+ * @param[in] max_length index_file_nameの最大文字数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 拡張子を.idxに変更します
+ */
+int IscRawFileIndex::MakeIndexFileName(const wchar_t* raw_file_name, wchar_t* index_file_name, const int max_length)
+{
+	if (raw_file_name == nullptr || index_file_name == nullptr || max_length <= 0) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	wchar_t file_name[_MAX_PATH] = {};
+	swprintf_s(file_name, L"%s", raw_file_name);
+
+	if (!::PathRenameExtension(file_name, L".idx")) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	swprintf_s(index_file_name, max_length, L"%s", file_name);
+
+	return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルを走査してインデックスを作成します
+ *
+ * @param[in] raw_file_name RAWデータファイル名
+ * @param[out] entry_count 作成したEntryの数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note
+ *  - インデックスの無い以前のファイル用です  
+ *  - ヘッダーのみを読み込み、データは読み飛ばします  
+ *  - 不完全なデータ以降は対象外とします
+ */
+int IscRawFileIndex::Rebuild(const wchar_t* raw_file_name, __int64* entry_count)
+{
+	if (raw_file_name == nullptr || entry_count == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+	*entry_count = 0;
+
+	if (!::PathFileExists(raw_file_name) || ::PathIsDirectory(raw_file_name)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	HANDLE handle_file = CreateFile(raw_file_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (handle_file == INVALID_HANDLE_VALUE) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
+
+	LARGE_INTEGER raw_file_size = {};
+	if (!GetFileSizeEx(handle_file, &raw_file_size)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	IscRawFileHeader raw_file_header = {};
+	DWORD readed_size = 0;
+	if (FALSE == ReadFile(handle_file, &raw_file_header, sizeof(raw_file_header), &readed_size, NULL) || readed_size != sizeof(raw_file_header)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// write to a temporary file, then replace
+	wchar_t index_file_name[_MAX_PATH] = {};
+	int ret = MakeIndexFileName(raw_file_name, index_file_name, _MAX_PATH);
+	if (ret != DPC_E_OK) {
+		CloseHandle(handle_file);
+		return ret;
+	}
+
+	wchar_t temp_file_name[_MAX_PATH] = {};
+	swprintf_s(temp_file_name, L"%s.tmp", index_file_name);
+
+	IscRawFileIndex raw_file_index;
+	ret = raw_file_index.OpenIndexFile(temp_file_name);
+	if (ret != DPC_E_OK) {
+		CloseHandle(handle_file);
+		return ret;
+	}
+
+	__int64 count = 0;
+	__int64 offset = sizeof(IscRawFileHeader);
+
+	while (offset + (__int64)sizeof(IscRawDataHeader) <= raw_file_size.QuadPart) {
+		LARGE_INTEGER distance_to_move = {};
+		distance_to_move.QuadPart = offset;
+		if (!SetFilePointerEx(handle_file, distance_to_move, NULL, FILE_BEGIN)) {
+			break;
+		}
+
+		IscRawDataHeader raw_data_header = {};
+		readed_size = 0;
+		if (FALSE == ReadFile(handle_file, &raw_data_header, sizeof(raw_data_header), &readed_size, NULL) || readed_size != sizeof(raw_data_header)) {
+			break;
+		}
+
+		// the pre-allocated area is zero, and the last data may be incomplete
+		if (raw_data_header.header_size != sizeof(IscRawDataHeader) || raw_data_header.data_size <= 0) {
+			break;
+		}
+		if (offset + (__int64)sizeof(IscRawDataHeader) + raw_data_header.data_size > raw_file_size.QuadPart) {
+			break;
+		}
+
+		IscRawFileIndexEntry entry = {};
+		entry.offset = offset;
+		if (raw_data_header.version >= 300) {
+			ULARGE_INTEGER ul_int = {};
+			ul_int.LowPart = raw_data_header.frame_time_low;
+			ul_int.HighPart = raw_data_header.frame_time_high;
+			entry.frame_time = (__int64)ul_int.QuadPart;
+		}
+		entry.frame_index = raw_data_header.frame_index;
+		entry.data_size = raw_data_header.data_size;
+		entry.type = raw_data_header.type;
+
+		ret = raw_file_index.Add(&entry);
+		if (ret != DPC_E_OK) {
+			break;
+		}
+
+		count++;
+		offset += sizeof(IscRawDataHeader) + raw_data_header.data_size;
+	}
+
+	CloseHandle(handle_file);
+	raw_file_index.Close();
+
+	if (ret != DPC_E_OK) {
+		DeleteFile(temp_file_name);
+		return ret;
+	}
+
+	if (!MoveFileEx(temp_file_name, index_file_name, MOVEFILE_REPLACE_EXISTING)) {
+		DeleteFile(temp_file_name);
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	*entry_count = count;
+
+	return DPC_E_OK;
+}
@@ -0,0 +1,406 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_raw_file_stripe.cpp
+ * @brief striped raw data file
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class provides the manifest of a raw data file striped over several folders.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <Shlwapi.h>
+
+#include "isc_dpl_error_def.h"
+#include "isc_camera_def.h"
+
+#include "isc_raw_file_stripe.h"
+
+#pragma comment (lib, "shlwapi")
+
+constexpr char kISC_RAW_STRIPE_MARK[] = "ISC RAW STRIPE";
+
+/**
+ * constructor
+ *
+ */
+IscRawFileStripe::IscRawFileStripe():
+	stripe_count_(0), handle_stripe_file_(), chunk_size_(0), chunk_count_(0), total_size_(0), chunk_location_(nullptr), position_(0)
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscRawFileStripe::~IscRawFileStripe()
+{
+	Close();
+}
+
+/**
+ * マニフェストを読み込み、分割されたファイルを開きます
+ *
+ * @param[in] manifest_file_name マニフェストのファイル名
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileStripe::Open(const wchar_t* manifest_file_name)
+{
+	Close();
+
+	if (manifest_file_name == nullptr) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	HANDLE handle_file = CreateFile(manifest_file_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (handle_file == INVALID_HANDLE_VALUE) {
+		return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+	}
+
+	// header
+	IscRawStripeManifestHeader manifest_header = {};
+	DWORD readed_size = 0;
+	if (FALSE == ReadFile(handle_file, &manifest_header, sizeof(manifest_header), &readed_size, NULL) || readed_size != sizeof(manifest_header)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	if ((strcmp(manifest_header.mark, kISC_RAW_STRIPE_MARK) != 0) ||
+		(manifest_header.header_size != sizeof(IscRawStripeManifestHeader)) ||
+		(manifest_header.stripe_count < 1) || (manifest_header.stripe_count > kISC_SAVE_MAX_SAVE_FOLDER_COUNT) ||
+		(manifest_header.chunk_size <= 0) || (manifest_header.chunk_count < 0) || (manifest_header.total_size < 0) ||
+		(manifest_header.total_size > manifest_header.chunk_size * manifest_header.chunk_count)) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// stripe files
+	wchar_t stripe_file_name[kISC_SAVE_MAX_SAVE_FOLDER_COUNT][_MAX_PATH] = {};
+	const DWORD name_size = (DWORD)(sizeof(wchar_t) * _MAX_PATH * manifest_header.stripe_count);
+	if (FALSE == ReadFile(handle_file, stripe_file_name, name_size, &readed_size, NULL) || readed_size != name_size) {
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	// chunks
+	unsigned char* chunk_stripe = new unsigned char[(size_t)manifest_header.chunk_count + 1];
+	const DWORD chunk_stripe_size = (DWORD)manifest_header.chunk_count;
+	if (FALSE == ReadFile(handle_file, chunk_stripe, chunk_stripe_size, &readed_size, NULL) || readed_size != chunk_stripe_size) {
+		delete[] chunk_stripe;
+		CloseHandle(handle_file);
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	CloseHandle(handle_file);
+
+	// それぞれのファイル内での位置
+	chunk_location_ = new ChunkLocation[(size_t)manifest_header.chunk_count + 1];
+	__int64 stripe_offset[kISC_SAVE_MAX_SAVE_FOLDER_COUNT] = {};
+	for (__int64 i = 0; i < manifest_header.chunk_count; i++) {
+		const int stripe_index = chunk_stripe[i];
+		if (stripe_index >= manifest_header.stripe_count) {
+			delete[] chunk_stripe;
+			Close();
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		chunk_location_[i].stripe_index = stripe_index;
+		chunk_location_[i].offset = stripe_offset[stripe_index];
+		stripe_offset[stripe_index] += manifest_header.chunk_size;
+	}
+	delete[] chunk_stripe;
+
+	for (int i = 0; i < manifest_header.stripe_count; i++) {
+		handle_stripe_file_[i] = CreateFile(stripe_file_name[i], GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if (handle_stripe_file_[i] == INVALID_HANDLE_VALUE) {
+			handle_stripe_file_[i] = NULL;
+			stripe_count_ = i;
+			Close();
+			return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+		}
+	}
+
+	stripe_count_ = manifest_header.stripe_count;
+	chunk_size_ = manifest_header.chunk_size;
+	chunk_count_ = manifest_header.chunk_count;
+	total_size_ = manifest_header.total_size;
+	position_ = 0;
+
+	return DPC_E_OK;
+}
+
+/**
+ * 分割されたファイルを閉じます
+ *
+ * @return none
+ */
+void IscRawFileStripe::Close()
+{
+	for (int i = 0; i < kISC_SAVE_MAX_SAVE_FOLDER_COUNT; i++) {
+		if (handle_stripe_file_[i] != NULL) {
+			CloseHandle(handle_stripe_file_[i]);
+			handle_stripe_file_[i] = NULL;
+		}
+	}
+
+	delete[] chunk_location_;
+	chunk_location_ = nullptr;
+
+	stripe_count_ = 0;
+	chunk_size_ = 0;
+	chunk_count_ = 0;
+	total_size_ = 0;
+	position_ = 0;
+
+	return;
+}
+
+/**
+ * 分割されたファイルを開いているかを取得します
+ *
+ * @retval true 開いている
+ * @retval false 開いていない
+ */
+bool IscRawFileStripe::IsOpen() const
+{
+	return (stripe_count_ > 0);
+}
+
+/**
+ * 結合したファイルのサイズを取得します
+ *
+ * @return サイズ
+ */
+unsigned __int64 IscRawFileStripe::GetSize() const
+{
+	return (unsigned __int64)total_size_;
+}
+
+/**
+ * 読み込み位置を移動します
+ *
+ * @param[in] distance_to_move 移動量
+ * @param[in] move_method FILE_BEGIN/FILE_CURRENT/FILE_END
+ * @param[out] new_position 移動後の位置 (nullptr可)
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileStripe::Seek(const __int64 distance_to_move, const DWORD move_method, __int64* new_position)
+{
+	if (!IsOpen()) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+
+	__int64 position = 0;
+	switch (move_method) {
+	case FILE_BEGIN:
+		position = distance_to_move;
+		break;
+	case FILE_CURRENT:
+		position = position_ + distance_to_move;
+		break;
+	case FILE_END:
+		position = total_size_ + distance_to_move;
+		break;
+	default:
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	if (position < 0) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	position_ = position;
+	if (new_position != nullptr) {
+		*new_position = position_;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * 現在の位置から読み込みます
+ *
+ * @param[out] buffer 読み込み先
+ * @param[in] number_of_bytes_to_read 読み込むサイズ
+ * @param[out] number_of_bytes_read 読み込んだサイズ 終端では要求より小さくなります
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileStripe::Read(void* buffer, const DWORD number_of_bytes_to_read, DWORD* number_of_bytes_read)
+{
+	if (!IsOpen() || (buffer == nullptr) || (number_of_bytes_read == nullptr)) {
+		return CAMCONTROL_E_READ_FILE_FAILED;
+	}
+	*number_of_bytes_read = 0;
+
+	unsigned char* dst = (unsigned char*)buffer;
+	__int64 remaining_size = number_of_bytes_to_read;
+
+	while ((remaining_size > 0) && (position_ < total_size_)) {
+		const __int64 chunk_index = position_ / chunk_size_;
+		const __int64 offset_in_chunk = position_ % chunk_size_;
+
+		__int64 read_size = chunk_size_ - offset_in_chunk;
+		if (read_size > remaining_size) {
+			read_size = remaining_size;
+		}
+		if (read_size > total_size_ - position_) {
+			read_size = total_size_ - position_;
+		}
+
+		const ChunkLocation* chunk_location = &chunk_location_[chunk_index];
+		HANDLE handle_file = handle_stripe_file_[chunk_location->stripe_index];
+
+		LARGE_INTEGER distance_to_move = {};
+		distance_to_move.QuadPart = chunk_location->offset + offset_in_chunk;
+		if (!SetFilePointerEx(handle_file, distance_to_move, NULL, FILE_BEGIN)) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		DWORD readed_size = 0;
+		if (FALSE == ReadFile(handle_file, dst, (DWORD)read_size, &readed_size, NULL)) {
+			return CAMCONTROL_E_READ_FILE_FAILED;
+		}
+
+		dst += readed_size;
+		remaining_size -= readed_size;
+		position_ += readed_size;
+		*number_of_bytes_read += readed_size;
+
+		if (readed_size != (DWORD)read_size) {
+			// 分割ファイルが短い
+			break;
+		}
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * マニフェストを書き込みます
+ *
+ * @param[in] manifest_file_name マニフェストのファイル名
+ * @param[in] stripe_count 分割ファイルの数
+ * @param[in] stripe_file_name 分割ファイル名
+ * @param[in] chunk_size 1チャンクのサイズ
+ * @param[in] chunk_stripe それぞれのチャンクの分割ファイル番号
+ * @param[in] chunk_count チャンクの数
+ * @param[in] total_size 結合したファイルのサイズ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRawFileStripe::WriteManifest(const wchar_t* manifest_file_name, const int stripe_count, const wchar_t stripe_file_name[][_MAX_PATH],
+									const __int64 chunk_size, const unsigned char* chunk_stripe, const __int64 chunk_count, const __int64 total_size)
+{
+	if ((manifest_file_name == nullptr) || (stripe_file_name == nullptr) || ((chunk_stripe == nullptr) && (chunk_count > 0)) ||
+		(stripe_count < 1) || (stripe_count > kISC_SAVE_MAX_SAVE_FOLDER_COUNT)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	HANDLE handle_file = CreateFile(manifest_file_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle_file == INVALID_HANDLE_VALUE) {
+		return CAMCONTROL_E_CREATE_SAVE_FILE;
+	}
+
+	IscRawStripeManifestHeader manifest_header = {};
+	sprintf_s(manifest_header.mark, "%s", kISC_RAW_STRIPE_MARK);
+	manifest_header.version = ISC_RAW_STRIPE_MANIFEST_VERSION;
+	manifest_header.header_size = sizeof(IscRawStripeManifestHeader);
+	manifest_header.stripe_count = stripe_count;
+	manifest_header.chunk_size = chunk_size;
+	manifest_header.chunk_count = chunk_count;
+	manifest_header.total_size = total_size;
+
+	DWORD written_size = 0;
+	BOOL ret = WriteFile(handle_file, &manifest_header, sizeof(manifest_header), &written_size, NULL);
+	if (ret) {
+		ret = WriteFile(handle_file, stripe_file_name, (DWORD)(sizeof(wchar_t) * _MAX_PATH * stripe_count), &written_size, NULL);
+	}
+	if (ret && (chunk_count > 0)) {
+		ret = WriteFile(handle_file, chunk_stripe, (DWORD)chunk_count, &written_size, NULL);
+	}
+
+	CloseHandle(handle_file);
+
+	if (!ret) {
+		return CAMCONTROL_E_WRITE_FAILED;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * マニフェストのファイル名から分割ファイル名を作成します
+ *
+ * @param[in] manifest_file_name マニフェストのファイル名
+ * @param[in] stripe_folder 分割ファイルの保存先
+ * @param[in] stripe_index 分割ファイルの番号
+ * @param[out] stripe_file_name 分割ファイル名
+ * @param[in] max_length stripe_file_nameの長さ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note <保存先>\<マニフェストのファイル名>.s<番号> とします
+ */
+int IscRawFileStripe::MakeStripeFileName(const wchar_t* manifest_file_name, const wchar_t* stripe_folder, const int stripe_index, wchar_t* stripe_file_name, const int max_length)
+{
+	if ((manifest_file_name == nullptr) || (stripe_folder == nullptr) || (stripe_file_name == nullptr) || (max_length <= 0)) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	const wchar_t* file_name = ::PathFindFileName(manifest_file_name);
+	if (swprintf_s(stripe_file_name, max_length, L"%s\\%s.s%02d", stripe_folder, file_name, stripe_index) < 0) {
+		return CAMCONTROL_E_INVALID_PARAMETER;
+	}
+
+	return DPC_E_OK;
+}
+
+/**
+ * ファイルがマニフェストかを確認します
+ *
+ * @param[in] file_name ファイル名
+ * @retval true マニフェスト
+ * @retval false マニフェストではない
+ */
+bool IscRawFileStripe::IsManifest(const wchar_t* file_name)
+{
+	if (file_name == nullptr) {
+		return false;
+	}
+
+	HANDLE handle_file = CreateFile(file_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (handle_file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	char mark[32] = {};
+	DWORD readed_size = 0;
+	BOOL ret = ReadFile(handle_file, mark, sizeof(mark), &readed_size, NULL);
+	CloseHandle(handle_file);
+
+	if (!ret || (readed_size != sizeof(mark))) {
+		return false;
+	}
+	mark[sizeof(mark) - 1] = 0;
+
+	return (strcmp(mark, kISC_RAW_STRIPE_MARK) == 0);
+}
@@ -116,6 +116,11 @@ public:
 	*/
 	int GetDataProcModuleData(IscDataProcResultData* isc_data_proc_result_data);
 
+	/** @brief get only the requested planes of module processing result into caller-owned buffers.
+		@return 0, if successful.
+	*/
+	int GetDataProcModuleDataPartial(IscDataProcPartialResultData* isc_data_proc_partial_result_data);
+
 	// data processing module 
 
 	/** @brief do the processing.
@@ -123,6 +128,69 @@ public:
 	*/
 	int Run(IscImageInfo* isc_image_info);
 
+	/** @brief set the function called when a processing result is stored.
+		@return none.
+	*/
+	void SetResultPublishedCallback(std::function<int(const IscDataProcResultData*)> func_result_published);
+
+	/** @brief set the function called with the block disparity when a processing result is stored.
+		@return none.
+	*/
+	void SetBlockDisparityPublishedCallback(std::function<int(const IscImageInfo*, const IscBlockDisparityData*)> func_block_disparity_published);
+
+	/** @brief do the processing in the calling thread into the caller's buffer. it is for the reprocessing of a file and is not used with Run().
+		@return 0, if successful.
+	*/
+	int RunOffline(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data, const IscBlockDisparityData** isc_block_disparity_data);
+
+	// admission control
+
+	/** @brief set the parameter of admission control.
+		@return 0, if successful.
+	*/
+	int SetAdmissionParameter(const IscDataProcAdmissionParameter* isc_dataproc_admission_parameter);
+
+	/** @brief get the parameter of admission control.
+		@return 0, if successful.
+	*/
+	int GetAdmissionParameter(IscDataProcAdmissionParameter* isc_dataproc_admission_parameter);
+
+	/** @brief get the status and the latest decisions of admission control.
+		@return 0, if successful.
+	*/
+	int GetAdmissionStatus(IscDataProcAdmissionStatus* isc_dataproc_admission_status);
+
+	// thread placement
+
+	/** @brief append the placement applied to the threads of data processing.
+		@return 0, if successful.
+	*/
+	int GetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status);
+
+	// preview
+
+	/** @brief set the parameter of the reduced-resolution preview.
+		@return 0, if successful.
+	*/
+	int SetPreviewParameter(const IscDataProcPreviewParameter* isc_dataproc_preview_parameter);
+
+	/** @brief get the parameter of the reduced-resolution preview.
+		@return 0, if successful.
+	*/
+	int GetPreviewParameter(IscDataProcPreviewParameter* isc_dataproc_preview_parameter);
+
+	/** @brief get the latest reduced-resolution preview into caller-owned buffers.
+		@return 0, if successful.
+	*/
+	int GetPreviewData(IscDataProcPreviewData* isc_dataproc_preview_data);
+
+	// play
+
+	/** @brief get the processing time of the frames read from file. the fields of the reading are not changed.
+		@return 0, if successful.
+	*/
+	int GetPlayStatistics(IscPlayStatistics* isc_play_statistics);
+
 private:
 
 	UtilityMeasureTime* measure_time_;
@@ -137,6 +205,77 @@ private:
 
 	IscBlockDisparityData isc_block_disparity_data_;
 
+	std::function<int(const IscDataProcResultData*)> result_published_callback_;
+	std::function<int(const IscImageInfo*, const IscBlockDisparityData*)> block_disparity_published_callback_;
+
+	// admission control
+	struct AdmissionControl {
+		IscDataProcAdmissionParameter parameter;
+		IscDataProcAdmissionStatus status;
+		int history_write_index;
+
+		bool proc_busy;
+		ULONGLONG proc_start_time;
+		double average_proc_time;
+		int over_budget_count;
+
+		__int64 next_sequence;
+		__int64 last_sequence;
+	};
+	AdmissionControl admission_control_;
+
+	// decision for each slot of the image ring buffer
+	struct AdmissionSlot {
+		__int64 sequence;
+		IscDataProcAdmissionDecision decision;
+		LARGE_INTEGER put_counter;		/**< time the frame was passed (for the play statistics) */
+	};
+	AdmissionSlot* admission_slot_;
+	int admission_slot_count_;
+
+	IscDataProcAdmissionPolicy current_admission_policy_;
+
+	// play from file
+	struct PlayControl {
+		bool is_lossless;					/**< kMaximumSpeed: wait for the processing thread instead of dropping the frame */
+		int pending_count;					/**< frames passed and not yet taken by the processing thread */
+		HANDLE handle_event_taken;
+		LARGE_INTEGER frequency;
+
+		__int64 processed_frame_count;
+		double processing_time_total_msec;
+		double processing_time_max_msec;
+		double processing_time_last_msec;
+		double backpressure_wait_msec;
+	};
+	PlayControl play_control_;
+
+	// preview
+	struct PreviewSlot {
+		__int64 preview_number;
+		__int64 frame_time;
+		__int64 data_index;
+		int frameNo;
+		int decimation;
+		bool is_block_disparity;
+
+		int width, height;
+		unsigned char* image;
+		float* depth;
+	};
+
+	struct PreviewControl {
+		IscDataProcPreviewParameter parameter;
+		ULONGLONG last_time;
+		__int64 preview_number;
+
+		int slot_count;
+		int latest_index;
+		PreviewSlot* slot;
+	};
+	PreviewControl preview_control_;
+	CRITICAL_SECTION preview_critical_;
+
 	// modules
 	IscFramedecoderInterface* isc_frame_decoder_;
 	IscStereoMatchingInterface* isc_stereo_matching_;
@@ -155,6 +294,8 @@ private:
 	HANDLE thread_handle_dataproc_;
 	CRITICAL_SECTION	threads_critical_dataproc_;
 
+	IscThreadPlacement* isc_thread_placement_;
+
 	static unsigned __stdcall ControlThreadDataProc(void* context);
 	int DataProc();
 
@@ -162,10 +303,17 @@ private:
 	int SyncRun(IscImageInfo* isc_image_info);
 	int AsyncRun(IscImageInfo* isc_image_info);
 	int ClearIscDataProcResultData(IscDataProcResultData* isc_data_proc_result_data);
+	int CopyOutputPlane(IscDataProcOutputPlane* output_plane, const void* src_image, const int width, const int height, const int channel_count, const int bytes_per_pixel);
+	bool DecideAdmission(const ULONGLONG time, const IscImageInfo* isc_image_info, IscDataProcAdmissionDecision* decision);
+	void RecordAdmissionDecision(IscDataProcAdmissionDecision* decision);
+	int PredictLatency(const ULONGLONG time, const int queue_age, const __int64 queued_count);
+	void WaitForFrameTaken();
+	int MakePreview(const IscImageInfo* isc_image_info, const IscDataProcResultData* isc_data_proc_result_data);
 
 	int RunDataProcModules(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data);
 	int RunDataProcStereoMatching(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data);
 	int RunDataProcFrameDecoder(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data);
 	int RunDataProcFrameDecoderInDoubleShutter(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data);
+	void MakeFixedPointBlockDisparity(IscBlockDisparityData* isc_block_disparity_data);
 
 };
@@ -29,12 +29,14 @@
 #include <tchar.h>
 #include <stdint.h>
 #include <process.h>
+#include <functional>
 
 #include "isc_dpl_error_def.h"
 #include "isc_camera_def.h"
 #include "isc_dataprocessing_def.h"
 
 #include "utility.h"
+#include "isc_thread_placement.h"
 #include "isc_image_info_ring_buffer.h"
 #include "isc_dataproc_resultdata_ring_buffer.h"
 #include "isc_framedecoder_interface.h"
@@ -61,6 +63,8 @@
 constexpr int kISC_DPL_MODULE_COUNT = 3;
 const wchar_t kISC_DPL_MODULE_NAME[kISC_DPL_MODULE_COUNT][32] = { L"S/W Stereo Matching", L"Frame Decoder", L"Disparity Filter" };
 
+constexpr DWORD kISC_DPL_PLAY_WAIT_LIMIT_MSEC = 5000;	/**< kMaximumSpeedで処理Threadを待つ上限 (処理が止まった場合の保護) */
+
 /**
  * constructor
  *
@@ -73,13 +77,23 @@ IscDataProcessingControl::IscDataProcessingControl():
     isc_image_info_ring_buffer_(nullptr),
     isc_dataproc_resultdata_ring_buffer_(nullptr),
     isc_block_disparity_data_(),
+    result_published_callback_(nullptr),
+    block_disparity_published_callback_(nullptr),
+    admission_control_(),
+    admission_slot_(nullptr),
+    admission_slot_count_(0),
+    current_admission_policy_(IscDataProcAdmissionPolicy::kAdmit),
+    play_control_(),
+    preview_control_(),
+    preview_critical_(),
     isc_frame_decoder_(nullptr),
     isc_stereo_matching_(nullptr),
     isc_disparity_filter_(nullptr),
 	thread_control_dataproc_(),
 	handle_semaphore_dataproc_(NULL),
 	thread_handle_dataproc_(NULL),
-	threads_critical_dataproc_()
+	threads_critical_dataproc_(),
+	isc_thread_placement_(nullptr)
 {
     measure_time_ = new UtilityMeasureTime;
 }
@@ -116,6 +130,12 @@ int IscDataProcessingControl::Initialize(IscDataProcModuleConfiguration* isc_dat
 
     isc_data_proc_module_configuration_.max_buffer_count = isc_data_proc_module_configuration->max_buffer_count;
 
+    isc_data_proc_module_configuration_.isc_thread_configuration = isc_data_proc_module_configuration->isc_thread_configuration;
+
+    // thread placement
+    isc_thread_placement_ = new IscThreadPlacement;
+    isc_thread_placement_->Initialize(&isc_data_proc_module_configuration_.isc_thread_configuration);
+
     // modules
     if (isc_data_proc_module_configuration_.enabled_data_proc_module) {
         isc_frame_decoder_ = new IscFramedecoderInterface;
@@ -175,23 +195,69 @@ int IscDataProcessingControl::Initialize(IscDataProcModuleConfiguration* isc_dat
         isc_dataproc_resultdata_ring_buffer_ = new IscDataprocResultdataRingBuffer;
         isc_dataproc_resultdata_ring_buffer_->Initialize(true, true, max_buffer_count, isc_data_proc_module_configuration_.max_image_width, isc_data_proc_module_configuration_.max_image_height, 3);
         isc_dataproc_resultdata_ring_buffer_->Clear();
+
+        admission_slot_count_ = max_buffer_count;
+        admission_slot_ = new AdmissionSlot[admission_slot_count_];
+        memset(admission_slot_, 0, sizeof(AdmissionSlot) * admission_slot_count_);
+
+        // preview is 1/kISC_DATAPROC_PREVIEW_MIN_DECIMATION at most
+        const size_t preview_size = (size_t)(isc_data_proc_module_configuration_.max_image_width / kISC_DATAPROC_PREVIEW_MIN_DECIMATION) *
+            (size_t)(isc_data_proc_module_configuration_.max_image_height / kISC_DATAPROC_PREVIEW_MIN_DECIMATION);
+
+        preview_control_.slot_count = 4;
+        preview_control_.slot = new PreviewSlot[preview_control_.slot_count];
+        for (int i = 0; i < preview_control_.slot_count; i++) {
+            PreviewSlot* slot = &preview_control_.slot[i];
+            slot->preview_number = 0;
+            slot->frame_time = 0;
+            slot->data_index = 0;
+            slot->frameNo = 0;
+            slot->decimation = 0;
+            slot->is_block_disparity = false;
+            slot->width = 0;
+            slot->height = 0;
+            slot->image = new unsigned char[preview_size];
+            slot->depth = new float[preview_size];
+        }
     }
 
+    // admission control is disabled by default
+    admission_control_.parameter.enabled = false;
+    admission_control_.parameter.latency_budget = 100;
+    admission_control_.parameter.over_budget_policy = IscDataProcAdmissionPolicy::kDrop;
+    admission_control_.parameter.reduced_depth = 0;
+    admission_control_.parameter.every_nth_frame = 2;
+    memset(&admission_control_.status, 0, sizeof(admission_control_.status));
+
+    // preview is disabled by default
+    preview_control_.parameter.enabled = false;
+    preview_control_.parameter.decimation = 4;
+    preview_control_.parameter.min_interval = 0;
+    preview_control_.last_time = 0;
+    preview_control_.preview_number = 0;
+    preview_control_.latest_index = -1;
+
     // create thread for data processing
     thread_control_dataproc_.terminate_request = 0;
     thread_control_dataproc_.terminate_done = 0;
     thread_control_dataproc_.end_code = 0;
     thread_control_dataproc_.stop_request = false;
 
-    char semaphoreName[64] = {};
-    sprintf_s(semaphoreName, "THREAD_SEMAPHORENAME_ISCDP_%d", 0);
-    handle_semaphore_dataproc_ = CreateSemaphoreA(NULL, 0, 1, semaphoreName);
+    handle_semaphore_dataproc_ = CreateSemaphoreA(NULL, 0, 1, NULL);
     if (handle_semaphore_dataproc_ == NULL) {
         // fail
 
         return DPCCONTROL_E_INVALID_DEVICEHANDLE;
     }
     InitializeCriticalSection(&threads_critical_dataproc_);
+    InitializeCriticalSection(&preview_critical_);
+
+    // play from file
+    play_control_.handle_event_taken = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (play_control_.handle_event_taken == NULL) {
+        return DPCCONTROL_E_INVALID_DEVICEHANDLE;
+    }
+    QueryPerformanceFrequency(&play_control_.frequency);
 
     if (isc_data_proc_module_configuration_.enabled_data_proc_module) {
         // it enabled process
@@ -207,6 +273,22 @@ int IscDataProcessingControl::Initialize(IscDataProcModuleConfiguration* isc_dat
         // THREAD_PRIORITY_NORMAL  +0
         // THREAD_PRIORITY_BELOW_NORMAL -1
         SetThreadPriority(thread_handle_dataproc_, THREAD_PRIORITY_NORMAL);
+
+        isc_thread_placement_->Apply(IscThreadRole::kDataProc, 0, thread_handle_dataproc_);
+
+        // band threads of the modules
+        HANDLE thread_handle[kISC_THREAD_PLACEMENT_MAX_COUNT] = {};
+        int thread_count = 0;
+        isc_stereo_matching_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT, thread_handle, &thread_count);
+        for (int i = 0; i < thread_count; i++) {
+            isc_thread_placement_->Apply(IscThreadRole::kStereoMatchingBand, i, thread_handle[i]);
+        }
+
+        thread_count = 0;
+        isc_disparity_filter_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT, thread_handle, &thread_count);
+        for (int i = 0; i < thread_count; i++) {
+            isc_thread_placement_->Apply(IscThreadRole::kDisparityFilterBand, i, thread_handle[i]);
+        }
     }
 
     measure_time_->Init();
@@ -251,7 +333,13 @@ int IscDataProcessingControl::Terminate()
         CloseHandle(handle_semaphore_dataproc_);
         handle_semaphore_dataproc_ = NULL;
     }
+
+    if (play_control_.handle_event_taken != NULL) {
+        CloseHandle(play_control_.handle_event_taken);
+        play_control_.handle_event_taken = NULL;
+    }
     DeleteCriticalSection(&threads_critical_dataproc_);
+    DeleteCriticalSection(&preview_critical_);
 
     if (isc_data_proc_module_configuration_.enabled_data_proc_module) {
 
@@ -293,6 +381,27 @@ int IscDataProcessingControl::Terminate()
         ReleaeIscIscBlockDisparityData(&isc_block_disparity_data_);
     }
 
+    delete[] admission_slot_;
+    admission_slot_ = nullptr;
+    admission_slot_count_ = 0;
+
+    if (preview_control_.slot != nullptr) {
+        for (int i = 0; i < preview_control_.slot_count; i++) {
+            delete[] preview_control_.slot[i].image;
+            delete[] preview_control_.slot[i].depth;
+        }
+        delete[] preview_control_.slot;
+        preview_control_.slot = nullptr;
+    }
+    preview_control_.slot_count = 0;
+    preview_control_.latest_index = -1;
+
+    if (isc_thread_placement_ != nullptr) {
+        isc_thread_placement_->Terminate();
+        delete isc_thread_placement_;
+        isc_thread_placement_ = nullptr;
+    }
+
     return DPC_E_OK;
 }
 
@@ -308,16 +417,46 @@ int IscDataProcessingControl::Start(const IscGrabStartMode* isc_grab_start_mode,
 {
 
     isc_grab_start_mode_.isc_play_mode = isc_grab_start_mode->isc_play_mode;
+    isc_grab_start_mode_.isc_play_mode_parameter.pacing_mode = isc_grab_start_mode->isc_play_mode_parameter.pacing_mode;
+    isc_grab_start_mode_.isc_play_mode_parameter.fixed_rate = isc_grab_start_mode->isc_play_mode_parameter.fixed_rate;
+    isc_grab_start_mode_.isc_play_mode_parameter.follow_growing_file = isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file;
 
     isc_dataproc_start_mode_.enabled_stereo_matching = isc_dataproc_start_mode->enabled_stereo_matching;
     isc_dataproc_start_mode_.enabled_frame_decoder = isc_dataproc_start_mode->enabled_frame_decoder;
     isc_dataproc_start_mode_.enabled_disparity_filter = isc_dataproc_start_mode->enabled_disparity_filter;
+    isc_dataproc_start_mode_.enabled_valid_block_list = isc_dataproc_start_mode->enabled_valid_block_list;
 
     if (isc_data_proc_module_configuration_.enabled_data_proc_module) {
         isc_image_info_ring_buffer_->Clear();
         isc_dataproc_resultdata_ring_buffer_->Clear();
     }
 
+    EnterCriticalSection(&threads_critical_dataproc_);
+    memset(&admission_control_.status, 0, sizeof(admission_control_.status));
+    admission_control_.history_write_index = 0;
+    admission_control_.proc_busy = false;
+    admission_control_.proc_start_time = 0;
+    admission_control_.average_proc_time = 0;
+    admission_control_.over_budget_count = 0;
+    admission_control_.next_sequence = 1;
+    admission_control_.last_sequence = 0;
+
+    // at maximum speed, the reading waits for the processing thread
+    play_control_.is_lossless = (isc_grab_start_mode_.isc_play_mode == IscPlayMode::kPlayOn) &&
+                                (isc_grab_start_mode_.isc_play_mode_parameter.pacing_mode == IscPlayPacingMode::kMaximumSpeed);
+    play_control_.pending_count = 0;
+    play_control_.processed_frame_count = 0;
+    play_control_.processing_time_total_msec = 0;
+    play_control_.processing_time_max_msec = 0;
+    play_control_.processing_time_last_msec = 0;
+    play_control_.backpressure_wait_msec = 0;
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    EnterCriticalSection(&preview_critical_);
+    preview_control_.last_time = 0;
+    preview_control_.latest_index = -1;
+    LeaveCriticalSection(&preview_critical_);
+
     measure_time_->Init();
 
     return DPC_E_OK;
@@ -536,6 +675,9 @@ int IscDataProcessingControl::InitializeIscBlockDisparityData(IscBlockDisparityD
 
     isc_stereo_disparity_data->pblkval = new int[frame_size];
     isc_stereo_disparity_data->pblkcrst = new int[frame_size];
+    isc_stereo_disparity_data->pblkfix = new unsigned short[frame_size];
+    isc_stereo_disparity_data->pvalidblk = new IscValidBlock[frame_size];
+    isc_stereo_disparity_data->validblkcnt = -1;
 
     isc_stereo_disparity_data->pdspimg = new unsigned char[frame_size];
     isc_stereo_disparity_data->ppxldsp = new float[frame_size];
@@ -576,6 +718,11 @@ int IscDataProcessingControl::ReleaeIscIscBlockDisparityData(IscBlockDisparityDa
     isc_stereo_disparity_data->pblkval = nullptr;
     delete[] isc_stereo_disparity_data->pblkcrst;
     isc_stereo_disparity_data->pblkcrst = nullptr;
+    delete[] isc_stereo_disparity_data->pblkfix;
+    isc_stereo_disparity_data->pblkfix = nullptr;
+    delete[] isc_stereo_disparity_data->pvalidblk;
+    isc_stereo_disparity_data->pvalidblk = nullptr;
+    isc_stereo_disparity_data->validblkcnt = -1;
 
     delete[] isc_stereo_disparity_data->pdspimg;
     isc_stereo_disparity_data->pdspimg = nullptr;
@@ -944,6 +1091,167 @@ int IscDataProcessingControl::GetDataProcModuleData(IscDataProcResultData* isc_d
     return DPC_E_OK;
 }
 
+/**
+ * モジュールの処理結果のうち、指定された項目のみを呼び出し側のバッファーへ取得します
+ *
+ * @param[in,out] isc_data_proc_partial_result_data 取得項目・バッファー指定と処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note
+ *  - field_maskで指定されていない、またはbufferがnullptrのPlaneはコピーしません
+ *  - コピーしなかったPlaneと有効なデータが無いPlaneは width/height/channel_count が0になります
+ */
+int IscDataProcessingControl::GetDataProcModuleDataPartial(IscDataProcPartialResultData* isc_data_proc_partial_result_data)
+{
+    if (isc_data_proc_partial_result_data == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    // the planes not copied report no data, including those excluded by field_mask and those left by a failure
+    IscDataProcOutputPlane* output_plane[] = {
+        &isc_data_proc_partial_result_data->p1, &isc_data_proc_partial_result_data->p2, &isc_data_proc_partial_result_data->color,
+        &isc_data_proc_partial_result_data->depth, &isc_data_proc_partial_result_data->raw, &isc_data_proc_partial_result_data->raw_color };
+    for (int i = 0; i < (int)(sizeof(output_plane) / sizeof(output_plane[0])); i++) {
+        output_plane[i]->width = 0;
+        output_plane[i]->height = 0;
+        output_plane[i]->channel_count = 0;
+    }
+
+    const int fd_index = isc_data_proc_partial_result_data->frame_data_index;
+    if (fd_index < 0 || fd_index >= kISCIMAGEINFO_FRAMEDATA_MAX_COUNT) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (!isc_data_proc_module_configuration_.enabled_data_proc_module) {
+        return CAMCONTROL_E_NO_IMAGE;
+    }
+
+    IscDataprocResultdataRingBuffer::BufferData* dataproc_result_buffer_data = nullptr;
+    ULONGLONG time = 0;
+    int get_index = isc_dataproc_resultdata_ring_buffer_->GetGetBuffer(&dataproc_result_buffer_data, &time);
+
+    if (get_index < 0) {
+        isc_dataproc_resultdata_ring_buffer_->DoneGetBuffer(get_index);
+        return CAMCONTROL_E_NO_IMAGE;
+    }
+
+    IscDataProcResultData* src_result_data = &dataproc_result_buffer_data->isc_dataproc_resultdata;
+    IscDataProcPartialResultData* dst = isc_data_proc_partial_result_data;
+
+    dst->number_of_modules_processed = src_result_data->number_of_modules_processed;
+    dst->status.error_code = src_result_data->status.error_code;
+    dst->status.proc_tact_time = src_result_data->status.proc_tact_time;
+
+    for (int i = 0; i < src_result_data->number_of_modules_processed; i++) {
+        sprintf_s(dst->module_status[i].module_names, "%s", src_result_data->module_status[i].module_names);
+        dst->module_status[i].error_code = src_result_data->module_status[i].error_code;
+        dst->module_status[i].processing_time = src_result_data->module_status[i].processing_time;
+    }
+
+    // metadata
+    IscImageInfo* src_isc_image_info = &src_result_data->isc_image_info;
+    IscImageInfo::FrameData* src_frame_data = &src_isc_image_info->frame_data[fd_index];
+
+    dst->grab = src_isc_image_info->grab;
+    dst->color_grab_mode = src_isc_image_info->color_grab_mode;
+    dst->shutter_mode = src_isc_image_info->shutter_mode;
+    dst->camera_specific_parameter = src_isc_image_info->camera_specific_parameter;
+
+    dst->camera_status = src_frame_data->camera_status;
+    dst->frame_time = src_frame_data->frame_time;
+    dst->data_index = src_frame_data->data_index;
+    dst->frameNo = src_frame_data->frameNo;
+    dst->gain = src_frame_data->gain;
+    dst->exposure = src_frame_data->exposure;
+
+    // planes, only requested
+    const unsigned int field_mask = dst->field_mask;
+    int ret = DPC_E_OK;
+
+    if ((field_mask & kISC_DATAPROC_FIELD_P1) != 0 && ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&dst->p1, src_frame_data->p1.image, src_frame_data->p1.width, src_frame_data->p1.height, src_frame_data->p1.channel_count, src_frame_data->p1.channel_count);
+    }
+    if ((field_mask & kISC_DATAPROC_FIELD_P2) != 0 && ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&dst->p2, src_frame_data->p2.image, src_frame_data->p2.width, src_frame_data->p2.height, src_frame_data->p2.channel_count, src_frame_data->p2.channel_count);
+    }
+    if ((field_mask & kISC_DATAPROC_FIELD_COLOR) != 0 && ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&dst->color, src_frame_data->color.image, src_frame_data->color.width, src_frame_data->color.height, src_frame_data->color.channel_count, src_frame_data->color.channel_count);
+    }
+    if ((field_mask & kISC_DATAPROC_FIELD_DEPTH) != 0 && ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&dst->depth, src_frame_data->depth.image, src_frame_data->depth.width, src_frame_data->depth.height, 1, sizeof(float));
+    }
+    if ((field_mask & kISC_DATAPROC_FIELD_RAW) != 0 && ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&dst->raw, src_frame_data->raw.image, src_frame_data->raw.width, src_frame_data->raw.height, src_frame_data->raw.channel_count, src_frame_data->raw.channel_count);
+    }
+    if ((field_mask & kISC_DATAPROC_FIELD_RAW_COLOR) != 0 && ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&dst->raw_color, src_frame_data->raw_color.image, src_frame_data->raw_color.width, src_frame_data->raw_color.height, src_frame_data->raw_color.channel_count, src_frame_data->raw_color.channel_count);
+    }
+
+    isc_dataproc_resultdata_ring_buffer_->DoneGetBuffer(get_index);
+
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 1Plane分のデータを呼び出し側のバッファーへコピーします
+ *
+ * @param[in,out] output_plane コピー先
+ * @param[in] src_image コピー元
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[in] channel_count チャンネル数
+ * @param[in] bytes_per_pixel 1画素のバイト数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataProcessingControl::CopyOutputPlane(IscDataProcOutputPlane* output_plane, const void* src_image, const int width, const int height, const int channel_count, const int bytes_per_pixel)
+{
+    output_plane->width = 0;
+    output_plane->height = 0;
+    output_plane->channel_count = 0;
+
+    if (output_plane->buffer == nullptr) {
+        return DPC_E_OK;
+    }
+
+    if (width <= 0 || height <= 0 || bytes_per_pixel <= 0) {
+        // no valid data
+        return DPC_E_OK;
+    }
+
+    const size_t src_pitch = (size_t)width * bytes_per_pixel;
+    const size_t dst_pitch = output_plane->pitch > 0 ? (size_t)output_plane->pitch : src_pitch;
+
+    if (dst_pitch < src_pitch) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+    if (output_plane->buffer_size < dst_pitch * (height - 1) + src_pitch) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    const unsigned char* src = (const unsigned char*)src_image;
+    unsigned char* dst = (unsigned char*)output_plane->buffer;
+
+    if (dst_pitch == src_pitch) {
+        memcpy(dst, src, src_pitch * height);
+    }
+    else {
+        for (int y = 0; y < height; y++) {
+            memcpy(dst + dst_pitch * y, src + src_pitch * y, src_pitch);
+        }
+    }
+
+    output_plane->width = width;
+    output_plane->height = height;
+    output_plane->channel_count = channel_count;
+
+    return DPC_E_OK;
+}
+
 /**
  * データ処理を呼び出します
  *
@@ -990,6 +1298,612 @@ int IscDataProcessingControl::Run(IscImageInfo* isc_image_info)
     return DPC_E_OK;
 }
 
+/**
+ * 処理結果が格納された時に呼び出す関数を設定します
+ *
+ * @param[in] func_result_published 呼び出す関数
+ * @return none
+ * @note データ処理Threadから呼び出されます。処理をブロックしないでください
+ */
+void IscDataProcessingControl::SetResultPublishedCallback(std::function<int(const IscDataProcResultData*)> func_result_published)
+{
+    result_published_callback_ = func_result_published;
+
+    return;
+}
+
+/**
+ * 処理結果が格納された時に、ブロック視差を渡して呼び出す関数を設定します
+ *
+ * @param[in] func_block_disparity_published 呼び出す関数
+ * @return none
+ * @note データ処理Threadから呼び出されます。ブロック視差は呼び出し中のみ有効です
+ */
+void IscDataProcessingControl::SetBlockDisparityPublishedCallback(std::function<int(const IscImageInfo*, const IscBlockDisparityData*)> func_block_disparity_published)
+{
+    block_disparity_published_callback_ = func_block_disparity_published;
+
+    return;
+}
+
+/**
+ * 呼び出し元のThreadで処理を行い、指定のバッファーに結果を格納します
+ *
+ * @param[in] isc_image_info 入力データ
+ * @param[out] isc_data_proc_result_data 処理結果データ
+ * @param[out] isc_block_disparity_data ブロック視差 次の呼び出しまで有効です
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note ファイルの再処理用です。受付制御は行わず、Run()と同時には使用しません
+ */
+int IscDataProcessingControl::RunOffline(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data, const IscBlockDisparityData** isc_block_disparity_data)
+{
+    if (isc_image_info == nullptr || isc_data_proc_result_data == nullptr || isc_block_disparity_data == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (!isc_data_proc_module_configuration_.enabled_data_proc_module || isc_frame_decoder_ == nullptr) {
+        return DPCCONTROL_E_INVALID_DEVICEHANDLE;
+    }
+
+    // all frames are processed with the full parameter
+    current_admission_policy_ = IscDataProcAdmissionPolicy::kAdmit;
+    if (isc_stereo_matching_ != nullptr) {
+        isc_stereo_matching_->SetMatchingDepthOverride(0);
+    }
+
+    int ret = RunDataProcModules(isc_image_info, isc_data_proc_result_data);
+
+    *isc_block_disparity_data = &isc_block_disparity_data_;
+
+    return ret;
+}
+
+/**
+ * 受付制御のパラメータを設定します
+ *
+ * @param[in] isc_dataproc_admission_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次のフレームから反映されます
+ */
+int IscDataProcessingControl::SetAdmissionParameter(const IscDataProcAdmissionParameter* isc_dataproc_admission_parameter)
+{
+    if (isc_dataproc_admission_parameter == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_dataproc_admission_parameter->latency_budget <= 0) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_dataproc_admission_parameter->over_budget_policy == IscDataProcAdmissionPolicy::kReducedDepth &&
+        isc_dataproc_admission_parameter->reduced_depth <= 0) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_dataproc_admission_parameter->over_budget_policy == IscDataProcAdmissionPolicy::kEveryNthFrame &&
+        isc_dataproc_admission_parameter->every_nth_frame <= 0) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&threads_critical_dataproc_);
+    admission_control_.parameter = *isc_dataproc_admission_parameter;
+    admission_control_.over_budget_count = 0;
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 受付制御のパラメータを取得します
+ *
+ * @param[out] isc_dataproc_admission_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataProcessingControl::GetAdmissionParameter(IscDataProcAdmissionParameter* isc_dataproc_admission_parameter)
+{
+    if (isc_dataproc_admission_parameter == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&threads_critical_dataproc_);
+    *isc_dataproc_admission_parameter = admission_control_.parameter;
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 受付制御の状態と最新の判定結果を取得します
+ *
+ * @param[out] isc_dataproc_admission_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 判定結果は古い順に格納されます
+ */
+int IscDataProcessingControl::GetAdmissionStatus(IscDataProcAdmissionStatus* isc_dataproc_admission_status)
+{
+    if (isc_dataproc_admission_status == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&threads_critical_dataproc_);
+
+    const IscDataProcAdmissionStatus* status = &admission_control_.status;
+
+    isc_dataproc_admission_status->total_decision_count = status->total_decision_count;
+    isc_dataproc_admission_status->admitted_count = status->admitted_count;
+    isc_dataproc_admission_status->downgraded_count = status->downgraded_count;
+    isc_dataproc_admission_status->dropped_count = status->dropped_count;
+    isc_dataproc_admission_status->superseded_count = status->superseded_count;
+    isc_dataproc_admission_status->average_proc_time = (int)admission_control_.average_proc_time;
+
+    // history is a ring, copy from the oldest
+    const int decision_count = status->decision_count;
+    int read_index = admission_control_.history_write_index - decision_count;
+    if (read_index < 0) {
+        read_index += kISC_DATAPROC_ADMISSION_HISTORY_COUNT;
+    }
+    for (int i = 0; i < decision_count; i++) {
+        isc_dataproc_admission_status->decision[i] = status->decision[read_index];
+        read_index = (read_index + 1) % kISC_DATAPROC_ADMISSION_HISTORY_COUNT;
+    }
+    isc_dataproc_admission_status->decision_count = decision_count;
+
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * Threadに適用した配置を取得します
+ *
+ * @param[in,out] isc_thread_placement_status 配置の一覧　placement_countの後に追加します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataProcessingControl::GetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status)
+{
+    if (isc_thread_placement_status == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_thread_placement_ == nullptr) {
+        return DPC_E_OK;
+    }
+
+    isc_thread_placement_->GetPlacement(isc_thread_placement_status);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 縮小プレビューのパラメータを設定します
+ *
+ * @param[in] isc_dataproc_preview_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の処理結果から反映されます
+ */
+int IscDataProcessingControl::SetPreviewParameter(const IscDataProcPreviewParameter* isc_dataproc_preview_parameter)
+{
+    if (isc_dataproc_preview_parameter == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_dataproc_preview_parameter->decimation < kISC_DATAPROC_PREVIEW_MIN_DECIMATION ||
+        isc_dataproc_preview_parameter->decimation > kISC_DATAPROC_PREVIEW_MAX_DECIMATION) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_dataproc_preview_parameter->min_interval < 0) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&preview_critical_);
+    preview_control_.parameter = *isc_dataproc_preview_parameter;
+    LeaveCriticalSection(&preview_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 縮小プレビューのパラメータを取得します
+ *
+ * @param[out] isc_dataproc_preview_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataProcessingControl::GetPreviewParameter(IscDataProcPreviewParameter* isc_dataproc_preview_parameter)
+{
+    if (isc_dataproc_preview_parameter == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&preview_critical_);
+    *isc_dataproc_preview_parameter = preview_control_.parameter;
+    LeaveCriticalSection(&preview_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新の縮小プレビューを呼び出し側のバッファーへ取得します
+ *
+ * @param[in,out] isc_dataproc_preview_data 取得先
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 一度取得したプレビューも、次のプレビューが作成されるまで再度取得できます
+ */
+int IscDataProcessingControl::GetPreviewData(IscDataProcPreviewData* isc_dataproc_preview_data)
+{
+    if (isc_dataproc_preview_data == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    isc_dataproc_preview_data->preview_number = 0;
+    isc_dataproc_preview_data->frame_time = 0;
+    isc_dataproc_preview_data->data_index = 0;
+    isc_dataproc_preview_data->frameNo = 0;
+    isc_dataproc_preview_data->decimation = 0;
+    isc_dataproc_preview_data->is_block_disparity = false;
+
+    if (preview_control_.slot == nullptr) {
+        return CAMCONTROL_E_NO_IMAGE;
+    }
+
+    EnterCriticalSection(&preview_critical_);
+
+    if (preview_control_.latest_index < 0) {
+        LeaveCriticalSection(&preview_critical_);
+        return CAMCONTROL_E_NO_IMAGE;
+    }
+
+    // the slot is not overwritten while holding the lock
+    const PreviewSlot* slot = &preview_control_.slot[preview_control_.latest_index];
+
+    isc_dataproc_preview_data->preview_number = slot->preview_number;
+    isc_dataproc_preview_data->frame_time = slot->frame_time;
+    isc_dataproc_preview_data->data_index = slot->data_index;
+    isc_dataproc_preview_data->frameNo = slot->frameNo;
+    isc_dataproc_preview_data->decimation = slot->decimation;
+    isc_dataproc_preview_data->is_block_disparity = slot->is_block_disparity;
+
+    int ret = CopyOutputPlane(&isc_dataproc_preview_data->image, slot->image, slot->width, slot->height, 1, sizeof(unsigned char));
+    if (ret == DPC_E_OK) {
+        ret = CopyOutputPlane(&isc_dataproc_preview_data->depth, slot->depth, slot->width, slot->height, 1, sizeof(float));
+    }
+
+    LeaveCriticalSection(&preview_critical_);
+
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ファイルから読み込んだフレームの処理時間を取得します
+ *
+ * @param[in,out] isc_play_statistics 取得先
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 読み込みの項目は変更しません 処理時間は、データ処理へ渡してから処理結果ができるまでの時間です
+ */
+int IscDataProcessingControl::GetPlayStatistics(IscPlayStatistics* isc_play_statistics)
+{
+    if (isc_play_statistics == nullptr) {
+        return DPCCONTROL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&threads_critical_dataproc_);
+    isc_play_statistics->processed_frame_count = play_control_.processed_frame_count;
+    isc_play_statistics->processing_time_average_msec = (play_control_.processed_frame_count > 0) ? play_control_.processing_time_total_msec / (double)play_control_.processed_frame_count : 0;
+    isc_play_statistics->processing_time_max_msec = play_control_.processing_time_max_msec;
+    isc_play_statistics->processing_time_last_msec = play_control_.processing_time_last_msec;
+    isc_play_statistics->backpressure_wait_msec = play_control_.backpressure_wait_msec;
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * フレームを受け付けるか判定します
+ *
+ * @param[in] time 入力時刻
+ * @param[in] isc_image_info 入力データ
+ * @param[out] decision 判定結果
+ * @retval true 処理します
+ * @retval false 破棄します
+ * @note 処理中のフレームの残り時間、先に待っているフレーム数と平均処理時間から完了までの時間を予測します
+ */
+bool IscDataProcessingControl::DecideAdmission(const ULONGLONG time, const IscImageInfo* isc_image_info, IscDataProcAdmissionDecision* decision)
+{
+    decision->data_index = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].data_index;
+    decision->frameNo = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frameNo;
+    decision->policy = IscDataProcAdmissionPolicy::kAdmit;
+    decision->processed = true;
+    decision->queue_age = 0;
+    decision->predicted_latency = 0;
+
+    EnterCriticalSection(&threads_critical_dataproc_);
+
+    if (!admission_control_.parameter.enabled) {
+        LeaveCriticalSection(&threads_critical_dataproc_);
+        return true;
+    }
+
+    // frames passed and not yet taken by the processing thread are processed before this frame
+    __int64 queued_count = admission_control_.next_sequence - 1 - admission_control_.last_sequence;
+    if (queued_count < 0) {
+        queued_count = 0;
+    }
+    decision->queue_age = (int)(GetTickCount64() - time);
+    decision->predicted_latency = PredictLatency(time, decision->queue_age, queued_count);
+
+    if (decision->predicted_latency <= admission_control_.parameter.latency_budget) {
+        admission_control_.over_budget_count = 0;
+        LeaveCriticalSection(&threads_critical_dataproc_);
+        return true;
+    }
+
+    decision->policy = admission_control_.parameter.over_budget_policy;
+
+    switch (decision->policy) {
+    case IscDataProcAdmissionPolicy::kDrop:
+        decision->processed = false;
+        break;
+
+    case IscDataProcAdmissionPolicy::kEveryNthFrame:
+        // the first frame over the budget is processed
+        if ((admission_control_.over_budget_count % admission_control_.parameter.every_nth_frame) != 0) {
+            decision->processed = false;
+        }
+        admission_control_.over_budget_count++;
+        break;
+
+    default:
+        break;
+    }
+
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return decision->processed;
+}
+
+/**
+ * フレームの処理が完了するまでの時間を予測します
+ *
+ * @param[in] time 現在時刻
+ * @param[in] queue_age フレームを受け付けてからの時間(msec)
+ * @param[in] queued_count 先に処理されるフレームの数(処理中のフレームを除く)
+ * @return 予測時間(msec) フレームを受け付けてから処理完了まで
+ * @note threads_critical_dataproc_ 内で呼び出します
+ */
+int IscDataProcessingControl::PredictLatency(const ULONGLONG time, const int queue_age, const __int64 queued_count)
+{
+    const double average_proc_time = admission_control_.average_proc_time;
+
+    // remaining time of the frame in process
+    double wait_time = 0;
+    if (admission_control_.proc_busy) {
+        wait_time = average_proc_time - (double)(time - admission_control_.proc_start_time);
+        if (wait_time < 0) {
+            wait_time = 0;
+        }
+    }
+
+    const double predicted_latency = (double)queue_age + wait_time + ((double)queued_count * average_proc_time) + average_proc_time;
+
+    return (int)predicted_latency;
+}
+
+/**
+ * 判定結果を記録します
+ *
+ * @param[in] decision 判定結果
+ * @return none
+ */
+void IscDataProcessingControl::RecordAdmissionDecision(IscDataProcAdmissionDecision* decision)
+{
+    EnterCriticalSection(&threads_critical_dataproc_);
+
+    IscDataProcAdmissionStatus* status = &admission_control_.status;
+
+    status->total_decision_count++;
+    decision->decision_number = status->total_decision_count;
+
+    if (!decision->processed) {
+        status->dropped_count++;
+    }
+    else if (decision->policy == IscDataProcAdmissionPolicy::kAdmit || decision->policy == IscDataProcAdmissionPolicy::kEveryNthFrame) {
+        status->admitted_count++;
+    }
+    else {
+        status->downgraded_count++;
+    }
+
+    status->decision[admission_control_.history_write_index] = *decision;
+    admission_control_.history_write_index = (admission_control_.history_write_index + 1) % kISC_DATAPROC_ADMISSION_HISTORY_COUNT;
+    if (status->decision_count < kISC_DATAPROC_ADMISSION_HISTORY_COUNT) {
+        status->decision_count++;
+    }
+
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return;
+}
+
+/**
+ * 処理結果から縮小プレビューを作成します
+ *
+ * @param[in] isc_image_info 入力データ
+ * @param[in] isc_data_proc_result_data 処理結果データ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note
+ *  - 視差はブロック視差から作成し、等倍の中間データは作成しません  
+ *  - ブロック視差が無い場合は視差画像の有効画素を平均します  
+ *  - 最新以外のSlotへ書き込み、完了後に最新として公開します  
+ *  - 処理結果の通知の後に呼び出します
+ */
+int IscDataProcessingControl::MakePreview(const IscImageInfo* isc_image_info, const IscDataProcResultData* isc_data_proc_result_data)
+{
+    if (preview_control_.slot == nullptr) {
+        return DPC_E_OK;
+    }
+
+    EnterCriticalSection(&preview_critical_);
+    const IscDataProcPreviewParameter parameter = preview_control_.parameter;
+    const ULONGLONG last_time = preview_control_.last_time;
+    const int write_index = (preview_control_.latest_index + 1) % preview_control_.slot_count;
+    LeaveCriticalSection(&preview_critical_);
+
+    if (!parameter.enabled) {
+        return DPC_E_OK;
+    }
+
+    // rate limit
+    const ULONGLONG time = GetTickCount64();
+    if (parameter.min_interval > 0 && last_time != 0 && (time - last_time) < (ULONGLONG)parameter.min_interval) {
+        return DPC_E_OK;
+    }
+
+    const int fd_index = (isc_image_info->shutter_mode == IscShutterMode::kDoubleShutter) ? kISCIMAGEINFO_FRAMEDATA_MERGED : kISCIMAGEINFO_FRAMEDATA_LATEST;
+    const IscImageInfo::FrameData* frame_data = &isc_data_proc_result_data->isc_image_info.frame_data[fd_index];
+
+    int width = frame_data->p1.width;
+    int height = frame_data->p1.height;
+    if (width == 0 || height == 0) {
+        width = frame_data->depth.width;
+        height = frame_data->depth.height;
+    }
+
+    const int decimation = parameter.decimation;
+    const int preview_width = width / decimation;
+    const int preview_height = height / decimation;
+    if (preview_width <= 0 || preview_height <= 0) {
+        return DPC_E_OK;
+    }
+
+    PreviewSlot* slot = &preview_control_.slot[write_index];
+
+    // (1) base image, average of decimation x decimation pixels
+    const bool is_image = frame_data->p1.width == width && frame_data->p1.height == height && frame_data->p1.image != nullptr;
+    if (is_image) {
+        const int channel_count = frame_data->p1.channel_count > 0 ? frame_data->p1.channel_count : 1;
+        const int src_pitch = width * channel_count;
+        const int area = decimation * decimation;
+
+        for (int y = 0; y < preview_height; y++) {
+            unsigned char* dst = slot->image + (size_t)y * preview_width;
+            for (int x = 0; x < preview_width; x++) {
+                const unsigned char* src = frame_data->p1.image + (size_t)y * decimation * src_pitch + (size_t)x * decimation * channel_count;
+                int sum = 0;
+                for (int j = 0; j < decimation; j++) {
+                    const unsigned char* src_row = src + (size_t)j * src_pitch;
+                    for (int i = 0; i < decimation; i++) {
+                        sum += src_row[i * channel_count];
+                    }
+                }
+                dst[x] = (unsigned char)(sum / area);
+            }
+        }
+    }
+    else {
+        memset(slot->image, 0, (size_t)preview_width * preview_height);
+    }
+
+    // (2) disparity
+    const IscBlockDisparityData* block_data = &isc_block_disparity_data_;
+    const bool is_block_disparity = block_data->image_width == width && block_data->image_height == height &&
+        block_data->blkwdt > 0 && block_data->blkhgt > 0 && block_data->pblkdsp != nullptr;
+
+    if (is_block_disparity) {
+        // average of the valid blocks covered by the preview pixel
+        const int block_width = block_data->blkwdt;
+        const int block_height = block_data->blkhgt;
+        const int block_count_x = width / block_width;
+        const int block_count_y = height / block_height;
+
+        for (int y = 0; y < preview_height; y++) {
+            float* dst = slot->depth + (size_t)y * preview_width;
+
+            const int by0 = (y * decimation) / block_height;
+            int by1 = (y * decimation + decimation - 1) / block_height;
+            if (by1 >= block_count_y) {
+                by1 = block_count_y - 1;
+            }
+
+            for (int x = 0; x < preview_width; x++) {
+                const int bx0 = (x * decimation) / block_width;
+                int bx1 = (x * decimation + decimation - 1) / block_width;
+                if (bx1 >= block_count_x) {
+                    bx1 = block_count_x - 1;
+                }
+
+                float sum = 0;
+                int count = 0;
+                for (int by = by0; by <= by1; by++) {
+                    const float* src = block_data->pblkdsp + (size_t)by * block_count_x;
+                    for (int bx = bx0; bx <= bx1; bx++) {
+                        if (src[bx] > 0) {
+                            sum += src[bx];
+                            count++;
+                        }
+                    }
+                }
+                dst[x] = count > 0 ? sum / count : 0;
+            }
+        }
+    }
+    else if (frame_data->depth.width == width && frame_data->depth.height == height && frame_data->depth.image != nullptr) {
+        // average of the valid pixels
+        for (int y = 0; y < preview_height; y++) {
+            float* dst = slot->depth + (size_t)y * preview_width;
+            for (int x = 0; x < preview_width; x++) {
+                const float* src = frame_data->depth.image + (size_t)y * decimation * width + (size_t)x * decimation;
+                float sum = 0;
+                int count = 0;
+                for (int j = 0; j < decimation; j++) {
+                    const float* src_row = src + (size_t)j * width;
+                    for (int i = 0; i < decimation; i++) {
+                        if (src_row[i] > 0) {
+                            sum += src_row[i];
+                            count++;
+                        }
+                    }
+                }
+                dst[x] = count > 0 ? sum / count : 0;
+            }
+        }
+    }
+    else {
+        memset(slot->depth, 0, (size_t)preview_width * preview_height * sizeof(float));
+    }
+
+    slot->frame_time = frame_data->frame_time;
+    slot->data_index = frame_data->data_index;
+    slot->frameNo = frame_data->frameNo;
+    slot->decimation = decimation;
+    slot->is_block_disparity = is_block_disparity;
+    slot->width = preview_width;
+    slot->height = preview_height;
+
+    // publish
+    EnterCriticalSection(&preview_critical_);
+    preview_control_.preview_number++;
+    slot->preview_number = preview_control_.preview_number;
+    preview_control_.latest_index = write_index;
+    preview_control_.last_time = time;
+    LeaveCriticalSection(&preview_critical_);
+
+    return DPC_E_OK;
+}
+
 /**
  * データ処理Threadです
  *
@@ -1040,6 +1954,57 @@ int IscDataProcessingControl::DataProc()
             int get_index = isc_image_info_ring_buffer_->GetGetBuffer(&image_info_buffer_data, &time);
 
             if (get_index >= 0) {
+                // the reading can pass the next frame
+                EnterCriticalSection(&threads_critical_dataproc_);
+                if (play_control_.pending_count > 0) {
+                    play_control_.pending_count--;
+                }
+                LeaveCriticalSection(&threads_critical_dataproc_);
+                SetEvent(play_control_.handle_event_taken);
+            }
+
+            bool is_admitted = true;
+            if (get_index >= 0 && admission_slot_ != nullptr && get_index < admission_slot_count_) {
+                // check the age of the frame with the decision made at AsyncRun
+                const ULONGLONG time_now = GetTickCount64();
+                AdmissionSlot* admission_slot = &admission_slot_[get_index];
+                admission_slot->decision.queue_age = (int)(time_now - time);
+
+                EnterCriticalSection(&threads_critical_dataproc_);
+                // this frame is processed next
+                admission_slot->decision.predicted_latency = PredictLatency(time_now, admission_slot->decision.queue_age, 0);
+                const IscDataProcAdmissionParameter parameter = admission_control_.parameter;
+                const bool is_lossless = play_control_.is_lossless;
+
+                // frames admitted but overwritten by a newer one
+                if (admission_control_.last_sequence != 0 && admission_slot->sequence > admission_control_.last_sequence + 1) {
+                    admission_control_.status.superseded_count += admission_slot->sequence - admission_control_.last_sequence - 1;
+                }
+                admission_control_.last_sequence = admission_slot->sequence;
+                LeaveCriticalSection(&threads_critical_dataproc_);
+
+                if (parameter.enabled && !is_lossless) {
+                    if (admission_slot->decision.predicted_latency > parameter.latency_budget &&
+                        parameter.over_budget_policy == IscDataProcAdmissionPolicy::kDrop) {
+                        // it will be too old when processed
+                        admission_slot->decision.policy = IscDataProcAdmissionPolicy::kDrop;
+                        admission_slot->decision.processed = false;
+                        is_admitted = false;
+                    }
+                    RecordAdmissionDecision(&admission_slot->decision);
+                    current_admission_policy_ = admission_slot->decision.policy;
+                }
+                else {
+                    current_admission_policy_ = IscDataProcAdmissionPolicy::kAdmit;
+                }
+
+                if (isc_stereo_matching_ != nullptr) {
+                    const int matching_depth = (current_admission_policy_ == IscDataProcAdmissionPolicy::kReducedDepth) ? parameter.reduced_depth : 0;
+                    isc_stereo_matching_->SetMatchingDepthOverride(matching_depth);
+                }
+            }
+
+            if (get_index >= 0 && is_admitted) {
                 // there is an image
 
                 // get buffer for proc
@@ -1049,12 +2014,57 @@ int IscDataProcessingControl::DataProc()
                 int image_status = 0;
 
                 if (put_index >= 0 && dataproc_result_buffer_data != nullptr) {
+                    EnterCriticalSection(&threads_critical_dataproc_);
+                    admission_control_.proc_busy = true;
+                    admission_control_.proc_start_time = time;
+                    LeaveCriticalSection(&threads_critical_dataproc_);
+
                     // call data processing
                     int dp_ret = RunDataProcModules(&image_info_buffer_data->isc_image_info, &dataproc_result_buffer_data->isc_dataproc_resultdata);
 
+                    // update the average processing time for the prediction
+                    const double proc_time = (double)(GetTickCount64() - time);
+                    EnterCriticalSection(&threads_critical_dataproc_);
+                    if (admission_control_.average_proc_time <= 0) {
+                        admission_control_.average_proc_time = proc_time;
+                    }
+                    else {
+                        admission_control_.average_proc_time = (admission_control_.average_proc_time * 7.0 + proc_time) / 8.0;
+                    }
+                    admission_control_.proc_busy = false;
+                    LeaveCriticalSection(&threads_critical_dataproc_);
+
                     // ended
                     if (dp_ret == DPC_E_OK) {
                         image_status = 1;
+
+                        // notify the result
+                        if (result_published_callback_) {
+                            result_published_callback_(&dataproc_result_buffer_data->isc_dataproc_resultdata);
+                        }
+                        if (block_disparity_published_callback_) {
+                            block_disparity_published_callback_(&image_info_buffer_data->isc_image_info, &isc_block_disparity_data_);
+                        }
+
+                        // end-to-end time of the frame read from file
+                        if (isc_grab_start_mode_.isc_play_mode == IscPlayMode::kPlayOn && admission_slot_ != nullptr && get_index < admission_slot_count_) {
+                            LARGE_INTEGER end_counter = {};
+                            QueryPerformanceCounter(&end_counter);
+                            const double processing_time = (double)(end_counter.QuadPart - admission_slot_[get_index].put_counter.QuadPart) * 1000.0 / (double)play_control_.frequency.QuadPart;
+
+                            EnterCriticalSection(&threads_critical_dataproc_);
+                            play_control_.processed_frame_count++;
+                            play_control_.processing_time_total_msec += processing_time;
+                            play_control_.processing_time_last_msec = processing_time;
+                            if (processing_time > play_control_.processing_time_max_msec) {
+                                play_control_.processing_time_max_msec = processing_time;
+                            }
+                            LeaveCriticalSection(&threads_critical_dataproc_);
+                        }
+
+                        // reduced-resolution preview, after the result is published
+                        // the buffers are still held here, so it must be done before DonePutBuffer
+                        MakePreview(&image_info_buffer_data->isc_image_info, &dataproc_result_buffer_data->isc_dataproc_resultdata);
                     }
 
                 }
@@ -1127,13 +2137,39 @@ int IscDataProcessingControl::AsyncRun(IscImageInfo* isc_image_info)
         return DPCCONTROL_E_INVALID_DEVICEHANDLE;
     }
 
-    IscImageInfoRingBuffer::BufferData* buffer_data = nullptr;
+    // at maximum speed, no frame is dropped: wait until the previous one is taken
+    EnterCriticalSection(&threads_critical_dataproc_);
+    const bool is_lossless = play_control_.is_lossless;
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    if (is_lossless) {
+        WaitForFrameTaken();
+    }
+
     const ULONGLONG time = GetTickCount64();
+
+    // admission control
+    IscDataProcAdmissionDecision decision = {};
+    bool is_admitted = is_lossless ? true : DecideAdmission(time, isc_image_info, &decision);
+    if (!is_admitted) {
+        RecordAdmissionDecision(&decision);
+        return DPC_E_OK;
+    }
+
+    IscImageInfoRingBuffer::BufferData* buffer_data = nullptr;
     int put_index = isc_image_info_ring_buffer_->GetPutBuffer(&buffer_data, time);
     int image_status = 0;
 
     if (put_index >= 0 && buffer_data != nullptr) {
 
+        if (admission_slot_ != nullptr && put_index < admission_slot_count_) {
+            EnterCriticalSection(&threads_critical_dataproc_);
+            admission_slot_[put_index].sequence = admission_control_.next_sequence++;
+            LeaveCriticalSection(&threads_critical_dataproc_);
+            admission_slot_[put_index].decision = decision;
+            QueryPerformanceCounter(&admission_slot_[put_index].put_counter);
+        }
+
         buffer_data->isc_image_info.grab = isc_image_info->grab;
         buffer_data->isc_image_info.color_grab_mode = isc_image_info->color_grab_mode;
         buffer_data->isc_image_info.shutter_mode = isc_image_info->shutter_mode;
@@ -1203,6 +2239,12 @@ int IscDataProcessingControl::AsyncRun(IscImageInfo* isc_image_info)
 
         image_status = 1;
 
+        if (is_lossless) {
+            EnterCriticalSection(&threads_critical_dataproc_);
+            play_control_.pending_count++;
+            LeaveCriticalSection(&threads_critical_dataproc_);
+        }
+
         // start processing thread
         BOOL result_release = ReleaseSemaphore(handle_semaphore_dataproc_, 1, NULL);
         if (!result_release) {
@@ -1221,6 +2263,53 @@ int IscDataProcessingControl::AsyncRun(IscImageInfo* isc_image_info)
 	return DPC_E_OK;
 }
 
+/**
+ * 処理Threadが前のフレームを受け取るまで待ちます
+ *
+ * @return none
+ * @note 読み込みと処理を1フレームずつ重ねます 待った時間は再生の統計に加算します
+ */
+void IscDataProcessingControl::WaitForFrameTaken()
+{
+    LARGE_INTEGER start_counter = {};
+    QueryPerformanceCounter(&start_counter);
+    const ULONGLONG start_time = GetTickCount64();
+
+    for (;;) {
+        EnterCriticalSection(&threads_critical_dataproc_);
+        const int pending_count = play_control_.pending_count;
+        LeaveCriticalSection(&threads_critical_dataproc_);
+
+        if (pending_count == 0) {
+            break;
+        }
+
+        if (thread_control_dataproc_.terminate_request > 0) {
+            break;
+        }
+
+        if ((GetTickCount64() - start_time) > kISC_DPL_PLAY_WAIT_LIMIT_MSEC) {
+            // the processing thread does not respond, do not wait for every frame
+            EnterCriticalSection(&threads_critical_dataproc_);
+            play_control_.pending_count = 0;
+            LeaveCriticalSection(&threads_critical_dataproc_);
+            break;
+        }
+
+        WaitForSingleObject(play_control_.handle_event_taken, 10);
+    }
+
+    LARGE_INTEGER end_counter = {};
+    QueryPerformanceCounter(&end_counter);
+    const double wait_time = (double)(end_counter.QuadPart - start_counter.QuadPart) * 1000.0 / (double)play_control_.frequency.QuadPart;
+
+    EnterCriticalSection(&threads_critical_dataproc_);
+    play_control_.backpressure_wait_msec += wait_time;
+    LeaveCriticalSection(&threads_critical_dataproc_);
+
+    return;
+}
+
 /**
  * データ処理モジュールを呼び出します
  *
@@ -1235,6 +2324,10 @@ int IscDataProcessingControl::RunDataProcModules(IscImageInfo* isc_image_info, I
     // clear
     ClearIscDataProcResultData(isc_data_proc_result_data);
 
+    // the block disparity is valid only when set by the modules in this frame
+    isc_block_disparity_data_.image_width = 0;
+    isc_block_disparity_data_.image_height = 0;
+
     if( (isc_stereo_matching_ == nullptr)   ||
         (isc_frame_decoder_ == nullptr)     ||
         (isc_disparity_filter_ == nullptr) ) {
@@ -1275,9 +2368,75 @@ int IscDataProcessingControl::RunDataProcModules(IscImageInfo* isc_image_info, I
         isc_data_proc_result_data->status.proc_tact_time = measure_time_->GetTaktTime();
     }
 
+    if (dp_ret == DPC_E_OK) {
+        MakeFixedPointBlockDisparity(&isc_block_disparity_data_);
+    }
+
     return dp_ret;
 }
 
+/**
+ * Block毎の視差を固定小数点(uint16)に変換します
+ *
+ * @param[in,out] isc_block_disparity_data Block毎の視差
+ * @return none
+ * @note 視差フィルターの結果を反映した整数の視差(pblkval 1000倍)から、浮動小数点を使用せずに作成します
+ * @note enabled_valid_block_listの場合は、同時に視差のあるBlockのリストを作成します
+ */
+void IscDataProcessingControl::MakeFixedPointBlockDisparity(IscBlockDisparityData* isc_block_disparity_data)
+{
+    IscBlockDisparityData* block_data = isc_block_disparity_data;
+
+    if (block_data->image_width <= 0 || block_data->image_height <= 0 ||
+        block_data->blkwdt <= 0 || block_data->blkhgt <= 0 || block_data->pblkval == nullptr || block_data->pblkfix == nullptr) {
+        block_data->validblkcnt = -1;
+        return;
+    }
+
+    // 1000倍 -> kISC_DISPARITY_FIXED_POINT_SCALE倍 (四捨五入) 視差があるBlockは最小1とします
+    constexpr int value_scale = 1000;
+    constexpr int max_fixed_value = 65535;
+
+    const int block_count_x = block_data->image_width / block_data->blkwdt;
+    const int block_count_y = block_data->image_height / block_data->blkhgt;
+    const int* src = block_data->pblkval;
+    unsigned short* dst = block_data->pblkfix;
+
+    const bool make_valid_block_list = isc_dataproc_start_mode_.enabled_valid_block_list && (block_data->pvalidblk != nullptr);
+    const int* crst = block_data->pblkcrst;
+    IscValidBlock* valid_block = block_data->pvalidblk;
+    int valid_block_count = 0;
+
+    for (int y = 0; y < block_count_y; y++) {
+        const int row_offset = y * block_count_x;
+
+        for (int x = 0; x < block_count_x; x++) {
+            const int value = src[row_offset + x];
+            if (value <= 0) {
+                dst[row_offset + x] = 0;
+                continue;
+            }
+
+            const int fixed_value = ((value * kISC_DISPARITY_FIXED_POINT_SCALE) + (value_scale / 2)) / value_scale;
+            const unsigned short fixed_disparity = (unsigned short)std::max(1, std::min(fixed_value, max_fixed_value));
+            dst[row_offset + x] = fixed_disparity;
+
+            if (make_valid_block_list) {
+                IscValidBlock* block = &valid_block[valid_block_count++];
+                block->block_x = (unsigned short)x;
+                block->block_y = (unsigned short)y;
+                block->disparity = fixed_disparity;
+                block->reserved = 0;
+                block->contrast = (crst != nullptr) ? crst[row_offset + x] : 0;
+            }
+        }
+    }
+
+    block_data->validblkcnt = make_valid_block_list ? valid_block_count : -1;
+
+    return;
+}
+
 /**
  * Stereo Matchingを呼び出します
  *
@@ -1288,7 +2447,11 @@ int IscDataProcessingControl::RunDataProcModules(IscImageInfo* isc_image_info, I
  */
 int IscDataProcessingControl::RunDataProcStereoMatching(IscImageInfo* isc_image_info, IscDataProcResultData* isc_data_proc_result_data)
 {
-    if (isc_dataproc_start_mode_.enabled_disparity_filter) {
+    // the disparity filter is skipped when downgraded by admission control
+    const bool enabled_disparity_filter = isc_dataproc_start_mode_.enabled_disparity_filter &&
+        (current_admission_policy_ != IscDataProcAdmissionPolicy::kSkipDisparityFilter);
+
+    if (enabled_disparity_filter) {
         // stereo matching -> disparity filter
 
         // (1) block matching
@@ -1422,7 +2585,11 @@ int IscDataProcessingControl::RunDataProcFrameDecoder(IscImageInfo* isc_image_in
 
     isc_data_proc_result_data->number_of_modules_processed++;
 
-    if (isc_dataproc_start_mode_.enabled_disparity_filter) {
+    // the disparity filter is skipped when downgraded by admission control
+    const bool enabled_disparity_filter = isc_dataproc_start_mode_.enabled_disparity_filter &&
+        (current_admission_policy_ != IscDataProcAdmissionPolicy::kSkipDisparityFilter);
+
+    if (enabled_disparity_filter) {
         // stereo matching -> disparity filter
 
         measure_time_->Start();
@@ -1529,7 +2696,11 @@ int IscDataProcessingControl::RunDataProcFrameDecoderInDoubleShutter(IscImageInf
 
     isc_data_proc_result_data->number_of_modules_processed++;
 
-    if (isc_dataproc_start_mode_.enabled_disparity_filter) {
+    // the disparity filter is skipped when downgraded by admission control
+    const bool enabled_disparity_filter = isc_dataproc_start_mode_.enabled_disparity_filter &&
+        (current_admission_policy_ != IscDataProcAdmissionPolicy::kSkipDisparityFilter);
+
+    if (enabled_disparity_filter) {
         // stereo matching -> disparity filter
 
         measure_time_->Start();
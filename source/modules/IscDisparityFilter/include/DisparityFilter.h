@@ -97,6 +97,11 @@ public:
 	 */
 	static void deleteAveragingThread();
 
+	/** @brief get the handles of the averaging threads.
+		@return number of handles.
+	 */
+	static int getAveragingThreadHandle(int maxcnt, HANDLE* phandle);
+
 	/** @brief Sharpen parallax on straight edges.
 		@return none.
 	 */
@@ -81,6 +81,11 @@ public:
 	*/
 	int GetAverageDisparityDataDoubleShutter(IscImageInfo* isc_image_Info, IscBlockDisparityData* isc_block_disparity_data, IscDataProcResultData* isc_data_proc_result_data);
 
+	/** @brief get the handles of the threads created by the module.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
 private:
 
 	bool parameter_update_request_;
@@ -1905,6 +1905,27 @@ void DisparityFilter::deleteAveragingThread()
 }
 
 
+/// <summary>
+/// 視差平均化スレッドのハンドルを取得する
+/// </summary>
+/// <param name="maxcnt">取得する最大数(IN)</param>
+/// <param name="phandle">スレッドハンドル(OUT)</param>
+/// <returns>取得した数を返す</returns>
+int DisparityFilter::getAveragingThreadHandle(int maxcnt, HANDLE* phandle)
+{
+	int cnt = 0;
+
+	// バンド数が2以上の場合
+	if (numOfBands > 1) {
+		for (int i = 0; i < numOfBands && cnt < maxcnt; i++) {
+			phandle[cnt++] = bandInfo[i].bandThread;
+		}
+	}
+
+	return cnt;
+}
+
+
 /// <summary>
 /// 視差平均化スレッド
 /// </summary>
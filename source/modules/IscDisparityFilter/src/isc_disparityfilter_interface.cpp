@@ -1033,3 +1033,23 @@ int IscDisparityFilterInterface::GetAverageDisparityDataDoubleShutter(IscImageIn
     return DPC_E_OK;
 }
 
+/**
+ * 視差平均化Threadのハンドルを取得します
+ *
+ * @param[in] max_count 取得する最大数
+ * @param[out] thread_handle Threadのハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Threadの配置を設定するために利用します
+ */
+int IscDisparityFilterInterface::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+    if (thread_handle == nullptr || thread_count == nullptr) {
+        return DPCPROCESS_E_INVALID_PARAMETER;
+    }
+
+    *thread_count = DisparityFilter::getAveragingThreadHandle(max_count, thread_handle);
+
+    return DPC_E_OK;
+}
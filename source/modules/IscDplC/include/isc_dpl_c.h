@@ -37,6 +37,11 @@ extern "C" {
 	*/
 	ISCDPLC_EXPORTS_API int DplTerminate();
 
+	/** @brief set the placement of the threads. Call it before DplInitialize(), ThreadParameter.ini in configuration_file_path overrides it.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetThreadConfiguration(const IscThreadConfiguration* isc_thread_configuration);
+
 	// camera dependent paraneter
 
 	/** @brief whether or not the parameter is implemented.
@@ -376,5 +381,310 @@ extern "C" {
 	*/
 	ISCDPLC_EXPORTS_API int DplGetDataProcModuleData(IscDataProcResultData* isc_data_proc_result_data);
 
+	// callback
+
+	/** @brief register a callback to receive camera data.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplRegisterCameraDataCallback(IscCameraDataCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter);
+
+	/** @brief unregister the callback for camera data.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplUnregisterCameraDataCallback();
+
+	/** @brief register a callback to receive data processing result.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplRegisterDataProcResultCallback(IscDataProcResultCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter);
+
+	/** @brief unregister the callback for data processing result.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplUnregisterDataProcResultCallback();
+
+	/** @brief release the data held by the callback.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplReleaseCallbackData(const int release_token);
+
+	/** @brief get the delivery status of callbacks.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetCallbackStatus(IscDataCallbackStatus* camera_data_status, IscDataCallbackStatus* data_proc_result_status);
+
+	// data processing module result data (partial)
+
+	/** @brief get only the requested planes of module processing result into caller-owned buffers.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetDataProcModuleDataPartial(IscDataProcPartialResultData* isc_data_proc_partial_result_data);
+
+	// data processing admission control
+
+	/** @brief set the parameter of admission control for data processing.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetAdmissionParameter(const IscDataProcAdmissionParameter* isc_dataproc_admission_parameter);
+
+	/** @brief get the parameter of admission control for data processing.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetAdmissionParameter(IscDataProcAdmissionParameter* isc_dataproc_admission_parameter);
+
+	/** @brief get the status and the latest decisions of admission control for data processing.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetAdmissionStatus(IscDataProcAdmissionStatus* isc_dataproc_admission_status);
+
+	// thread placement
+
+	/** @brief get the cpu set and priority applied to the threads of the library.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status);
+
+	// data processing preview
+
+	/** @brief set the parameter of the reduced-resolution preview of the data processing result.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetPreviewParameter(const IscDataProcPreviewParameter* isc_dataproc_preview_parameter);
+
+	/** @brief get the parameter of the reduced-resolution preview of the data processing result.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPreviewParameter(IscDataProcPreviewParameter* isc_dataproc_preview_parameter);
+
+	/** @brief get the latest reduced-resolution preview of the data processing result into caller-owned buffers.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPreviewData(IscDataProcPreviewData* isc_dataproc_preview_data);
+
+	// raw data file index
+
+	/** @brief Set the read Frame to the first frame at or after the specified time. The index file is required.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetReadFrameTime(const __int64 frame_time);
+
+	/** @brief make the index file of the raw data file. it is for files recorded without the index.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplRebuildFileIndex(const wchar_t* play_file_name, __int64* entry_count);
+
+	// record compression
+
+	/** @brief set the compression of the raw data recording. it is applied at the next start of recording.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetRecordCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter);
+
+	/** @brief get the compression of the raw data recording.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetRecordCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter);
+
+	/** @brief get the result of the compression of the current recording.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetRecordCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics);
+
+	// record writer
+
+	/** @brief set the writing of the raw data recording. it is applied at the next start of recording.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetRecordWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter);
+
+	/** @brief get the writing of the raw data recording.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetRecordWriteParameter(IscRecordWriteParameter* isc_record_write_parameter);
+
+	/** @brief get the queue depth, dropped frames and write latency of the current recording.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetRecordWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics);
+
+	// play
+
+	/** @brief get the pacing, the achieved rate and the processing time of the current playback.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPlayStatistics(IscPlayStatistics* isc_play_statistics);
+
+	// reprocess
+
+	/** @brief split the raw data file into ranges for the reprocessing. the boundaries keep the set of mono/color and double shutter.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplMakeReprocessRanges(const wchar_t* play_file_name, const int range_count, IscReprocessRangeList* isc_reprocess_range_list);
+
+	/** @brief process a range of the raw data file without the camera and write the result file. call it while stopped, it returns when the range is done.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplReprocessRange(const IscReprocessParameter* isc_reprocess_parameter, IscReprocessStatus* isc_reprocess_status);
+
+	/** @brief merge the result files of the ranges in order.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplMergeReprocessResults(const IscReprocessMergeParameter* isc_reprocess_merge_parameter);
+
+	// result record
+
+	/** @brief start recording the block disparity of the data processing result in the compact form.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplStartResultRecord(const IscResultRecordParameter* isc_result_record_parameter);
+
+	/** @brief stop recording the block disparity and write the index.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplStopResultRecord();
+
+	/** @brief get the status of the recording of the block disparity.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetResultRecordStatus(IscResultRecordStatus* isc_result_record_status);
+
+	/** @brief open the result record file for reading.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplOpenResultRecord(const wchar_t* file_name, IscResultRecordInformation* isc_result_record_information);
+
+	/** @brief read a frame of the result record file into caller-owned buffers.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplReadResultRecord(const __int64 frame_number, IscResultRecordFrame* isc_result_record_frame);
+
+	/** @brief close the result record file.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplCloseResultRecord();
+
+	// play cache
+
+	/** @brief set how the decoded frames are kept and prefetched during the playback.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter);
+
+	/** @brief get how the decoded frames are kept and prefetched during the playback.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter);
+
+	/** @brief get the usage and the hit rate of the decoded frame cache.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status);
+
+	// measurement
+
+	/** @brief get information for many regions of the same frame at once. x, y, width and height of each element specify the region.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetAreaStatisticsBatch(const int roi_count, const float min_distance, const float max_distance, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics);
+
+	// point cloud
+
+	/** @brief convert the disparity to the point cloud. the buffers of isc_point_cloud_data are allocated by the caller.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPointCloud(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data);
+
+	/** @brief convert the disparity to the point cloud and write it to the PCD/PLY (binary) file.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSavePointCloud(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info);
+
+	// measurement
+
+	/** @brief gets the disparity, distance and 3D position of many coordinates (or the pixels of a mask) at once.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetPosition3DBatch(const IscImageInfo* isc_image_info, IscPositionBatch* isc_position_batch);
+
+	// occupancy grid
+
+	/** @brief set the parameter of the occupancy grid built from the block disparity. the grid and the voxel map are cleared.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetOccupancyGridParameter(const IscOccupancyGridParameter* isc_occupancy_grid_parameter);
+
+	/** @brief get the parameter of the occupancy grid.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetOccupancyGridParameter(IscOccupancyGridParameter* isc_occupancy_grid_parameter);
+
+	/** @brief get the latest occupancy grid.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetOccupancyGrid(IscOccupancyGridData* isc_occupancy_grid_data);
+
+	/** @brief get the latest voxel map.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetVoxelMap(IscVoxelMapData* isc_voxel_map_data);
+
+	// u-disparity and v-disparity
+
+	/** @brief set the parameter of the u-disparity and v-disparity built from the block disparity. the histograms are cleared.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetUvDisparityParameter(const IscUvDisparityParameter* isc_uv_disparity_parameter);
+
+	/** @brief get the parameter of the u-disparity and v-disparity.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetUvDisparityParameter(IscUvDisparityParameter* isc_uv_disparity_parameter);
+
+	/** @brief get the latest u-disparity, v-disparity and ground line.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetUvDisparity(IscUvDisparityData* isc_uv_disparity_data);
+
+	// range index
+
+	/** @brief set the parameter of the range index built from the block disparity and register the zones evaluated every frame.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplSetRangeIndexParameter(const IscRangeIndexParameter* isc_range_index_parameter);
+
+	/** @brief get the parameter of the range index.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetRangeIndexParameter(IscRangeIndexParameter* isc_range_index_parameter);
+
+	/** @brief get the results of the registered zones of the latest frame.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetRangeZoneData(IscRangeZoneData* isc_range_zone_data);
+
+	/** @brief get the nearest and farthest distance and the number of the blocks in range of a region of the latest frame.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplQueryRange(const IscRangeZone* isc_range_zone, IscRangeZoneResult* isc_range_zone_result);
+
+	// fixed-point block disparity
+
+	/** @brief get the fixed-point block disparity (uint16, disparity x kISC_DISPARITY_FIXED_POINT_SCALE) of the latest frame.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetBlockDisparityFixed(IscBlockDisparityFixedData* isc_block_disparity_fixed_data);
+
+	/** @brief gets the disparity and distance of the given coordinates from the fixed-point block disparity of the latest frame.
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetBlockPositionDepth(const int x, const int y, float* disparity, float* depth);
+
+	// valid block list
+
+	/** @brief get the list of the blocks which have the disparity in the latest frame (IscDataProcStartMode::enabled_valid_block_list).
+		@return 0, if successful.
+	*/
+	ISCDPLC_EXPORTS_API int DplGetValidBlockList(IscValidBlockListData* isc_valid_block_list_data);
+
 } /* extern "C" { */
 
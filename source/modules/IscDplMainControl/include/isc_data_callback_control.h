@@ -0,0 +1,157 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_data_callback_control.h
+ * @brief This class delivers camera data and data processing results to callbacks.
+ */
+
+#pragma once
+
+/**
+ * @class   IscDataCallbackControl
+ * @brief   This class delivers camera data and data processing results to callbacks.
+ *
+ */
+class IscDataCallbackControl
+{
+public:
+    IscDataCallbackControl();
+    ~IscDataCallbackControl();
+
+	/** @brief Initializes the class and starts the delivery thread.
+		@return 0, if successful.
+	*/
+	int Initialize(const int max_width, const int max_height, IscLog* isc_log);
+
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	/** @brief register a callback for camera data.
+		@return 0, if successful.
+	*/
+	int RegisterCameraDataCallback(IscCameraDataCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter);
+
+	/** @brief unregister the callback for camera data.
+		@return 0, if successful.
+	*/
+	int UnregisterCameraDataCallback();
+
+	/** @brief register a callback for data processing result.
+		@return 0, if successful.
+	*/
+	int RegisterDataProcResultCallback(IscDataProcResultCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter);
+
+	/** @brief unregister the callback for data processing result.
+		@return 0, if successful.
+	*/
+	int UnregisterDataProcResultCallback();
+
+	/** @brief release the data held by the callback.
+		@return 0, if successful.
+	*/
+	int ReleaseCallbackData(const int release_token);
+
+	/** @brief get the delivery status.
+		@return 0, if successful.
+	*/
+	int GetCallbackStatus(IscDataCallbackStatus* camera_data_status, IscDataCallbackStatus* data_proc_result_status);
+
+	/** @brief queue camera data for delivery. It never blocks.
+		@return 0, if successful.
+	*/
+	int PublishCameraData(const IscImageInfo* isc_image_info);
+
+	/** @brief queue data processing result for delivery. It never blocks.
+		@return 0, if successful.
+	*/
+	int PublishDataProcResult(const IscDataProcResultData* isc_data_proc_result_data);
+
+	/** @brief get the handle of the delivery thread.
+		@return thread handle.
+	*/
+	HANDLE GetThreadHandle();
+
+private:
+
+	enum {
+		kStreamCameraData = 0,
+		kStreamDataProcResult = 1,
+		kStreamCount = 2
+	};
+
+	// slot state 0:free 1:writing 2:queued 3:delivering 4:held
+	struct SlotData {
+		int state;
+		int generation;
+		unsigned __int64 sequence;
+		IscDataProcResultData isc_data_proc_result_data;
+	};
+
+	struct StreamControl {
+		bool registered;
+		IscCameraDataCallback camera_data_callback;
+		IscDataProcResultCallback data_proc_result_callback;
+		void* user_context;
+		IscDataCallbackParameter parameter;
+
+		int slot_count;
+		SlotData* slot_data;
+		unsigned char* buff_image;
+		float* buff_depth;
+
+		unsigned __int64 next_sequence;
+		IscDataCallbackStatus status;
+	};
+	StreamControl stream_control_[kStreamCount];
+
+	IscLog* isc_log_;
+	int max_width_;
+	int max_height_;
+	int generation_;
+
+	CRITICAL_SECTION stream_critical_;
+
+	// Thread Control
+	struct ThreadControl {
+		int terminate_request;
+		int terminate_done;
+		int end_code;
+		bool stop_request;
+	};
+	ThreadControl thread_control_delivery_;
+
+	HANDLE handle_semaphore_delivery_;
+	HANDLE thread_handle_delivery_;
+	DWORD thread_id_delivery_;
+
+	static unsigned __stdcall ControlThreadDelivery(void* context);
+	int DeliveryProc();
+
+	int RegisterCallback(const int stream, IscCameraDataCallback camera_data_callback, IscDataProcResultCallback data_proc_result_callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter);
+	int UnregisterCallback(const int stream);
+	int Publish(const int stream, const IscDataProcResultData* isc_data_proc_result_data, const IscImageInfo* isc_image_info);
+
+	int AllocateSlotData(StreamControl* stream_control, const int slot_count);
+	int ReleaseSlotData(StreamControl* stream_control);
+	bool IsSlotDataInUse(const StreamControl* stream_control);
+	void ReleaseSlotDataIfUnused(StreamControl* stream_control);
+	int CopyIscImageInfo(IscImageInfo* dst_isc_image_info, const IscImageInfo* src_isc_image_info);
+
+	int MakeReleaseToken(const int generation, const int stream, const int slot_index);
+	void CountSlotStatus(StreamControl* stream_control);
+
+};
@@ -1,4 +1,4 @@
-// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -52,11 +52,43 @@ public:
 	*/
 	int GetPosition3D(const int x, const int y, const IscImageInfo* isc_image_info, float* x_d, float* y_d, float* z_d);
 
+	/** @brief gets the disparity, distance and 3D position of many coordinates at once.
+		@return 0, if successful.
+	*/
+	int GetPosition3DBatch(const IscImageInfo* isc_image_info, IscPositionBatch* isc_position_batch);
+
 	/** @brief get information for the specified region.
 		@return 0, if successful.
 	*/
 	int GetAreaStatistics(const int x, const int y, const int width, const int height, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics);
 
+	/** @brief get information for many regions of the same frame at once.
+		@return 0, if successful.
+	*/
+	int GetAreaStatisticsBatch(const int roi_count, const float min_distance, const float max_distance, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics);
+
+	// fixed-point block disparity
+
+	/** @brief keep the fixed-point block disparity of the latest frame. called from the data processing thread.
+		@return 0, if successful.
+	*/
+	int UpdateBlockDisparity(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data);
+
+	/** @brief get the fixed-point block disparity of the latest frame.
+		@return 0, if successful.
+	*/
+	int GetBlockDisparityFixed(IscBlockDisparityFixedData* isc_block_disparity_fixed_data);
+
+	/** @brief gets the disparity and distance of the given coordinates from the fixed-point block disparity of the latest frame.
+		@return 0, if successful.
+	*/
+	int GetBlockPositionDepth(const int x, const int y, float* disparity, float* depth);
+
+	/** @brief get the list of the blocks which have the disparity in the latest frame.
+		@return 0, if successful.
+	*/
+	int GetValidBlockList(IscValidBlockListData* isc_valid_block_list_data);
+
 
 private:
 	struct WorkBuffers {
@@ -68,5 +100,62 @@ private:
 	};
 	WorkBuffers work_buffers_;
 
+	struct AreaHistogram {
+		int* disparity_bins;			// 視差 0.01 pixel毎
+		int* distance_bins;				// 距離 0.01m(~10m) 0.1m(~100m) 1m(~1000m)
+		int* distance_mode_bins;		// 距離の最頻値の作業領域
+	};
+	AreaHistogram area_histogram_;
+
+	struct AreaTables {
+		int width, height;							// 作成した視差画像の大きさ
+		int tile_columns, tile_rows;
+
+		const float* disparity;						// 作成元の視差
+		float d_inf, bf;
+		float min_distance, max_distance;
+
+		// summed-area tables (width + 1) x (height + 1)
+		int* disparity_count;
+		__int64* disparity_sum;						// 1/256 pixel
+		__int64* disparity_square_sum;
+		int* distance_count;
+		__int64* distance_sum;						// mm
+		__int64* distance_square_sum;
+
+		// 画素毎のHistogramの位置 (0xFF:無効)
+		unsigned char* disparity_bin;
+		unsigned char* distance_bin;
+		unsigned char* distance_bin_lut;			// 視差(1/64 pixel)から距離のHistogramの位置
+		float* disparity_bin_edges;					// Histogramの境界 bin + 1
+		float* distance_bin_edges;
+
+		// Tile毎のHistogram summed-area (tile_columns + 1) x (tile_rows + 1) x bin
+		int* disparity_tile_histogram;
+		int* distance_tile_histogram;
+
+		// Tile毎の最大最小
+		float* tile_disparity_min;
+		float* tile_disparity_max;
+		float* tile_distance_min;
+		float* tile_distance_max;
+	};
+	AreaTables area_tables_;
+
+	int AllocateAreaTables();
+	void ReleaseAreaTables();
+	int BuildAreaTables(const float* disparity, const int width, const int height, const float d_inf, const float bf, const float min_distance, const float max_distance);
+	void GetAreaStatisticsFromTables(const int x, const int y, const int width, const int height, const float base_length, IscAreaDataStatistics* isc_data_statistics);
+
+	struct BlockDisparity {
+		CRITICAL_SECTION critical;
+		IscBlockDisparityFixedData data;			// block_valueは内部のバッファー
+		int capacity;
+		IscValidBlock* valid_block;				// 視差のあるBlockのリスト
+		int valid_block_count;					// -1:リストなし
+		int valid_block_capacity;
+	};
+	BlockDisparity block_disparity_;
+
 
 };
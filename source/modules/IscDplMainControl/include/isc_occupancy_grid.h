@@ -0,0 +1,135 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_occupancy_grid.h
+ * @brief This class builds the occupancy grid from the block disparity.
+ */
+
+#pragma once
+
+class IscBandWorker;
+
+/**
+ * @class   IscOccupancyGrid
+ * @brief   occupancy grid class
+ * this class builds the 2D occupancy grid and the sparse voxel map from the block disparity with temporal decay
+ */
+class IscOccupancyGrid
+{
+public:
+	IscOccupancyGrid();
+	~IscOccupancyGrid();
+
+	/** @brief initialize the class. the block rows are divided into bands, and each band is projected by one thread.
+		@return 0, if successful.
+	*/
+	int Initialize(const int thread_count);
+
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	/** @brief get the handles of the band worker threads for the placement.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
+	/** @brief set the parameter. the grid and the voxel map are cleared.
+		@return 0, if successful.
+	*/
+	int SetParameter(const IscOccupancyGridParameter* isc_occupancy_grid_parameter);
+
+	/** @brief get the parameter.
+		@return 0, if successful.
+	*/
+	int GetParameter(IscOccupancyGridParameter* isc_occupancy_grid_parameter);
+
+	/** @brief add the block disparity of a frame to the grid. called from the data processing thread.
+		@return 0, if successful.
+	*/
+	int Update(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data);
+
+	/** @brief copy the latest grid to the buffers of the caller.
+		@return 0, if successful.
+	*/
+	int GetGrid(IscOccupancyGridData* isc_occupancy_grid_data);
+
+	/** @brief copy the latest voxel map to the buffer of the caller.
+		@return 0, if successful.
+	*/
+	int GetVoxelMap(IscVoxelMapData* isc_voxel_map_data);
+
+private:
+
+	static constexpr int kMaxBandCount = 8;
+
+	struct ProjectSource {
+		const float* block_disparity;			/**< Block毎の視差 */
+		int block_width, block_height;
+		int block_count_x;
+		float d_inf, bf, base_length;
+		float center_x, center_y;
+
+		float cos_pitch, sin_pitch;
+		IscOccupancyGridParameter parameter;
+		int cell_count_x, cell_count_z;
+	};
+
+	struct BandJob {
+		int block_row_start, block_row_end;
+		int* occupied_hits;						/**< Threadの部分集計 [z][x] */
+		int* ground_hits;
+		unsigned __int64* voxel_keys;			/**< Threadの観測したvoxel */
+		int voxel_key_count;
+		int max_voxel_key_count;
+	};
+
+	struct VoxelSlot {
+		unsigned __int64 key;
+		float value;							/**< 0:空き */
+	};
+
+	IscBandWorker* band_worker_;
+
+	CRITICAL_SECTION grid_critical_;			/**< parameter_, 集計結果 */
+	IscOccupancyGridParameter parameter_;
+	int cell_count_x_, cell_count_z_;
+	float* occupied_;
+	float* ground_;
+	__int64 frame_time_;
+	int frame_index_;
+
+	VoxelSlot* voxel_table_[2];					/**< 更新時に入れ替えます */
+	int voxel_table_index_;
+	int voxel_count_;
+
+	ProjectSource project_source_;
+	int band_count_;
+	BandJob band_job_[kMaxBandCount];
+	int max_block_count_;
+
+	void ReleaseBuffers();
+	int AllocateBandBuffers(const int block_count);
+
+	static void RunBand(void* context, const int band_index);
+
+	static void ProjectBand(const ProjectSource* source, BandJob* job);
+
+	void MergeBands(const int band_count);
+
+	void InsertVoxel(VoxelSlot* table, const unsigned __int64 key, const float value);
+
+};
@@ -0,0 +1,114 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_point_cloud.h
+ * @brief This class converts the disparity to the point cloud.
+ */
+
+#pragma once
+
+class IscBandWorker;
+
+/**
+ * @class   IscPointCloud
+ * @brief   point cloud class
+ * this class converts the disparity of a frame to the point cloud, and writes it to the PCD/PLY file
+ */
+class IscPointCloud
+{
+public:
+	IscPointCloud();
+	~IscPointCloud();
+
+	/** @brief initialize the class. the rows are divided into bands, and each band is converted by one thread.
+		@return 0, if successful.
+	*/
+	int Initialize(const int thread_count, const int max_width, const int max_height);
+
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	/** @brief get the handles of the band worker threads for the placement.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
+	/** @brief convert the disparity to the point cloud into the buffers of the caller.
+		@return 0, if successful.
+	*/
+	int Convert(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data);
+
+	/** @brief convert the disparity to the point cloud and write it to the file.
+		@return 0, if successful.
+	*/
+	int SaveFile(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info);
+
+private:
+
+	static constexpr int kMaxBandCount = 8;
+
+	struct ConvertSource {
+		const float* depth;						/**< 視差 */
+		int depth_width;
+
+		const unsigned char* color;				/**< 色 (nullptr:無し) */
+		int color_width;
+		int color_channel_count;
+
+		int roi_x, roi_y;
+		int decimation;
+		int sampled_width;						/**< 間引き後の幅 */
+
+		float d_inf, bf, base_length;
+		float center_x, center_y;
+		float min_distance, max_distance;
+
+		bool is_organized;
+		bool is_ros_axis;
+		IscPointCloudLayout layout;
+	};
+
+	struct BandJob {
+		int row_start, row_end;					/**< 間引き後の行 */
+		int point_offset;						/**< 書き込みを開始する位置 */
+		int point_count;						/**< 書き込んだ数 */
+	};
+
+	int max_width_, max_height_;
+
+	CRITICAL_SECTION convert_critical_;			/**< Convert, SaveFileの間の変換の状態 */
+	IscBandWorker* band_worker_;
+	ConvertSource convert_source_;
+	IscPointCloudData* convert_destination_;
+	BandJob band_job_[kMaxBandCount];
+
+	IscPointXYZRGB* save_points_;				/**< ファイルへの書き込み用 */
+	unsigned char* save_buffer_;
+
+	int ConvertPoints(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data);
+
+	int SavePoints(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info);
+
+	static void RunBand(void* context, const int band_index);
+
+	static void ConvertBand(const ConvertSource* source, BandJob* job, IscPointCloudData* destination);
+
+	int WritePcd(HANDLE handle_file, const IscPointCloudParameter* isc_point_cloud_parameter, const IscPointCloudData* isc_point_cloud_data);
+	int WritePly(HANDLE handle_file, const IscPointCloudParameter* isc_point_cloud_parameter, const IscPointCloudData* isc_point_cloud_data);
+	int WriteBuffer(HANDLE handle_file, const void* data, const size_t size);
+
+};
@@ -0,0 +1,97 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_range_index.h
+ * @brief This class builds the index for the range query from the block disparity.
+ */
+
+#pragma once
+
+/**
+ * @class   IscRangeIndex
+ * @brief   range index class
+ * this class builds the min/max sparse table of the block disparity and evaluates the registered zones every frame
+ */
+class IscRangeIndex
+{
+public:
+	IscRangeIndex();
+	~IscRangeIndex();
+
+	/** @brief initialize the class.
+		@return 0, if successful.
+	*/
+	int Initialize();
+
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	/** @brief set the parameter and register the zones. the index is cleared.
+		@return 0, if successful.
+	*/
+	int SetParameter(const IscRangeIndexParameter* isc_range_index_parameter);
+
+	/** @brief get the parameter.
+		@return 0, if successful.
+	*/
+	int GetParameter(IscRangeIndexParameter* isc_range_index_parameter);
+
+	/** @brief build the index from the block disparity of a frame and evaluate the zones. called from the data processing thread.
+		@return 0, if successful.
+	*/
+	int Update(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data);
+
+	/** @brief get the results of the registered zones of the latest frame.
+		@return 0, if successful.
+	*/
+	int GetZoneData(IscRangeZoneData* isc_range_zone_data);
+
+	/** @brief query a region of the latest frame.
+		@return 0, if successful.
+	*/
+	int QueryRange(const IscRangeZone* isc_range_zone, IscRangeZoneResult* isc_range_zone_result);
+
+private:
+
+	static constexpr int kMaxLevelCount = 16;
+
+	CRITICAL_SECTION index_critical_;			/**< parameter_, index */
+	IscRangeIndexParameter parameter_;
+
+	int block_width_, block_height_;
+	int block_count_x_, block_count_y_;
+	float bf_;
+
+	int level_count_x_, level_count_y_;
+	size_t level_offset_[kMaxLevelCount][kMaxLevelCount];	/**< [ky][kx] */
+	short* min_table_;							/**< 2^kx x 2^ky の範囲の最小値 */
+	short* max_table_;							/**< 2^kx x 2^ky の範囲の最大値 */
+	size_t max_table_size_;
+	int* valid_sum_;							/**< 有効なBlockの数の累積 */
+	int* level_log_;							/**< floor(log2(n)) */
+	int max_block_count_x_, max_block_count_y_;
+
+	IscRangeZoneData zone_data_;
+
+	void ReleaseBuffers();
+	void AllocateBuffers(const int block_count_x, const int block_count_y);
+
+	void BuildTables(const float* block_disparity, const float d_inf);
+
+	void Query(const IscRangeZone* zone, IscRangeZoneResult* result);
+
+};
@@ -23,17 +23,117 @@
  * @class   IscRecordControl
  * @brief   implementation class
  * this class is an inplementation for data record
+ * it records the block disparity of the data processing result in a compact form, and reads it back
  */
 class IscRecordControl
 {
 
 public:
+	IscRecordControl();
+	~IscRecordControl();
 
+	/** @brief Initializes the class.
+		@return 0, if successful.
+	*/
+	int Initialize(IscLog* isc_log);
 
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	// record
+
+	/** @brief create the file and start recording the block disparity.
+		@return 0, if successful.
+	*/
+	int StartRecord(const IscResultRecordParameter* isc_result_record_parameter);
+
+	/** @brief write the index and close the file.
+		@return 0, if successful.
+	*/
+	int StopRecord();
+
+	/** @brief get the status of the recording.
+		@return 0, if successful.
+	*/
+	int GetRecordStatus(IscResultRecordStatus* isc_result_record_status);
+
+	/** @brief write the block disparity of a frame. it does nothing if not recording.
+		@return 0, if successful.
+	*/
+	int WriteFrame(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data);
+
+	// read
+
+	/** @brief open the file for reading. the index is rebuilt if the recording did not stop.
+		@return 0, if successful.
+	*/
+	int OpenFile(const wchar_t* file_name, IscResultRecordInformation* isc_result_record_information);
+
+	/** @brief read the specified frame. the frames from the previous key frame are decoded.
+		@return 0, if successful.
+	*/
+	int ReadFrame(const __int64 frame_number, IscResultRecordFrame* isc_result_record_frame);
+
+	/** @brief close the file.
+		@return 0, if successful.
+	*/
+	int CloseFile();
 
 private:
 
+	IscLog* isc_log_;
 
-};
+	// block values and the work area of one frame
+	struct FrameBuffer {
+		int capacity;                   /**< number of blocks allocated */
+		int block_count;                /**< number of blocks of the frame */
+		IscResultRecordFrameHeader frame_header;
+		unsigned short* value;          /**< fixed-point disparity */
+		unsigned short* previous_value; /**< fixed-point disparity of the previous frame */
+		unsigned char* plane[2];        /**< low and high byte of the residual */
+		unsigned char* coded;           /**< coded planes */
+	};
+
+	struct RecordControl {
+		CRITICAL_SECTION critical;
+		HANDLE handle_file;
+		IscResultRecordFileHeader file_header;
+		IscResultRecordStatus status;
+		int frame_count_from_key;
+		FrameBuffer frame_buffer;
+
+		IscResultRecordIndexEntry* index_entry;
+		__int64 index_capacity;
+	};
+	RecordControl record_control_;
+
+	struct ReadControl {
+		CRITICAL_SECTION critical;
+		HANDLE handle_file;
+		IscResultRecordFileHeader file_header;
+		IscResultRecordInformation information;
+		__int64 decoded_frame_number;   /**< frame in frame_buffer.value, -1:none */
+		FrameBuffer frame_buffer;
+
+		IscResultRecordIndexEntry* index_entry;
+		__int64 index_count;
+		__int64 index_capacity;
+	};
+	ReadControl read_control_;
 
+	static bool AllocateFrameBuffer(FrameBuffer* frame_buffer, const int block_count);
+	static void ReleaseFrameBuffer(FrameBuffer* frame_buffer);
+	static bool AddIndexEntry(IscResultRecordIndexEntry** index_entry, __int64* index_capacity, const __int64 index_count, const IscResultRecordIndexEntry* entry);
 
+	int BuildIndex(ReadControl* read_control);
+	int DecodeFrame(ReadControl* read_control, const __int64 frame_number);
+
+	static int EncodePlane(const unsigned char* src, const int count, unsigned char* dst, const int dst_capacity);
+	static bool DecodePlane(const unsigned char* src, const int src_size, unsigned char* dst, const int count);
+
+	static bool WriteFileAll(HANDLE handle_file, const void* data, const size_t size);
+	static bool ReadFileAll(HANDLE handle_file, void* data, const size_t size);
+
+};
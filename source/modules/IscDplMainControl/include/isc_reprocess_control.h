@@ -0,0 +1,71 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_reprocess_control.h
+ * @brief This class reprocesses a range of the RAW data file without the camera.
+ */
+
+#pragma once
+
+/**
+ * @class   IscReprocessControl
+ * @brief   This class reprocesses a range of the RAW data file without the camera.
+ *
+ */
+class IscReprocessControl
+{
+public:
+    IscReprocessControl();
+    ~IscReprocessControl();
+
+	/** @brief Initializes the class.
+		@return 0, if successful.
+	*/
+	int Initialize(IscLog* isc_log);
+
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	/** @brief split the RAW data file into ranges of about the same number of records.
+		@return 0, if successful.
+	*/
+	int MakeRanges(IscCameraControl* isc_camera_control, const wchar_t* play_file_name, const int range_count, IscReprocessRangeList* isc_reprocess_range_list);
+
+	/** @brief process a range of the RAW data file in the calling thread and write the result file.
+		@return 0, if successful.
+	*/
+	int ProcessRange(IscCameraControl* isc_camera_control, IscDataProcessingControl* isc_data_processing_control,
+		const IscReprocessParameter* isc_reprocess_parameter, IscReprocessStatus* isc_reprocess_status);
+
+	/** @brief merge the result files of the ranges in order.
+		@return 0, if successful.
+	*/
+	int MergeResults(const IscReprocessMergeParameter* isc_reprocess_merge_parameter);
+
+private:
+
+	IscLog* isc_log_;
+
+	LARGE_INTEGER frequency_;
+
+	int GetRawFileInformation(IscCameraControl* isc_camera_control, const wchar_t* play_file_name, IscRawFileHeader* raw_file_header, IscPlayFileInformation* play_file_information);
+	int WriteResultFrame(HANDLE handle_file, const __int64 frame_number, const int result_code, const IscReprocessParameter* isc_reprocess_parameter,
+		const IscImageInfo* isc_image_info, const IscDataProcResultData* isc_data_proc_result_data, const IscBlockDisparityData* isc_block_disparity_data);
+	static bool WriteFileAll(HANDLE handle_file, const void* data, const size_t size);
+	static bool ReadFileAll(HANDLE handle_file, void* data, const size_t size);
+
+};
@@ -0,0 +1,125 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_uv_disparity.h
+ * @brief This class builds the u-disparity and v-disparity from the block disparity.
+ */
+
+#pragma once
+
+class IscBandWorker;
+
+/**
+ * @class   IscUvDisparity
+ * @brief   u-disparity and v-disparity class
+ * this class builds the u-disparity and v-disparity histograms from the integer block disparity and fits the ground line
+ */
+class IscUvDisparity
+{
+public:
+	IscUvDisparity();
+	~IscUvDisparity();
+
+	/** @brief initialize the class. the block rows are divided into bands, and each band is counted by one thread.
+		@return 0, if successful.
+	*/
+	int Initialize(const int thread_count);
+
+	/** @brief ... Shut down the runtime system. Don't call any method after calling Terminate().
+		@return 0, if successful.
+	 */
+	int Terminate();
+
+	/** @brief get the handles of the band worker threads for the placement.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
+	/** @brief set the parameter. the histograms are cleared.
+		@return 0, if successful.
+	*/
+	int SetParameter(const IscUvDisparityParameter* isc_uv_disparity_parameter);
+
+	/** @brief get the parameter.
+		@return 0, if successful.
+	*/
+	int GetParameter(IscUvDisparityParameter* isc_uv_disparity_parameter);
+
+	/** @brief build the histograms from the block disparity of a frame. called from the data processing thread.
+		@return 0, if successful.
+	*/
+	int Update(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data);
+
+	/** @brief copy the latest histograms and the ground line to the buffers of the caller.
+		@return 0, if successful.
+	*/
+	int GetData(IscUvDisparityData* isc_uv_disparity_data);
+
+private:
+
+	static constexpr int kMaxBandCount = 8;
+
+	struct CountSource {
+		const int* block_value;					/**< Block毎の視差 (x1000) */
+		int block_count_x;
+		int disparity_resolution;
+		int bin_count;
+	};
+
+	struct BandJob {
+		int block_row_start, block_row_end;
+		int* u_hits;							/**< Threadの部分集計 [bin][block x] */
+	};
+
+	struct GroundPoint {
+		float y, disparity;
+		int count;
+	};
+
+	IscBandWorker* band_worker_;
+
+	CRITICAL_SECTION uv_critical_;				/**< parameter_, 集計結果 */
+	IscUvDisparityParameter parameter_;
+	int bin_count_;
+	int block_width_, block_height_;
+	int block_count_x_, block_count_y_;
+	int* u_disparity_;
+	int* v_disparity_;
+	int max_block_count_x_, max_block_count_y_;
+
+	bool has_ground_line_;
+	float ground_slope_, ground_intercept_;
+	int ground_inlier_count_;
+	GroundPoint* ground_points_;
+
+	__int64 frame_time_;
+	int frame_index_;
+
+	CountSource count_source_;
+	int band_count_;
+	BandJob band_job_[kMaxBandCount];
+
+	void ReleaseBuffers();
+	void AllocateBuffers(const int block_count_x, const int block_count_y);
+
+	static void RunBand(void* context, const int band_index);
+
+	void CountBand(BandJob* job);
+
+	void MergeBands(const int band_count);
+
+	void FitGroundLine();
+
+};
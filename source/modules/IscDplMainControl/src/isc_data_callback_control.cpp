@@ -0,0 +1,991 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_data_callback_control.cpp
+ * @brief This class delivers camera data and data processing results to callbacks
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class delivers camera data and data processing results to callbacks.
+ * @note
+ *  - 配信は専用Threadで行うため、データ取得・データ処理Threadはブロックしません
+ *  - キューが一杯の場合は、drop_policyに従ってデータを破棄します
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <process.h>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+
+#include "isc_data_callback_control.h"
+
+// slot state
+constexpr int kSLOT_STATE_FREE = 0;
+constexpr int kSLOT_STATE_WRITING = 1;
+constexpr int kSLOT_STATE_QUEUED = 2;
+constexpr int kSLOT_STATE_DELIVERING = 3;
+constexpr int kSLOT_STATE_HELD = 4;
+
+// bytes per pixel of unsigned char planes (p1:1 p2:1 color:3 raw:2 raw_color:2)
+constexpr int kSLOT_IMAGE_BYTES_PER_PIXEL = 9;
+
+/**
+ * constructor
+ *
+ */
+IscDataCallbackControl::IscDataCallbackControl():
+    stream_control_(),
+    isc_log_(nullptr),
+    max_width_(0),
+    max_height_(0),
+    generation_(0),
+    stream_critical_(),
+    thread_control_delivery_(),
+    handle_semaphore_delivery_(NULL),
+    thread_handle_delivery_(NULL),
+    thread_id_delivery_(0)
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscDataCallbackControl::~IscDataCallbackControl()
+{
+
+}
+
+/**
+ * クラスを初期化します.
+ *
+ * @param[in] max_width 画像最大幅
+ * @param[in] max_height 画像最大高さ
+ * @param[in] isc_log ログオブジェクト
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::Initialize(const int max_width, const int max_height, IscLog* isc_log)
+{
+    isc_log_ = isc_log;
+    max_width_ = max_width;
+    max_height_ = max_height;
+    generation_ = 0;
+
+    for (int i = 0; i < kStreamCount; i++) {
+        memset(&stream_control_[i], 0, sizeof(StreamControl));
+    }
+
+    InitializeCriticalSection(&stream_critical_);
+
+    // create thread for delivery
+    thread_control_delivery_.terminate_request = 0;
+    thread_control_delivery_.terminate_done = 0;
+    thread_control_delivery_.end_code = 0;
+    thread_control_delivery_.stop_request = false;
+
+    handle_semaphore_delivery_ = CreateSemaphoreA(NULL, 0, 1, NULL);
+    if (handle_semaphore_delivery_ == NULL) {
+        // Fail
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    unsigned int thread_id = 0;
+    if ((thread_handle_delivery_ = (HANDLE)_beginthreadex(0, 0, ControlThreadDelivery, (void*)this, 0, &thread_id)) == 0) {
+        // Fail
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+    thread_id_delivery_ = (DWORD)thread_id;
+
+    // THREAD_PRIORITY_TIME_CRITICAL
+    // THREAD_PRIORITY_HIGHEST +2
+    // THREAD_PRIORITY_ABOVE_NORMAL +1
+    // THREAD_PRIORITY_NORMAL  +0
+    // THREAD_PRIORITY_BELOW_NORMAL -1
+    SetThreadPriority(thread_handle_delivery_, THREAD_PRIORITY_NORMAL);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします.
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 配信Threadの終了を待ってから解放します。保持中のSlotがある場合、そのバッファーは解放しません
+ */
+int IscDataCallbackControl::Terminate()
+{
+    // stop delivery
+    UnregisterCallback(kStreamCameraData);
+    UnregisterCallback(kStreamDataProcResult);
+
+    // close thread procedure
+    thread_control_delivery_.stop_request = true;
+    thread_control_delivery_.terminate_done = 0;
+    thread_control_delivery_.end_code = 0;
+    thread_control_delivery_.terminate_request = 1;
+
+    // release any resources
+    ReleaseSemaphore(handle_semaphore_delivery_, 1, NULL);
+
+    // wait for the callback in progress to return
+    if (thread_handle_delivery_ != NULL) {
+        WaitForSingleObject(thread_handle_delivery_, INFINITE);
+        CloseHandle(thread_handle_delivery_);
+        thread_handle_delivery_ = NULL;
+    }
+    if (handle_semaphore_delivery_ != NULL) {
+        CloseHandle(handle_semaphore_delivery_);
+        handle_semaphore_delivery_ = NULL;
+    }
+
+    int ret = DPC_E_OK;
+
+    EnterCriticalSection(&stream_critical_);
+    for (int i = 0; i < kStreamCount; i++) {
+        StreamControl* stream_control = &stream_control_[i];
+
+        ReleaseSlotDataIfUnused(stream_control);
+
+        if (stream_control->slot_data != nullptr) {
+            // the buffers are left to the holder of the slots
+            if (isc_log_ != nullptr) {
+                isc_log_->LogWarning(L"IscDataCallbackControl", L"Terminate with the slots in use, the buffers are not released\n");
+            }
+            ret = ISCDPL_E_OPVERLAPED_OPERATION;
+        }
+    }
+    LeaveCriticalSection(&stream_critical_);
+
+    DeleteCriticalSection(&stream_critical_);
+
+    return ret;
+}
+
+/**
+ * カメラデータのCallbackを登録します.
+ *
+ * @param[in] callback Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::RegisterCameraDataCallback(IscCameraDataCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (callback == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = RegisterCallback(kStreamCameraData, callback, nullptr, user_context, isc_data_callback_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * カメラデータのCallbackを解除します.
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::UnregisterCameraDataCallback()
+{
+    int ret = UnregisterCallback(kStreamCameraData);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果のCallbackを登録します.
+ *
+ * @param[in] callback Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::RegisterDataProcResultCallback(IscDataProcResultCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (callback == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = RegisterCallback(kStreamDataProcResult, nullptr, callback, user_context, isc_data_callback_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果のCallbackを解除します.
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::UnregisterDataProcResultCallback()
+{
+    int ret = UnregisterCallback(kStreamDataProcResult);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Callbackで保持(kISC_DATA_CALLBACK_HOLD)したデータを解放します.
+ *
+ * @param[in] release_token Callbackで渡されたtoken
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::ReleaseCallbackData(const int release_token)
+{
+    if (release_token < 0) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const int generation = (release_token >> 16) & 0x7FFF;
+    const int stream = (release_token >> 8) & 0xFF;
+    const int slot_index = release_token & 0xFF;
+
+    if (stream < 0 || stream >= kStreamCount) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&stream_critical_);
+
+    StreamControl* stream_control = &stream_control_[stream];
+
+    if (stream_control->slot_data == nullptr || slot_index >= stream_control->slot_count) {
+        LeaveCriticalSection(&stream_critical_);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    SlotData* slot_data = &stream_control->slot_data[slot_index];
+    if (slot_data->state != kSLOT_STATE_HELD || slot_data->generation != generation) {
+        // already released or reused
+        LeaveCriticalSection(&stream_critical_);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    slot_data->state = kSLOT_STATE_FREE;
+    CountSlotStatus(stream_control);
+
+    if (!stream_control->registered) {
+        // the last one held after unregistering
+        ReleaseSlotDataIfUnused(stream_control);
+    }
+
+    LeaveCriticalSection(&stream_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 配信状態を取得します.
+ *
+ * @param[out] camera_data_status カメラデータの配信状態
+ * @param[out] data_proc_result_status データ処理結果の配信状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::GetCallbackStatus(IscDataCallbackStatus* camera_data_status, IscDataCallbackStatus* data_proc_result_status)
+{
+    EnterCriticalSection(&stream_critical_);
+
+    if (camera_data_status != nullptr) {
+        *camera_data_status = stream_control_[kStreamCameraData].status;
+    }
+
+    if (data_proc_result_status != nullptr) {
+        *data_proc_result_status = stream_control_[kStreamDataProcResult].status;
+    }
+
+    LeaveCriticalSection(&stream_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 配信Threadのハンドルを取得します
+ *
+ * @return Threadのハンドル
+ * @note Threadの配置を設定するために利用します
+ */
+HANDLE IscDataCallbackControl::GetThreadHandle()
+{
+    return thread_handle_delivery_;
+}
+
+/**
+ * カメラデータを配信キューに登録します.
+ *
+ * @param[in] isc_image_info カメラデータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 未登録時は何もしません
+ */
+int IscDataCallbackControl::PublishCameraData(const IscImageInfo* isc_image_info)
+{
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (!stream_control_[kStreamCameraData].registered) {
+        return DPC_E_OK;
+    }
+
+    int ret = Publish(kStreamCameraData, nullptr, isc_image_info);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果を配信キューに登録します.
+ *
+ * @param[in] isc_data_proc_result_data データ処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 未登録時は何もしません
+ */
+int IscDataCallbackControl::PublishDataProcResult(const IscDataProcResultData* isc_data_proc_result_data)
+{
+    if (isc_data_proc_result_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (!stream_control_[kStreamDataProcResult].registered) {
+        return DPC_E_OK;
+    }
+
+    int ret = Publish(kStreamDataProcResult, isc_data_proc_result_data, &isc_data_proc_result_data->isc_image_info);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 配信Threadです.
+ *
+ * @param[in] context Thread入力パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+unsigned __stdcall IscDataCallbackControl::ControlThreadDelivery(void* context)
+{
+    IscDataCallbackControl* isc_data_callback_control = (IscDataCallbackControl*)context;
+
+    if (isc_data_callback_control == nullptr) {
+        return -1;
+    }
+
+    int ret = isc_data_callback_control->DeliveryProc();
+
+    return ret;
+}
+
+/**
+ * 配信Threadの処理本体です.
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 各Streamの最も古いデータから順にCallbackを呼び出します
+ */
+int IscDataCallbackControl::DeliveryProc()
+{
+
+    constexpr DWORD wait_milli_seconds = 10;
+
+    while (thread_control_delivery_.terminate_request < 1) {
+
+        // Wait for data
+        DWORD wait_result = WaitForSingleObject(handle_semaphore_delivery_, wait_milli_seconds);
+
+        if (thread_control_delivery_.stop_request) {
+            thread_control_delivery_.stop_request = false;
+            break;
+        }
+
+        if (wait_result == WAIT_FAILED) {
+            // error, abort
+            break;
+        }
+
+        // deliver all queued data
+        for (;;) {
+            bool delivered = false;
+
+            for (int stream = 0; stream < kStreamCount; stream++) {
+
+                EnterCriticalSection(&stream_critical_);
+
+                StreamControl* stream_control = &stream_control_[stream];
+                if (!stream_control->registered || stream_control->slot_data == nullptr) {
+                    LeaveCriticalSection(&stream_critical_);
+                    continue;
+                }
+
+                // the oldest one
+                int slot_index = -1;
+                for (int i = 0; i < stream_control->slot_count; i++) {
+                    if (stream_control->slot_data[i].state != kSLOT_STATE_QUEUED) {
+                        continue;
+                    }
+                    if (slot_index < 0 || stream_control->slot_data[i].sequence < stream_control->slot_data[slot_index].sequence) {
+                        slot_index = i;
+                    }
+                }
+                if (slot_index < 0) {
+                    LeaveCriticalSection(&stream_critical_);
+                    continue;
+                }
+
+                SlotData* slot_data = &stream_control->slot_data[slot_index];
+                slot_data->state = kSLOT_STATE_DELIVERING;
+                CountSlotStatus(stream_control);
+
+                IscCameraDataCallback camera_data_callback = stream_control->camera_data_callback;
+                IscDataProcResultCallback data_proc_result_callback = stream_control->data_proc_result_callback;
+                void* user_context = stream_control->user_context;
+                const int release_token = MakeReleaseToken(slot_data->generation, stream, slot_index);
+
+                LeaveCriticalSection(&stream_critical_);
+
+                // call the client
+                int callback_result = kISC_DATA_CALLBACK_RELEASE;
+                if (camera_data_callback != nullptr) {
+                    callback_result = camera_data_callback(&slot_data->isc_data_proc_result_data.isc_image_info, release_token, user_context);
+                }
+                else if (data_proc_result_callback != nullptr) {
+                    callback_result = data_proc_result_callback(&slot_data->isc_data_proc_result_data, release_token, user_context);
+                }
+
+                EnterCriticalSection(&stream_critical_);
+
+                if (callback_result == kISC_DATA_CALLBACK_HOLD && stream_control->registered) {
+                    slot_data->state = kSLOT_STATE_HELD;
+                }
+                else {
+                    slot_data->state = kSLOT_STATE_FREE;
+                }
+                stream_control->status.delivered_count++;
+                CountSlotStatus(stream_control);
+
+                if (!stream_control->registered) {
+                    // unregistered in the callback or while delivering
+                    ReleaseSlotDataIfUnused(stream_control);
+                }
+
+                LeaveCriticalSection(&stream_critical_);
+
+                delivered = true;
+            }
+
+            if (!delivered) {
+                break;
+            }
+
+            if (thread_control_delivery_.terminate_request > 0) {
+                break;
+            }
+        }
+    }
+
+    thread_control_delivery_.terminate_done = 1;
+
+    return 0;
+}
+
+/**
+ * Callbackを登録します.
+ *
+ * @param[in] stream 対象Stream
+ * @param[in] camera_data_callback カメラデータCallback関数
+ * @param[in] data_proc_result_callback データ処理結果Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 解除前のデータを保持したままの場合は、ReleaseCallbackDataで解放するまで登録できません
+ */
+int IscDataCallbackControl::RegisterCallback(const int stream, IscCameraDataCallback camera_data_callback, IscDataProcResultCallback data_proc_result_callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (isc_data_callback_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_callback_parameter->max_queue_count < 1 || isc_data_callback_parameter->max_queue_count > kISC_DATA_CALLBACK_MAX_QUEUE_COUNT) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    StreamControl* stream_control = &stream_control_[stream];
+
+    EnterCriticalSection(&stream_critical_);
+
+    if (stream_control->registered) {
+        LeaveCriticalSection(&stream_critical_);
+        return ISCDPL_E_OPVERLAPED_OPERATION;
+    }
+
+    // left by unregistering, the client still holds some data or the publisher is writing
+    if (IsSlotDataInUse(stream_control)) {
+        LeaveCriticalSection(&stream_critical_);
+        return ISCDPL_E_OPVERLAPED_OPERATION;
+    }
+    ReleaseSlotData(stream_control);
+
+    int ret = AllocateSlotData(stream_control, isc_data_callback_parameter->max_queue_count);
+    if (ret != DPC_E_OK) {
+        LeaveCriticalSection(&stream_critical_);
+        return ret;
+    }
+
+    stream_control->camera_data_callback = camera_data_callback;
+    stream_control->data_proc_result_callback = data_proc_result_callback;
+    stream_control->user_context = user_context;
+    stream_control->parameter = *isc_data_callback_parameter;
+    stream_control->next_sequence = 0;
+    memset(&stream_control->status, 0, sizeof(IscDataCallbackStatus));
+    stream_control->status.registered = true;
+    stream_control->registered = true;
+
+    LeaveCriticalSection(&stream_critical_);
+
+    if (isc_log_ != nullptr) {
+        wchar_t log_msg[256] = {};
+        swprintf_s(log_msg, L"Register callback stream=%d queue=%d policy=%d\n", stream, isc_data_callback_parameter->max_queue_count, (int)isc_data_callback_parameter->drop_policy);
+        isc_log_->LogInfo(L"IscDataCallbackControl", log_msg);
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Callbackを解除します.
+ *
+ * @param[in] stream 対象Stream
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note バッファーは、書き込み中・配信中・保持中のSlotが無くなった時点で解放します
+ * @note Callback内から呼び出された場合は、バッファーの解放は配信Threadで行います
+ * @note 保持中のSlotがある場合は、最後のReleaseCallbackDataで解放します
+ */
+int IscDataCallbackControl::UnregisterCallback(const int stream)
+{
+    StreamControl* stream_control = &stream_control_[stream];
+
+    EnterCriticalSection(&stream_critical_);
+
+    if (!stream_control->registered) {
+        LeaveCriticalSection(&stream_critical_);
+        return DPC_E_OK;
+    }
+
+    stream_control->registered = false;
+    stream_control->status.registered = false;
+    stream_control->camera_data_callback = nullptr;
+    stream_control->data_proc_result_callback = nullptr;
+
+    // queued data will not be delivered
+    for (int i = 0; i < stream_control->slot_count; i++) {
+        if (stream_control->slot_data[i].state == kSLOT_STATE_QUEUED) {
+            stream_control->slot_data[i].state = kSLOT_STATE_FREE;
+        }
+    }
+    CountSlotStatus(stream_control);
+    ReleaseSlotDataIfUnused(stream_control);
+
+    LeaveCriticalSection(&stream_critical_);
+
+    if (GetCurrentThreadId() == thread_id_delivery_) {
+        // called in the callback
+        return DPC_E_OK;
+    }
+
+    // wait for writing and delivering
+    int count = 0;
+    for (;;) {
+        bool in_use = false;
+
+        EnterCriticalSection(&stream_critical_);
+        for (int i = 0; i < stream_control->slot_count; i++) {
+            const int state = stream_control->slot_data[i].state;
+            if (state == kSLOT_STATE_WRITING || state == kSLOT_STATE_DELIVERING) {
+                in_use = true;
+                break;
+            }
+        }
+        if (!in_use) {
+            // held slots are released by ReleaseCallbackData
+            ReleaseSlotDataIfUnused(stream_control);
+        }
+        LeaveCriticalSection(&stream_critical_);
+
+        if (!in_use) {
+            break;
+        }
+
+        if (count > 100) {
+            if (isc_log_ != nullptr) {
+                isc_log_->LogWarning(L"IscDataCallbackControl", L"Unregister timed out, the callback has not returned\n");
+            }
+            return ISCDPL_E_OPVERLAPED_OPERATION;
+        }
+        count++;
+        Sleep(10L);
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データを配信キューに登録します.
+ *
+ * @param[in] stream 対象Stream
+ * @param[in] isc_data_proc_result_data データ処理結果(カメラデータの場合はnullptr)
+ * @param[in] isc_image_info 画像データ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::Publish(const int stream, const IscDataProcResultData* isc_data_proc_result_data, const IscImageInfo* isc_image_info)
+{
+    EnterCriticalSection(&stream_critical_);
+
+    StreamControl* stream_control = &stream_control_[stream];
+    if (!stream_control->registered || stream_control->slot_data == nullptr) {
+        LeaveCriticalSection(&stream_critical_);
+        return DPC_E_OK;
+    }
+
+    // find a free slot
+    int slot_index = -1;
+    for (int i = 0; i < stream_control->slot_count; i++) {
+        if (stream_control->slot_data[i].state == kSLOT_STATE_FREE) {
+            slot_index = i;
+            break;
+        }
+    }
+
+    if (slot_index < 0) {
+        // queue is full
+        if (stream_control->parameter.drop_policy == IscDataCallbackDropPolicy::kDropOldest) {
+            for (int i = 0; i < stream_control->slot_count; i++) {
+                if (stream_control->slot_data[i].state != kSLOT_STATE_QUEUED) {
+                    continue;
+                }
+                if (slot_index < 0 || stream_control->slot_data[i].sequence < stream_control->slot_data[slot_index].sequence) {
+                    slot_index = i;
+                }
+            }
+        }
+
+        stream_control->status.dropped_count++;
+
+        if (slot_index < 0) {
+            // all slots are in delivery or held, discard new one
+            LeaveCriticalSection(&stream_critical_);
+            return DPC_E_OK;
+        }
+    }
+
+    SlotData* slot_data = &stream_control->slot_data[slot_index];
+    slot_data->state = kSLOT_STATE_WRITING;
+    generation_ = (generation_ + 1) & 0x7FFF;
+    slot_data->generation = generation_;
+    CountSlotStatus(stream_control);
+
+    LeaveCriticalSection(&stream_critical_);
+
+    // copy
+    IscDataProcResultData* dst = &slot_data->isc_data_proc_result_data;
+    if (isc_data_proc_result_data != nullptr) {
+        dst->number_of_modules_processed = isc_data_proc_result_data->number_of_modules_processed;
+        dst->maximum_number_of_modules = isc_data_proc_result_data->maximum_number_of_modules;
+        dst->maximum_number_of_modulename = isc_data_proc_result_data->maximum_number_of_modulename;
+        dst->status = isc_data_proc_result_data->status;
+        for (int i = 0; i < 4; i++) {
+            dst->module_status[i] = isc_data_proc_result_data->module_status[i];
+        }
+    }
+    CopyIscImageInfo(&dst->isc_image_info, isc_image_info);
+
+    EnterCriticalSection(&stream_critical_);
+
+    if (!stream_control->registered) {
+        // unregistered while writing, the buffers are released here if this is the last user
+        slot_data->state = kSLOT_STATE_FREE;
+        CountSlotStatus(stream_control);
+        ReleaseSlotDataIfUnused(stream_control);
+        LeaveCriticalSection(&stream_critical_);
+        return DPC_E_OK;
+    }
+
+    slot_data->state = kSLOT_STATE_QUEUED;
+    slot_data->sequence = stream_control->next_sequence++;
+    stream_control->status.published_count++;
+    CountSlotStatus(stream_control);
+
+    LeaveCriticalSection(&stream_critical_);
+
+    // wake up the delivery thread, it fails if already signaled
+    ReleaseSemaphore(handle_semaphore_delivery_, 1, NULL);
+
+    return DPC_E_OK;
+}
+
+/**
+ * Slotのバッファーを確保します.
+ *
+ * @param[in] stream_control 対象Stream
+ * @param[in] slot_count Slot数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::AllocateSlotData(StreamControl* stream_control, const int slot_count)
+{
+    const size_t one_frame_size = (size_t)max_width_ * max_height_;
+    const int max_fd_count = kISCIMAGEINFO_FRAMEDATA_MAX_COUNT;
+    const size_t image_unit = one_frame_size * kSLOT_IMAGE_BYTES_PER_PIXEL;
+
+    stream_control->slot_count = slot_count;
+    stream_control->slot_data = new SlotData[slot_count];
+    stream_control->buff_image = new unsigned char[slot_count * max_fd_count * image_unit];
+    stream_control->buff_depth = new float[slot_count * max_fd_count * one_frame_size];
+
+    for (int i = 0; i < slot_count; i++) {
+        SlotData* slot_data = &stream_control->slot_data[i];
+        memset(slot_data, 0, sizeof(SlotData));
+
+        slot_data->isc_data_proc_result_data.maximum_number_of_modules = 4;
+        slot_data->isc_data_proc_result_data.maximum_number_of_modulename = 32;
+
+        for (int j = 0; j < max_fd_count; j++) {
+            IscImageInfo::FrameData* frame_data = &slot_data->isc_data_proc_result_data.isc_image_info.frame_data[j];
+            unsigned char* image_top = stream_control->buff_image + (image_unit * ((i * max_fd_count) + j));
+
+            frame_data->p1.image = image_top;
+            frame_data->p2.image = image_top + one_frame_size;
+            frame_data->color.image = image_top + one_frame_size * 2;
+            frame_data->raw.image = image_top + one_frame_size * 5;
+            frame_data->raw_color.image = image_top + one_frame_size * 7;
+            frame_data->depth.image = stream_control->buff_depth + (one_frame_size * ((i * max_fd_count) + j));
+        }
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Slotのバッファーを解放します.
+ *
+ * @param[in] stream_control 対象Stream
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::ReleaseSlotData(StreamControl* stream_control)
+{
+    delete[] stream_control->slot_data;
+    delete[] stream_control->buff_image;
+    delete[] stream_control->buff_depth;
+
+    stream_control->slot_data = nullptr;
+    stream_control->buff_image = nullptr;
+    stream_control->buff_depth = nullptr;
+    stream_control->slot_count = 0;
+
+    stream_control->status.queued_count = 0;
+    stream_control->status.held_count = 0;
+
+    return DPC_E_OK;
+}
+
+/**
+ * Slotが使用中かどうかを確認します.
+ *
+ * @param[in] stream_control 対象Stream
+ * @retval true 書き込み中・配信中・保持中のSlotがある
+ * @retval false 使用中のSlotは無い
+ * @note stream_critical_ 内で呼び出します
+ */
+bool IscDataCallbackControl::IsSlotDataInUse(const StreamControl* stream_control)
+{
+    for (int i = 0; i < stream_control->slot_count; i++) {
+        const int state = stream_control->slot_data[i].state;
+        if (state == kSLOT_STATE_WRITING || state == kSLOT_STATE_DELIVERING || state == kSLOT_STATE_HELD) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * 使用中のSlotが無ければ、Slotのバッファーを解放します.
+ *
+ * @param[in] stream_control 対象Stream
+ * @return none
+ * @note stream_critical_ 内で、解除後に呼び出します
+ */
+void IscDataCallbackControl::ReleaseSlotDataIfUnused(StreamControl* stream_control)
+{
+    if (stream_control->slot_data == nullptr || IsSlotDataInUse(stream_control)) {
+        return;
+    }
+
+    ReleaseSlotData(stream_control);
+
+    return;
+}
+
+/**
+ * IscImageInfoの内容をコピーします
+ *
+ * @param[out] dst_isc_image_info コピー先
+ * @param[in] src_isc_image_info コピー元
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscDataCallbackControl::CopyIscImageInfo(IscImageInfo* dst_isc_image_info, const IscImageInfo* src_isc_image_info)
+{
+    dst_isc_image_info->grab = src_isc_image_info->grab;
+    dst_isc_image_info->color_grab_mode = src_isc_image_info->color_grab_mode;
+    dst_isc_image_info->shutter_mode = src_isc_image_info->shutter_mode;
+    dst_isc_image_info->camera_specific_parameter = src_isc_image_info->camera_specific_parameter;
+
+    for (int i = 0; i < kISCIMAGEINFO_FRAMEDATA_MAX_COUNT; i++) {
+        IscImageInfo::FrameData* dst = &dst_isc_image_info->frame_data[i];
+        const IscImageInfo::FrameData* src = &src_isc_image_info->frame_data[i];
+
+        dst->camera_status = src->camera_status;
+        dst->frame_time = src->frame_time;
+        dst->data_index = src->data_index;
+        dst->frameNo = src->frameNo;
+        dst->gain = src->gain;
+        dst->exposure = src->exposure;
+
+        dst->p1.width = src->p1.width;
+        dst->p1.height = src->p1.height;
+        dst->p1.channel_count = src->p1.channel_count;
+        size_t copy_size = (size_t)src->p1.width * src->p1.height * src->p1.channel_count;
+        if (copy_size > 0) {
+            memcpy(dst->p1.image, src->p1.image, copy_size);
+        }
+
+        dst->p2.width = src->p2.width;
+        dst->p2.height = src->p2.height;
+        dst->p2.channel_count = src->p2.channel_count;
+        copy_size = (size_t)src->p2.width * src->p2.height * src->p2.channel_count;
+        if (copy_size > 0) {
+            memcpy(dst->p2.image, src->p2.image, copy_size);
+        }
+
+        dst->color.width = src->color.width;
+        dst->color.height = src->color.height;
+        dst->color.channel_count = src->color.channel_count;
+        copy_size = (size_t)src->color.width * src->color.height * src->color.channel_count;
+        if (copy_size > 0) {
+            memcpy(dst->color.image, src->color.image, copy_size);
+        }
+
+        dst->depth.width = src->depth.width;
+        dst->depth.height = src->depth.height;
+        copy_size = (size_t)src->depth.width * src->depth.height * sizeof(float);
+        if (copy_size > 0) {
+            memcpy(dst->depth.image, src->depth.image, copy_size);
+        }
+
+        dst->raw.width = src->raw.width;
+        dst->raw.height = src->raw.height;
+        dst->raw.channel_count = src->raw.channel_count;
+        copy_size = (size_t)src->raw.width * src->raw.height * src->raw.channel_count;
+        if (copy_size > 0) {
+            memcpy(dst->raw.image, src->raw.image, copy_size);
+        }
+
+        dst->raw_color.width = src->raw_color.width;
+        dst->raw_color.height = src->raw_color.height;
+        dst->raw_color.channel_count = src->raw_color.channel_count;
+        copy_size = (size_t)src->raw_color.width * src->raw_color.height * src->raw_color.channel_count;
+        if (copy_size > 0) {
+            memcpy(dst->raw_color.image, src->raw_color.image, copy_size);
+        }
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 解放用のtokenを作成します.
+ *
+ * @param[in] generation Slotの世代
+ * @param[in] stream 対象Stream
+ * @param[in] slot_index SlotのIndex
+ * @return token
+ */
+int IscDataCallbackControl::MakeReleaseToken(const int generation, const int stream, const int slot_index)
+{
+    return ((generation & 0x7FFF) << 16) | ((stream & 0xFF) << 8) | (slot_index & 0xFF);
+}
+
+/**
+ * キュー・保持中の数を更新します.
+ *
+ * @param[in] stream_control 対象Stream
+ * @return none
+ * @note stream_critical_ 内で呼び出します
+ */
+void IscDataCallbackControl::CountSlotStatus(StreamControl* stream_control)
+{
+    int queued_count = 0, held_count = 0;
+    for (int i = 0; i < stream_control->slot_count; i++) {
+        if (stream_control->slot_data[i].state == kSLOT_STATE_QUEUED) {
+            queued_count++;
+        }
+        else if (stream_control->slot_data[i].state == kSLOT_STATE_HELD) {
+            held_count++;
+        }
+    }
+    stream_control->status.queued_count = queued_count;
+    stream_control->status.held_count = held_count;
+
+    return;
+}
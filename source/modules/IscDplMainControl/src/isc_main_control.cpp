@@ -36,14 +36,20 @@
 #include "isc_dpl_def.h"
 #include "isc_log.h"
 #include "utility.h"
+#include "isc_thread_placement.h"
 
 #include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
 #include "vm_sdk_wrapper.h"
 #include "xc_sdk_wrapper.h"
 #include "k4a_sdk_wrapper.h"
 #include "isc_sdk_control.h"
 #include "isc_file_write_control_impl.h"
 #include "isc_raw_data_decoder.h"
+#include "isc_decoded_frame_cache.h"
 #include "isc_file_read_control_impl.h"
 #include "isc_selftcalibration_interface.h"
 #include "isc_camera_control.h"
@@ -53,6 +59,13 @@
 #include "isc_disparityfilter_interface.h"
 #include "isc_data_processing_control.h"
 #include "isc_measurement.h"
+#include "isc_point_cloud.h"
+#include "isc_occupancy_grid.h"
+#include "isc_uv_disparity.h"
+#include "isc_range_index.h"
+#include "isc_data_callback_control.h"
+#include "isc_reprocess_control.h"
+#include "isc_record_control.h"
 #include "isc_main_control_impl.h"
 
 #include "isc_main_control.h"
@@ -62,7 +75,8 @@
  *
  */
 IscMainControl::IscMainControl():
-	isc_main_control_impl_(nullptr)
+	isc_main_control_impl_(nullptr),
+	isc_thread_configuration_()
 {
 
 }
@@ -76,6 +90,29 @@ IscMainControl::~IscMainControl()
 
 }
 
+/**
+ * Threadの配置を設定します.
+ *
+ * @param[in] isc_thread_configuration 役割毎の配置
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Initializeの前に呼び出します。ParameterフォルダーのThreadParameter.iniが優先されます
+ */
+int IscMainControl::SetThreadConfiguration(const IscThreadConfiguration* isc_thread_configuration)
+{
+	if (isc_main_control_impl_ != nullptr) {
+		return ISCDPL_E_OPVERLAPED_OPERATION;
+	}
+
+	if (isc_thread_configuration == nullptr) {
+		return ISCDPL_E_INVALID_PARAMETER;
+	}
+
+	isc_thread_configuration_ = *isc_thread_configuration;
+
+	return DPC_E_OK;
+}
+
 /**
  * クラスを初期化します.
  *
@@ -90,6 +127,7 @@ int IscMainControl::Initialize(const IscDplConfiguration* ipc_dpl_configuration)
 	}
 
 	isc_main_control_impl_ = new IscMainControlImpl;
+	isc_main_control_impl_->SetThreadConfiguration(&isc_thread_configuration_);
 	int ret = isc_main_control_impl_->Initialize(ipc_dpl_configuration);
 	if (ret != DPC_E_OK) {
 		return ret;
@@ -1644,3 +1682,1404 @@ int IscMainControl::GetDataProcModuleData(IscDataProcResultData* isc_data_proc_r
     return DPC_E_OK;
 }
 
+/**
+ * カメラデータを受け取るCallbackを登録します
+ *
+ * @param[in] callback Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Callbackは配信Threadから呼び出されます。kISC_DATA_CALLBACK_HOLDを返した場合はReleaseCallbackDataで解放してください
+ */
+int IscMainControl::RegisterCameraDataCallback(IscCameraDataCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (callback == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_callback_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->RegisterCameraDataCallback(callback, user_context, isc_data_callback_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * カメラデータのCallbackを解除します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::UnregisterCameraDataCallback()
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_main_control_impl_->UnregisterCameraDataCallback();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果を受け取るCallbackを登録します
+ *
+ * @param[in] callback Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Callbackは配信Threadから呼び出されます。kISC_DATA_CALLBACK_HOLDを返した場合はReleaseCallbackDataで解放してください
+ */
+int IscMainControl::RegisterDataProcResultCallback(IscDataProcResultCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (callback == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_callback_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->RegisterDataProcResultCallback(callback, user_context, isc_data_callback_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果のCallbackを解除します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::UnregisterDataProcResultCallback()
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_main_control_impl_->UnregisterDataProcResultCallback();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Callbackで保持したデータを解放します
+ *
+ * @param[in] release_token Callbackで渡されたtoken
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::ReleaseCallbackData(const int release_token)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_main_control_impl_->ReleaseCallbackData(release_token);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Callbackの配信状態を取得します
+ *
+ * @param[out] camera_data_status カメラデータの配信状態
+ * @param[out] data_proc_result_status データ処理結果の配信状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetCallbackStatus(IscDataCallbackStatus* camera_data_status, IscDataCallbackStatus* data_proc_result_status)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (camera_data_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (data_proc_result_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetCallbackStatus(camera_data_status, data_proc_result_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * モジュールの処理結果のうち、指定された項目のみを取得します
+ *
+ * @param[in,out] isc_data_proc_partial_result_data 取得項目・バッファー指定と処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetDataProcModuleDataPartial(IscDataProcPartialResultData* isc_data_proc_partial_result_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_data_proc_partial_result_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetDataProcModuleDataPartial(isc_data_proc_partial_result_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理の受付制御パラメータを設定します
+ *
+ * @param[in] isc_dataproc_admission_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::SetAdmissionParameter(const IscDataProcAdmissionParameter* isc_dataproc_admission_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_admission_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetAdmissionParameter(isc_dataproc_admission_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理の受付制御パラメータを取得します
+ *
+ * @param[out] isc_dataproc_admission_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetAdmissionParameter(IscDataProcAdmissionParameter* isc_dataproc_admission_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_admission_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetAdmissionParameter(isc_dataproc_admission_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理の受付制御の状態と最新の判定結果を取得します
+ *
+ * @param[out] isc_dataproc_admission_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetAdmissionStatus(IscDataProcAdmissionStatus* isc_dataproc_admission_status)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_admission_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetAdmissionStatus(isc_dataproc_admission_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ライブラリのThreadに適用したCPUの集合と優先度を取得します
+ *
+ * @param[out] isc_thread_placement_status 配置の一覧
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 設定はIscDplConfiguration又はThreadParameter.iniで行います
+ */
+int IscMainControl::GetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_thread_placement_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetThreadPlacement(isc_thread_placement_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果の縮小プレビューのパラメータを設定します
+ *
+ * @param[in] isc_dataproc_preview_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::SetPreviewParameter(const IscDataProcPreviewParameter* isc_dataproc_preview_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_preview_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetPreviewParameter(isc_dataproc_preview_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果の縮小プレビューのパラメータを取得します
+ *
+ * @param[out] isc_dataproc_preview_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetPreviewParameter(IscDataProcPreviewParameter* isc_dataproc_preview_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_preview_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPreviewParameter(isc_dataproc_preview_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果の最新の縮小プレビューを呼び出し側のバッファーへ取得します
+ *
+ * @param[in,out] isc_dataproc_preview_data 取得先
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetPreviewData(IscDataProcPreviewData* isc_dataproc_preview_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_preview_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPreviewData(isc_dataproc_preview_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 読み込みFrameを指定時刻以降の最初のFrameとします
+ *
+ * @param[in] frame_time 指定時刻 (UTC msec)
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::SetReadFrameTime(const __int64 frame_time)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_main_control_impl_->SetReadFrameTime(frame_time);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルのインデックスを作成します
+ *
+ * @param[in] play_file_name RAWデータファイル名
+ * @param[out] entry_count 作成したEntryの数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note インデックス無しで保存されたファイル用です
+ */
+int IscMainControl::RebuildFileIndex(const wchar_t* play_file_name, __int64* entry_count)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (play_file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (entry_count == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->RebuildFileIndex(play_file_name, entry_count);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮を設定します
+ *
+ * @param[in] isc_record_compression_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の保存開始時に適用します
+ */
+int IscMainControl::SetRecordCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_compression_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetRecordCompressionParameter(isc_record_compression_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮の設定を取得します
+ *
+ * @param[out] isc_record_compression_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetRecordCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_compression_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetRecordCompressionParameter(isc_record_compression_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮の結果を取得します
+ *
+ * @param[out] isc_record_compression_statistics 圧縮の結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetRecordCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_compression_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetRecordCompressionStatistics(isc_record_compression_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の書き込みを設定します
+ *
+ * @param[in] isc_record_write_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の保存開始時に適用します
+ */
+int IscMainControl::SetRecordWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_write_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetRecordWriteParameter(isc_record_write_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の書き込みの設定を取得します
+ *
+ * @param[out] isc_record_write_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetRecordWriteParameter(IscRecordWriteParameter* isc_record_write_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_write_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetRecordWriteParameter(isc_record_write_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の書き込みの結果を取得します
+ *
+ * @param[out] isc_record_write_statistics 書き込みの結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetRecordWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_write_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetRecordWriteStatistics(isc_record_write_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再生の速度制御と処理時間の結果を取得します
+ *
+ * @param[out] isc_play_statistics 再生の結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetPlayStatistics(IscPlayStatistics* isc_play_statistics)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPlayStatistics(isc_play_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再処理のためにRAWデータファイルを範囲に分割します
+ *
+ * @param[in] play_file_name ファイル名
+ * @param[in] range_count 分割数 1~kISC_REPROCESS_MAX_RANGE_COUNT
+ * @param[out] isc_reprocess_range_list 分割結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::MakeReprocessRanges(const wchar_t* play_file_name, const int range_count, IscReprocessRangeList* isc_reprocess_range_list)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (play_file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_reprocess_range_list == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->MakeReprocessRanges(play_file_name, range_count, isc_reprocess_range_list);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルの範囲を処理し、結果ファイルに書き込みます
+ *
+ * @param[in] isc_reprocess_parameter パラメータ
+ * @param[out] isc_reprocess_status 処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 取り込みを停止した状態で呼び出します。範囲の処理が終わるまで戻りません
+ */
+int IscMainControl::ReprocessRange(const IscReprocessParameter* isc_reprocess_parameter, IscReprocessStatus* isc_reprocess_status)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_reprocess_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_reprocess_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->ReprocessRange(isc_reprocess_parameter, isc_reprocess_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 範囲の結果ファイルを順に結合します
+ *
+ * @param[in] isc_reprocess_merge_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::MergeReprocessResults(const IscReprocessMergeParameter* isc_reprocess_merge_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_reprocess_merge_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->MergeReprocessResults(isc_reprocess_merge_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果のブロック視差の記録を開始します
+ *
+ * @param[in] isc_result_record_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理の結果が格納される毎に書き込みます
+ */
+int IscMainControl::StartResultRecord(const IscResultRecordParameter* isc_result_record_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_result_record_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->StartResultRecord(isc_result_record_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録を停止し、Indexを書き込みます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::StopResultRecord()
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_main_control_impl_->StopResultRecord();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録の状態を取得します
+ *
+ * @param[out] isc_result_record_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetResultRecordStatus(IscResultRecordStatus* isc_result_record_status)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_result_record_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetResultRecordStatus(isc_result_record_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録ファイルを開きます
+ *
+ * @param[in] file_name ファイル名
+ * @param[out] isc_result_record_information ファイルの情報
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::OpenResultRecord(const wchar_t* file_name, IscResultRecordInformation* isc_result_record_information)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_result_record_information == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->OpenResultRecord(file_name, isc_result_record_information);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録ファイルから1Frameを読み込みます
+ *
+ * @param[in] frame_number Frame番号 0~frame_count-1
+ * @param[in,out] isc_result_record_frame 読み込み先とFrameの情報
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::ReadResultRecord(const __int64 frame_number, IscResultRecordFrame* isc_result_record_frame)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_result_record_frame == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->ReadResultRecord(frame_number, isc_result_record_frame);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録ファイルを閉じます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::CloseResultRecord()
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_main_control_impl_->CloseResultRecord();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再生時に展開済みFrameを保持、先読みする方法を設定します
+ *
+ * @param[in] isc_play_cache_parameter 設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の再生の開始から適用します
+ */
+int IscMainControl::SetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_cache_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetPlayCacheParameter(isc_play_cache_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再生時に展開済みFrameを保持、先読みする方法を取得します
+ *
+ * @param[out] isc_play_cache_parameter 設定
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_cache_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPlayCacheParameter(isc_play_cache_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 展開済みFrameの保持の状態を取得します
+ *
+ * @param[out] isc_play_cache_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_cache_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPlayCacheStatus(isc_play_cache_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 複数の領域の情報を一括して取得します
+ *
+ * @param[in] roi_count 領域の数
+ * @param[in] min_distance 有効な最小の距離(m)
+ * @param[in] max_distance 有効な最大の距離(m)
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_data_statistics 領域の情報 x,y,width,heightで領域を指定します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 視差画像全体の集計表を1回作成し、各領域の情報は表から求めます
+ */
+int IscMainControl::GetAreaStatisticsBatch(const int roi_count, const float min_distance, const float max_distance, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetAreaStatisticsBatch(roi_count, min_distance, max_distance, isc_image_info, isc_data_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 視差を点群に変換します
+ *
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_point_cloud_data 点群 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note バッファーは間引き後の格子の全点を保持できる大きさが必要です
+ */
+int IscMainControl::GetPointCloud(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_point_cloud_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_point_cloud_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPointCloud(isc_point_cloud_parameter, isc_image_info, isc_point_cloud_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 視差を点群に変換し、ファイルに書き込みます
+ *
+ * @param[in] file_name ファイル名
+ * @param[in] file_format ファイルの形式
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_image_info データ構造体
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note PLYには有効な点のみを書き込みます
+ */
+int IscMainControl::SavePointCloud(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_point_cloud_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SavePointCloud(file_name, file_format, isc_point_cloud_parameter, isc_image_info);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 複数の位置の視差、距離と3D位置を一括して取得します
+ *
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_position_batch 位置と結果 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note window_sizeが0の場合は、GetPosition3D()と同じ結果となります
+ */
+int IscMainControl::GetPosition3DBatch(const IscImageInfo* isc_image_info, IscPositionBatch* isc_position_batch)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_position_batch == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetPosition3DBatch(isc_image_info, isc_position_batch);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Occupancy gridのパラメータを設定します
+ *
+ * @param[in] isc_occupancy_grid_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Gridとvoxelは消去されます
+ */
+int IscMainControl::SetOccupancyGridParameter(const IscOccupancyGridParameter* isc_occupancy_grid_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_occupancy_grid_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetOccupancyGridParameter(isc_occupancy_grid_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Occupancy gridのパラメータを取得します
+ *
+ * @param[out] isc_occupancy_grid_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetOccupancyGridParameter(IscOccupancyGridParameter* isc_occupancy_grid_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_occupancy_grid_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetOccupancyGridParameter(isc_occupancy_grid_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のOccupancy gridを取得します
+ *
+ * @param[in,out] isc_occupancy_grid_data Grid バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetOccupancyGrid(IscOccupancyGridData* isc_occupancy_grid_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_occupancy_grid_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetOccupancyGrid(isc_occupancy_grid_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のVoxelを取得します
+ *
+ * @param[in,out] isc_voxel_map_data Voxel バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note max_voxel_countを超えるVoxelは取得しません
+ */
+int IscMainControl::GetVoxelMap(IscVoxelMapData* isc_voxel_map_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_voxel_map_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetVoxelMap(isc_voxel_map_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * u-disparity, v-disparityのパラメータを設定します
+ *
+ * @param[in] isc_uv_disparity_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 集計結果は消去されます
+ */
+int IscMainControl::SetUvDisparityParameter(const IscUvDisparityParameter* isc_uv_disparity_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_uv_disparity_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetUvDisparityParameter(isc_uv_disparity_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * u-disparity, v-disparityのパラメータを取得します
+ *
+ * @param[out] isc_uv_disparity_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetUvDisparityParameter(IscUvDisparityParameter* isc_uv_disparity_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_uv_disparity_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetUvDisparityParameter(isc_uv_disparity_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のu-disparity, v-disparityと地面の直線を取得します
+ *
+ * @param[in,out] isc_uv_disparity_data 集計結果 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetUvDisparity(IscUvDisparityData* isc_uv_disparity_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_uv_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetUvDisparity(isc_uv_disparity_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Range indexのパラメータを設定し、毎フレーム評価する領域を登録します
+ *
+ * @param[in] isc_range_index_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 作成済みの表は消去されます
+ */
+int IscMainControl::SetRangeIndexParameter(const IscRangeIndexParameter* isc_range_index_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_index_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->SetRangeIndexParameter(isc_range_index_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Range indexのパラメータを取得します
+ *
+ * @param[out] isc_range_index_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetRangeIndexParameter(IscRangeIndexParameter* isc_range_index_parameter)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_index_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetRangeIndexParameter(isc_range_index_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの登録した領域の結果を取得します
+ *
+ * @param[out] isc_range_zone_data 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetRangeZoneData(IscRangeZoneData* isc_range_zone_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_zone_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetRangeZoneData(isc_range_zone_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの任意の領域の最小/最大の距離と範囲内のBlockの数を取得します
+ *
+ * @param[in] isc_range_zone 領域
+ * @param[out] isc_range_zone_result 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::QueryRange(const IscRangeZone* isc_range_zone, IscRangeZoneResult* isc_range_zone_result)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_zone == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_range_zone_result == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->QueryRange(isc_range_zone, isc_range_zone_result);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの固定小数点のBlock毎の視差を取得します
+ *
+ * @param[in,out] isc_block_disparity_fixed_data Block毎の視差 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note block_valueがnullptrの場合は、大きさのみを取得します
+ */
+int IscMainControl::GetBlockDisparityFixed(IscBlockDisparityFixedData* isc_block_disparity_fixed_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_block_disparity_fixed_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetBlockDisparityFixed(isc_block_disparity_fixed_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの固定小数点のBlock毎の視差から、指定位置の距離を取得します
+ *
+ * @param[in] x 画像内座標(X)
+ * @param[in] y 画像内座標(Y)
+ * @param[out] disparity 視差
+ * @param[out] depth 距離(m)
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControl::GetBlockPositionDepth(const int x, const int y, float* disparity, float* depth)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (disparity == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (depth == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetBlockPositionDepth(x, y, disparity, depth);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの視差のあるBlockのリストを取得します
+ *
+ * @param[in,out] isc_valid_block_list_data Blockのリスト バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note valid_blockがnullptrの場合は、数のみを取得します
+ */
+int IscMainControl::GetValidBlockList(IscValidBlockListData* isc_valid_block_list_data)
+{
+    if (isc_main_control_impl_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_valid_block_list_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_main_control_impl_->GetValidBlockList(isc_valid_block_list_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
@@ -36,14 +36,20 @@
 #include "isc_dpl_def.h"
 #include "isc_log.h"
 #include "utility.h"
+#include "isc_thread_placement.h"
 
 #include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
 #include "vm_sdk_wrapper.h"
 #include "xc_sdk_wrapper.h"
 #include "k4a_sdk_wrapper.h"
 #include "isc_sdk_control.h"
 #include "isc_file_write_control_impl.h"
 #include "isc_raw_data_decoder.h"
+#include "isc_decoded_frame_cache.h"
 #include "isc_file_read_control_impl.h"
 #include "isc_selftcalibration_interface.h"
 #include "isc_camera_control.h"
@@ -53,6 +59,13 @@
 #include "isc_disparityfilter_interface.h"
 #include "isc_data_processing_control.h"
 #include "isc_measurement.h"
+#include "isc_point_cloud.h"
+#include "isc_occupancy_grid.h"
+#include "isc_uv_disparity.h"
+#include "isc_range_index.h"
+#include "isc_data_callback_control.h"
+#include "isc_reprocess_control.h"
+#include "isc_record_control.h"
 
 #include "isc_main_control_impl.h"
 
@@ -70,6 +83,10 @@
 #pragma comment (lib,"opencv_world480")
 #endif
 
+constexpr int kISC_POINT_CLOUD_THREAD_COUNT = 4;	/**< 点群の変換に使用するthread数 */
+constexpr int kISC_OCCUPANCY_GRID_THREAD_COUNT = 4;	/**< Occupancy gridの作成に使用するthread数 */
+constexpr int kISC_UV_DISPARITY_THREAD_COUNT = 4;	/**< u-disparity, v-disparityの作成に使用するthread数 */
+
 /**
  * constructor
  *
@@ -79,10 +96,19 @@ IscMainControlImpl::IscMainControlImpl():
     log_file_name_(),
     freq_for_performance_counter(),
 	ipc_dpl_configuration_(),
+    isc_thread_configuration_(),
     isc_camera_control_(nullptr),
     isc_data_processing_control_(nullptr),
     isc_image_info_ring_buffer_(nullptr),
     isc_measurement_(nullptr),
+    isc_point_cloud_(nullptr),
+    isc_occupancy_grid_(nullptr),
+    isc_uv_disparity_(nullptr),
+    isc_range_index_(nullptr),
+    isc_data_callback_control_(nullptr),
+    isc_reprocess_control_(nullptr),
+    isc_record_control_(nullptr),
+    isc_thread_placement_(nullptr),
     temp_isc_grab_start_mode_(),
     temp_isc_dataproc_start_mode_(),
     work_buffers_(),
@@ -105,6 +131,25 @@ IscMainControlImpl::~IscMainControlImpl()
 
 }
 
+/**
+ * Threadの配置を設定します.
+ *
+ * @param[in] isc_thread_configuration 役割毎の配置
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Initializeの前に呼び出します。ParameterフォルダーのThreadParameter.iniが優先されます
+ */
+int IscMainControlImpl::SetThreadConfiguration(const IscThreadConfiguration* isc_thread_configuration)
+{
+    if (isc_thread_configuration == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    isc_thread_configuration_ = *isc_thread_configuration;
+
+    return DPC_E_OK;
+}
+
 /**
  * クラスを初期化します.
  *
@@ -128,6 +173,11 @@ int IscMainControlImpl::Initialize(const IscDplConfiguration* ipc_dpl_configurat
 
     ipc_dpl_configuration_.enabled_data_proc_module = ipc_dpl_configuration->enabled_data_proc_module;
 
+    // thread placement, the file overrides the configuration set by SetThreadConfiguration
+    wchar_t thread_parameter_file_name[_MAX_PATH] = {};
+    swprintf_s(thread_parameter_file_name, L"%s\\ThreadParameter.ini", ipc_dpl_configuration_.configuration_file_path);
+    IscThreadPlacement::LoadFromFile(thread_parameter_file_name, &isc_thread_configuration_);
+
     IscCameraControlConfiguration isc_camera_control_config = {};
     swprintf_s(isc_camera_control_config.configuration_file_path, L"%s", ipc_dpl_configuration_.configuration_file_path);
     swprintf_s(isc_camera_control_config.log_file_path, L"%s", ipc_dpl_configuration_.log_file_path);
@@ -137,6 +187,7 @@ int IscMainControlImpl::Initialize(const IscDplConfiguration* ipc_dpl_configurat
     swprintf_s(isc_camera_control_config.save_image_path, L"%s", ipc_dpl_configuration_.save_image_path);
     swprintf_s(isc_camera_control_config.load_image_path, L"%s", ipc_dpl_configuration_.load_image_path);
     isc_camera_control_config.minimum_write_interval_time = ipc_dpl_configuration_.minimum_write_interval_time;
+    isc_camera_control_config.isc_thread_configuration = isc_thread_configuration_;
 
     // log
     swprintf_s(log_file_name_, L"%s\\IscDplLib", ipc_dpl_configuration_.log_file_path);
@@ -144,6 +195,10 @@ int IscMainControlImpl::Initialize(const IscDplConfiguration* ipc_dpl_configurat
     isc_log_->Open(ipc_dpl_configuration_.log_file_path, log_file_name_, ipc_dpl_configuration_.log_level, true);
     isc_log_->LogDebug(L"IscMainControlImpl", L"---Open log---\n");
 
+    isc_thread_placement_ = new IscThreadPlacement;
+    isc_thread_placement_->Initialize(&isc_thread_configuration_);
+    isc_thread_placement_->Apply(IscThreadRole::kLog, 0, isc_log_->GetThreadHandle());
+
     wchar_t log_msg[256] = {};
 
     // camera control open
@@ -276,6 +331,8 @@ int IscMainControlImpl::Initialize(const IscDplConfiguration* ipc_dpl_configurat
 
     isc_data_proc_module_configuration.max_buffer_count = max_buffer_count;
 
+    isc_data_proc_module_configuration.isc_thread_configuration = isc_thread_configuration_;
+
     isc_data_processing_control_ = new IscDataProcessingControl;
     isc_data_processing_control_->Initialize(&isc_data_proc_module_configuration);
 
@@ -283,15 +340,78 @@ int IscMainControlImpl::Initialize(const IscDplConfiguration* ipc_dpl_configurat
     isc_measurement_ = new IscMeasurement;
     isc_measurement_->Initialize(max_width, max_height);
 
+    // point cloud
+    isc_point_cloud_ = new IscPointCloud;
+    isc_point_cloud_->Initialize(kISC_POINT_CLOUD_THREAD_COUNT, max_width, max_height);
+
+    // occupancy grid, updated when the block disparity is ready
+    isc_occupancy_grid_ = new IscOccupancyGrid;
+    isc_occupancy_grid_->Initialize(kISC_OCCUPANCY_GRID_THREAD_COUNT);
+
+    // u-disparity and v-disparity, updated when the block disparity is ready
+    isc_uv_disparity_ = new IscUvDisparity;
+    isc_uv_disparity_->Initialize(kISC_UV_DISPARITY_THREAD_COUNT);
+
+    // band threads of the engines, numbered through the engines so that distribute spreads them
+    {
+        HANDLE thread_handle[kISC_THREAD_PLACEMENT_MAX_COUNT] = {};
+        int band_thread_count = 0;
+        int thread_count = 0;
+        isc_point_cloud_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT - band_thread_count, &thread_handle[band_thread_count], &thread_count);
+        band_thread_count += thread_count;
+
+        thread_count = 0;
+        isc_occupancy_grid_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT - band_thread_count, &thread_handle[band_thread_count], &thread_count);
+        band_thread_count += thread_count;
+
+        thread_count = 0;
+        isc_uv_disparity_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT - band_thread_count, &thread_handle[band_thread_count], &thread_count);
+        band_thread_count += thread_count;
+
+        for (int i = 0; i < band_thread_count; i++) {
+            isc_thread_placement_->Apply(IscThreadRole::kBandWorker, i, thread_handle[i]);
+        }
+    }
+
+    // range index of the zones, updated when the block disparity is ready
+    isc_range_index_ = new IscRangeIndex;
+    isc_range_index_->Initialize();
+
+    // callback
+    isc_data_callback_control_ = new IscDataCallbackControl;
+    ret = isc_data_callback_control_->Initialize(max_width, max_height, isc_log_);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+    isc_thread_placement_->Apply(IscThreadRole::kCallbackDelivery, 0, isc_data_callback_control_->GetThreadHandle());
+    isc_data_processing_control_->SetResultPublishedCallback(
+        [this](const IscDataProcResultData* isc_data_proc_result_data) -> int {
+            return isc_data_callback_control_->PublishDataProcResult(isc_data_proc_result_data);
+        });
+
+    // reprocessing of the file
+    isc_reprocess_control_ = new IscReprocessControl;
+    isc_reprocess_control_->Initialize(isc_log_);
+
+    // recording of the block disparity
+    isc_record_control_ = new IscRecordControl;
+    isc_record_control_->Initialize(isc_log_);
+    isc_data_processing_control_->SetBlockDisparityPublishedCallback(
+        [this](const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data) -> int {
+            isc_occupancy_grid_->Update(isc_image_info, isc_block_disparity_data);
+            isc_uv_disparity_->Update(isc_image_info, isc_block_disparity_data);
+            isc_range_index_->Update(isc_image_info, isc_block_disparity_data);
+            isc_measurement_->UpdateBlockDisparity(isc_image_info, isc_block_disparity_data);
+            return isc_record_control_->WriteFrame(isc_image_info, isc_block_disparity_data);
+        });
+
     // Create Thread for camera
     thread_control_camera_.terminate_request = 0;
     thread_control_camera_.terminate_done = 0;
     thread_control_camera_.end_code = 0;
     thread_control_camera_.stop_request = false;
 
-    char semaphoreName[64] = {};
-    sprintf_s(semaphoreName, "THREAD_SEMAPHORENAME_ISCMAINCON_%d", 0);
-    handle_semaphore_camera_ = CreateSemaphoreA(NULL, 0, 1, semaphoreName);
+    handle_semaphore_camera_ = CreateSemaphoreA(NULL, 0, 1, NULL);
     if (handle_semaphore_camera_ == NULL) {
         // Fail
         return CAMCONTROL_E_INVALID_DEVICEHANDLE;
@@ -311,6 +431,20 @@ int IscMainControlImpl::Initialize(const IscDplConfiguration* ipc_dpl_configurat
     if (thread_handle_camera_ != NULL) {
         SetThreadPriority(thread_handle_camera_, THREAD_PRIORITY_NORMAL);
     }
+    isc_thread_placement_->Apply(IscThreadRole::kCameraReceive, 1, thread_handle_camera_);
+
+    // thread placement for diagnostics
+    IscThreadPlacementStatus* isc_thread_placement_status = new IscThreadPlacementStatus;
+    memset(isc_thread_placement_status, 0, sizeof(IscThreadPlacementStatus));
+    GetThreadPlacement(isc_thread_placement_status);
+    for (int i = 0; i < isc_thread_placement_status->placement_count; i++) {
+        const IscThreadPlacementStatus::Placement* placement = &isc_thread_placement_status->placement[i];
+        swprintf_s(log_msg, L"Thread role=%d index=%d id=%u cpu=0x%016llX priority=%d boost_disabled=%d error=%d\n",
+            (int)placement->role, placement->thread_index, placement->thread_id, placement->cpu_mask,
+            placement->priority, (int)placement->priority_boost_disabled, placement->error_code);
+        isc_log_->LogInfo(L"IscMainControlImpl", log_msg);
+    }
+    delete isc_thread_placement_status;
 
     swprintf_s(log_msg, L"Initialize ended (0x%08X)\n", ret_camera_open);
     isc_log_->LogInfo(L"IscMainControlImpl", log_msg);
@@ -362,10 +496,16 @@ int IscMainControlImpl::Terminate()
     work_buffers_.max_width = 0;
     work_buffers_.max_height = 0;
 
-    if (isc_measurement_ != nullptr) {
-        isc_measurement_->Terminate();
-        delete isc_measurement_;
-        isc_measurement_ = nullptr;
+    if (isc_reprocess_control_ != nullptr) {
+        isc_reprocess_control_->Terminate();
+        delete isc_reprocess_control_;
+        isc_reprocess_control_ = nullptr;
+    }
+
+    if (isc_point_cloud_ != nullptr) {
+        isc_point_cloud_->Terminate();
+        delete isc_point_cloud_;
+        isc_point_cloud_ = nullptr;
     }
 
     if (isc_data_processing_control_ != nullptr) {
@@ -374,6 +514,43 @@ int IscMainControlImpl::Terminate()
         isc_data_processing_control_ = nullptr;
     }
 
+    if (isc_data_callback_control_ != nullptr) {
+        isc_data_callback_control_->Terminate();
+        delete isc_data_callback_control_;
+        isc_data_callback_control_ = nullptr;
+    }
+
+    // updated from the data processing thread, terminate after it
+    if (isc_occupancy_grid_ != nullptr) {
+        isc_occupancy_grid_->Terminate();
+        delete isc_occupancy_grid_;
+        isc_occupancy_grid_ = nullptr;
+    }
+
+    if (isc_uv_disparity_ != nullptr) {
+        isc_uv_disparity_->Terminate();
+        delete isc_uv_disparity_;
+        isc_uv_disparity_ = nullptr;
+    }
+
+    if (isc_range_index_ != nullptr) {
+        isc_range_index_->Terminate();
+        delete isc_range_index_;
+        isc_range_index_ = nullptr;
+    }
+
+    if (isc_measurement_ != nullptr) {
+        isc_measurement_->Terminate();
+        delete isc_measurement_;
+        isc_measurement_ = nullptr;
+    }
+
+    if (isc_record_control_ != nullptr) {
+        isc_record_control_->Terminate();
+        delete isc_record_control_;
+        isc_record_control_ = nullptr;
+    }
+
     if (isc_image_info_ring_buffer_ != nullptr) {
         isc_image_info_ring_buffer_->Terminate();
         delete isc_image_info_ring_buffer_;
@@ -386,6 +563,12 @@ int IscMainControlImpl::Terminate()
         isc_camera_control_ = nullptr;
     }
 
+    if (isc_thread_placement_ != nullptr) {
+        isc_thread_placement_->Terminate();
+        delete isc_thread_placement_;
+        isc_thread_placement_ = nullptr;
+    }
+
     if (isc_log_ != nullptr) {
         isc_log_->LogDebug(L"IscMainControlImpl", L"---Close log---\n");
         isc_log_->Close();
@@ -478,6 +661,9 @@ int IscMainControlImpl::RecieveDataProcCamera()
                         QueryPerformanceCounter(&elp_before);
                     }
 
+                    // deliver to the callback
+                    isc_data_callback_control_->PublishCameraData(&buffer_data->isc_image_info);
+
                     // start data processing
                     int dpc_result = isc_data_processing_control_->Run(&buffer_data->isc_image_info);
 
@@ -1490,6 +1676,9 @@ int IscMainControlImpl::Start(const IscStartMode* isc_start_mode)
     temp_isc_grab_start_mode_.isc_record_mode = isc_grab_start_mode->isc_record_mode;
     temp_isc_grab_start_mode_.isc_play_mode = isc_grab_start_mode->isc_play_mode;
     temp_isc_grab_start_mode_.isc_play_mode_parameter.interval = isc_grab_start_mode->isc_play_mode_parameter.interval;
+    temp_isc_grab_start_mode_.isc_play_mode_parameter.pacing_mode = isc_grab_start_mode->isc_play_mode_parameter.pacing_mode;
+    temp_isc_grab_start_mode_.isc_play_mode_parameter.fixed_rate = isc_grab_start_mode->isc_play_mode_parameter.fixed_rate;
+    temp_isc_grab_start_mode_.isc_play_mode_parameter.follow_growing_file = isc_grab_start_mode->isc_play_mode_parameter.follow_growing_file;
     swprintf_s(temp_isc_grab_start_mode_.isc_play_mode_parameter.play_file_name, L"%s", isc_grab_start_mode->isc_play_mode_parameter.play_file_name);
 
     // setup data processing
@@ -1497,6 +1686,7 @@ int IscMainControlImpl::Start(const IscStartMode* isc_start_mode)
     temp_isc_dataproc_start_mode_.enabled_stereo_matching = isc_dataproc_start_mode->enabled_stereo_matching;
     temp_isc_dataproc_start_mode_.enabled_frame_decoder = isc_dataproc_start_mode->enabled_frame_decoder;
     temp_isc_dataproc_start_mode_.enabled_disparity_filter = isc_dataproc_start_mode->enabled_disparity_filter;
+    temp_isc_dataproc_start_mode_.enabled_valid_block_list = isc_dataproc_start_mode->enabled_valid_block_list;
 
     // clear buffer
     isc_image_info_ring_buffer_->Clear();
@@ -2212,3 +2402,1431 @@ int IscMainControlImpl::GetDataProcModuleData(IscDataProcResultData* isc_data_pr
 
     return DPC_E_OK;
 }
+
+/**
+ * カメラデータを受け取るCallbackを登録します
+ *
+ * @param[in] callback Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Callbackは配信Threadから呼び出されます。kISC_DATA_CALLBACK_HOLDを返した場合はReleaseCallbackDataで解放してください
+ */
+int IscMainControlImpl::RegisterCameraDataCallback(IscCameraDataCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (isc_data_callback_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (callback == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_callback_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_callback_control_->RegisterCameraDataCallback(callback, user_context, isc_data_callback_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * カメラデータのCallbackを解除します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::UnregisterCameraDataCallback()
+{
+    if (isc_data_callback_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_data_callback_control_->UnregisterCameraDataCallback();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果を受け取るCallbackを登録します
+ *
+ * @param[in] callback Callback関数
+ * @param[in] user_context Callbackに渡すユーザーデータ
+ * @param[in] isc_data_callback_parameter キュー設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Callbackは配信Threadから呼び出されます。kISC_DATA_CALLBACK_HOLDを返した場合はReleaseCallbackDataで解放してください
+ */
+int IscMainControlImpl::RegisterDataProcResultCallback(IscDataProcResultCallback callback, void* user_context, const IscDataCallbackParameter* isc_data_callback_parameter)
+{
+    if (isc_data_callback_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (callback == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_callback_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_callback_control_->RegisterDataProcResultCallback(callback, user_context, isc_data_callback_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果のCallbackを解除します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::UnregisterDataProcResultCallback()
+{
+    if (isc_data_callback_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_data_callback_control_->UnregisterDataProcResultCallback();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Callbackで保持したデータを解放します
+ *
+ * @param[in] release_token Callbackで渡されたtoken
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::ReleaseCallbackData(const int release_token)
+{
+    if (isc_data_callback_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_data_callback_control_->ReleaseCallbackData(release_token);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Callbackの配信状態を取得します
+ *
+ * @param[out] camera_data_status カメラデータの配信状態
+ * @param[out] data_proc_result_status データ処理結果の配信状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetCallbackStatus(IscDataCallbackStatus* camera_data_status, IscDataCallbackStatus* data_proc_result_status)
+{
+    if (isc_data_callback_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (camera_data_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (data_proc_result_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_callback_control_->GetCallbackStatus(camera_data_status, data_proc_result_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * モジュールの処理結果のうち、指定された項目のみを取得します
+ *
+ * @param[in,out] isc_data_proc_partial_result_data 取得項目・バッファー指定と処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetDataProcModuleDataPartial(IscDataProcPartialResultData* isc_data_proc_partial_result_data)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_data_proc_partial_result_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->GetDataProcModuleDataPartial(isc_data_proc_partial_result_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理の受付制御パラメータを設定します
+ *
+ * @param[in] isc_dataproc_admission_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::SetAdmissionParameter(const IscDataProcAdmissionParameter* isc_dataproc_admission_parameter)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_admission_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->SetAdmissionParameter(isc_dataproc_admission_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理の受付制御パラメータを取得します
+ *
+ * @param[out] isc_dataproc_admission_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetAdmissionParameter(IscDataProcAdmissionParameter* isc_dataproc_admission_parameter)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_admission_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->GetAdmissionParameter(isc_dataproc_admission_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理の受付制御の状態と最新の判定結果を取得します
+ *
+ * @param[out] isc_dataproc_admission_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetAdmissionStatus(IscDataProcAdmissionStatus* isc_dataproc_admission_status)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_admission_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->GetAdmissionStatus(isc_dataproc_admission_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ライブラリのThreadに適用したCPUの集合と優先度を取得します
+ *
+ * @param[out] isc_thread_placement_status 配置の一覧
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 設定はIscDplConfiguration又はThreadParameter.iniで行います
+ */
+int IscMainControlImpl::GetThreadPlacement(IscThreadPlacementStatus* isc_thread_placement_status)
+{
+    if (isc_thread_placement_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_thread_placement_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    isc_thread_placement_status->placement_count = 0;
+
+    int ret = isc_thread_placement_->GetPlacement(isc_thread_placement_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    if (isc_camera_control_ != nullptr) {
+        ret = isc_camera_control_->GetThreadPlacement(isc_thread_placement_status);
+        if (ret != DPC_E_OK) {
+            return ret;
+        }
+    }
+
+    if (isc_data_processing_control_ != nullptr) {
+        ret = isc_data_processing_control_->GetThreadPlacement(isc_thread_placement_status);
+        if (ret != DPC_E_OK) {
+            return ret;
+        }
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果の縮小プレビューのパラメータを設定します
+ *
+ * @param[in] isc_dataproc_preview_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::SetPreviewParameter(const IscDataProcPreviewParameter* isc_dataproc_preview_parameter)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_preview_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->SetPreviewParameter(isc_dataproc_preview_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果の縮小プレビューのパラメータを取得します
+ *
+ * @param[out] isc_dataproc_preview_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetPreviewParameter(IscDataProcPreviewParameter* isc_dataproc_preview_parameter)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_preview_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->GetPreviewParameter(isc_dataproc_preview_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果の最新の縮小プレビューを呼び出し側のバッファーへ取得します
+ *
+ * @param[in,out] isc_dataproc_preview_data 取得先
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetPreviewData(IscDataProcPreviewData* isc_dataproc_preview_data)
+{
+    if (isc_data_processing_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_dataproc_preview_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_data_processing_control_->GetPreviewData(isc_dataproc_preview_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 読み込みFrameを指定時刻以降の最初のFrameとします
+ *
+ * @param[in] frame_time 指定時刻 (UTC msec)
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::SetReadFrameTime(const __int64 frame_time)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_camera_control_->SetReadFrameTime(frame_time);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルのインデックスを作成します
+ *
+ * @param[in] play_file_name RAWデータファイル名
+ * @param[out] entry_count 作成したEntryの数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note インデックス無しで保存されたファイル用です
+ */
+int IscMainControlImpl::RebuildFileIndex(const wchar_t* play_file_name, __int64* entry_count)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (play_file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (entry_count == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->RebuildFileIndex(play_file_name, entry_count);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮を設定します
+ *
+ * @param[in] isc_record_compression_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の保存開始時に適用します
+ */
+int IscMainControlImpl::SetRecordCompressionParameter(const IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_compression_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->SetRecordCompressionParameter(isc_record_compression_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮の設定を取得します
+ *
+ * @param[out] isc_record_compression_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetRecordCompressionParameter(IscRecordCompressionParameter* isc_record_compression_parameter)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_compression_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->GetRecordCompressionParameter(isc_record_compression_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の圧縮の結果を取得します
+ *
+ * @param[out] isc_record_compression_statistics 圧縮の結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetRecordCompressionStatistics(IscRecordCompressionStatistics* isc_record_compression_statistics)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_compression_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->GetRecordCompressionStatistics(isc_record_compression_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の書き込みを設定します
+ *
+ * @param[in] isc_record_write_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の保存開始時に適用します
+ */
+int IscMainControlImpl::SetRecordWriteParameter(const IscRecordWriteParameter* isc_record_write_parameter)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_write_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->SetRecordWriteParameter(isc_record_write_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の書き込みの設定を取得します
+ *
+ * @param[out] isc_record_write_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetRecordWriteParameter(IscRecordWriteParameter* isc_record_write_parameter)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_write_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->GetRecordWriteParameter(isc_record_write_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータ保存の書き込みの結果を取得します
+ *
+ * @param[out] isc_record_write_statistics 書き込みの結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetRecordWriteStatistics(IscRecordWriteStatistics* isc_record_write_statistics)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_record_write_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->GetRecordWriteStatistics(isc_record_write_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再生の速度制御と処理時間の結果を取得します
+ *
+ * @param[out] isc_play_statistics 再生の結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetPlayStatistics(IscPlayStatistics* isc_play_statistics)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    memset(isc_play_statistics, 0, sizeof(IscPlayStatistics));
+
+    int ret = isc_camera_control_->GetPlayStatistics(isc_play_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    // 処理時間はデータ処理側から取得します
+    if (isc_data_processing_control_ != nullptr) {
+        ret = isc_data_processing_control_->GetPlayStatistics(isc_play_statistics);
+        if (ret != DPC_E_OK) {
+            return ret;
+        }
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再処理のためにRAWデータファイルを範囲に分割します
+ *
+ * @param[in] play_file_name ファイル名
+ * @param[in] range_count 分割数 1~kISC_REPROCESS_MAX_RANGE_COUNT
+ * @param[out] isc_reprocess_range_list 分割結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::MakeReprocessRanges(const wchar_t* play_file_name, const int range_count, IscReprocessRangeList* isc_reprocess_range_list)
+{
+    if (isc_camera_control_ == nullptr || isc_reprocess_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (play_file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_reprocess_range_list == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_reprocess_control_->MakeRanges(isc_camera_control_, play_file_name, range_count, isc_reprocess_range_list);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルの範囲を処理し、結果ファイルに書き込みます
+ *
+ * @param[in] isc_reprocess_parameter パラメータ
+ * @param[out] isc_reprocess_status 処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 取り込みを停止した状態で呼び出します。範囲の処理が終わるまで戻りません
+ */
+int IscMainControlImpl::ReprocessRange(const IscReprocessParameter* isc_reprocess_parameter, IscReprocessStatus* isc_reprocess_status)
+{
+    if (isc_camera_control_ == nullptr || isc_data_processing_control_ == nullptr || isc_reprocess_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_reprocess_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_reprocess_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_reprocess_control_->ProcessRange(isc_camera_control_, isc_data_processing_control_, isc_reprocess_parameter, isc_reprocess_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 範囲の結果ファイルを順に結合します
+ *
+ * @param[in] isc_reprocess_merge_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::MergeReprocessResults(const IscReprocessMergeParameter* isc_reprocess_merge_parameter)
+{
+    if (isc_reprocess_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_reprocess_merge_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_reprocess_control_->MergeResults(isc_reprocess_merge_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * データ処理結果のブロック視差の記録を開始します
+ *
+ * @param[in] isc_result_record_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理の結果が格納される毎に書き込みます
+ */
+int IscMainControlImpl::StartResultRecord(const IscResultRecordParameter* isc_result_record_parameter)
+{
+    if (isc_record_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_result_record_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_record_control_->StartRecord(isc_result_record_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録を停止し、Indexを書き込みます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::StopResultRecord()
+{
+    if (isc_record_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_record_control_->StopRecord();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録の状態を取得します
+ *
+ * @param[out] isc_result_record_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetResultRecordStatus(IscResultRecordStatus* isc_result_record_status)
+{
+    if (isc_record_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_result_record_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_record_control_->GetRecordStatus(isc_result_record_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録ファイルを開きます
+ *
+ * @param[in] file_name ファイル名
+ * @param[out] isc_result_record_information ファイルの情報
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::OpenResultRecord(const wchar_t* file_name, IscResultRecordInformation* isc_result_record_information)
+{
+    if (isc_record_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_result_record_information == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_record_control_->OpenFile(file_name, isc_result_record_information);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録ファイルから1Frameを読み込みます
+ *
+ * @param[in] frame_number Frame番号 0~frame_count-1
+ * @param[in,out] isc_result_record_frame 読み込み先とFrameの情報
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::ReadResultRecord(const __int64 frame_number, IscResultRecordFrame* isc_result_record_frame)
+{
+    if (isc_record_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_result_record_frame == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_record_control_->ReadFrame(frame_number, isc_result_record_frame);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック視差の記録ファイルを閉じます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::CloseResultRecord()
+{
+    if (isc_record_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    int ret = isc_record_control_->CloseFile();
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再生時に展開済みFrameを保持、先読みする方法を設定します
+ *
+ * @param[in] isc_play_cache_parameter 設定
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次の再生の開始から適用します
+ */
+int IscMainControlImpl::SetPlayCacheParameter(const IscPlayCacheParameter* isc_play_cache_parameter)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_cache_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->SetPlayCacheParameter(isc_play_cache_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 再生時に展開済みFrameを保持、先読みする方法を取得します
+ *
+ * @param[out] isc_play_cache_parameter 設定
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetPlayCacheParameter(IscPlayCacheParameter* isc_play_cache_parameter)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_cache_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->GetPlayCacheParameter(isc_play_cache_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 展開済みFrameの保持の状態を取得します
+ *
+ * @param[out] isc_play_cache_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetPlayCacheStatus(IscPlayCacheStatus* isc_play_cache_status)
+{
+    if (isc_camera_control_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_play_cache_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_camera_control_->GetPlayCacheStatus(isc_play_cache_status);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 複数の領域の情報を一括して取得します
+ *
+ * @param[in] roi_count 領域の数
+ * @param[in] min_distance 有効な最小の距離(m)
+ * @param[in] max_distance 有効な最大の距離(m)
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_data_statistics 領域の情報 x,y,width,heightで領域を指定します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 視差画像全体の集計表を1回作成し、各領域の情報は表から求めます
+ */
+int IscMainControlImpl::GetAreaStatisticsBatch(const int roi_count, const float min_distance, const float max_distance, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics)
+{
+    if (isc_measurement_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_measurement_->GetAreaStatisticsBatch(roi_count, min_distance, max_distance, isc_image_info, isc_data_statistics);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 視差を点群に変換します
+ *
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_point_cloud_data 点群 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note バッファーは間引き後の格子の全点を保持できる大きさが必要です
+ */
+int IscMainControlImpl::GetPointCloud(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data)
+{
+    if (isc_point_cloud_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_point_cloud_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_point_cloud_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_point_cloud_->Convert(isc_point_cloud_parameter, isc_image_info, isc_point_cloud_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 視差を点群に変換し、ファイルに書き込みます
+ *
+ * @param[in] file_name ファイル名
+ * @param[in] file_format ファイルの形式
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_image_info データ構造体
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note PLYには有効な点のみを書き込みます
+ */
+int IscMainControlImpl::SavePointCloud(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info)
+{
+    if (isc_point_cloud_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (file_name == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_point_cloud_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_point_cloud_->SaveFile(file_name, file_format, isc_point_cloud_parameter, isc_image_info);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 複数の位置の視差、距離と3D位置を一括して取得します
+ *
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_position_batch 位置と結果 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note window_sizeが0の場合は、GetPosition3D()と同じ結果となります
+ */
+int IscMainControlImpl::GetPosition3DBatch(const IscImageInfo* isc_image_info, IscPositionBatch* isc_position_batch)
+{
+    if (isc_measurement_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_position_batch == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_measurement_->GetPosition3DBatch(isc_image_info, isc_position_batch);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Occupancy gridのパラメータを設定します
+ *
+ * @param[in] isc_occupancy_grid_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Gridとvoxelは消去されます
+ */
+int IscMainControlImpl::SetOccupancyGridParameter(const IscOccupancyGridParameter* isc_occupancy_grid_parameter)
+{
+    if (isc_occupancy_grid_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_occupancy_grid_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_occupancy_grid_->SetParameter(isc_occupancy_grid_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Occupancy gridのパラメータを取得します
+ *
+ * @param[out] isc_occupancy_grid_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetOccupancyGridParameter(IscOccupancyGridParameter* isc_occupancy_grid_parameter)
+{
+    if (isc_occupancy_grid_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_occupancy_grid_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_occupancy_grid_->GetParameter(isc_occupancy_grid_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のOccupancy gridを取得します
+ *
+ * @param[in,out] isc_occupancy_grid_data Grid バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetOccupancyGrid(IscOccupancyGridData* isc_occupancy_grid_data)
+{
+    if (isc_occupancy_grid_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_occupancy_grid_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_occupancy_grid_->GetGrid(isc_occupancy_grid_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のVoxelを取得します
+ *
+ * @param[in,out] isc_voxel_map_data Voxel バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note max_voxel_countを超えるVoxelは取得しません
+ */
+int IscMainControlImpl::GetVoxelMap(IscVoxelMapData* isc_voxel_map_data)
+{
+    if (isc_occupancy_grid_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_voxel_map_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_occupancy_grid_->GetVoxelMap(isc_voxel_map_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * u-disparity, v-disparityのパラメータを設定します
+ *
+ * @param[in] isc_uv_disparity_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 集計結果は消去されます
+ */
+int IscMainControlImpl::SetUvDisparityParameter(const IscUvDisparityParameter* isc_uv_disparity_parameter)
+{
+    if (isc_uv_disparity_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_uv_disparity_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_uv_disparity_->SetParameter(isc_uv_disparity_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * u-disparity, v-disparityのパラメータを取得します
+ *
+ * @param[out] isc_uv_disparity_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetUvDisparityParameter(IscUvDisparityParameter* isc_uv_disparity_parameter)
+{
+    if (isc_uv_disparity_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_uv_disparity_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_uv_disparity_->GetParameter(isc_uv_disparity_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のu-disparity, v-disparityと地面の直線を取得します
+ *
+ * @param[in,out] isc_uv_disparity_data 集計結果 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetUvDisparity(IscUvDisparityData* isc_uv_disparity_data)
+{
+    if (isc_uv_disparity_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_uv_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_uv_disparity_->GetData(isc_uv_disparity_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Range indexのパラメータを設定し、毎フレーム評価する領域を登録します
+ *
+ * @param[in] isc_range_index_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 作成済みの表は消去されます
+ */
+int IscMainControlImpl::SetRangeIndexParameter(const IscRangeIndexParameter* isc_range_index_parameter)
+{
+    if (isc_range_index_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_index_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_range_index_->SetParameter(isc_range_index_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Range indexのパラメータを取得します
+ *
+ * @param[out] isc_range_index_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetRangeIndexParameter(IscRangeIndexParameter* isc_range_index_parameter)
+{
+    if (isc_range_index_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_index_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_range_index_->GetParameter(isc_range_index_parameter);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの登録した領域の結果を取得します
+ *
+ * @param[out] isc_range_zone_data 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetRangeZoneData(IscRangeZoneData* isc_range_zone_data)
+{
+    if (isc_range_index_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_zone_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_range_index_->GetZoneData(isc_range_zone_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの任意の領域の最小/最大の距離と範囲内のBlockの数を取得します
+ *
+ * @param[in] isc_range_zone 領域
+ * @param[out] isc_range_zone_result 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::QueryRange(const IscRangeZone* isc_range_zone, IscRangeZoneResult* isc_range_zone_result)
+{
+    if (isc_range_index_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_range_zone == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_range_zone_result == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_range_index_->QueryRange(isc_range_zone, isc_range_zone_result);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの固定小数点のBlock毎の視差を取得します
+ *
+ * @param[in,out] isc_block_disparity_fixed_data Block毎の視差 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note block_valueがnullptrの場合は、大きさのみを取得します
+ */
+int IscMainControlImpl::GetBlockDisparityFixed(IscBlockDisparityFixedData* isc_block_disparity_fixed_data)
+{
+    if (isc_measurement_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_block_disparity_fixed_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_measurement_->GetBlockDisparityFixed(isc_block_disparity_fixed_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの固定小数点のBlock毎の視差から、指定位置の距離を取得します
+ *
+ * @param[in] x 画像内座標(X)
+ * @param[in] y 画像内座標(Y)
+ * @param[out] disparity 視差
+ * @param[out] depth 距離(m)
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMainControlImpl::GetBlockPositionDepth(const int x, const int y, float* disparity, float* depth)
+{
+    if (isc_measurement_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (disparity == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (depth == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_measurement_->GetBlockPositionDepth(x, y, disparity, depth);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの視差のあるBlockのリストを取得します
+ *
+ * @param[in,out] isc_valid_block_list_data Blockのリスト バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note valid_blockがnullptrの場合は、数のみを取得します
+ */
+int IscMainControlImpl::GetValidBlockList(IscValidBlockListData* isc_valid_block_list_data)
+{
+    if (isc_measurement_ == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_valid_block_list_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int ret = isc_measurement_->GetValidBlockList(isc_valid_block_list_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
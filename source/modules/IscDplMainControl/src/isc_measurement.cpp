@@ -1,4 +1,4 @@
-// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -28,6 +28,7 @@
 #include <time.h>
 #include <tchar.h>
 #include <stdint.h>
+#include <float.h>
 #include <process.h>
 #include <mutex>
 #include <functional>
@@ -41,27 +42,68 @@
 
 #include "opencv2\opencv.hpp"
 
-struct HistogramData {
-    int resolution;             // 分解能　視差ｘresolution　として計算します
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define ISC_MEASUREMENT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+constexpr int kISC_AREA_DISPARITY_RESOLUTION = 100;                                     /**< 視差のHistogramの分解能 (1/100 pixel) */
+constexpr int kISC_AREA_DISPARITY_BIN_COUNT = 256 * kISC_AREA_DISPARITY_RESOLUTION;     /**< disparity 0.0 ~ 255.99 */
+constexpr int kISC_AREA_DISTANCE_BIN_COUNT = 1000 + 900 + 900 + 1;                      /**< 0.01m(~10m) 0.1m(~100m) 1m(~1000m) 1000m~ */
+constexpr int kISC_AREA_DISTANCE_MODE_BIN_COUNT = 1000;                                 /**< 最頻値を求める段階の数 */
 
-    int histo_buffer_size;      // バッファーサイズ
-    float* histo_buffer;        // 作業バッファー
+constexpr int kISC_AREA_TABLE_TILE_SIZE = 16;                                           /**< 一括集計のHistogramのTileの大きさ */
+constexpr int kISC_AREA_TABLE_BIN_COUNT = 128;                                          /**< 一括集計のHistogramの段階の数 */
+constexpr float kISC_AREA_TABLE_DISPARITY_BIN_WIDTH = 256.0F / kISC_AREA_TABLE_BIN_COUNT;   /**< 一括集計の視差のHistogramの幅 */
+constexpr unsigned char kISC_AREA_TABLE_INVALID_BIN = 0xFF;                             /**< 無効な画素 */
+constexpr int kISC_AREA_TABLE_LUT_RESOLUTION = 64;                                      /**< 距離のHistogramの位置の表の分解能 (1/64 pixel) */
+constexpr int kISC_AREA_TABLE_LUT_SIZE = 256 * kISC_AREA_TABLE_LUT_RESOLUTION;
 
-    // for debug dispalay
-    int buffer_size;
-    float* buffer;
+/**
+ * @struct AreaMoments
+ * @brief 平均と分散の逐次計算 (Welford)
+ */
+struct AreaMoments {
+    double count;
+    double mean;
+    double m2;          // 平均との差の二乗和
+    float min_value;
+    float max_value;
+};
 
+/**
+ * @struct AreaAccumulator
+ * @brief 領域の情報の1回の走査による集計
+ */
+struct AreaAccumulator {
+    // 判定の条件
+    float d_inf;
+    float bf;
+    float min_distance;
+    float max_distance;
+
+    AreaMoments disparity;
+    AreaMoments distance;
+
+    int* disparity_bins;
+    int disparity_bin_min, disparity_bin_max;
+
+    int* distance_bins;
+    int distance_bin_min, distance_bin_max;
+
+#ifdef ISC_MEASUREMENT_USE_SSE2
+    // 4並列のWelford 最後にdisparity/distanceへ統合します
+    __m128 lane_disparity_count, lane_disparity_mean, lane_disparity_m2, lane_disparity_min, lane_disparity_max;
+    __m128 lane_distance_count, lane_distance_mean, lane_distance_m2, lane_distance_min, lane_distance_max;
+#endif
 };
-HistogramData disparity_histogram_, distance_histogram_;
 
-int GetMaxDisparityValueInHistogram(cv::Mat src_data, const float min_valid_value, float* max_frequency_value, HistogramData* histogram_data);
-int GetMaxDistanceValueInHistogram(cv::Mat src_data, const float min_valid_value, float* max_frequency_value, HistogramData* histogram_data);
 
 /**
  * constructor
  *
  */
-IscMeasurement::IscMeasurement():work_buffers_()
+IscMeasurement::IscMeasurement():work_buffers_(), area_histogram_(), area_tables_(), block_disparity_()
 {
 
 }
@@ -97,21 +139,24 @@ int IscMeasurement::Initialize(const int max_width, const int max_height)
         memset(work_buffers_.depth_buffer[i], 0, work_buffer_frame_size * sizeof(float));
     }
 
-    disparity_histogram_.resolution = 100;  // 視差の計算分解能
-    disparity_histogram_.histo_buffer_size = 256 * disparity_histogram_.resolution; // disparity 0.0 ~ 255.0
-    disparity_histogram_.histo_buffer = new float[disparity_histogram_.histo_buffer_size];
+    // 領域の情報のHistogram 使用した範囲のみ都度消去します
+    area_histogram_.disparity_bins = new int[kISC_AREA_DISPARITY_BIN_COUNT];
+    memset(area_histogram_.disparity_bins, 0, sizeof(int) * kISC_AREA_DISPARITY_BIN_COUNT);
 
-    disparity_histogram_.buffer_size = 256; // disparity 0.0 ~ 255.0
-    disparity_histogram_.buffer = new float[disparity_histogram_.buffer_size];
+    area_histogram_.distance_bins = new int[kISC_AREA_DISTANCE_BIN_COUNT];
+    memset(area_histogram_.distance_bins, 0, sizeof(int) * kISC_AREA_DISTANCE_BIN_COUNT);
 
+    area_histogram_.distance_mode_bins = new int[kISC_AREA_DISTANCE_MODE_BIN_COUNT];
+    memset(area_histogram_.distance_mode_bins, 0, sizeof(int) * kISC_AREA_DISTANCE_MODE_BIN_COUNT);
 
-    distance_histogram_.resolution = 1000;                                  // 距離の計算分解能
-    distance_histogram_.histo_buffer_size = distance_histogram_.resolution; // 1000段階
-    distance_histogram_.histo_buffer = new float[distance_histogram_.histo_buffer_size];
+    // 最新のFrameの固定小数点のBlock毎の視差
+    InitializeCriticalSection(&block_disparity_.critical);
+    memset(&block_disparity_.data, 0, sizeof(block_disparity_.data));
+    block_disparity_.capacity = 0;
+    block_disparity_.valid_block = nullptr;
+    block_disparity_.valid_block_count = -1;
+    block_disparity_.valid_block_capacity = 0;
 
-    distance_histogram_.buffer_size = 1000;
-    distance_histogram_.buffer = new float[distance_histogram_.buffer_size];
- 
     return DPC_E_OK;
 }
 
@@ -123,17 +168,25 @@ int IscMeasurement::Initialize(const int max_width, const int max_height)
  */
 int IscMeasurement::Terminate()
 {
-    delete[] distance_histogram_.buffer;
-    distance_histogram_.buffer = nullptr;
+    ReleaseAreaTables();
 
-    delete[] distance_histogram_.histo_buffer;
-    distance_histogram_.histo_buffer = nullptr;
+    delete[] block_disparity_.data.block_value;
+    block_disparity_.data.block_value = nullptr;
+    block_disparity_.capacity = 0;
+    delete[] block_disparity_.valid_block;
+    block_disparity_.valid_block = nullptr;
+    block_disparity_.valid_block_count = -1;
+    block_disparity_.valid_block_capacity = 0;
+    DeleteCriticalSection(&block_disparity_.critical);
 
-    delete[] disparity_histogram_.buffer;
-    disparity_histogram_.buffer = nullptr;
+    delete[] area_histogram_.distance_mode_bins;
+    area_histogram_.distance_mode_bins = nullptr;
 
-    delete[] disparity_histogram_.histo_buffer;
-    disparity_histogram_.histo_buffer = nullptr;
+    delete[] area_histogram_.distance_bins;
+    area_histogram_.distance_bins = nullptr;
+
+    delete[] area_histogram_.disparity_bins;
+    area_histogram_.disparity_bins = nullptr;
 
     for (int i = 0; i < 1; i++) {
         delete[] work_buffers_.image_buffer[i];
@@ -145,6 +198,93 @@ int IscMeasurement::Terminate()
     return DPC_E_OK;
 }
 
+/**
+ * 指定位置を含む4x4 Blockの視差を取得します
+ *
+ * @param[in] image 視差
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[in] x 画像内座標(X)
+ * @param[in] y 画像内座標(Y)
+ * @retval Block内の最初の有効な視差 無い場合は0
+ */
+static float GetBlockDisparity(const float* image, const int width, const int height, const int x, const int y)
+{
+    int x_s = (int)((int)((double)x / 4.0) * 4);
+    int x_e = x_s + 4;
+    if (x_e >= width) {
+        x_e = width - 1;
+    }
+
+    int y_s = (int)((int)((double)y / 4.0) * 4);
+    int y_e = y_s + 4;
+    if (y_e >= height) {
+        y_e = height - 1;
+    }
+
+    for (int i = y_s; i < y_e; i++) {
+        const float* src = image + (i * width);
+
+        for (int j = x_s; j < x_e; j++) {
+            if (*(src + j) > 0) {
+                // 有効な視差
+                return *(src + j);
+            }
+        }
+    }
+
+    return 0.0F;
+}
+
+/**
+ * 指定位置を中心とする窓の有効な視差の中央値を取得します
+ *
+ * @param[in] image 視差
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[in] x 画像内座標(X)
+ * @param[in] y 画像内座標(Y)
+ * @param[in] window_size 窓の大きさ(奇数)
+ * @param[in] d_inf 無限遠の視差
+ * @retval 中央値 有効な視差が無い場合は0
+ */
+static float GetWindowMedianDisparity(const float* image, const int width, const int height, const int x, const int y, const int window_size, const float d_inf)
+{
+    float values[kISC_POSITION_MAX_WINDOW_SIZE * kISC_POSITION_MAX_WINDOW_SIZE];
+
+    const int half_size = window_size / 2;
+    const int x_s = std::max(x - half_size, 0);
+    const int x_e = std::min(x + half_size + 1, width);
+    const int y_s = std::max(y - half_size, 0);
+    const int y_e = std::min(y + half_size + 1, height);
+
+    int count = 0;
+    for (int i = y_s; i < y_e; i++) {
+        const float* src = image + (i * width);
+
+        for (int j = x_s; j < x_e; j++) {
+            if (src[j] > d_inf) {
+                values[count] = src[j];
+                count++;
+            }
+        }
+    }
+
+    if (count == 0) {
+        return 0.0F;
+    }
+
+    std::nth_element(values, values + (count / 2), values + count);
+    float median = values[count / 2];
+
+    if ((count % 2) == 0) {
+        const float lower = *std::max_element(values, values + (count / 2));
+        median = (median + lower) / 2.0F;
+    }
+
+    return median;
+}
+
 /**
  * 指定位置の視差と距離を取得します
  *
@@ -208,53 +348,256 @@ int IscMeasurement::GetPositionDepth(const int x, const int y, const IscImageInf
         ユーザーが画面上で選択した座標は厳密ではいため、Block内に視差がれば、そこが選択れたものとして値を計算する
     */
 
-    int x_s = (int)((int)((double)x / 4.0) * 4);
-    int x_e = x_s + 4;
-    if (x_e >= width) {
-        x_e = width - 1;
+    float block_disparity = GetBlockDisparity(isc_image_info->frame_data[fd_index].depth.image, width, height, x, y);
+
+    if (block_disparity > isc_image_info->camera_specific_parameter.d_inf) {
+        *disparity = block_disparity;
+        *depth = isc_image_info->camera_specific_parameter.bf / (block_disparity - isc_image_info->camera_specific_parameter.d_inf);
+    }
+    else {
+        *disparity = 0;
+        *depth = 0;
     }
 
-    int y_s = (int)((int)((double)y / 4.0) * 4);
-    int y_e = y_s + 4;
-    if (y_e >= height) {
-        y_e = height - 1;
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のFrameの固定小数点のBlock毎の視差を保持します
+ *
+ * @param[in] isc_image_info データ構造体
+ * @param[in] isc_block_disparity_data Block毎の視差
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理Threadから呼び出されます。Block毎の視差が無いFrameでは、保持している視差を無効にします
+ */
+int IscMeasurement::UpdateBlockDisparity(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data)
+{
+    if (isc_image_info == nullptr || isc_block_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
     }
 
-    float depth_array[16] = {};
-    int index = 0;
-    for (int i = y_s; i < y_e; i++) {
-        float* src = isc_image_info->frame_data[fd_index].depth.image + (i * width);
+    const IscBlockDisparityData* block_data = isc_block_disparity_data;
+    IscBlockDisparityFixedData* data = &block_disparity_.data;
 
-        for (int j = x_s; j < x_e; j++) {
-            depth_array[index] = *(src + j);
-            index++;
-        }
+    EnterCriticalSection(&block_disparity_.critical);
+
+    if (block_data->image_width <= 0 || block_data->image_height <= 0 ||
+        block_data->blkwdt <= 0 || block_data->blkhgt <= 0 || block_data->pblkfix == nullptr) {
+        data->block_count_x = 0;
+        data->block_count_y = 0;
+        block_disparity_.valid_block_count = -1;
+        LeaveCriticalSection(&block_disparity_.critical);
+        return DPC_E_OK;
     }
-    
-    if (index == 0) {
-        *disparity = 0;
-        *depth = 0;
+
+    const int block_count_x = block_data->image_width / block_data->blkwdt;
+    const int block_count_y = block_data->image_height / block_data->blkhgt;
+    const int block_count = block_count_x * block_count_y;
+
+    if (block_count > block_disparity_.capacity) {
+        delete[] data->block_value;
+        data->block_value = new unsigned short[block_count];
+        block_disparity_.capacity = block_count;
+    }
+    memcpy(data->block_value, block_data->pblkfix, sizeof(unsigned short) * block_count);
+
+    // 視差のあるBlockのリストは、作成されている場合のみ保持します
+    if (block_data->pvalidblk != nullptr && block_data->validblkcnt >= 0) {
+        if (block_data->validblkcnt > block_disparity_.valid_block_capacity) {
+            delete[] block_disparity_.valid_block;
+            block_disparity_.valid_block = new IscValidBlock[block_count];
+            block_disparity_.valid_block_capacity = block_count;
+        }
+        memcpy(block_disparity_.valid_block, block_data->pvalidblk, sizeof(IscValidBlock) * block_data->validblkcnt);
+        block_disparity_.valid_block_count = block_data->validblkcnt;
     }
     else {
-        float block_disparity = 0.0f;
-        for (auto value : depth_array) {
-            if (value > 0) {
-                // 有効な視差
-                block_disparity = value;
-                break;
-            }
+        block_disparity_.valid_block_count = -1;
+    }
+
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+    if (isc_image_info->shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
+
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
         }
+    }
+
+    data->max_block_count = block_disparity_.capacity;
+    data->image_width = block_data->image_width;
+    data->image_height = block_data->image_height;
+    data->block_width = block_data->blkwdt;
+    data->block_height = block_data->blkhgt;
+    data->block_count_x = block_count_x;
+    data->block_count_y = block_count_y;
+    data->fixed_point_scale = kISC_DISPARITY_FIXED_POINT_SCALE;
+    data->d_inf = isc_image_info->camera_specific_parameter.d_inf;
+    data->bf = isc_image_info->camera_specific_parameter.bf;
+    data->frame_time = isc_image_info->frame_data[fd_index].frame_time;
+    data->frame_index = isc_image_info->frame_data[fd_index].frameNo;
+
+    LeaveCriticalSection(&block_disparity_.critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のFrameの固定小数点のBlock毎の視差を取得します
+ *
+ * @param[in,out] isc_block_disparity_fixed_data Block毎の視差 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscMeasurement::GetBlockDisparityFixed(IscBlockDisparityFixedData* isc_block_disparity_fixed_data)
+{
+    if (isc_block_disparity_fixed_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscBlockDisparityFixedData* data = &block_disparity_.data;
+
+    EnterCriticalSection(&block_disparity_.critical);
+
+    if (data->block_count_x == 0) {
+        LeaveCriticalSection(&block_disparity_.critical);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
 
-        if (block_disparity > isc_image_info->camera_specific_parameter.d_inf) {
-            *disparity = block_disparity;
-            *depth = isc_image_info->camera_specific_parameter.bf / (block_disparity - isc_image_info->camera_specific_parameter.d_inf);
+    const int block_count = data->block_count_x * data->block_count_y;
+    if (isc_block_disparity_fixed_data->block_value != nullptr) {
+        if (isc_block_disparity_fixed_data->max_block_count < block_count) {
+            LeaveCriticalSection(&block_disparity_.critical);
+            return ISCDPL_E_INVALID_PARAMETER;
         }
-        else {
-            *disparity = 0;
-            *depth = 0;
+        memcpy(isc_block_disparity_fixed_data->block_value, data->block_value, sizeof(unsigned short) * block_count);
+    }
+
+    isc_block_disparity_fixed_data->image_width = data->image_width;
+    isc_block_disparity_fixed_data->image_height = data->image_height;
+    isc_block_disparity_fixed_data->block_width = data->block_width;
+    isc_block_disparity_fixed_data->block_height = data->block_height;
+    isc_block_disparity_fixed_data->block_count_x = data->block_count_x;
+    isc_block_disparity_fixed_data->block_count_y = data->block_count_y;
+    isc_block_disparity_fixed_data->fixed_point_scale = data->fixed_point_scale;
+    isc_block_disparity_fixed_data->d_inf = data->d_inf;
+    isc_block_disparity_fixed_data->bf = data->bf;
+    isc_block_disparity_fixed_data->frame_time = data->frame_time;
+    isc_block_disparity_fixed_data->frame_index = data->frame_index;
+
+    LeaveCriticalSection(&block_disparity_.critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のFrameの視差のあるBlockのリストを取得します
+ *
+ * @param[in,out] isc_valid_block_list_data Blockのリスト バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note リストはIscDataProcStartMode::enabled_valid_block_listの場合に作成されます
+ */
+int IscMeasurement::GetValidBlockList(IscValidBlockListData* isc_valid_block_list_data)
+{
+    if (isc_valid_block_list_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscBlockDisparityFixedData* data = &block_disparity_.data;
+
+    EnterCriticalSection(&block_disparity_.critical);
+
+    if (data->block_count_x == 0 || block_disparity_.valid_block_count < 0) {
+        LeaveCriticalSection(&block_disparity_.critical);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    const int valid_block_count = block_disparity_.valid_block_count;
+    if (isc_valid_block_list_data->valid_block != nullptr) {
+        if (isc_valid_block_list_data->max_valid_block_count < valid_block_count) {
+            LeaveCriticalSection(&block_disparity_.critical);
+            return ISCDPL_E_INVALID_PARAMETER;
         }
+        memcpy(isc_valid_block_list_data->valid_block, block_disparity_.valid_block, sizeof(IscValidBlock) * valid_block_count);
+    }
+
+    isc_valid_block_list_data->valid_block_count = valid_block_count;
+    isc_valid_block_list_data->image_width = data->image_width;
+    isc_valid_block_list_data->image_height = data->image_height;
+    isc_valid_block_list_data->block_width = data->block_width;
+    isc_valid_block_list_data->block_height = data->block_height;
+    isc_valid_block_list_data->block_count_x = data->block_count_x;
+    isc_valid_block_list_data->block_count_y = data->block_count_y;
+    isc_valid_block_list_data->fixed_point_scale = data->fixed_point_scale;
+    isc_valid_block_list_data->d_inf = data->d_inf;
+    isc_valid_block_list_data->bf = data->bf;
+    isc_valid_block_list_data->frame_time = data->frame_time;
+    isc_valid_block_list_data->frame_index = data->frame_index;
+
+    LeaveCriticalSection(&block_disparity_.critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のFrameの固定小数点のBlock毎の視差から、指定位置の距離を取得します
+ *
+ * @param[in] x 画像内座標(X)
+ * @param[in] y 画像内座標(Y)
+ * @param[out] disparity 視差
+ * @param[out] depth 距離(m)
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 指定位置を含むBlockの視差を使用します
+ */
+int IscMeasurement::GetBlockPositionDepth(const int x, const int y, float* disparity, float* depth)
+{
+    if (disparity == nullptr || depth == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscBlockDisparityFixedData* data = &block_disparity_.data;
+
+    EnterCriticalSection(&block_disparity_.critical);
+
+    if (data->block_count_x == 0) {
+        LeaveCriticalSection(&block_disparity_.critical);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    if ((x < 0) || (x >= data->image_width) || (y < 0) || (y >= data->image_height)) {
+        LeaveCriticalSection(&block_disparity_.critical);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    // 画像の右端、下端のBlockに満たない部分は、最後のBlockとします
+    int block_x = x / data->block_width;
+    int block_y = y / data->block_height;
+    if (block_x >= data->block_count_x) {
+        block_x = data->block_count_x - 1;
+    }
+    if (block_y >= data->block_count_y) {
+        block_y = data->block_count_y - 1;
     }
 
+    const unsigned short value = data->block_value[block_y * data->block_count_x + block_x];
+    const float block_disparity = (float)value / (float)data->fixed_point_scale;
+
+    if ((value != 0) && (block_disparity > data->d_inf)) {
+        *disparity = block_disparity;
+        *depth = data->bf / (block_disparity - data->d_inf);
+    }
+    else {
+        *disparity = 0;
+        *depth = 0;
+    }
+
+    LeaveCriticalSection(&block_disparity_.critical);
+
     return DPC_E_OK;
 }
 
@@ -330,76 +673,41 @@ int IscMeasurement::GetPosition3D(const int x, const int y, const IscImageInfo*
 }
 
 /**
- * 中央値を取得します
- *
- * @param[in] input_org 入力配列
- * @retval 中央値
- * @note 失敗時には、0を戻します
- */
-float MedianMat(cv::Mat& input_org) {
-
-    std::vector<float> vec_from_mat;
-
-    for (int i = 0; i < input_org.rows; i++) {
-        float* src = input_org.ptr<float>(i);
-
-        for (int j = 0; j < input_org.cols; j++) {
-            if (*src > 1) {
-                vec_from_mat.push_back(*src);
-            }
-            src++;
-        }
-    }
-
-    if (vec_from_mat.size() == 0) {
-        return 0.0F;
-    }
-
-    //Input = Input.reshape(0, 1); // spread Input Mat to single row
-    //Input.copyTo(vec_from_mat); // Copy Input Mat to vector vec_from_mat    
-
-    // sort vec_from_mat
-    std::sort(vec_from_mat.begin(), vec_from_mat.end());
-
-    // in case of even-numbered matrix
-    if (vec_from_mat.size() % 2 == 0) { 
-        return (vec_from_mat[vec_from_mat.size() / 2 - 1] + vec_from_mat[vec_from_mat.size() / 2]) / 2; 
-    } 
-    
-    // odd-number of elements in matrix
-    return vec_from_mat[(vec_from_mat.size() - 1) / 2]; 
-}
-
-/**
- * 指定領域の情報を取得します
+ * 複数の位置の視差、距離と3D位置を一括して取得します
  *
- * @param[in] x 画像内座標左上(X)
- * @param[in] y 画像内座標左上(Y)
- * @param[in] width 幅
- * @param[in] height 高さ
  * @param[in] isc_image_info データ構造体
- * @param[out] isc_data_statistics 領域の情報
+ * @param[in,out] isc_position_batch 位置と結果 バッファーは呼び出し元が確保します
  * @retval 0 成功
  * @retval other 失敗
+ * @note 
+ *  - window_sizeが0の場合は、GetPosition3D()と同じ結果となります
+ *  - maskを指定した場合は、0以外の画素をx,yへ書き込みます(max_point_countまで)
+ *  - 画像外、視差の無い位置はis_validを0とし、結果を0とします
  */
-int IscMeasurement::GetAreaStatistics(const int x, const int y, const int width, const int height, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics)
+int IscMeasurement::GetPosition3DBatch(const IscImageInfo* isc_image_info, IscPositionBatch* isc_position_batch)
 {
-    
-    if (isc_image_info == nullptr) {
+    if (isc_image_info == nullptr || isc_position_batch == nullptr) {
         return ISCDPL_E_INVALID_PARAMETER;
     }
 
-    if (isc_data_statistics == nullptr) {
+    IscPositionBatch* batch = isc_position_batch;
+
+    if (batch->x == nullptr || batch->y == nullptr) {
         return ISCDPL_E_INVALID_PARAMETER;
     }
 
-    double min_distance = isc_data_statistics->min_distance;
-    double max_distance = isc_data_statistics->max_distance;
+    const int window_size = batch->window_size;
+    if ((window_size < 0) || (window_size > kISC_POSITION_MAX_WINDOW_SIZE) || ((window_size != 0) && ((window_size % 2) == 0))) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
 
-    memset(isc_data_statistics, 0, sizeof(IscAreaDataStatistics));
+    if (batch->max_point_count < 0) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
 
-    isc_data_statistics->min_distance = min_distance;
-    isc_data_statistics->max_distance = max_distance;
+    if ((batch->mask == nullptr) && ((batch->point_count < 0) || (batch->point_count > batch->max_point_count))) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
 
     int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
 
@@ -415,111 +723,689 @@ int IscMeasurement::GetAreaStatistics(const int x, const int y, const int width,
         }
     }
 
-    int image_width = isc_image_info->frame_data[fd_index].depth.width;
-    int image_height = isc_image_info->frame_data[fd_index].depth.height;
+    const int width = isc_image_info->frame_data[fd_index].depth.width;
+    const int height = isc_image_info->frame_data[fd_index].depth.height;
+    const float* image = isc_image_info->frame_data[fd_index].depth.image;
 
-    if ((x <= 0) || (x >= image_width)) {
+    if ((width <= 0) || (height <= 0) || (image == nullptr)) {
         return ISCDPL_E_INVALID_PARAMETER;
     }
 
-    if ((y <= 0) || (y >= image_height)) {
-        return ISCDPL_E_INVALID_PARAMETER;
+    // maskから位置を取得します
+    if (batch->mask != nullptr) {
+        int count = 0;
+        for (int i = 0; (i < height) && (count < batch->max_point_count); i++) {
+            const unsigned char* mask = batch->mask + (i * width);
+
+            for (int j = 0; (j < width) && (count < batch->max_point_count); j++) {
+                if (mask[j] != 0) {
+                    batch->x[count] = j;
+                    batch->y[count] = i;
+                    count++;
+                }
+            }
+        }
+        batch->point_count = count;
     }
 
-    // 対象の切り出し
-    cv::Rect roi = {};
-    roi.x = x;
-    roi.y = y;
-    roi.width = x + width < image_width ? width : image_width - (x + width) - 1;
-    roi.height = y + height < image_height ? height : image_height - (y + height) - 1;
+    const float d_inf = isc_image_info->camera_specific_parameter.d_inf;
+    const float bf = isc_image_info->camera_specific_parameter.bf;
+    const float base_length = isc_image_info->camera_specific_parameter.base_length;
+    const int center_x = width / 2;
+    const int center_y = height / 2;
+
+    for (int k = 0; k < batch->point_count; k++) {
+        const int x = batch->x[k];
+        const int y = batch->y[k];
+
+        float disparity = 0.0F;
+        if (window_size == 0) {
+            // GetPositionDepth()と同じ範囲の確認
+            if ((x > 0) && (x < width) && (y > 0) && (y < height)) {
+                disparity = GetBlockDisparity(image, width, height, x, y);
+            }
+        }
+        else {
+            if ((x >= 0) && (x < width) && (y >= 0) && (y < height)) {
+                disparity = GetWindowMedianDisparity(image, width, height, x, y, window_size, d_inf);
+            }
+        }
 
-    if (roi.width < 0) {
-        return ISCDPL_E_INVALID_PARAMETER;
-    }
+        float depth = 0.0F, x_d = 0.0F, y_d = 0.0F, z_d = 0.0F;
+        const bool is_valid = disparity > d_inf;
 
-    if (roi.height < 0) {
-        return ISCDPL_E_INVALID_PARAMETER;
-    }
+        if (is_valid) {
+            const float bd = base_length / disparity;
 
-    cv::Mat src_disparity(image_height, image_width, CV_32F, isc_image_info->frame_data[fd_index].depth.image);
-    cv::Mat roi_depth = src_disparity(roi);
+            depth = bf / (disparity - d_inf);
+            x_d = (float)(x - center_x) * bd;
+            y_d = (float)(center_y - y) * bd;
+            z_d = depth;
+        }
+        else {
+            disparity = 0.0F;
+        }
 
-    const float valid_minimum = isc_image_info->camera_specific_parameter.d_inf;
-    
-    // Histogramより最頻値を取得
-    float max_disparity_frequency_value = 0.0F;
-    int histo_ret = GetMaxDisparityValueInHistogram(roi_depth, valid_minimum, &max_disparity_frequency_value, &disparity_histogram_);
+        if (batch->disparity != nullptr) {
+            batch->disparity[k] = disparity;
+        }
+        if (batch->depth != nullptr) {
+            batch->depth[k] = depth;
+        }
+        if (batch->x_d != nullptr) {
+            batch->x_d[k] = x_d;
+        }
+        if (batch->y_d != nullptr) {
+            batch->y_d[k] = y_d;
+        }
+        if (batch->z_d != nullptr) {
+            batch->z_d[k] = z_d;
+        }
+        if (batch->is_valid != nullptr) {
+            batch->is_valid[k] = is_valid ? 1 : 0;
+        }
+    }
 
-    // 視差の平均を計算
-    float sum_of_depth = 0;
-    float max_of_depth = 0, min_of_depth = 999;
+    return DPC_E_OK;
+}
 
-    unsigned int sum_of_depth_count = 0;
-    for (int i = 0; i < roi_depth.rows; i++) {
-        float* src = roi_depth.ptr<float>(i);
+/**
+ * 値を1つ追加します
+ *
+ * @param[in] value 値
+ * @param[in,out] moments 集計
+ * @return none
+ */
+static inline void AddAreaMoments(const float value, AreaMoments* moments)
+{
+    moments->count += 1.0;
+    const double delta = value - moments->mean;
+    moments->mean += delta / moments->count;
+    moments->m2 += delta * (value - moments->mean);
 
-        for (int j = 0; j < roi_depth.cols; j++) {
-            if (*src > valid_minimum) {
-                sum_of_depth += *src;
-                sum_of_depth_count++;
+    if (value < moments->min_value) {
+        moments->min_value = value;
+    }
+    if (value > moments->max_value) {
+        moments->max_value = value;
+    }
 
-                if (*src > max_of_depth) {
-                    max_of_depth = *src;
-                }
-                if (*src < min_of_depth) {
-                    min_of_depth = *src;
-                }
-            }
-            src++;
+    return;
+}
+
+/**
+ * 別に集計した結果を統合します
+ *
+ * @param[in] count 件数
+ * @param[in] mean 平均
+ * @param[in] m2 平均との差の二乗和
+ * @param[in] min_value 最小値
+ * @param[in] max_value 最大値
+ * @param[in,out] moments 集計
+ * @return none
+ * @note Chanの方法により、平均と分散を統合します
+ */
+static void MergeAreaMoments(const double count, const double mean, const double m2, const float min_value, const float max_value, AreaMoments* moments)
+{
+    if (count <= 0.0) {
+        return;
+    }
+
+    const double total = moments->count + count;
+    const double delta = mean - moments->mean;
+    moments->mean += delta * count / total;
+    moments->m2 += m2 + delta * delta * moments->count * count / total;
+    moments->count = total;
+
+    if (min_value < moments->min_value) {
+        moments->min_value = min_value;
+    }
+    if (max_value > moments->max_value) {
+        moments->max_value = max_value;
+    }
+
+    return;
+}
+
+/**
+ * 距離のHistogramの位置を取得します
+ *
+ * @param[in] distance 距離(m)
+ * @retval Histogramの位置
+ * @note 10mまでは0.01m、100mまでは0.1m、1000mまでは1m毎です
+ */
+static inline int GetDistanceBinIndex(const float distance)
+{
+    if (distance < 10.0F) {
+        return std::min((int)(distance * 100.0F), 999);
+    }
+    else if (distance < 100.0F) {
+        return 1000 + std::min((int)((distance - 10.0F) * 10.0F), 899);
+    }
+    else if (distance < 1000.0F) {
+        return 1900 + std::min((int)(distance - 100.0F), 899);
+    }
+
+    return kISC_AREA_DISTANCE_BIN_COUNT - 1;
+}
+
+/**
+ * 距離のHistogramの範囲を取得します
+ *
+ * @param[in] index Histogramの位置
+ * @param[out] lower_cm 下限(cm)
+ * @param[out] width_cm 幅(cm)
+ * @return none
+ */
+static void GetDistanceBinRange(const int index, int* lower_cm, int* width_cm)
+{
+    if (index < 1000) {
+        *lower_cm = index;
+        *width_cm = 1;
+    }
+    else if (index < 1900) {
+        *lower_cm = 1000 + (index - 1000) * 10;
+        *width_cm = 10;
+    }
+    else if (index < 2800) {
+        *lower_cm = 10000 + (index - 1900) * 100;
+        *width_cm = 100;
+    }
+    else {
+        *lower_cm = 100000;
+        *width_cm = 0;
+    }
+
+    return;
+}
+
+/**
+ * 視差のHistogramの範囲を取得します
+ *
+ * @param[in] index Histogramの位置
+ * @param[out] lower 下限
+ * @param[out] width 幅
+ * @return none
+ */
+static void GetDisparityBinRange(const int index, float* lower, float* width)
+{
+    *lower = (float)index / (float)kISC_AREA_DISPARITY_RESOLUTION;
+    *width = 1.0F / (float)kISC_AREA_DISPARITY_RESOLUTION;
+
+    return;
+}
+
+/**
+ * 距離のHistogramの範囲を取得します(m)
+ *
+ * @param[in] index Histogramの位置
+ * @param[out] lower 下限
+ * @param[out] width 幅
+ * @return none
+ */
+static void GetDistanceBinRangeMeter(const int index, float* lower, float* width)
+{
+    int lower_cm = 0, width_cm = 0;
+    GetDistanceBinRange(index, &lower_cm, &width_cm);
+
+    *lower = (float)lower_cm / 100.0F;
+    *width = (float)width_cm / 100.0F;
+
+    return;
+}
+
+/**
+ * Histogramより指定の順位の値を取得します
+ *
+ * @param[in] bins Histogram
+ * @param[in] bin_min 値のある最初の位置
+ * @param[in] bin_max 値のある最後の位置
+ * @param[in] rank 小さい方からの順位 (0~)
+ * @param[in] get_bin_range 位置から範囲を求める関数
+ * @retval 値
+ * @note 範囲内では一様に分布しているとして補間します
+ */
+static float GetHistogramRankValue(const int* bins, const int bin_min, const int bin_max, const __int64 rank, void (*get_bin_range)(const int, float*, float*))
+{
+    __int64 cumulative = 0;
+
+    for (int i = bin_min; i <= bin_max; i++) {
+        if (bins[i] == 0) {
+            continue;
         }
+
+        if (rank < cumulative + bins[i]) {
+            float lower = 0.0F, width = 0.0F;
+            get_bin_range(i, &lower, &width);
+
+            return lower + width * ((float)(rank - cumulative) + 0.5F) / (float)bins[i];
+        }
+        cumulative += bins[i];
     }
 
-    float average_of_depth = 0;
-    if (sum_of_depth_count != 0) {
-        average_of_depth = sum_of_depth / (float)sum_of_depth_count;
+    return 0.0F;
+}
+
+/**
+ * Histogramより中央値を取得します
+ *
+ * @param[in] bins Histogram
+ * @param[in] bin_min 値のある最初の位置
+ * @param[in] bin_max 値のある最後の位置
+ * @param[in] count 値の数
+ * @param[in] get_bin_range 位置から範囲を求める関数
+ * @retval 中央値
+ * @note 失敗時には、0を戻します
+ */
+static float GetHistogramMedian(const int* bins, const int bin_min, const int bin_max, const __int64 count, void (*get_bin_range)(const int, float*, float*))
+{
+    if (count <= 0) {
+        return 0.0F;
+    }
+
+    if (count % 2 == 0) {
+        const float lower_value = GetHistogramRankValue(bins, bin_min, bin_max, count / 2 - 1, get_bin_range);
+        const float upper_value = GetHistogramRankValue(bins, bin_min, bin_max, count / 2, get_bin_range);
+
+        return (lower_value + upper_value) / 2.0F;
+    }
+
+    return GetHistogramRankValue(bins, bin_min, bin_max, (count - 1) / 2, get_bin_range);
+}
+
+/**
+ * 1つの視差を集計します
+ *
+ * @param[in] disparity 視差
+ * @param[in,out] accumulator 集計
+ * @return none
+ */
+static inline void AddAreaSample(const float disparity, AreaAccumulator* accumulator)
+{
+    if (!(disparity > accumulator->d_inf)) {
+        return;
     }
 
-    // 中央値を計算
-    float median_of_depth = 0;
-    if (sum_of_depth_count != 0) {
-        median_of_depth = MedianMat(roi_depth);
+    AddAreaMoments(disparity, &accumulator->disparity);
+
+    const int disparity_index = (int)(disparity * (float)kISC_AREA_DISPARITY_RESOLUTION);
+    if (disparity_index < kISC_AREA_DISPARITY_BIN_COUNT) {
+        accumulator->disparity_bins[disparity_index]++;
+        accumulator->disparity_bin_min = std::min(accumulator->disparity_bin_min, disparity_index);
+        accumulator->disparity_bin_max = std::max(accumulator->disparity_bin_max, disparity_index);
     }
 
-    // 視差の標準偏差を計算
-    float std_dev_of_depth = 0;
-    if (sum_of_depth_count != 0) {
+    const float distance = accumulator->bf / (disparity - accumulator->d_inf);
+    if ((distance > accumulator->min_distance) && (distance < accumulator->max_distance)) {
+        AddAreaMoments(distance, &accumulator->distance);
 
-        float sum_of_mean_diff = 0;
-        unsigned int sum_of_mean_diff_count = 0;
-        for (int i = 0; i < roi_depth.rows; i++) {
-            float* src = roi_depth.ptr<float>(i);
+        const int distance_index = GetDistanceBinIndex(distance);
+        accumulator->distance_bins[distance_index]++;
+        accumulator->distance_bin_min = std::min(accumulator->distance_bin_min, distance_index);
+        accumulator->distance_bin_max = std::max(accumulator->distance_bin_max, distance_index);
+    }
 
-            for (int j = 0; j < roi_depth.cols; j++) {
-                if (*src > valid_minimum) {
-                    sum_of_mean_diff += ((*src - average_of_depth) * (*src - average_of_depth));
-                    sum_of_mean_diff_count++;
+    return;
+}
+
+#ifdef ISC_MEASUREMENT_USE_SSE2
+/**
+ * 有効な値のみ選択します
+ *
+ * @param[in] mask 選択
+ * @param[in] a 選択時の値
+ * @param[in] b 非選択時の値
+ * @retval 結果
+ */
+static inline __m128 SelectPs(const __m128 mask, const __m128 a, const __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+/**
+ * 4並列のWelfordに値を追加します
+ *
+ * @param[in] valid 有効な値
+ * @param[in] value 値
+ * @param[in,out] count 件数
+ * @param[in,out] mean 平均
+ * @param[in,out] m2 平均との差の二乗和
+ * @param[in,out] min_value 最小値
+ * @param[in,out] max_value 最大値
+ * @return none
+ */
+static inline void AddAreaMomentsPs(const __m128 valid, const __m128 value, __m128* count, __m128* mean, __m128* m2, __m128* min_value, __m128* max_value)
+{
+    const __m128 one = _mm_set1_ps(1.0F);
+    const __m128 weight = _mm_and_ps(valid, one);
+    const __m128 x = _mm_and_ps(valid, value);
+
+    *count = _mm_add_ps(*count, weight);
+    const __m128 delta = _mm_sub_ps(x, *mean);
+    *mean = _mm_add_ps(*mean, _mm_mul_ps(delta, _mm_div_ps(weight, _mm_max_ps(*count, one))));
+    *m2 = _mm_add_ps(*m2, _mm_mul_ps(weight, _mm_mul_ps(delta, _mm_sub_ps(x, *mean))));
+
+    *min_value = _mm_min_ps(*min_value, SelectPs(valid, value, _mm_set1_ps(FLT_MAX)));
+    *max_value = _mm_max_ps(*max_value, SelectPs(valid, value, _mm_set1_ps(-FLT_MAX)));
+
+    return;
+}
+
+/**
+ * 4並列の集計を統合します
+ *
+ * @param[in] count 件数
+ * @param[in] mean 平均
+ * @param[in] m2 平均との差の二乗和
+ * @param[in] min_value 最小値
+ * @param[in] max_value 最大値
+ * @param[in,out] moments 集計
+ * @return none
+ */
+static void MergeAreaMomentsPs(const __m128 count, const __m128 mean, const __m128 m2, const __m128 min_value, const __m128 max_value, AreaMoments* moments)
+{
+    float lane_count[4] = {}, lane_mean[4] = {}, lane_m2[4] = {}, lane_min[4] = {}, lane_max[4] = {};
+    _mm_storeu_ps(lane_count, count);
+    _mm_storeu_ps(lane_mean, mean);
+    _mm_storeu_ps(lane_m2, m2);
+    _mm_storeu_ps(lane_min, min_value);
+    _mm_storeu_ps(lane_max, max_value);
+
+    for (int i = 0; i < 4; i++) {
+        MergeAreaMoments(lane_count[i], lane_mean[i], lane_m2[i], lane_min[i], lane_max[i], moments);
+    }
+
+    return;
+}
+#endif
+
+/**
+ * 1行分の視差を集計します
+ *
+ * @param[in] src 視差
+ * @param[in] count 数
+ * @param[in,out] accumulator 集計
+ * @return none
+ */
+static void AccumulateAreaRow(const float* src, const int count, AreaAccumulator* accumulator)
+{
+    int j = 0;
+
+#ifdef ISC_MEASUREMENT_USE_SSE2
+    const __m128 d_inf = _mm_set1_ps(accumulator->d_inf);
+    const __m128 bf = _mm_set1_ps(accumulator->bf);
+    const __m128 min_distance = _mm_set1_ps(accumulator->min_distance);
+    const __m128 max_distance = _mm_set1_ps(accumulator->max_distance);
+    const __m128 one = _mm_set1_ps(1.0F);
+
+    float disparity_lane[4] = {}, distance_lane[4] = {};
+
+    for (; j + 4 <= count; j += 4) {
+        const __m128 disparity = _mm_loadu_ps(src + j);
+        const __m128 valid_disparity = _mm_cmpgt_ps(disparity, d_inf);
+
+        const int disparity_bits = _mm_movemask_ps(valid_disparity);
+        if (disparity_bits == 0) {
+            continue;
+        }
+
+        AddAreaMomentsPs(valid_disparity, disparity,
+            &accumulator->lane_disparity_count, &accumulator->lane_disparity_mean, &accumulator->lane_disparity_m2,
+            &accumulator->lane_disparity_min, &accumulator->lane_disparity_max);
+
+        // 無効な視差は除算しない
+        const __m128 distance = _mm_div_ps(bf, SelectPs(valid_disparity, _mm_sub_ps(disparity, d_inf), one));
+        const __m128 valid_distance = _mm_and_ps(valid_disparity, _mm_and_ps(_mm_cmpgt_ps(distance, min_distance), _mm_cmplt_ps(distance, max_distance)));
+
+        AddAreaMomentsPs(valid_distance, distance,
+            &accumulator->lane_distance_count, &accumulator->lane_distance_mean, &accumulator->lane_distance_m2,
+            &accumulator->lane_distance_min, &accumulator->lane_distance_max);
+
+        // Histogram
+        const int distance_bits = _mm_movemask_ps(valid_distance);
+        _mm_storeu_ps(disparity_lane, disparity);
+        _mm_storeu_ps(distance_lane, distance);
+
+        for (int k = 0; k < 4; k++) {
+            if (disparity_bits & (1 << k)) {
+                const int disparity_index = (int)(disparity_lane[k] * (float)kISC_AREA_DISPARITY_RESOLUTION);
+                if (disparity_index < kISC_AREA_DISPARITY_BIN_COUNT) {
+                    accumulator->disparity_bins[disparity_index]++;
+                    accumulator->disparity_bin_min = std::min(accumulator->disparity_bin_min, disparity_index);
+                    accumulator->disparity_bin_max = std::max(accumulator->disparity_bin_max, disparity_index);
                 }
-                src++;
             }
+
+            if (distance_bits & (1 << k)) {
+                const int distance_index = GetDistanceBinIndex(distance_lane[k]);
+                accumulator->distance_bins[distance_index]++;
+                accumulator->distance_bin_min = std::min(accumulator->distance_bin_min, distance_index);
+                accumulator->distance_bin_max = std::max(accumulator->distance_bin_max, distance_index);
+            }
+        }
+    }
+#endif
+
+    for (; j < count; j++) {
+        AddAreaSample(src[j], accumulator);
+    }
+
+    return;
+}
+
+/**
+ * 距離のHistogramより最頻値を取得します
+ *
+ * @param[in] accumulator 集計
+ * @param[in] min_valid_value 有効な最小の距離
+ * @param[in,out] mode_bins 作業領域
+ * @retval 最頻値
+ * @note 最大値により、10mまでは0.01m、100mまでは0.1m、1000mまでは1mを分解能とします
+ */
+static float GetDistanceMode(const AreaAccumulator* accumulator, const float min_valid_value, int* mode_bins)
+{
+    const float max_value = accumulator->distance.max_value;
+
+    if ((accumulator->distance.count <= 0) || (max_value > 1000.0F)) {
+        // 範囲外
+        return 0.0F;
+    }
+
+    int resolution = 1;
+    if (max_value < 10.0F) {
+        resolution = 100;
+    }
+    else if (max_value < 100.0F) {
+        resolution = 10;
+    }
+    const int step_cm = 100 / resolution;
+
+    memset(mode_bins, 0, sizeof(int) * kISC_AREA_DISTANCE_MODE_BIN_COUNT);
+
+    for (int i = accumulator->distance_bin_min; i <= accumulator->distance_bin_max; i++) {
+        if (accumulator->distance_bins[i] == 0) {
+            continue;
+        }
+
+        int lower_cm = 0, width_cm = 0;
+        GetDistanceBinRange(i, &lower_cm, &width_cm);
+
+        const int index = lower_cm / step_cm;
+        if (index < kISC_AREA_DISTANCE_MODE_BIN_COUNT) {
+            mode_bins[index] += accumulator->distance_bins[i];
+        }
+    }
+
+    // 無効分は対象外
+    const int start = std::max(0, (int)(min_valid_value * (float)resolution));
+
+    int max_frequency = 0;
+    int max_frequency_index = 0;
+    for (int i = start; i < kISC_AREA_DISTANCE_MODE_BIN_COUNT; i++) {
+        if (mode_bins[i] > max_frequency) {
+            max_frequency = mode_bins[i];
+            max_frequency_index = i;
+        }
+    }
+
+    return (float)max_frequency_index / (float)resolution;
+}
+
+/**
+ * 指定領域の情報を取得します
+ *
+ * @param[in] x 画像内座標左上(X)
+ * @param[in] y 画像内座標左上(Y)
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[in] isc_image_info データ構造体
+ * @param[out] isc_data_statistics 領域の情報
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 視差と距離の最大、最小、平均、標準偏差とHistogramを1回の走査で集計し、中央値と最頻値はHistogramより求めます
+ */
+int IscMeasurement::GetAreaStatistics(const int x, const int y, const int width, const int height, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics)
+{
+    
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_data_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    double min_distance = isc_data_statistics->min_distance;
+    double max_distance = isc_data_statistics->max_distance;
+
+    memset(isc_data_statistics, 0, sizeof(IscAreaDataStatistics));
+
+    isc_data_statistics->min_distance = min_distance;
+    isc_data_statistics->max_distance = max_distance;
+
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+
+    IscShutterMode shutter_mode = isc_image_info->shutter_mode;
+
+    if (shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
+
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
         }
-        std_dev_of_depth = sqrt(sum_of_mean_diff / sum_of_mean_diff_count);
     }
 
+    int image_width = isc_image_info->frame_data[fd_index].depth.width;
+    int image_height = isc_image_info->frame_data[fd_index].depth.height;
+
+    if ((x <= 0) || (x >= image_width)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if ((y <= 0) || (y >= image_height)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    // 対象の切り出し
+    cv::Rect roi = {};
+    roi.x = x;
+    roi.y = y;
+    roi.width = x + width < image_width ? width : image_width - (x + width) - 1;
+    roi.height = y + height < image_height ? height : image_height - (y + height) - 1;
+
+    if (roi.width < 0) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (roi.height < 0) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const float d_inf = isc_image_info->camera_specific_parameter.d_inf;
+    const float bf = isc_image_info->camera_specific_parameter.bf;
+    const float base_length = isc_image_info->camera_specific_parameter.base_length;
+
+    // 視差と距離を同時に集計
+    AreaAccumulator accumulator = {};
+    accumulator.d_inf = d_inf;
+    accumulator.bf = bf;
+    accumulator.min_distance = (float)min_distance;
+    accumulator.max_distance = (float)max_distance;
+
+    accumulator.disparity.min_value = FLT_MAX;
+    accumulator.disparity.max_value = -FLT_MAX;
+    accumulator.distance.min_value = FLT_MAX;
+    accumulator.distance.max_value = -FLT_MAX;
+
+    accumulator.disparity_bins = area_histogram_.disparity_bins;
+    accumulator.disparity_bin_min = kISC_AREA_DISPARITY_BIN_COUNT;
+    accumulator.disparity_bin_max = -1;
+
+    accumulator.distance_bins = area_histogram_.distance_bins;
+    accumulator.distance_bin_min = kISC_AREA_DISTANCE_BIN_COUNT;
+    accumulator.distance_bin_max = -1;
+
+#ifdef ISC_MEASUREMENT_USE_SSE2
+    accumulator.lane_disparity_count = _mm_setzero_ps();
+    accumulator.lane_disparity_mean = _mm_setzero_ps();
+    accumulator.lane_disparity_m2 = _mm_setzero_ps();
+    accumulator.lane_disparity_min = _mm_set1_ps(FLT_MAX);
+    accumulator.lane_disparity_max = _mm_set1_ps(-FLT_MAX);
+
+    accumulator.lane_distance_count = _mm_setzero_ps();
+    accumulator.lane_distance_mean = _mm_setzero_ps();
+    accumulator.lane_distance_m2 = _mm_setzero_ps();
+    accumulator.lane_distance_min = _mm_set1_ps(FLT_MAX);
+    accumulator.lane_distance_max = _mm_set1_ps(-FLT_MAX);
+#endif
+
+    const float* src_disparity = isc_image_info->frame_data[fd_index].depth.image;
+    for (int i = 0; i < roi.height; i++) {
+        AccumulateAreaRow(src_disparity + ((roi.y + i) * image_width) + roi.x, roi.width, &accumulator);
+    }
+
+#ifdef ISC_MEASUREMENT_USE_SSE2
+    MergeAreaMomentsPs(accumulator.lane_disparity_count, accumulator.lane_disparity_mean, accumulator.lane_disparity_m2,
+        accumulator.lane_disparity_min, accumulator.lane_disparity_max, &accumulator.disparity);
+    MergeAreaMomentsPs(accumulator.lane_distance_count, accumulator.lane_distance_mean, accumulator.lane_distance_m2,
+        accumulator.lane_distance_min, accumulator.lane_distance_max, &accumulator.distance);
+#endif
+
     // 結果を設定
     isc_data_statistics->x = x;
-    isc_data_statistics->y = x;
-    isc_data_statistics->width = roi_depth.cols;
-    isc_data_statistics->height = roi_depth.rows;
-
-    isc_data_statistics->statistics_depth.max_value = max_of_depth;
-    isc_data_statistics->statistics_depth.min_value = min_of_depth;
-    isc_data_statistics->statistics_depth.std_dev = std_dev_of_depth;
-    isc_data_statistics->statistics_depth.average = average_of_depth;
-    isc_data_statistics->statistics_depth.median = median_of_depth;
-
-    float d_inf = isc_image_info->camera_specific_parameter.d_inf;
-    float bf = isc_image_info->camera_specific_parameter.bf;
-    float base_length = isc_image_info->camera_specific_parameter.base_length;
+    isc_data_statistics->y = y;
+    isc_data_statistics->width = roi.width;
+    isc_data_statistics->height = roi.height;
+
+    // 視差
+    const __int64 disparity_count = (__int64)accumulator.disparity.count;
+    float max_disparity_frequency_value = 0.0F;
+
+    if (disparity_count != 0) {
+        isc_data_statistics->statistics_depth.max_value = accumulator.disparity.max_value;
+        isc_data_statistics->statistics_depth.min_value = accumulator.disparity.min_value;
+        isc_data_statistics->statistics_depth.std_dev = (float)sqrt(accumulator.disparity.m2 / accumulator.disparity.count);
+        isc_data_statistics->statistics_depth.average = (float)accumulator.disparity.mean;
+
+        __int64 binned_count = 0;
+        int max_frequency = 0;
+        for (int i = accumulator.disparity_bin_min; i <= accumulator.disparity_bin_max; i++) {
+            binned_count += accumulator.disparity_bins[i];
+            if (accumulator.disparity_bins[i] > max_frequency) {
+                max_frequency = accumulator.disparity_bins[i];
+                max_disparity_frequency_value = (float)i / (float)kISC_AREA_DISPARITY_RESOLUTION;
+            }
+        }
+        isc_data_statistics->statistics_depth.median = GetHistogramMedian(accumulator.disparity_bins, accumulator.disparity_bin_min, accumulator.disparity_bin_max, binned_count, GetDisparityBinRange);
+        isc_data_statistics->statistics_depth.mode = max_disparity_frequency_value;
+    }
+    else {
+        isc_data_statistics->statistics_depth.max_value = 0;
+        isc_data_statistics->statistics_depth.min_value = 999;
+    }
+
     if (max_disparity_frequency_value > d_inf) {
         float bd = base_length / (max_disparity_frequency_value - d_inf);
         isc_data_statistics->roi_3d.width = bd * isc_data_statistics->width;
@@ -532,340 +1418,650 @@ int IscMeasurement::GetAreaStatistics(const int x, const int y, const int width,
         isc_data_statistics->roi_3d.distance = 0;
     }
 
-    // convert to distance
-    float sum_of_distance = 0;
-    float max_of_distance = 0, min_of_distance = 99999;
-    unsigned int sum_of_distance_count = 0;
-
-    cv::Mat src_distance(roi_depth.rows, roi_depth.cols, CV_32F, work_buffers_.depth_buffer[0]);
-
-    for (int i = 0; i < roi_depth.rows; i++) {
-        float* src = roi_depth.ptr<float>(i);
-        float* dst = src_distance.ptr<float>(i);
+    // 距離
+    const __int64 distance_count = (__int64)accumulator.distance.count;
 
-        for (int j = 0; j < roi_depth.cols; j++) {
-            if (*src > valid_minimum) {
+    if (distance_count != 0) {
+        isc_data_statistics->statistics_distance.max_value = accumulator.distance.max_value;
+        isc_data_statistics->statistics_distance.min_value = accumulator.distance.min_value;
+        isc_data_statistics->statistics_distance.std_dev = (float)sqrt(accumulator.distance.m2 / accumulator.distance.count);
+        isc_data_statistics->statistics_distance.average = (float)accumulator.distance.mean;
+        isc_data_statistics->statistics_distance.median = GetHistogramMedian(accumulator.distance_bins, accumulator.distance_bin_min, accumulator.distance_bin_max, distance_count, GetDistanceBinRangeMeter);
 
-                float distance = bf / (*src - d_inf);
-                
-                if ((distance > isc_data_statistics->min_distance) && (distance < isc_data_statistics->max_distance)) {
-                    *dst = distance;
-
-                    sum_of_distance += distance;
-                    sum_of_distance_count++;
-
-                    if (distance > max_of_distance) {
-                        max_of_distance = distance;
-                    }
-                    if (distance < min_of_distance) {
-                        min_of_distance = distance;
-                    }
-                }
-                else {
-                    *dst = 0;
-                }
-            }
-            else {
-                *dst = 0;
-            }
-            src++;
-            dst++;
-        }
+        float valid_distance_minimum = (float)std::max((double)isc_data_statistics->min_distance, std::max(0.5, isc_image_info->camera_specific_parameter.bf / 255.0));
+        isc_data_statistics->statistics_distance.mode = GetDistanceMode(&accumulator, valid_distance_minimum, area_histogram_.distance_mode_bins);
     }
-
-    float average_of_distance = 0;
-    if (sum_of_distance_count != 0) {
-        average_of_distance = sum_of_distance / (float)sum_of_distance_count;
+    else {
+        isc_data_statistics->statistics_distance.max_value = 0;
+        isc_data_statistics->statistics_distance.min_value = 99999;
     }
 
-    float median_of_distance = 0;
-    if (sum_of_distance_count != 0) {
-        median_of_distance = MedianMat(src_distance);
+    // 次回のために使用した範囲のみ消去します
+    if (accumulator.disparity_bin_max >= accumulator.disparity_bin_min) {
+        memset(&accumulator.disparity_bins[accumulator.disparity_bin_min], 0, sizeof(int) * (accumulator.disparity_bin_max - accumulator.disparity_bin_min + 1));
+    }
+    if (accumulator.distance_bin_max >= accumulator.distance_bin_min) {
+        memset(&accumulator.distance_bins[accumulator.distance_bin_min], 0, sizeof(int) * (accumulator.distance_bin_max - accumulator.distance_bin_min + 1));
     }
 
-    float std_dev_of_distance = 0;
-    if (sum_of_distance_count != 0) {
+    return DPC_E_OK;
+}
 
-        float sum_of_mean_diff = 0;
-        unsigned int sum_of_mean_diff_count = 0;
-        for (int i = 0; i < src_distance.rows; i++) {
-            float* src = src_distance.ptr<float>(i);
+/**
+ * 一括集計用の領域を確保します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 大きな領域のため、初回の一括集計時に確保します
+ */
+int IscMeasurement::AllocateAreaTables()
+{
+    const int max_width = work_buffers_.max_width;
+    const int max_height = work_buffers_.max_height;
 
-            for (int j = 0; j < src_distance.cols; j++) {
-                if (*src > 0) {
-                    sum_of_mean_diff += ((*src - average_of_distance) * (*src - average_of_distance));
-                    sum_of_mean_diff_count++;
-                }
-                src++;
-            }
-        }
-        std_dev_of_distance = sqrt(sum_of_mean_diff / sum_of_mean_diff_count);
+    if ((max_width <= 0) || (max_height <= 0)) {
+        return ISCDPL_E_INVALID_HANDLE;
     }
 
-    // Histogramより最頻値を取得
-    float max_distance_frequency_value = 0.0F;
-    float valid_distance_minimum = std::max((double)isc_data_statistics->min_distance, std::max(0.5, isc_image_info->camera_specific_parameter.bf / 255.0));
+    const size_t table_size = (size_t)(max_width + 1) * (size_t)(max_height + 1);
+    const size_t frame_size = (size_t)max_width * (size_t)max_height;
+    const int max_tile_columns = (max_width + kISC_AREA_TABLE_TILE_SIZE - 1) / kISC_AREA_TABLE_TILE_SIZE;
+    const int max_tile_rows = (max_height + kISC_AREA_TABLE_TILE_SIZE - 1) / kISC_AREA_TABLE_TILE_SIZE;
+    const size_t tile_count = (size_t)max_tile_columns * (size_t)max_tile_rows;
+    const size_t tile_table_size = (size_t)(max_tile_columns + 1) * (size_t)(max_tile_rows + 1) * kISC_AREA_TABLE_BIN_COUNT;
+
+    area_tables_.disparity_count = new int[table_size];
+    area_tables_.disparity_sum = new __int64[table_size];
+    area_tables_.disparity_square_sum = new __int64[table_size];
+    area_tables_.distance_count = new int[table_size];
+    area_tables_.distance_sum = new __int64[table_size];
+    area_tables_.distance_square_sum = new __int64[table_size];
+
+    area_tables_.disparity_bin = new unsigned char[frame_size];
+    area_tables_.distance_bin = new unsigned char[frame_size];
+    area_tables_.distance_bin_lut = new unsigned char[kISC_AREA_TABLE_LUT_SIZE];
+    area_tables_.disparity_bin_edges = new float[kISC_AREA_TABLE_BIN_COUNT + 1];
+    area_tables_.distance_bin_edges = new float[kISC_AREA_TABLE_BIN_COUNT + 1];
+
+    area_tables_.disparity_tile_histogram = new int[tile_table_size];
+    area_tables_.distance_tile_histogram = new int[tile_table_size];
+
+    area_tables_.tile_disparity_min = new float[tile_count];
+    area_tables_.tile_disparity_max = new float[tile_count];
+    area_tables_.tile_distance_min = new float[tile_count];
+    area_tables_.tile_distance_max = new float[tile_count];
+
+    // 視差は0~256を等間隔に分割します
+    for (int i = 0; i <= kISC_AREA_TABLE_BIN_COUNT; i++) {
+        area_tables_.disparity_bin_edges[i] = (float)i * kISC_AREA_TABLE_DISPARITY_BIN_WIDTH;
+    }
 
-    histo_ret = GetMaxDistanceValueInHistogram(src_distance, valid_distance_minimum, &max_distance_frequency_value, &distance_histogram_);
-
-    // 結果を設定
-    isc_data_statistics->statistics_distance.max_value = max_of_distance;
-    isc_data_statistics->statistics_distance.min_value = min_of_distance;
-    isc_data_statistics->statistics_distance.std_dev = std_dev_of_distance;
-    isc_data_statistics->statistics_distance.average = average_of_distance;
-    isc_data_statistics->statistics_distance.median = median_of_distance;
+    area_tables_.width = 0;
+    area_tables_.height = 0;
 
     return DPC_E_OK;
 }
 
-int GetMaxDisparityValueInHistogram(cv::Mat src_data, const float min_valid_value, float* max_frequency_value, HistogramData* histogram_data)
+/**
+ * 一括集計用の領域を解放します
+ *
+ * @return none
+ */
+void IscMeasurement::ReleaseAreaTables()
 {
-    // Histogram
-    /*
-        Histogramの最頻値を取得します
-    */
-
-    float* hist_data = histogram_data->histo_buffer;
-    memset(hist_data, 0, sizeof(float) * histogram_data->histo_buffer_size);
+    delete[] area_tables_.tile_distance_max;
+    delete[] area_tables_.tile_distance_min;
+    delete[] area_tables_.tile_disparity_max;
+    delete[] area_tables_.tile_disparity_min;
+
+    delete[] area_tables_.distance_tile_histogram;
+    delete[] area_tables_.disparity_tile_histogram;
+
+    delete[] area_tables_.distance_bin_edges;
+    delete[] area_tables_.disparity_bin_edges;
+    delete[] area_tables_.distance_bin_lut;
+    delete[] area_tables_.distance_bin;
+    delete[] area_tables_.disparity_bin;
+
+    delete[] area_tables_.distance_square_sum;
+    delete[] area_tables_.distance_sum;
+    delete[] area_tables_.distance_count;
+    delete[] area_tables_.disparity_square_sum;
+    delete[] area_tables_.disparity_sum;
+    delete[] area_tables_.disparity_count;
+
+    memset(&area_tables_, 0, sizeof(area_tables_));
+
+    return;
+}
 
-    for (int i = 0; i < src_data.rows; i++) {
-        float* src = src_data.ptr<float>(i);
+/**
+ * 視差画像全体の集計表を作成します
+ *
+ * @param[in] disparity 視差
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[in] d_inf 無限遠の視差
+ * @param[in] bf 基線長 x 焦点距離
+ * @param[in] min_distance 有効な最小の距離(m)
+ * @param[in] max_distance 有効な最大の距離(m)
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 画素毎の件数、和、二乗和のsummed-area tableと、Tile毎のHistogramのsummed-area tableを作成します
+ *       和は固定小数点(視差 1/256 pixel、距離 mm)の整数で集計するため、結果は集計の順序に依存しません
+ */
+int IscMeasurement::BuildAreaTables(const float* disparity, const int width, const int height, const float d_inf, const float bf, const float min_distance, const float max_distance)
+{
+    if ((width > work_buffers_.max_width) || (height > work_buffers_.max_height)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
 
-        for (int j = 0; j < src_data.cols; j++) {
-            int index = (int)(*src * (float)histogram_data->resolution);
-            if (index < histogram_data->histo_buffer_size) {
-                hist_data[index]++;
-            }
-            src++;
-        }
+    area_tables_.width = width;
+    area_tables_.height = height;
+    area_tables_.tile_columns = (width + kISC_AREA_TABLE_TILE_SIZE - 1) / kISC_AREA_TABLE_TILE_SIZE;
+    area_tables_.tile_rows = (height + kISC_AREA_TABLE_TILE_SIZE - 1) / kISC_AREA_TABLE_TILE_SIZE;
+    area_tables_.disparity = disparity;
+    area_tables_.d_inf = d_inf;
+    area_tables_.bf = bf;
+    area_tables_.min_distance = min_distance;
+    area_tables_.max_distance = max_distance;
+
+    // 距離は有効範囲を対数で等間隔に分割します
+    const double log_min_distance = log((double)std::max(min_distance, 0.01F));
+    double log_range = log((double)max_distance) - log_min_distance;
+    if (log_range <= 0.0) {
+        log_range = 1.0;
     }
 
-    // 無効分のデータをクリアする
-    int start = 0;
-    int end = (int)(min_valid_value + 0.5);
-    for (int i = start; i < end; i++) {
-        hist_data[i] = 0;
+    for (int i = 0; i <= kISC_AREA_TABLE_BIN_COUNT; i++) {
+        area_tables_.distance_bin_edges[i] = (float)exp(log_min_distance + log_range * (double)i / (double)kISC_AREA_TABLE_BIN_COUNT);
     }
-    double max_histo_val = 0;
-    cv::Point max_histo_point = {};
-    cv::Mat src_hist_data(histogram_data->histo_buffer_size, 1, CV_32F, hist_data);
 
-    cv::minMaxLoc(src_hist_data, 0, &max_histo_val, 0, &max_histo_point);
+    for (int i = 0; i < kISC_AREA_TABLE_LUT_SIZE; i++) {
+        const double lut_disparity = ((double)i + 0.5) / (double)kISC_AREA_TABLE_LUT_RESOLUTION;
 
-    // 最頻値
-    *max_frequency_value = max_histo_point.y / (float)histogram_data->resolution;
+        if (lut_disparity <= d_inf) {
+            area_tables_.distance_bin_lut[i] = kISC_AREA_TABLE_BIN_COUNT - 1;
+            continue;
+        }
+
+        const double lut_distance = bf / (lut_disparity - d_inf);
+        const int bin = (int)floor((log(lut_distance) - log_min_distance) / log_range * (double)kISC_AREA_TABLE_BIN_COUNT);
+        area_tables_.distance_bin_lut[i] = (unsigned char)std::min(std::max(bin, 0), kISC_AREA_TABLE_BIN_COUNT - 1);
+    }
 
-    // (debug)Histogramの結果を表示する
-    bool show_histo_image = false;
-    if (show_histo_image) {
-        // 分解能1でHistogramを作成して表示します
-        hist_data = histogram_data->buffer;
-        memset(hist_data, 0, sizeof(float) * histogram_data->buffer_size);
+    const int tile_columns = area_tables_.tile_columns;
+    const int tile_rows = area_tables_.tile_rows;
+    const size_t tile_stride = (size_t)(tile_columns + 1) * kISC_AREA_TABLE_BIN_COUNT;
+    const size_t tile_table_size = tile_stride * (size_t)(tile_rows + 1);
 
-        for (int i = 0; i < src_data.rows; i++) {
-            float* src = src_data.ptr<float>(i);
+    memset(area_tables_.disparity_tile_histogram, 0, sizeof(int) * tile_table_size);
+    memset(area_tables_.distance_tile_histogram, 0, sizeof(int) * tile_table_size);
 
-            for (int j = 0; j < src_data.cols; j++) {
-                int index = (int)(*src);
-                if (index < histogram_data->buffer_size) {
-                    hist_data[index]++;
+    for (int i = 0; i < tile_columns * tile_rows; i++) {
+        area_tables_.tile_disparity_min[i] = FLT_MAX;
+        area_tables_.tile_disparity_max[i] = -FLT_MAX;
+        area_tables_.tile_distance_min[i] = FLT_MAX;
+        area_tables_.tile_distance_max[i] = -FLT_MAX;
+    }
+
+    // summed-area tables
+    const int stride = width + 1;
+
+    memset(area_tables_.disparity_count, 0, sizeof(int) * stride);
+    memset(area_tables_.disparity_sum, 0, sizeof(__int64) * stride);
+    memset(area_tables_.disparity_square_sum, 0, sizeof(__int64) * stride);
+    memset(area_tables_.distance_count, 0, sizeof(int) * stride);
+    memset(area_tables_.distance_sum, 0, sizeof(__int64) * stride);
+    memset(area_tables_.distance_square_sum, 0, sizeof(__int64) * stride);
+
+    for (int i = 0; i < height; i++) {
+        const float* src = disparity + (i * width);
+        unsigned char* disparity_bin = area_tables_.disparity_bin + (i * width);
+        unsigned char* distance_bin = area_tables_.distance_bin + (i * width);
+
+        const size_t upper = (size_t)i * stride;
+        const size_t current = (size_t)(i + 1) * stride;
+
+        area_tables_.disparity_count[current] = 0;
+        area_tables_.disparity_sum[current] = 0;
+        area_tables_.disparity_square_sum[current] = 0;
+        area_tables_.distance_count[current] = 0;
+        area_tables_.distance_sum[current] = 0;
+        area_tables_.distance_square_sum[current] = 0;
+
+        int row_disparity_count = 0, row_distance_count = 0;
+        __int64 row_disparity_sum = 0, row_disparity_square_sum = 0;
+        __int64 row_distance_sum = 0, row_distance_square_sum = 0;
+
+        const int tile_y = i / kISC_AREA_TABLE_TILE_SIZE;
+
+        for (int j = 0; j < width; j++) {
+            const float value = src[j];
+
+            disparity_bin[j] = kISC_AREA_TABLE_INVALID_BIN;
+            distance_bin[j] = kISC_AREA_TABLE_INVALID_BIN;
+
+            if (value > d_inf) {
+                const int tile_x = j / kISC_AREA_TABLE_TILE_SIZE;
+                const int tile_index = tile_y * tile_columns + tile_x;
+                const size_t tile_histogram_offset = (size_t)(tile_y + 1) * tile_stride + (size_t)(tile_x + 1) * kISC_AREA_TABLE_BIN_COUNT;
+
+                const __int64 fixed_disparity = (__int64)(value * 256.0F + 0.5F);
+                row_disparity_count++;
+                row_disparity_sum += fixed_disparity;
+                row_disparity_square_sum += fixed_disparity * fixed_disparity;
+
+                const int bin = std::min((int)(value / kISC_AREA_TABLE_DISPARITY_BIN_WIDTH), kISC_AREA_TABLE_BIN_COUNT - 1);
+                disparity_bin[j] = (unsigned char)bin;
+                area_tables_.disparity_tile_histogram[tile_histogram_offset + bin]++;
+
+                area_tables_.tile_disparity_min[tile_index] = std::min(area_tables_.tile_disparity_min[tile_index], value);
+                area_tables_.tile_disparity_max[tile_index] = std::max(area_tables_.tile_disparity_max[tile_index], value);
+
+                const float distance = bf / (value - d_inf);
+                if ((distance > min_distance) && (distance < max_distance)) {
+                    const __int64 fixed_distance = (__int64)(distance * 1000.0F + 0.5F);
+                    row_distance_count++;
+                    row_distance_sum += fixed_distance;
+                    row_distance_square_sum += fixed_distance * fixed_distance;
+
+                    const int lut_index = std::min((int)(value * (float)kISC_AREA_TABLE_LUT_RESOLUTION), kISC_AREA_TABLE_LUT_SIZE - 1);
+                    const int distance_bin_index = area_tables_.distance_bin_lut[lut_index];
+                    distance_bin[j] = (unsigned char)distance_bin_index;
+                    area_tables_.distance_tile_histogram[tile_histogram_offset + distance_bin_index]++;
+
+                    area_tables_.tile_distance_min[tile_index] = std::min(area_tables_.tile_distance_min[tile_index], distance);
+                    area_tables_.tile_distance_max[tile_index] = std::max(area_tables_.tile_distance_max[tile_index], distance);
                 }
-                src++;
             }
+
+            area_tables_.disparity_count[current + j + 1] = area_tables_.disparity_count[upper + j + 1] + row_disparity_count;
+            area_tables_.disparity_sum[current + j + 1] = area_tables_.disparity_sum[upper + j + 1] + row_disparity_sum;
+            area_tables_.disparity_square_sum[current + j + 1] = area_tables_.disparity_square_sum[upper + j + 1] + row_disparity_square_sum;
+            area_tables_.distance_count[current + j + 1] = area_tables_.distance_count[upper + j + 1] + row_distance_count;
+            area_tables_.distance_sum[current + j + 1] = area_tables_.distance_sum[upper + j + 1] + row_distance_sum;
+            area_tables_.distance_square_sum[current + j + 1] = area_tables_.distance_square_sum[upper + j + 1] + row_distance_square_sum;
         }
-        // 無効分のデータをクリアする
-        int start = 0;
-        int end = (int)(min_valid_value + 0.5);
-        for (int i = start; i < end; i++) {
-            hist_data[i] = 0;
+    }
+
+    // Tile毎のHistogramを累積します
+    for (int ty = 1; ty <= tile_rows; ty++) {
+        for (int tx = 1; tx <= tile_columns; tx++) {
+            const size_t current = (size_t)ty * tile_stride + (size_t)tx * kISC_AREA_TABLE_BIN_COUNT;
+            const size_t left = current - kISC_AREA_TABLE_BIN_COUNT;
+            const size_t upper = current - tile_stride;
+            const size_t upper_left = upper - kISC_AREA_TABLE_BIN_COUNT;
+
+            for (int b = 0; b < kISC_AREA_TABLE_BIN_COUNT; b++) {
+                area_tables_.disparity_tile_histogram[current + b] += area_tables_.disparity_tile_histogram[left + b] + area_tables_.disparity_tile_histogram[upper + b] - area_tables_.disparity_tile_histogram[upper_left + b];
+                area_tables_.distance_tile_histogram[current + b] += area_tables_.distance_tile_histogram[left + b] + area_tables_.distance_tile_histogram[upper + b] - area_tables_.distance_tile_histogram[upper_left + b];
+            }
         }
+    }
 
-        cv::Mat display_hist_data(histogram_data->buffer_size, 1, CV_32F, hist_data);
+    return DPC_E_OK;
+}
 
-        int hist_w = 512, hist_h = 400;
-        int bin_w = cvRound((double)hist_w / histogram_data->buffer_size);
-        cv::Mat histImage(hist_h, hist_w, CV_8UC3, cv::Scalar(0, 0, 0));
-        cv::normalize(display_hist_data, display_hist_data, 0, histImage.rows, cv::NORM_MINMAX, -1, cv::Mat());
+/**
+ * 集計表より矩形の和を取得します
+ *
+ * @param[in] table summed-area table
+ * @param[in] stride 1行の数
+ * @param[in] x0 左
+ * @param[in] y0 上
+ * @param[in] x1 右 (含まない)
+ * @param[in] y1 下 (含まない)
+ * @retval 和
+ */
+template <typename T>
+static inline T GetAreaTableSum(const T* table, const int stride, const int x0, const int y0, const int x1, const int y1)
+{
+    return table[(size_t)y1 * stride + x1] - table[(size_t)y0 * stride + x1] - table[(size_t)y1 * stride + x0] + table[(size_t)y0 * stride + x0];
+}
 
-        for (int i = 1; i < histogram_data->buffer_size; i++) {
-            line(histImage, cv::Point(bin_w * (i - 1), hist_h - cvRound(display_hist_data.at<float>(i - 1))),
-                cv::Point(bin_w * (i), hist_h - cvRound(display_hist_data.at<float>(i))),
-                cv::Scalar(255, 0, 0), 2, 8, 0);
-        }
-        imshow("Disparity Histogram of ROI", histImage);
-        cv::waitKey();
+/**
+ * 整数の和と二乗和より分散を取得します
+ *
+ * @param[in] count 件数
+ * @param[in] sum 和
+ * @param[in] square_sum 二乗和
+ * @retval 分散
+ * @note 桁あふれを避けるため、平均の整数部を引いた値で計算します
+ */
+static double GetAreaTableVariance(const __int64 count, const __int64 sum, const __int64 square_sum)
+{
+    if (count <= 0) {
+        return 0.0;
     }
 
+    // sum = a * count + b
+    const __int64 a = sum / count;
+    const __int64 b = sum % count;
 
-    // OpenCVを使ったサンプル
-#if 0
+    // Σ(x - a)^2 = square_sum - 2 * a * sum + a^2 * count
+    const __int64 shifted_square_sum = square_sum - a * a * count - 2 * a * b;
+    const double variance = ((double)shifted_square_sum - (double)b * (double)b / (double)count) / (double)count;
 
-    // 視差を 量子化します
-    //int hist_size= 256;
-    int hist_size = (int)(256.0 / 0.25);
+    return std::max(variance, 0.0);
+}
 
-    // 視差の範囲は 0 から 255 です．
-    float ranges[] = { 0.0F, 255.0F };
-    const float* hist_ranges[] = { ranges };
+/**
+ * Histogramより指定の順位の値を取得します
+ *
+ * @param[in] bins Histogram
+ * @param[in] edges Histogramの境界
+ * @param[in] rank 小さい方からの順位 (0~)
+ * @retval 値
+ * @note 範囲内では一様に分布しているとして補間します
+ */
+static float GetAreaTableRankValue(const int* bins, const float* edges, const __int64 rank)
+{
+    __int64 cumulative = 0;
 
-    cv::MatND hist;
-    // 0 番目のチャンネルからヒストグラムを求めます．
-    int channels[] = { 0 };
+    for (int i = 0; i < kISC_AREA_TABLE_BIN_COUNT; i++) {
+        if (bins[i] == 0) {
+            continue;
+        }
 
-    bool uniform = true, accumulate = false;
+        if (rank < cumulative + bins[i]) {
+            return edges[i] + (edges[i + 1] - edges[i]) * ((float)(rank - cumulative) + 0.5F) / (float)bins[i];
+        }
+        cumulative += bins[i];
+    }
 
-    cv::calcHist(
-        &src_data, 1, channels, cv::Mat(),  // マスクは利用しません
-        hist, 1, &hist_size, hist_ranges,
-        uniform,                            // ヒストグラムは一様です
-        accumulate);
+    return 0.0F;
+}
 
-    double max_val = 0;
-    cv::Point max_point = {};
+/**
+ * Histogramより中央値と最頻値を取得します
+ *
+ * @param[in] bins Histogram
+ * @param[in] edges Histogramの境界
+ * @param[in] count 値の数
+ * @param[out] median 中央値
+ * @param[out] mode 最頻値 (範囲の中央)
+ * @return none
+ */
+static void GetAreaTableMedianMode(const int* bins, const float* edges, const __int64 count, float* median, float* mode)
+{
+    *median = 0.0F;
+    *mode = 0.0F;
 
-    hist.at<float>(0) = 0;
-    cv:minMaxLoc(hist, 0, &max_val, 0, &max_point);
+    if (count <= 0) {
+        return;
+    }
 
-    // 最頻値
-    *max_frequency_value = max_point.y * 0.25;
-    
-    // (debug)Histogramの結果を表示する
-    bool show_cv_histo_image = false;
-    if (show_cv_histo_image) {
-        int hist_w = 512, hist_h = 400;
-        int bin_w = cvRound((double)hist_w / hist_size);
-        cv::Mat histImage(hist_h, hist_w, CV_8UC3, cv::Scalar(0, 0, 0));
-        cv::normalize(hist, hist, 0, histImage.rows, cv::NORM_MINMAX, -1, cv::Mat());
-
-        for (int i = 1; i < hist_size; i++)
-        {
-            line(histImage, cv::Point(bin_w * (i - 1), hist_h - cvRound(hist.at<float>(i - 1))),
-                cv::Point(bin_w * (i), hist_h - cvRound(hist.at<float>(i))),
-                cv::Scalar(255, 0, 0), 2, 8, 0);
-        }
-        imshow("calcHist Demo", histImage);
-        cv::waitKey();
+    if (count % 2 == 0) {
+        *median = (GetAreaTableRankValue(bins, edges, count / 2 - 1) + GetAreaTableRankValue(bins, edges, count / 2)) / 2.0F;
+    }
+    else {
+        *median = GetAreaTableRankValue(bins, edges, (count - 1) / 2);
     }
-#endif
 
-    return 0;
+    int max_frequency = 0;
+    for (int i = 0; i < kISC_AREA_TABLE_BIN_COUNT; i++) {
+        if (bins[i] > max_frequency) {
+            max_frequency = bins[i];
+            *mode = (edges[i] + edges[i + 1]) / 2.0F;
+        }
+    }
+
+    return;
 }
 
-int GetMaxDistanceValueInHistogram(cv::Mat src_data, const float min_valid_value, float* max_frequency_value, HistogramData* histogram_data)
+/**
+ * 集計表より矩形の情報を取得します
+ *
+ * @param[in] x 画像内座標左上(X)
+ * @param[in] y 画像内座標左上(Y)
+ * @param[in] width 幅
+ * @param[in] height 高さ
+ * @param[in] base_length 基線長
+ * @param[out] isc_data_statistics 領域の情報
+ * @return none
+ * @note 件数、平均、標準偏差は表より直接求めます
+ *       Histogramと最大最小は、Tileに揃う内側を表より、残りの縁を画素より求めます
+ */
+void IscMeasurement::GetAreaStatisticsFromTables(const int x, const int y, const int width, const int height, const float base_length, IscAreaDataStatistics* isc_data_statistics)
 {
-    // Histogram
-    /*
-        Histogramの最頻値を取得します
+    const int stride = area_tables_.width + 1;
+    const int x1 = x + width;
+    const int y1 = y + height;
+
+    // 件数、平均、標準偏差
+    const __int64 disparity_count = GetAreaTableSum(area_tables_.disparity_count, stride, x, y, x1, y1);
+    const __int64 disparity_sum = GetAreaTableSum(area_tables_.disparity_sum, stride, x, y, x1, y1);
+    const __int64 disparity_square_sum = GetAreaTableSum(area_tables_.disparity_square_sum, stride, x, y, x1, y1);
+
+    const __int64 distance_count = GetAreaTableSum(area_tables_.distance_count, stride, x, y, x1, y1);
+    const __int64 distance_sum = GetAreaTableSum(area_tables_.distance_sum, stride, x, y, x1, y1);
+    const __int64 distance_square_sum = GetAreaTableSum(area_tables_.distance_square_sum, stride, x, y, x1, y1);
+
+    // Histogramと最大最小
+    int disparity_histogram[kISC_AREA_TABLE_BIN_COUNT] = {};
+    int distance_histogram[kISC_AREA_TABLE_BIN_COUNT] = {};
+    float disparity_min = FLT_MAX, disparity_max = -FLT_MAX;
+    float distance_min = FLT_MAX, distance_max = -FLT_MAX;
+
+    // Tileに揃う内側
+    const int tile_x0 = (x + kISC_AREA_TABLE_TILE_SIZE - 1) / kISC_AREA_TABLE_TILE_SIZE;
+    const int tile_y0 = (y + kISC_AREA_TABLE_TILE_SIZE - 1) / kISC_AREA_TABLE_TILE_SIZE;
+    int tile_x1 = x1 / kISC_AREA_TABLE_TILE_SIZE;
+    int tile_y1 = y1 / kISC_AREA_TABLE_TILE_SIZE;
+    if ((tile_x0 >= tile_x1) || (tile_y0 >= tile_y1)) {
+        tile_x1 = tile_x0;
+        tile_y1 = tile_y0;
+    }
 
-        最大値により分解能を変更します
+    int inner_x0 = x1, inner_x1 = x1, inner_y0 = y1, inner_y1 = y1;
+    if (tile_x0 < tile_x1) {
+        inner_x0 = tile_x0 * kISC_AREA_TABLE_TILE_SIZE;
+        inner_x1 = tile_x1 * kISC_AREA_TABLE_TILE_SIZE;
+        inner_y0 = tile_y0 * kISC_AREA_TABLE_TILE_SIZE;
+        inner_y1 = tile_y1 * kISC_AREA_TABLE_TILE_SIZE;
+
+        const size_t tile_stride = (size_t)(area_tables_.tile_columns + 1) * kISC_AREA_TABLE_BIN_COUNT;
+        const size_t bottom_right = (size_t)tile_y1 * tile_stride + (size_t)tile_x1 * kISC_AREA_TABLE_BIN_COUNT;
+        const size_t top_right = (size_t)tile_y0 * tile_stride + (size_t)tile_x1 * kISC_AREA_TABLE_BIN_COUNT;
+        const size_t bottom_left = (size_t)tile_y1 * tile_stride + (size_t)tile_x0 * kISC_AREA_TABLE_BIN_COUNT;
+        const size_t top_left = (size_t)tile_y0 * tile_stride + (size_t)tile_x0 * kISC_AREA_TABLE_BIN_COUNT;
+
+        for (int b = 0; b < kISC_AREA_TABLE_BIN_COUNT; b++) {
+            const int* histogram = area_tables_.disparity_tile_histogram;
+            disparity_histogram[b] = histogram[bottom_right + b] - histogram[top_right + b] - histogram[bottom_left + b] + histogram[top_left + b];
+
+            histogram = area_tables_.distance_tile_histogram;
+            distance_histogram[b] = histogram[bottom_right + b] - histogram[top_right + b] - histogram[bottom_left + b] + histogram[top_left + b];
+        }
 
-        最大値　分解能
-        <10m    0.01m (10mm)
-        <100m   0.1m (100mm)
-        <1000m  1m
+        for (int ty = tile_y0; ty < tile_y1; ty++) {
+            for (int tx = tile_x0; tx < tile_x1; tx++) {
+                const int tile_index = ty * area_tables_.tile_columns + tx;
 
-    */
+                disparity_min = std::min(disparity_min, area_tables_.tile_disparity_min[tile_index]);
+                disparity_max = std::max(disparity_max, area_tables_.tile_disparity_max[tile_index]);
+                distance_min = std::min(distance_min, area_tables_.tile_distance_min[tile_index]);
+                distance_max = std::max(distance_max, area_tables_.tile_distance_max[tile_index]);
+            }
+        }
+    }
 
-    // 最大最小の取得
-    double minVal = 0;
-    double maxVal = 0;
-    cv::Point minLoc = {};
-    cv::Point maxLoc = {};
-        
-    cv::minMaxLoc(
-                    src_data,
-                    &minVal,
-                    &maxVal,
-                    &minLoc,
-                    &maxLoc);
-
-    if (maxVal > 1000.0) {
-        // 範囲外
-        *max_frequency_value = 0;
-        return -1;
+    // 縁
+    for (int i = y; i < y1; i++) {
+        const bool is_inner_row = (i >= inner_y0) && (i < inner_y1);
+        const size_t line = (size_t)i * area_tables_.width;
+
+        for (int j = x; j < x1; j++) {
+            if (is_inner_row && (j == inner_x0)) {
+                j = inner_x1 - 1;
+                continue;
+            }
+
+            const unsigned char disparity_bin = area_tables_.disparity_bin[line + j];
+            if (disparity_bin == kISC_AREA_TABLE_INVALID_BIN) {
+                continue;
+            }
+
+            const float disparity = area_tables_.disparity[line + j];
+            disparity_histogram[disparity_bin]++;
+            disparity_min = std::min(disparity_min, disparity);
+            disparity_max = std::max(disparity_max, disparity);
+
+            const unsigned char distance_bin = area_tables_.distance_bin[line + j];
+            if (distance_bin != kISC_AREA_TABLE_INVALID_BIN) {
+                const float distance = area_tables_.bf / (disparity - area_tables_.d_inf);
+                distance_histogram[distance_bin]++;
+                distance_min = std::min(distance_min, distance);
+                distance_max = std::max(distance_max, distance);
+            }
+        }
     }
 
-    double resolution = 1.0;
-    if (maxVal < 10.0) {
-        resolution = 100.0;
+    // 結果を設定
+    isc_data_statistics->x = x;
+    isc_data_statistics->y = y;
+    isc_data_statistics->width = width;
+    isc_data_statistics->height = height;
+
+    float disparity_median = 0.0F, disparity_mode = 0.0F;
+    if (disparity_count != 0) {
+        GetAreaTableMedianMode(disparity_histogram, area_tables_.disparity_bin_edges, disparity_count, &disparity_median, &disparity_mode);
+
+        isc_data_statistics->statistics_depth.max_value = disparity_max;
+        isc_data_statistics->statistics_depth.min_value = disparity_min;
+        isc_data_statistics->statistics_depth.std_dev = (float)(sqrt(GetAreaTableVariance(disparity_count, disparity_sum, disparity_square_sum)) / 256.0);
+        isc_data_statistics->statistics_depth.average = (float)((double)disparity_sum / (double)disparity_count / 256.0);
+        isc_data_statistics->statistics_depth.median = disparity_median;
+        isc_data_statistics->statistics_depth.mode = disparity_mode;
     }
-    else if (maxVal < 100.0) {
-        resolution = 10.0;
+    else {
+        isc_data_statistics->statistics_depth.max_value = 0;
+        isc_data_statistics->statistics_depth.min_value = 999;
     }
-    else if (maxVal < 1000.0) {
-        resolution = 1.0;
+
+    float distance_median = 0.0F, distance_mode = 0.0F;
+    if (distance_count != 0) {
+        GetAreaTableMedianMode(distance_histogram, area_tables_.distance_bin_edges, distance_count, &distance_median, &distance_mode);
+
+        isc_data_statistics->statistics_distance.max_value = distance_max;
+        isc_data_statistics->statistics_distance.min_value = distance_min;
+        isc_data_statistics->statistics_distance.std_dev = (float)(sqrt(GetAreaTableVariance(distance_count, distance_sum, distance_square_sum)) / 1000.0);
+        isc_data_statistics->statistics_distance.average = (float)((double)distance_sum / (double)distance_count / 1000.0);
+        isc_data_statistics->statistics_distance.median = distance_median;
+        isc_data_statistics->statistics_distance.mode = distance_mode;
+    }
+    else {
+        isc_data_statistics->statistics_distance.max_value = 0;
+        isc_data_statistics->statistics_distance.min_value = 99999;
     }
 
-    float* hist_data = histogram_data->histo_buffer;
-    memset(hist_data, 0, sizeof(float) * histogram_data->histo_buffer_size);
+    // 領域の大きさは最頻の距離で求めます (距離の範囲外のみの場合は、最頻の視差)
+    float roi_distance = 0.0F;
+    if (distance_mode > 0.0F) {
+        roi_distance = distance_mode;
+    }
+    else if (disparity_mode > area_tables_.d_inf) {
+        roi_distance = area_tables_.bf / (disparity_mode - area_tables_.d_inf);
+    }
 
-    for (int i = 0; i < src_data.rows; i++) {
-        float* src = src_data.ptr<float>(i);
+    if ((roi_distance > 0.0F) && (area_tables_.bf > 0.0F)) {
+        const float bd = base_length * roi_distance / area_tables_.bf;
+        isc_data_statistics->roi_3d.width = bd * width;
+        isc_data_statistics->roi_3d.height = bd * height;
+        isc_data_statistics->roi_3d.distance = roi_distance;
+    }
+    else {
+        isc_data_statistics->roi_3d.width = 0;
+        isc_data_statistics->roi_3d.height = 0;
+        isc_data_statistics->roi_3d.distance = 0;
+    }
 
-        for (int j = 0; j < src_data.cols; j++) {
-            int index = (int)(*src * (float)resolution);
-            if (index < histogram_data->histo_buffer_size) {
-                hist_data[index]++;
-            }
-            src++;
-        }
+    return;
+}
+
+/**
+ * 複数の領域の情報を一括して取得します
+ *
+ * @param[in] roi_count 領域の数
+ * @param[in] min_distance 有効な最小の距離(m)
+ * @param[in] max_distance 有効な最大の距離(m)
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_data_statistics 領域の情報 x,y,width,heightで領域を指定します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 視差画像全体の集計表を1回作成し、各領域は表から求めます
+ *       中央値と最頻値は、視差は2 pixel、距離は有効範囲を対数で128分割した範囲内を補間した値です
+ *       画像外の領域は、情報を0とします
+ */
+int IscMeasurement::GetAreaStatisticsBatch(const int roi_count, const float min_distance, const float max_distance, const IscImageInfo* isc_image_info, IscAreaDataStatistics* isc_data_statistics)
+{
+    if (isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
     }
 
-    // 無効分のデータをクリアする
-    int start = 0;
-    int end = (int)(min_valid_value + 0.5);
-    for (int i = start; i < end; i++) {
-        hist_data[i] = 0;
+    if (isc_data_statistics == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
     }
-    double max_histo_val = 0;
-    cv::Point max_histo_point = {};
-    cv::Mat src_hist_data(histogram_data->histo_buffer_size, 1, CV_32F, hist_data);
 
-    cv::minMaxLoc(src_hist_data, 0, &max_histo_val, 0, &max_histo_point);
+    if ((roi_count <= 0) || (max_distance <= min_distance)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
 
-    // 最頻値
-    *max_frequency_value = max_histo_point.y / (float)resolution;
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
 
-    // (debug)Histogramの結果を表示する
-    bool show_histo_image = false;
-    if (show_histo_image) {
-        // 分解能1でHistogramを作成して表示します
-        hist_data = histogram_data->buffer;
-        memset(hist_data, 0, sizeof(float) * histogram_data->buffer_size);
+    IscShutterMode shutter_mode = isc_image_info->shutter_mode;
 
-        for (int i = 0; i < src_data.rows; i++) {
-            float* src = src_data.ptr<float>(i);
+    if (shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
 
-            for (int j = 0; j < src_data.cols; j++) {
-                int index = (int)(*src * (float)resolution);
-                if (index < histogram_data->buffer_size) {
-                    hist_data[index]++;
-                }
-                src++;
-            }
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
         }
-        // 無効分のデータをクリアする
-        int start = 0;
-        int end = (int)(min_valid_value + 0.5);
-        for (int i = start; i < end; i++) {
-            hist_data[i] = 0;
+    }
+
+    const int image_width = isc_image_info->frame_data[fd_index].depth.width;
+    const int image_height = isc_image_info->frame_data[fd_index].depth.height;
+
+    if ((image_width <= 0) || (image_height <= 0)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (area_tables_.disparity_count == nullptr) {
+        int ret = AllocateAreaTables();
+        if (ret != DPC_E_OK) {
+            return ret;
         }
+    }
 
-        cv::Mat display_hist_data(histogram_data->buffer_size, 1, CV_32F, hist_data);
+    int ret = BuildAreaTables(isc_image_info->frame_data[fd_index].depth.image, image_width, image_height,
+                                isc_image_info->camera_specific_parameter.d_inf, isc_image_info->camera_specific_parameter.bf, min_distance, max_distance);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    for (int i = 0; i < roi_count; i++) {
+        IscAreaDataStatistics* statistics = &isc_data_statistics[i];
+
+        const int x = statistics->x;
+        const int y = statistics->y;
+        const int width = std::min(statistics->width, image_width - x);
+        const int height = std::min(statistics->height, image_height - y);
 
-        int hist_w = 512, hist_h = 400;
-        int bin_w = cvRound((double)hist_w / histogram_data->buffer_size);
-        cv::Mat histImage(hist_h, hist_w, CV_8UC3, cv::Scalar(0, 0, 0));
-        cv::normalize(display_hist_data, display_hist_data, 0, histImage.rows, cv::NORM_MINMAX, -1, cv::Mat());
+        memset(statistics, 0, sizeof(IscAreaDataStatistics));
+        statistics->x = x;
+        statistics->y = y;
+        statistics->min_distance = min_distance;
+        statistics->max_distance = max_distance;
 
-        for (int i = 1; i < histogram_data->buffer_size; i++) {
-            line(histImage, cv::Point(bin_w * (i - 1), hist_h - cvRound(display_hist_data.at<float>(i - 1))),
-                cv::Point(bin_w * (i), hist_h - cvRound(display_hist_data.at<float>(i))),
-                cv::Scalar(255, 0, 0), 2, 8, 0);
+        if ((x < 0) || (x >= image_width) || (y < 0) || (y >= image_height) || (width <= 0) || (height <= 0)) {
+            continue;
         }
-        imshow("Depth Histogram of ROI", histImage);
-        cv::waitKey();
+
+        GetAreaStatisticsFromTables(x, y, width, height, isc_image_info->camera_specific_parameter.base_length, statistics);
     }
 
-    return 0;
-}
\ No newline at end of file
+    return DPC_E_OK;
+}
@@ -0,0 +1,709 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_occupancy_grid.cpp
+ * @brief occupancy grid class
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ * 
+ * @details This class builds the occupancy grid and the voxel map from the block disparity.
+ * @note
+ *  - 画素に展開する前のBlock毎の視差を、Blockの中心の位置として地面の座標系へ投影します
+ *  - 地面の座標系は x:右 z:前方(地面に沿って) height:地面からの高さ です
+ *  - Blockの行をバンドに分割し、各バンドはThread毎の部分集計へ加算し、最後に統合します
+ *  - 統合時に前回までの値へdecayを掛けて加算します
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <math.h>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+#include "isc_band_worker.h"
+
+#include "isc_occupancy_grid.h"
+
+constexpr int kISC_OCCUPANCY_MAX_CELL_COUNT = 1024 * 1024;                          /**< Gridの最大のCell数 */
+constexpr int kISC_OCCUPANCY_VOXEL_TABLE_BITS = 18;                                 /**< Voxelのhash tableの大きさ (2^n) */
+constexpr int kISC_OCCUPANCY_VOXEL_TABLE_SIZE = 1 << kISC_OCCUPANCY_VOXEL_TABLE_BITS;
+constexpr int kISC_OCCUPANCY_MAX_VOXEL_COUNT = kISC_OCCUPANCY_VOXEL_TABLE_SIZE / 2;  /**< 保持する最大のVoxel数 */
+constexpr float kISC_OCCUPANCY_VOXEL_MIN_VALUE = 0.05F;                             /**< 減衰してこの値未満となったVoxelは削除します */
+constexpr int kISC_OCCUPANCY_VOXEL_INDEX_OFFSET = 1 << 20;                          /**< Voxelの位置 -2^20 ~ 2^20 - 1 */
+
+/**
+ * Voxelの位置をkeyにします
+ *
+ * @param[in] x 位置(X)
+ * @param[in] y 位置(Y)
+ * @param[in] z 位置(Z)
+ * @retval key
+ */
+static inline unsigned __int64 MakeVoxelKey(const int x, const int y, const int z)
+{
+    const unsigned __int64 ux = (unsigned __int64)(x + kISC_OCCUPANCY_VOXEL_INDEX_OFFSET) & 0x1FFFFF;
+    const unsigned __int64 uy = (unsigned __int64)(y + kISC_OCCUPANCY_VOXEL_INDEX_OFFSET) & 0x1FFFFF;
+    const unsigned __int64 uz = (unsigned __int64)(z + kISC_OCCUPANCY_VOXEL_INDEX_OFFSET) & 0x1FFFFF;
+
+    return (ux << 42) | (uy << 21) | uz;
+}
+
+/**
+ * keyからVoxelの位置を取得します
+ *
+ * @param[in] key key
+ * @param[out] voxel 位置
+ * @return none
+ */
+static inline void GetVoxelPosition(const unsigned __int64 key, IscVoxel* voxel)
+{
+    voxel->x = (int)((key >> 42) & 0x1FFFFF) - kISC_OCCUPANCY_VOXEL_INDEX_OFFSET;
+    voxel->y = (int)((key >> 21) & 0x1FFFFF) - kISC_OCCUPANCY_VOXEL_INDEX_OFFSET;
+    voxel->z = (int)(key & 0x1FFFFF) - kISC_OCCUPANCY_VOXEL_INDEX_OFFSET;
+
+    return;
+}
+
+/**
+ * keyのhashを取得します
+ *
+ * @param[in] key key
+ * @retval hash tableの位置
+ */
+static inline int GetVoxelHash(const unsigned __int64 key)
+{
+    return (int)((key * 0x9E3779B97F4A7C15ULL) >> (64 - kISC_OCCUPANCY_VOXEL_TABLE_BITS));
+}
+
+/**
+ * 位置が範囲内であることを確認します
+ *
+ * @param[in] value 位置
+ * @retval true 範囲内
+ */
+static inline bool IsVoxelIndexInRange(const float value)
+{
+    return (value >= (float)-kISC_OCCUPANCY_VOXEL_INDEX_OFFSET) && (value < (float)kISC_OCCUPANCY_VOXEL_INDEX_OFFSET);
+}
+
+/**
+ * constructor
+ *
+ */
+IscOccupancyGrid::IscOccupancyGrid():
+    band_worker_(nullptr),
+    grid_critical_(), parameter_(), cell_count_x_(0), cell_count_z_(0), occupied_(nullptr), ground_(nullptr), frame_time_(0), frame_index_(0),
+    voxel_table_(), voxel_table_index_(0), voxel_count_(0),
+    project_source_(), band_count_(0), band_job_(), max_block_count_(0)
+{
+    band_worker_ = new IscBandWorker;
+}
+
+
+/**
+ * destructor
+ *
+ */
+IscOccupancyGrid::~IscOccupancyGrid()
+{
+    delete band_worker_;
+    band_worker_ = nullptr;
+}
+
+/**
+ * クラスを初期化します
+ *
+ * @param[in] thread_count 投影に使用するスレッドの数 0:呼び出し元のスレッドで処理します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscOccupancyGrid::Initialize(const int thread_count)
+{
+    if ((thread_count < 0) || (thread_count > kMaxBandCount)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    InitializeCriticalSection(&grid_critical_);
+
+    // 既定値 無効
+    parameter_.enabled = false;
+    parameter_.camera_height = 1.0F;
+    parameter_.camera_pitch = 0.0F;
+    parameter_.cell_size = 0.1F;
+    parameter_.min_x = -5.0F;
+    parameter_.max_x = 5.0F;
+    parameter_.min_z = 0.0F;
+    parameter_.max_z = 20.0F;
+    parameter_.min_height = 0.1F;
+    parameter_.max_height = 2.0F;
+    parameter_.decay = 0.5F;
+    parameter_.build_voxel = false;
+    parameter_.voxel_size = 0.2F;
+
+    // workers
+    if (band_worker_->Initialize(thread_count, RunBand, this) != 0) {
+        return ISCDPL_E_FAIL;
+    }
+    band_count_ = band_worker_->GetBandCount();
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscOccupancyGrid::Terminate()
+{
+    band_worker_->Terminate();
+
+    ReleaseBuffers();
+
+    for (int i = 0; i < kMaxBandCount; i++) {
+        delete[] band_job_[i].voxel_keys;
+        band_job_[i].voxel_keys = nullptr;
+        band_job_[i].max_voxel_key_count = 0;
+    }
+    max_block_count_ = 0;
+
+    DeleteCriticalSection(&grid_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 配置のためにBand workerのスレッドのハンドルを取得します
+ *
+ * @param[in] max_count thread_handleの数
+ * @param[out] thread_handle ハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscOccupancyGrid::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+    if ((thread_handle == nullptr) || (thread_count == nullptr)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    band_worker_->GetThreadHandle(max_count, thread_handle, thread_count);
+
+    return DPC_E_OK;
+}
+
+/**
+ * Gridの領域を解放します
+ *
+ * @return none
+ */
+void IscOccupancyGrid::ReleaseBuffers()
+{
+    delete[] occupied_;
+    occupied_ = nullptr;
+
+    delete[] ground_;
+    ground_ = nullptr;
+
+    for (int i = 0; i < kMaxBandCount; i++) {
+        delete[] band_job_[i].occupied_hits;
+        band_job_[i].occupied_hits = nullptr;
+
+        delete[] band_job_[i].ground_hits;
+        band_job_[i].ground_hits = nullptr;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        delete[] voxel_table_[i];
+        voxel_table_[i] = nullptr;
+    }
+    voxel_table_index_ = 0;
+    voxel_count_ = 0;
+
+    cell_count_x_ = 0;
+    cell_count_z_ = 0;
+
+    return;
+}
+
+/**
+ * パラメータを設定します
+ *
+ * @param[in] isc_occupancy_grid_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Gridとvoxelは消去されます
+ */
+int IscOccupancyGrid::SetParameter(const IscOccupancyGridParameter* isc_occupancy_grid_parameter)
+{
+    if (isc_occupancy_grid_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscOccupancyGridParameter* parameter = isc_occupancy_grid_parameter;
+
+    if ((parameter->cell_size <= 0) || (parameter->max_x <= parameter->min_x) || (parameter->max_z <= parameter->min_z) ||
+        (parameter->max_height <= parameter->min_height) || (parameter->decay < 0) || (parameter->decay > 1.0F)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (parameter->build_voxel && (parameter->voxel_size <= 0)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const double cell_count_x = ceil((double)(parameter->max_x - parameter->min_x) / parameter->cell_size);
+    const double cell_count_z = ceil((double)(parameter->max_z - parameter->min_z) / parameter->cell_size);
+    if ((cell_count_x * cell_count_z) > kISC_OCCUPANCY_MAX_CELL_COUNT) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&grid_critical_);
+
+    ReleaseBuffers();
+
+    parameter_ = *parameter;
+
+    if (parameter_.enabled) {
+        cell_count_x_ = (int)cell_count_x;
+        cell_count_z_ = (int)cell_count_z;
+        const int cell_count = cell_count_x_ * cell_count_z_;
+
+        occupied_ = new float[cell_count];
+        ground_ = new float[cell_count];
+        memset(occupied_, 0, sizeof(float) * cell_count);
+        memset(ground_, 0, sizeof(float) * cell_count);
+
+        for (int i = 0; i < band_count_; i++) {
+            band_job_[i].occupied_hits = new int[cell_count];
+            band_job_[i].ground_hits = new int[cell_count];
+        }
+
+        if (parameter_.build_voxel) {
+            for (int i = 0; i < 2; i++) {
+                voxel_table_[i] = new VoxelSlot[kISC_OCCUPANCY_VOXEL_TABLE_SIZE];
+                memset(voxel_table_[i], 0, sizeof(VoxelSlot) * kISC_OCCUPANCY_VOXEL_TABLE_SIZE);
+            }
+        }
+    }
+
+    frame_time_ = 0;
+    frame_index_ = 0;
+
+    LeaveCriticalSection(&grid_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * パラメータを取得します
+ *
+ * @param[out] isc_occupancy_grid_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscOccupancyGrid::GetParameter(IscOccupancyGridParameter* isc_occupancy_grid_parameter)
+{
+    if (isc_occupancy_grid_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&grid_critical_);
+    *isc_occupancy_grid_parameter = parameter_;
+    LeaveCriticalSection(&grid_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * Voxelの記録の領域を確保します
+ *
+ * @param[in] block_count Blockの数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscOccupancyGrid::AllocateBandBuffers(const int block_count)
+{
+    if (block_count <= max_block_count_) {
+        return DPC_E_OK;
+    }
+
+    for (int i = 0; i < band_count_; i++) {
+        delete[] band_job_[i].voxel_keys;
+        band_job_[i].voxel_keys = new unsigned __int64[block_count];
+        band_job_[i].max_voxel_key_count = block_count;
+    }
+    max_block_count_ = block_count;
+
+    return DPC_E_OK;
+}
+
+/**
+ * Block毎の視差をGridへ追加します
+ *
+ * @param[in] isc_image_info データ構造体
+ * @param[in] isc_block_disparity_data Block毎の視差
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理Threadから呼び出されます
+ */
+int IscOccupancyGrid::Update(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data)
+{
+    if (isc_image_info == nullptr || isc_block_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscBlockDisparityData* block_data = isc_block_disparity_data;
+    if (block_data->image_width <= 0 || block_data->image_height <= 0 ||
+        block_data->blkwdt <= 0 || block_data->blkhgt <= 0 || block_data->pblkdsp == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&grid_critical_);
+
+    if (!parameter_.enabled || occupied_ == nullptr) {
+        LeaveCriticalSection(&grid_critical_);
+        return DPC_E_OK;
+    }
+
+    const int block_count_x = block_data->image_width / block_data->blkwdt;
+    const int block_count_y = block_data->image_height / block_data->blkhgt;
+    AllocateBandBuffers(block_count_x * block_count_y);
+
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+    if (isc_image_info->shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
+
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+        }
+    }
+
+    constexpr double pi = 3.14159265358979323846;
+    const double pitch = parameter_.camera_pitch * pi / 180.0;
+
+    ProjectSource* source = &project_source_;
+    source->block_disparity = block_data->pblkdsp;
+    source->block_width = block_data->blkwdt;
+    source->block_height = block_data->blkhgt;
+    source->block_count_x = block_count_x;
+    source->d_inf = isc_image_info->camera_specific_parameter.d_inf;
+    source->bf = isc_image_info->camera_specific_parameter.bf;
+    source->base_length = isc_image_info->camera_specific_parameter.base_length;
+    source->center_x = (float)(block_data->image_width / 2);
+    source->center_y = (float)(block_data->image_height / 2);
+    source->cos_pitch = (float)cos(pitch);
+    source->sin_pitch = (float)sin(pitch);
+    source->parameter = parameter_;
+    source->cell_count_x = cell_count_x_;
+    source->cell_count_z = cell_count_z_;
+
+    // バンドに分割
+    int row_start[kMaxBandCount] = {};
+    int row_end[kMaxBandCount] = {};
+    const int used_band_count = band_worker_->SplitRows(block_count_y, row_start, row_end);
+
+    for (int i = 0; i < used_band_count; i++) {
+        band_job_[i].block_row_start = row_start[i];
+        band_job_[i].block_row_end = row_end[i];
+    }
+
+    band_worker_->Run(used_band_count);
+
+    MergeBands(used_band_count);
+
+    frame_time_ = isc_image_info->frame_data[fd_index].frame_time;
+    frame_index_ = isc_image_info->frame_data[fd_index].frameNo;
+
+    LeaveCriticalSection(&grid_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のGridを取得します
+ *
+ * @param[in,out] isc_occupancy_grid_data Grid バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscOccupancyGrid::GetGrid(IscOccupancyGridData* isc_occupancy_grid_data)
+{
+    if (isc_occupancy_grid_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&grid_critical_);
+
+    if (occupied_ == nullptr) {
+        LeaveCriticalSection(&grid_critical_);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    const int cell_count = cell_count_x_ * cell_count_z_;
+    if (isc_occupancy_grid_data->max_cell_count < cell_count) {
+        LeaveCriticalSection(&grid_critical_);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_occupancy_grid_data->occupied != nullptr) {
+        memcpy(isc_occupancy_grid_data->occupied, occupied_, sizeof(float) * cell_count);
+    }
+    if (isc_occupancy_grid_data->ground != nullptr) {
+        memcpy(isc_occupancy_grid_data->ground, ground_, sizeof(float) * cell_count);
+    }
+    isc_occupancy_grid_data->cell_count_x = cell_count_x_;
+    isc_occupancy_grid_data->cell_count_z = cell_count_z_;
+    isc_occupancy_grid_data->frame_time = frame_time_;
+    isc_occupancy_grid_data->frame_index = frame_index_;
+
+    LeaveCriticalSection(&grid_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のVoxelを取得します
+ *
+ * @param[in,out] isc_voxel_map_data Voxel バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note max_voxel_countを超えるVoxelは取得しません
+ */
+int IscOccupancyGrid::GetVoxelMap(IscVoxelMapData* isc_voxel_map_data)
+{
+    if (isc_voxel_map_data == nullptr || isc_voxel_map_data->voxels == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&grid_critical_);
+
+    const VoxelSlot* table = voxel_table_[voxel_table_index_];
+    if (table == nullptr) {
+        LeaveCriticalSection(&grid_critical_);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    int count = 0;
+    for (int i = 0; (i < kISC_OCCUPANCY_VOXEL_TABLE_SIZE) && (count < isc_voxel_map_data->max_voxel_count); i++) {
+        if (table[i].value > 0) {
+            IscVoxel* voxel = &isc_voxel_map_data->voxels[count];
+            GetVoxelPosition(table[i].key, voxel);
+            voxel->value = table[i].value;
+            count++;
+        }
+    }
+
+    isc_voxel_map_data->voxel_count = count;
+    isc_voxel_map_data->voxel_size = parameter_.voxel_size;
+    isc_voxel_map_data->frame_time = frame_time_;
+    isc_voxel_map_data->frame_index = frame_index_;
+
+    LeaveCriticalSection(&grid_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 1バンドを投影します
+ *
+ * @param[in] context IscOccupancyGrid
+ * @param[in] band_index バンド
+ * @return none
+ * @note IscBandWorkerのスレッドから呼び出されます
+ */
+void IscOccupancyGrid::RunBand(void* context, const int band_index)
+{
+    IscOccupancyGrid* owner = (IscOccupancyGrid*)context;
+
+    ProjectBand(&owner->project_source_, &owner->band_job_[band_index]);
+
+    return;
+}
+
+/**
+ * 1バンドのBlockを投影し、Threadの部分集計へ加算します
+ *
+ * @param[in] source 投影の条件
+ * @param[in,out] job バンド
+ * @return none
+ */
+void IscOccupancyGrid::ProjectBand(const ProjectSource* source, BandJob* job)
+{
+    const IscOccupancyGridParameter* parameter = &source->parameter;
+    const int cell_count = source->cell_count_x * source->cell_count_z;
+    const float cell_mag = 1.0F / parameter->cell_size;
+    const float voxel_mag = parameter->build_voxel ? 1.0F / parameter->voxel_size : 0.0F;
+    const bool is_voxel = parameter->build_voxel && (job->voxel_keys != nullptr);
+
+    memset(job->occupied_hits, 0, sizeof(int) * cell_count);
+    memset(job->ground_hits, 0, sizeof(int) * cell_count);
+    job->voxel_key_count = 0;
+
+    for (int by = job->block_row_start; by < job->block_row_end; by++) {
+        const float* src = source->block_disparity + ((size_t)by * source->block_count_x);
+        const float y_offset = source->center_y - (((float)by + 0.5F) * source->block_height);
+
+        for (int bx = 0; bx < source->block_count_x; bx++) {
+            const float value = src[bx] - source->d_inf;
+            if (!(value > 0)) {
+                continue;
+            }
+
+            // カメラの座標 x:右 y:上 z:前方
+            const float bd = source->base_length / value;
+            const float z = source->bf / value;
+            const float x = ((((float)bx + 0.5F) * source->block_width) - source->center_x) * bd;
+            const float y = y_offset * bd;
+
+            // 地面の座標
+            const float height = parameter->camera_height + (y * source->cos_pitch) - (z * source->sin_pitch);
+            const float forward = (z * source->cos_pitch) + (y * source->sin_pitch);
+
+            if (height > parameter->max_height) {
+                continue;
+            }
+
+            const float cell_x = (x - parameter->min_x) * cell_mag;
+            const float cell_z = (forward - parameter->min_z) * cell_mag;
+            if ((cell_x >= 0) && (cell_x < source->cell_count_x) && (cell_z >= 0) && (cell_z < source->cell_count_z)) {
+                const int index = ((int)cell_z * source->cell_count_x) + (int)cell_x;
+                if (height >= parameter->min_height) {
+                    job->occupied_hits[index]++;
+                }
+                else {
+                    job->ground_hits[index]++;
+                }
+            }
+
+            if (is_voxel && (job->voxel_key_count < job->max_voxel_key_count)) {
+                const float voxel_x = floorf(x * voxel_mag);
+                const float voxel_y = floorf(height * voxel_mag);
+                const float voxel_z = floorf(forward * voxel_mag);
+
+                if (IsVoxelIndexInRange(voxel_x) && IsVoxelIndexInRange(voxel_y) && IsVoxelIndexInRange(voxel_z)) {
+                    job->voxel_keys[job->voxel_key_count] = MakeVoxelKey((int)voxel_x, (int)voxel_y, (int)voxel_z);
+                    job->voxel_key_count++;
+                }
+            }
+        }
+    }
+
+    return;
+}
+
+/**
+ * Voxelを追加します
+ *
+ * @param[in,out] table hash table
+ * @param[in] key key
+ * @param[in] value 加算する値
+ * @return none
+ * @note 保持できる数を超えた新しいVoxelは追加しません
+ */
+void IscOccupancyGrid::InsertVoxel(VoxelSlot* table, const unsigned __int64 key, const float value)
+{
+    int index = GetVoxelHash(key);
+
+    for (;;) {
+        VoxelSlot* slot = &table[index];
+
+        if (slot->value <= 0) {
+            if (voxel_count_ >= kISC_OCCUPANCY_MAX_VOXEL_COUNT) {
+                return;
+            }
+            slot->key = key;
+            slot->value = value;
+            voxel_count_++;
+            return;
+        }
+
+        if (slot->key == key) {
+            slot->value += value;
+            return;
+        }
+
+        index = (index + 1) & (kISC_OCCUPANCY_VOXEL_TABLE_SIZE - 1);
+    }
+}
+
+/**
+ * Threadの部分集計を統合します
+ *
+ * @param[in] band_count バンドの数
+ * @return none
+ * @note 前回までの値にはdecayを掛けます
+ */
+void IscOccupancyGrid::MergeBands(const int band_count)
+{
+    const float decay = parameter_.decay;
+    const int cell_count = cell_count_x_ * cell_count_z_;
+
+    for (int i = 0; i < cell_count; i++) {
+        float occupied = occupied_[i] * decay;
+        float ground = ground_[i] * decay;
+
+        for (int b = 0; b < band_count; b++) {
+            occupied += (float)band_job_[b].occupied_hits[i];
+            ground += (float)band_job_[b].ground_hits[i];
+        }
+
+        occupied_[i] = occupied;
+        ground_[i] = ground;
+    }
+
+    if (!parameter_.build_voxel || voxel_table_[0] == nullptr) {
+        return;
+    }
+
+    // 減衰させた前回のVoxelと、今回のVoxelを別のtableへ作成します
+    const VoxelSlot* previous_table = voxel_table_[voxel_table_index_];
+    VoxelSlot* table = voxel_table_[1 - voxel_table_index_];
+
+    memset(table, 0, sizeof(VoxelSlot) * kISC_OCCUPANCY_VOXEL_TABLE_SIZE);
+    voxel_count_ = 0;
+
+    for (int i = 0; i < kISC_OCCUPANCY_VOXEL_TABLE_SIZE; i++) {
+        if (previous_table[i].value > 0) {
+            const float value = previous_table[i].value * decay;
+            if (value >= kISC_OCCUPANCY_VOXEL_MIN_VALUE) {
+                InsertVoxel(table, previous_table[i].key, value);
+            }
+        }
+    }
+
+    for (int b = 0; b < band_count; b++) {
+        const BandJob* job = &band_job_[b];
+
+        for (int i = 0; i < job->voxel_key_count; i++) {
+            InsertVoxel(table, job->voxel_keys[i], 1.0F);
+        }
+    }
+
+    voxel_table_index_ = 1 - voxel_table_index_;
+
+    return;
+}
@@ -0,0 +1,753 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_point_cloud.cpp
+ * @brief point cloud class
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ * 
+ * @details This class converts the disparity to the point cloud.
+ * @note
+ *  - 座標はGetPosition3D()と同じく、画像中央を原点に x:右 y:上 z:前方 です (ROSの軸では x:前方 y:左 z:上)
+ *  - 行をバンドに分割し、各バンドを1つのスレッドで変換します。バンドは間引き後の格子の位置に書き込み、最後に詰めます
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <limits>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+#include "isc_band_worker.h"
+
+#include "isc_point_cloud.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define ISC_POINT_CLOUD_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+constexpr int kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT = 64 * 1024;     /**< ファイルへ一度に書き込む点の数 */
+constexpr int kISC_POINT_CLOUD_PLY_POINT_SIZE = (sizeof(float) * 3) + 3; /**< PLYの1点の大きさ x,y,z,r,g,b */
+
+/**
+ * constructor
+ *
+ */
+IscPointCloud::IscPointCloud():
+    max_width_(0), max_height_(0),
+    convert_critical_(), band_worker_(nullptr), convert_source_(), convert_destination_(nullptr), band_job_(),
+    save_points_(nullptr), save_buffer_(nullptr)
+{
+    InitializeCriticalSection(&convert_critical_);
+    band_worker_ = new IscBandWorker;
+}
+
+/**
+ * destructor
+ *
+ */
+IscPointCloud::~IscPointCloud()
+{
+    delete band_worker_;
+    band_worker_ = nullptr;
+
+    DeleteCriticalSection(&convert_critical_);
+}
+
+/**
+ * クラスを初期化します
+ *
+ * @param[in] thread_count 変換に使用するスレッドの数 0:呼び出し元のスレッドで変換します
+ * @param[in] max_width 最大の幅
+ * @param[in] max_height 最大の高さ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscPointCloud::Initialize(const int thread_count, const int max_width, const int max_height)
+{
+    Terminate();
+
+    if ((thread_count < 0) || (thread_count > kMaxBandCount) || (max_width < 0) || (max_height < 0)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&convert_critical_);
+
+    max_width_ = max_width;
+    max_height_ = max_height;
+
+    // workers
+    int ret = band_worker_->Initialize(thread_count, RunBand, this);
+
+    LeaveCriticalSection(&convert_critical_);
+
+    if (ret != 0) {
+        Terminate();
+        return ISCDPL_E_FAIL;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscPointCloud::Terminate()
+{
+    EnterCriticalSection(&convert_critical_);
+
+    band_worker_->Terminate();
+
+    delete[] save_buffer_;
+    save_buffer_ = nullptr;
+
+    delete[] save_points_;
+    save_points_ = nullptr;
+
+    max_width_ = 0;
+    max_height_ = 0;
+
+    LeaveCriticalSection(&convert_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 配置のためにBand workerのスレッドのハンドルを取得します
+ *
+ * @param[in] max_count thread_handleの数
+ * @param[out] thread_handle ハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscPointCloud::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+    if ((thread_handle == nullptr) || (thread_count == nullptr)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    band_worker_->GetThreadHandle(max_count, thread_handle, thread_count);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 視差を点群に変換します
+ *
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_point_cloud_data 点群 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note バッファーは間引き後の格子の全点(有効な点のみの場合も)を保持できる大きさが必要です
+ */
+int IscPointCloud::Convert(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data)
+{
+    EnterCriticalSection(&convert_critical_);
+    int ret = ConvertPoints(isc_point_cloud_parameter, isc_image_info, isc_point_cloud_data);
+    LeaveCriticalSection(&convert_critical_);
+
+    return ret;
+}
+
+/**
+ * 視差を点群に変換します
+ *
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_image_info データ構造体
+ * @param[in,out] isc_point_cloud_data 点群 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note convert_critical_ 内で呼び出します
+ */
+int IscPointCloud::ConvertPoints(const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info, IscPointCloudData* isc_point_cloud_data)
+{
+    if (isc_point_cloud_parameter == nullptr || isc_image_info == nullptr || isc_point_cloud_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    isc_point_cloud_data->point_count = 0;
+    isc_point_cloud_data->width = 0;
+    isc_point_cloud_data->height = 0;
+
+    if ((isc_point_cloud_parameter->decimation < 1) || (isc_point_cloud_parameter->max_distance <= isc_point_cloud_parameter->min_distance)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscPointCloudLayout layout = isc_point_cloud_parameter->layout;
+    if (layout == IscPointCloudLayout::kArrayOfStructures) {
+        if (isc_point_cloud_data->points == nullptr) {
+            return ISCDPL_E_INVALID_PARAMETER;
+        }
+    }
+    else {
+        if ((isc_point_cloud_data->x == nullptr) || (isc_point_cloud_data->y == nullptr) || (isc_point_cloud_data->z == nullptr)) {
+            return ISCDPL_E_INVALID_PARAMETER;
+        }
+    }
+
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+
+    IscShutterMode shutter_mode = isc_image_info->shutter_mode;
+
+    if (shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
+
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+        }
+    }
+
+    const IscImageInfo::FrameData* frame_data = &isc_image_info->frame_data[fd_index];
+    const int image_width = frame_data->depth.width;
+    const int image_height = frame_data->depth.height;
+
+    if ((image_width <= 0) || (image_height <= 0) || (frame_data->depth.image == nullptr)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    // 対象の領域
+    const int roi_x = isc_point_cloud_parameter->roi_x;
+    const int roi_y = isc_point_cloud_parameter->roi_y;
+    if ((roi_x < 0) || (roi_x >= image_width) || (roi_y < 0) || (roi_y >= image_height)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    int roi_width = image_width - roi_x;
+    if (isc_point_cloud_parameter->roi_width > 0) {
+        roi_width = (std::min)(isc_point_cloud_parameter->roi_width, roi_width);
+    }
+    int roi_height = image_height - roi_y;
+    if (isc_point_cloud_parameter->roi_height > 0) {
+        roi_height = (std::min)(isc_point_cloud_parameter->roi_height, roi_height);
+    }
+
+    const int decimation = isc_point_cloud_parameter->decimation;
+    const int sampled_width = (roi_width + decimation - 1) / decimation;
+    const int sampled_height = (roi_height + decimation - 1) / decimation;
+
+    if (isc_point_cloud_data->max_point_count < sampled_width * sampled_height) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    // 色は基準側のカラー画像、無ければ基準側画像より取得します
+    ConvertSource* source = &convert_source_;
+    source->color = nullptr;
+    source->color_width = 0;
+    source->color_channel_count = 0;
+
+    const bool has_rgb_buffer = (layout == IscPointCloudLayout::kArrayOfStructures) || (isc_point_cloud_data->rgb != nullptr);
+    if (isc_point_cloud_parameter->with_color && has_rgb_buffer) {
+        if ((frame_data->color.image != nullptr) && (frame_data->color.width == image_width) && (frame_data->color.height == image_height) && (frame_data->color.channel_count >= 3)) {
+            source->color = frame_data->color.image;
+            source->color_width = frame_data->color.width;
+            source->color_channel_count = frame_data->color.channel_count;
+        }
+        else if ((frame_data->p1.image != nullptr) && (frame_data->p1.width == image_width) && (frame_data->p1.height == image_height)) {
+            source->color = frame_data->p1.image;
+            source->color_width = frame_data->p1.width;
+            source->color_channel_count = frame_data->p1.channel_count;
+        }
+    }
+
+    source->depth = frame_data->depth.image;
+    source->depth_width = image_width;
+    source->roi_x = roi_x;
+    source->roi_y = roi_y;
+    source->decimation = decimation;
+    source->sampled_width = sampled_width;
+    source->d_inf = isc_image_info->camera_specific_parameter.d_inf;
+    source->bf = isc_image_info->camera_specific_parameter.bf;
+    source->base_length = isc_image_info->camera_specific_parameter.base_length;
+    source->center_x = (float)(image_width / 2);
+    source->center_y = (float)(image_height / 2);
+    source->min_distance = isc_point_cloud_parameter->min_distance;
+    source->max_distance = isc_point_cloud_parameter->max_distance;
+    source->is_organized = isc_point_cloud_parameter->is_organized;
+    source->is_ros_axis = isc_point_cloud_parameter->is_ros_axis;
+    source->layout = layout;
+
+    // バンドに分割
+    int row_start[kMaxBandCount] = {};
+    int row_end[kMaxBandCount] = {};
+    const int used_band_count = band_worker_->SplitRows(sampled_height, row_start, row_end);
+
+    for (int i = 0; i < used_band_count; i++) {
+        band_job_[i].row_start = row_start[i];
+        band_job_[i].row_end = row_end[i];
+        band_job_[i].point_offset = row_start[i] * sampled_width;
+        band_job_[i].point_count = 0;
+    }
+
+    convert_destination_ = isc_point_cloud_data;
+
+    if (band_worker_->Run(used_band_count) != 0) {
+        return ISCDPL_E_FAIL;
+    }
+
+    // 有効な点のみの場合は、バンドの結果を詰めます
+    int point_count = 0;
+    for (int i = 0; i < used_band_count; i++) {
+        const BandJob* job = &band_job_[i];
+
+        if ((job->point_offset != point_count) && (job->point_count > 0)) {
+            if (layout == IscPointCloudLayout::kArrayOfStructures) {
+                memmove(&isc_point_cloud_data->points[point_count], &isc_point_cloud_data->points[job->point_offset], sizeof(IscPointXYZRGB) * job->point_count);
+            }
+            else {
+                memmove(&isc_point_cloud_data->x[point_count], &isc_point_cloud_data->x[job->point_offset], sizeof(float) * job->point_count);
+                memmove(&isc_point_cloud_data->y[point_count], &isc_point_cloud_data->y[job->point_offset], sizeof(float) * job->point_count);
+                memmove(&isc_point_cloud_data->z[point_count], &isc_point_cloud_data->z[job->point_offset], sizeof(float) * job->point_count);
+                if (isc_point_cloud_data->rgb != nullptr) {
+                    memmove(&isc_point_cloud_data->rgb[point_count], &isc_point_cloud_data->rgb[job->point_offset], sizeof(unsigned int) * job->point_count);
+                }
+            }
+        }
+        point_count += job->point_count;
+    }
+
+    isc_point_cloud_data->point_count = point_count;
+    if (isc_point_cloud_parameter->is_organized) {
+        isc_point_cloud_data->width = sampled_width;
+        isc_point_cloud_data->height = sampled_height;
+    }
+    else {
+        isc_point_cloud_data->width = point_count;
+        isc_point_cloud_data->height = 1;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 視差を点群に変換し、ファイルに書き込みます
+ *
+ * @param[in] file_name ファイル名
+ * @param[in] file_format ファイルの形式
+ * @param[in] isc_point_cloud_parameter 変換の条件 layoutは使用しません
+ * @param[in] isc_image_info データ構造体
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note PLYには有効な点のみを書き込みます
+ */
+int IscPointCloud::SaveFile(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info)
+{
+    if (file_name == nullptr || isc_point_cloud_parameter == nullptr || isc_image_info == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&convert_critical_);
+    int ret = SavePoints(file_name, file_format, isc_point_cloud_parameter, isc_image_info);
+    LeaveCriticalSection(&convert_critical_);
+
+    return ret;
+}
+
+/**
+ * 視差を点群に変換し、ファイルに書き込みます
+ *
+ * @param[in] file_name ファイル名
+ * @param[in] file_format ファイルの形式
+ * @param[in] isc_point_cloud_parameter 変換の条件 layoutは使用しません
+ * @param[in] isc_image_info データ構造体
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note convert_critical_ 内で呼び出します
+ */
+int IscPointCloud::SavePoints(const wchar_t* file_name, const IscPointCloudFileFormat file_format, const IscPointCloudParameter* isc_point_cloud_parameter, const IscImageInfo* isc_image_info)
+{
+    if ((max_width_ <= 0) || (max_height_ <= 0)) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    // 書き込み用の領域は初回に確保します
+    const int max_point_count = max_width_ * max_height_;
+    if (save_points_ == nullptr) {
+        save_points_ = new IscPointXYZRGB[max_point_count];
+        save_buffer_ = new unsigned char[(size_t)kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT * sizeof(IscPointXYZRGB)];
+    }
+
+    IscPointCloudParameter parameter = *isc_point_cloud_parameter;
+    parameter.layout = IscPointCloudLayout::kArrayOfStructures;
+    if (file_format == IscPointCloudFileFormat::kPlyBinary) {
+        parameter.is_organized = false;
+    }
+
+    IscPointCloudData point_cloud_data = {};
+    point_cloud_data.max_point_count = max_point_count;
+    point_cloud_data.points = save_points_;
+
+    int ret = ConvertPoints(&parameter, isc_image_info, &point_cloud_data);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    HANDLE handle_file = CreateFileW(file_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE) {
+        return CAMCONTROL_E_CREATE_SAVE_FILE;
+    }
+
+    if (file_format == IscPointCloudFileFormat::kPlyBinary) {
+        ret = WritePly(handle_file, &parameter, &point_cloud_data);
+    }
+    else {
+        ret = WritePcd(handle_file, &parameter, &point_cloud_data);
+    }
+
+    CloseHandle(handle_file);
+
+    return ret;
+}
+
+/**
+ * 1バンドを変換します
+ *
+ * @param[in] context IscPointCloud
+ * @param[in] band_index バンド
+ * @return none
+ * @note IscBandWorkerのスレッドから呼び出されます
+ */
+void IscPointCloud::RunBand(void* context, const int band_index)
+{
+    IscPointCloud* owner = (IscPointCloud*)context;
+
+    ConvertBand(&owner->convert_source_, &owner->band_job_[band_index], owner->convert_destination_);
+
+    return;
+}
+
+/**
+ * 色を取得します
+ *
+ * @param[in] color_line 色の行 (nullptr:無し)
+ * @param[in] channel_count チャンネル数 3以上はBGR
+ * @param[in] x 画像内座標(X)
+ * @retval 0x00RRGGBB
+ */
+static inline unsigned int GetPointColor(const unsigned char* color_line, const int channel_count, const int x)
+{
+    if (color_line == nullptr) {
+        return 0;
+    }
+
+    if (channel_count >= 3) {
+        // BGR
+        const unsigned char* pixel = color_line + (x * channel_count);
+        return ((unsigned int)pixel[2] << 16) | ((unsigned int)pixel[1] << 8) | (unsigned int)pixel[0];
+    }
+
+    const unsigned int value = color_line[x];
+    return (value << 16) | (value << 8) | value;
+}
+
+/**
+ * 1点を書き込みます
+ *
+ * @param[in] is_ros_axis ROSの軸に変換する
+ * @param[in] layout 配置
+ * @param[in] index 位置
+ * @param[in] x 座標(m) 右
+ * @param[in] y 座標(m) 上
+ * @param[in] z 座標(m) 前方
+ * @param[in] rgb 色
+ * @param[out] destination 点群
+ * @return none
+ */
+static inline void WritePoint(const bool is_ros_axis, const IscPointCloudLayout layout, const int index, const float x, const float y, const float z, const unsigned int rgb, IscPointCloudData* destination)
+{
+    // ROS: (x, y, z) = (前方, 左, 上)
+    const float px = is_ros_axis ? z : x;
+    const float py = is_ros_axis ? -x : y;
+    const float pz = is_ros_axis ? y : z;
+
+    if (layout == IscPointCloudLayout::kArrayOfStructures) {
+        IscPointXYZRGB* point = &destination->points[index];
+        point->x = px;
+        point->y = py;
+        point->z = pz;
+        point->rgb = rgb;
+    }
+    else {
+        destination->x[index] = px;
+        destination->y[index] = py;
+        destination->z[index] = pz;
+        if (destination->rgb != nullptr) {
+            destination->rgb[index] = rgb;
+        }
+    }
+
+    return;
+}
+
+/**
+ * 1バンドを変換します
+ *
+ * @param[in] source 変換の条件
+ * @param[in,out] job バンド
+ * @param[out] destination 点群
+ * @return none
+ * @note 間引きが無い場合は、4画素ずつSSE2で座標を計算します
+ */
+void IscPointCloud::ConvertBand(const ConvertSource* source, BandJob* job, IscPointCloudData* destination)
+{
+    const float invalid = std::numeric_limits<float>::quiet_NaN();
+    const bool is_organized = source->is_organized;
+    const bool is_ros_axis = source->is_ros_axis;
+    const IscPointCloudLayout layout = source->layout;
+
+    int index = job->point_offset;
+
+    for (int r = job->row_start; r < job->row_end; r++) {
+        const int i = source->roi_y + (r * source->decimation);
+        const float* src = source->depth + ((size_t)i * source->depth_width);
+        const unsigned char* color_line = (source->color != nullptr) ? source->color + ((size_t)i * source->color_width * source->color_channel_count) : nullptr;
+        const float y_offset = source->center_y - (float)i;
+
+        int c = 0;
+
+#ifdef ISC_POINT_CLOUD_USE_SSE2
+        if (source->decimation == 1) {
+            const __m128 d_inf = _mm_set1_ps(source->d_inf);
+            const __m128 bf = _mm_set1_ps(source->bf);
+            const __m128 base_length = _mm_set1_ps(source->base_length);
+            const __m128 min_distance = _mm_set1_ps(source->min_distance);
+            const __m128 max_distance = _mm_set1_ps(source->max_distance);
+            const __m128 one = _mm_set1_ps(1.0F);
+            const __m128 lane_offset = _mm_set_ps(3.0F, 2.0F, 1.0F, 0.0F);
+            const __m128 y_offset_ps = _mm_set1_ps(y_offset);
+
+            float lane_x[4] = {}, lane_y[4] = {}, lane_z[4] = {};
+
+            for (; c + 4 <= source->sampled_width; c += 4) {
+                const int j = source->roi_x + c;
+
+                const __m128 value = _mm_sub_ps(_mm_loadu_ps(src + j), d_inf);
+                __m128 valid = _mm_cmpgt_ps(value, _mm_setzero_ps());
+
+                // 無効な視差は除算しない
+                const __m128 safe_value = _mm_or_ps(_mm_and_ps(valid, value), _mm_andnot_ps(valid, one));
+                const __m128 z = _mm_div_ps(bf, safe_value);
+                const __m128 bd = _mm_div_ps(base_length, safe_value);
+                valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(z, min_distance), _mm_cmplt_ps(z, max_distance)));
+
+                const int valid_bits = _mm_movemask_ps(valid);
+                if ((valid_bits == 0) && !is_organized) {
+                    continue;
+                }
+
+                const __m128 x_offset = _mm_sub_ps(_mm_add_ps(_mm_set1_ps((float)j), lane_offset), _mm_set1_ps(source->center_x));
+                _mm_storeu_ps(lane_x, _mm_mul_ps(x_offset, bd));
+                _mm_storeu_ps(lane_y, _mm_mul_ps(y_offset_ps, bd));
+                _mm_storeu_ps(lane_z, z);
+
+                for (int k = 0; k < 4; k++) {
+                    if (valid_bits & (1 << k)) {
+                        WritePoint(is_ros_axis, layout, index, lane_x[k], lane_y[k], lane_z[k], GetPointColor(color_line, source->color_channel_count, j + k), destination);
+                        index++;
+                    }
+                    else if (is_organized) {
+                        WritePoint(false, layout, index, invalid, invalid, invalid, 0, destination);
+                        index++;
+                    }
+                }
+            }
+        }
+#endif
+
+        for (; c < source->sampled_width; c++) {
+            const int j = source->roi_x + (c * source->decimation);
+            const float value = src[j] - source->d_inf;
+
+            bool is_valid = false;
+            float x = invalid, y = invalid, z = invalid;
+
+            if (value > 0) {
+                z = source->bf / value;
+                if ((z >= source->min_distance) && (z < source->max_distance)) {
+                    const float bd = source->base_length / value;
+                    x = ((float)j - source->center_x) * bd;
+                    y = y_offset * bd;
+                    is_valid = true;
+                }
+            }
+
+            if (is_valid) {
+                WritePoint(is_ros_axis, layout, index, x, y, z, GetPointColor(color_line, source->color_channel_count, j), destination);
+                index++;
+            }
+            else if (is_organized) {
+                WritePoint(false, layout, index, invalid, invalid, invalid, 0, destination);
+                index++;
+            }
+        }
+    }
+
+    job->point_count = index - job->point_offset;
+
+    return;
+}
+
+/**
+ * ファイルに書き込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[in] data データ
+ * @param[in] size 大きさ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscPointCloud::WriteBuffer(HANDLE handle_file, const void* data, const size_t size)
+{
+    DWORD written_size = 0;
+    if (WriteFile(handle_file, data, (DWORD)size, &written_size, NULL) != TRUE) {
+        return CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    if (written_size != (DWORD)size) {
+        return CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * PCD(binary)を書き込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_point_cloud_data 点群
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscPointCloud::WritePcd(HANDLE handle_file, const IscPointCloudParameter* isc_point_cloud_parameter, const IscPointCloudData* isc_point_cloud_data)
+{
+    const bool with_color = isc_point_cloud_parameter->with_color;
+
+    char header[512] = {};
+    if (with_color) {
+        sprintf_s(header, "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS x y z rgb\nSIZE 4 4 4 4\nTYPE F F F U\nCOUNT 1 1 1 1\n"
+                    "WIDTH %d\nHEIGHT %d\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS %d\nDATA binary\n",
+                    isc_point_cloud_data->width, isc_point_cloud_data->height, isc_point_cloud_data->point_count);
+    }
+    else {
+        sprintf_s(header, "# .PCD v0.7 - Point Cloud Data file format\nVERSION 0.7\nFIELDS x y z\nSIZE 4 4 4\nTYPE F F F\nCOUNT 1 1 1\n"
+                    "WIDTH %d\nHEIGHT %d\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS %d\nDATA binary\n",
+                    isc_point_cloud_data->width, isc_point_cloud_data->height, isc_point_cloud_data->point_count);
+    }
+
+    int ret = WriteBuffer(handle_file, header, strlen(header));
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    if (with_color) {
+        // IscPointXYZRGBはPCDの1点と同じ配置です
+        for (int i = 0; i < isc_point_cloud_data->point_count; i += kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT) {
+            const int count = (std::min)(kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT, isc_point_cloud_data->point_count - i);
+
+            ret = WriteBuffer(handle_file, &isc_point_cloud_data->points[i], sizeof(IscPointXYZRGB) * count);
+            if (ret != DPC_E_OK) {
+                return ret;
+            }
+        }
+
+        return DPC_E_OK;
+    }
+
+    for (int i = 0; i < isc_point_cloud_data->point_count; i += kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT) {
+        const int count = (std::min)(kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT, isc_point_cloud_data->point_count - i);
+
+        float* dst = (float*)save_buffer_;
+        for (int k = 0; k < count; k++) {
+            const IscPointXYZRGB* point = &isc_point_cloud_data->points[i + k];
+            *dst++ = point->x;
+            *dst++ = point->y;
+            *dst++ = point->z;
+        }
+
+        ret = WriteBuffer(handle_file, save_buffer_, sizeof(float) * 3 * count);
+        if (ret != DPC_E_OK) {
+            return ret;
+        }
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * PLY(binary_little_endian)を書き込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[in] isc_point_cloud_parameter 変換の条件
+ * @param[in] isc_point_cloud_data 点群
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscPointCloud::WritePly(HANDLE handle_file, const IscPointCloudParameter* isc_point_cloud_parameter, const IscPointCloudData* isc_point_cloud_data)
+{
+    const bool with_color = isc_point_cloud_parameter->with_color;
+
+    char header[512] = {};
+    sprintf_s(header, "ply\nformat binary_little_endian 1.0\nelement vertex %d\nproperty float x\nproperty float y\nproperty float z\n%send_header\n",
+                isc_point_cloud_data->point_count,
+                with_color ? "property uchar red\nproperty uchar green\nproperty uchar blue\n" : "");
+
+    int ret = WriteBuffer(handle_file, header, strlen(header));
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    const size_t point_size = with_color ? kISC_POINT_CLOUD_PLY_POINT_SIZE : (sizeof(float) * 3);
+
+    for (int i = 0; i < isc_point_cloud_data->point_count; i += kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT) {
+        const int count = (std::min)(kISC_POINT_CLOUD_SAVE_CHUNK_POINT_COUNT, isc_point_cloud_data->point_count - i);
+
+        unsigned char* dst = save_buffer_;
+        for (int k = 0; k < count; k++) {
+            const IscPointXYZRGB* point = &isc_point_cloud_data->points[i + k];
+
+            memcpy(dst, &point->x, sizeof(float) * 3);
+            if (with_color) {
+                dst[12] = (unsigned char)((point->rgb >> 16) & 0xFF);
+                dst[13] = (unsigned char)((point->rgb >> 8) & 0xFF);
+                dst[14] = (unsigned char)(point->rgb & 0xFF);
+            }
+            dst += point_size;
+        }
+
+        ret = WriteBuffer(handle_file, save_buffer_, point_size * count);
+        if (ret != DPC_E_OK) {
+            return ret;
+        }
+    }
+
+    return DPC_E_OK;
+}
@@ -0,0 +1,583 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_range_index.cpp
+ * @brief range index class
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ * 
+ * @details This class builds the index for the range query from the block disparity.
+ * @note
+ *  - Block毎の視差(d - d_inf)を1/64画素の固定小数点(short)とし、2^kx x 2^ky の範囲の最小値/最大値の表(sparse table)を作成します
+ *  - 任意の矩形の最小値/最大値は、重なり合う4つの範囲から O(1) で求めます
+ *  - 有効なBlockの数は累積の表から O(1) で求めます
+ *  - 距離の範囲内のBlockの数は、矩形の最小値/最大値が範囲の内側/外側の場合は O(1) で、それ以外は矩形のBlockを数えます
+ *  - 登録した領域は毎フレーム評価します
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+
+#include "isc_range_index.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define ISC_RANGE_INDEX_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+constexpr float kISC_RANGE_INDEX_DISPARITY_SCALE = 64.0F;   /**< 視差の固定小数点の倍率 */
+constexpr short kISC_RANGE_INDEX_MAX_VALUE = 32766;         /**< 視差の最大値 (511.98 pixel) */
+constexpr short kISC_RANGE_INDEX_INVALID_MIN = 32767;       /**< 無効なBlock (最小値の表) */
+constexpr short kISC_RANGE_INDEX_INVALID_MAX = -1;          /**< 無効なBlock (最大値の表) */
+
+/**
+ * 2つの行の要素毎の最小値、最大値を求めます
+ *
+ * @param[in] min_a 最小値の表の行
+ * @param[in] min_b 最小値の表の行
+ * @param[in] max_a 最大値の表の行
+ * @param[in] max_b 最大値の表の行
+ * @param[in] count 要素の数
+ * @param[out] min_dst 最小値
+ * @param[out] max_dst 最大値
+ * @return none
+ */
+static void MinMaxRow(const short* min_a, const short* min_b, const short* max_a, const short* max_b, const int count, short* min_dst, short* max_dst)
+{
+    int i = 0;
+
+#ifdef ISC_RANGE_INDEX_USE_SSE2
+    for (; i + 8 <= count; i += 8) {
+        const __m128i min_value = _mm_min_epi16(_mm_loadu_si128((const __m128i*)(min_a + i)), _mm_loadu_si128((const __m128i*)(min_b + i)));
+        const __m128i max_value = _mm_max_epi16(_mm_loadu_si128((const __m128i*)(max_a + i)), _mm_loadu_si128((const __m128i*)(max_b + i)));
+        _mm_storeu_si128((__m128i*)(min_dst + i), min_value);
+        _mm_storeu_si128((__m128i*)(max_dst + i), max_value);
+    }
+#endif
+
+    for (; i < count; i++) {
+        min_dst[i] = (std::min)(min_a[i], min_b[i]);
+        max_dst[i] = (std::max)(max_a[i], max_b[i]);
+    }
+
+    return;
+}
+
+/**
+ * constructor
+ *
+ */
+IscRangeIndex::IscRangeIndex():
+    index_critical_(), parameter_(),
+    block_width_(0), block_height_(0), block_count_x_(0), block_count_y_(0), bf_(0),
+    level_count_x_(0), level_count_y_(0), level_offset_(), min_table_(nullptr), max_table_(nullptr), max_table_size_(0),
+    valid_sum_(nullptr), level_log_(nullptr), max_block_count_x_(0), max_block_count_y_(0),
+    zone_data_()
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscRangeIndex::~IscRangeIndex()
+{
+
+}
+
+/**
+ * クラスを初期化します
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRangeIndex::Initialize()
+{
+    InitializeCriticalSection(&index_critical_);
+
+    // 既定値 無効
+    parameter_.enabled = false;
+    parameter_.zone_count = 0;
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRangeIndex::Terminate()
+{
+    ReleaseBuffers();
+
+    DeleteCriticalSection(&index_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 表の領域を解放します
+ *
+ * @return none
+ */
+void IscRangeIndex::ReleaseBuffers()
+{
+    delete[] min_table_;
+    min_table_ = nullptr;
+
+    delete[] max_table_;
+    max_table_ = nullptr;
+
+    delete[] valid_sum_;
+    valid_sum_ = nullptr;
+
+    delete[] level_log_;
+    level_log_ = nullptr;
+
+    max_table_size_ = 0;
+    max_block_count_x_ = 0;
+    max_block_count_y_ = 0;
+    block_count_x_ = 0;
+    block_count_y_ = 0;
+
+    return;
+}
+
+/**
+ * パラメータを設定し、領域を登録します
+ *
+ * @param[in] isc_range_index_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 作成済みの表は消去されます
+ */
+int IscRangeIndex::SetParameter(const IscRangeIndexParameter* isc_range_index_parameter)
+{
+    if (isc_range_index_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscRangeIndexParameter* parameter = isc_range_index_parameter;
+
+    if ((parameter->zone_count < 0) || (parameter->zone_count > kISC_RANGE_INDEX_MAX_ZONE_COUNT)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    for (int i = 0; i < parameter->zone_count; i++) {
+        const IscRangeZone* zone = &parameter->zones[i];
+
+        if ((zone->x < 0) || (zone->y < 0) || (zone->width <= 0) || (zone->height <= 0) ||
+            (zone->min_distance < 0) || (zone->max_distance <= zone->min_distance)) {
+            return ISCDPL_E_INVALID_PARAMETER;
+        }
+    }
+
+    EnterCriticalSection(&index_critical_);
+
+    block_count_x_ = 0;
+    block_count_y_ = 0;
+
+    parameter_ = *parameter;
+
+    memset(&zone_data_, 0, sizeof(zone_data_));
+
+    LeaveCriticalSection(&index_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * パラメータを取得します
+ *
+ * @param[out] isc_range_index_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRangeIndex::GetParameter(IscRangeIndexParameter* isc_range_index_parameter)
+{
+    if (isc_range_index_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&index_critical_);
+    *isc_range_index_parameter = parameter_;
+    LeaveCriticalSection(&index_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 表の領域を確保します
+ *
+ * @param[in] block_count_x 横方向のBlockの数
+ * @param[in] block_count_y 縦方向のBlockの数
+ * @return none
+ */
+void IscRangeIndex::AllocateBuffers(const int block_count_x, const int block_count_y)
+{
+    // 各段の位置 行の間隔は block_count_x で、行の数は block_count_y - 2^ky + 1 です
+    level_count_x_ = 0;
+    while ((level_count_x_ < kMaxLevelCount) && ((1 << level_count_x_) <= block_count_x)) {
+        level_count_x_++;
+    }
+    level_count_y_ = 0;
+    while ((level_count_y_ < kMaxLevelCount) && ((1 << level_count_y_) <= block_count_y)) {
+        level_count_y_++;
+    }
+
+    size_t table_size = 0;
+    for (int ky = 0; ky < level_count_y_; ky++) {
+        const size_t row_count = (size_t)block_count_y - ((size_t)1 << ky) + 1;
+        for (int kx = 0; kx < level_count_x_; kx++) {
+            level_offset_[ky][kx] = table_size;
+            table_size += row_count * block_count_x;
+        }
+    }
+
+    if ((table_size <= max_table_size_) && (block_count_x <= max_block_count_x_) && (block_count_y <= max_block_count_y_)) {
+        return;
+    }
+
+    const size_t max_table_size = (std::max)(table_size, max_table_size_);
+    const int max_block_count_x = (std::max)(block_count_x, max_block_count_x_);
+    const int max_block_count_y = (std::max)(block_count_y, max_block_count_y_);
+    ReleaseBuffers();
+
+    min_table_ = new short[max_table_size];
+    max_table_ = new short[max_table_size];
+    valid_sum_ = new int[((size_t)max_block_count_x + 1) * ((size_t)max_block_count_y + 1)];
+
+    const int max_length = (std::max)(max_block_count_x, max_block_count_y);
+    level_log_ = new int[max_length + 1];
+    level_log_[0] = 0;
+    for (int i = 1; i <= max_length; i++) {
+        level_log_[i] = (i == 1) ? 0 : level_log_[i / 2] + 1;
+    }
+
+    max_table_size_ = max_table_size;
+    max_block_count_x_ = max_block_count_x;
+    max_block_count_y_ = max_block_count_y;
+
+    return;
+}
+
+/**
+ * Block毎の視差から表を作成します
+ *
+ * @param[in] block_disparity Block毎の視差
+ * @param[in] d_inf 無限遠の視差
+ * @return none
+ */
+void IscRangeIndex::BuildTables(const float* block_disparity, const float d_inf)
+{
+    const int width = block_count_x_;
+    const int height = block_count_y_;
+
+    // 1 x 1 と有効なBlockの数の累積
+    short* min_base = min_table_;
+    short* max_base = max_table_;
+    const int sum_stride = width + 1;
+
+    memset(valid_sum_, 0, sizeof(int) * sum_stride);
+
+    for (int y = 0; y < height; y++) {
+        const float* src = block_disparity + ((size_t)y * width);
+        short* min_row = min_base + ((size_t)y * width);
+        short* max_row = max_base + ((size_t)y * width);
+        const int* sum_above = valid_sum_ + ((size_t)y * sum_stride);
+        int* sum_row = valid_sum_ + ((size_t)(y + 1) * sum_stride);
+
+        int row_count = 0;
+        sum_row[0] = 0;
+
+        for (int x = 0; x < width; x++) {
+            const float value = src[x] - d_inf;
+
+            if (value > 0) {
+                const int fixed_value = (int)((value * kISC_RANGE_INDEX_DISPARITY_SCALE) + 0.5F);
+                const short clipped_value = (short)(std::max)(1, (std::min)(fixed_value, (int)kISC_RANGE_INDEX_MAX_VALUE));
+                min_row[x] = clipped_value;
+                max_row[x] = clipped_value;
+                row_count++;
+            }
+            else {
+                min_row[x] = kISC_RANGE_INDEX_INVALID_MIN;
+                max_row[x] = kISC_RANGE_INDEX_INVALID_MAX;
+            }
+
+            sum_row[x + 1] = sum_above[x + 1] + row_count;
+        }
+    }
+
+    // 2^kx x 1
+    for (int kx = 1; kx < level_count_x_; kx++) {
+        const size_t src_offset = level_offset_[0][kx - 1];
+        const size_t dst_offset = level_offset_[0][kx];
+        const int half = 1 << (kx - 1);
+        const int count = width - (1 << kx) + 1;
+
+        for (int y = 0; y < height; y++) {
+            const size_t row = (size_t)y * width;
+            MinMaxRow(min_table_ + src_offset + row, min_table_ + src_offset + row + half,
+                max_table_ + src_offset + row, max_table_ + src_offset + row + half, count,
+                min_table_ + dst_offset + row, max_table_ + dst_offset + row);
+        }
+    }
+
+    // 2^kx x 2^ky
+    for (int ky = 1; ky < level_count_y_; ky++) {
+        const int half = 1 << (ky - 1);
+        const int row_count = height - (1 << ky) + 1;
+
+        for (int kx = 0; kx < level_count_x_; kx++) {
+            const size_t src_offset = level_offset_[ky - 1][kx];
+            const size_t dst_offset = level_offset_[ky][kx];
+            const size_t half_offset = (size_t)half * width;
+            const int count = width - (1 << kx) + 1;
+
+            for (int y = 0; y < row_count; y++) {
+                const size_t row = (size_t)y * width;
+                MinMaxRow(min_table_ + src_offset + row, min_table_ + src_offset + row + half_offset,
+                    max_table_ + src_offset + row, max_table_ + src_offset + row + half_offset, count,
+                    min_table_ + dst_offset + row, max_table_ + dst_offset + row);
+            }
+        }
+    }
+
+    return;
+}
+
+/**
+ * 領域を評価します
+ *
+ * @param[in] zone 領域
+ * @param[out] result 結果
+ * @return none
+ */
+void IscRangeIndex::Query(const IscRangeZone* zone, IscRangeZoneResult* result)
+{
+    memset(result, 0, sizeof(IscRangeZoneResult));
+
+    if ((zone->width <= 0) || (zone->height <= 0) || ((zone->x + zone->width) <= 0) || ((zone->y + zone->height) <= 0)) {
+        return;
+    }
+
+    // 領域と重なるBlock
+    const int bx0 = (std::max)(zone->x, 0) / block_width_;
+    const int by0 = (std::max)(zone->y, 0) / block_height_;
+    const int bx1 = (std::min)((zone->x + zone->width - 1) / block_width_, block_count_x_ - 1);
+    const int by1 = (std::min)((zone->y + zone->height - 1) / block_height_, block_count_y_ - 1);
+
+    if ((bx0 > bx1) || (by0 > by1)) {
+        return;
+    }
+
+    const int sum_stride = block_count_x_ + 1;
+    const int valid_count = valid_sum_[(size_t)(by1 + 1) * sum_stride + (bx1 + 1)] - valid_sum_[(size_t)by0 * sum_stride + (bx1 + 1)] -
+        valid_sum_[(size_t)(by1 + 1) * sum_stride + bx0] + valid_sum_[(size_t)by0 * sum_stride + bx0];
+    if (valid_count == 0) {
+        return;
+    }
+
+    // 重なり合う4つの範囲
+    const int kx = level_log_[bx1 - bx0 + 1];
+    const int ky = level_log_[by1 - by0 + 1];
+    const size_t offset = level_offset_[ky][kx];
+    const int x0 = bx0, x1 = bx1 - (1 << kx) + 1;
+    const int y0 = by0, y1 = by1 - (1 << ky) + 1;
+
+    const short* min_level = min_table_ + offset;
+    const short* max_level = max_table_ + offset;
+    const size_t row0 = (size_t)y0 * block_count_x_;
+    const size_t row1 = (size_t)y1 * block_count_x_;
+
+    const int min_value = (std::min)((std::min)(min_level[row0 + x0], min_level[row0 + x1]), (std::min)(min_level[row1 + x0], min_level[row1 + x1]));
+    const int max_value = (std::max)((std::max)(max_level[row0 + x0], max_level[row0 + x1]), (std::max)(max_level[row1 + x0], max_level[row1 + x1]));
+
+    const float bf = bf_ * kISC_RANGE_INDEX_DISPARITY_SCALE;
+    result->valid_count = valid_count;
+    result->min_distance = bf / (float)max_value;
+    result->max_distance = bf / (float)min_value;
+
+    // 距離の範囲を視差の範囲とします
+    const float lower_value = bf / zone->max_distance;
+    const float upper_value = (zone->min_distance > 0) ? bf / zone->min_distance : FLT_MAX;
+
+    if (((float)min_value >= lower_value) && ((float)max_value <= upper_value)) {
+        result->in_range_count = valid_count;
+    }
+    else if (((float)max_value < lower_value) || ((float)min_value > upper_value)) {
+        result->in_range_count = 0;
+    }
+    else {
+        int in_range_count = 0;
+        for (int y = by0; y <= by1; y++) {
+            const short* src = min_table_ + ((size_t)y * block_count_x_);
+
+            for (int x = bx0; x <= bx1; x++) {
+                const float value = (float)src[x];
+                if ((src[x] != kISC_RANGE_INDEX_INVALID_MIN) && (value >= lower_value) && (value <= upper_value)) {
+                    in_range_count++;
+                }
+            }
+        }
+        result->in_range_count = in_range_count;
+    }
+
+    return;
+}
+
+/**
+ * Block毎の視差から表を作成し、登録した領域を評価します
+ *
+ * @param[in] isc_image_info データ構造体
+ * @param[in] isc_block_disparity_data Block毎の視差
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理Threadから呼び出されます
+ */
+int IscRangeIndex::Update(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data)
+{
+    if (isc_image_info == nullptr || isc_block_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscBlockDisparityData* block_data = isc_block_disparity_data;
+    if (block_data->image_width <= 0 || block_data->image_height <= 0 ||
+        block_data->blkwdt <= 0 || block_data->blkhgt <= 0 || block_data->pblkdsp == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&index_critical_);
+
+    if (!parameter_.enabled) {
+        LeaveCriticalSection(&index_critical_);
+        return DPC_E_OK;
+    }
+
+    const int block_count_x = block_data->image_width / block_data->blkwdt;
+    const int block_count_y = block_data->image_height / block_data->blkhgt;
+    if (block_count_x <= 0 || block_count_y <= 0) {
+        LeaveCriticalSection(&index_critical_);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+    AllocateBuffers(block_count_x, block_count_y);
+
+    block_width_ = block_data->blkwdt;
+    block_height_ = block_data->blkhgt;
+    block_count_x_ = block_count_x;
+    block_count_y_ = block_count_y;
+    bf_ = isc_image_info->camera_specific_parameter.bf;
+
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+    if (isc_image_info->shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
+
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+        }
+    }
+
+    BuildTables(block_data->pblkdsp, isc_image_info->camera_specific_parameter.d_inf);
+
+    zone_data_.zone_count = parameter_.zone_count;
+    for (int i = 0; i < parameter_.zone_count; i++) {
+        Query(&parameter_.zones[i], &zone_data_.results[i]);
+    }
+    zone_data_.frame_time = isc_image_info->frame_data[fd_index].frame_time;
+    zone_data_.frame_index = isc_image_info->frame_data[fd_index].frameNo;
+
+    LeaveCriticalSection(&index_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの登録した領域の結果を取得します
+ *
+ * @param[out] isc_range_zone_data 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRangeIndex::GetZoneData(IscRangeZoneData* isc_range_zone_data)
+{
+    if (isc_range_zone_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&index_critical_);
+
+    if (block_count_x_ == 0) {
+        LeaveCriticalSection(&index_critical_);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    *isc_range_zone_data = zone_data_;
+
+    LeaveCriticalSection(&index_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のフレームの任意の領域を評価します
+ *
+ * @param[in] isc_range_zone 領域
+ * @param[out] isc_range_zone_result 結果
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRangeIndex::QueryRange(const IscRangeZone* isc_range_zone, IscRangeZoneResult* isc_range_zone_result)
+{
+    if (isc_range_zone == nullptr || isc_range_zone_result == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if ((isc_range_zone->min_distance < 0) || (isc_range_zone->max_distance <= isc_range_zone->min_distance)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&index_critical_);
+
+    if (block_count_x_ == 0) {
+        LeaveCriticalSection(&index_critical_);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    Query(isc_range_zone, isc_range_zone_result);
+
+    LeaveCriticalSection(&index_critical_);
+
+    return DPC_E_OK;
+}
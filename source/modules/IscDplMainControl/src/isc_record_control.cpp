@@ -20,17 +20,1166 @@
  * @version 0.1
  * 
  * @details This class provides a function for recording.
+ * @note
+ *  - ブロック視差をkISC_RESULT_RECORD_SUBPIXEL_TIMES倍のuint16に変換して記録します
+ *  - use_fixed_point指定時は、kISC_DISPARITY_FIXED_POINT_SCALE倍の固定小数点のブロック視差をそのまま記録します
+ *  - Key Frameは左のブロックから、その他のFrameは前Frameの同じブロックから予測し、残差をrANSで符号化します
+ *  - 記録の停止時に、ファイルの末尾にIndexを書き込みます。Indexが無いファイルは読み込み時に走査して作成します
  */
 #include "pch.h"
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <process.h>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+#include "isc_thread_placement.h"
+
+#include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
+#include "vm_sdk_wrapper.h"
+#include "xc_sdk_wrapper.h"
+#include "k4a_sdk_wrapper.h"
+#include "isc_sdk_control.h"
+#include "isc_file_write_control_impl.h"
+#include "isc_raw_data_decoder.h"
+#include "isc_decoded_frame_cache.h"
+#include "isc_file_read_control_impl.h"
+#include "isc_selftcalibration_interface.h"
+#include "isc_camera_control.h"
+#include "isc_dataproc_resultdata_ring_buffer.h"
+#include "isc_framedecoder_interface.h"
+#include "isc_stereomatching_interface.h"
+#include "isc_disparityfilter_interface.h"
+#include "isc_data_processing_control.h"
 
 #include "isc_record_control.h"
 
+// mark of the result record file
+constexpr char kISC_RESULT_RECORD_MARK[] = "ISC RESULT RECORD";
 
-//
-// Functionality in this class will be provided in the future.
-//
+// number of index entries added at once
+constexpr __int64 kISC_RESULT_RECORD_INDEX_GROW_COUNT = 4096;
+
+// rANS
+constexpr int kRansScaleBits = 12;
+constexpr uint32_t kRansScale = 1u << kRansScaleBits;
+constexpr uint32_t kRansByteL = 1u << 23;
+constexpr int kFrequencyTableSize = 256 * sizeof(uint16_t);
+
+/**
+ * 出現回数を合計kRansScaleの頻度に正規化します
+ *
+ * @param[in] count 出現回数
+ * @param[in] total 合計
+ * @param[out] freq 頻度
+ * @retval true 成功
+ * @retval false 失敗
+ * @note 出現した値の頻度は1以上とし、差分は最も多い値で調整します
+ */
+static bool NormalizeFrequency(const uint32_t* count, const uint32_t total, uint16_t* freq)
+{
+    if (total == 0) {
+        return false;
+    }
+
+    uint32_t sum = 0;
+    int max_symbol = 0;
+    for (int s = 0; s < 256; s++) {
+        if (count[s] == 0) {
+            freq[s] = 0;
+            continue;
+        }
+
+        uint32_t f = (uint32_t)(((uint64_t)count[s] * kRansScale) / total);
+        if (f == 0) {
+            f = 1;
+        }
+        freq[s] = (uint16_t)f;
+        sum += f;
+
+        if (count[s] > count[max_symbol]) {
+            max_symbol = s;
+        }
+    }
+
+    const int diff = (int)kRansScale - (int)sum;
+    if ((int)freq[max_symbol] + diff < 1) {
+        return false;
+    }
+    freq[max_symbol] = (uint16_t)(freq[max_symbol] + diff);
+
+    return true;
+}
+
+/**
+ * 残差をzigzag符号化します
+ *
+ * @param[in] residual 残差
+ * @return 符号化した値
+ */
+static inline unsigned short ZigZag(const unsigned short residual)
+{
+    const short d = (short)residual;
+
+    return (unsigned short)(((unsigned short)d << 1) ^ (unsigned short)(d >> 15));
+}
+
+/**
+ * zigzag符号化を戻します
+ *
+ * @param[in] z 符号化した値
+ * @return 残差
+ */
+static inline unsigned short UnZigZag(const unsigned short z)
+{
+    return (unsigned short)((z >> 1) ^ (unsigned short)(-(int)(z & 1)));
+}
+
+/**
+ * Key Frameの予測値を計算します
+ *
+ * @param[in] value ブロックの値
+ * @param[in] block_count_x 横のブロック数
+ * @param[in] x 位置
+ * @param[in] y 位置
+ * @return 予測値
+ * @note 左のブロック、行の先頭は上のブロックを予測値とします
+ */
+static inline unsigned short PredictKeyFrame(const unsigned short* value, const int block_count_x, const int x, const int y)
+{
+    const int index = y * block_count_x + x;
+
+    if (x > 0) {
+        return value[index - 1];
+    }
+    else if (y > 0) {
+        return value[index - block_count_x];
+    }
+
+    return 0;
+}
+
+/**
+ * constructor
+ *
+ */
+IscRecordControl::IscRecordControl():
+    isc_log_(nullptr),
+    record_control_(),
+    read_control_()
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscRecordControl::~IscRecordControl()
+{
+
+}
+
+/**
+ * クラスを初期化します.
+ *
+ * @param[in] isc_log ログ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRecordControl::Initialize(IscLog* isc_log)
+{
+    isc_log_ = isc_log;
+
+    InitializeCriticalSection(&record_control_.critical);
+    record_control_.handle_file = NULL;
+    memset(&record_control_.file_header, 0, sizeof(record_control_.file_header));
+    memset(&record_control_.status, 0, sizeof(record_control_.status));
+    record_control_.frame_count_from_key = 0;
+    memset(&record_control_.frame_buffer, 0, sizeof(record_control_.frame_buffer));
+    record_control_.index_entry = nullptr;
+    record_control_.index_capacity = 0;
+
+    InitializeCriticalSection(&read_control_.critical);
+    read_control_.handle_file = NULL;
+    memset(&read_control_.file_header, 0, sizeof(read_control_.file_header));
+    memset(&read_control_.information, 0, sizeof(read_control_.information));
+    read_control_.decoded_frame_number = -1;
+    memset(&read_control_.frame_buffer, 0, sizeof(read_control_.frame_buffer));
+    read_control_.index_entry = nullptr;
+    read_control_.index_count = 0;
+    read_control_.index_capacity = 0;
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします.
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRecordControl::Terminate()
+{
+    StopRecord();
+    CloseFile();
+
+    ReleaseFrameBuffer(&record_control_.frame_buffer);
+    delete[] record_control_.index_entry;
+    record_control_.index_entry = nullptr;
+    record_control_.index_capacity = 0;
+    DeleteCriticalSection(&record_control_.critical);
+
+    ReleaseFrameBuffer(&read_control_.frame_buffer);
+    DeleteCriticalSection(&read_control_.critical);
+
+    isc_log_ = nullptr;
+
+    return DPC_E_OK;
+}
+
+/**
+ * ファイルを作成し、ブロック視差の記録を開始します
+ *
+ * @param[in] isc_result_record_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRecordControl::StartRecord(const IscResultRecordParameter* isc_result_record_parameter)
+{
+    if (isc_result_record_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_result_record_parameter->file_name[0] == L'\0' || isc_result_record_parameter->key_frame_interval < 0) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    RecordControl* record_control = &record_control_;
+
+    EnterCriticalSection(&record_control->critical);
+
+    if (record_control->handle_file != NULL) {
+        LeaveCriticalSection(&record_control->critical);
+        return ISCDPL_E_OPVERLAPED_OPERATION;
+    }
+
+    HANDLE handle_file = CreateFile(isc_result_record_parameter->file_name, GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE) {
+        LeaveCriticalSection(&record_control->critical);
+        return CAMCONTROL_E_CREATE_SAVE_FILE;
+    }
+
+    IscResultRecordFileHeader* file_header = &record_control->file_header;
+    memset(file_header, 0, sizeof(IscResultRecordFileHeader));
+    sprintf_s(file_header->mark, "%s", kISC_RESULT_RECORD_MARK);
+    file_header->version = ISC_RESULT_RECORD_HEADER_VERSION;
+    file_header->header_size = sizeof(IscResultRecordFileHeader);
+    file_header->frame_header_size = sizeof(IscResultRecordFrameHeader);
+    file_header->subpixel_times = isc_result_record_parameter->use_fixed_point ? kISC_DISPARITY_FIXED_POINT_SCALE : kISC_RESULT_RECORD_SUBPIXEL_TIMES;
+    file_header->key_frame_interval = (isc_result_record_parameter->key_frame_interval == 0) ? kISC_RESULT_RECORD_DEFAULT_KEY_FRAME_INTERVAL : isc_result_record_parameter->key_frame_interval;
+
+    if (!WriteFileAll(handle_file, file_header, sizeof(IscResultRecordFileHeader))) {
+        CloseHandle(handle_file);
+        DeleteFile(isc_result_record_parameter->file_name);
+        LeaveCriticalSection(&record_control->critical);
+        return CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    record_control->handle_file = handle_file;
+    memset(&record_control->status, 0, sizeof(IscResultRecordStatus));
+    record_control->status.recording = true;
+    record_control->status.file_size = sizeof(IscResultRecordFileHeader);
+    record_control->frame_count_from_key = 0;
+    memset(&record_control->frame_buffer.frame_header, 0, sizeof(IscResultRecordFrameHeader));
+
+    LeaveCriticalSection(&record_control->critical);
+
+    if (isc_log_ != nullptr) {
+        wchar_t log_msg[512] = {};
+        swprintf_s(log_msg, L"Result record start file=%s key_frame_interval=%d subpixel_times=%d\n", isc_result_record_parameter->file_name, file_header->key_frame_interval, file_header->subpixel_times);
+        isc_log_->LogInfo(L"IscRecordControl", log_msg);
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * Indexを書き込み、ファイルを閉じます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRecordControl::StopRecord()
+{
+    RecordControl* record_control = &record_control_;
+
+    EnterCriticalSection(&record_control->critical);
+
+    if (record_control->handle_file == NULL) {
+        LeaveCriticalSection(&record_control->critical);
+        return DPC_E_OK;
+    }
+
+    int ret = DPC_E_OK;
+
+    // index
+    LARGE_INTEGER zero = {};
+    LARGE_INTEGER index_offset = {};
+    const __int64 frame_count = record_control->status.frame_count;
+    const size_t index_size = (size_t)frame_count * sizeof(IscResultRecordIndexEntry);
+
+    if (!SetFilePointerEx(record_control->handle_file, zero, &index_offset, FILE_END) ||
+        !WriteFileAll(record_control->handle_file, record_control->index_entry, index_size)) {
+        ret = CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    // header
+    if (ret == DPC_E_OK) {
+        record_control->file_header.frame_count = frame_count;
+        record_control->file_header.index_offset = index_offset.QuadPart;
+
+        if (!SetFilePointerEx(record_control->handle_file, zero, NULL, FILE_BEGIN) ||
+            !WriteFileAll(record_control->handle_file, &record_control->file_header, sizeof(IscResultRecordFileHeader))) {
+            ret = CAMCONTROL_E_WRITE_FAILED;
+        }
+        else {
+            record_control->status.file_size += index_size;
+        }
+    }
+
+    CloseHandle(record_control->handle_file);
+    record_control->handle_file = NULL;
+    record_control->status.recording = false;
+
+    const IscResultRecordStatus status = record_control->status;
+
+    LeaveCriticalSection(&record_control->critical);
+
+    if (isc_log_ != nullptr) {
+        wchar_t log_msg[512] = {};
+        swprintf_s(log_msg, L"Result record stop frames=%I64d key_frames=%I64d failed=%I64d size=%I64d ratio=%.2f (0x%08X)\n",
+            status.frame_count, status.key_frame_count, status.failed_count, status.file_size, status.compression_ratio, ret);
+        isc_log_->LogInfo(L"IscRecordControl", log_msg);
+    }
+
+    return ret;
+}
+
+/**
+ * 記録の状態を取得します
+ *
+ * @param[out] isc_result_record_status 状態
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRecordControl::GetRecordStatus(IscResultRecordStatus* isc_result_record_status)
+{
+    if (isc_result_record_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&record_control_.critical);
+    *isc_result_record_status = record_control_.status;
+    LeaveCriticalSection(&record_control_.critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 1Frameのブロック視差を書き込みます
+ *
+ * @param[in] isc_image_info 入力データ
+ * @param[in] isc_block_disparity_data ブロック視差
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理Threadから呼び出されます。記録中でない場合は何もしません
+ */
+int IscRecordControl::WriteFrame(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data)
+{
+    if (isc_image_info == nullptr || isc_block_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    RecordControl* record_control = &record_control_;
+
+    EnterCriticalSection(&record_control->critical);
+
+    if (record_control->handle_file == NULL) {
+        LeaveCriticalSection(&record_control->critical);
+        return DPC_E_OK;
+    }
+
+    // there is no block disparity for this mode
+    if (isc_block_disparity_data->image_width <= 0 || isc_block_disparity_data->image_height <= 0 ||
+        isc_block_disparity_data->blkwdt <= 0 || isc_block_disparity_data->blkhgt <= 0 || isc_block_disparity_data->pblkdsp == nullptr) {
+        LeaveCriticalSection(&record_control->critical);
+        return DPC_E_OK;
+    }
+
+    FrameBuffer* frame_buffer = &record_control->frame_buffer;
+    const IscResultRecordFrameHeader* previous_header = &frame_buffer->frame_header;
+
+    IscResultRecordFrameHeader frame_header = {};
+    frame_header.frame_time = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frame_time;
+    frame_header.frame_index = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frameNo;
+    frame_header.image_width = isc_block_disparity_data->image_width;
+    frame_header.image_height = isc_block_disparity_data->image_height;
+    frame_header.block_width = isc_block_disparity_data->blkwdt;
+    frame_header.block_height = isc_block_disparity_data->blkhgt;
+    frame_header.block_count_x = isc_block_disparity_data->image_width / isc_block_disparity_data->blkwdt;
+    frame_header.block_count_y = isc_block_disparity_data->image_height / isc_block_disparity_data->blkhgt;
+
+    const int block_count_x = frame_header.block_count_x;
+    const int block_count_y = frame_header.block_count_y;
+    const int block_count = block_count_x * block_count_y;
+
+    // a key frame at the interval, or when the grid is changed
+    const bool is_key_frame = record_control->frame_count_from_key == 0 ||
+        record_control->frame_count_from_key >= record_control->file_header.key_frame_interval ||
+        previous_header->block_count_x != block_count_x || previous_header->block_count_y != block_count_y ||
+        previous_header->block_width != frame_header.block_width || previous_header->block_height != frame_header.block_height;
+    frame_header.flags = is_key_frame ? kISC_RESULT_RECORD_FRAME_KEY : 0;
+
+    if (!AllocateFrameBuffer(frame_buffer, block_count)) {
+        record_control->status.failed_count++;
+        LeaveCriticalSection(&record_control->critical);
+        return ISCDPL_E_FAIL;
+    }
+
+    // fixed-point
+    unsigned short* value = frame_buffer->value;
+    if (record_control->file_header.subpixel_times == kISC_DISPARITY_FIXED_POINT_SCALE && isc_block_disparity_data->pblkfix != nullptr) {
+        // the fixed-point block disparity is recorded as is
+        memcpy(value, isc_block_disparity_data->pblkfix, sizeof(unsigned short) * block_count);
+    }
+    else {
+        const float* block_disparity = isc_block_disparity_data->pblkdsp;
+        const float subpixel_times = (float)record_control->file_header.subpixel_times;
+        for (int i = 0; i < block_count; i++) {
+            const float fixed_value = block_disparity[i] * subpixel_times + 0.5F;
+            if (fixed_value < 1.0F) {
+                value[i] = 0;
+            }
+            else if (fixed_value >= 65535.0F) {
+                value[i] = 65535;
+            }
+            else {
+                value[i] = (unsigned short)fixed_value;
+            }
+        }
+    }
+
+    // residual
+    const unsigned short* previous_value = frame_buffer->previous_value;
+    unsigned char* plane_low = frame_buffer->plane[0];
+    unsigned char* plane_high = frame_buffer->plane[1];
+    for (int y = 0; y < block_count_y; y++) {
+        for (int x = 0; x < block_count_x; x++) {
+            const int index = y * block_count_x + x;
+            const unsigned short prediction = is_key_frame ? PredictKeyFrame(value, block_count_x, x, y) : previous_value[index];
+            const unsigned short z = ZigZag((unsigned short)(value[index] - prediction));
+            plane_low[index] = (unsigned char)(z & 0xff);
+            plane_high[index] = (unsigned char)(z >> 8);
+        }
+    }
+
+    // entropy coding, a plane is stored as is if it is not smaller
+    unsigned char* coded = frame_buffer->coded;
+    int coded_size = 0;
+    for (int p = 0; p < 2; p++) {
+        unsigned char* dst = coded + coded_size;
+        int plane_size = EncodePlane(frame_buffer->plane[p], block_count, dst, block_count);
+        if (plane_size == 0) {
+            memcpy(dst, frame_buffer->plane[p], block_count);
+            plane_size = block_count;
+            frame_header.plane_flags[p] = kISC_RESULT_RECORD_PLANE_STORED;
+        }
+        frame_header.plane_size[p] = plane_size;
+        coded_size += plane_size;
+    }
+
+    // write
+    LARGE_INTEGER zero = {};
+    LARGE_INTEGER offset = {};
+    if (!SetFilePointerEx(record_control->handle_file, zero, &offset, FILE_CURRENT) ||
+        !WriteFileAll(record_control->handle_file, &frame_header, sizeof(IscResultRecordFrameHeader)) ||
+        !WriteFileAll(record_control->handle_file, coded, coded_size)) {
+        record_control->status.failed_count++;
+        LeaveCriticalSection(&record_control->critical);
+        return CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    IscResultRecordIndexEntry entry = {};
+    entry.offset = offset.QuadPart;
+    entry.frame_time = frame_header.frame_time;
+    entry.flags = frame_header.flags;
+    if (!AddIndexEntry(&record_control->index_entry, &record_control->index_capacity, record_control->status.frame_count, &entry)) {
+        record_control->status.failed_count++;
+        LeaveCriticalSection(&record_control->critical);
+        return ISCDPL_E_FAIL;
+    }
+
+    // the next frame is predicted from this frame
+    frame_buffer->previous_value = value;
+    frame_buffer->value = (unsigned short*)previous_value;
+    frame_buffer->frame_header = frame_header;
+
+    record_control->frame_count_from_key = is_key_frame ? 1 : record_control->frame_count_from_key + 1;
+
+    IscResultRecordStatus* status = &record_control->status;
+    status->frame_count++;
+    if (is_key_frame) {
+        status->key_frame_count++;
+    }
+    status->block_data_size += (__int64)block_count * sizeof(float);
+    status->file_size += sizeof(IscResultRecordFrameHeader) + coded_size;
+    status->compression_ratio = (double)status->block_data_size / (double)status->file_size;
+
+    LeaveCriticalSection(&record_control->critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 読み込むファイルを開きます
+ *
+ * @param[in] file_name ファイル名
+ * @param[out] isc_result_record_information ファイルの情報
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 記録が停止されずにIndexが無い場合は、ファイルを走査してIndexを作成します
+ */
+int IscRecordControl::OpenFile(const wchar_t* file_name, IscResultRecordInformation* isc_result_record_information)
+{
+    if (file_name == nullptr || isc_result_record_information == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    ReadControl* read_control = &read_control_;
+
+    EnterCriticalSection(&read_control->critical);
+
+    CloseFile();
+
+    HANDLE handle_file = CreateFile(file_name, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE) {
+        LeaveCriticalSection(&read_control->critical);
+        return CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+    }
+
+    IscResultRecordFileHeader* file_header = &read_control->file_header;
+    if (!ReadFileAll(handle_file, file_header, sizeof(IscResultRecordFileHeader)) ||
+        strcmp(file_header->mark, kISC_RESULT_RECORD_MARK) != 0 ||
+        file_header->version != ISC_RESULT_RECORD_HEADER_VERSION ||
+        file_header->header_size != sizeof(IscResultRecordFileHeader) ||
+        file_header->frame_header_size != sizeof(IscResultRecordFrameHeader) ||
+        file_header->subpixel_times <= 0) {
+        CloseHandle(handle_file);
+        LeaveCriticalSection(&read_control->critical);
+        return CAMCONTROL_E_READ_FILE_FAILED;
+    }
+    read_control->handle_file = handle_file;
+
+    // index
+    IscResultRecordInformation* information = &read_control->information;
+    memset(information, 0, sizeof(IscResultRecordInformation));
+
+    int ret = DPC_E_OK;
+    if (file_header->index_offset > 0 && file_header->frame_count > 0) {
+        const __int64 frame_count = file_header->frame_count;
+        read_control->index_entry = new IscResultRecordIndexEntry[frame_count];
+        read_control->index_capacity = frame_count;
+
+        LARGE_INTEGER offset = {};
+        offset.QuadPart = file_header->index_offset;
+        if (!SetFilePointerEx(handle_file, offset, NULL, FILE_BEGIN) ||
+            !ReadFileAll(handle_file, read_control->index_entry, (size_t)frame_count * sizeof(IscResultRecordIndexEntry))) {
+            ret = CAMCONTROL_E_READ_FILE_FAILED;
+        }
+        else {
+            read_control->index_count = frame_count;
+            information->has_index = true;
+        }
+    }
+    else {
+        ret = BuildIndex(read_control);
+    }
+
+    // the first frame
+    IscResultRecordFrameHeader frame_header = {};
+    if (ret == DPC_E_OK && read_control->index_count > 0) {
+        LARGE_INTEGER offset = {};
+        offset.QuadPart = read_control->index_entry[0].offset;
+        if (!SetFilePointerEx(handle_file, offset, NULL, FILE_BEGIN) ||
+            !ReadFileAll(handle_file, &frame_header, sizeof(IscResultRecordFrameHeader))) {
+            ret = CAMCONTROL_E_READ_FILE_FAILED;
+        }
+    }
+
+    if (ret != DPC_E_OK) {
+        CloseFile();
+        LeaveCriticalSection(&read_control->critical);
+        return ret;
+    }
+
+    information->frame_count = read_control->index_count;
+    if (read_control->index_count > 0) {
+        information->start_time = read_control->index_entry[0].frame_time;
+        information->end_time = read_control->index_entry[read_control->index_count - 1].frame_time;
+    }
+    information->image_width = frame_header.image_width;
+    information->image_height = frame_header.image_height;
+    information->block_width = frame_header.block_width;
+    information->block_height = frame_header.block_height;
+    information->block_count_x = frame_header.block_count_x;
+    information->block_count_y = frame_header.block_count_y;
+    information->subpixel_times = file_header->subpixel_times;
+    information->key_frame_interval = file_header->key_frame_interval;
+
+    read_control->decoded_frame_number = -1;
+    *isc_result_record_information = *information;
+
+    LeaveCriticalSection(&read_control->critical);
+
+    if (isc_log_ != nullptr) {
+        wchar_t log_msg[512] = {};
+        swprintf_s(log_msg, L"Result record open file=%s frames=%I64d index=%d\n", file_name, information->frame_count, (int)information->has_index);
+        isc_log_->LogInfo(L"IscRecordControl", log_msg);
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 指定のFrameを読み込みます
+ *
+ * @param[in] frame_number Frame番号 0~frame_count-1
+ * @param[in,out] isc_result_record_frame 読み込み先とFrameの情報
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 前のKey Frameから順に復号します。続けて次のFrameを読み込む場合は、そのFrameのみ復号します
+ */
+int IscRecordControl::ReadFrame(const __int64 frame_number, IscResultRecordFrame* isc_result_record_frame)
+{
+    if (isc_result_record_frame == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    ReadControl* read_control = &read_control_;
+
+    EnterCriticalSection(&read_control->critical);
+
+    if (read_control->handle_file == NULL) {
+        LeaveCriticalSection(&read_control->critical);
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (frame_number < 0 || frame_number >= read_control->index_count) {
+        LeaveCriticalSection(&read_control->critical);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (read_control->decoded_frame_number != frame_number) {
+        int ret = DecodeFrame(read_control, frame_number);
+        if (ret != DPC_E_OK) {
+            read_control->decoded_frame_number = -1;
+            LeaveCriticalSection(&read_control->critical);
+            return ret;
+        }
+    }
+
+    const FrameBuffer* frame_buffer = &read_control->frame_buffer;
+    const IscResultRecordFrameHeader* frame_header = &frame_buffer->frame_header;
+
+    isc_result_record_frame->frame_time = frame_header->frame_time;
+    isc_result_record_frame->frame_index = frame_header->frame_index;
+    isc_result_record_frame->image_width = frame_header->image_width;
+    isc_result_record_frame->image_height = frame_header->image_height;
+    isc_result_record_frame->block_width = frame_header->block_width;
+    isc_result_record_frame->block_height = frame_header->block_height;
+    isc_result_record_frame->block_count_x = frame_header->block_count_x;
+    isc_result_record_frame->block_count_y = frame_header->block_count_y;
+
+    const int block_count = frame_buffer->block_count;
+    const bool has_buffer = isc_result_record_frame->block_disparity != nullptr || isc_result_record_frame->block_value != nullptr;
+    if (has_buffer && isc_result_record_frame->buffer_count < block_count) {
+        LeaveCriticalSection(&read_control->critical);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_result_record_frame->block_value != nullptr) {
+        memcpy(isc_result_record_frame->block_value, frame_buffer->value, block_count * sizeof(unsigned short));
+    }
+
+    if (isc_result_record_frame->block_disparity != nullptr) {
+        const float scale = 1.0F / (float)read_control->file_header.subpixel_times;
+        for (int i = 0; i < block_count; i++) {
+            isc_result_record_frame->block_disparity[i] = (float)frame_buffer->value[i] * scale;
+        }
+    }
+
+    LeaveCriticalSection(&read_control->critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 読み込むファイルを閉じます
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscRecordControl::CloseFile()
+{
+    ReadControl* read_control = &read_control_;
+
+    EnterCriticalSection(&read_control->critical);
+
+    if (read_control->handle_file != NULL) {
+        CloseHandle(read_control->handle_file);
+        read_control->handle_file = NULL;
+    }
+
+    delete[] read_control->index_entry;
+    read_control->index_entry = nullptr;
+    read_control->index_count = 0;
+    read_control->index_capacity = 0;
+    read_control->decoded_frame_number = -1;
+    memset(&read_control->information, 0, sizeof(IscResultRecordInformation));
+
+    LeaveCriticalSection(&read_control->critical);
+
+    return DPC_E_OK;
+}
+
+/**
+ * ブロック数に合わせてバッファーを確保します
+ *
+ * @param[in,out] frame_buffer バッファー
+ * @param[in] block_count ブロック数
+ * @retval true 成功
+ * @retval false 失敗
+ * @note 確保し直した場合、前Frameの値は失われます。ブロック数が変わる場合はKey Frameです
+ */
+bool IscRecordControl::AllocateFrameBuffer(FrameBuffer* frame_buffer, const int block_count)
+{
+    if (block_count <= 0) {
+        return false;
+    }
+
+    if (block_count > frame_buffer->capacity) {
+        ReleaseFrameBuffer(frame_buffer);
+
+        frame_buffer->value = new unsigned short[block_count];
+        frame_buffer->previous_value = new unsigned short[block_count];
+        frame_buffer->plane[0] = new unsigned char[block_count];
+        frame_buffer->plane[1] = new unsigned char[block_count];
+        frame_buffer->coded = new unsigned char[(size_t)block_count * 2];
+        frame_buffer->capacity = block_count;
+
+        memset(frame_buffer->previous_value, 0, block_count * sizeof(unsigned short));
+    }
+    frame_buffer->block_count = block_count;
+
+    return true;
+}
+
+/**
+ * バッファーを解放します
+ *
+ * @param[in,out] frame_buffer バッファー
+ * @return none
+ */
+void IscRecordControl::ReleaseFrameBuffer(FrameBuffer* frame_buffer)
+{
+    delete[] frame_buffer->value;
+    delete[] frame_buffer->previous_value;
+    delete[] frame_buffer->plane[0];
+    delete[] frame_buffer->plane[1];
+    delete[] frame_buffer->coded;
+
+    frame_buffer->value = nullptr;
+    frame_buffer->previous_value = nullptr;
+    frame_buffer->plane[0] = nullptr;
+    frame_buffer->plane[1] = nullptr;
+    frame_buffer->coded = nullptr;
+    frame_buffer->capacity = 0;
+    frame_buffer->block_count = 0;
+
+    return;
+}
+
+/**
+ * Indexに追加します
+ *
+ * @param[in,out] index_entry Index
+ * @param[in,out] index_capacity 確保した数
+ * @param[in] index_count 追加前の数
+ * @param[in] entry 追加する値
+ * @retval true 成功
+ * @retval false 失敗
+ */
+bool IscRecordControl::AddIndexEntry(IscResultRecordIndexEntry** index_entry, __int64* index_capacity, const __int64 index_count, const IscResultRecordIndexEntry* entry)
+{
+    if (index_count >= *index_capacity) {
+        const __int64 capacity = *index_capacity + kISC_RESULT_RECORD_INDEX_GROW_COUNT;
+        IscResultRecordIndexEntry* new_entry = new IscResultRecordIndexEntry[capacity];
+        if (*index_entry != nullptr) {
+            memcpy(new_entry, *index_entry, (size_t)index_count * sizeof(IscResultRecordIndexEntry));
+            delete[] *index_entry;
+        }
+        *index_entry = new_entry;
+        *index_capacity = capacity;
+    }
+
+    (*index_entry)[index_count] = *entry;
+
+    return true;
+}
+
+/**
+ * ファイルを走査してIndexを作成します
+ *
+ * @param[in,out] read_control 読み込み制御
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 書き込み途中の不完全なFrameで終了します
+ */
+int IscRecordControl::BuildIndex(ReadControl* read_control)
+{
+    LARGE_INTEGER file_size = {};
+    if (!GetFileSizeEx(read_control->handle_file, &file_size)) {
+        return CAMCONTROL_E_READ_FILE_FAILED;
+    }
+
+    __int64 offset = read_control->file_header.header_size;
+    read_control->index_count = 0;
+
+    while (offset + (__int64)sizeof(IscResultRecordFrameHeader) <= file_size.QuadPart) {
+        LARGE_INTEGER position = {};
+        position.QuadPart = offset;
+
+        IscResultRecordFrameHeader frame_header = {};
+        if (!SetFilePointerEx(read_control->handle_file, position, NULL, FILE_BEGIN) ||
+            !ReadFileAll(read_control->handle_file, &frame_header, sizeof(IscResultRecordFrameHeader))) {
+            break;
+        }
+
+        if (frame_header.block_count_x <= 0 || frame_header.block_count_y <= 0 ||
+            frame_header.plane_size[0] <= 0 || frame_header.plane_size[1] <= 0) {
+            break;
+        }
+
+        const __int64 frame_size = sizeof(IscResultRecordFrameHeader) + (__int64)frame_header.plane_size[0] + frame_header.plane_size[1];
+        if (offset + frame_size > file_size.QuadPart) {
+            break;
+        }
+
+        IscResultRecordIndexEntry entry = {};
+        entry.offset = offset;
+        entry.frame_time = frame_header.frame_time;
+        entry.flags = frame_header.flags;
+        if (!AddIndexEntry(&read_control->index_entry, &read_control->index_capacity, read_control->index_count, &entry)) {
+            return ISCDPL_E_FAIL;
+        }
+        read_control->index_count++;
+
+        offset += frame_size;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 指定のFrameを復号します
+ *
+ * @param[in,out] read_control 読み込み制御
+ * @param[in] frame_number Frame番号
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 前のKey Frame、または復号済みの前Frameから順に復号します
+ */
+int IscRecordControl::DecodeFrame(ReadControl* read_control, const __int64 frame_number)
+{
+    // first frame to decode
+    __int64 start_frame_number = frame_number;
+    while ((read_control->index_entry[start_frame_number].flags & kISC_RESULT_RECORD_FRAME_KEY) == 0) {
+        if (start_frame_number - 1 == read_control->decoded_frame_number) {
+            break;
+        }
+        if (start_frame_number == 0) {
+            return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+        }
+        start_frame_number--;
+    }
+
+    FrameBuffer* frame_buffer = &read_control->frame_buffer;
+
+    for (__int64 n = start_frame_number; n <= frame_number; n++) {
+        const IscResultRecordIndexEntry* entry = &read_control->index_entry[n];
+
+        LARGE_INTEGER position = {};
+        position.QuadPart = entry->offset;
+
+        IscResultRecordFrameHeader frame_header = {};
+        if (!SetFilePointerEx(read_control->handle_file, position, NULL, FILE_BEGIN) ||
+            !ReadFileAll(read_control->handle_file, &frame_header, sizeof(IscResultRecordFrameHeader))) {
+            return CAMCONTROL_E_READ_FILE_FAILED;
+        }
+
+        const bool is_key_frame = (frame_header.flags & kISC_RESULT_RECORD_FRAME_KEY) != 0;
+        const int block_count_x = frame_header.block_count_x;
+        const int block_count_y = frame_header.block_count_y;
+        if (block_count_x <= 0 || block_count_y <= 0) {
+            return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+        }
+
+        // the grid is not changed without a key frame
+        if (!is_key_frame &&
+            (frame_buffer->frame_header.block_count_x != block_count_x || frame_buffer->frame_header.block_count_y != block_count_y)) {
+            return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+        }
+
+        const int block_count = block_count_x * block_count_y;
+        if (!AllocateFrameBuffer(frame_buffer, block_count)) {
+            return ISCDPL_E_FAIL;
+        }
+
+        for (int p = 0; p < 2; p++) {
+            const int plane_size = frame_header.plane_size[p];
+            const bool is_stored = (frame_header.plane_flags[p] & kISC_RESULT_RECORD_PLANE_STORED) != 0;
+            if (plane_size <= 0 || plane_size > block_count || (is_stored && plane_size != block_count)) {
+                return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+            }
+        }
+
+        unsigned char* coded = frame_buffer->coded;
+        if (!ReadFileAll(read_control->handle_file, coded, (size_t)frame_header.plane_size[0] + frame_header.plane_size[1])) {
+            return CAMCONTROL_E_READ_FILE_FAILED;
+        }
+
+        const unsigned char* src = coded;
+        for (int p = 0; p < 2; p++) {
+            if ((frame_header.plane_flags[p] & kISC_RESULT_RECORD_PLANE_STORED) != 0) {
+                memcpy(frame_buffer->plane[p], src, block_count);
+            }
+            else if (!DecodePlane(src, frame_header.plane_size[p], frame_buffer->plane[p], block_count)) {
+                return CAMCONTROL_E_INVALID_COMPRESSED_DATA;
+            }
+            src += frame_header.plane_size[p];
+        }
+
+        // the previous frame is the prediction
+        unsigned short* previous_value = frame_buffer->value;
+        unsigned short* value = frame_buffer->previous_value;
+        frame_buffer->previous_value = previous_value;
+        frame_buffer->value = value;
+
+        const unsigned char* plane_low = frame_buffer->plane[0];
+        const unsigned char* plane_high = frame_buffer->plane[1];
+        for (int y = 0; y < block_count_y; y++) {
+            for (int x = 0; x < block_count_x; x++) {
+                const int index = y * block_count_x + x;
+                const unsigned short prediction = is_key_frame ? PredictKeyFrame(value, block_count_x, x, y) : previous_value[index];
+                const unsigned short z = (unsigned short)(plane_low[index] | (plane_high[index] << 8));
+                value[index] = (unsigned short)(prediction + UnZigZag(z));
+            }
+        }
+
+        frame_buffer->frame_header = frame_header;
+        read_control->decoded_frame_number = n;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 1 planeをrANSで符号化します
+ *
+ * @param[in] src 入力
+ * @param[in] count 入力のサイズ
+ * @param[out] dst 出力
+ * @param[in] dst_capacity 出力のサイズ
+ * @return 符号化したサイズ 入力より小さくならない場合は0
+ * @note 出力は、頻度表(256 x 2byte)、状態(4byte)とrANSのデータです
+ */
+int IscRecordControl::EncodePlane(const unsigned char* src, const int count, unsigned char* dst, const int dst_capacity)
+{
+    if (count <= 0 || dst_capacity <= kFrequencyTableSize + 4) {
+        return 0;
+    }
+
+    // frequency
+    uint32_t histogram[256] = {};
+    for (int i = 0; i < count; i++) {
+        histogram[src[i]]++;
+    }
+
+    uint16_t freq[256] = {};
+    if (!NormalizeFrequency(histogram, (uint32_t)count, freq)) {
+        return 0;
+    }
+
+    uint32_t cum[256] = {};
+    uint32_t cum_value = 0;
+    for (int s = 0; s < 256; s++) {
+        cum[s] = cum_value;
+        cum_value += freq[s];
+    }
+
+    // encode backward from the end of dst
+    unsigned char* const stream_start = dst + kFrequencyTableSize + 4;
+    unsigned char* const end = dst + dst_capacity;
+    unsigned char* ptr = end;
+    uint32_t x = kRansByteL;
+
+    for (int i = count - 1; i >= 0; i--) {
+        const unsigned char s = src[i];
+        const uint32_t x_max = ((kRansByteL >> kRansScaleBits) << 8) * freq[s];
+        while (x >= x_max) {
+            if (ptr <= stream_start) {
+                return 0;
+            }
+            *--ptr = (unsigned char)(x & 0xff);
+            x >>= 8;
+        }
+        x = ((x / freq[s]) << kRansScaleBits) + (x % freq[s]) + cum[s];
+    }
+
+    const int stream_size = (int)(end - ptr);
+    memmove(stream_start, ptr, stream_size);
+
+    memcpy(dst, freq, kFrequencyTableSize);
+    dst[kFrequencyTableSize + 0] = (unsigned char)(x >> 0);
+    dst[kFrequencyTableSize + 1] = (unsigned char)(x >> 8);
+    dst[kFrequencyTableSize + 2] = (unsigned char)(x >> 16);
+    dst[kFrequencyTableSize + 3] = (unsigned char)(x >> 24);
+
+    const int coded_size = kFrequencyTableSize + 4 + stream_size;
+
+    return (coded_size < count) ? coded_size : 0;
+}
+
+/**
+ * 1 planeを復号します
+ *
+ * @param[in] src 入力
+ * @param[in] src_size 入力のサイズ
+ * @param[out] dst 出力
+ * @param[in] count 出力のサイズ
+ * @retval true 成功
+ * @retval false 失敗
+ */
+bool IscRecordControl::DecodePlane(const unsigned char* src, const int src_size, unsigned char* dst, const int count)
+{
+    if (src_size < kFrequencyTableSize + 4) {
+        return false;
+    }
+
+    // frequency
+    uint16_t freq[256] = {};
+    memcpy(freq, src, kFrequencyTableSize);
+
+    uint32_t cum[256] = {};
+    uint32_t cum_value = 0;
+    for (int s = 0; s < 256; s++) {
+        cum[s] = cum_value;
+        cum_value += freq[s];
+    }
+    if (cum_value != kRansScale) {
+        return false;
+    }
+
+    unsigned char slot_to_symbol[kRansScale];
+    for (int s = 0; s < 256; s++) {
+        memset(&slot_to_symbol[cum[s]], s, freq[s]);
+    }
+
+    // decode
+    const unsigned char* ptr = src + kFrequencyTableSize;
+    const unsigned char* end = src + src_size;
+
+    uint32_t x = (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+    ptr += 4;
+
+    for (int i = 0; i < count; i++) {
+        const unsigned char s = slot_to_symbol[x & (kRansScale - 1)];
+        x = freq[s] * (x >> kRansScaleBits) + (x & (kRansScale - 1)) - cum[s];
+        while (x < kRansByteL) {
+            if (ptr >= end) {
+                return false;
+            }
+            x = (x << 8) | *ptr++;
+        }
+        dst[i] = s;
+    }
+
+    return true;
+}
+
+/**
+ * 指定サイズを全て書き込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[in] data データ
+ * @param[in] size サイズ
+ * @retval true 成功
+ * @retval false 失敗
+ */
+bool IscRecordControl::WriteFileAll(HANDLE handle_file, const void* data, const size_t size)
+{
+    const unsigned char* src = (const unsigned char*)data;
+    size_t remain = size;
+
+    while (remain > 0) {
+        const DWORD request_size = (remain > MAXDWORD) ? MAXDWORD : (DWORD)remain;
+        DWORD written_size = 0;
+        if (!WriteFile(handle_file, src, request_size, &written_size, NULL) || written_size != request_size) {
+            return false;
+        }
+        src += written_size;
+        remain -= written_size;
+    }
+
+    return true;
+}
+
+/**
+ * 指定サイズを全て読み込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[out] data データ
+ * @param[in] size サイズ
+ * @retval true 成功
+ * @retval false 失敗
+ */
+bool IscRecordControl::ReadFileAll(HANDLE handle_file, void* data, const size_t size)
+{
+    unsigned char* dst = (unsigned char*)data;
+    size_t remain = size;
+
+    while (remain > 0) {
+        const DWORD request_size = (remain > MAXDWORD) ? MAXDWORD : (DWORD)remain;
+        DWORD read_size = 0;
+        if (!ReadFile(handle_file, dst, request_size, &read_size, NULL) || read_size != request_size) {
+            return false;
+        }
+        dst += read_size;
+        remain -= read_size;
+    }
 
+    return true;
+}
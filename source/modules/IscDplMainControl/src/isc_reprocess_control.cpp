@@ -0,0 +1,625 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_reprocess_control.cpp
+ * @brief This class reprocesses a range of the RAW data file without the camera
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ *
+ * @details This class reprocesses a range of the RAW data file without the camera.
+ * @note
+ *  - 読み込みとデータ処理は呼び出し元のThreadで行い、全てのFrameを処理します
+ *  - データ処理モジュールは内部状態をプロセスで共有するため、範囲の並列処理はプロセス単位で行います
+ *  - 範囲の境界は、mono/colorの組とDouble Shutterの組を分けないようにkISC_REPROCESS_RANGE_ALIGNMENTに合わせます
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <process.h>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+#include "isc_thread_placement.h"
+
+#include "isc_image_info_ring_buffer.h"
+#include "isc_raw_file_index.h"
+#include "isc_raw_data_codec.h"
+#include "isc_raw_file_stripe.h"
+#include "isc_async_file_writer.h"
+#include "vm_sdk_wrapper.h"
+#include "xc_sdk_wrapper.h"
+#include "k4a_sdk_wrapper.h"
+#include "isc_sdk_control.h"
+#include "isc_file_write_control_impl.h"
+#include "isc_raw_data_decoder.h"
+#include "isc_decoded_frame_cache.h"
+#include "isc_file_read_control_impl.h"
+#include "isc_selftcalibration_interface.h"
+#include "isc_camera_control.h"
+#include "isc_dataproc_resultdata_ring_buffer.h"
+#include "isc_framedecoder_interface.h"
+#include "isc_stereomatching_interface.h"
+#include "isc_disparityfilter_interface.h"
+#include "isc_data_processing_control.h"
+
+#include "isc_reprocess_control.h"
+
+// mark of the result file
+constexpr char kISC_REPROCESS_RESULT_MARK[] = "ISC REPROCESS RESULT";
+
+// size of the copy when merging
+constexpr DWORD kISC_REPROCESS_MERGE_COPY_SIZE = 4 * 1024 * 1024;
+
+/**
+ * constructor
+ *
+ */
+IscReprocessControl::IscReprocessControl():
+    isc_log_(nullptr),
+    frequency_()
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscReprocessControl::~IscReprocessControl()
+{
+
+}
+
+/**
+ * クラスを初期化します.
+ *
+ * @param[in] isc_log ログ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscReprocessControl::Initialize(IscLog* isc_log)
+{
+    isc_log_ = isc_log;
+
+    QueryPerformanceFrequency(&frequency_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします.
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscReprocessControl::Terminate()
+{
+    isc_log_ = nullptr;
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルを同程度のレコード数の範囲に分割します
+ *
+ * @param[in] isc_camera_control カメラ制御
+ * @param[in] play_file_name ファイル名
+ * @param[in] range_count 分割数 1~kISC_REPROCESS_MAX_RANGE_COUNT
+ * @param[out] isc_reprocess_range_list 分割結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note レコード数が少ない場合は、range_countより少なくなります
+ */
+int IscReprocessControl::MakeRanges(IscCameraControl* isc_camera_control, const wchar_t* play_file_name, const int range_count, IscReprocessRangeList* isc_reprocess_range_list)
+{
+    if (isc_camera_control == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (play_file_name == nullptr || isc_reprocess_range_list == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (range_count < 1 || range_count > kISC_REPROCESS_MAX_RANGE_COUNT) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    memset(isc_reprocess_range_list, 0, sizeof(IscReprocessRangeList));
+
+    IscRawFileHeader raw_file_header = {};
+    IscPlayFileInformation play_file_information = {};
+    int ret = GetRawFileInformation(isc_camera_control, play_file_name, &raw_file_header, &play_file_information);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    const __int64 total_frame_count = play_file_information.total_frame_count;
+    isc_reprocess_range_list->total_frame_count = total_frame_count;
+    if (total_frame_count <= 0) {
+        return DPC_E_OK;
+    }
+
+    // split by the unit of alignment
+    const __int64 unit_count = (total_frame_count + kISC_REPROCESS_RANGE_ALIGNMENT - 1) / kISC_REPROCESS_RANGE_ALIGNMENT;
+
+    for (int i = 0; i < range_count; i++) {
+        const __int64 start_frame_number = (unit_count * i / range_count) * kISC_REPROCESS_RANGE_ALIGNMENT;
+        __int64 end_frame_number = (unit_count * (i + 1) / range_count) * kISC_REPROCESS_RANGE_ALIGNMENT;
+        if (end_frame_number > total_frame_count) {
+            end_frame_number = total_frame_count;
+        }
+
+        if (start_frame_number >= end_frame_number) {
+            continue;
+        }
+
+        IscReprocessRangeList::Range* range = &isc_reprocess_range_list->range[isc_reprocess_range_list->range_count];
+        range->start_frame_number = start_frame_number;
+        range->end_frame_number = end_frame_number;
+        isc_reprocess_range_list->range_count++;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルの範囲を処理し、結果ファイルに書き込みます
+ *
+ * @param[in] isc_camera_control カメラ制御
+ * @param[in] isc_data_processing_control データ処理制御
+ * @param[in] isc_reprocess_parameter パラメータ
+ * @param[out] isc_reprocess_status 処理結果
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 取り込みを停止した状態で呼び出します。範囲の処理が終わるまで戻りません
+ */
+int IscReprocessControl::ProcessRange(IscCameraControl* isc_camera_control, IscDataProcessingControl* isc_data_processing_control,
+    const IscReprocessParameter* isc_reprocess_parameter, IscReprocessStatus* isc_reprocess_status)
+{
+    if (isc_camera_control == nullptr || isc_data_processing_control == nullptr) {
+        return ISCDPL_E_INVALID_HANDLE;
+    }
+
+    if (isc_reprocess_parameter == nullptr || isc_reprocess_status == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    memset(isc_reprocess_status, 0, sizeof(IscReprocessStatus));
+
+    IscRawFileHeader raw_file_header = {};
+    IscPlayFileInformation play_file_information = {};
+    int ret = GetRawFileInformation(isc_camera_control, isc_reprocess_parameter->play_file_name, &raw_file_header, &play_file_information);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    // range
+    const __int64 total_frame_count = play_file_information.total_frame_count;
+    const __int64 start_frame_number = isc_reprocess_parameter->start_frame_number;
+    __int64 end_frame_number = isc_reprocess_parameter->end_frame_number;
+    if (end_frame_number < 0 || end_frame_number > total_frame_count) {
+        end_frame_number = total_frame_count;
+    }
+    if (start_frame_number < 0 || start_frame_number >= end_frame_number) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    // read all records of the range as fast as possible
+    IscGrabStartMode isc_grab_start_mode = {};
+    switch (raw_file_header.grab_mode) {
+    case 1: isc_grab_start_mode.isc_grab_mode = IscGrabMode::kParallax; break;
+    case 2: isc_grab_start_mode.isc_grab_mode = IscGrabMode::kCorrect; break;
+    case 3: isc_grab_start_mode.isc_grab_mode = IscGrabMode::kBeforeCorrect; break;
+    case 4: isc_grab_start_mode.isc_grab_mode = IscGrabMode::kBayerS0; break;
+    default: isc_grab_start_mode.isc_grab_mode = IscGrabMode::kParallax; break;
+    }
+    isc_grab_start_mode.isc_grab_color_mode = (raw_file_header.color_mode == 0) ? IscGrabColorMode::kColorOFF : IscGrabColorMode::kColorON;
+    isc_grab_start_mode.isc_get_mode.wait_time = 0;
+    isc_grab_start_mode.isc_get_raw_mode = IscGetModeRaw::kRawOn;
+    isc_grab_start_mode.isc_get_color_mode = IscGetModeColor::kCorrect;
+    isc_grab_start_mode.isc_record_mode = IscRecordMode::kRecordOff;
+    isc_grab_start_mode.isc_play_mode = IscPlayMode::kPlayOn;
+    isc_grab_start_mode.isc_play_mode_parameter.interval = 0;
+    isc_grab_start_mode.isc_play_mode_parameter.pacing_mode = IscPlayPacingMode::kMaximumSpeed;
+    isc_grab_start_mode.isc_play_mode_parameter.fixed_rate = 0;
+    isc_grab_start_mode.isc_play_mode_parameter.follow_growing_file = false;
+    swprintf_s(isc_grab_start_mode.isc_play_mode_parameter.play_file_name, L"%s", isc_reprocess_parameter->play_file_name);
+
+    // result file
+    HANDLE handle_file = CreateFile(isc_reprocess_parameter->result_file_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE) {
+        return CAMCONTROL_E_CREATE_SAVE_FILE;
+    }
+
+    IscReprocessResultFileHeader result_file_header = {};
+    strcpy_s(result_file_header.mark, sizeof(result_file_header.mark), kISC_REPROCESS_RESULT_MARK);
+    result_file_header.version = ISC_REPROCESS_RESULT_HEADER_VERSION;
+    result_file_header.header_size = sizeof(IscReprocessResultFileHeader);
+    result_file_header.frame_header_size = sizeof(IscReprocessResultFrameHeader);
+    result_file_header.start_frame_number = start_frame_number;
+    result_file_header.end_frame_number = start_frame_number;
+    result_file_header.frame_count = 0;
+    result_file_header.raw_file_header = raw_file_header;
+
+    if (!WriteFileAll(handle_file, &result_file_header, sizeof(result_file_header))) {
+        CloseHandle(handle_file);
+        return CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    // buffers
+    IscImageInfo* isc_image_info = new IscImageInfo;
+    memset(isc_image_info, 0, sizeof(IscImageInfo));
+    IscDataProcResultData* isc_data_proc_result_data = new IscDataProcResultData;
+    memset(isc_data_proc_result_data, 0, sizeof(IscDataProcResultData));
+
+    isc_camera_control->InitializeIscIamgeinfo(isc_image_info);
+    isc_data_processing_control->InitializeIscDataProcResultData(isc_data_proc_result_data);
+
+    wchar_t log_msg[512] = {};
+    swprintf_s(log_msg, L"Reprocess start file=%s range=%I64d-%I64d\n", isc_reprocess_parameter->play_file_name, start_frame_number, end_frame_number);
+    isc_log_->LogInfo(L"IscReprocessControl", log_msg);
+
+    LARGE_INTEGER start_counter = {};
+    QueryPerformanceCounter(&start_counter);
+
+    int result = isc_data_processing_control->Start(&isc_grab_start_mode, &isc_reprocess_parameter->isc_dataproc_start_mode);
+    if (result == DPC_E_OK) {
+        result = isc_camera_control->Start(&isc_grab_start_mode);
+    }
+
+    if (result == DPC_E_OK && start_frame_number > 0) {
+        result = isc_camera_control->SetReadFrameNumber(start_frame_number);
+    }
+
+    __int64 frame_number = start_frame_number;
+    while (result == DPC_E_OK && frame_number < end_frame_number) {
+
+        int read_ret = isc_camera_control->GetData(isc_image_info);
+        if (read_ret == CAMCONTROL_E_NO_IMAGE) {
+            // end of the file
+            break;
+        }
+        else if (read_ret != DPC_E_OK) {
+            result = read_ret;
+            break;
+        }
+
+        const IscBlockDisparityData* isc_block_disparity_data = nullptr;
+        int dp_ret = isc_data_processing_control->RunOffline(isc_image_info, isc_data_proc_result_data, &isc_block_disparity_data);
+        if (dp_ret != DPC_E_OK) {
+            isc_reprocess_status->failed_frame_count++;
+        }
+
+        int write_ret = WriteResultFrame(handle_file, frame_number, dp_ret, isc_reprocess_parameter, isc_image_info, isc_data_proc_result_data,
+            (dp_ret == DPC_E_OK) ? isc_block_disparity_data : nullptr);
+        if (write_ret != DPC_E_OK) {
+            result = write_ret;
+            break;
+        }
+        isc_reprocess_status->processed_frame_count++;
+
+        // the reading advances by the records of the frame
+        IscFileReadStatus file_read_status = IscFileReadStatus::kNotReady;
+        __int64 next_frame_number = -1;
+        isc_camera_control->GetFileReadStatus(&next_frame_number, &file_read_status);
+        if (next_frame_number <= frame_number) {
+            break;
+        }
+        frame_number = next_frame_number;
+    }
+
+    isc_camera_control->Stop();
+    isc_data_processing_control->Stop();
+
+    LARGE_INTEGER end_counter = {};
+    QueryPerformanceCounter(&end_counter);
+
+    if (frame_number > end_frame_number) {
+        frame_number = end_frame_number;
+    }
+
+    // complete the header
+    result_file_header.end_frame_number = frame_number;
+    result_file_header.frame_count = isc_reprocess_status->processed_frame_count;
+
+    LARGE_INTEGER move = {};
+    if (!SetFilePointerEx(handle_file, move, NULL, FILE_BEGIN) || !WriteFileAll(handle_file, &result_file_header, sizeof(result_file_header))) {
+        if (result == DPC_E_OK) {
+            result = CAMCONTROL_E_WRITE_FAILED;
+        }
+    }
+    CloseHandle(handle_file);
+
+    isc_data_processing_control->ReleaeIscDataProcResultData(isc_data_proc_result_data);
+    isc_camera_control->ReleaeIscIamgeinfo(isc_image_info);
+    delete isc_data_proc_result_data;
+    delete isc_image_info;
+
+    isc_reprocess_status->start_frame_number = start_frame_number;
+    isc_reprocess_status->end_frame_number = frame_number;
+    isc_reprocess_status->elapsed_time_msec = (double)(end_counter.QuadPart - start_counter.QuadPart) * 1000.0 / (double)frequency_.QuadPart;
+    if (isc_reprocess_status->elapsed_time_msec > 0) {
+        isc_reprocess_status->frames_per_second = (double)isc_reprocess_status->processed_frame_count * 1000.0 / isc_reprocess_status->elapsed_time_msec;
+    }
+
+    swprintf_s(log_msg, L"Reprocess ended (0x%08X) frames=%I64d failed=%I64d time=%.1f(ms) fps=%.2f\n", result,
+        isc_reprocess_status->processed_frame_count, isc_reprocess_status->failed_frame_count,
+        isc_reprocess_status->elapsed_time_msec, isc_reprocess_status->frames_per_second);
+    isc_log_->LogInfo(L"IscReprocessControl", log_msg);
+
+    return result;
+}
+
+/**
+ * 範囲の結果ファイルを順に結合します
+ *
+ * @param[in] isc_reprocess_merge_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 範囲が連続していない場合は失敗します
+ */
+int IscReprocessControl::MergeResults(const IscReprocessMergeParameter* isc_reprocess_merge_parameter)
+{
+    if (isc_reprocess_merge_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const int range_file_count = isc_reprocess_merge_parameter->range_file_count;
+    if (range_file_count < 1 || range_file_count > kISC_REPROCESS_MAX_RANGE_COUNT) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    HANDLE handle_file = CreateFile(isc_reprocess_merge_parameter->result_file_name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (handle_file == INVALID_HANDLE_VALUE) {
+        return CAMCONTROL_E_CREATE_SAVE_FILE;
+    }
+
+    unsigned char* copy_buffer = new unsigned char[kISC_REPROCESS_MERGE_COPY_SIZE];
+
+    IscReprocessResultFileHeader merged_file_header = {};
+    int result = DPC_E_OK;
+
+    for (int i = 0; i < range_file_count && result == DPC_E_OK; i++) {
+        HANDLE handle_range_file = CreateFile(isc_reprocess_merge_parameter->range_file_name[i], GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (handle_range_file == INVALID_HANDLE_VALUE) {
+            result = CAMCONTROL_E_OPEN_READ_FILE_FAILED;
+            break;
+        }
+
+        IscReprocessResultFileHeader range_file_header = {};
+        if (!ReadFileAll(handle_range_file, &range_file_header, sizeof(range_file_header)) ||
+            strncmp(range_file_header.mark, kISC_REPROCESS_RESULT_MARK, sizeof(range_file_header.mark)) != 0 ||
+            range_file_header.version != ISC_REPROCESS_RESULT_HEADER_VERSION ||
+            range_file_header.header_size != sizeof(IscReprocessResultFileHeader)) {
+            CloseHandle(handle_range_file);
+            result = CAMCONTROL_E_READ_FILE_FAILED;
+            break;
+        }
+
+        if (i == 0) {
+            merged_file_header = range_file_header;
+            merged_file_header.frame_count = 0;
+
+            if (!WriteFileAll(handle_file, &merged_file_header, sizeof(merged_file_header))) {
+                CloseHandle(handle_range_file);
+                result = CAMCONTROL_E_WRITE_FAILED;
+                break;
+            }
+        }
+        else if (range_file_header.start_frame_number != merged_file_header.end_frame_number) {
+            // the ranges must be continuous
+            CloseHandle(handle_range_file);
+            result = ISCDPL_E_INVALID_PARAMETER;
+            break;
+        }
+
+        // frames
+        for (;;) {
+            DWORD read_size = 0;
+            if (!ReadFile(handle_range_file, copy_buffer, kISC_REPROCESS_MERGE_COPY_SIZE, &read_size, NULL)) {
+                result = CAMCONTROL_E_READ_FILE_FAILED;
+                break;
+            }
+            if (read_size == 0) {
+                break;
+            }
+            if (!WriteFileAll(handle_file, copy_buffer, read_size)) {
+                result = CAMCONTROL_E_WRITE_FAILED;
+                break;
+            }
+        }
+        CloseHandle(handle_range_file);
+
+        merged_file_header.end_frame_number = range_file_header.end_frame_number;
+        merged_file_header.frame_count += range_file_header.frame_count;
+    }
+
+    delete[] copy_buffer;
+
+    if (result == DPC_E_OK) {
+        LARGE_INTEGER move = {};
+        if (!SetFilePointerEx(handle_file, move, NULL, FILE_BEGIN) || !WriteFileAll(handle_file, &merged_file_header, sizeof(merged_file_header))) {
+            result = CAMCONTROL_E_WRITE_FAILED;
+        }
+    }
+    CloseHandle(handle_file);
+
+    if (result != DPC_E_OK) {
+        DeleteFile(isc_reprocess_merge_parameter->result_file_name);
+        return result;
+    }
+
+    if (isc_reprocess_merge_parameter->delete_range_files) {
+        for (int i = 0; i < range_file_count; i++) {
+            DeleteFile(isc_reprocess_merge_parameter->range_file_name[i]);
+        }
+    }
+
+    wchar_t log_msg[512] = {};
+    swprintf_s(log_msg, L"Reprocess merged file=%s ranges=%d frames=%I64d\n", isc_reprocess_merge_parameter->result_file_name, range_file_count, merged_file_header.frame_count);
+    isc_log_->LogInfo(L"IscReprocessControl", log_msg);
+
+    return DPC_E_OK;
+}
+
+/**
+ * RAWデータファイルのヘッダーと情報を取得します
+ *
+ * @param[in] isc_camera_control カメラ制御
+ * @param[in] play_file_name ファイル名
+ * @param[out] raw_file_header ヘッダー
+ * @param[out] play_file_information 情報
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscReprocessControl::GetRawFileInformation(IscCameraControl* isc_camera_control, const wchar_t* play_file_name, IscRawFileHeader* raw_file_header, IscPlayFileInformation* play_file_information)
+{
+    wchar_t file_name[_MAX_PATH] = {};
+    swprintf_s(file_name, L"%s", play_file_name);
+
+    int ret = isc_camera_control->GetFileInformation(file_name, raw_file_header, play_file_information);
+    if (ret != DPC_E_OK) {
+        return ret;
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 1Frameの処理結果を書き込みます
+ *
+ * @param[in] handle_file 結果ファイル
+ * @param[in] frame_number RAWデータファイルのレコード番号
+ * @param[in] result_code モジュールの処理結果
+ * @param[in] isc_reprocess_parameter パラメータ
+ * @param[in] isc_image_info 入力データ
+ * @param[in] isc_data_proc_result_data 処理結果
+ * @param[in] isc_block_disparity_data ブロック視差 nullptrの場合は書き込みません
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscReprocessControl::WriteResultFrame(HANDLE handle_file, const __int64 frame_number, const int result_code, const IscReprocessParameter* isc_reprocess_parameter,
+    const IscImageInfo* isc_image_info, const IscDataProcResultData* isc_data_proc_result_data, const IscBlockDisparityData* isc_block_disparity_data)
+{
+    IscReprocessResultFrameHeader frame_header = {};
+    frame_header.frame_number = frame_number;
+    frame_header.frame_time = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frame_time;
+    frame_header.frame_index = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_LATEST].frameNo;
+    frame_header.result_code = result_code;
+
+    // block grid
+    const float* block_disparity = nullptr;
+    if (isc_reprocess_parameter->write_block_disparity && isc_block_disparity_data != nullptr &&
+        isc_block_disparity_data->image_width > 0 && isc_block_disparity_data->image_height > 0 &&
+        isc_block_disparity_data->blkwdt > 0 && isc_block_disparity_data->blkhgt > 0 && isc_block_disparity_data->pblkdsp != nullptr) {
+        frame_header.block_width = isc_block_disparity_data->blkwdt;
+        frame_header.block_height = isc_block_disparity_data->blkhgt;
+        frame_header.block_count_x = isc_block_disparity_data->image_width / isc_block_disparity_data->blkwdt;
+        frame_header.block_count_y = isc_block_disparity_data->image_height / isc_block_disparity_data->blkhgt;
+        block_disparity = isc_block_disparity_data->pblkdsp;
+    }
+
+    // disparity of each pixel, merged frame for double shutter
+    const int fd_index = (isc_image_info->shutter_mode == IscShutterMode::kDoubleShutter) ? kISCIMAGEINFO_FRAMEDATA_MERGED : kISCIMAGEINFO_FRAMEDATA_LATEST;
+    const IscImageInfo::DepthType* depth = &isc_data_proc_result_data->isc_image_info.frame_data[fd_index].depth;
+    if (isc_reprocess_parameter->write_depth && result_code == DPC_E_OK &&
+        depth->width > 0 && depth->height > 0 && depth->image != nullptr) {
+        frame_header.depth_width = depth->width;
+        frame_header.depth_height = depth->height;
+    }
+
+    if (!WriteFileAll(handle_file, &frame_header, sizeof(frame_header))) {
+        return CAMCONTROL_E_WRITE_FAILED;
+    }
+
+    if (block_disparity != nullptr) {
+        const size_t block_size = (size_t)frame_header.block_count_x * frame_header.block_count_y * sizeof(float);
+        if (!WriteFileAll(handle_file, block_disparity, block_size)) {
+            return CAMCONTROL_E_WRITE_FAILED;
+        }
+    }
+
+    if (frame_header.depth_width > 0) {
+        const size_t depth_size = (size_t)frame_header.depth_width * frame_header.depth_height * sizeof(float);
+        if (!WriteFileAll(handle_file, depth->image, depth_size)) {
+            return CAMCONTROL_E_WRITE_FAILED;
+        }
+    }
+
+    return DPC_E_OK;
+}
+
+/**
+ * 指定サイズを全て書き込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[in] data データ
+ * @param[in] size サイズ
+ * @retval true 成功
+ * @retval false 失敗
+ */
+bool IscReprocessControl::WriteFileAll(HANDLE handle_file, const void* data, const size_t size)
+{
+    const unsigned char* src = (const unsigned char*)data;
+    size_t remain = size;
+
+    while (remain > 0) {
+        const DWORD request_size = (remain > kISC_REPROCESS_MERGE_COPY_SIZE) ? kISC_REPROCESS_MERGE_COPY_SIZE : (DWORD)remain;
+        DWORD written_size = 0;
+        if (!WriteFile(handle_file, src, request_size, &written_size, NULL) || written_size != request_size) {
+            return false;
+        }
+        src += written_size;
+        remain -= written_size;
+    }
+
+    return true;
+}
+
+/**
+ * 指定サイズを全て読み込みます
+ *
+ * @param[in] handle_file ファイル
+ * @param[out] data データ
+ * @param[in] size サイズ
+ * @retval true 成功
+ * @retval false 失敗
+ */
+bool IscReprocessControl::ReadFileAll(HANDLE handle_file, void* data, const size_t size)
+{
+    unsigned char* dst = (unsigned char*)data;
+    size_t remain = size;
+
+    while (remain > 0) {
+        const DWORD request_size = (remain > kISC_REPROCESS_MERGE_COPY_SIZE) ? kISC_REPROCESS_MERGE_COPY_SIZE : (DWORD)remain;
+        DWORD read_size = 0;
+        if (!ReadFile(handle_file, dst, request_size, &read_size, NULL) || read_size != request_size) {
+            return false;
+        }
+        dst += read_size;
+        remain -= read_size;
+    }
+
+    return true;
+}
@@ -0,0 +1,635 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_uv_disparity.cpp
+ * @brief u-disparity and v-disparity class
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ * 
+ * @details This class builds the u-disparity and v-disparity from the block disparity.
+ * @note
+ *  - 画素に展開する前のBlock毎の整数の視差(x1000)を、そのまま集計します
+ *  - u-disparity は [視差][Blockの列]、v-disparity は [Blockの行][視差] です
+ *  - Blockの行をバンドに分割し、v-disparityは各バンドが直接書き込み、u-disparityはThread毎の部分集計を最後に統合します
+ *  - 地面の直線は v-disparity の各行で度数の大きい点からRANSACで求め、inlierの重み付き最小二乗で補正します
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <tchar.h>
+#include <stdint.h>
+#include <math.h>
+#include <mutex>
+#include <functional>
+
+#include "isc_dpl_error_def.h"
+#include "isc_dpl_def.h"
+#include "isc_log.h"
+#include "utility.h"
+#include "isc_band_worker.h"
+
+#include "isc_uv_disparity.h"
+
+constexpr int kISC_UV_MAX_DISPARITY_RESOLUTION = 16;            /**< 視差1画素あたりの最大のbin数 */
+constexpr int kISC_UV_MAX_BIN_COUNT = 4096;                     /**< 最大のbin数 */
+constexpr int kISC_UV_MAX_GROUND_ITERATION_COUNT = 10000;       /**< RANSACの最大の繰り返し数 */
+constexpr int kISC_UV_GROUND_POINTS_PER_ROW = 3;                /**< 地面の候補とするv-disparityの各行の点の数 */
+
+/**
+ * constructor
+ *
+ */
+IscUvDisparity::IscUvDisparity():
+    band_worker_(nullptr),
+    uv_critical_(), parameter_(), bin_count_(0), block_width_(0), block_height_(0), block_count_x_(0), block_count_y_(0),
+    u_disparity_(nullptr), v_disparity_(nullptr), max_block_count_x_(0), max_block_count_y_(0),
+    has_ground_line_(false), ground_slope_(0), ground_intercept_(0), ground_inlier_count_(0), ground_points_(nullptr),
+    frame_time_(0), frame_index_(0),
+    count_source_(), band_count_(0), band_job_()
+{
+    band_worker_ = new IscBandWorker;
+}
+
+
+/**
+ * destructor
+ *
+ */
+IscUvDisparity::~IscUvDisparity()
+{
+    delete band_worker_;
+    band_worker_ = nullptr;
+}
+
+/**
+ * クラスを初期化します
+ *
+ * @param[in] thread_count 集計に使用するスレッドの数 0:呼び出し元のスレッドで処理します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUvDisparity::Initialize(const int thread_count)
+{
+    if ((thread_count < 0) || (thread_count > kMaxBandCount)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    InitializeCriticalSection(&uv_critical_);
+
+    // 既定値 無効
+    parameter_.enabled = false;
+    parameter_.disparity_resolution = 1;
+    parameter_.max_disparity = 256;
+    parameter_.fit_ground_line = false;
+    parameter_.ground_min_count = 5;
+    parameter_.ground_tolerance = 2.0F;
+    parameter_.ground_iteration_count = 100;
+
+    // workers
+    if (band_worker_->Initialize(thread_count, RunBand, this) != 0) {
+        return ISCDPL_E_FAIL;
+    }
+    band_count_ = band_worker_->GetBandCount();
+
+    return DPC_E_OK;
+}
+
+/**
+ * 終了処理をします
+ *
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUvDisparity::Terminate()
+{
+    band_worker_->Terminate();
+
+    ReleaseBuffers();
+
+    DeleteCriticalSection(&uv_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 配置のためにBand workerのスレッドのハンドルを取得します
+ *
+ * @param[in] max_count thread_handleの数
+ * @param[out] thread_handle ハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUvDisparity::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+    if ((thread_handle == nullptr) || (thread_count == nullptr)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    band_worker_->GetThreadHandle(max_count, thread_handle, thread_count);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 集計の領域を解放します
+ *
+ * @return none
+ */
+void IscUvDisparity::ReleaseBuffers()
+{
+    delete[] u_disparity_;
+    u_disparity_ = nullptr;
+
+    delete[] v_disparity_;
+    v_disparity_ = nullptr;
+
+    delete[] ground_points_;
+    ground_points_ = nullptr;
+
+    for (int i = 0; i < kMaxBandCount; i++) {
+        delete[] band_job_[i].u_hits;
+        band_job_[i].u_hits = nullptr;
+    }
+
+    max_block_count_x_ = 0;
+    max_block_count_y_ = 0;
+    block_count_x_ = 0;
+    block_count_y_ = 0;
+
+    has_ground_line_ = false;
+    ground_inlier_count_ = 0;
+
+    return;
+}
+
+/**
+ * パラメータを設定します
+ *
+ * @param[in] isc_uv_disparity_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 集計結果は消去されます
+ */
+int IscUvDisparity::SetParameter(const IscUvDisparityParameter* isc_uv_disparity_parameter)
+{
+    if (isc_uv_disparity_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscUvDisparityParameter* parameter = isc_uv_disparity_parameter;
+
+    if ((parameter->disparity_resolution < 1) || (parameter->disparity_resolution > kISC_UV_MAX_DISPARITY_RESOLUTION) ||
+        (parameter->max_disparity < 1) || ((parameter->max_disparity * parameter->disparity_resolution) > kISC_UV_MAX_BIN_COUNT)) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (parameter->fit_ground_line) {
+        if ((parameter->ground_min_count < 1) || !(parameter->ground_tolerance > 0) ||
+            (parameter->ground_iteration_count < 1) || (parameter->ground_iteration_count > kISC_UV_MAX_GROUND_ITERATION_COUNT)) {
+            return ISCDPL_E_INVALID_PARAMETER;
+        }
+    }
+
+    EnterCriticalSection(&uv_critical_);
+
+    ReleaseBuffers();
+
+    parameter_ = *parameter;
+    bin_count_ = parameter_.max_disparity * parameter_.disparity_resolution;
+
+    frame_time_ = 0;
+    frame_index_ = 0;
+
+    LeaveCriticalSection(&uv_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * パラメータを取得します
+ *
+ * @param[out] isc_uv_disparity_parameter パラメータ
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUvDisparity::GetParameter(IscUvDisparityParameter* isc_uv_disparity_parameter)
+{
+    if (isc_uv_disparity_parameter == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&uv_critical_);
+    *isc_uv_disparity_parameter = parameter_;
+    LeaveCriticalSection(&uv_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 集計の領域を確保します
+ *
+ * @param[in] block_count_x 横方向のBlockの数
+ * @param[in] block_count_y 縦方向のBlockの数
+ * @return none
+ * @note 確保済みの大きさで足りる場合は何もしません
+ */
+void IscUvDisparity::AllocateBuffers(const int block_count_x, const int block_count_y)
+{
+    if ((block_count_x <= max_block_count_x_) && (block_count_y <= max_block_count_y_)) {
+        return;
+    }
+
+    const int max_block_count_x = (std::max)(block_count_x, max_block_count_x_);
+    const int max_block_count_y = (std::max)(block_count_y, max_block_count_y_);
+    ReleaseBuffers();
+
+    u_disparity_ = new int[(size_t)bin_count_ * max_block_count_x];
+    v_disparity_ = new int[(size_t)max_block_count_y * bin_count_];
+    ground_points_ = new GroundPoint[(size_t)max_block_count_y * kISC_UV_GROUND_POINTS_PER_ROW];
+
+    for (int i = 0; i < band_count_; i++) {
+        band_job_[i].u_hits = new int[(size_t)bin_count_ * max_block_count_x];
+    }
+
+    max_block_count_x_ = max_block_count_x;
+    max_block_count_y_ = max_block_count_y;
+
+    return;
+}
+
+/**
+ * Block毎の視差からu-disparity, v-disparityを作成します
+ *
+ * @param[in] isc_image_info データ構造体
+ * @param[in] isc_block_disparity_data Block毎の視差
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note データ処理Threadから呼び出されます
+ */
+int IscUvDisparity::Update(const IscImageInfo* isc_image_info, const IscBlockDisparityData* isc_block_disparity_data)
+{
+    if (isc_image_info == nullptr || isc_block_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    const IscBlockDisparityData* block_data = isc_block_disparity_data;
+    if (block_data->image_width <= 0 || block_data->image_height <= 0 ||
+        block_data->blkwdt <= 0 || block_data->blkhgt <= 0 || block_data->pblkval == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&uv_critical_);
+
+    if (!parameter_.enabled) {
+        LeaveCriticalSection(&uv_critical_);
+        return DPC_E_OK;
+    }
+
+    const int block_count_x = block_data->image_width / block_data->blkwdt;
+    const int block_count_y = block_data->image_height / block_data->blkhgt;
+    if (block_count_x <= 0 || block_count_y <= 0) {
+        LeaveCriticalSection(&uv_critical_);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+    AllocateBuffers(block_count_x, block_count_y);
+
+    block_width_ = block_data->blkwdt;
+    block_height_ = block_data->blkhgt;
+    block_count_x_ = block_count_x;
+    block_count_y_ = block_count_y;
+
+    int fd_index = kISCIMAGEINFO_FRAMEDATA_LATEST;
+    if (isc_image_info->shutter_mode == IscShutterMode::kDoubleShutter) {
+        // Double Shutterモードで、結合結果のデータがあれば、それを使用する
+        int temp_width = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.width;
+        int temp_height = isc_image_info->frame_data[kISCIMAGEINFO_FRAMEDATA_MERGED].depth.height;
+
+        if (temp_width > 0 && temp_height > 0) {
+            fd_index = kISCIMAGEINFO_FRAMEDATA_MERGED;
+        }
+    }
+
+    CountSource* source = &count_source_;
+    source->block_value = block_data->pblkval;
+    source->block_count_x = block_count_x;
+    source->disparity_resolution = parameter_.disparity_resolution;
+    source->bin_count = bin_count_;
+
+    // バンドに分割
+    int row_start[kMaxBandCount] = {};
+    int row_end[kMaxBandCount] = {};
+    const int used_band_count = band_worker_->SplitRows(block_count_y, row_start, row_end);
+
+    for (int i = 0; i < used_band_count; i++) {
+        band_job_[i].block_row_start = row_start[i];
+        band_job_[i].block_row_end = row_end[i];
+    }
+
+    band_worker_->Run(used_band_count);
+
+    MergeBands(used_band_count);
+
+    if (parameter_.fit_ground_line) {
+        FitGroundLine();
+    }
+    else {
+        has_ground_line_ = false;
+        ground_inlier_count_ = 0;
+    }
+
+    frame_time_ = isc_image_info->frame_data[fd_index].frame_time;
+    frame_index_ = isc_image_info->frame_data[fd_index].frameNo;
+
+    LeaveCriticalSection(&uv_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 最新のu-disparity, v-disparityを取得します
+ *
+ * @param[in,out] isc_uv_disparity_data 集計結果 バッファーは呼び出し元が確保します
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUvDisparity::GetData(IscUvDisparityData* isc_uv_disparity_data)
+{
+    if (isc_uv_disparity_data == nullptr) {
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    EnterCriticalSection(&uv_critical_);
+
+    if (u_disparity_ == nullptr || block_count_x_ == 0) {
+        LeaveCriticalSection(&uv_critical_);
+        return ISCDPL_E_INCORRECT_MODE;
+    }
+
+    const int u_count = bin_count_ * block_count_x_;
+    const int v_count = block_count_y_ * bin_count_;
+
+    if ((isc_uv_disparity_data->u_disparity != nullptr && isc_uv_disparity_data->max_u_count < u_count) ||
+        (isc_uv_disparity_data->v_disparity != nullptr && isc_uv_disparity_data->max_v_count < v_count)) {
+        LeaveCriticalSection(&uv_critical_);
+        return ISCDPL_E_INVALID_PARAMETER;
+    }
+
+    if (isc_uv_disparity_data->u_disparity != nullptr) {
+        memcpy(isc_uv_disparity_data->u_disparity, u_disparity_, sizeof(int) * u_count);
+    }
+    if (isc_uv_disparity_data->v_disparity != nullptr) {
+        memcpy(isc_uv_disparity_data->v_disparity, v_disparity_, sizeof(int) * v_count);
+    }
+
+    isc_uv_disparity_data->block_width = block_width_;
+    isc_uv_disparity_data->block_height = block_height_;
+    isc_uv_disparity_data->block_count_x = block_count_x_;
+    isc_uv_disparity_data->block_count_y = block_count_y_;
+    isc_uv_disparity_data->bin_count = bin_count_;
+    isc_uv_disparity_data->disparity_resolution = parameter_.disparity_resolution;
+
+    isc_uv_disparity_data->has_ground_line = has_ground_line_;
+    isc_uv_disparity_data->ground_slope = has_ground_line_ ? ground_slope_ : 0;
+    isc_uv_disparity_data->ground_intercept = has_ground_line_ ? ground_intercept_ : 0;
+    isc_uv_disparity_data->ground_inlier_count = has_ground_line_ ? ground_inlier_count_ : 0;
+
+    isc_uv_disparity_data->frame_time = frame_time_;
+    isc_uv_disparity_data->frame_index = frame_index_;
+
+    LeaveCriticalSection(&uv_critical_);
+
+    return DPC_E_OK;
+}
+
+/**
+ * 1バンドを集計します
+ *
+ * @param[in] context IscUvDisparity
+ * @param[in] band_index バンド
+ * @return none
+ * @note IscBandWorkerのスレッドから呼び出されます
+ */
+void IscUvDisparity::RunBand(void* context, const int band_index)
+{
+    IscUvDisparity* owner = (IscUvDisparity*)context;
+
+    owner->CountBand(&owner->band_job_[band_index]);
+
+    return;
+}
+
+/**
+ * 1バンドのBlockを集計します
+ *
+ * @param[in,out] job バンド
+ * @return none
+ * @note v-disparityの行はバンド毎に異なるため直接書き込みます
+ */
+void IscUvDisparity::CountBand(BandJob* job)
+{
+    const CountSource* source = &count_source_;
+    const int block_count_x = source->block_count_x;
+    const int bin_count = source->bin_count;
+    const int resolution = source->disparity_resolution;
+
+    memset(job->u_hits, 0, sizeof(int) * bin_count * block_count_x);
+
+    for (int by = job->block_row_start; by < job->block_row_end; by++) {
+        const int* src = source->block_value + ((size_t)by * block_count_x);
+        int* v_row = v_disparity_ + ((size_t)by * bin_count);
+
+        memset(v_row, 0, sizeof(int) * bin_count);
+
+        for (int bx = 0; bx < block_count_x; bx++) {
+            const int value = src[bx];
+            if (value <= 0) {
+                continue;
+            }
+
+            const int bin = (value * resolution) / 1000;
+            if (bin >= bin_count) {
+                continue;
+            }
+
+            v_row[bin]++;
+            job->u_hits[(bin * block_count_x) + bx]++;
+        }
+    }
+
+    return;
+}
+
+/**
+ * Threadの部分集計を統合します
+ *
+ * @param[in] band_count バンドの数
+ * @return none
+ */
+void IscUvDisparity::MergeBands(const int band_count)
+{
+    const int u_count = bin_count_ * block_count_x_;
+
+    memcpy(u_disparity_, band_job_[0].u_hits, sizeof(int) * u_count);
+
+    for (int b = 1; b < band_count; b++) {
+        const int* hits = band_job_[b].u_hits;
+
+        for (int i = 0; i < u_count; i++) {
+            u_disparity_[i] += hits[i];
+        }
+    }
+
+    return;
+}
+
+/**
+ * v-disparityから地面の直線を求めます
+ *
+ * @return none
+ * @note 視差(画素) = ground_slope_ x y(画素) + ground_intercept_ 地面は下ほど視差が大きいため傾きは正のみとします
+ */
+void IscUvDisparity::FitGroundLine()
+{
+    has_ground_line_ = false;
+    ground_inlier_count_ = 0;
+
+    // 候補 各行で度数の大きい点
+    const float bin_width = 1.0F / parameter_.disparity_resolution;
+    int point_count = 0;
+
+    for (int by = 0; by < block_count_y_; by++) {
+        const int* v_row = v_disparity_ + ((size_t)by * bin_count_);
+        GroundPoint* row_points = &ground_points_[point_count];
+        int row_point_count = 0;
+
+        for (int bin = 0; bin < bin_count_; bin++) {
+            const int count = v_row[bin];
+            if (count < parameter_.ground_min_count) {
+                continue;
+            }
+
+            int index = row_point_count;
+            if (row_point_count < kISC_UV_GROUND_POINTS_PER_ROW) {
+                row_point_count++;
+            }
+            else if (count <= row_points[kISC_UV_GROUND_POINTS_PER_ROW - 1].count) {
+                continue;
+            }
+            else {
+                index = kISC_UV_GROUND_POINTS_PER_ROW - 1;
+            }
+
+            // 度数の降順に挿入
+            while ((index > 0) && (row_points[index - 1].count < count)) {
+                row_points[index] = row_points[index - 1];
+                index--;
+            }
+            row_points[index].y = ((float)by + 0.5F) * block_height_;
+            row_points[index].disparity = ((float)bin + 0.5F) * bin_width;
+            row_points[index].count = count;
+        }
+
+        point_count += row_point_count;
+    }
+
+    if (point_count < 2) {
+        return;
+    }
+
+    // RANSAC 結果が毎回同じになるよう乱数は固定の初期値から生成します
+    const float tolerance = parameter_.ground_tolerance;
+    unsigned int random_state = 0x2545F491;
+    auto next_random = [&random_state](const int range) {
+        random_state = (random_state * 1103515245U) + 12345U;
+        return (int)((random_state >> 8) % (unsigned int)range);
+    };
+
+    int best_score = 0;
+    float best_slope = 0, best_intercept = 0;
+
+    for (int iteration = 0; iteration < parameter_.ground_iteration_count; iteration++) {
+        const GroundPoint* p0 = &ground_points_[next_random(point_count)];
+        const GroundPoint* p1 = &ground_points_[next_random(point_count)];
+        if (p0->y == p1->y) {
+            continue;
+        }
+
+        const float slope = (p1->disparity - p0->disparity) / (p1->y - p0->y);
+        if (!(slope > 0)) {
+            continue;
+        }
+        const float intercept = p0->disparity - (slope * p0->y);
+
+        int score = 0;
+        for (int i = 0; i < point_count; i++) {
+            const GroundPoint* point = &ground_points_[i];
+            if (fabsf(point->disparity - ((slope * point->y) + intercept)) <= tolerance) {
+                score += point->count;
+            }
+        }
+
+        if (score > best_score) {
+            best_score = score;
+            best_slope = slope;
+            best_intercept = intercept;
+        }
+    }
+
+    if (best_score == 0) {
+        return;
+    }
+
+    // inlierの重み付き最小二乗で補正します
+    double sum_w = 0, sum_y = 0, sum_d = 0, sum_yy = 0, sum_yd = 0;
+    for (int i = 0; i < point_count; i++) {
+        const GroundPoint* point = &ground_points_[i];
+        if (fabsf(point->disparity - ((best_slope * point->y) + best_intercept)) <= tolerance) {
+            const double w = point->count;
+            sum_w += w;
+            sum_y += w * point->y;
+            sum_d += w * point->disparity;
+            sum_yy += w * point->y * point->y;
+            sum_yd += w * point->y * point->disparity;
+        }
+    }
+
+    const double denominator = (sum_w * sum_yy) - (sum_y * sum_y);
+    if (denominator > 0) {
+        const double slope = ((sum_w * sum_yd) - (sum_y * sum_d)) / denominator;
+        if (slope > 0) {
+            best_slope = (float)slope;
+            best_intercept = (float)((sum_d - (slope * sum_y)) / sum_w);
+        }
+    }
+
+    int inlier_count = 0;
+    for (int i = 0; i < point_count; i++) {
+        const GroundPoint* point = &ground_points_[i];
+        if (fabsf(point->disparity - ((best_slope * point->y) + best_intercept)) <= tolerance) {
+            inlier_count += point->count;
+        }
+    }
+
+    has_ground_line_ = true;
+    ground_slope_ = best_slope;
+    ground_intercept_ = best_intercept;
+    ground_inlier_count_ = inlier_count;
+
+    return;
+}
@@ -47,6 +47,11 @@ public:
 	 */
 	static void finalize();
 
+	/** @brief get the handle of the parallelizing thread.
+		@return thread handle.
+	 */
+	static HANDLE getParallelizingThreadHandle();
+
 	/** @brief Set mesh parameters.
 		@return none.
 	 */
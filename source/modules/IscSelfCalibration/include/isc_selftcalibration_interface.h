@@ -77,6 +77,11 @@ public:
 	 */
 	void SetCallbackFunc(std::function<int(unsigned char*, unsigned char*, int, int)> func_get_camera_reg, std::function<int(unsigned char*, int)> func_set_camera_reg);
 
+	/** @brief get the handles of the threads created by the module.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
 
 private:
 
@@ -2457,6 +2457,16 @@ void SelfCalibration::deleteParallelizingThread()
 }
 
 
+/// <summary>
+/// エピポーラ線平行化スレッドのハンドルを取得する
+/// </summary>
+/// <returns>スレッドハンドルを返す</returns>
+HANDLE SelfCalibration::getParallelizingThreadHandle()
+{
+	return parallelizingThread;
+}
+
+
 /// <summary>
 /// エピポーラ線平行化処理を中断する
 /// </summary>
@@ -665,3 +665,31 @@ int IscSelftCalibrationInterface::SetCameraRegData(unsigned char* wbuf, int writ
 
     return ret;
 }
+
+/**
+ * 平行化Threadのハンドルを取得します
+ *
+ * @param[in] max_count 取得する最大数
+ * @param[out] thread_handle Threadのハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Threadの配置を設定するために利用します
+ */
+int IscSelftCalibrationInterface::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+    if (thread_handle == nullptr || thread_count == nullptr) {
+        return DPCPROCESS_E_INVALID_PARAMETER;
+    }
+
+    *thread_count = 0;
+    if (max_count > 0) {
+        HANDLE handle = SelfCalibration::getParallelizingThreadHandle();
+        if (handle != NULL) {
+            thread_handle[0] = handle;
+            *thread_count = 1;
+        }
+    }
+
+    return DPC_E_OK;
+}
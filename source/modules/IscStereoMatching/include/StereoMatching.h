@@ -121,6 +121,11 @@ public:
 	 */
 	static void deleteMatchingThread();
 
+	/** @brief get the handles of the matching threads.
+		@return number of handles.
+	 */
+	static int getMatchingThreadHandle(int maxcnt, HANDLE* phandle);
+
 
 private:
 
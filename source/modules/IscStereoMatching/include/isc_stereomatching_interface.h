@@ -93,9 +93,20 @@ public:
 	*/
 	int GetEdgeMaskDisparity(IscImageInfo* isc_image_Info, IscDataProcResultData* isc_data_proc_result_data);
 
+	/** @brief limit the matching depth temporarily. 0 restores the parameter value.
+		@return 0, if successful.
+	*/
+	int SetMatchingDepthOverride(const int depth);
+
+	/** @brief get the handles of the threads created by the module.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
 private:
 
 	bool parameter_update_request_;
+	int matching_depth_override_;
 
 	IscDataProcModuleConfiguration isc_data_proc_module_configuration_;
 
@@ -6429,6 +6429,33 @@ void StereoMatching::deleteMatchingThread()
 }
 
 
+/// <summary>
+/// マッチングスレッドのハンドルを取得する
+/// </summary>
+/// <param name="maxcnt">取得する最大数(IN)</param>
+/// <param name="phandle">スレッドハンドル マッチングスレッド、ブロックスレッドの順(OUT)</param>
+/// <returns>取得した数を返す</returns>
+int StereoMatching::getMatchingThreadHandle(int maxcnt, HANDLE* phandle)
+{
+	int cnt = 0;
+
+	// バンド数が2以上の場合
+	if (numOfBands > 1) {
+		// マッチングスレッド
+		for (int i = 0; i < numOfBands && cnt < maxcnt; i++) {
+			phandle[cnt++] = bandInfo[i].bandThread;
+		}
+
+		// ブロックスレッド
+		for (int i = 0; i < numOfBands && cnt < maxcnt; i++) {
+			phandle[cnt++] = bandBlockInfo[i].bandThread;
+		}
+	}
+
+	return cnt;
+}
+
+
 /// <summary>
 /// バンド分割してブロック輝度とコントラストを取得する
 /// </summary>
@@ -57,6 +57,7 @@
  */
 IscStereoMatchingInterface::IscStereoMatchingInterface():
     parameter_update_request_(false),
+    matching_depth_override_(0),
     parameter_file_name_(),
     isc_data_proc_module_configuration_(),
     stereo_matching_parameters_(),
@@ -528,10 +529,16 @@ int IscStereoMatchingInterface::SetParameterToStereoMatchingModule(const StereoM
 {
     StereoMatching::setUseOpenCLForMatching(stereo_matching_parameters->system_parameter.enabled_opencl_for_avedisp);
 
+    // depth is limited while the override is set
+    int matching_depth = stereo_matching_parameters->matching_parameter.depth;
+    if (matching_depth_override_ > 0 && matching_depth_override_ < matching_depth) {
+        matching_depth = matching_depth_override_;
+    }
+
     StereoMatching::setMatchingParameter(
         stereo_matching_parameters->matching_parameter.imghgt,
         stereo_matching_parameters->matching_parameter.imgwdt,
-        stereo_matching_parameters->matching_parameter.depth,
+        matching_depth,
         stereo_matching_parameters->matching_parameter.blkhgt,
         stereo_matching_parameters->matching_parameter.blkwdt,
         stereo_matching_parameters->matching_parameter.mtchgt,
@@ -1228,3 +1235,48 @@ int IscStereoMatchingInterface::GetEdgeMaskDisparity(IscImageInfo* isc_image_Inf
 
     return DPC_E_OK;
 }
+
+/**
+ * マッチング探索幅を一時的に制限します
+ *
+ * @param[in] depth 探索幅 0:パラメータの値に戻します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 次回の処理から反映されます
+ */
+int IscStereoMatchingInterface::SetMatchingDepthOverride(const int depth)
+{
+    if (depth < 0) {
+        return DPCPROCESS_E_INVALID_PARAMETER;
+    }
+
+    if (depth == matching_depth_override_) {
+        return DPC_E_OK;
+    }
+
+    matching_depth_override_ = depth;
+    parameter_update_request_ = true;
+
+    return DPC_E_OK;
+}
+
+/**
+ * マッチングThreadのハンドルを取得します
+ *
+ * @param[in] max_count 取得する最大数
+ * @param[out] thread_handle Threadのハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note Threadの配置を設定するために利用します
+ */
+int IscStereoMatchingInterface::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+    if (thread_handle == nullptr || thread_count == nullptr) {
+        return DPCPROCESS_E_INVALID_PARAMETER;
+    }
+
+    *thread_count = StereoMatching::getMatchingThreadHandle(max_count, thread_handle);
+
+    return DPC_E_OK;
+}
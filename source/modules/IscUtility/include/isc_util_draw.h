@@ -19,6 +19,8 @@
  
 #pragma once
 
+class IscBandWorker;
+
 /**
  * @class   IscUtilDraw
  * @brief   draw function class
@@ -61,6 +63,11 @@ public:
     */
     int Terminate();
 
+    /** @brief get the handles of the draw threads for the placement.
+       @return 0, if successful.
+    */
+    int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count);
+
     /** @brief Create in the specified range.
       @return none.
     */
@@ -76,6 +83,16 @@ public:
     */
     int Disparity2Image(const int width, const int height, float* disparity, unsigned char* bgr_image);
 
+    /** @brief Converts the block disparity (width / block_width x height / block_height) to distance image without expanding it.
+      @return 0, if successful.
+    */
+    int BlockDisparity2DistanceImage(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image);
+
+    /** @brief Converts the block disparity (width / block_width x height / block_height) to image without expanding it.
+       @return 0, if successful.
+    */
+    int BlockDisparity2Image(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image);
+
 private:
     // parameter
     Cameraparameter camera_parameter_;
@@ -93,6 +110,45 @@ private:
 	DispColorMap disp_color_map_distance_;		/**<  視差表示用 LUT 距離基準 */
 	DispColorMap disp_color_map_disparity_;		/**<  視差表示用 LUT 視差基準 */
 
+	// Disparity -> BGR LUT
+	struct DepthColorLut {
+		bool is_valid;							/**<  作成済み */
+		bool is_color_by_distance;				/**<  作成した条件 */
+		bool is_draw_outside_bounds;
+		double min_length;
+		double max_length;
+		double bf;
+		double dinf;
+		double color_map_step;
+
+		unsigned int* table;					/**<  0x00RRGGBB [0]:無効な視差 [1~]:視差 1/resolution pixel毎 */
+	};
+	DepthColorLut depth_color_lut_distance_;	/**<  距離基準 */
+	DepthColorLut depth_color_lut_disparity_;	/**<  視差基準 */
+
+	// row-parallel drawing
+	static constexpr int kMaxDrawThreadCount = 4;
+
+	struct DrawJob {
+		const float* depth;						/**<  視差 画素毎 または Block毎 */
+		int width;
+		int height;
+		int block_width;						/**<  0:画素毎の視差 */
+		int block_height;
+		const unsigned int* table;
+		float dinf;
+		unsigned char* bgr_image;
+	};
+
+	struct DrawRows {
+		int row_start;
+		int row_end;
+	};
+
+	IscBandWorker* band_worker_;
+	DrawJob draw_job_;
+	DrawRows draw_rows_[kMaxDrawThreadCount];
+
     // functions
 	int BuildColorHeatMap(DispColorMap* disp_color_map);
 
@@ -102,6 +158,16 @@ private:
 
 	bool MakeDepthColorImage(const bool is_color_by_distance, const bool is_draw_outside_bounds, const double min_length_i, const double max_length_i,
 		DispColorMap* disp_color_map, double b_i, const double angle_i, const double bf_i, const double dinf_i,
-		const int width, const int height, float* depth, unsigned char* bgr_image);
+		const int width, const int height, float* depth, unsigned char* bgr_image, const int block_width = 0, const int block_height = 0);
+
+	unsigned int GetDepthColor(const bool is_color_by_distance, const bool is_draw_outside_bounds, const double min_length_i, const double max_length_i,
+		const DispColorMap* disp_color_map, const double bf_i, const double dinf_i, const double disparity);
+
+	DepthColorLut* PrepareDepthColorLut(const bool is_color_by_distance, const bool is_draw_outside_bounds, const double min_length_i, const double max_length_i,
+		const DispColorMap* disp_color_map, const double bf_i, const double dinf_i);
+
+	static void DrawBand(void* context, const int band_index);
+
+	static void DrawDepthRows(const DrawJob* draw_job, const DrawRows* draw_rows);
 
 };
\ No newline at end of file
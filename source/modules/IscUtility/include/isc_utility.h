@@ -25,6 +25,8 @@
 #define ISCUTILITY_EXPORTS_API __declspec(dllimport)
 #endif
 
+struct IscThreadConfiguration;
+
 extern "C" {
 
     /** @struct  DplIscUtilityParameter
@@ -62,6 +64,11 @@ extern "C" {
      */
     ISCUTILITY_EXPORTS_API int DplIscUtilityTerminate();
 
+    /** @brief Apply the placement of kBandWorker to the draw threads. It is kept until DplIscUtilityTerminate.
+        @return 0, if successful.
+     */
+    ISCUTILITY_EXPORTS_API int DplIscUtilitySetThreadConfiguration(const IscThreadConfiguration* isc_thread_configuration);
+
     /** @brief Create in the specified range.
        @return none.
     */
@@ -77,5 +84,15 @@ extern "C" {
     */
     ISCUTILITY_EXPORTS_API int Disparity2Image(const int width, const int height, float* disparity, unsigned char* bgr_image);
 
+    /** @brief Converts the block disparity (width / block_width x height / block_height) to distance image without expanding it.
+       @return 0, if successful.
+    */
+    ISCUTILITY_EXPORTS_API int BlockDisparity2DistanceImage(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image);
+
+    /** @brief Converts the block disparity (width / block_width x height / block_height) to image without expanding it.
+       @return 0, if successful.
+    */
+    ISCUTILITY_EXPORTS_API int BlockDisparity2Image(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image);
+
 
 } /* extern "C" { */
\ No newline at end of file
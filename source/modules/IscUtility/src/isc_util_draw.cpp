@@ -30,19 +30,34 @@
 #include <imagehlp.h>
 #include <Shlobj.h>
 #include <math.h>
+#include <algorithm>
 
+#include "isc_band_worker.h"
 #include "isc_util_draw.h"
 
+#if defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__)
+#define ISC_UTIL_DRAW_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+constexpr int kISC_DRAW_LUT_RESOLUTION = 128;                                          /**< 変換表の視差の分解能 (1/128 pixel) */
+constexpr int kISC_DRAW_LUT_DISPARITY_COUNT = 256 * kISC_DRAW_LUT_RESOLUTION;          /**< 視差 0.0 ~ 255.99 (以上は最後の色) */
+constexpr int kISC_DRAW_LUT_SIZE = kISC_DRAW_LUT_DISPARITY_COUNT + 1;                  /**< [0]は無効な視差 */
+constexpr int kISC_DRAW_MIN_ROWS_PER_THREAD = 64;                                      /**< 1threadで描画する最小の行数 */
+
 IscUtilDraw::IscUtilDraw():
     camera_parameter_(), draw_parameter_(),
-    disp_color_map_distance_(), disp_color_map_disparity_()
+    disp_color_map_distance_(), disp_color_map_disparity_(),
+    depth_color_lut_distance_(), depth_color_lut_disparity_(),
+    band_worker_(nullptr), draw_job_(), draw_rows_()
 {
-
+	band_worker_ = new IscBandWorker;
 }
 
 IscUtilDraw::~IscUtilDraw()
 {
-
+	delete band_worker_;
+	band_worker_ = nullptr;
 }
 
 /**
@@ -89,6 +104,17 @@ int IscUtilDraw::Initialize(Cameraparameter* camera_parameter, DrawParameter* dr
 	memset(disp_color_map_disparity_.color_map, 0, disp_color_map_disparity_.color_map_size + sizeof(int));
 	BuildColorHeatMapForDisparity(&disp_color_map_disparity_);
 
+	// 視差から色への変換表は、描画時に作成します
+	depth_color_lut_distance_.is_valid = false;
+	depth_color_lut_distance_.table = new unsigned int[kISC_DRAW_LUT_SIZE];
+	depth_color_lut_disparity_.is_valid = false;
+	depth_color_lut_disparity_.table = new unsigned int[kISC_DRAW_LUT_SIZE];
+
+	// 描画用のthread 作成できない場合は呼び出し元のthreadで描画します
+	if (band_worker_->Initialize(kMaxDrawThreadCount, DrawBand, this) != 0) {
+		band_worker_->Initialize(0, DrawBand, this);
+	}
+
     return 0;
 }
 
@@ -101,6 +127,16 @@ int IscUtilDraw::Initialize(Cameraparameter* camera_parameter, DrawParameter* dr
 int IscUtilDraw::Terminate()
 {
 
+	band_worker_->Terminate();
+
+	delete[] depth_color_lut_distance_.table;
+	depth_color_lut_distance_.table = nullptr;
+	depth_color_lut_distance_.is_valid = false;
+
+	delete[] depth_color_lut_disparity_.table;
+	depth_color_lut_disparity_.table = nullptr;
+	depth_color_lut_disparity_.is_valid = false;
+
 	delete[] disp_color_map_distance_.color_map;
 	disp_color_map_distance_.color_map = nullptr;
 
@@ -110,6 +146,27 @@ int IscUtilDraw::Terminate()
     return 0;
 }
 
+/**
+ * 配置のために描画用のスレッドのハンドルを取得します.
+ *
+ * @param[in] max_count thread_handleの数
+ * @param[out] thread_handle ハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUtilDraw::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count)
+{
+
+	if ((thread_handle == nullptr) || (thread_count == nullptr)) {
+		return -1;
+	}
+
+	band_worker_->GetThreadHandle(max_count, thread_handle, thread_count);
+
+	return 0;
+}
+
 /**
  * Color tableを指定範囲で再作成します.
  *
@@ -134,6 +191,9 @@ void IscUtilDraw::RebuildDrawColorMap(const double min_distance, const double ma
 	memset(disp_color_map_distance_.color_map, 0, disp_color_map_distance_.color_map_size + sizeof(int));
 	BuildColorHeatMap(&disp_color_map_distance_);
 
+	// 変換表は次の描画時に再作成します
+	depth_color_lut_distance_.is_valid = false;
+
 	return;
 }
 
@@ -217,6 +277,108 @@ int IscUtilDraw::Disparity2Image(const int width, const int height, float* dispa
     return 0;
 }
 
+/**
+ * Block毎の視差を展開せずに距離画像(m)へ変換します.
+ *
+ * @param[in] width　画像の幅
+ * @param[in] height　画像の高さ
+ * @param[in] block_width　Blockの幅
+ * @param[in] block_height　Blockの高さ
+ * @param[in] block_disparity　Block毎の視差 (width / block_width x height / block_height)
+ * @param[out] bgr_image　カラー画像
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUtilDraw::BlockDisparity2DistanceImage(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image)
+{
+
+    if((block_disparity == nullptr) || (bgr_image == nullptr)) {
+        return -1;
+    }
+
+    if((block_width <= 0) || (block_height <= 0)) {
+        return -1;
+    }
+
+    const double max_length = disp_color_map_distance_.max_value;
+    const double min_length = disp_color_map_distance_.min_value;
+    DispColorMap* disp_color_map = &disp_color_map_distance_;
+
+    bool ret = MakeDepthColorImage(
+        true,
+        draw_parameter_.draw_outside_bounds,
+        min_length,
+        max_length,
+        disp_color_map,
+        camera_parameter_.base_length,
+        camera_parameter_.camera_angle,
+        camera_parameter_.bf,
+        camera_parameter_.d_inf,
+        width,
+        height,
+        block_disparity,
+        bgr_image,
+        block_width,
+        block_height);
+
+    if (!ret) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Block毎の視差を展開せずに画像へ変換します.
+ *
+ * @param[in] width　画像の幅
+ * @param[in] height　画像の高さ
+ * @param[in] block_width　Blockの幅
+ * @param[in] block_height　Blockの高さ
+ * @param[in] block_disparity　Block毎の視差 (width / block_width x height / block_height)
+ * @param[out] bgr_image　カラー画像
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int IscUtilDraw::BlockDisparity2Image(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image)
+{
+
+    if((block_disparity == nullptr) || (bgr_image == nullptr)) {
+        return -1;
+    }
+
+    if((block_width <= 0) || (block_height <= 0)) {
+        return -1;
+    }
+
+    const double max_length = disp_color_map_disparity_.max_value;
+    const double min_length = disp_color_map_disparity_.min_value;
+    DispColorMap* disp_color_map = &disp_color_map_disparity_;
+
+    bool ret = MakeDepthColorImage(
+        false,
+        draw_parameter_.draw_outside_bounds,
+        min_length,
+        max_length,
+        disp_color_map,
+        camera_parameter_.base_length,
+        camera_parameter_.camera_angle,
+        camera_parameter_.bf,
+        camera_parameter_.d_inf,
+        width,
+        height,
+        block_disparity,
+        bgr_image,
+        block_width,
+        block_height);
+
+    if (!ret) {
+        return -1;
+    }
+
+    return 0;
+}
+
 /**
  * 入力値をカラーデータへ変換します.
  *
@@ -355,6 +517,114 @@ int IscUtilDraw::BuildColorHeatMapForDisparity(DispColorMap* disp_color_map)
 	return 0;
 }
 
+
+/**
+ * 視差の色を取得します.
+ *
+ * @param[in] is_color_by_distance　true:距離基準画像　false:視差基準画像
+ * @param[in] is_draw_outside_bounds　true:範囲外を描画する　false:範囲は黒とする
+ * @param[in] min_length_i　最小距離
+ * @param[in] max_length_i　最大距離
+ * @param[in] disp_color_map　カラーテーブル
+ * @param[in] bf_i　カメラ固有値
+ * @param[in] dinf_i　カメラ固有値
+ * @param[in] disparity　視差 (dinf_iより大きい値)
+ * @retval 色 0x00RRGGBB
+ */
+unsigned int IscUtilDraw::GetDepthColor(const bool is_color_by_distance, const bool is_draw_outside_bounds, const double min_length_i, const double max_length_i,
+										const DispColorMap* disp_color_map, const double bf_i, const double dinf_i, const double disparity)
+{
+	const double color_map_step_mag = 1.0 / disp_color_map->color_map_step;
+
+	if (is_color_by_distance) {
+		// 距離変換
+		double d = (disparity - dinf_i);
+		double za = max_length_i;
+		if (d > 0) {
+			za = bf_i / d;
+		}
+
+		if (!is_draw_outside_bounds) {
+			if ((za > max_length_i) || (za < min_length_i)) {
+				// it's black
+				return 0;
+			}
+		}
+
+		double map_index = za * color_map_step_mag;
+		if (map_index >= 0 && map_index < disp_color_map->color_map_size) {
+			return (unsigned int)disp_color_map->color_map[(int)map_index] & 0x00FFFFFF;
+		}
+
+		// it's blue or black
+		return is_draw_outside_bounds ? 0x000000FF : 0;
+	}
+
+	// 視差
+	const double max_value = disp_color_map->max_value;
+	double d = 0 >= (max_value - disparity - dinf_i) ? 0 : (max_value - disparity - dinf_i);
+
+	double map_index = d * color_map_step_mag;
+	if (map_index >= 0 && map_index < disp_color_map->color_map_size) {
+		return (unsigned int)disp_color_map->color_map[(int)map_index] & 0x00FFFFFF;
+	}
+
+	// it's black
+	return 0;
+}
+
+/**
+ * 視差からカラーへの変換表を準備します.
+ *
+ * @param[in] is_color_by_distance　true:距離基準画像　false:視差基準画像
+ * @param[in] is_draw_outside_bounds　true:範囲外を描画する　false:範囲は黒とする
+ * @param[in] min_length_i　最小距離
+ * @param[in] max_length_i　最大距離
+ * @param[in] disp_color_map　カラーテーブル
+ * @param[in] bf_i　カメラ固有値
+ * @param[in] dinf_i　カメラ固有値
+ * @retval 変換表 nullptr:失敗
+ * @note 条件が前回と同じであれば、作成済みの表を使用します
+ */
+IscUtilDraw::DepthColorLut* IscUtilDraw::PrepareDepthColorLut(const bool is_color_by_distance, const bool is_draw_outside_bounds, const double min_length_i, const double max_length_i,
+															const DispColorMap* disp_color_map, const double bf_i, const double dinf_i)
+{
+	DepthColorLut* lut = is_color_by_distance ? &depth_color_lut_distance_ : &depth_color_lut_disparity_;
+
+	if (lut->table == nullptr || disp_color_map->color_map == nullptr) {
+		return nullptr;
+	}
+
+	if (lut->is_valid &&
+		lut->is_color_by_distance == is_color_by_distance &&
+		lut->is_draw_outside_bounds == is_draw_outside_bounds &&
+		lut->min_length == min_length_i &&
+		lut->max_length == max_length_i &&
+		lut->bf == bf_i &&
+		lut->dinf == dinf_i &&
+		lut->color_map_step == disp_color_map->color_map_step) {
+		return lut;
+	}
+
+	// [0]は無効な視差、[k + 1]は視差 k/resolution ~ (k + 1)/resolution の中央の色
+	lut->table[0] = 0;
+	for (int k = 0; k < kISC_DRAW_LUT_DISPARITY_COUNT; k++) {
+		const double disparity = ((double)k + 0.5) / kISC_DRAW_LUT_RESOLUTION;
+		lut->table[k + 1] = GetDepthColor(is_color_by_distance, is_draw_outside_bounds, min_length_i, max_length_i, disp_color_map, bf_i, dinf_i, disparity);
+	}
+
+	lut->is_color_by_distance = is_color_by_distance;
+	lut->is_draw_outside_bounds = is_draw_outside_bounds;
+	lut->min_length = min_length_i;
+	lut->max_length = max_length_i;
+	lut->bf = bf_i;
+	lut->dinf = dinf_i;
+	lut->color_map_step = disp_color_map->color_map_step;
+	lut->is_valid = true;
+
+	return lut;
+}
+
 /**
  * 入力値をカラーデータへ変換します.
  *
@@ -363,7 +633,7 @@ int IscUtilDraw::BuildColorHeatMapForDisparity(DispColorMap* disp_color_map)
  * @param[in] min_length_i　最小距離
  * @param[in] max_length_i　最大距離
  * @param[in] disp_color_map　カラーテーブル
- * @param[in] b_i　基線長
+ * @param[in] b_i　基線長（未使用）
  * @param[in] angle_i　カメラ角度（未使用）
  * @param[in] bf_i　カメラ固有値
  * @param[in] dinf_i　カメラ固有値
@@ -371,12 +641,15 @@ int IscUtilDraw::BuildColorHeatMapForDisparity(DispColorMap* disp_color_map)
  * @param[in] height　画像高さ
  * @param[in] depth　視差データ
  * @param[out] bgr_image　カラー画像
+ * @param[in] block_width　0:depthは画素毎の視差 other:depthはBlock毎の視差 (width / block_width x height / block_height)
+ * @param[in] block_height　Blockの高さ
  * @retval 0 成功
  * @retval other 失敗
+ * @note 視差から色への変換表を使用し、行を分割して複数のthreadで描画します
  */
 bool IscUtilDraw::MakeDepthColorImage(	const bool is_color_by_distance, const bool is_draw_outside_bounds, const double min_length_i, const double max_length_i,
 										DispColorMap* disp_color_map, double b_i, const double angle_i, const double bf_i, const double dinf_i,
-										const int width, const int height, float* depth, unsigned char* bgr_image)
+										const int width, const int height, float* depth, unsigned char* bgr_image, const int block_width, const int block_height)
 {
 	if (disp_color_map == nullptr) {
 		return false;
@@ -390,139 +663,178 @@ bool IscUtilDraw::MakeDepthColorImage(	const bool is_color_by_distance, const bo
 		return false;
 	}
 
+	if ((width <= 0) || (height <= 0)) {
+		return false;
+	}
+
+	DepthColorLut* lut = PrepareDepthColorLut(is_color_by_distance, is_draw_outside_bounds, min_length_i, max_length_i, disp_color_map, bf_i, dinf_i);
+	if (lut == nullptr) {
+		return false;
+	}
+
+	draw_job_.depth = depth;
+	draw_job_.width = width;
+	draw_job_.height = height;
+	draw_job_.block_width = block_width;
+	draw_job_.block_height = block_height;
+	draw_job_.table = lut->table;
+	draw_job_.bgr_image = bgr_image;
+	draw_job_.dinf = (float)dinf_i;
+
+	// 行を分割します
+	int row_start[kMaxDrawThreadCount] = {};
+	int row_end[kMaxDrawThreadCount] = {};
+	const int used_band_count = band_worker_->SplitRows(height, row_start, row_end, kISC_DRAW_MIN_ROWS_PER_THREAD);
+
+	for (int i = 0; i < used_band_count; i++) {
+		draw_rows_[i].row_start = row_start[i];
+		draw_rows_[i].row_end = row_end[i];
+	}
+
+	band_worker_->Run(used_band_count);
+
+	return true;
+}
+
+/**
+ * 1バンドを描画します.
+ *
+ * @param[in] context　IscUtilDraw
+ * @param[in] band_index　バンド
+ * @retval none
+ * @note IscBandWorkerのスレッドから呼び出されます
+ */
+void IscUtilDraw::DrawBand(void* context, const int band_index)
+{
+	IscUtilDraw* owner = (IscUtilDraw*)context;
+
+	DrawDepthRows(&owner->draw_job_, &owner->draw_rows_[band_index]);
+
+	return;
+}
+
+/**
+ * 視差から変換表の位置を取得します.
+ *
+ * @param[in] value　視差
+ * @param[in] dinf　カメラ固有値
+ * @retval 位置 0:無効な視差
+ */
+static inline int GetDepthColorLutIndex(const float value, const float dinf)
+{
+	if (!(value > dinf)) {
+		return 0;
+	}
+
+	float position = value * kISC_DRAW_LUT_RESOLUTION;
+	if (position < 0.0F) {
+		position = 0.0F;
+	}
+	else if (position > (float)(kISC_DRAW_LUT_DISPARITY_COUNT - 1)) {
+		position = (float)(kISC_DRAW_LUT_DISPARITY_COUNT - 1);
+	}
+
+	return (int)position + 1;
+}
+
+/**
+ * 指定行を描画します.
+ *
+ * @param[in] draw_job　描画の条件
+ * @param[in] draw_rows　描画する行
+ * @retval none
+ * @note 行の最後以外の画素は4byteで書き込みます
+ */
+void IscUtilDraw::DrawDepthRows(const DrawJob* draw_job, const DrawRows* draw_rows)
+{
 	constexpr int channel_count = 3;
 
-	constexpr double pi = 3.1415926535;
-	const double bf = bf_i;
-	const double b = b_i;
-	const double dinf = dinf_i;
-	const double rad = angle_i * pi / 180.0;
-	const double color_map_step_mag = 1.0 / disp_color_map->color_map_step;
+	const int width = draw_job->width;
+	const unsigned int* table = draw_job->table;
+	const float dinf = draw_job->dinf;
 
-	if (is_color_by_distance) {
-		// 距離変換
+	if (draw_job->block_width > 0 && draw_job->block_height > 0) {
+		// Block毎の視差を展開せずに描画します
+		const int block_count_x = width / draw_job->block_width;
+		const int block_count_y = draw_job->height / draw_job->block_height;
+		const size_t row_size = (size_t)width * channel_count;
 
-		for (int i = 0; i < height; i++) {
-			float* src = depth + (i * width);
-			unsigned char* dst = bgr_image + (i * width * channel_count);
+		for (int i = draw_rows->row_start; i < draw_rows->row_end; i++) {
+			unsigned char* dst = draw_job->bgr_image + (i * row_size);
+			const int by = i / draw_job->block_height;
 
-			for (int j = 0; j < width; j++) {
-				int r = 0, g = 0, b = 0;
-				if (*src <= dinf) {
-					r = 0;
-					g = 0;
-					b = 0;
-				}
-				else {
-					double d = (*src - dinf);
-					double za = max_length_i;
-					if (d > 0) {
-#if 0
-						double yh = (b * (i - (height / 2))) / d;
-						double z = bf / d;
-						za = -1 * yh * sin(rad) + z * cos(rad);
-#else
-						za = bf / d;
-#endif
-					}
-
-					if (is_draw_outside_bounds) {
-						int map_index = (int)(za * color_map_step_mag);
-						if (map_index >= 0 && map_index < disp_color_map->color_map_size) {
-							int map_value = disp_color_map->color_map[map_index];
-
-							r = (unsigned char)(map_value >> 16);
-							g = (unsigned char)(map_value >> 8);
-							b = (unsigned char)(map_value);
-						}
-						else {
-							// it's blue
-							r = 0;
-							g = 0;
-							b = 255;
-						}
-					}
-					else {
-						if (za > max_length_i) {
-							r = 0;
-							g = 0;
-							b = 0;
-						}
-						else if (za < min_length_i) {
-							r = 0;
-							g = 0;
-							b = 0;
-						}
-						else {
-							int map_index = (int)(za * color_map_step_mag);
-							if (map_index >= 0 && map_index < disp_color_map->color_map_size) {
-								int map_value = disp_color_map->color_map[map_index];
-
-								r = (unsigned char)(map_value >> 16);
-								g = (unsigned char)(map_value >> 8);
-								b = (unsigned char)(map_value);
-							}
-							else {
-								// it's black
-								r = 0;
-								g = 0;
-								b = 0;
-							}
-						}
-					}
-				}
+			if (by >= block_count_y) {
+				memset(dst, 0, row_size);
+				continue;
+			}
 
-				*dst++ = b;
-				*dst++ = g;
-				*dst++ = r;
+			if ((i > draw_rows->row_start) && ((i - 1) / draw_job->block_height == by)) {
+				// 同じBlockの行
+				memcpy(dst, dst - row_size, row_size);
+				continue;
+			}
+
+			const float* src = draw_job->depth + ((size_t)by * block_count_x);
+			int j = 0;
+			for (int bx = 0; bx < block_count_x; bx++) {
+				const unsigned int color = table[GetDepthColorLutIndex(src[bx], dinf)];
 
-				src++;
+				for (int k = 0; k < draw_job->block_width; k++, j++) {
+					*dst++ = (unsigned char)(color);
+					*dst++ = (unsigned char)(color >> 8);
+					*dst++ = (unsigned char)(color >> 16);
+				}
 			}
+
+			// Blockの外
+			memset(dst, 0, (size_t)(width - j) * channel_count);
 		}
+
+		return;
 	}
-	else {
-		// 視差
-		const double max_value = disp_color_map_disparity_.max_value;
-		const double dinf = dinf_i;
-
-		for (int i = 0; i < height; i++) {
-			float* src = depth + (i * width);
-			unsigned char* dst = bgr_image + (i * width * channel_count);
-
-			for (int j = 0; j < width; j++) {
-				int r = 0, g = 0, b = 0;
-				if (*src <= dinf) {
-					r = 0;
-					g = 0;
-					b = 0;
-				}
-				else {
-					double d = 0 >= (max_value - *src - dinf) ? 0 : (max_value - *src - dinf);
-
-					int map_index = (int)(d * color_map_step_mag);
-					if (map_index >= 0 && map_index < disp_color_map->color_map_size) {
-						int map_value = disp_color_map->color_map[map_index];
-
-						r = (unsigned char)(map_value >> 16);
-						g = (unsigned char)(map_value >> 8);
-						b = (unsigned char)(map_value);
-					}
-					else {
-						// it's black
-						r = 0;
-						g = 0;
-						b = 0;
-					}
-				}
 
-				*dst++ = b;
-				*dst++ = g;
-				*dst++ = r;
+	for (int i = draw_rows->row_start; i < draw_rows->row_end; i++) {
+		const float* src = draw_job->depth + ((size_t)i * width);
+		unsigned char* dst = draw_job->bgr_image + ((size_t)i * width * channel_count);
 
-				src++;
-			}
+		int j = 0;
+
+#ifdef ISC_UTIL_DRAW_USE_SSE2
+		const __m128 dinf_ps = _mm_set1_ps(dinf);
+		const __m128 resolution_ps = _mm_set1_ps((float)kISC_DRAW_LUT_RESOLUTION);
+		const __m128 max_position_ps = _mm_set1_ps((float)(kISC_DRAW_LUT_DISPARITY_COUNT - 1));
+		const __m128i one_epi32 = _mm_set1_epi32(1);
+
+		int lut_index[4] = {};
+
+		// 行の最後の画素は含めない
+		for (; j + 4 < width; j += 4) {
+			const __m128 value = _mm_loadu_ps(src + j);
+			const __m128 valid = _mm_cmpgt_ps(value, dinf_ps);
+
+			__m128 position = _mm_mul_ps(value, resolution_ps);
+			position = _mm_min_ps(_mm_max_ps(position, _mm_setzero_ps()), max_position_ps);
+
+			__m128i index = _mm_add_epi32(_mm_cvttps_epi32(position), one_epi32);
+			index = _mm_and_si128(index, _mm_castps_si128(valid));
+			_mm_storeu_si128((__m128i*)lut_index, index);
+
+			memcpy(dst + 0, &table[lut_index[0]], sizeof(unsigned int));
+			memcpy(dst + 3, &table[lut_index[1]], sizeof(unsigned int));
+			memcpy(dst + 6, &table[lut_index[2]], sizeof(unsigned int));
+			memcpy(dst + 9, &table[lut_index[3]], sizeof(unsigned int));
+			dst += 4 * channel_count;
+		}
+#endif
+
+		for (; j < width; j++) {
+			const unsigned int color = table[GetDepthColorLutIndex(src[j], dinf)];
+
+			*dst++ = (unsigned char)(color);
+			*dst++ = (unsigned char)(color >> 8);
+			*dst++ = (unsigned char)(color >> 16);
 		}
 	}
 
-	return true;
+	return;
 }
@@ -30,10 +30,35 @@
 #include <imagehlp.h>
 #include <Shlobj.h>
 
+#include "isc_camera_def.h"
+#include "isc_thread_placement.h"
 #include "isc_utility.h"
 #include "isc_util_draw.h"
 
 static IscUtilDraw* isc_util_draw_ = nullptr;
+static IscThreadPlacement* isc_thread_placement_ = nullptr;
+
+/**
+ * 描画用のThreadに配置を適用します.
+ *
+ * @retval none
+ */
+static void ApplyDrawThreadPlacement()
+{
+
+    if((isc_util_draw_ == nullptr) || (isc_thread_placement_ == nullptr)){
+        return;
+    }
+
+    HANDLE thread_handle[kISC_THREAD_PLACEMENT_MAX_COUNT] = {};
+    int thread_count = 0;
+    isc_util_draw_->GetThreadHandle(kISC_THREAD_PLACEMENT_MAX_COUNT, thread_handle, &thread_count);
+    for(int i = 0; i < thread_count; i++){
+        isc_thread_placement_->Apply(IscThreadRole::kBandWorker, i, thread_handle[i]);
+    }
+
+    return;
+}
 
 
 extern "C" {
@@ -78,6 +103,8 @@ int DplIscUtilityInitialize(DplIscUtilityParameter* utility_parameter)
         return ret;
     }
 
+    ApplyDrawThreadPlacement();
+
     return 0;
 }
 
@@ -96,6 +123,41 @@ int DplIscUtilityTerminate()
         isc_util_draw_ = nullptr;
     }
 
+    if(isc_thread_placement_ != nullptr){
+        isc_thread_placement_->Terminate();
+        delete isc_thread_placement_;
+        isc_thread_placement_ = nullptr;
+    }
+
+    return 0;
+}
+
+/**
+ * 描画用のThreadの配置を設定します.
+ *
+ * @param[in] isc_thread_configuration 配置 kBandWorkerを使用します
+ * @retval 0 成功
+ * @retval other 失敗
+ * @note 設定はDplIscUtilityTerminateまで保持し、DplIscUtilityInitializeで作成したThreadにも適用します
+ */
+int DplIscUtilitySetThreadConfiguration(const IscThreadConfiguration* isc_thread_configuration)
+{
+
+    if(isc_thread_configuration == nullptr){
+        return -1;
+    }
+
+    if(isc_thread_placement_ != nullptr){
+        isc_thread_placement_->Terminate();
+        delete isc_thread_placement_;
+        isc_thread_placement_ = nullptr;
+    }
+
+    isc_thread_placement_ = new IscThreadPlacement;
+    isc_thread_placement_->Initialize(isc_thread_configuration);
+
+    ApplyDrawThreadPlacement();
+
     return 0;
 }
 
@@ -162,6 +224,54 @@ int Disparity2Image(const int width, const int height, float* disparity, unsigne
     return ret;
 }
 
+/**
+ * Block毎の視差を展開せずに距離画像(m)へ変換します.
+ *
+ * @param[in] width　画像の幅
+ * @param[in] height　画像の高さ
+ * @param[in] block_width　Blockの幅
+ * @param[in] block_height　Blockの高さ
+ * @param[in] block_disparity　Block毎の視差 (width / block_width x height / block_height)
+ * @param[out] bgr_image　カラー画像
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int BlockDisparity2DistanceImage(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image)
+{
+
+    if(isc_util_draw_ == nullptr){
+        return -1;
+    }
+
+    int ret = isc_util_draw_->BlockDisparity2DistanceImage(width, height, block_width, block_height, block_disparity, bgr_image);
+
+    return ret;
+}
+
+/**
+ * Block毎の視差を展開せずに画像へ変換します.
+ *
+ * @param[in] width　画像の幅
+ * @param[in] height　画像の高さ
+ * @param[in] block_width　Blockの幅
+ * @param[in] block_height　Blockの高さ
+ * @param[in] block_disparity　Block毎の視差 (width / block_width x height / block_height)
+ * @param[out] bgr_image　カラー画像
+ * @retval 0 成功
+ * @retval other 失敗
+ */
+int BlockDisparity2Image(const int width, const int height, const int block_width, const int block_height, float* block_disparity, unsigned char* bgr_image)
+{
+
+    if(isc_util_draw_ == nullptr){
+        return -1;
+    }
+
+    int ret = isc_util_draw_->BlockDisparity2Image(width, height, block_width, block_height, block_disparity, bgr_image);
+
+    return ret;
+}
+
 }
 
 
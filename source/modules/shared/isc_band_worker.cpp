@@ -0,0 +1,279 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/**
+ * @file isc_band_worker.cpp
+ * @brief band worker class
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ * 
+ * @details This class runs the bands of a frame on a pool of worker threads.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <process.h>
+
+#include "isc_band_worker.h"
+
+/**
+ * constructor
+ *
+ */
+IscBandWorker::IscBandWorker():
+	thread_count_(0), band_kernel_(nullptr), context_(nullptr), worker_control_()
+{
+
+}
+
+/**
+ * destructor
+ *
+ */
+IscBandWorker::~IscBandWorker()
+{
+
+}
+
+/**
+ * クラスを初期化します.
+ *
+ * @param[in] thread_count スレッドの数 0:呼び出し元のスレッドで処理します
+ * @param[in] band_kernel バンドを処理する関数
+ * @param[in] context band_kernelへ渡す値
+ * @retval 0 成功
+ * @retval -1 失敗
+ */
+int IscBandWorker::Initialize(const int thread_count, BandKernel band_kernel, void* context)
+{
+	Terminate();
+
+	if ((thread_count < 0) || (thread_count > kMaxThreadCount) || (band_kernel == nullptr)) {
+		return -1;
+	}
+
+	band_kernel_ = band_kernel;
+	context_ = context;
+
+	for (int i = 0; i < thread_count; i++) {
+		WorkerControl* worker_control = &worker_control_[i];
+
+		worker_control->terminate_request = 0;
+		worker_control->band_index = i;
+		worker_control->owner = this;
+
+		worker_control->start_semaphore = CreateSemaphore(NULL, 0, 1, NULL);
+		worker_control->done_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+		if ((worker_control->start_semaphore == NULL) || (worker_control->done_event == NULL)) {
+			Terminate();
+			return -1;
+		}
+
+		if ((worker_control->thread_handle = (HANDLE)_beginthreadex(0, 0, WorkerThread, (void*)worker_control, 0, 0)) == 0) {
+			worker_control->thread_handle = NULL;
+			Terminate();
+			return -1;
+		}
+	}
+	thread_count_ = thread_count;
+
+	return 0;
+}
+
+/**
+ * 終了処理をします.
+ *
+ * @retval 0 成功
+ * @retval -1 失敗
+ * @note スレッドの終了を待ってからハンドルを閉じます
+ */
+int IscBandWorker::Terminate()
+{
+	for (int i = 0; i < kMaxThreadCount; i++) {
+		WorkerControl* worker_control = &worker_control_[i];
+
+		if (worker_control->thread_handle != NULL) {
+			worker_control->terminate_request = 1;
+			ReleaseSemaphore(worker_control->start_semaphore, 1, NULL);
+			WaitForSingleObject(worker_control->thread_handle, INFINITE);
+
+			CloseHandle(worker_control->thread_handle);
+			worker_control->thread_handle = NULL;
+		}
+		if (worker_control->start_semaphore != NULL) {
+			CloseHandle(worker_control->start_semaphore);
+			worker_control->start_semaphore = NULL;
+		}
+		if (worker_control->done_event != NULL) {
+			CloseHandle(worker_control->done_event);
+			worker_control->done_event = NULL;
+		}
+	}
+	thread_count_ = 0;
+
+	return 0;
+}
+
+/**
+ * スレッドの数を取得します.
+ *
+ * @return スレッドの数
+ */
+int IscBandWorker::GetThreadCount() const
+{
+	return thread_count_;
+}
+
+/**
+ * 配置のためにスレッドのハンドルを取得します.
+ *
+ * @param[in] max_count thread_handleの数
+ * @param[out] thread_handle ハンドル
+ * @param[out] thread_count 取得した数
+ * @retval 0 成功
+ * @retval -1 失敗
+ */
+int IscBandWorker::GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count) const
+{
+	if ((thread_handle == nullptr) || (thread_count == nullptr)) {
+		return -1;
+	}
+
+	int count = 0;
+	for (int i = 0; (i < thread_count_) && (count < max_count); i++) {
+		thread_handle[count++] = worker_control_[i].thread_handle;
+	}
+	*thread_count = count;
+
+	return 0;
+}
+
+/**
+ * 1回に処理するバンドの最大数を取得します.
+ *
+ * @return バンドの数 スレッドが無い場合は1
+ */
+int IscBandWorker::GetBandCount() const
+{
+	return thread_count_ > 0 ? thread_count_ : 1;
+}
+
+/**
+ * 行をバンドに分割します.
+ *
+ * @param[in] row_count 行の数
+ * @param[out] row_start バンドの開始行
+ * @param[out] row_end バンドの終了行 (この行を含みません)
+ * @param[in] min_band_rows 1バンドの最小の行数
+ * @return 使用するバンドの数
+ */
+int IscBandWorker::SplitRows(const int row_count, int* row_start, int* row_end, const int min_band_rows) const
+{
+	if (row_count <= 0) {
+		return 0;
+	}
+
+	int band_count = row_count / (min_band_rows > 1 ? min_band_rows : 1);
+	if (band_count > GetBandCount()) {
+		band_count = GetBandCount();
+	}
+	if (band_count < 1) {
+		band_count = 1;
+	}
+	const int rows_per_band = (row_count + band_count - 1) / band_count;
+
+	int used_band_count = 0;
+	for (int i = 0; i < band_count; i++) {
+		const int start = i * rows_per_band;
+		if (start >= row_count) {
+			break;
+		}
+
+		row_start[i] = start;
+		row_end[i] = (start + rows_per_band) < row_count ? (start + rows_per_band) : row_count;
+		used_band_count++;
+	}
+
+	return used_band_count;
+}
+
+/**
+ * バンドを処理します.
+ *
+ * @param[in] band_count バンドの数
+ * @retval 0 成功
+ * @retval -1 失敗
+ * @note 全てのバンドが終わるまで待ちます。バンドがスレッドより多い場合は、スレッドの数ずつ処理します
+ */
+int IscBandWorker::Run(const int band_count)
+{
+	if ((band_count < 0) || (band_kernel_ == nullptr)) {
+		return -1;
+	}
+
+	if ((thread_count_ == 0) || (band_count <= 1)) {
+		for (int i = 0; i < band_count; i++) {
+			band_kernel_(context_, i);
+		}
+		return 0;
+	}
+
+	for (int base = 0; base < band_count; base += thread_count_) {
+		const int count = (band_count - base < thread_count_) ? (band_count - base) : thread_count_;
+
+		HANDLE done_event[kMaxThreadCount] = {};
+		for (int i = 0; i < count; i++) {
+			worker_control_[i].band_index = base + i;
+			done_event[i] = worker_control_[i].done_event;
+			ReleaseSemaphore(worker_control_[i].start_semaphore, 1, NULL);
+		}
+
+		DWORD wait_result = WaitForMultipleObjects(count, done_event, TRUE, INFINITE);
+		if ((wait_result < WAIT_OBJECT_0) || (wait_result >= WAIT_OBJECT_0 + count)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * バンドのスレッドです.
+ *
+ * @param[in] context WorkerControl
+ * @retval 0 成功
+ */
+unsigned __stdcall IscBandWorker::WorkerThread(void* context)
+{
+	WorkerControl* worker_control = (WorkerControl*)context;
+	IscBandWorker* owner = worker_control->owner;
+
+	for (;;) {
+		DWORD wait_result = WaitForSingleObject(worker_control->start_semaphore, INFINITE);
+		if (wait_result != WAIT_OBJECT_0) {
+			break;
+		}
+
+		if (worker_control->terminate_request != 0) {
+			break;
+		}
+
+		owner->band_kernel_(owner->context_, worker_control->band_index);
+
+		SetEvent(worker_control->done_event);
+	}
+
+	return 0;
+}
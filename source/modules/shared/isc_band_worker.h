@@ -0,0 +1,95 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/**
+	@file isc_band_worker.h
+	@brief this class runs the bands of a frame on a pool of worker threads.
+*/
+
+#pragma once
+
+/**
+ * @class   IscBandWorker
+ * @brief   band worker
+ * this class divides the rows into bands, and runs the kernel of the owner for each band on its own thread.
+ */
+class IscBandWorker {
+
+public:
+	/** @brief kernel of the owner. it processes the band of band_index.
+	*/
+	typedef void (*BandKernel)(void* context, const int band_index);
+
+	static constexpr int kMaxThreadCount = 16;
+
+	IscBandWorker();
+	~IscBandWorker();
+
+	/** @brief initialize the class. if thread_count is 0, the bands are run on the calling thread.
+		@return 0, if successful.
+	*/
+	int Initialize(const int thread_count, BandKernel band_kernel, void* context);
+
+	/** @brief stop the threads and release the resources.
+		@return 0, if successful.
+	*/
+	int Terminate();
+
+	/** @brief get the number of the threads.
+		@return number of the threads.
+	*/
+	int GetThreadCount() const;
+
+	/** @brief get the threads for placement.
+		@return 0, if successful.
+	*/
+	int GetThreadHandle(const int max_count, HANDLE* thread_handle, int* thread_count) const;
+
+	/** @brief get the maximum number of the bands run at once.
+		@return number of the bands.
+	*/
+	int GetBandCount() const;
+
+	/** @brief divide the rows into the bands of min_band_rows or more. row_start and row_end need GetBandCount() elements.
+		@return number of the bands used.
+	*/
+	int SplitRows(const int row_count, int* row_start, int* row_end, const int min_band_rows = 1) const;
+
+	/** @brief run the kernel for the bands, and wait for all of them. a single band is run on the calling thread.
+		if there are more bands than the threads, they are run in rounds of the thread count.
+		@return 0, if successful.
+	*/
+	int Run(const int band_count);
+
+private:
+	struct WorkerControl {
+		HANDLE thread_handle;
+		HANDLE start_semaphore;
+		HANDLE done_event;
+		int terminate_request;
+		int band_index;
+		IscBandWorker* owner;
+	};
+
+	int thread_count_;									/**< number of the threads */
+	BandKernel band_kernel_;							/**< kernel of the owner */
+	void* context_;										/**< context of the kernel */
+
+	WorkerControl worker_control_[kMaxThreadCount];		/**< threads */
+
+	/** @brief thread of the band.
+		@return 0, if successful.
+	*/
+	static unsigned __stdcall WorkerThread(void* context);
+
+};
@@ -184,15 +184,9 @@ int IscDataprocResultdataRingBuffer::Clear()
 {
 	write_inex_ = 0; read_index_ = 0; put_index_ = 0;  geted_inedx_ = 0;
 
-	const size_t one_frame_size = width_ * height_;
 	const int max_fd_count = kISCIMAGEINFO_FRAMEDATA_MAX_COUNT;
 
-	memset(buff_p1_,			0, buffer_count_ * one_frame_size * max_fd_count);
-	memset(buff_p2_,			0, buffer_count_ * one_frame_size * max_fd_count);
-	memset(buff_color_,			0, buffer_count_ * one_frame_size * 3 * max_fd_count);
-	memset(buff_depth_,			0, buffer_count_ * one_frame_size * sizeof(float) * max_fd_count);
-	memset(buff_raw_,			0, buffer_count_ * one_frame_size * 2 * max_fd_count);
-	memset(buff_raw_color_,		0, buffer_count_ * one_frame_size * 2 * max_fd_count);
+	// the planes are not cleared, the valid area is indicated by width/height
 
 	for (int i = 0; i < buffer_count_; i++) {
 		buffer_data_[i].inedx = i;
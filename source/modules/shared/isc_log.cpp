@@ -144,9 +144,7 @@ void IscLog::Open(wchar_t* save_path, wchar_t* save_file_name, int log_level, bo
 	log_data_que_->open(128, false);		// mode=all data
 			
 	// thread start
-	wchar_t semaphore_name[64] = {};
-	swprintf_s(semaphore_name, sizeof(semaphore_name) / sizeof(wchar_t), L"MAIN_THREAD_SEMAPHORENAME_%d", 0);
-	handle_semaphore_ = CreateSemaphore(NULL, 0, 1, semaphore_name);
+	handle_semaphore_ = CreateSemaphore(NULL, 0, 1, NULL);
 	if (handle_semaphore_ == NULL) {
 		// Fail
 	}
@@ -459,6 +457,17 @@ void IscLog::LogInfo(const wchar_t *head, const wchar_t *str)
 	return;
 }
 
+/**
+ * ログThreadのハンドルを取得します.
+ *
+ * @return Threadのハンドル
+ * @note Threadの配置を設定するために利用します
+ */
+HANDLE IscLog::GetThreadHandle()
+{
+	return thread_handle_;
+}
+
 /**
  * Thread関数です.
  *
@@ -80,6 +80,11 @@ public:
 	*/
 	void LogInfo(const wchar_t *head, const wchar_t *str);
 
+	/** @brief get the handle of the log thread.
+		@return thread handle.
+	*/
+	HANDLE GetThreadHandle();
+
 private:
 
 	bool immediate_mode_;	/**< mode 0:keep the file open 1:close the file after each write */
@@ -0,0 +1,357 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+ * @file isc_thread_placement.cpp
+ * @brief thread placement class
+ * @author Takayuki
+ * @date 2022.11.21
+ * @version 0.1
+ * 
+ * @details This class applies cpu set and priority to the threads by role.
+ */
+#include "pch.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <Shlwapi.h>
+
+#include "isc_camera_def.h"
+
+#include "isc_thread_placement.h"
+
+#pragma comment (lib, "shlwapi")
+
+/**
+ * constructor
+ *
+ */
+IscThreadPlacement::IscThreadPlacement():
+	isc_thread_configuration_(), placement_count_(0), placement_(), placement_critical_()
+{
+	InitializeCriticalSection(&placement_critical_);
+}
+
+/**
+ * destructor
+ *
+ */
+IscThreadPlacement::~IscThreadPlacement()
+{
+	DeleteCriticalSection(&placement_critical_);
+}
+
+/**
+ * クラスを初期化します.
+ *
+ * @param[in] isc_thread_configuration 役割毎の配置
+ * @retval 0 成功
+ * @retval -1 失敗
+ */
+int IscThreadPlacement::Initialize(const IscThreadConfiguration* isc_thread_configuration)
+{
+	if (isc_thread_configuration == nullptr) {
+		return -1;
+	}
+
+	EnterCriticalSection(&placement_critical_);
+
+	isc_thread_configuration_ = *isc_thread_configuration;
+	placement_count_ = 0;
+
+	LeaveCriticalSection(&placement_critical_);
+
+	return 0;
+}
+
+/**
+ * 終了処理をします.
+ *
+ * @retval 0 成功
+ * @retval -1 失敗
+ */
+int IscThreadPlacement::Terminate()
+{
+	EnterCriticalSection(&placement_critical_);
+
+	placement_count_ = 0;
+
+	LeaveCriticalSection(&placement_critical_);
+
+	return 0;
+}
+
+/**
+ * 役割の配置をThreadに適用します.
+ *
+ * @param[in] role Threadの役割
+ * @param[in] thread_index 役割内のIndex
+ * @param[in] thread_handle Threadのハンドル
+ * @retval 0 成功
+ * @retval -1 失敗
+ * @note 設定が無効な役割はライブラリの既定値のまま記録のみ行います
+ */
+int IscThreadPlacement::Apply(const IscThreadRole role, const int thread_index, HANDLE thread_handle)
+{
+	const int role_index = (int)role;
+	if (role_index < 0 || role_index >= kISC_THREAD_ROLE_COUNT) {
+		return -1;
+	}
+
+	if (thread_handle == NULL) {
+		return -1;
+	}
+
+	const IscThreadParameter* isc_thread_parameter = &isc_thread_configuration_.thread_parameter[role_index];
+
+	DWORD_PTR process_mask = 0, system_mask = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+		process_mask = 0;
+	}
+
+	unsigned __int64 cpu_mask = process_mask;
+	int error_code = 0;
+
+	if (isc_thread_parameter->enabled) {
+		// cpu set
+		unsigned __int64 selected_mask = SelectCpuMask(isc_thread_parameter, thread_index);
+		if (selected_mask != 0) {
+			if (SetThreadAffinityMask(thread_handle, (DWORD_PTR)selected_mask) == 0) {
+				error_code = (int)GetLastError();
+			}
+			else {
+				cpu_mask = selected_mask;
+			}
+		}
+
+		// priority
+		int priority = THREAD_PRIORITY_NORMAL;
+		switch (isc_thread_parameter->priority) {
+		case IscThreadPriority::kIdle:			priority = THREAD_PRIORITY_IDLE; break;
+		case IscThreadPriority::kLowest:		priority = THREAD_PRIORITY_LOWEST; break;
+		case IscThreadPriority::kBelowNormal:	priority = THREAD_PRIORITY_BELOW_NORMAL; break;
+		case IscThreadPriority::kNormal:		priority = THREAD_PRIORITY_NORMAL; break;
+		case IscThreadPriority::kAboveNormal:	priority = THREAD_PRIORITY_ABOVE_NORMAL; break;
+		case IscThreadPriority::kHighest:		priority = THREAD_PRIORITY_HIGHEST; break;
+		case IscThreadPriority::kTimeCritical:	priority = THREAD_PRIORITY_TIME_CRITICAL; break;
+		default:								priority = THREAD_PRIORITY_NORMAL; break;
+		}
+		if (!SetThreadPriority(thread_handle, priority)) {
+			error_code = (int)GetLastError();
+		}
+
+		// scheduling policy
+		if (!SetThreadPriorityBoost(thread_handle, isc_thread_parameter->disable_priority_boost ? TRUE : FALSE)) {
+			error_code = (int)GetLastError();
+		}
+	}
+
+	BOOL priority_boost_disabled = FALSE;
+	GetThreadPriorityBoost(thread_handle, &priority_boost_disabled);
+
+	EnterCriticalSection(&placement_critical_);
+
+	// a thread created again replaces the previous one
+	int write_index = placement_count_;
+	for (int i = 0; i < placement_count_; i++) {
+		if (placement_[i].role == role && placement_[i].thread_index == thread_index) {
+			write_index = i;
+			break;
+		}
+	}
+
+	if (write_index < kISC_THREAD_PLACEMENT_MAX_COUNT) {
+		IscThreadPlacementStatus::Placement* placement = &placement_[write_index];
+		placement->role = role;
+		placement->thread_index = thread_index;
+		placement->thread_id = GetThreadId(thread_handle);
+		placement->cpu_mask = cpu_mask;
+		placement->priority = GetThreadPriority(thread_handle);
+		placement->priority_boost_disabled = priority_boost_disabled ? true : false;
+		placement->error_code = error_code;
+
+		if (write_index == placement_count_) {
+			placement_count_++;
+		}
+	}
+
+	LeaveCriticalSection(&placement_critical_);
+
+	return error_code == 0 ? 0 : -1;
+}
+
+/**
+ * 役割の記録を削除します.
+ *
+ * @param[in] role Threadの役割
+ * @retval 0 成功
+ * @retval -1 失敗
+ * @note Threadを終了した時に呼び出します
+ */
+int IscThreadPlacement::Remove(const IscThreadRole role)
+{
+	EnterCriticalSection(&placement_critical_);
+
+	int write_index = 0;
+	for (int i = 0; i < placement_count_; i++) {
+		if (placement_[i].role != role) {
+			placement_[write_index] = placement_[i];
+			write_index++;
+		}
+	}
+	placement_count_ = write_index;
+
+	LeaveCriticalSection(&placement_critical_);
+
+	return 0;
+}
+
+/**
+ * 適用した配置を追加します.
+ *
+ * @param[in,out] isc_thread_placement_status 配置の一覧　placement_countの後に追加します
+ * @retval 0 成功
+ * @retval -1 失敗
+ */
+int IscThreadPlacement::GetPlacement(IscThreadPlacementStatus* isc_thread_placement_status)
+{
+	if (isc_thread_placement_status == nullptr) {
+		return -1;
+	}
+
+	EnterCriticalSection(&placement_critical_);
+
+	for (int i = 0; i < placement_count_; i++) {
+		if (isc_thread_placement_status->placement_count >= kISC_THREAD_PLACEMENT_MAX_COUNT) {
+			break;
+		}
+		isc_thread_placement_status->placement[isc_thread_placement_status->placement_count] = placement_[i];
+		isc_thread_placement_status->placement_count++;
+	}
+
+	LeaveCriticalSection(&placement_critical_);
+
+	return 0;
+}
+
+/**
+ * 設定をファイルから読み込みます.
+ *
+ * @param[in] file_name ファイル名
+ * @param[in,out] isc_thread_configuration 役割毎の配置
+ * @retval 0 成功
+ * @retval -1 失敗
+ * @note ファイルに記載された項目のみ上書きします
+ */
+int IscThreadPlacement::LoadFromFile(const wchar_t* file_name, IscThreadConfiguration* isc_thread_configuration)
+{
+	if (file_name == nullptr || isc_thread_configuration == nullptr) {
+		return -1;
+	}
+
+	bool is_exists = PathFileExists(file_name) == TRUE ? true : false;
+	if (!is_exists) {
+		return -1;
+	}
+
+	const wchar_t section_name[kISC_THREAD_ROLE_COUNT][32] = {
+		L"CAMERA_RECEIVE", L"DATA_PROC", L"STEREO_MATCHING_BAND", L"DISPARITY_FILTER_BAND",
+		L"SELF_CALIBRATION", L"FILE_WRITER", L"LOG", L"CALLBACK_DELIVERY",
+		L"BAND_WORKER", L"FILE_PLAYER" };
+
+	wchar_t returned_string[1024] = {};
+
+	for (int i = 0; i < kISC_THREAD_ROLE_COUNT; i++) {
+		IscThreadParameter* isc_thread_parameter = &isc_thread_configuration->thread_parameter[i];
+
+		GetPrivateProfileString(section_name[i], L"enabled", L"", returned_string, sizeof(returned_string) / sizeof(wchar_t), file_name);
+		if (returned_string[0] != L'\0') {
+			isc_thread_parameter->enabled = _wtoi(returned_string) == 1 ? true : false;
+		}
+
+		// decimal or hex(0x)
+		GetPrivateProfileString(section_name[i], L"cpu_mask", L"", returned_string, sizeof(returned_string) / sizeof(wchar_t), file_name);
+		if (returned_string[0] != L'\0') {
+			isc_thread_parameter->cpu_mask = _wcstoui64(returned_string, nullptr, 0);
+		}
+
+		GetPrivateProfileString(section_name[i], L"distribute", L"", returned_string, sizeof(returned_string) / sizeof(wchar_t), file_name);
+		if (returned_string[0] != L'\0') {
+			isc_thread_parameter->distribute = _wtoi(returned_string) == 1 ? true : false;
+		}
+
+		GetPrivateProfileString(section_name[i], L"priority", L"", returned_string, sizeof(returned_string) / sizeof(wchar_t), file_name);
+		if (returned_string[0] != L'\0') {
+			int priority = _wtoi(returned_string);
+			if (priority >= (int)IscThreadPriority::kIdle && priority <= (int)IscThreadPriority::kTimeCritical) {
+				isc_thread_parameter->priority = (IscThreadPriority)priority;
+			}
+		}
+
+		GetPrivateProfileString(section_name[i], L"disable_priority_boost", L"", returned_string, sizeof(returned_string) / sizeof(wchar_t), file_name);
+		if (returned_string[0] != L'\0') {
+			isc_thread_parameter->disable_priority_boost = _wtoi(returned_string) == 1 ? true : false;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Threadに割り当てるCPUを選択します.
+ *
+ * @param[in] isc_thread_parameter 役割の配置
+ * @param[in] thread_index 役割内のIndex
+ * @return CPUの集合 0:変更しません
+ * @note distributeの場合、集合のCPUを順番に1つずつ割り当てます
+ */
+unsigned __int64 IscThreadPlacement::SelectCpuMask(const IscThreadParameter* isc_thread_parameter, const int thread_index)
+{
+	DWORD_PTR process_mask = 0, system_mask = 0;
+	if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+		return 0;
+	}
+
+	unsigned __int64 cpu_mask = isc_thread_parameter->cpu_mask & (unsigned __int64)process_mask;
+	if (cpu_mask == 0) {
+		// not in the process, use all processors
+		cpu_mask = (unsigned __int64)process_mask;
+	}
+
+	if (!isc_thread_parameter->distribute) {
+		return cpu_mask;
+	}
+
+	int cpu_count = 0;
+	for (int i = 0; i < 64; i++) {
+		if (cpu_mask & (1ULL << i)) {
+			cpu_count++;
+		}
+	}
+	if (cpu_count == 0) {
+		return 0;
+	}
+
+	int target = thread_index % cpu_count;
+	for (int i = 0; i < 64; i++) {
+		if (cpu_mask & (1ULL << i)) {
+			if (target == 0) {
+				return 1ULL << i;
+			}
+			target--;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,76 @@
+﻿// Copyright 2023 ITD Lab Corp.All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http ://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/**
+	@file isc_thread_placement.h
+	@brief this class applies cpu set and priority to the threads by role.
+*/
+
+#pragma once
+
+/**
+ * @class   IscThreadPlacement
+ * @brief   thread placement
+ * this class applies cpu set and priority to the threads by role and keeps the result for diagnostics.
+ */
+class IscThreadPlacement {
+
+public:
+	IscThreadPlacement();
+	~IscThreadPlacement();
+
+	/** @brief initialize the class.
+		@return 0, if successful.
+	*/
+	int Initialize(const IscThreadConfiguration* isc_thread_configuration);
+
+	/** @brief release the resources.
+		@return 0, if successful.
+	*/
+	int Terminate();
+
+	/** @brief apply the placement of the role to the thread.
+		@return 0, if successful.
+	*/
+	int Apply(const IscThreadRole role, const int thread_index, HANDLE thread_handle);
+
+	/** @brief remove the placement of the role from the list.
+		@return 0, if successful.
+	*/
+	int Remove(const IscThreadRole role);
+
+	/** @brief append the applied placement to the status.
+		@return 0, if successful.
+	*/
+	int GetPlacement(IscThreadPlacementStatus* isc_thread_placement_status);
+
+	/** @brief read the configuration from the file. Only the keys in the file are overwritten.
+		@return 0, if successful.
+	*/
+	static int LoadFromFile(const wchar_t* file_name, IscThreadConfiguration* isc_thread_configuration);
+
+private:
+	IscThreadConfiguration isc_thread_configuration_;	/**< configuration */
+
+	int placement_count_;																/**< valid count of placement_ */
+	IscThreadPlacementStatus::Placement placement_[kISC_THREAD_PLACEMENT_MAX_COUNT];	/**< applied placement */
+
+	CRITICAL_SECTION placement_critical_;				/**< lock for placement_ */
+
+	/** @brief select the cpu set for the thread.
+		@return cpu set.
+	*/
+	unsigned __int64 SelectCpuMask(const IscThreadParameter* isc_thread_parameter, const int thread_index);
+
+};